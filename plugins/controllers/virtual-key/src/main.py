@@ -28,6 +28,7 @@ import numpy as np
 sys.path.insert(0, os.path.dirname(__file__))
 
 from core.spatial import SpatialEngine   # noqa: E402
+from midi.control_stream import NO_FINGER, ControlStreamWriter  # noqa: E402
 from midi.mpe_engine import MPEEngine    # noqa: E402
 from utils.filters import OneEuroFilter  # noqa: E402
 
@@ -54,6 +55,7 @@ NOTE_NAMES = ["C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"]
 # Must match ky=0.76 used in _draw_keyboard.
 KEY_ZONE_TOP:     float = 0.76   # fingertip enters zone  → note on
 KEY_ZONE_RELEASE: float = 0.73   # fingertip leaves zone  → note off (3% hysteresis)
+KEY_ZONE_HEIGHT:  float = 0.20   # kh in _draw_keyboard; y runs 0-1 down the keys
 
 
 # ===========================================================================
@@ -78,6 +80,17 @@ class OpticalController:
         self.spatial = SpatialEngine()
         self.mpe     = MPEEngine()
 
+        # Per-finger x/y/z every frame, for plugins that read it (NewProject);
+        # the notes themselves still go over MIDI
+        self.control_stream: ControlStreamWriter | None = None
+        cs_cfg = self.config.get("control_stream", {})
+        if cs_cfg.get("enabled", False):
+            writer = ControlStreamWriter(cs_cfg.get("name", "virtual-key"),
+                                         semitones_per_unit_x=self.num_notes)
+            if writer.open():
+                self.control_stream = writer
+        self.control_fingers = [NO_FINGER] * (2 * len(FINGER_TIPS))
+
         # ── MediaPipe HandLandmarker (Tasks API, VIDEO mode) ─────────────────
         base_dir   = os.path.dirname(os.path.dirname(__file__))
         model_path = os.path.join(base_dir, "models", "hand_landmarker.task")
@@ -193,7 +206,7 @@ class OpticalController:
     def _process_hand(self, landmarks: list, hand_idx: int, t: float) -> Set[int]:
         """Process one hand's landmarks; return set of currently active notes."""
         active: Set[int] = set()
-        for name, tip_id in FINGER_TIPS.items():
+        for fi, (name, tip_id) in enumerate(FINGER_TIPS.items()):
             k   = (hand_idx, tip_id)
             tip = landmarks[tip_id]
 
@@ -224,6 +237,14 @@ class OpticalController:
                 # fingertip left the zone (hysteresis prevents chattering)
                 self.mpe.note_off(k, self.active_fingers.pop(k))
 
+            # Expression for the sounding note goes over the control stream
+            chan, held_note = self.mpe.active_notes.get(k, (-1, 0))
+            if chan >= 0 and hand_idx < 2:
+                y = max(0.0, min(1.0, (fy - KEY_ZONE_TOP) / KEY_ZONE_HEIGHT))
+                z = landmarks[FINGER_MCP[name]].z - tip.z
+                self.control_fingers[hand_idx * len(FINGER_TIPS) + fi] = (
+                    chan + 1, held_note, px, y, z)
+
         return active
 
     # ==========================================================================
@@ -277,6 +298,7 @@ class OpticalController:
 
                 all_active: Set[int] = set()
                 num_hands = 0
+                self.control_fingers = [NO_FINGER] * len(self.control_fingers)
 
                 if result.hand_landmarks:
                     num_hands = len(result.hand_landmarks)
@@ -289,6 +311,9 @@ class OpticalController:
                 for fk in stale:
                     self.mpe.note_off(fk, self.active_fingers.pop(fk))
 
+                if self.control_stream is not None:
+                    self.control_stream.publish(self.control_fingers)
+
                 self._draw_keyboard(frame, all_active)
                 self._draw_hud(frame, all_active)
                 cv2.imshow(WIN, frame)
@@ -314,6 +339,8 @@ class OpticalController:
         finally:
             print("\nShutting down - sending MIDI panic ...")
             self.mpe.all_notes_off()
+            if self.control_stream is not None:
+                self.control_stream.close()
             self.detector.close()
             cap.release()
             cv2.destroyAllWindows()
@@ -0,0 +1,169 @@
+"""
+src/midi/control_stream.py
+
+Per-finger positions at camera frame rate, over shared memory.
+
+MIDI carries the notes; this carries what MIDI would have to quantise and
+thin out: every finger's x / y / z for every frame, with its timestamp.
+Plugins that understand it (NewProject) map the region read-only and turn
+the positions into per-note pitch bend and timbre directly.
+
+The layout is plugins/vst/Shared/ControlStream.h's, byte for byte
+(little-endian):
+
+  Header (64 bytes)
+     0  u32  magic "VGCS"         16  u64  frames published
+     4  u32  version (1)          24  f32  semitones per unit of x
+     8  u32  slot bytes (192)     28  u32  max fingers (10)
+    12  u32  capacity (64)        32  i64  heartbeat, ms since 1970
+  Slots (capacity x 192 bytes, frame n in slot n % capacity)
+     0  u64  sequence: 2n + 1 while frame n is written, 2n + 2 after
+     8  f64  timestamp (time.monotonic())
+    16  u32  fingers used
+    24  x10  { u8 MIDI channel (0 = no note), u8 note, u16 0,
+               f32 x, f32 y, f32 z }
+
+A reader only accepts a slot whose sequence reads 2n + 2 before and
+after copying it, so nothing here needs a lock.
+"""
+
+from __future__ import annotations
+
+import mmap
+import os
+import struct
+import sys
+import time
+from typing import Optional, Sequence, Tuple
+
+MAGIC       = 0x53434756   # "VGCS"
+VERSION     = 1
+CAPACITY    = 64
+MAX_FINGERS = 10
+
+_HEADER = struct.Struct("<IIIIQfIq24x")
+_FINGER = struct.Struct("<BBHfff")
+_FRAME  = struct.Struct("<dII" + "BBHfff" * MAX_FINGERS)   # the slot after its sequence
+_U64    = struct.Struct("<Q")
+_I64    = struct.Struct("<q")
+
+HEADER_BYTES = _HEADER.size
+SLOT_BYTES   = 192
+REGION_BYTES = HEADER_BYTES + CAPACITY * SLOT_BYTES
+
+_FRAMES_PUBLISHED_OFFSET = 16
+_HEARTBEAT_OFFSET        = 32
+
+assert HEADER_BYTES == 64 and _FINGER.size == 16 and _U64.size + _FRAME.size + 8 == SLOT_BYTES
+
+# (MIDI channel 1-16 or 0, note, x, y, z)
+Finger = Tuple[int, int, float, float, float]
+NO_FINGER: Finger = (0, 0, 0.0, 0.0, 0.0)
+
+
+def region_directory() -> str:
+    """Must match ControlStream::getDirectory()."""
+    if sys.platform.startswith("linux") and os.path.isdir("/dev/shm"):
+        return "/dev/shm/vst-garage-control"
+    if sys.platform == "darwin":
+        return os.path.expanduser("~/Library/vst-garage/control")
+    if sys.platform == "win32":
+        return os.path.join(os.environ.get("APPDATA", os.path.expanduser("~")), "vst-garage", "control")
+    return os.path.expanduser("~/.config/vst-garage/control")
+
+
+class ControlStreamWriter:
+    """
+    Creates ``<region_directory()>/<name>.control`` and publishes frames
+    into it.  One writer per region; call from one thread.
+
+    Args:
+        name                 : region name; NewProject follows "virtual-key"
+        semitones_per_unit_x : keys across the whole x range, so a reader
+                               can turn a slide in x into a bend
+    """
+
+    def __init__(self, name: str = "virtual-key", semitones_per_unit_x: float = 24.0) -> None:
+        self.path = os.path.join(region_directory(), name + ".control")
+        self.semitones_per_unit_x = float(semitones_per_unit_x)
+        self._file = None
+        self._map: Optional[mmap.mmap] = None
+        self._published = 0
+
+    # ------------------------------------------------------------------
+    # Public API
+    # ------------------------------------------------------------------
+
+    def open(self) -> bool:
+        """Create (or take over) the region.  False if it can't be mapped."""
+        self.close()
+        try:
+            os.makedirs(os.path.dirname(self.path), exist_ok=True)
+            self._file = open(self.path, "w+b")
+            self._file.truncate(REGION_BYTES)
+            self._map = mmap.mmap(self._file.fileno(), REGION_BYTES)
+        except OSError as exc:
+            print(f"[ControlStream] Can't create {self.path}: {exc}")
+            self.close()
+            return False
+
+        self._map[:] = bytes(REGION_BYTES)
+        self._published = 0
+
+        # Magic last, so a reader never accepts a half-written header
+        _HEADER.pack_into(self._map, 0, 0, VERSION, SLOT_BYTES, CAPACITY, 0,
+                          self.semitones_per_unit_x, MAX_FINGERS, _now_ms())
+        struct.pack_into("<I", self._map, 0, MAGIC)
+        print(f"[ControlStream] Publishing to {self.path}")
+        return True
+
+    def close(self) -> None:
+        """Remove the region; safe when not open."""
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+        if self._file is not None:
+            self._file.close()
+            self._file = None
+            try:
+                os.remove(self.path)
+            except OSError:
+                pass
+
+    @property
+    def is_open(self) -> bool:
+        return self._map is not None
+
+    def publish(self, fingers: Sequence[Finger], timestamp: Optional[float] = None) -> None:
+        """
+        Publish one frame.
+
+        Args:
+            fingers   : up to MAX_FINGERS (channel, note, x, y, z); keep each
+                        finger at the same index frame to frame, with
+                        NO_FINGER where it plays nothing
+            timestamp : seconds on time.monotonic(); now if omitted
+        """
+        if self._map is None:
+            return
+
+        n      = self._published
+        offset = HEADER_BYTES + (n % CAPACITY) * SLOT_BYTES
+        count  = min(len(fingers), MAX_FINGERS)
+
+        values = [time.monotonic() if timestamp is None else timestamp, count, 0]
+        for i in range(MAX_FINGERS):
+            channel, note, x, y, z = fingers[i] if i < count else NO_FINGER
+            values += [channel & 0xFF, note & 0x7F, 0, x, y, z]
+
+        _U64.pack_into(self._map, offset, 2 * n + 1)
+        _FRAME.pack_into(self._map, offset + _U64.size, *values)
+        _U64.pack_into(self._map, offset, 2 * n + 2)
+
+        self._published = n + 1
+        _U64.pack_into(self._map, _FRAMES_PUBLISHED_OFFSET, self._published)
+        _I64.pack_into(self._map, _HEARTBEAT_OFFSET, _now_ms())
+
+
+def _now_ms() -> int:
+    return int(time.time() * 1000)
@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+    RenderCheck.cpp  –  AutoTunesRenderCheck: golden-output and timing
+                        regression check (see Shared/RenderHarness.h)
+
+    Nothing binds the processor to an ARA document, so this checks the
+    live corrector, with the governor off so detections are never spaced
+    out under --live.
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "../../Shared/RenderHarness.h"
+
+int main (int argc, char* argv[])
+{
+    return RenderHarness::run (argc, argv, "AutoTunes", []
+    {
+        auto processor = std::make_unique<AutoTunesAudioProcessor>();
+        processor->getQualityGovernor().setEnabled (false);
+        return processor;
+    });
+}
@@ -149,7 +149,7 @@
  #define JucePlugin_ARAContentTypes        0
 #endif
 #ifndef  JucePlugin_ARATransformationFlags
- #define JucePlugin_ARATransformationFlags  0
+ #define JucePlugin_ARATransformationFlags  1
 #endif
 #ifndef  JucePlugin_ARAFactoryID
  #define JucePlugin_ARAFactoryID           "com.yourcompany.AutoTunes.factory"
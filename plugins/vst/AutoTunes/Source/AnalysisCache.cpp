@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+    AnalysisCache.cpp  –  AnalysisCache implementation
+  ==============================================================================
+*/
+
+#include "AnalysisCache.h"
+#include <algorithm>
+#include <cstring>
+
+//==============================================================================
+juce::File AnalysisCache::getDefaultDirectory()
+{
+   #if JUCE_MAC
+    return juce::File::getSpecialLocation (juce::File::userHomeDirectory).getChildFile ("Library/Caches/AutoTunes");
+   #elif JUCE_LINUX || JUCE_BSD
+    return juce::File::getSpecialLocation (juce::File::userHomeDirectory).getChildFile (".cache/AutoTunes");
+   #else
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory).getChildFile ("AutoTunes/Cache");
+   #endif
+}
+
+AnalysisCache::AnalysisCache (juce::File directoryIn, juce::int64 maxBytesIn)
+    : directory (std::move (directoryIn)),
+      maxBytes (maxBytesIn)
+{
+}
+
+//==============================================================================
+AnalysisCache::ContentHasher::ContentHasher (double sampleRate, int numChannels, juce::int64 numSamples) noexcept
+{
+    juce::uint64 rateBits;
+    std::memcpy (&rateBits, &sampleRate, sizeof (rateBits));
+
+    mix (rateBits);
+    mix ((juce::uint64) numChannels);
+    mix ((juce::uint64) numSamples);
+}
+
+void AnalysisCache::ContentHasher::add (const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    // Two samples a word, channel by channel; any order works as long as
+    // it's the same every time
+    for (int c = 0; c < numChannels; ++c)
+    {
+        const auto* data = channels[c];
+        int i = 0;
+
+        for (; i + 1 < numSamples; i += 2)
+        {
+            juce::uint64 word;
+            std::memcpy (&word, data + i, sizeof (word));
+            mix (word);
+        }
+
+        if (i < numSamples)
+        {
+            juce::uint32 last;
+            std::memcpy (&last, data + i, sizeof (last));
+            mix (last);
+        }
+    }
+
+    count += numSamples;
+}
+
+void AnalysisCache::ContentHasher::mix (juce::uint64 word) noexcept
+{
+    // One multiply-xorshift round per word (as in splitmix64 / wyhash)
+    state = (state ^ word) * 0xbf58476d1ce4e5b9ull;
+    state ^= state >> 31;
+}
+
+juce::uint64 AnalysisCache::ContentHasher::finalise (juce::uint64 h) noexcept
+{
+    h ^= h >> 30;  h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;  h *= 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+AnalysisCache::Key AnalysisCache::makeKey (const juce::String& persistentID, juce::uint64 contentHash) noexcept
+{
+    return { (juce::uint64) persistentID.hashCode64(), contentHash };
+}
+
+//==============================================================================
+juce::File AnalysisCache::getFile (const Key& key) const
+{
+    return directory.getChildFile (juce::String::toHexString ((juce::int64) key.contentHash).paddedLeft ('0', 16)
+                                     + "-" + juce::String::toHexString ((juce::int64) key.idHash).paddedLeft ('0', 16)
+                                     + kExtension);
+}
+
+std::shared_ptr<const PitchAnalysis> AnalysisCache::find (const Key& key) const
+{
+    const auto file = getFile (key);
+
+    if (! file.existsAsFile())
+        return nullptr;
+
+    const juce::MemoryMappedFile mapped (file, juce::MemoryMappedFile::readOnly);
+
+    if (mapped.getData() == nullptr)
+        return nullptr;
+
+    auto analysis = PitchAnalysis::fromBinary (mapped.getData(), mapped.getSize());
+
+    if (analysis != nullptr)
+        file.setLastAccessTime (juce::Time::getCurrentTime());
+
+    return analysis;
+}
+
+void AnalysisCache::store (const Key& key, const PitchAnalysis& analysis)
+{
+    if (! directory.createDirectory())
+        return;
+
+    const auto file     = getFile (key);
+    const auto encoded  = analysis.toBinary();
+    const auto tempFile = file.getSiblingFile (file.getFileName() + "."
+                                                 + juce::String::toHexString (juce::Random::getSystemRandom().nextInt64())
+                                                 + ".tmp");
+
+    // Written aside and renamed in, so a reader never maps half a file
+    if (! tempFile.replaceWithData (encoded.getData(), encoded.getSize())
+        || ! tempFile.moveFileTo (file))
+    {
+        tempFile.deleteFile();
+        return;
+    }
+
+    trimToSize();
+}
+
+void AnalysisCache::trimToSize()
+{
+    const juce::ScopedLock sl (trimLock);
+
+    auto files = directory.findChildFiles (juce::File::findFiles, false, juce::String ("*") + kExtension);
+
+    juce::int64 totalBytes = 0;
+    for (const auto& f : files)
+        totalBytes += f.getSize();
+
+    if (totalBytes <= maxBytes)
+        return;
+
+    // Oldest use first
+    std::sort (files.begin(), files.end(), [] (const juce::File& a, const juce::File& b)
+    {
+        return a.getLastAccessTime() < b.getLastAccessTime();
+    });
+
+    for (const auto& f : files)
+    {
+        if (totalBytes <= maxBytes)
+            break;
+
+        const auto size = f.getSize();
+
+        // Another instance may have it mapped or have deleted it already
+        if (f.deleteFile())
+            totalBytes -= size;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+    AnalysisCache.h  –  On-disk pitch analyses shared across projects
+
+    The same stems get imported into project after project; this keeps each
+    finished analysis in the user's cache folder, keyed by the audio
+    source's persistent ID and a hash of its samples, so the next project
+    (or the next import) reads it back instead of analysing again.
+
+    One file per analysis holding PitchAnalysis::toBinary(), decoded
+    straight from a read-only memory map.  Files are written under a temp
+    name and renamed into place, so several plugin instances can share the
+    folder, and the least recently used are deleted once the folder grows
+    past its size cap.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "PitchAnalysis.h"
+
+class AnalysisCache
+{
+public:
+    static constexpr juce::int64 kDefaultMaxBytes = 512 * 1024 * 1024;
+
+    /** ~/Library/Caches/AutoTunes on macOS, ~/.cache/AutoTunes on Linux,
+        %APPDATA%/AutoTunes/Cache on Windows. */
+    static juce::File getDefaultDirectory();
+
+    explicit AnalysisCache (juce::File directory = getDefaultDirectory(), juce::int64 maxBytes = kDefaultMaxBytes);
+
+    /** Identifies one source's samples. */
+    struct Key
+    {
+        juce::uint64 idHash      { 0 };   ///< Of the persistent ID
+        juce::uint64 contentHash { 0 };   ///< Of the samples, rate and layout (see ContentHasher)
+    };
+
+    /** A fast, non-cryptographic 64-bit hash, fed block by block. */
+    class ContentHasher
+    {
+    public:
+        ContentHasher (double sampleRate, int numChannels, juce::int64 numSamples) noexcept;
+
+        void add (const float* const* channels, int numChannels, int numSamples) noexcept;
+
+        juce::uint64 getHash() const noexcept { return finalise (state ^ (juce::uint64) count); }
+
+    private:
+        static juce::uint64 finalise (juce::uint64 h) noexcept;
+        void mix (juce::uint64 word) noexcept;
+
+        juce::uint64 state { 0x9e3779b97f4a7c15ull };
+        juce::int64  count { 0 };
+    };
+
+    static Key makeKey (const juce::String& persistentID, juce::uint64 contentHash) noexcept;
+
+    /** The cached analysis for key, or nullptr.  A hit counts as a use for
+        the size cap.  Any thread. */
+    std::shared_ptr<const PitchAnalysis> find (const Key& key) const;
+
+    /** Adds (or replaces) key's analysis, then trims the folder to its
+        cap.  Any thread; failures only cost a later re-analysis. */
+    void store (const Key& key, const PitchAnalysis& analysis);
+
+private:
+    juce::File getFile (const Key& key) const;
+    void       trimToSize();
+
+    static constexpr const char* kExtension = ".atpa";
+
+    const juce::File        directory;
+    const juce::int64       maxBytes;
+    juce::CriticalSection   trimLock;   // one trim at a time per instance
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisCache)
+};
@@ -0,0 +1,606 @@
+/*
+  ==============================================================================
+    AnalysisScheduler.cpp  –  AnalysisScheduler implementation
+  ==============================================================================
+*/
+
+#include "AnalysisScheduler.h"
+#include "../../PFix/Source/PitchBatchAnalyser.h"
+#include "../../Shared/VectorKernels.h"
+#include "SampleRateConverter.h"
+#include "SpectralEnvelope.h"
+#include <cmath>
+#include <limits>
+#include <optional>
+
+//==============================================================================
+/** One source's analysis.  Only the worker holding it (busy) touches the
+    progress fields; other threads read them under the lock while it's idle. */
+struct AnalysisScheduler::Task
+{
+    /** Message thread: the reader is created here, where the model is safe
+        to touch, and used only by the worker holding the task afterwards. */
+    Task (juce::ARAAudioSource& sourceIn, std::shared_ptr<SampleCache> samplesIn, bool detectPitchIn)
+        : source (sourceIn),
+          persistentID (sourceIn.getPersistentID()),
+          reader (&sourceIn),
+          samples (std::move (samplesIn)),
+          waveform (std::make_unique<WaveformOverview> (reader.lengthInSamples)),
+          detectPitch (detectPitchIn)
+    {
+    }
+
+    double getSeconds (juce::int64 sample) const noexcept   { return (double) sample / sampleRate; }
+    double getFrameStart (juce::int64 frame) const noexcept { return getSeconds (frame * analysis->hop); }
+    double getFrameEnd (juce::int64 frame) const noexcept   { return getSeconds ((frame - 1) * analysis->hop + analysis->analysisSize); }
+
+    juce::int64 getChunkEnd (int chunk) const noexcept
+    {
+        return juce::jmin ((juce::int64) (chunk + 1) * kFramesPerChunk, numFrames);
+    }
+
+    juce::ARAAudioSource&       source;
+    const juce::String          persistentID;
+    juce::ARAAudioSourceReader  reader;   // this task's own; readers aren't shared across threads
+    std::shared_ptr<SampleCache> samples;   // null if there's nowhere to decode to
+    std::unique_ptr<WaveformOverview> waveform;
+    const bool                        detectPitch;
+
+    // What it's analysed at: the reader's, or what the converter makes of it
+    double                               sampleRate = 0.0;
+    juce::int64                          numSamples = 0;
+    std::unique_ptr<SampleRateConverter> converter;   // null at the source's own rate
+
+    std::shared_ptr<PitchAnalysis> analysis;    // points filled in chunk by chunk
+    juce::int64                    numFrames = 0;
+
+    // Progress
+    std::optional<AnalysisCache::ContentHasher> hasher;
+    juce::int64                                 numHashed  = 0;       // samples
+    bool                                        hashed     = false;
+    AnalysisCache::Key                          key;
+    std::vector<juce::int64>                    chunkNext;            // per chunk, the next frame to detect
+    int                                         chunksLeft = 0;
+    juce::int64                                 framesDone = 0;
+    bool                                        started    = false;   // progress reported to the host
+
+    bool                busy = false;           // under the lock
+    std::atomic<bool>   cancelled { false };    // set under the lock
+    juce::WaitableEvent released;               // by a worker that sees it cancelled
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Task)
+};
+
+//==============================================================================
+/** Takes the nearest work until there's none; its scratch is kept from one
+    task to the next. */
+class AnalysisScheduler::Worker  : public juce::ThreadPoolJob
+{
+public:
+    explicit Worker (AnalysisScheduler& ownerIn)
+        : ThreadPoolJob ("AutoTunes analysis"),
+          owner (ownerIn)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        for (auto work = owner.acquire (*this); work.task != nullptr; work = owner.acquire (*this))
+            owner.run (work, *this);
+
+        return jobHasFinished;
+    }
+
+    AnalysisScheduler&       owner;
+    PitchDetector            detector;
+    juce::AudioBuffer<float> channels;
+    std::vector<float>       mono;
+
+    std::unique_ptr<SpectralEnvelope::Analyser> envelopes;   // for the detector's window
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+};
+
+//==============================================================================
+AnalysisScheduler::AnalysisScheduler (juce::ThreadPool& poolIn, AnalysisCache& cacheIn, AnalysedCallback onAnalysedIn)
+    : pool (poolIn),
+      cache (cacheIn),
+      onAnalysed (std::move (onAnalysedIn)),
+      maxWorkers (juce::jmax (1, juce::SystemStats::getNumCpus() / 2))
+{
+}
+
+AnalysisScheduler::~AnalysisScheduler()
+{
+    cancelPendingUpdate();
+
+    {
+        const juce::ScopedLock sl (lock);
+        shuttingDown = true;
+
+        for (auto& entry : tasks)
+            entry.second->cancelled = true;
+    }
+
+    struct OwnWorkers  : juce::ThreadPool::JobSelector
+    {
+        explicit OwnWorkers (AnalysisScheduler& s)  : scheduler (s) {}
+
+        bool isJobSuitable (juce::ThreadPoolJob* job) override
+        {
+            const auto* worker = dynamic_cast<Worker*> (job);
+            return worker != nullptr && &worker->owner == &scheduler;
+        }
+
+        AnalysisScheduler& scheduler;
+    };
+
+    OwnWorkers selector (*this);
+    pool.removeAllJobs (true, kCancelTimeoutMs, &selector);
+}
+
+//==============================================================================
+void AnalysisScheduler::add (juce::ARAAudioSource& audioSource, std::shared_ptr<SampleCache> samples, bool detectPitch)
+{
+    cancel (&audioSource);
+
+    auto task = std::make_unique<Task> (audioSource, std::move (samples), detectPitch);
+    const auto& reader = task->reader;
+
+    if (! reader.isValid() || reader.sampleRate <= 0.0 || reader.numChannels == 0)
+        return;
+
+    task->sampleRate = task->samples != nullptr ? task->samples->getSampleRate() : reader.sampleRate;
+    task->numSamples = SampleRateConverter::getNumOutputSamples (reader.lengthInSamples, reader.sampleRate, task->sampleRate);
+
+    // Filled as the source is hashed, so only an empty one of its shape will do
+    if (task->samples != nullptr
+        && (! task->samples->isValid() || task->samples->getNumDecoded() > 0
+            || task->samples->getNumChannels() != (int) reader.numChannels
+            || task->samples->getNumSamples() != task->numSamples))
+        task->samples = nullptr;
+
+    // The only copy at that rate: without it, there's nothing to analyse
+    if (task->sampleRate != reader.sampleRate)
+    {
+        if (task->samples == nullptr)
+            return;
+
+        task->converter = std::make_unique<SampleRateConverter> ((int) reader.numChannels, reader.sampleRate,
+                                                                 task->sampleRate, reader.lengthInSamples);
+    }
+
+    auto analysis = std::make_shared<PitchAnalysis>();
+    analysis->sampleRate   = task->sampleRate;
+    analysis->numSamples   = task->numSamples;
+    analysis->analysisSize = PitchDetector::analysisSizeFor (task->sampleRate, kMinFrequencyHz);
+    analysis->hop          = analysis->analysisSize / kHopsPerWindow;
+
+    task->numFrames = PitchBatchAnalyser::getNumFrames (task->numSamples, analysis->analysisSize, analysis->hop);
+    analysis->points.resize ((size_t) task->numFrames);
+
+    analysis->envelopeOrder  = SpectralEnvelope::getOrder (task->sampleRate);
+    analysis->envelopeStride = SpectralEnvelope::kFramesPerEnvelope;
+    analysis->envelopes.resize ((size_t) ((task->numFrames + analysis->envelopeStride - 1) / analysis->envelopeStride
+                                          * analysis->envelopeOrder));
+    task->analysis = std::move (analysis);
+
+    if (detectPitch)
+        for (juce::int64 frame = 0; frame < task->numFrames; frame += kFramesPerChunk)
+            task->chunkNext.push_back (frame);
+
+    task->chunksLeft = (int) task->chunkNext.size();
+
+    const juce::ScopedLock sl (lock);
+    tasks[&audioSource] = std::move (task);
+    ++generation;
+
+    // One worker per source at most, as each has the one reader
+    if (numWorkers < juce::jmin (maxWorkers, (int) tasks.size()))
+    {
+        ++numWorkers;
+        pool.addJob (new Worker (*this), true);
+    }
+}
+
+void AnalysisScheduler::cancel (const juce::ARAAudioSource* audioSource)
+{
+    std::unique_ptr<Task> task;
+    bool wasBusy;
+
+    {
+        const juce::ScopedLock sl (lock);
+        const auto it = tasks.find (audioSource);
+
+        if (it == tasks.end())
+            return;
+
+        task = std::move (it->second);
+        tasks.erase (it);
+        task->cancelled = true;
+        wasBusy = task->busy;
+    }
+
+    // Its worker stops within a step, reporting it done
+    if (wasBusy)
+        task->released.wait (-1);
+    else if (task->started)
+        task->source.notifyAnalysisProgressCompleted();
+}
+
+void AnalysisScheduler::remove (const juce::ARAAudioSource* audioSource)
+{
+    cancel (audioSource);
+
+    const juce::ScopedLock sl (lock);
+    placements.erase (audioSource);
+
+    if (focusSource == audioSource)
+        focusSource = nullptr;
+}
+
+bool AnalysisScheduler::isAnalysing (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (lock);
+    return tasks.find (audioSource) != tasks.end();
+}
+
+//==============================================================================
+void AnalysisScheduler::setPlacements (const juce::ARAAudioSource* audioSource, std::vector<Placement> newPlacements)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (newPlacements.empty())
+        placements.erase (audioSource);
+    else
+        placements[audioSource] = std::move (newPlacements);
+
+    ++generation;
+}
+
+void AnalysisScheduler::setPlayhead (double songSeconds) noexcept
+{
+    // Playing on moves the playhead a block at a time, which the next chunk
+    // taken follows anyway; only a jump is worth a worker looking up for
+    const auto previous = playhead.exchange (songSeconds, std::memory_order_relaxed);
+
+    if (std::abs (songSeconds - previous) > kJumpSeconds)
+        generation.fetch_add (1, std::memory_order_relaxed);
+}
+
+void AnalysisScheduler::setEditFocus (const juce::ARAAudioSource* audioSource, double sourceSeconds)
+{
+    const juce::ScopedLock sl (lock);
+    focusSource  = audioSource;
+    focusSeconds = sourceSeconds;
+    ++generation;
+}
+
+//==============================================================================
+double AnalysisScheduler::getDistance (const Task& task, double start, double end) const
+{
+    auto distance = kUnplacedDistance + start;
+
+    const auto gap = [] (double position, double rangeStart, double rangeEnd)
+    {
+        return position < rangeStart ? rangeStart - position
+             : position > rangeEnd   ? kBehindWeight * (position - rangeEnd)
+                                     : 0.0;
+    };
+
+    if (focusSource == &task.source)
+        distance = juce::jmin (distance, gap (focusSeconds, start, end));
+
+    const auto it = placements.find (&task.source);
+
+    if (it == placements.end())
+        return distance;
+
+    const auto now = playhead.load (std::memory_order_relaxed);
+
+    for (const auto& placement : it->second)
+    {
+        const auto placedStart = juce::jmax (start, placement.sourceStart);
+        const auto placedEnd   = juce::jmin (end,   placement.sourceEnd);
+
+        if (placedStart < placedEnd)
+            distance = juce::jmin (distance, gap (now, placedStart + placement.sourceToSong, placedEnd + placement.sourceToSong));
+    }
+
+    return distance;
+}
+
+std::pair<int, double> AnalysisScheduler::findNearestChunk (const Task& task, int excluded) const
+{
+    // The analysis may be in the cache, so nothing is detected before the hash is done
+    if (! task.hashed)
+        return { -1, getDistance (task, 0.0, task.getSeconds (task.reader.lengthInSamples)) };
+
+    std::pair<int, double> nearest { -1, std::numeric_limits<double>::max() };
+
+    for (int chunk = 0; chunk < (int) task.chunkNext.size(); ++chunk)
+    {
+        const auto next = task.chunkNext[(size_t) chunk];
+        const auto end  = task.getChunkEnd (chunk);
+
+        if (chunk == excluded || next >= end)
+            continue;
+
+        const auto distance = getDistance (task, task.getFrameStart (next), task.getFrameEnd (end));
+
+        if (distance < nearest.second)
+            nearest = { chunk, distance };
+    }
+
+    return nearest;
+}
+
+AnalysisScheduler::Work AnalysisScheduler::acquire (Worker& worker)
+{
+    const juce::ScopedLock sl (lock);
+
+    Work nearest;
+    nearest.generation = generation.load();
+
+    if (! shuttingDown && ! worker.shouldExit())
+    {
+        for (const auto& entry : tasks)
+        {
+            const auto& task = *entry.second;
+
+            if (task.busy)
+                continue;
+
+            const auto [chunk, distance] = findNearestChunk (task, -1);
+
+            if (nearest.task == nullptr || distance < nearest.distance)
+            {
+                nearest.task     = entry.second.get();
+                nearest.chunk    = chunk;
+                nearest.distance = distance;
+            }
+        }
+    }
+
+    if (nearest.task == nullptr)
+        --numWorkers;
+    else
+        nearest.task->busy = true;
+
+    return nearest;
+}
+
+bool AnalysisScheduler::shouldYield (Work& work, double start, double end)
+{
+    const auto now = generation.load();
+
+    if (now == work.generation)
+        return false;
+
+    const juce::ScopedLock sl (lock);
+    work.generation = now;
+
+    const auto remaining = getDistance (*work.task, start, end);
+
+    // Another of its own chunks can only be taken by giving this one back
+    if (work.chunk >= 0 && findNearestChunk (*work.task, work.chunk).second + kYieldMargin < remaining)
+        return true;
+
+    for (const auto& entry : tasks)
+        if (! entry.second->busy && findNearestChunk (*entry.second, -1).second + kYieldMargin < remaining)
+            return true;
+
+    return false;
+}
+
+//==============================================================================
+void AnalysisScheduler::run (Work& work, Worker& worker)
+{
+    auto& task = *work.task;
+
+    // ARA lets analysis progress be reported from any thread
+    if (! task.started)
+    {
+        task.started = true;
+        task.source.notifyAnalysisProgressStarted();
+    }
+
+    if (work.chunk < 0)
+        runHash (work, worker);
+    else
+        runChunk (work, worker);
+}
+
+void AnalysisScheduler::runHash (Work& work, Worker& worker)
+{
+    auto& task   = *work.task;
+    auto& reader = task.reader;
+
+    const auto numChannels = (int) reader.numChannels;
+    const auto numSamples  = reader.lengthInSamples;
+
+    if (! task.hasher.has_value())
+        task.hasher.emplace (task.sampleRate, numChannels, task.numSamples);
+
+    worker.channels.setSize (numChannels, kHashBlockSize, false, false, true);
+
+    while (task.numHashed < numSamples)
+    {
+        if (task.cancelled || worker.shouldExit() || shouldYield (work, 0.0, task.getSeconds (task.numSamples)))
+            return release (task);
+
+        const auto length = (int) juce::jmin ((juce::int64) kHashBlockSize, numSamples - task.numHashed);
+
+        // The host stopped us reading part-way; access coming back starts it again
+        if (! reader.read (worker.channels.getArrayOfWritePointers(), numChannels, task.numHashed, length))
+            return finish (task, nullptr);
+
+        if (task.converter != nullptr)
+        {
+            // Its state carries over a yield, as the task does
+            const auto  numConverted = task.converter->process (worker.channels.getArrayOfReadPointers(), length);
+            const auto& converted    = task.converter->getOutput();
+
+            task.hasher->add (converted.getArrayOfReadPointers(), numChannels, numConverted);
+            task.samples->append (converted.getArrayOfReadPointers(), numConverted);
+        }
+        else
+        {
+            task.hasher->add (worker.channels.getArrayOfReadPointers(), numChannels, length);
+
+            if (task.samples != nullptr)
+                task.samples->append (worker.channels.getArrayOfReadPointers(), length);
+        }
+
+        task.waveform->append (worker.channels.getArrayOfReadPointers(), numChannels, length);
+        task.numHashed += length;
+        task.source.notifyAnalysisProgressUpdated ((task.detectPitch ? kHashProgress : 1.0f) * (float) task.numHashed / (float) numSamples);
+    }
+
+    task.key    = AnalysisCache::makeKey (task.persistentID, task.hasher->getHash());
+    task.hashed = true;
+
+    if (! task.detectPitch)
+        return finish (task, nullptr);
+
+    // One from before envelopes is analysed again, for them
+    if (auto cached = cache.find (task.key); cached != nullptr && cached->hasEnvelopes())
+        return finish (task, std::move (cached));
+
+    if (task.chunksLeft == 0)
+        return finish (task, task.analysis);
+
+    // Back in with its chunks, nearest first
+    release (task);
+}
+
+void AnalysisScheduler::runChunk (Work& work, Worker& worker)
+{
+    auto& task     = *work.task;
+    auto& analysis = *task.analysis;
+    auto& reader   = task.reader;
+
+    const auto numChannels = (int) reader.numChannels;
+    const auto size        = analysis.analysisSize;
+    const auto hop         = analysis.hop;
+    const auto first       = task.chunkNext[(size_t) work.chunk];
+    const auto end         = task.getChunkEnd (work.chunk);
+    const auto span        = (int) (end - first - 1) * hop + size;
+
+    if (worker.detector.getAnalysisSize() != size)
+    {
+        PitchDetector::Settings settings;
+        settings.analysisSize = size;
+        worker.detector.applySettings (settings);
+    }
+
+    if (worker.envelopes == nullptr || worker.envelopes->getFrameSize() != size || worker.envelopes->getOrder() != analysis.envelopeOrder)
+        worker.envelopes = std::make_unique<SpectralEnvelope::Analyser> (size, analysis.envelopeOrder);
+
+    worker.channels.setSize (numChannels, span, false, false, true);
+    worker.mono.resize ((size_t) juce::jmax ((int) worker.mono.size(), span));
+
+    auto* const* channels = worker.channels.getArrayOfWritePointers();
+
+    // Converted, the reader has the wrong rate to fall back on
+    if ((task.samples == nullptr || ! task.samples->read (channels, numChannels, first * hop, span))
+        && (task.converter != nullptr || ! reader.read (channels, numChannels, first * hop, span)))
+        return finish (task, nullptr);
+
+    // Mono mix, so a stereo vocal is analysed once rather than per side
+    const auto& kernels = VectorKernels::get();
+    auto* mono = worker.mono.data();
+    kernels.copyScaled (mono, worker.channels.getReadPointer (0), 1.0f / (float) numChannels, span);
+
+    for (int c = 1; c < numChannels; ++c)
+        kernels.multiplyAdd (mono, worker.channels.getReadPointer (c), 1.0f / (float) numChannels, span);
+
+    for (auto frame = first; frame < end; frame += kFramesPerStep)
+    {
+        // Whatever's left of the chunk is done by whoever takes it next
+        if (task.cancelled || worker.shouldExit()
+            || (frame != first && shouldYield (work, task.getFrameStart (frame), task.getFrameEnd (end))))
+        {
+            task.chunkNext[(size_t) work.chunk] = frame;
+            return release (task);
+        }
+
+        const auto stepEnd = juce::jmin (frame + kFramesPerStep, end);
+
+        PitchBatchAnalyser::detectPitchRange (worker.detector, mono + (frame - first) * hop, frame, stepEnd,
+                                              hop, task.sampleRate, analysis.points.data() + frame);
+
+        // The envelopes from the same windows, while they're in cache
+        const auto stride = (juce::int64) analysis.envelopeStride;
+
+        for (auto f = (frame + stride - 1) / stride * stride; f < stepEnd; f += stride)
+            worker.envelopes->analyse (mono + (f - first) * hop, analysis.envelopes.data() + f / stride * analysis.envelopeOrder);
+
+        task.framesDone += stepEnd - frame;
+        task.source.notifyAnalysisProgressUpdated (kHashProgress + (1.0f - kHashProgress) * (float) task.framesDone / (float) task.numFrames);
+    }
+
+    task.chunkNext[(size_t) work.chunk] = end;
+
+    if (--task.chunksLeft > 0)
+        return release (task);
+
+    cache.store (task.key, analysis);
+    finish (task, task.analysis);
+}
+
+//==============================================================================
+void AnalysisScheduler::release (Task& task)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (! task.cancelled)
+        {
+            task.busy = false;
+            return;
+        }
+    }
+
+    // cancel() owns it now, and is waiting
+    if (task.started)
+        task.source.notifyAnalysisProgressCompleted();
+
+    task.released.signal();
+}
+
+void AnalysisScheduler::finish (Task& task, std::shared_ptr<const PitchAnalysis> analysis)
+{
+    // Still busy, so a cancel() from here on waits until it's published
+    const auto succeeded = task.hashed && (analysis != nullptr || ! task.detectPitch);
+
+    if (succeeded && ! task.cancelled)
+        onAnalysed (&task.source, std::move (analysis), std::shared_ptr<const WaveformOverview> (std::move (task.waveform)));
+
+    task.source.notifyAnalysisProgressCompleted();
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (! task.cancelled)
+        {
+            const auto it = tasks.find (&task.source);
+            finished.push_back (std::move (it->second));
+            tasks.erase (it);
+            triggerAsyncUpdate();
+            return;
+        }
+    }
+
+    task.released.signal();
+}
+
+void AnalysisScheduler::handleAsyncUpdate()
+{
+    std::vector<std::unique_ptr<Task>> done;
+
+    {
+        const juce::ScopedLock sl (lock);
+        done.swap (finished);
+    }
+}
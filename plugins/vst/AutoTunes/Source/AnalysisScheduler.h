@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+    AnalysisScheduler.h  –  Pitch analysis of ARA audio sources, most
+                            wanted first
+
+    Every source is split into chunks of kFramesPerChunk analysis frames; a
+    few workers on the document controller's pool keep taking the chunk
+    nearest to where the user is, so the clip under the playhead (or the
+    one just edited) is ready first whatever order the sources came in:
+
+      • Distance is measured in song time, through the regions each source
+        plays in (see setPlacements()), from the playhead; what's behind it
+        counts kBehindWeight times as far, as playback runs forward.  The
+        edit focus counts too, measured in its source.  Chunks no region
+        plays come last, in source order.
+
+      • A worker checks between steps of kFramesPerStep frames whether the
+        playhead has jumped, or the focus moved, since it took its chunk.
+        If something else is now clearly nearer it leaves the chunk where
+        it is (the rest is done later, nothing is lost) and takes that.
+
+      • A source is hashed first, and taken from the AnalysisCache instead
+        if it's there; hashing yields the same way.  The samples hashed go
+        into the source's SampleCache, if it has one, and its chunks are
+        read from there; and into its WaveformOverview.  A source whose
+        analysis was restored can be queued just for those.
+
+      • A SampleCache at another rate from the source's has the source
+        converted to that rate as it's hashed, and everything after works
+        at that rate: the hash, and so the AnalysisCache entry, is of the
+        converted samples, the chunks are read from the cache alone, and
+        the analysis is of the source as it is at that rate.  Only the
+        waveform is of the samples as recorded.
+
+    Each chunk's spectral envelopes (see SpectralEnvelope) are worked out
+    with its pitch, from the same mono windows.
+
+    At most one worker reads a source at a time, through the source's own
+    ARAAudioSourceReader, and at most getNumCpus() / 2 run at once, leaving
+    the other cores to the host's audio threads and the render jobs.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "AnalysisCache.h"
+#include "Overview.h"
+#include "PitchAnalysis.h"
+#include "SampleCache.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class AnalysisScheduler  : private juce::AsyncUpdater
+{
+public:
+    static constexpr float  kMinFrequencyHz   = 50.0f;     // below any sung fundamental
+    static constexpr int    kHopsPerWindow    = 8;         // 256 samples at 44.1 / 48 kHz
+    static constexpr int    kFramesPerChunk   = 256;       // ~1.5 s at 44.1 kHz
+    static constexpr int    kFramesPerStep    = 64;
+    static constexpr int    kHashBlockSize    = 65536;
+    static constexpr float  kHashProgress     = 0.1f;      // share of the progress bar for hashing; reading is cheap next to YIN
+    static constexpr double kJumpSeconds      = 1.0;       // a playhead move further than this is a jump
+    static constexpr double kBehindWeight     = 4.0;
+    static constexpr double kUnplacedDistance = 1.0e9;     // seconds; further than anything placed
+    static constexpr double kYieldMargin      = 5.0;       // seconds nearer something else must be to pre-empt
+    static constexpr int    kCancelTimeoutMs  = 10000;
+
+    /** Where an audio source plays: one per playback region. */
+    struct Placement
+    {
+        double sourceStart;    ///< The region's span of the source, in seconds
+        double sourceEnd;
+        double sourceToSong;   ///< Song time = source time + sourceToSong
+    };
+
+    /** Called on a worker with each finished analysis (null if only the
+        waveform was asked for) and the source's waveform, before it stops
+        counting as running.  Not called for a cancelled one. */
+    using AnalysedCallback = std::function<void (const juce::ARAAudioSource*,
+                                                 std::shared_ptr<const PitchAnalysis>,
+                                                 std::shared_ptr<const WaveformOverview>)>;
+
+    AnalysisScheduler (juce::ThreadPool& pool, AnalysisCache& cache, AnalysedCallback onAnalysed);
+    ~AnalysisScheduler() override;
+
+    //==============================================================================
+    /** Queues audioSource, replacing any analysis of it still running, to
+        decode into samples (if not null and empty) as it's hashed, and to
+        have its pitch detected unless detectPitch is false; at the samples'
+        rate, converting to it if that's not the source's.  Nothing is
+        queued if its samples can't be read, or it's to be converted and
+        samples won't take it.  Message thread. */
+    void add (juce::ARAAudioSource& audioSource, std::shared_ptr<SampleCache> samples, bool detectPitch = true);
+
+    /** Stops audioSource's analysis, waiting for a worker that's part-way
+        through it (or publishing it).  Message thread. */
+    void cancel (const juce::ARAAudioSource* audioSource);
+
+    /** cancel(), and forgets where it plays, for a source being destroyed.
+        Message thread. */
+    void remove (const juce::ARAAudioSource* audioSource);
+
+    /** True while audioSource is queued or being analysed.  Any thread. */
+    bool isAnalysing (const juce::ARAAudioSource* audioSource) const;
+
+    //==============================================================================
+    /** Where audioSource's regions place it in the song.  Message thread,
+        whenever a region is added, removed or changed. */
+    void setPlacements (const juce::ARAAudioSource* audioSource, std::vector<Placement> placements);
+
+    /** The song time being played.  Lock-free: call it from the audio
+        thread, every block. */
+    void setPlayhead (double songSeconds) noexcept;
+
+    /** Where the user is working: a time in one source.  Message thread. */
+    void setEditFocus (const juce::ARAAudioSource* audioSource, double sourceSeconds);
+
+private:
+    //==============================================================================
+    struct Task;
+    class Worker;
+
+    /** A task and the chunk of it to do (-1: hash it), with how far it is
+        from the playhead or focus. */
+    struct Work
+    {
+        Task*        task       = nullptr;
+        int          chunk      = -1;
+        double       distance   = 0.0;
+        juce::uint32 generation = 0;   // of the priorities it was chosen under
+    };
+
+    /** The nearest work nobody has, marked taken; an empty Work (and one
+        worker fewer) if there's none or worker must exit.  Worker. */
+    Work acquire (Worker& worker);
+
+    /** Does work until it's done, pre-empted or cancelled. */
+    void run (Work& work, Worker& worker);
+    void runHash (Work& work, Worker& worker);
+    void runChunk (Work& work, Worker& worker);
+
+    /** True if the priorities changed since work was chosen and something
+        else is now kYieldMargin nearer than what's left of it, source
+        seconds [start, end).  Worker. */
+    bool shouldYield (Work& work, double start, double end);
+
+    /** Gives the task back.  Worker; the task may be gone once it returns. */
+    void release (Task& task);
+
+    /** Publishes analysis (or just the waveform, if that's all the task
+        was for and it's done), then drops the task.  Worker. */
+    void finish (Task& task, std::shared_ptr<const PitchAnalysis> analysis);
+
+    /** How far source seconds [start, end) of task are from being wanted.  Under lock. */
+    double getDistance (const Task& task, double start, double end) const;
+
+    /** The nearest chunk task still has to do but excluded, or -1 to hash
+        it first.  Under lock. */
+    std::pair<int, double> findNearestChunk (const Task& task, int excluded) const;
+
+    /** Frees finished tasks, whose readers must go on the message thread. */
+    void handleAsyncUpdate() override;
+
+    juce::ThreadPool&      pool;
+    AnalysisCache&         cache;
+    const AnalysedCallback onAnalysed;
+    const int              maxWorkers;
+
+    mutable juce::CriticalSection                                  lock;
+    std::map<const juce::ARAAudioSource*, std::unique_ptr<Task>>   tasks;
+    std::map<const juce::ARAAudioSource*, std::vector<Placement>>  placements;   // kept across re-analysis
+    std::vector<std::unique_ptr<Task>>                             finished;     // freed on the message thread
+    const juce::ARAAudioSource*                                    focusSource  = nullptr;
+    double                                                         focusSeconds = 0.0;
+    int                                                            numWorkers   = 0;
+    bool                                                           shuttingDown = false;
+
+    std::atomic<double>       playhead   { 0.0 };
+    std::atomic<juce::uint32> generation { 0 };   // bumped whenever priorities jump
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisScheduler)
+};
@@ -0,0 +1,728 @@
+/*
+  ==============================================================================
+    NoteEditor.cpp  –  NoteEditor implementation
+  ==============================================================================
+*/
+
+#include "NoteEditor.h"
+
+namespace NoteColours
+{
+    const juce::Colour background   { 0xff0d1117 };
+    const juce::Colour blackKeyRow  { 0xff080c12 };
+    const juce::Colour semitoneLine { 0xff1c2330 };
+    const juce::Colour octaveLine   { 0xff3d4451 };
+    const juce::Colour lane         { 0xff131a24 };
+    const juce::Colour blob         { 0xc045aaf2 };
+    const juce::Colour pitchTrack   { 0xff26de81 };
+    const juce::Colour hovered      { 0xff8fd0ff };
+    const juce::Colour selected     { 0xffffd700 };
+    const juce::Colour text         { 0xff8b949e };
+}
+
+static bool isBlackKey (int midiNote) noexcept
+{
+    const int s = ((midiNote % 12) + 12) % 12;
+    return s == 1 || s == 3 || s == 6 || s == 8 || s == 10;
+}
+
+//==============================================================================
+bool NoteEditor::Lane::operator== (const Lane& other) const noexcept
+{
+    return region == other.region && modification == other.modification && source == other.source
+        && notes == other.notes && pitch == other.pitch && edits.isSameVersionAs (other.edits)
+        && sourceStart == other.sourceStart && sourceEnd == other.sourceEnd
+        && sourceToSong == other.sourceToSong;
+}
+
+//==============================================================================
+int NoteEditor::BlobGrid::getColumn (double seconds) const noexcept
+{
+    return juce::jlimit (0, numColumns - 1, (int) std::floor ((seconds - timeOrigin) / kCellSeconds));
+}
+
+int NoteEditor::BlobGrid::getRow (float midi) const noexcept
+{
+    return juce::jlimit (0, numRows - 1, (int) std::floor ((midi - pitchOrigin) / kCellSemitones));
+}
+
+void NoteEditor::BlobGrid::build (const std::vector<Blob>& blobs)
+{
+    cellStarts.clear();
+    entries.clear();
+    stamps.assign (blobs.size(), 0);
+    stamp      = 0;
+    numColumns = 0;
+    numRows    = 0;
+
+    if (blobs.empty())
+        return;
+
+    auto timeEnd  = blobs.front().end;
+    auto pitchEnd = blobs.front().midi + 0.5f;
+    timeOrigin    = blobs.front().start;
+    pitchOrigin   = blobs.front().midi - 0.5f;
+
+    for (const auto& blob : blobs)
+    {
+        timeOrigin  = juce::jmin (timeOrigin, blob.start);
+        timeEnd     = juce::jmax (timeEnd, blob.end);
+        pitchOrigin = juce::jmin (pitchOrigin, blob.midi - 0.5f);
+        pitchEnd    = juce::jmax (pitchEnd, blob.midi + 0.5f);
+    }
+
+    numColumns = (int) ((timeEnd - timeOrigin) / kCellSeconds) + 1;
+    numRows    = (int) ((pitchEnd - pitchOrigin) / kCellSemitones) + 1;
+
+    const auto forEachCell = [this] (const Blob& blob, auto&& visit)
+    {
+        const auto lastColumn = getColumn (blob.end);
+        const auto firstRow   = getRow (blob.midi - 0.5f);
+        const auto lastRow    = getRow (blob.midi + 0.5f);
+
+        for (auto column = getColumn (blob.start); column <= lastColumn; ++column)
+            for (auto row = firstRow; row <= lastRow; ++row)
+                visit (column * numRows + row);
+    };
+
+    // Count, then fill each cell's span in index order
+    cellStarts.assign ((size_t) (numColumns * numRows + 1), 0);
+
+    for (const auto& blob : blobs)
+        forEachCell (blob, [this] (int cell) { ++cellStarts[(size_t) cell + 1]; });
+
+    for (size_t cell = 1; cell < cellStarts.size(); ++cell)
+        cellStarts[cell] += cellStarts[cell - 1];
+
+    entries.resize ((size_t) cellStarts.back());
+    std::vector<int> next (cellStarts.begin(), cellStarts.end() - 1);
+
+    for (size_t i = 0; i < blobs.size(); ++i)
+        forEachCell (blobs[i], [&] (int cell) { entries[(size_t) next[(size_t) cell]++] = (int) i; });
+}
+
+void NoteEditor::BlobGrid::find (const std::vector<Blob>& blobs, double start, double end, float low, float high,
+                                 std::vector<int>& found)
+{
+    found.clear();
+
+    if (numColumns == 0 || stamps.size() != blobs.size())
+        return;
+
+    const auto overlaps = [&] (const Blob& blob)
+    {
+        return blob.end > start && blob.start < end && blob.midi + 0.5f > low && blob.midi - 0.5f < high;
+    };
+
+    const auto firstColumn = getColumn (start);
+    const auto lastColumn  = getColumn (end);
+    const auto firstRow    = getRow (low);
+    const auto lastRow     = getRow (high);
+
+    // A wide view can list a blob in many cells; past as many candidates as
+    // there are blobs, one pass over the blobs is cheaper
+    size_t numCandidates = 0;
+
+    for (auto column = firstColumn; column <= lastColumn; ++column)
+        numCandidates += (size_t) (cellStarts[(size_t) (column * numRows + lastRow + 1)]
+                                   - cellStarts[(size_t) (column * numRows + firstRow)]);
+
+    if (numCandidates >= blobs.size())
+    {
+        for (size_t i = 0; i < blobs.size(); ++i)
+            if (overlaps (blobs[i]))
+                found.push_back ((int) i);
+
+        return;
+    }
+
+    if (++stamp == 0)
+    {
+        std::fill (stamps.begin(), stamps.end(), 0u);
+        stamp = 1;
+    }
+
+    for (auto column = firstColumn; column <= lastColumn; ++column)
+    {
+        const auto first = cellStarts[(size_t) (column * numRows + firstRow)];
+        const auto last  = cellStarts[(size_t) (column * numRows + lastRow + 1)];
+
+        for (auto entry = first; entry < last; ++entry)
+        {
+            const auto i = entries[(size_t) entry];
+
+            if (stamps[(size_t) i] != stamp)
+            {
+                stamps[(size_t) i] = stamp;
+
+                if (overlaps (blobs[(size_t) i]))
+                    found.push_back (i);
+            }
+        }
+    }
+}
+
+//==============================================================================
+NoteEditor::NoteEditor (AutoTunesDocumentController& documentController)
+    : controller (documentController)
+{
+    setOpaque (true);
+    setWantsKeyboardFocus (true);   // for undo and redo
+    refresh();
+    startTimer (kRefreshMs);
+}
+
+NoteEditor::~NoteEditor()
+{
+    stopTimer();
+}
+
+void NoteEditor::setView (double startSeconds, double newSecondsPerPixel, float newTopMidi, float newPixelsPerSemitone)
+{
+    newSecondsPerPixel   = juce::jlimit (kMinSecondsPerPixel, kMaxSecondsPerPixel, newSecondsPerPixel);
+    newPixelsPerSemitone = juce::jlimit (kMinPixelsPerSemitone, kMaxPixelsPerSemitone, newPixelsPerSemitone);
+
+    // Keep MIDI 0 – 127 on screen as far as it fills it
+    const auto visibleSemitones = (float) getHeight() / newPixelsPerSemitone;
+    newTopMidi = juce::jlimit (juce::jmin (128.0f, visibleSemitones), juce::jmax (128.0f, visibleSemitones), newTopMidi);
+
+    if (startSeconds == viewStart && newSecondsPerPixel == secondsPerPixel
+        && newTopMidi == topMidi && newPixelsPerSemitone == pixelsPerSemitone)
+        return;
+
+    viewStart         = startSeconds;
+    secondsPerPixel   = newSecondsPerPixel;
+    topMidi           = newTopMidi;
+    pixelsPerSemitone = newPixelsPerSemitone;
+    hoveredBlob       = -1;
+    invalidateContent();
+}
+
+void NoteEditor::showAll()
+{
+    if (blobs.empty() || getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    auto start = blobs.front().start, end  = blobs.front().end;
+    auto low   = blobs.front().midi,  high = blobs.front().midi;
+
+    for (const auto& blob : blobs)
+    {
+        start = juce::jmin (start, blob.start);
+        end   = juce::jmax (end, blob.end);
+        low   = juce::jmin (low, blob.midi);
+        high  = juce::jmax (high, blob.midi);
+    }
+
+    // A semitone and a half of room above and below
+    const auto semitones = high - low + 3.0f;
+    setView (start, (end - start) / (double) getWidth(), high + 1.5f, (float) getHeight() / semitones);
+}
+
+void NoteEditor::invalidateContent()
+{
+    contentScale = 0.0f;
+    repaint();
+}
+
+void NoteEditor::resized()
+{
+    contentCache = {};
+    contentScale = 0.0f;
+
+    if (! viewMoved)
+        showAll();
+}
+
+//==============================================================================
+void NoteEditor::timerCallback()
+{
+    if (isShowing())
+        refresh();
+}
+
+void NoteEditor::refresh()
+{
+    std::vector<Lane> current;
+    current.reserve (lanes.size());
+
+    for (auto* audioSource : controller.getDocumentController()->getDocument()->getAudioSources<juce::ARAAudioSource>())
+    {
+        auto notes = controller.getNoteIndex (audioSource);
+
+        if (notes == nullptr)
+            continue;
+
+        auto pitch = controller.getPitchOverview (audioSource);
+
+        for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+        {
+            const auto edits = controller.getNoteEdits (audioModification);
+
+            for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+                current.push_back ({ playbackRegion, audioModification, audioSource, notes, pitch, edits,
+                                     playbackRegion->getStartInAudioModificationTime(),
+                                     playbackRegion->getEndInAudioModificationTime(),
+                                     playbackRegion->getStartInPlaybackTime() - playbackRegion->getStartInAudioModificationTime() });
+        }
+    }
+
+    if (current == lanes)
+        return;
+
+    lanes = std::move (current);
+    rebuildBlobs();
+
+    if (! viewMoved)
+        showAll();
+
+    invalidateContent();
+}
+
+void NoteEditor::rebuildBlobs()
+{
+    blobs.clear();
+    hoveredBlob = -1;
+
+    for (size_t l = 0; l < lanes.size(); ++l)
+    {
+        const auto& lane  = lanes[l];
+        const auto& notes = lane.notes->getNotes();
+        const auto  range = lane.notes->findNotes (lane.sourceStart, lane.sourceEnd);
+
+        for (auto n = range.first; n < range.second; ++n)
+        {
+            const auto& note   = notes[n];
+            const auto* edited = lane.edits.find (note.start);
+
+            blobs.push_back ({ juce::jmax (note.start, lane.sourceStart) + lane.sourceToSong,
+                               juce::jmin (note.end, lane.sourceEnd) + lane.sourceToSong,
+                               edited != nullptr ? edited->targetMidi : note.midi, (int) l, (int) n });
+        }
+    }
+
+    grid.build (blobs);
+}
+
+//==============================================================================
+juce::Rectangle<float> NoteEditor::getBlobBounds (const Blob& blob) const noexcept
+{
+    const auto x = timeToX (blob.start);
+    const auto y = midiToY (blob.midi + 0.5f);
+
+    // At least a pixel, so a note too short for the zoom still shows
+    return { x, y, juce::jmax (1.0f, timeToX (blob.end) - x), pixelsPerSemitone };
+}
+
+int NoteEditor::findBlobAt (juce::Point<float> position)
+{
+    const auto slopSeconds   = (double) kHitSlop * secondsPerPixel;
+    const auto slopSemitones = kHitSlop / pixelsPerSemitone;
+    const auto seconds       = xToTime (position.x);
+    const auto midi          = yToMidi (position.y);
+
+    grid.find (blobs, seconds - slopSeconds, seconds + slopSeconds, midi - slopSemitones, midi + slopSemitones, visibleBlobs);
+
+    // Drawn in index order, so the highest index is on top
+    int hit = -1;
+
+    for (auto i : visibleBlobs)
+        if (i > hit && getBlobBounds (blobs[(size_t) i]).expanded (kHitSlop).contains (position))
+            hit = i;
+
+    return hit;
+}
+
+int NoteEditor::findSelectedBlob() const noexcept
+{
+    if (selectedRegion == nullptr)
+        return -1;
+
+    for (size_t i = 0; i < blobs.size(); ++i)
+        if (blobs[i].note == selectedNote && lanes[(size_t) blobs[i].lane].region == selectedRegion)
+            return (int) i;
+
+    return -1;
+}
+
+//==============================================================================
+void NoteEditor::paint (juce::Graphics& g)
+{
+    // Follows the display we're on, as PFix's pitch graph does
+    const auto pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (! contentCache.isValid() || pixelScale != contentScale)
+        renderContentCache (pixelScale);
+
+    g.drawImage (contentCache, getLocalBounds().toFloat());
+
+    if (const auto selected = findSelectedBlob(); selected >= 0)
+        drawBlobHighlight (g, blobs[(size_t) selected], true);
+
+    if (hoveredBlob >= 0)
+        drawBlobHighlight (g, blobs[(size_t) hoveredBlob], false);
+
+    if (blobs.empty())
+    {
+        g.setColour (NoteColours::text);
+        g.setFont (juce::FontOptions (14.0f));
+        g.drawText (lanes.empty() ? "Waiting for analysed regions..." : "No notes found",
+                    getLocalBounds(), juce::Justification::centred);
+    }
+}
+
+void NoteEditor::renderContentCache (float pixelScale)
+{
+    contentScale = pixelScale;
+
+    const int w = juce::roundToInt ((float) getWidth()  * pixelScale);
+    const int h = juce::roundToInt ((float) getHeight() * pixelScale);
+
+    if (w <= 0 || h <= 0)
+    {
+        contentCache = {};
+        return;
+    }
+
+    if (contentCache.getWidth() != w || contentCache.getHeight() != h)
+        contentCache = juce::Image (juce::Image::RGB, w, h, false);
+
+    juce::Graphics cacheGraphics (contentCache);
+    cacheGraphics.addTransform (juce::AffineTransform::scale (pixelScale));
+
+    drawGrid        (cacheGraphics);
+    drawLanes       (cacheGraphics);
+    drawBlobs       (cacheGraphics);
+    drawPitchTracks (cacheGraphics);
+}
+
+void NoteEditor::drawGrid (juce::Graphics& g) const
+{
+    g.fillAll (NoteColours::background);
+
+    const auto width   = (float) getWidth();
+    const auto lowest  = (int) std::floor (yToMidi ((float) getHeight()));
+    const auto highest = (int) std::ceil (topMidi);
+
+    juce::RectangleList<float> blackRows;
+
+    for (auto midi = lowest; midi <= highest; ++midi)
+        if (isBlackKey (midi))
+            blackRows.addWithoutMerging ({ 0.0f, midiToY ((float) midi + 0.5f), width, pixelsPerSemitone });
+
+    g.setColour (NoteColours::blackKeyRow);
+    g.fillRectList (blackRows);
+
+    // Lines between rows, brighter below each C; too dense to help when zoomed out
+    for (auto midi = lowest; midi <= highest; ++midi)
+    {
+        const auto isOctave = ((midi % 12) + 12) % 12 == 0;
+
+        if (! isOctave && pixelsPerSemitone < 6.0f)
+            continue;
+
+        g.setColour (isOctave ? NoteColours::octaveLine : NoteColours::semitoneLine);
+        g.drawHorizontalLine (juce::roundToInt (midiToY ((float) midi - 0.5f)), 0.0f, width);
+    }
+}
+
+void NoteEditor::drawLanes (juce::Graphics& g) const
+{
+    const auto viewEnd = xToTime ((float) getWidth());
+    juce::RectangleList<float> spans;
+
+    for (const auto& lane : lanes)
+    {
+        const auto start = lane.sourceStart + lane.sourceToSong;
+        const auto end   = lane.sourceEnd + lane.sourceToSong;
+
+        if (end > viewStart && start < viewEnd)
+        {
+            const auto x0 = juce::jmax (0.0f, timeToX (start));
+            const auto x1 = juce::jmin ((float) getWidth(), timeToX (end));
+            spans.addWithoutMerging ({ x0, (float) getHeight() - 3.0f, juce::jmax (1.0f, x1 - x0), 3.0f });
+        }
+    }
+
+    g.setColour (NoteColours::lane.brighter (0.6f));
+    g.fillRectList (spans);
+}
+
+void NoteEditor::drawBlobs (juce::Graphics& g)
+{
+    grid.find (blobs, viewStart, xToTime ((float) getWidth()), yToMidi ((float) getHeight()), topMidi, visibleBlobs);
+
+    // One fill for the slivers, one for the rest, however many there are;
+    // zoomed out most blobs are slivers, and many share a pixel
+    juce::RectangleList<float> slivers;
+    juce::Path                 rounded;
+    const auto                 corner = juce::jmin (4.0f, pixelsPerSemitone * 0.3f);
+
+    for (auto i : visibleBlobs)
+    {
+        const auto bounds = getBlobBounds (blobs[(size_t) i]);
+
+        if (bounds.getWidth() < kRoundedMinWidth)
+            slivers.addWithoutMerging (bounds);
+        else
+            rounded.addRoundedRectangle (bounds.reduced (0.0f, 0.5f), corner);
+    }
+
+    g.setColour (NoteColours::blob);
+    g.fillRectList (slivers);
+    g.fillPath (rounded);
+}
+
+void NoteEditor::drawPitchTracks (juce::Graphics& g)
+{
+    const auto width   = getWidth();
+    const auto viewEnd = xToTime ((float) width);
+    juce::RectangleList<float> spans;
+
+    for (const auto& lane : lanes)
+    {
+        const auto start = lane.sourceStart + lane.sourceToSong;
+        const auto end   = lane.sourceEnd + lane.sourceToSong;
+
+        if (lane.pitch == nullptr || end <= viewStart || start >= viewEnd)
+            continue;
+
+        // Whole pixel columns of the region that are on screen
+        const auto firstX = juce::jmax (0, (int) std::floor (timeToX (start)));
+        const auto endX   = juce::jmin (width, (int) std::ceil (timeToX (end)));
+
+        if (endX <= firstX)
+            continue;
+
+        pitchColumns.resize ((size_t) (endX - firstX));
+        lane.pitch->getColumns (xToTime ((float) firstX) - lane.sourceToSong, secondsPerPixel,
+                                pitchColumns.data(), endX - firstX);
+
+        for (auto x = firstX; x < endX; ++x)
+        {
+            const auto& column = pitchColumns[(size_t) (x - firstX)];
+
+            if (column.voiced <= 0.0f || column.low > column.high)
+                continue;
+
+            const auto top = midiToY (column.high);
+            spans.addWithoutMerging ({ (float) x, top, 1.0f, juce::jmax (1.5f, midiToY (column.low) - top) });
+        }
+    }
+
+    g.setColour (NoteColours::pitchTrack);
+    g.fillRectList (spans);
+}
+
+void NoteEditor::drawBlobHighlight (juce::Graphics& g, const Blob& blob, bool selected) const
+{
+    auto bounds = getBlobBounds (blob);
+
+    // Where the note goes if the drag ends here
+    if (selected && dragSemitones != 0.0f)
+    {
+        bounds = bounds.translated (0.0f, -dragSemitones * pixelsPerSemitone);
+        g.setColour (NoteColours::selected.withAlpha (0.5f));
+        g.fillRoundedRectangle (bounds, juce::jmin (4.0f, pixelsPerSemitone * 0.3f));
+    }
+
+    if (! bounds.intersects (getLocalBounds().toFloat()))
+        return;
+
+    g.setColour (selected ? NoteColours::selected : NoteColours::hovered);
+    g.drawRoundedRectangle (bounds.expanded (1.0f), juce::jmin (4.0f, pixelsPerSemitone * 0.3f), 1.5f);
+}
+
+//==============================================================================
+void NoteEditor::mouseMove (const juce::MouseEvent& e)
+{
+    const auto hit = findBlobAt (e.position);
+
+    if (hit == hoveredBlob)
+        return;
+
+    // Only around the two outlines; the rest comes from the cache
+    if (hoveredBlob >= 0)
+        repaint (getBlobBounds (blobs[(size_t) hoveredBlob]).expanded (3.0f).getSmallestIntegerContainer());
+
+    hoveredBlob = hit;
+
+    if (hoveredBlob >= 0)
+        repaint (getBlobBounds (blobs[(size_t) hoveredBlob]).expanded (3.0f).getSmallestIntegerContainer());
+}
+
+void NoteEditor::mouseExit (const juce::MouseEvent&)
+{
+    if (hoveredBlob >= 0)
+        repaint (getBlobBounds (blobs[(size_t) hoveredBlob]).expanded (3.0f).getSmallestIntegerContainer());
+
+    hoveredBlob = -1;
+}
+
+void NoteEditor::mouseDown (const juce::MouseEvent& e)
+{
+    // The regions may have changed since the last poll, and a click must
+    // not focus on a source that's gone
+    refresh();
+
+    const auto hit = findBlobAt (e.position);
+    panning = hit < 0;
+
+    if (panning)
+    {
+        dragViewStart = viewStart;
+        dragTopMidi   = topMidi;
+        return;
+    }
+
+    const auto& blob = blobs[(size_t) hit];
+    const auto& lane = lanes[(size_t) blob.lane];
+
+    selectedRegion = lane.region;
+    selectedNote   = blob.note;
+    dragSemitones  = 0.0f;
+    controller.setEditFocus (lane.source, lane.notes->getNotes()[(size_t) blob.note].start);
+    grabKeyboardFocus();
+    repaint();
+}
+
+void NoteEditor::mouseDrag (const juce::MouseEvent& e)
+{
+    if (! panning)
+    {
+        // Whole semitones unless shift is down
+        const auto semitones = -(float) e.getDistanceFromDragStartY() / pixelsPerSemitone;
+        dragSemitones = e.mods.isShiftDown() ? semitones : std::round (semitones);
+        repaint();
+        return;
+    }
+
+    viewMoved = true;
+    setView (dragViewStart - e.getDistanceFromDragStartX() * secondsPerPixel,
+             secondsPerPixel,
+             dragTopMidi + (float) e.getDistanceFromDragStartY() / pixelsPerSemitone,
+             pixelsPerSemitone);
+}
+
+void NoteEditor::mouseUp (const juce::MouseEvent&)
+{
+    if (panning || dragSemitones == 0.0f)
+        return;
+
+    const auto selected = findSelectedBlob();
+    const auto moved    = dragSemitones;
+    dragSemitones = 0.0f;
+
+    if (selected >= 0)
+        moveSelectedNote (blobs[(size_t) selected].midi + moved);
+
+    repaint();
+}
+
+void NoteEditor::moveSelectedNote (float targetMidi)
+{
+    // The modification must still be there to take the edit
+    refresh();
+
+    const auto selected = findSelectedBlob();
+
+    if (selected < 0)
+        return;
+
+    const auto& blob = blobs[(size_t) selected];
+    const auto& lane = lanes[(size_t) blob.lane];
+    const auto& note = lane.notes->getNotes()[(size_t) blob.note];
+
+    NoteEdit edit { note.start, note.end, targetMidi };
+
+    if (const auto* existing = lane.edits.find (note.start))
+    {
+        edit            = *existing;
+        edit.targetMidi = targetMidi;
+    }
+
+    controller.setNoteEdits (lane.modification, lane.edits.with (edit));
+    refresh();
+}
+
+bool NoteEditor::undoSelected (bool redo)
+{
+    refresh();
+
+    const auto selected = findSelectedBlob();
+
+    if (selected < 0)
+        return false;
+
+    auto* modification = lanes[(size_t) blobs[(size_t) selected].lane].modification;
+
+    if (! (redo ? controller.redoNoteEdits (modification) : controller.undoNoteEdits (modification)))
+        return false;
+
+    refresh();
+    return true;
+}
+
+bool NoteEditor::keyPressed (const juce::KeyPress& key)
+{
+    // Unhandled (nothing selected, nothing to undo) goes on to the host
+    if (key == juce::KeyPress ('z', juce::ModifierKeys::commandModifier, 0))
+        return undoSelected (false);
+
+    if (key == juce::KeyPress ('z', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+        return undoSelected (true);
+
+    return false;
+}
+
+void NoteEditor::mouseDoubleClick (const juce::MouseEvent&)
+{
+    viewMoved = false;
+    showAll();
+}
+
+void NoteEditor::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    viewMoved = true;
+
+    // One wheel notch ≈ ×0.75, as in PFix's session view
+    const auto delta = wheel.deltaY != 0.0f ? wheel.deltaY : wheel.deltaX;
+
+    if (e.mods.isCommandDown())
+    {
+        const auto anchor = xToTime (e.position.x);
+        const auto factor = std::pow (2.0, -4.0 * (double) delta);
+        const auto spp    = juce::jlimit (kMinSecondsPerPixel, kMaxSecondsPerPixel, secondsPerPixel * factor);
+
+        setView (anchor - (anchor - viewStart) * spp / secondsPerPixel, spp, topMidi, pixelsPerSemitone);
+    }
+    else if (e.mods.isAltDown())
+    {
+        const auto anchor = yToMidi (e.position.y);
+        const auto pps    = juce::jlimit (kMinPixelsPerSemitone, kMaxPixelsPerSemitone,
+                                          pixelsPerSemitone * (float) std::pow (2.0, 4.0 * (double) delta));
+
+        setView (viewStart, secondsPerPixel, anchor + (topMidi - anchor) * pixelsPerSemitone / pps, pps);
+    }
+    else if (e.mods.isShiftDown() || wheel.deltaY == 0.0f)
+    {
+        setView (viewStart - (double) delta * 200.0 * secondsPerPixel, secondsPerPixel, topMidi, pixelsPerSemitone);
+    }
+    else
+    {
+        setView (viewStart, secondsPerPixel, topMidi + delta * 200.0f / pixelsPerSemitone, pixelsPerSemitone);
+    }
+}
+
+void NoteEditor::mouseMagnify (const juce::MouseEvent& e, float scaleFactor)
+{
+    if (scaleFactor <= 0.0f)
+        return;
+
+    viewMoved = true;
+
+    const auto anchor = xToTime (e.position.x);
+    const auto spp    = juce::jlimit (kMinSecondsPerPixel, kMaxSecondsPerPixel, secondsPerPixel / (double) scaleFactor);
+
+    setView (anchor - (anchor - viewStart) * spp / secondsPerPixel, spp, topMidi, pixelsPerSemitone);
+}
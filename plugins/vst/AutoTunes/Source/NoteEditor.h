@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+    NoteEditor.h  –  The document's notes as blobs on a piano roll
+
+    Every playback region's notes (from its source's NoteIndex), placed in
+    song time and clipped to the region, with the pitch track under them
+    (from its PitchOverview).  Nothing here is a component per note, and
+    nothing costs more than what's on screen:
+
+      • Blobs live in a BlobGrid, a uniform grid of kCellSeconds by
+        kCellSemitones cells, so painting and hit-testing only look at the
+        blobs in the cells they cover; a view covering more candidates than
+        there are blobs just scans them all.
+
+      • Visible blobs go into one RectangleList (and one Path for those
+        wide enough to round), filled once; the pitch track is a min–max
+        span per pixel column, a few pyramid bins each, whatever the zoom.
+
+      • All that is rendered into contentCache, at the display's pixel
+        scale, and only again when the view, the size or the data changes;
+        a hover or a selection draws over the cached image.
+
+    The controller is polled every kRefreshMs for new analyses, new edits
+    and moved regions, which rebuilds the blobs only if something changed.
+    The mouse wheel scrolls (pitch; time with shift), Cmd/Ctrl+wheel zooms
+    time around the pointer and Alt+wheel pitch, dragging the background
+    pans and a double click shows everything.  Clicking a note makes it the
+    edit focus; dragging it up or down moves it by semitones (freely with
+    shift), as one edit of its modification's NoteEdits, which Cmd/Ctrl+Z
+    and Cmd/Ctrl+Shift+Z undo and redo.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "PluginARADocumentController.h"
+#include <memory>
+#include <vector>
+
+class NoteEditor  : public juce::Component,
+                    private juce::Timer
+{
+public:
+    static constexpr double kCellSeconds          = 2.0;
+    static constexpr float  kCellSemitones        = 6.0f;
+    static constexpr int    kRefreshMs            = 100;
+    static constexpr double kMinSecondsPerPixel   = 0.0005;   // 2000 px per second
+    static constexpr double kMaxSecondsPerPixel   = 10.0;     // a 3-hour session in ~1000 px
+    static constexpr float  kMinPixelsPerSemitone = 2.0f;
+    static constexpr float  kMaxPixelsPerSemitone = 40.0f;
+    static constexpr float  kRoundedMinWidth      = 6.0f;     // narrower blobs are plain rectangles
+    static constexpr float  kHitSlop              = 2.0f;     // pixels around a blob that still hit it
+
+    /** The controller must outlive the editor. */
+    explicit NoteEditor (AutoTunesDocumentController& documentController);
+    ~NoteEditor() override;
+
+    /** The visible span: song seconds from the left edge and per pixel,
+        the MIDI note at the top edge and pixels per semitone; clamped. */
+    void setView (double startSeconds, double secondsPerPixel, float topMidi, float pixelsPerSemitone);
+
+    /** Zooms out to every blob in the document. */
+    void showAll();
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+    void mouseMove (const juce::MouseEvent& e) override;
+    void mouseExit (const juce::MouseEvent& e) override;
+    void mouseDown (const juce::MouseEvent& e) override;
+    void mouseDrag (const juce::MouseEvent& e) override;
+    void mouseUp (const juce::MouseEvent& e) override;
+    void mouseDoubleClick (const juce::MouseEvent& e) override;
+    void mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+    void mouseMagnify (const juce::MouseEvent& e, float scaleFactor) override;
+    bool keyPressed (const juce::KeyPress& key) override;
+
+private:
+    //==============================================================================
+    /** One playback region, as of the last refresh. */
+    struct Lane
+    {
+        const juce::ARAPlaybackRegion*       region;         // only compared; may be gone by the next refresh
+        juce::ARAAudioModification*          modification;   // likewise
+        const juce::ARAAudioSource*          source;
+        std::shared_ptr<const NoteIndex>     notes;
+        std::shared_ptr<const PitchOverview> pitch;
+        NoteEdits                            edits;
+        double                               sourceStart, sourceEnd, sourceToSong;
+
+        bool operator== (const Lane& other) const noexcept;
+    };
+
+    /** One note of one lane, in song time. */
+    struct Blob
+    {
+        double start, end;   // song seconds, clipped to the lane's region
+        float  midi;         // as edited
+        int    lane;
+        int    note;         // into the lane's NoteIndex
+    };
+
+    /** Which blobs fall in which cells: each blob is listed in every cell
+        it overlaps, cells column by column, so a column's run of rows is
+        one contiguous span of entries. */
+    class BlobGrid
+    {
+    public:
+        void build (const std::vector<Blob>& blobs);
+
+        /** Fills found with the blobs meeting song seconds [start, end) and
+            MIDI [low, high), each once, in index order if scanned and cell
+            order otherwise. */
+        void find (const std::vector<Blob>& blobs, double start, double end, float low, float high,
+                   std::vector<int>& found);
+
+    private:
+        int getColumn (double seconds) const noexcept;
+        int getRow (float midi) const noexcept;
+
+        double                    timeOrigin  = 0.0;
+        float                     pitchOrigin = 0.0f;
+        int                       numColumns  = 0;
+        int                       numRows     = 0;
+        std::vector<int>          cellStarts;   // numColumns * numRows + 1
+        std::vector<int>          entries;
+        std::vector<juce::uint32> stamps;       // per blob: the last find() that took it
+        juce::uint32              stamp = 0;
+    };
+
+    void timerCallback() override;
+
+    /** Reads the document's regions and their analyses, and rebuilds the
+        blobs if any of it changed.  Message thread. */
+    void refresh();
+    void rebuildBlobs();
+
+    /** Renders grid, blobs and pitch tracks into contentCache. */
+    void renderContentCache (float pixelScale);
+    void drawGrid (juce::Graphics& g) const;
+    void drawLanes (juce::Graphics& g) const;
+    void drawBlobs (juce::Graphics& g);
+    void drawPitchTracks (juce::Graphics& g);
+    void drawBlobHighlight (juce::Graphics& g, const Blob& blob, bool selected) const;
+
+    /** The topmost blob within kHitSlop of position, or -1. */
+    int findBlobAt (juce::Point<float> position);
+
+    /** The selected note's blob, or -1 if it isn't in the document any more. */
+    int findSelectedBlob() const noexcept;
+
+    /** Moves the selected note to targetMidi, as an edit.  Message thread. */
+    void moveSelectedNote (float targetMidi);
+
+    /** Undoes (or redoes) the selected note's modification's last edit. */
+    bool undoSelected (bool redo);
+
+    juce::Rectangle<float> getBlobBounds (const Blob& blob) const noexcept;
+    void invalidateContent();
+
+    float  timeToX (double seconds) const noexcept { return (float) ((seconds - viewStart) / secondsPerPixel); }
+    double xToTime (float x) const noexcept        { return viewStart + (double) x * secondsPerPixel; }
+    float  midiToY (float midi) const noexcept     { return (topMidi - midi) * pixelsPerSemitone; }
+    float  yToMidi (float y) const noexcept        { return topMidi - y / pixelsPerSemitone; }
+
+    //==============================================================================
+    AutoTunesDocumentController& controller;
+
+    std::vector<Lane> lanes;
+    std::vector<Blob> blobs;
+    BlobGrid          grid;
+    std::vector<int>  visibleBlobs;                     // reused by every find()
+    std::vector<PitchOverview::Column> pitchColumns;    // reused by drawPitchTracks()
+
+    double viewStart         = 0.0;
+    double secondsPerPixel   = 0.01;
+    float  topMidi           = 84.0f;
+    float  pixelsPerSemitone = 10.0f;
+    bool   viewMoved         = false;   // by the user; until then the view follows the data
+
+    juce::Image contentCache;
+    float       contentScale = 0.0f;    // physical pixels per logical pixel; 0 = re-render
+
+    int                             hoveredBlob      = -1;   // into blobs
+    const juce::ARAPlaybackRegion*  selectedRegion   = nullptr;
+    int                             selectedNote     = -1;
+
+    bool   panning        = false;
+    double dragViewStart  = 0.0;
+    float  dragTopMidi    = 0.0f;
+    float  dragSemitones  = 0.0f;    // how far the selected blob is being dragged
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteEditor)
+};
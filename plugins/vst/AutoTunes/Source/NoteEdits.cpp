@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+    NoteEdits.cpp  –  NoteEdits implementation
+  ==============================================================================
+*/
+
+#include "NoteEdits.h"
+#include <cmath>
+#include <cstring>
+
+struct NoteEdits::Node
+{
+    NoteEdit     edit;
+    juce::uint32 priority;
+    NodePtr      left, right;
+    size_t       size;
+};
+
+//==============================================================================
+juce::uint32 NoteEdits::priorityOf (double start) noexcept
+{
+    // splitmix64 of the key's bits: any fixed, well-mixed function will do
+    juce::uint64 bits;
+    std::memcpy (&bits, &start, sizeof (bits));
+
+    bits += 0x9e3779b97f4a7c15ull;
+    bits  = (bits ^ (bits >> 30)) * 0xbf58476d1ce4e5b9ull;
+    bits  = (bits ^ (bits >> 27)) * 0x94d049bb133111ebull;
+    return (juce::uint32) ((bits ^ (bits >> 31)) >> 32);
+}
+
+bool NoteEdits::isAbove (const Node& a, const Node& b) noexcept
+{
+    // Ties broken by key, so the order is total and the shape unique
+    return a.priority != b.priority ? a.priority > b.priority : a.edit.start < b.edit.start;
+}
+
+NoteEdits::NodePtr NoteEdits::makeNode (const NoteEdit& edit, juce::uint32 priority, NodePtr left, NodePtr right)
+{
+    const auto size = 1 + (left != nullptr ? left->size : 0) + (right != nullptr ? right->size : 0);
+    return std::make_shared<const Node> (Node { edit, priority, std::move (left), std::move (right), size });
+}
+
+std::pair<NoteEdits::NodePtr, NoteEdits::NodePtr> NoteEdits::split (const NodePtr& node, double start)
+{
+    if (node == nullptr)
+        return {};
+
+    jassert (node->edit.start != start);
+
+    if (node->edit.start < start)
+    {
+        auto [below, above] = split (node->right, start);
+        return { makeNode (node->edit, node->priority, node->left, std::move (below)), std::move (above) };
+    }
+
+    auto [below, above] = split (node->left, start);
+    return { std::move (below), makeNode (node->edit, node->priority, std::move (above), node->right) };
+}
+
+NoteEdits::NodePtr NoteEdits::merge (const NodePtr& below, const NodePtr& above)
+{
+    if (below == nullptr) return above;
+    if (above == nullptr) return below;
+
+    if (isAbove (*below, *above))
+        return makeNode (below->edit, below->priority, below->left, merge (below->right, above));
+
+    return makeNode (above->edit, above->priority, merge (below, above->left), above->right);
+}
+
+NoteEdits::NodePtr NoteEdits::insert (const NodePtr& node, const NodePtr& item)
+{
+    if (node == nullptr)
+        return item;
+
+    const auto start = item->edit.start;
+
+    // Same note: same place in the tree, only the edit changes
+    if (node->edit.start == start)
+        return makeNode (item->edit, node->priority, node->left, node->right);
+
+    if (isAbove (*item, *node))
+    {
+        auto [below, above] = split (node, start);
+        return makeNode (item->edit, item->priority, std::move (below), std::move (above));
+    }
+
+    if (start < node->edit.start)
+        return makeNode (node->edit, node->priority, insert (node->left, item), node->right);
+
+    return makeNode (node->edit, node->priority, node->left, insert (node->right, item));
+}
+
+NoteEdits::NodePtr NoteEdits::erase (const NodePtr& node, double start)
+{
+    if (node == nullptr)
+        return nullptr;
+
+    if (node->edit.start == start)
+        return merge (node->left, node->right);
+
+    if (start < node->edit.start)
+    {
+        auto left = erase (node->left, start);
+        return left == node->left ? node : makeNode (node->edit, node->priority, std::move (left), node->right);
+    }
+
+    auto right = erase (node->right, start);
+    return right == node->right ? node : makeNode (node->edit, node->priority, node->left, std::move (right));
+}
+
+//==============================================================================
+size_t NoteEdits::size() const noexcept
+{
+    return root != nullptr ? root->size : 0;
+}
+
+const NoteEdit* NoteEdits::find (double start) const noexcept
+{
+    for (auto* node = root.get(); node != nullptr;)
+    {
+        if (node->edit.start == start)
+            return &node->edit;
+
+        node = start < node->edit.start ? node->left.get() : node->right.get();
+    }
+
+    return nullptr;
+}
+
+NoteEdits NoteEdits::with (const NoteEdit& edit) const
+{
+    return NoteEdits (insert (root, makeNode (edit, priorityOf (edit.start), nullptr, nullptr)));
+}
+
+NoteEdits NoteEdits::without (double start) const
+{
+    return NoteEdits (erase (root, start));
+}
+
+void NoteEdits::forEach (const Node* node, const std::function<void (const NoteEdit&)>& visit)
+{
+    // The tree is only O(log n) deep, so recursion is fine
+    if (node == nullptr)
+        return;
+
+    forEach (node->left.get(), visit);
+    visit (node->edit);
+    forEach (node->right.get(), visit);
+}
+
+std::vector<NoteEdit> NoteEdits::getAll() const
+{
+    std::vector<NoteEdit> all;
+    all.reserve (size());
+    forEach (root.get(), [&all] (const NoteEdit& edit) { all.push_back (edit); });
+    return all;
+}
+
+//==============================================================================
+void NoteEdits::diff (const NoteEdits& a, const NoteEdits& b, const std::function<void (double, double)>& changed)
+{
+    diff (a.root, b.root, changed);
+}
+
+void NoteEdits::diff (const NodePtr& a, const NodePtr& b, const std::function<void (double, double)>& changed)
+{
+    if (a == b)
+        return;
+
+    if (a == nullptr || b == nullptr)
+    {
+        forEach ((a != nullptr ? a : b).get(), [&changed] (const NoteEdit& edit) { changed (edit.start, edit.end); });
+        return;
+    }
+
+    if (a->edit.start == b->edit.start)
+    {
+        if (a->edit != b->edit)
+        {
+            changed (a->edit.start, a->edit.end);
+
+            if (b->edit.end != a->edit.end)
+                changed (b->edit.start, b->edit.end);
+        }
+
+        diff (a->left, b->left, changed);
+        diff (a->right, b->right, changed);
+        return;
+    }
+
+    // Shapes follow the keys, so the higher root's note isn't in the other
+    // subtree at all (or it would be that subtree's root): it's an edit one
+    // version has alone, and the other splits around it
+    if (isAbove (*a, *b))
+    {
+        changed (a->edit.start, a->edit.end);
+        const auto [below, above] = split (b, a->edit.start);
+        diff (a->left, below, changed);
+        diff (a->right, above, changed);
+    }
+    else
+    {
+        changed (b->edit.start, b->edit.end);
+        const auto [below, above] = split (a, b->edit.start);
+        diff (below, b->left, changed);
+        diff (above, b->right, changed);
+    }
+}
+
+//==============================================================================
+juce::MemoryBlock NoteEdits::toBinary() const
+{
+    juce::MemoryOutputStream out (size() * 32 + 8);
+
+    out.writeInt (kFormatVersion);
+    out.writeInt ((int) size());
+
+    forEach (root.get(), [&out] (const NoteEdit& edit)
+    {
+        out.writeDouble (edit.start);
+        out.writeDouble (edit.end);
+        out.writeFloat (edit.targetMidi);
+        out.writeFloat (edit.drift);
+        out.writeFloat (edit.vibrato);
+        out.writeFloat (edit.formant);
+    });
+
+    return out.getMemoryBlock();
+}
+
+bool NoteEdits::fromBinary (const void* data, size_t numBytes, NoteEdits& result)
+{
+    juce::MemoryInputStream in (data, numBytes, false);
+
+    if (numBytes < 8 || in.readInt() != kFormatVersion)
+        return false;
+
+    const auto numEdits = in.readInt();
+
+    // Each edit is 32 bytes, so a count the data can't hold is damage
+    if (numEdits < 0 || (size_t) numEdits > (numBytes - 8) / 32)
+        return false;
+
+    NoteEdits edits;
+
+    for (int i = 0; i < numEdits; ++i)
+    {
+        NoteEdit edit {};
+        edit.start      = in.readDouble();
+        edit.end        = in.readDouble();
+        edit.targetMidi = in.readFloat();
+        edit.drift      = in.readFloat();
+        edit.vibrato    = in.readFloat();
+        edit.formant    = in.readFloat();
+
+        if (! (edit.end >= edit.start) || ! std::isfinite (edit.targetMidi))
+            return false;
+
+        edits = edits.with (edit);
+    }
+
+    result = std::move (edits);
+    return true;
+}
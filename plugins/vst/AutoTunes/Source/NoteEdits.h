@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+    NoteEdits.h  –  What the user changed about an audio modification's notes
+
+    One NoteEdit per edited note, keyed by the note's start: where it's
+    moved to and how much of its drift and vibrato it keeps, and how far
+    its formants move.  The render (PsolaPlan) follows an edit instead of
+    the correction inside the note's span.
+
+    A NoteEdits is an immutable treap whose nodes are shared between
+    versions: with() and without() copy only the path down to the edit,
+    O(log n) nodes, and the rest of the new version is the old one.  So
+    keeping every version for undo costs a pointer and the few nodes each
+    edit made, and undo or redo is swapping one version for another.
+
+    Priorities are a hash of the key, which makes a tree's shape depend on
+    its keys alone, however it was edited into being.  diff() uses that to
+    pair the two versions up node for node, and skips every subtree they
+    share without looking inside: the spans it reports are exactly the
+    edits that differ, found in O(changes · log n).
+
+    Immutable, so shared across threads by copying, like the analysis.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct NoteEdit
+{
+    double start;              ///< Source seconds: the note's span, as the NoteIndex had it
+    double end;
+    float  targetMidi;         ///< Where the note is moved to, fractional MIDI
+    float  drift   = 1.0f;     ///< Share of its slow wander around its pitch that's kept: 0 = flat … 1 = as sung
+    float  vibrato = 1.0f;     ///< Share of its vibrato that's kept
+    float  formant = 0.0f;     ///< Formant shift, semitones
+
+    bool operator== (const NoteEdit& other) const noexcept
+    {
+        return start == other.start && end == other.end && targetMidi == other.targetMidi
+            && drift == other.drift && vibrato == other.vibrato && formant == other.formant;
+    }
+
+    bool operator!= (const NoteEdit& other) const noexcept { return ! operator== (other); }
+};
+
+class NoteEdits
+{
+public:
+    /** No edits. */
+    NoteEdits() = default;
+
+    bool   isEmpty() const noexcept { return root == nullptr; }
+    size_t size() const noexcept;
+
+    /** The edit of the note starting at start, or null. */
+    const NoteEdit* find (double start) const noexcept;
+
+    /** A version with edit added, or replacing the one of the same note. */
+    NoteEdits with (const NoteEdit& edit) const;
+
+    /** A version without the edit of the note starting at start. */
+    NoteEdits without (double start) const;
+
+    /** Every edit, by start. */
+    std::vector<NoteEdit> getAll() const;
+
+    /** True if other is this very version (or a copy of it); not a test
+        for equal contents, which diff() gives. */
+    bool isSameVersionAs (const NoteEdits& other) const noexcept { return root == other.root; }
+
+    /** Calls changed (start, end) with the span of every edit that's in
+        one version and not the other, as it is in each. */
+    static void diff (const NoteEdits& a, const NoteEdits& b, const std::function<void (double start, double end)>& changed);
+
+    //==============================================================================
+    /** The archive form, starting with a format version. */
+    juce::MemoryBlock toBinary() const;
+
+    /** False (and result untouched) if the data is damaged or from a newer format. */
+    static bool fromBinary (const void* data, size_t numBytes, NoteEdits& result);
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    explicit NoteEdits (NodePtr rootIn)  : root (std::move (rootIn)) {}
+
+    static juce::uint32 priorityOf (double start) noexcept;
+    static bool         isAbove (const Node& a, const Node& b) noexcept;
+    static NodePtr      makeNode (const NoteEdit& edit, juce::uint32 priority, NodePtr left, NodePtr right);
+
+    /** Keys below start and above it; start itself must not be there. */
+    static std::pair<NodePtr, NodePtr> split (const NodePtr& node, double start);
+    static NodePtr merge (const NodePtr& below, const NodePtr& above);
+    static NodePtr insert (const NodePtr& node, const NodePtr& item);
+    static NodePtr erase (const NodePtr& node, double start);
+
+    static void forEach (const Node* node, const std::function<void (const NoteEdit&)>& visit);
+    static void diff (const NodePtr& a, const NodePtr& b, const std::function<void (double, double)>& changed);
+
+    static constexpr int kFormatVersion = 1;
+
+    NodePtr root;
+};
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+    NoteIndex.cpp  –  NoteIndex implementation
+  ==============================================================================
+*/
+
+#include "NoteIndex.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+NoteIndex::NoteIndex (const PitchAnalysis& analysis)
+{
+    if (analysis.sampleRate <= 0.0 || analysis.hop <= 0)
+        return;
+
+    // A point's pitch belongs to the middle of its window, and stands for a hop
+    const auto secondsPerHop = analysis.hop / analysis.sampleRate;
+    const auto firstCentre   = 0.5 * analysis.analysisSize / analysis.sampleRate;
+
+    // Timestamped in hops, so a note's first and last points come back as
+    // whole numbers and it spans them plus half a hop either side
+    NoteSegmenter segmenter;
+    segmenter.setMinDuration (0.0);
+
+    const auto addNote = [&] (const NoteEvent& note)
+    {
+        const auto start = juce::jmax (0.0, firstCentre + (note.timestamp - 0.5) * secondsPerHop);
+        const auto end   = firstCentre + (note.endTimestamp + 0.5) * secondsPerHop;
+
+        if (end - start >= kMinNoteSeconds)
+            notes.push_back ({ start, end, note.meanMidi });
+    };
+
+    // Each point's distance from equal temperament, as an angle, so that
+    // 0.49 and -0.49 semitones average to half a semitone, not to 0
+    double tuningX = 0.0, tuningY = 0.0;
+    int    numVoiced = 0;
+
+    const auto& points = analysis.points;
+    NoteEvent   note;
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto hz = points[i].pitchHz;
+
+        if (segmenter.addPoint ((double) i, hz, note))
+            addNote (note);
+
+        if (hz <= 0.0f)
+            continue;
+
+        const auto midi  = 69.0 + 12.0 * std::log2 (hz / 440.0);
+        const auto angle = juce::MathConstants<double>::twoPi * (midi - std::round (midi));
+        tuningX += std::cos (angle);
+        tuningY += std::sin (angle);
+        ++numVoiced;
+    }
+
+    if (segmenter.flush (note))
+        addNote (note);
+
+    const auto resultant = std::sqrt (tuningX * tuningX + tuningY * tuningY);
+
+    // Points spread evenly round the circle say nothing about the tuning
+    if (numVoiced >= kMinTuningPoints && resultant >= 0.3 * numVoiced)
+    {
+        const auto offset = std::atan2 (tuningY, tuningX) / juce::MathConstants<double>::twoPi;   // semitones
+        concertPitchHz = 440.0 * std::exp2 (offset / 12.0);
+    }
+}
+
+std::pair<size_t, size_t> NoteIndex::findNotes (double start, double end) const noexcept
+{
+    const auto first = std::upper_bound (notes.begin(), notes.end(), start,
+                                         [] (double position, const Note& n) { return position < n.end; });
+    const auto last  = std::lower_bound (first, notes.end(), end,
+                                         [] (const Note& n, double position) { return n.start < position; });
+
+    return { (size_t) (first - notes.begin()), (size_t) (last - notes.begin()) };
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+    NoteIndex.h  –  The notes and tuning an analysis heard
+
+    Built once from a finished PitchAnalysis: voiced runs of its pitch
+    track, split wherever the pitch settles somewhere else (PFix's
+    NoteSegmenter, whose rules these are), become notes, and the spread of
+    every voiced point around equal temperament gives the concert pitch
+    the take was sung to.
+
+    The notes are sorted and never overlap, so their ends are sorted too
+    and a range query is two binary searches.  Immutable, so shared across
+    threads through std::shared_ptr<const NoteIndex> like the analysis.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchAnalysis.h"
+#include "../../PFix/Source/NoteSegmenter.h"
+#include <cmath>
+#include <utility>
+#include <vector>
+
+class NoteIndex
+{
+public:
+    static constexpr double kMinNoteSeconds  = NoteSegmenter::kMinNoteSeconds;   // including half a hop either end
+    static constexpr int    kMinTuningPoints = 100;
+
+    struct Note
+    {
+        double start;   ///< Source seconds
+        double end;
+        float  midi;    ///< Mean detected pitch, fractional MIDI
+    };
+
+    explicit NoteIndex (const PitchAnalysis& analysis);
+
+    const std::vector<Note>& getNotes() const noexcept { return notes; }
+
+    /** [first, last) into getNotes(): the notes overlapping [start, end)
+        seconds.  O(log n). */
+    std::pair<size_t, size_t> findNotes (double start, double end) const noexcept;
+
+    /** Where the take's A4 sits, in Hz; 440 if too little was voiced, or
+        it wasn't sung to any one tuning. */
+    double getConcertPitchHz() const noexcept { return concertPitchHz; }
+
+    static float midiToHz (float midi) noexcept { return 440.0f * std::exp2 ((midi - 69.0f) / 12.0f); }
+
+private:
+    std::vector<Note> notes;
+    double            concertPitchHz = 440.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteIndex)
+};
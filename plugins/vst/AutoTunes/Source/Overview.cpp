@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+    Overview.cpp  –  WaveformOverview and PitchOverview implementation
+  ==============================================================================
+*/
+
+#include "Overview.h"
+#include <cmath>
+
+//==============================================================================
+WaveformOverview::Bin WaveformOverview::Bin::merge (const Bin& a, double weightA, const Bin& b, double weightB) noexcept
+{
+    const auto meanSquare = ((double) a.rms * a.rms * weightA + (double) b.rms * b.rms * weightB) / (weightA + weightB);
+    return { juce::jmin (a.min, b.min), juce::jmax (a.max, b.max), (juce::uint16) juce::roundToInt (std::sqrt (meanSquare)) };
+}
+
+WaveformOverview::WaveformOverview (juce::int64 numSamplesIn)
+    : numSamples (numSamplesIn)
+{
+    base.reserve ((size_t) ((numSamples + kBaseSamples - 1) / kBaseSamples));
+
+    if (numSamples == 0)
+        pyramid.build ({});
+}
+
+void WaveformOverview::append (const float* const* channels, int numChannels, int numSamplesToAppend)
+{
+    jassert (numAppended + numSamplesToAppend <= numSamples);
+
+    const auto toLevel = [] (float value) { return (juce::int16) juce::roundToInt (32767.0f * juce::jlimit (-1.0f, 1.0f, value)); };
+
+    for (int i = 0; i < numSamplesToAppend;)
+    {
+        // The rest of this bin, or of what's given
+        const auto inBin = (int) juce::jmin ((juce::int64) (numSamplesToAppend - i), kBaseSamples - numAppended % kBaseSamples);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const auto* samples = channels[c] + i;
+            const auto  range   = juce::FloatVectorOperations::findMinAndMax (samples, inBin);
+
+            binMin = binValues == 0 ? range.getStart() : juce::jmin (binMin, range.getStart());
+            binMax = binValues == 0 ? range.getEnd()   : juce::jmax (binMax, range.getEnd());
+
+            for (int s = 0; s < inBin; ++s)
+                binSquares += (double) samples[s] * samples[s];
+
+            binValues += inBin;
+        }
+
+        i += inBin;
+        numAppended += inBin;
+
+        if (numAppended % kBaseSamples == 0 || numAppended == numSamples)
+        {
+            const auto rms = binValues > 0 ? std::sqrt (binSquares / (double) binValues) : 0.0;
+            base.push_back ({ toLevel (binMin), toLevel (binMax), (juce::uint16) juce::roundToInt (65535.0 * juce::jmin (1.0, rms)) });
+            binSquares = 0.0;
+            binValues  = 0;
+        }
+    }
+
+    if (isComplete() && numSamples > 0)
+        pyramid.build (std::move (base));
+}
+
+WaveformOverview::Column WaveformOverview::getColumn (juce::int64 start, juce::int64 end) const noexcept
+{
+    // Every bin it touches, so a column narrower than one still shows it
+    const auto firstBin = start / kBaseSamples;
+    const auto endBin   = juce::jmax (firstBin + 1, (end + kBaseSamples - 1) / kBaseSamples);
+    const auto bin      = pyramid.get (firstBin, endBin);
+
+    return { bin.min / 32767.0f, bin.max / 32767.0f, bin.rms / 65535.0f };
+}
+
+void WaveformOverview::getColumns (double start, double samplesPerColumn, Column* columns, int numColumns) const noexcept
+{
+    for (int i = 0; i < numColumns; ++i)
+        columns[i] = getColumn ((juce::int64) std::floor (start + i * samplesPerColumn),
+                                (juce::int64) std::floor (start + (i + 1) * samplesPerColumn));
+}
+
+//==============================================================================
+PitchOverview::Bin PitchOverview::Bin::merge (const Bin& a, double weightA, const Bin& b, double weightB) noexcept
+{
+    return { juce::jmin (a.low, b.low), juce::jmax (a.high, b.high),
+             (float) ((a.voiced * weightA + b.voiced * weightB) / (weightA + weightB)) };
+}
+
+PitchOverview::PitchOverview (const PitchAnalysis& analysis)
+{
+    if (analysis.sampleRate <= 0.0 || analysis.hop <= 0)
+        return;
+
+    // A point's pitch belongs to the middle of its window, as for NoteIndex
+    pointsPerSecond = analysis.sampleRate / analysis.hop;
+    firstCentre     = 0.5 * analysis.analysisSize / analysis.sampleRate;
+
+    const auto& points = analysis.points;
+    std::vector<Bin> base ((points.size() + kBasePoints - 1) / kBasePoints);
+
+    for (size_t i = 0; i < base.size(); ++i)
+    {
+        const auto first = i * kBasePoints;
+        const auto end   = juce::jmin (points.size(), first + kBasePoints);
+        auto&      bin   = base[i];
+        int        numVoiced = 0;
+
+        for (auto p = first; p < end; ++p)
+        {
+            if (points[p].pitchHz <= 0.0f)
+                continue;
+
+            const auto midi = 69.0f + 12.0f * std::log2 (points[p].pitchHz / 440.0f);
+            bin.low  = juce::jmin (bin.low, midi);
+            bin.high = juce::jmax (bin.high, midi);
+            ++numVoiced;
+        }
+
+        bin.voiced = (float) numVoiced / (float) (end - first);
+    }
+
+    pyramid.build (std::move (base));
+}
+
+double PitchOverview::getBinPosition (double seconds) const noexcept
+{
+    // Base bin b covers the points centred from its first one's hop on
+    return ((seconds - firstCentre) * pointsPerSecond + 0.5) / kBasePoints;
+}
+
+PitchOverview::Column PitchOverview::getColumn (double start, double end) const noexcept
+{
+    const auto firstBin = (juce::int64) std::floor (getBinPosition (start));
+    const auto endBin   = juce::jmax (firstBin + 1, (juce::int64) std::ceil (getBinPosition (end)));
+    const auto bin      = pyramid.get (firstBin, endBin);
+
+    return { bin.low, bin.high, bin.voiced };
+}
+
+void PitchOverview::getColumns (double start, double secondsPerColumn, Column* columns, int numColumns) const noexcept
+{
+    for (int i = 0; i < numColumns; ++i)
+        columns[i] = getColumn (start + i * secondsPerColumn, start + (i + 1) * secondsPerColumn);
+}
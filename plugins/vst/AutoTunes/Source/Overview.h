@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+    Overview.h  –  Waveform and pitch summaries at every zoom level
+
+    A clip view draws one column per pixel, whatever the zoom: the range
+    of the waveform and of the pitch under it.  Both overviews keep a
+    pyramid of summaries for that, each level merging kFactor bins of the
+    one below, so a column is a few bins from a few levels (O(log n), from
+    both ends of its range inward) and a 3-hour session zooms all the way
+    out as fast as all the way in, without touching samples.
+
+    Finer than the base, a view has what the base was made from: the
+    samples, in the source's SampleCache, and the PitchAnalysis points.
+
+    WaveformOverview is built as the analysis hashes the source (every
+    sample passes by once, in order), PitchOverview from the finished
+    analysis.  Both are immutable once built and shared like the analysis.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "PitchAnalysis.h"
+#include <limits>
+#include <vector>
+
+//==============================================================================
+/** The levels of summaries; Bin::merge (a, weightA, b, weightB) combines two
+    bins covering weightA and weightB base bins. */
+template <typename Bin>
+class OverviewPyramid
+{
+public:
+    static constexpr int kFactor = 4;
+
+    /** Builds the levels above base. */
+    void build (std::vector<Bin> base)
+    {
+        levels.clear();
+        levels.push_back (std::move (base));
+
+        while (levels.back().size() > 1)
+        {
+            const auto& below = levels.back();
+            std::vector<Bin> above ((below.size() + kFactor - 1) / kFactor);
+
+            for (size_t i = 0; i < above.size(); ++i)
+            {
+                const auto first = i * kFactor;
+                const auto end   = juce::jmin (below.size(), first + kFactor);
+
+                above[i] = below[first];
+
+                for (auto j = first + 1; j < end; ++j)
+                    above[i] = Bin::merge (above[i], (double) (j - first), below[j], 1.0);
+            }
+
+            levels.push_back (std::move (above));
+        }
+    }
+
+    juce::int64 getNumBins() const noexcept { return levels.empty() ? 0 : (juce::int64) levels[0].size(); }
+
+    /** Base bins [first, end) merged; Bin{} if that's none of them. */
+    Bin get (juce::int64 first, juce::int64 end) const noexcept
+    {
+        first = juce::jmax ((juce::int64) 0, first);
+        end   = juce::jmin (end, getNumBins());
+
+        Bin    result {};
+        double weight = 0.0;
+
+        const auto take = [&] (size_t level, juce::int64 index, double binWeight)
+        {
+            const auto& bin = levels[level][(size_t) index];
+            result  = weight == 0.0 ? bin : Bin::merge (result, weight, bin, binWeight);
+            weight += binWeight;
+        };
+
+        // Whatever doesn't line up with a bin of the level above is taken at
+        // this one; the rest moves up
+        double binWeight = 1.0;
+
+        for (size_t level = 0; first < end; ++level, binWeight *= kFactor)
+        {
+            if (level + 1 == levels.size())
+            {
+                while (first < end)
+                    take (level, first++, binWeight);
+
+                break;
+            }
+
+            while (first < end && first % kFactor != 0)  take (level, first++, binWeight);
+            while (first < end && end % kFactor != 0)    take (level, --end, binWeight);
+
+            first /= kFactor;
+            end   /= kFactor;
+        }
+
+        return result;
+    }
+
+    size_t getSizeInBytes() const noexcept
+    {
+        size_t total = 0;
+
+        for (const auto& level : levels)
+            total += level.size() * sizeof (Bin);
+
+        return total;
+    }
+
+private:
+    std::vector<std::vector<Bin>> levels;   // [0] is the base
+};
+
+//==============================================================================
+class WaveformOverview
+{
+public:
+    static constexpr int kBaseSamples = 256;   // per base bin; ~5 ms at 48 kHz
+
+    /** One column's worth, over every channel; full scale is 1. */
+    struct Column
+    {
+        float min = 0.0f, max = 0.0f, rms = 0.0f;
+    };
+
+    explicit WaveformOverview (juce::int64 numSamples);
+
+    /** Adds the next numSamples of the source, in order, until all of it
+        is in; the pyramid is built with the last.  Builder only. */
+    void append (const float* const* channels, int numChannels, int numSamplesToAppend);
+
+    bool        isComplete() const noexcept    { return numAppended == numSamples; }
+    juce::int64 getNumSamples() const noexcept { return numSamples; }
+
+    /** Samples [start, end). */
+    Column getColumn (juce::int64 start, juce::int64 end) const noexcept;
+
+    /** numColumns columns of samplesPerColumn samples each, from start. */
+    void getColumns (double start, double samplesPerColumn, Column* columns, int numColumns) const noexcept;
+
+    size_t getSizeInBytes() const noexcept { return pyramid.getSizeInBytes(); }
+
+private:
+    struct Bin
+    {
+        juce::int16  min = 0, max = 0;   // of 32767
+        juce::uint16 rms = 0;            // of 65535
+
+        static Bin merge (const Bin& a, double weightA, const Bin& b, double weightB) noexcept;
+    };
+
+    const juce::int64     numSamples;
+    juce::int64           numAppended = 0;
+    std::vector<Bin>      base;          // while building
+    float                 binMin = 0.0f, binMax = 0.0f;
+    double                binSquares = 0.0;
+    juce::int64           binValues  = 0;
+    OverviewPyramid<Bin>  pyramid;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveformOverview)
+};
+
+//==============================================================================
+class PitchOverview
+{
+public:
+    static constexpr int kBasePoints = 4;   // per base bin; ~21 ms at 256 / 48 kHz
+
+    /** One column's worth of the pitch track, fractional MIDI; voiced is
+        the share of it that had a pitch, and low > high when none did. */
+    struct Column
+    {
+        float low   = std::numeric_limits<float>::max();
+        float high  = std::numeric_limits<float>::lowest();
+        float voiced = 0.0f;
+    };
+
+    explicit PitchOverview (const PitchAnalysis& analysis);
+
+    /** Source seconds [start, end). */
+    Column getColumn (double start, double end) const noexcept;
+
+    /** numColumns columns of secondsPerColumn each, from start. */
+    void getColumns (double start, double secondsPerColumn, Column* columns, int numColumns) const noexcept;
+
+    size_t getSizeInBytes() const noexcept { return pyramid.getSizeInBytes(); }
+
+private:
+    struct Bin
+    {
+        float low    = std::numeric_limits<float>::max();
+        float high   = std::numeric_limits<float>::lowest();
+        float voiced = 0.0f;
+
+        static Bin merge (const Bin& a, double weightA, const Bin& b, double weightB) noexcept;
+    };
+
+    /** The base bin time falls in, fractionally. */
+    double getBinPosition (double seconds) const noexcept;
+
+    double               pointsPerSecond = 0.0;
+    double               firstCentre     = 0.0;   // seconds
+    OverviewPyramid<Bin> pyramid;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchOverview)
+};
@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+    PitchAnalysis.cpp  –  PitchAnalysis archive format
+  ==============================================================================
+*/
+
+#include "PitchAnalysis.h"
+#include "SpectralEnvelope.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // ── Layout ───────────────────────────────────────────────────────────────
+    // varint  version
+    // double  sampleRate (little-endian)
+    // varint  numSamples, analysisSize, hop, numPoints
+    // varint  per point: zig-zag (q - previous q), q as below
+    // Version 2 on:
+    // varint  envelopeOrder, envelopeStride, numEnvelopes
+    // varint  per envelope, per coefficient: zig-zag (q - the previous
+    //         envelope's q), q = coefficient / SpectralEnvelope::kQuantum
+
+    constexpr juce::uint64 kFormatVersion = 2;
+
+    juce::uint16 quantiseMidi (float pitchHz) noexcept
+    {
+        if (pitchHz <= 0.0f)
+            return 0;
+
+        const float midi = 69.0f + 12.0f * std::log2 (pitchHz / 440.0f);
+        return (juce::uint16) juce::jlimit (1, 0xffff, juce::roundToInt (midi * 256.0f));
+    }
+
+    float unquantiseHz (juce::uint16 q) noexcept
+    {
+        return q == 0 ? 0.0f : 440.0f * std::exp2 (((float) q / 256.0f - 69.0f) / 12.0f);
+    }
+
+    void writeVarint (juce::MemoryOutputStream& out, juce::uint64 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte ((char) (0x80 | (value & 0x7f)));
+            value >>= 7;
+        }
+
+        out.writeByte ((char) value);
+    }
+
+    void writeZigZag (juce::MemoryOutputStream& out, juce::int64 delta)
+    {
+        writeVarint (out, ((juce::uint64) delta << 1) ^ (juce::uint64) (delta >> 63));
+    }
+
+    /** Reads from a bounded span, latching a failure rather than overrunning. */
+    struct Reader
+    {
+        const juce::uint8* data;
+        size_t             size;
+        size_t             position = 0;
+        bool               failed   = false;
+
+        juce::uint64 readVarint() noexcept
+        {
+            juce::uint64 value = 0;
+
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                if (position >= size)
+                    break;
+
+                const auto byte = data[position++];
+                value |= (juce::uint64) (byte & 0x7f) << shift;
+
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+
+            failed = true;
+            return 0;
+        }
+
+        juce::int64 readZigZag() noexcept
+        {
+            const auto zigzag = readVarint();
+            return (juce::int64) (zigzag >> 1) ^ -(juce::int64) (zigzag & 1);
+        }
+
+        double readDouble() noexcept
+        {
+            if (position > size || size - position < sizeof (double))
+            {
+                failed = true;
+                return 0.0;
+            }
+
+            const auto value = juce::ByteOrder::littleEndianInt64 (data + position);
+            position += sizeof (double);
+            double result;
+            std::memcpy (&result, &value, sizeof (double));
+            return result;
+        }
+    };
+
+    struct Header
+    {
+        juce::uint64 version;
+        double       sampleRate;
+        juce::int64  numSamples;
+        int          analysisSize, hop;
+        juce::int64  numPoints;
+    };
+
+    bool readHeader (Reader& in, Header& header) noexcept
+    {
+        header.version = in.readVarint();
+
+        if (in.failed || header.version > kFormatVersion)
+            return false;
+
+        header.sampleRate   = in.readDouble();
+        header.numSamples   = (juce::int64) in.readVarint();
+        header.analysisSize = (int) in.readVarint();
+        header.hop          = (int) in.readVarint();
+        header.numPoints    = (juce::int64) in.readVarint();
+
+        // Every point takes at least a byte, which bounds a damaged count
+        return ! in.failed && header.sampleRate > 0.0 && header.hop > 0
+                 && header.numPoints >= 0 && (juce::uint64) header.numPoints <= in.size - in.position;
+    }
+}
+
+//==============================================================================
+const float* PitchAnalysis::getEnvelopeAt (double position) const noexcept
+{
+    if (! hasEnvelopes())
+        return nullptr;
+
+    const auto numEnvelopes = (juce::int64) (envelopes.size() / (size_t) envelopeOrder);
+    const auto frame        = (position - analysisSize / 2) / hop;
+    const auto envelope     = juce::jlimit ((juce::int64) 0, numEnvelopes - 1, (juce::int64) std::llround (frame / envelopeStride));
+
+    return envelopes.data() + envelope * envelopeOrder;
+}
+
+//==============================================================================
+juce::MemoryBlock PitchAnalysis::toBinary() const
+{
+    juce::MemoryOutputStream out (points.size() + envelopes.size() + 32);
+
+    writeVarint (out, kFormatVersion);
+    out.writeDouble (sampleRate);
+    writeVarint (out, (juce::uint64) numSamples);
+    writeVarint (out, (juce::uint64) analysisSize);
+    writeVarint (out, (juce::uint64) hop);
+    writeVarint (out, (juce::uint64) points.size());
+
+    int previous = 0;
+
+    for (const auto& point : points)
+    {
+        const int q = quantiseMidi (point.pitchHz);
+        writeZigZag (out, (juce::int64) (q - previous));
+        previous = q;
+    }
+
+    const auto order = hasEnvelopes() ? envelopeOrder : 0;
+    const auto numEnvelopes = order > 0 ? envelopes.size() / (size_t) order : 0;
+
+    writeVarint (out, (juce::uint64) order);
+    writeVarint (out, (juce::uint64) (order > 0 ? envelopeStride : 0));
+    writeVarint (out, (juce::uint64) numEnvelopes);
+
+    std::vector<juce::int64> previousEnvelope ((size_t) order, 0);
+
+    for (size_t e = 0; e < numEnvelopes; ++e)
+    {
+        for (int n = 0; n < order; ++n)
+        {
+            const auto q = (juce::int64) std::llround (envelopes[e * (size_t) order + (size_t) n] / SpectralEnvelope::kQuantum);
+            writeZigZag (out, q - previousEnvelope[(size_t) n]);
+            previousEnvelope[(size_t) n] = q;
+        }
+    }
+
+    return out.getMemoryBlock();
+}
+
+std::shared_ptr<const PitchAnalysis> PitchAnalysis::fromBinary (const void* data, size_t numBytes)
+{
+    Reader in { static_cast<const juce::uint8*> (data), numBytes };
+    Header header;
+
+    if (! readHeader (in, header))
+        return nullptr;
+
+    auto analysis = std::make_shared<PitchAnalysis>();
+    analysis->sampleRate   = header.sampleRate;
+    analysis->numSamples   = header.numSamples;
+    analysis->analysisSize = header.analysisSize;
+    analysis->hop          = header.hop;
+    analysis->points.resize ((size_t) header.numPoints);
+
+    int previous = 0;
+
+    for (juce::int64 i = 0; i < header.numPoints; ++i)
+    {
+        const auto q = (juce::int64) previous + in.readZigZag();
+
+        if (in.failed || q < 0 || q > 0xffff)
+            return nullptr;
+
+        previous = (int) q;
+        analysis->points[(size_t) i] = { unquantiseHz ((juce::uint16) q), 0,
+                                         (double) (i * header.hop + header.analysisSize) / header.sampleRate };
+    }
+
+    if (header.version < 2)
+        return analysis;
+
+    const auto order        = (int) in.readVarint();
+    const auto stride       = (int) in.readVarint();
+    const auto numEnvelopes = in.readVarint();
+
+    // Again at least a byte a coefficient
+    if (in.failed || order < 0 || order > 4096 || stride < 0 || (order > 0) != (stride > 0)
+        || numEnvelopes * (juce::uint64) order > in.size - in.position)
+        return nullptr;
+
+    analysis->envelopeOrder  = order;
+    analysis->envelopeStride = stride;
+    analysis->envelopes.resize ((size_t) (numEnvelopes * (juce::uint64) order));
+
+    std::vector<juce::int64> previousEnvelope ((size_t) order, 0);
+
+    for (size_t i = 0; i < analysis->envelopes.size(); ++i)
+    {
+        auto& q = previousEnvelope[i % (size_t) order];
+        q += in.readZigZag();
+        analysis->envelopes[i] = (float) q * SpectralEnvelope::kQuantum;
+    }
+
+    if (in.failed)
+        return nullptr;
+
+    return analysis;
+}
+
+bool PitchAnalysis::matchesSource (const void* data, size_t numBytes, double sourceSampleRate, juce::int64 sourceNumSamples)
+{
+    Reader in { static_cast<const juce::uint8*> (data), numBytes };
+    Header header;
+
+    return readHeader (in, header)
+             && header.sampleRate == sourceSampleRate
+             && header.numSamples == sourceNumSamples;
+}
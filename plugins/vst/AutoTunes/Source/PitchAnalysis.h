@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+    PitchAnalysis.h  –  An ARA audio source's pitch track
+
+    Produced in the background by AutoTunesDocumentController's analysis
+    jobs, from the mono mix of the source's channels, and immutable once
+    published: readers share it through std::shared_ptr<const PitchAnalysis>.
+
+    Saved in the ARA archive in a compact binary form: pitch quantised to
+    1/256 semitone (MIDI × 256, 0 = unvoiced, as PFix's session index) and
+    stored as zig-zag varint deltas, so a held note costs a byte a point.
+    Timestamps aren't stored; they follow from the hop.
+
+    Alongside the pitch, a spectral envelope every few frames (see
+    SpectralEnvelope), for the render's formant handling.  Each
+    coefficient is stored the same way, as a delta from the envelope
+    before, so a steady vowel costs about a byte a coefficient.  Archives
+    from before envelopes decode with none.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../../PFix/Source/PitchDataQueue.h"
+#include <memory>
+#include <vector>
+
+struct PitchAnalysis
+{
+    double                  sampleRate   { 0.0 };   ///< The audio source's rate
+    juce::int64             numSamples   { 0 };     ///< The audio source's length
+    int                     analysisSize { 0 };     ///< YIN window, in samples
+    int                     hop          { 0 };     ///< Samples between consecutive points
+
+    /** One point per hop, timestamped (in source seconds) at the last
+        sample of its window, as PitchBatchAnalyser writes them. */
+    std::vector<PitchPoint> points;
+
+    int envelopeOrder  { 0 };   ///< Coefficients per envelope; 0 if there are none
+    int envelopeStride { 0 };   ///< Frames from one envelope to the next
+
+    /** envelopeOrder coefficients for frames 0, envelopeStride, 2 *
+        envelopeStride ..., each from that frame's window. */
+    std::vector<float> envelopes;
+
+    bool hasEnvelopes() const noexcept { return envelopeOrder > 0 && envelopeStride > 0 && ! envelopes.empty(); }
+
+    /** The envelope nearest source sample position, or nullptr if there
+        are none. */
+    const float* getEnvelopeAt (double position) const noexcept;
+
+    /** The archive form, starting with a format version. */
+    juce::MemoryBlock toBinary() const;
+
+    /** Null if the data is damaged or from a newer format. */
+    static std::shared_ptr<const PitchAnalysis> fromBinary (const void* data, size_t numBytes);
+
+    /** Reads only the header: whether toBinary() data was made from a
+        source of this rate and length, without decoding the points. */
+    static bool matchesSource (const void* data, size_t numBytes, double sampleRate, juce::int64 numSamples);
+};
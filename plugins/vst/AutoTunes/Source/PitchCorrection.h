@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+    PitchCorrection.h  –  What pitch correction aims for
+
+    Shared by the ARA render (PsolaPlan) and the live, non-ARA path
+    (RealtimeCorrector), so both pull a note onto the same target.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+
+struct PitchCorrection
+{
+    float        amount    { 1.0f };     ///< 0 = untouched … 1 = fully on the target note
+    juce::uint16 scaleMask { 0x0fff };   ///< Bit n set: pitch class n (C = 0) is a target
+
+    bool operator== (const PitchCorrection& other) const noexcept { return amount == other.amount && scaleMask == other.scaleMask; }
+    bool operator!= (const PitchCorrection& other) const noexcept { return ! operator== (other); }
+
+    static float hzToMidi (float hz) noexcept { return 69.0f + 12.0f * std::log2 (hz / 440.0f); }
+
+    /** The closest note the scale allows, in MIDI numbers. */
+    float getTarget (float midi) const noexcept
+    {
+        if ((scaleMask & 0x0fff) == 0)
+            return midi;
+
+        const auto nearest = std::round (midi);
+
+        for (int distance = 0; distance <= 6; ++distance)
+        {
+            for (const auto candidate : { nearest - (float) distance, nearest + (float) distance })
+            {
+                const auto pitchClass = ((int) candidate % 12 + 12) % 12;
+
+                if ((scaleMask & (1 << pitchClass)) != 0)
+                    return candidate;
+            }
+        }
+
+        return midi;
+    }
+
+    /** How far to move a voiced pitch of hz, in semitones. */
+    float getShiftSemitones (float hz) const noexcept
+    {
+        const auto midi = hzToMidi (hz);
+        return (getTarget (midi) - midi) * amount;
+    }
+};
@@ -10,30 +10,1324 @@
 
 #include "PluginARADocumentController.h"
 #include "PluginARAPlaybackRenderer.h"
+#include "SampleRateConverter.h"
+#include <algorithm>
+#include <optional>
+#include <utility>
 
 //==============================================================================
+/** Renders one audio modification's corrected audio into its cache, a
+    chunk at a time, nearest the playhead first, until none is dirty.  A
+    dirty chunk whose input samples and grains hash as they did the last
+    time is only marked clean, so an edit re-renders just what it changed. */
+class AutoTunesDocumentController::RenderJob  : public juce::ThreadPoolJob
+{
+public:
+    /** Message thread: the reader is created here, where the model is
+        safe to touch, and used only by the worker afterwards. */
+    RenderJob (juce::ARAAudioModification& modification, std::shared_ptr<RenderCache> cacheIn,
+               std::shared_ptr<const PsolaPlan> planIn, std::shared_ptr<const SampleCache> samplesIn, double sampleRateIn)
+        : ThreadPoolJob ("AutoTunes render"),
+          cache (std::move (cacheIn)),
+          plan (std::move (planIn)),
+          samples (samplesIn != nullptr && samplesIn->getSampleRate() == sampleRateIn ? std::move (samplesIn) : nullptr),
+          sampleRate (sampleRateIn),
+          reader (modification.getAudioSource())
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (! reader.isValid() || plan->getNumSamples() != cache->getNumSamples())
+            return jobHasFinished;
+
+        const auto numChannels = cache->getNumChannels();
+
+        juce::AudioBuffer<float> input;
+        juce::AudioBuffer<float> output (numChannels, RenderCache::kChunkSize);
+        std::vector<float>       weights ((size_t) RenderCache::kChunkSize);
+
+        for (auto chunk = cache->findChunkToRender(); chunk >= 0; chunk = cache->findChunkToRender())
+        {
+            if (shouldExit())
+                return jobHasFinished;
+
+            const auto token      = cache->beginRender (chunk);
+            const auto range      = cache->getChunkRange (chunk);
+            const auto numOutput  = (int) range.getLength();
+            const auto inputRange = plan->getInputRange (range.getStart(), numOutput);
+            const auto numInput   = (int) inputRange.getLength();
+
+            input.setSize (numChannels, numInput, false, false, true);
+            auto* const* inputChannels = input.getArrayOfWritePointers();
+
+            // Sample access went away part-way; it's restarted when it's back.
+            // Converted samples have only the cache, restarted once it's filled
+            if ((samples == nullptr || ! samples->read (inputChannels, numChannels, inputRange.getStart(), numInput))
+                && (sampleRate != reader.sampleRate || ! reader.read (inputChannels, numChannels, inputRange.getStart(), numInput)))
+                return jobHasFinished;
+
+            AnalysisCache::ContentHasher hasher (sampleRate, numChannels, numInput);
+            hasher.add (input.getArrayOfReadPointers(), numChannels, numInput);
+            const auto key = hasher.getHash() ^ plan->getGrainHash (range.getStart(), numOutput);
+
+            if (key != 0 && key == cache->getRenderedKey (chunk))
+            {
+                cache->markClean (chunk, token);
+                continue;
+            }
+
+            plan->render (input, inputRange.getStart(), output, range.getStart(), numOutput, weights);
+
+            // Out of storage: the rest plays uncorrected
+            if (! cache->write (chunk, output, key, token))
+                return jobHasFinished;
+        }
+
+        return jobHasFinished;
+    }
+
+private:
+    const std::shared_ptr<RenderCache>      cache;
+    const std::shared_ptr<const PsolaPlan>  plan;
+    const std::shared_ptr<const SampleCache> samples;   // read first, when there is one
+    const double                            sampleRate;   // the source's working rate
+    juce::ARAAudioSourceReader              reader;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+//==============================================================================
+/** The notes a host asked for, copied out when the reader is made, so
+    reading them takes no lock. */
+class AutoTunesDocumentController::NoteReader  : public ARA::PlugIn::ContentReader
+{
+public:
+    explicit NoteReader (std::vector<ARA::ARAContentNote> notesIn)  : notes (std::move (notesIn)) {}
+
+    ARA::ARAInt32 getEventCount() noexcept override                            { return (ARA::ARAInt32) notes.size(); }
+    const void* getDataForEvent (ARA::ARAInt32 eventIndex) noexcept override   { return &notes[(size_t) eventIndex]; }
+
+private:
+    const std::vector<ARA::ARAContentNote> notes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoteReader)
+};
+
+/** One static tuning for the whole source: equal temperament at the
+    concert pitch the take was sung to. */
+class AutoTunesDocumentController::TuningReader  : public ARA::PlugIn::ContentReader
+{
+public:
+    explicit TuningReader (double concertPitchHz)
+    {
+        tuning.concertPitchFrequency = (float) concertPitchHz;
+        tuning.root                  = 0;
+        tuning.name                  = nullptr;
+        std::fill (std::begin (tuning.tunings), std::end (tuning.tunings), 0.0f);
+    }
+
+    ARA::ARAInt32 getEventCount() noexcept override                { return 1; }
+    const void* getDataForEvent (ARA::ARAInt32) noexcept override  { return &tuning; }
+
+private:
+    ARA::ARAContentTuning tuning {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TuningReader)
+};
+
+//==============================================================================
+AutoTunesDocumentController::~AutoTunesDocumentController()
+{
+    cancelPendingUpdate();
+    pool.removeAllJobs (true, kCancelTimeoutMs);
+}
+
+std::shared_ptr<const PitchAnalysis> AutoTunesDocumentController::getAnalysis (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (analysesLock);
+    const auto it = analyses.find (audioSource);
+
+    if (it == analyses.end())
+        return nullptr;
+
+    auto& stored = it->second;
+
+    if (stored.decoded == nullptr)
+    {
+        stored.decoded = PitchAnalysis::fromBinary (stored.encoded.getData(), stored.encoded.getSize());
+
+        // The header was checked on restore, so only damaged points get here;
+        // the source is analysed again once its samples next change
+        if (stored.decoded == nullptr)
+        {
+            jassertfalse;
+            analyses.erase (it);
+            return nullptr;
+        }
+    }
+
+    return stored.decoded;
+}
+
+std::shared_ptr<const NoteIndex> AutoTunesDocumentController::getNoteIndex (const juce::ARAAudioSource* audioSource) const
+{
+    // Re-entrant, so getAnalysis() can decode under it
+    const juce::ScopedLock sl (analysesLock);
+
+    if (const auto analysis = getAnalysis (audioSource))
+    {
+        auto& stored = analyses.find (audioSource)->second;
+
+        if (stored.notes == nullptr)
+            stored.notes = std::make_shared<const NoteIndex> (*analysis);
+
+        return stored.notes;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<const SampleCache> AutoTunesDocumentController::getSampleCache (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (analysesLock);
+    const auto it = sampleCaches.find (audioSource);
+    return it != sampleCaches.end() ? it->second : nullptr;
+}
+
+void AutoTunesDocumentController::setSampleCacheEnabled (bool shouldBeEnabled)
+{
+    sampleCacheEnabled = shouldBeEnabled;
+
+    if (! shouldBeEnabled)
+    {
+        const juce::ScopedLock sl (analysesLock);
+        sampleCaches.clear();
+    }
+
+    updateWorkingRates();
+}
+
+void AutoTunesDocumentController::setPlaybackSampleRate (double newSampleRate)
+{
+    if (newSampleRate == playbackSampleRate.load())
+        return;
+
+    playbackSampleRate.store (newSampleRate);
+    updateWorkingRates();
+}
+
+double AutoTunesDocumentController::getWorkingSampleRate (const juce::ARAAudioSource* audioSource) const
+{
+    {
+        const juce::ScopedLock sl (analysesLock);
+        const auto it = workingRates.find (audioSource);
+
+        if (it != workingRates.end())
+            return it->second;
+    }
+
+    // Not analysed yet: what it will be
+    return getWantedSampleRate (audioSource);
+}
+
+juce::int64 AutoTunesDocumentController::getWorkingSampleCount (const juce::ARAAudioSource* audioSource) const
+{
+    return SampleRateConverter::getNumOutputSamples (audioSource->getSampleCount(), audioSource->getSampleRate(),
+                                                     getWorkingSampleRate (audioSource));
+}
+
+juce::Range<juce::int64> AutoTunesDocumentController::getModificationSampleRange (const juce::ARAPlaybackRegion& playbackRegion) const
+{
+    const auto* audioSource = playbackRegion.getAudioModification()->getAudioSource();
+    const auto  sampleRate  = getWorkingSampleRate (audioSource);
+
+    if (sampleRate == audioSource->getSampleRate())
+        return { playbackRegion.getStartInAudioModificationSamples(), playbackRegion.getEndInAudioModificationSamples() };
+
+    return { (juce::int64) std::llround (playbackRegion.getStartInAudioModificationTime() * sampleRate),
+             (juce::int64) std::llround (playbackRegion.getEndInAudioModificationTime() * sampleRate) };
+}
+
+std::shared_ptr<const PitchOverview> AutoTunesDocumentController::getPitchOverview (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (analysesLock);
+
+    if (const auto analysis = getAnalysis (audioSource))
+    {
+        auto& stored = analyses.find (audioSource)->second;
+
+        if (stored.pitchOverview == nullptr)
+            stored.pitchOverview = std::make_shared<const PitchOverview> (*analysis);
+
+        return stored.pitchOverview;
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<const WaveformOverview> AutoTunesDocumentController::getWaveformOverview (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (analysesLock);
+    const auto it = analyses.find (audioSource);
+    return it != analyses.end() ? it->second.waveform : nullptr;
+}
+
+bool AutoTunesDocumentController::hasAnalysis (const juce::ARAAudioSource* audioSource) const
+{
+    const juce::ScopedLock sl (analysesLock);
+    return analyses.find (audioSource) != analyses.end();
+}
+
+std::shared_ptr<RenderCache> AutoTunesDocumentController::getRenderCache (const juce::ARAAudioModification* audioModification)
+{
+    const juce::ScopedLock sl (renderCachesLock);
+    auto& cache = renderCaches[audioModification];
+
+    if (cache == nullptr)
+    {
+        const auto* audioSource = audioModification->getAudioSource();
+        cache = std::make_shared<RenderCache> (audioSource->getChannelCount(), getWorkingSampleCount (audioSource));
+    }
+
+    return cache;
+}
+
+std::shared_ptr<const PsolaPlan> AutoTunesDocumentController::getRenderPlan (const juce::ARAAudioModification* audioModification)
+{
+    const juce::ScopedLock sl (renderCachesLock);
+    auto analysis = getAnalysis (audioModification->getAudioSource());
+
+    if (analysis == nullptr)
+        return nullptr;
+
+    // A plan made from an analysis or edits that have since been replaced is stale
+    const auto editsIt = editHistories.find (audioModification);
+    const auto edits   = editsIt != editHistories.end() ? editsIt->second.current : NoteEdits();
+    auto& stored = renderPlans[audioModification];
+
+    if (stored.plan == nullptr || stored.analysis != analysis || ! stored.edits.isSameVersionAs (edits))
+        stored = { analysis, edits, std::make_shared<const PsolaPlan> (*analysis, correction, edits) };
+
+    return stored.plan;
+}
+
+PsolaPlan::Stretch AutoTunesDocumentController::getStretch (const juce::ARAPlaybackRegion& playbackRegion) const
+{
+    if (! playbackRegion.isTimestretchEnabled())
+        return {};
+
+    // In working samples at both ends; a sample either way is only rounding
+    const auto sampleRate = getWorkingSampleRate (playbackRegion.getAudioModification()->getAudioSource());
+    const auto range      = getModificationSampleRange (playbackRegion);
+    const auto start      = range.getStart();
+    const auto numSource  = range.getLength();
+    const auto numOutput  = (juce::int64) std::llround (playbackRegion.getDurationInPlaybackTime() * sampleRate);
+
+    if (numSource <= 0 || numOutput <= 0 || std::abs (numOutput - numSource) <= 1)
+        return {};
+
+    return { start, numOutput, (double) numSource / (double) numOutput };
+}
+
+AutoTunesDocumentController::StretchedRender& AutoTunesDocumentController::getStretchedRender (const juce::ARAPlaybackRegion* playbackRegion,
+                                                                                              const PsolaPlan::Stretch& stretch)
+{
+    auto& stored = stretchedRenders[playbackRegion];
+
+    if (stored.stretch != stretch)
+        stored = { stretch, nullptr, {} };
+
+    return stored;
+}
+
+std::shared_ptr<RenderCache> AutoTunesDocumentController::getStretchedRenderCache (const juce::ARAPlaybackRegion* playbackRegion)
+{
+    const auto stretch = getStretch (*playbackRegion);
+
+    if (! stretch.isStretched())
+        return nullptr;
+
+    const juce::ScopedLock sl (renderCachesLock);
+    auto& cache = getStretchedRender (playbackRegion, stretch).cache;
+
+    if (cache == nullptr)
+        cache = std::make_shared<RenderCache> (playbackRegion->getAudioModification()->getAudioSource()->getChannelCount(),
+                                               stretch.numOutputSamples);
+
+    return cache;
+}
+
+std::shared_ptr<const PsolaPlan> AutoTunesDocumentController::getRenderPlan (const juce::ARAPlaybackRegion* playbackRegion)
+{
+    const auto* audioModification = playbackRegion->getAudioModification();
+    const auto  stretch           = getStretch (*playbackRegion);
+
+    if (! stretch.isStretched())
+        return getRenderPlan (audioModification);
+
+    const juce::ScopedLock sl (renderCachesLock);
+    auto analysis = getAnalysis (audioModification->getAudioSource());
+
+    if (analysis == nullptr)
+        return nullptr;
+
+    const auto editsIt = editHistories.find (audioModification);
+    const auto edits   = editsIt != editHistories.end() ? editsIt->second.current : NoteEdits();
+    auto& stored = getStretchedRender (playbackRegion, stretch).plan;
+
+    if (stored.plan == nullptr || stored.analysis != analysis || ! stored.edits.isSameVersionAs (edits))
+        stored = { analysis, edits, std::make_shared<const PsolaPlan> (*analysis, correction, edits, stretch) };
+
+    return stored.plan;
+}
+
+void AutoTunesDocumentController::setCorrection (const PitchCorrection& newCorrection)
+{
+    if (newCorrection == getCorrection())
+        return;
+
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        correction = newCorrection;
+    }
+
+    for (auto* audioSource : getDocumentController()->getDocument()->getAudioSources<juce::ARAAudioSource>())
+    {
+        discardRenders (audioSource, false);
+        queueRenders (audioSource);
+    }
+}
+
+void AutoTunesDocumentController::setPlayheadPosition (double songSeconds) noexcept
+{
+    scheduler.setPlayhead (songSeconds);
+}
+
+void AutoTunesDocumentController::setEditFocus (const juce::ARAAudioSource* audioSource, double sourceSeconds)
+{
+    scheduler.setEditFocus (audioSource, sourceSeconds);
+}
+
+void AutoTunesDocumentController::invalidateRender (juce::ARAAudioModification* audioModification, juce::Range<juce::int64> samples)
+{
+    getRenderCache (audioModification)->invalidate (samples);
+    startRender (audioModification);
+}
+
+//==============================================================================
+NoteEdits AutoTunesDocumentController::getNoteEdits (const juce::ARAAudioModification* audioModification) const
+{
+    const juce::ScopedLock sl (renderCachesLock);
+    const auto it = editHistories.find (audioModification);
+    return it != editHistories.end() ? it->second.current : NoteEdits();
+}
+
+void AutoTunesDocumentController::setNoteEdits (juce::ARAAudioModification* audioModification, NoteEdits newEdits)
+{
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        auto& history = editHistories[audioModification];
+
+        if (newEdits.isSameVersionAs (history.current))
+            return;
+
+        history.undo.push_back (history.current);
+        history.redo.clear();
+
+        if (history.undo.size() > kMaxUndoSteps)
+            history.undo.erase (history.undo.begin());
+    }
+
+    replaceNoteEdits (audioModification, std::move (newEdits));
+}
+
+bool AutoTunesDocumentController::undoNoteEdits (juce::ARAAudioModification* audioModification)
+{
+    NoteEdits previous;
+
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        const auto it = editHistories.find (audioModification);
+
+        if (it == editHistories.end() || it->second.undo.empty())
+            return false;
+
+        auto& history = it->second;
+        previous = std::move (history.undo.back());
+        history.undo.pop_back();
+        history.redo.push_back (history.current);
+    }
+
+    replaceNoteEdits (audioModification, std::move (previous));
+    return true;
+}
+
+bool AutoTunesDocumentController::redoNoteEdits (juce::ARAAudioModification* audioModification)
+{
+    NoteEdits next;
+
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        const auto it = editHistories.find (audioModification);
+
+        if (it == editHistories.end() || it->second.redo.empty())
+            return false;
+
+        auto& history = it->second;
+        next = std::move (history.redo.back());
+        history.redo.pop_back();
+        history.undo.push_back (history.current);
+    }
+
+    replaceNoteEdits (audioModification, std::move (next));
+    return true;
+}
+
+void AutoTunesDocumentController::replaceNoteEdits (juce::ARAAudioModification* audioModification, NoteEdits next, bool notifyHost)
+{
+    NoteEdits before;
+
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        before = std::exchange (editHistories[audioModification].current, next);
+    }
+
+    // Only the notes that differ; shared subtrees aren't even looked at
+    std::vector<juce::Range<double>> changed;
+    NoteEdits::diff (before, next, [&changed] (double start, double end) { changed.push_back ({ start, end }); });
+
+    if (changed.empty())
+        return;
+
+    // Tells the host the modification changed (for its undo and dirty
+    // state) without any scope of ours, which would re-render all of it
+    if (notifyHost)
+        audioModification->notifyContentChanged (juce::ARAContentUpdateScopes::nothingIsAffected(), true);
+
+    // Remade with the new edits, and it knows how far each change reaches;
+    // null until the source is analysed, when it renders with them anyway
+    const auto plan = getRenderPlan (audioModification);
+
+    if (plan == nullptr)
+        return;
+
+    const auto sampleRate = getWorkingSampleRate (audioModification->getAudioSource());
+    auto       cache      = getRenderCache (audioModification);
+
+    for (const auto& span : changed)
+        cache->invalidate (plan->getAffectedRange ({ (juce::int64) std::floor (span.getStart() * sampleRate),
+                                                     (juce::int64) std::ceil (span.getEnd() * sampleRate) }));
+
+    // The stretched regions' plans map the same source spans into region time
+    for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+    {
+        const auto regionCache = getStretchedRenderCache (playbackRegion);
+        const auto regionPlan  = getRenderPlan (playbackRegion);
+
+        if (regionCache == nullptr || regionPlan == nullptr)
+            continue;
+
+        for (const auto& span : changed)
+            regionCache->invalidate (regionPlan->getAffectedRange ({ (juce::int64) std::floor (span.getStart() * sampleRate),
+                                                                     (juce::int64) std::ceil (span.getEnd() * sampleRate) }));
+    }
+
+    startRender (audioModification);
+}
+
+//==============================================================================
+juce::ARAAudioSource* AutoTunesDocumentController::doCreateAudioSource (juce::ARADocument* document, ARA::ARAAudioSourceHostRef hostRef) noexcept
+{
+    // Sample access is only granted later; didEnableAudioSourceSamplesAccess()
+    // starts the analysis
+    auto* audioSource = new juce::ARAAudioSource (document, hostRef);
+    audioSource->addListener (this);
+    return audioSource;
+}
+
+juce::ARAAudioModification* AutoTunesDocumentController::doCreateAudioModification (juce::ARAAudioSource* audioSource,
+                                                                                   ARA::ARAAudioModificationHostRef hostRef,
+                                                                                   const juce::ARAAudioModification* optionalModificationToClone) noexcept
+{
+    auto* audioModification = new juce::ARAAudioModification (audioSource, hostRef, optionalModificationToClone);
+    audioModification->addListener (this);
+
+    // A clone starts out with the same edits, every node shared
+    if (optionalModificationToClone != nullptr)
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+        const auto it = editHistories.find (optionalModificationToClone);
+
+        if (it != editHistories.end())
+            editHistories[audioModification].current = it->second.current;
+    }
+
+    // Rendered once the modification is in its source's list
+    if (hasAnalysis (audioSource))
+        queueRenders (audioSource);
+
+    return audioModification;
+}
+
+juce::ARAPlaybackRegion* AutoTunesDocumentController::doCreatePlaybackRegion (juce::ARAAudioModification* modification,
+                                                                             ARA::ARAPlaybackRegionHostRef hostRef) noexcept
+{
+    auto* playbackRegion = new juce::ARAPlaybackRegion (modification, hostRef);
+    playbackRegion->addListener (this);
+    return playbackRegion;
+}
+
 juce::ARAPlaybackRenderer* AutoTunesDocumentController::doCreatePlaybackRenderer() noexcept
 {
     return new AutoTunesPlaybackRenderer (getDocumentController());
 }
 
 //==============================================================================
+void AutoTunesDocumentController::didUpdateAudioSourceProperties (juce::ARAAudioSource* audioSource)
+{
+    // A new sample rate or channel count invalidates the analysis, and
+    // leaves the render caches the wrong shape
+    discardRenders (audioSource, true);
+    startAnalysis (audioSource);
+}
+
+void AutoTunesDocumentController::doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags)
+{
+    if (scopeFlags.affectSamples())
+        startAnalysis (audioSource);
+}
+
+void AutoTunesDocumentController::willEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable)
+{
+    // The readers go invalid with the access, so stop them first
+    if (! enable)
+    {
+        cancelAnalysis (audioSource);
+
+        for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+            cancelRender (audioModification);
+    }
+}
+
+void AutoTunesDocumentController::didEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable)
+{
+    // Access comes back after every edit of the source; only analyse what
+    // isn't done (or restored) already, and finish any render it cut short
+    if (! enable)
+        return;
+
+    if (hasAnalysis (audioSource))
+    {
+        queueRenders (audioSource);
+        startScan (audioSource);
+    }
+    else
+    {
+        startAnalysis (audioSource);
+    }
+}
+
+void AutoTunesDocumentController::willDestroyAudioSource (juce::ARAAudioSource* audioSource)
+{
+    scheduler.remove (audioSource);
+
+    const juce::ScopedLock sl (analysesLock);
+    analyses.erase (audioSource);
+    sampleCaches.erase (audioSource);
+    workingRates.erase (audioSource);
+}
+
+void AutoTunesDocumentController::didUpdateAudioModificationContent (juce::ARAAudioModification* audioModification, juce::ARAContentUpdateScopes scopeFlags)
+{
+    // No range comes with it; unchanged chunks are found by their keys
+    if (scopeFlags.affectSamples())
+        invalidateRender (audioModification, { 0, getWorkingSampleCount (audioModification->getAudioSource()) });
+}
+
+void AutoTunesDocumentController::didUpdatePlaybackRegionProperties (juce::ARAPlaybackRegion* playbackRegion)
+{
+    // The cache is in modification time, so moving or trimming a region
+    // leaves it valid; but what the region now starts on is needed first.
+    // A stretched region's own cache is remade for a new stretch.
+    getRenderCache (playbackRegion->getAudioModification())->setPlayheadHint (getModificationSampleRange (*playbackRegion).getStart());
+    startStretchedRender (playbackRegion);
+
+    auto* audioSource = playbackRegion->getAudioModification()->getAudioSource();
+    updatePlacements (audioSource, nullptr);
+    setEditFocus (audioSource, playbackRegion->getStartInAudioModificationTime());
+}
+
+void AutoTunesDocumentController::didAddPlaybackRegionToAudioModification (juce::ARAAudioModification* audioModification,
+                                                                          juce::ARAPlaybackRegion* playbackRegion)
+{
+    updatePlacements (audioModification->getAudioSource(), nullptr);
+    startStretchedRender (playbackRegion);
+}
+
+void AutoTunesDocumentController::willRemovePlaybackRegionFromAudioModification (juce::ARAAudioModification* audioModification,
+                                                                                juce::ARAPlaybackRegion* playbackRegion)
+{
+    updatePlacements (audioModification->getAudioSource(), playbackRegion);
+
+    cancelStretchedRender (playbackRegion);
+    stretchJobs.erase (playbackRegion);
+
+    const juce::ScopedLock sl (renderCachesLock);
+    stretchedRenders.erase (playbackRegion);
+}
+
+void AutoTunesDocumentController::willDestroyAudioModification (juce::ARAAudioModification* audioModification)
+{
+    cancelRender (audioModification);
+    renderJobs.erase (audioModification);
+
+    const juce::ScopedLock sl (renderCachesLock);
+    renderCaches.erase (audioModification);
+    renderPlans.erase (audioModification);
+    editHistories.erase (audioModification);
+}
+
+void AutoTunesDocumentController::handleAsyncUpdate()
+{
+    std::vector<const juce::ARAAudioSource*> toRender, toNotify;
+
+    {
+        const juce::ScopedLock sl (pendingRendersLock);
+        toRender.swap (pendingRenders);
+        toNotify.swap (pendingContentChanges);
+    }
+
+    const auto contains = [] (const auto& queued, const juce::ARAAudioSource* audioSource)
+    {
+        return std::find (queued.begin(), queued.end(), audioSource) != queued.end();
+    };
+
+    // A queued source may have gone since; only live ones are touched
+    for (auto* audioSource : getDocumentController()->getDocument()->getAudioSources<juce::ARAAudioSource>())
+    {
+        if (contains (toRender, audioSource))
+            for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+                startRender (audioModification);
+
+        if (contains (toNotify, audioSource))
+            notifyAnalysedContentChanged (audioSource);
+    }
+}
+
+//==============================================================================
+void AutoTunesDocumentController::startAnalysis (juce::ARAAudioSource* audioSource)
+{
+    cancelAnalysis (audioSource);
+
+    // Decoded afresh with the analysis: whatever changed the samples left
+    // the old copy stale.  It settles the working rate, which the renders'
+    // caches have to fit
+    auto samples = makeSampleCache (audioSource);
+    discardRenders (audioSource, false);
+
+    bool hadAnalysis;
+
+    {
+        const juce::ScopedLock sl (analysesLock);
+        hadAnalysis = analyses.erase (audioSource) != 0;
+    }
+
+    if (hadAnalysis)
+        notifyAnalysedContentChanged (audioSource);
+
+    if (audioSource->isSampleAccessEnabled())
+        scheduler.add (*audioSource, std::move (samples));
+}
+
+void AutoTunesDocumentController::startScan (juce::ARAAudioSource* audioSource)
+{
+    if (! audioSource->isSampleAccessEnabled() || scheduler.isAnalysing (audioSource))
+        return;
+
+    {
+        const juce::ScopedLock sl (analysesLock);
+        const auto it = analyses.find (audioSource);
+
+        if (it == analyses.end() || it->second.waveform != nullptr)
+            return;
+    }
+
+    auto samples = makeSampleCache (audioSource);
+
+    // Restored at a rate it can't be worked at now, it's analysed again
+    if (const auto analysis = getAnalysis (audioSource); analysis == nullptr || analysis->sampleRate != getWorkingSampleRate (audioSource))
+    {
+        startAnalysis (audioSource);
+        return;
+    }
+
+    scheduler.add (*audioSource, std::move (samples), false);
+}
+
+std::shared_ptr<SampleCache> AutoTunesDocumentController::makeSampleCache (juce::ARAAudioSource* audioSource)
+{
+    std::shared_ptr<SampleCache> samples;
+
+    if (sampleCacheEnabled && audioSource->isSampleAccessEnabled())
+    {
+        const auto sampleRate = getWantedSampleRate (audioSource);
+        samples = std::make_shared<SampleCache> (audioSource->getChannelCount(),
+                                                 SampleRateConverter::getNumOutputSamples (audioSource->getSampleCount(),
+                                                                                           audioSource->getSampleRate(), sampleRate),
+                                                 sampleRate);
+    }
+
+    // Out of disk: everything reads from the host as before, at the
+    // source's own rate, as there's nowhere to convert to
+    if (samples != nullptr && ! samples->isValid())
+        samples = nullptr;
+
+    const juce::ScopedLock sl (analysesLock);
+    workingRates[audioSource] = samples != nullptr ? samples->getSampleRate() : audioSource->getSampleRate();
+
+    if (samples != nullptr)
+        sampleCaches[audioSource] = samples;
+    else
+        sampleCaches.erase (audioSource);
+
+    return samples;
+}
+
+double AutoTunesDocumentController::getWantedSampleRate (const juce::ARAAudioSource* audioSource) const
+{
+    const auto playbackRate = playbackSampleRate.load();
+    const auto sourceRate   = audioSource->getSampleRate();
+
+    return sampleCacheEnabled && playbackRate > 0.0 && sourceRate > 0.0 ? playbackRate : sourceRate;
+}
+
+void AutoTunesDocumentController::updateWorkingRates()
+{
+    // Its analysis and every render of it are at the old rate
+    for (auto* audioSource : getDocumentController()->getDocument()->getAudioSources<juce::ARAAudioSource>())
+        if (getWorkingSampleRate (audioSource) != getWantedSampleRate (audioSource))
+            startAnalysis (audioSource);
+}
+
+void AutoTunesDocumentController::cancelAnalysis (juce::ARAAudioSource* audioSource)
+{
+    scheduler.cancel (audioSource);
+}
+
+void AutoTunesDocumentController::updatePlacements (juce::ARAAudioSource* audioSource, const juce::ARAPlaybackRegion* leaving)
+{
+    std::vector<AnalysisScheduler::Placement> placements;
+
+    for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+        for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+            if (playbackRegion != leaving)
+                placements.push_back ({ playbackRegion->getStartInAudioModificationTime(),
+                                        playbackRegion->getEndInAudioModificationTime(),
+                                        playbackRegion->getStartInPlaybackTime() - playbackRegion->getStartInAudioModificationTime() });
+
+    scheduler.setPlacements (audioSource, std::move (placements));
+}
+
+void AutoTunesDocumentController::publishAnalysis (const juce::ARAAudioSource* audioSource, std::shared_ptr<const PitchAnalysis> analysis,
+                                                   std::shared_ptr<const WaveformOverview> waveform)
+{
+    // Only scanned, for a restored analysis
+    if (analysis == nullptr)
+    {
+        const juce::ScopedLock sl (analysesLock);
+        const auto it = analyses.find (audioSource);
+
+        if (it != analyses.end())
+            it->second.waveform = std::move (waveform);
+
+        // A converted source's renders could only wait for its samples
+        queueRenders (audioSource);
+        return;
+    }
+
+    // Here on the worker, so no host's content read (or view) has to build them
+    auto notes = std::make_shared<const NoteIndex> (*analysis);
+    auto pitch = std::make_shared<const PitchOverview> (*analysis);
+
+    {
+        const juce::ScopedLock sl (analysesLock);
+        analyses[audioSource] = { std::move (analysis), {}, std::move (notes), std::move (pitch), std::move (waveform) };
+    }
+
+    queueRenders (audioSource);
+    queueContentChanged (audioSource);
+}
+
+//==============================================================================
+void AutoTunesDocumentController::queueRenders (const juce::ARAAudioSource* audioSource)
+{
+    {
+        const juce::ScopedLock sl (pendingRendersLock);
+
+        if (std::find (pendingRenders.begin(), pendingRenders.end(), audioSource) == pendingRenders.end())
+            pendingRenders.push_back (audioSource);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void AutoTunesDocumentController::queueContentChanged (const juce::ARAAudioSource* audioSource)
+{
+    {
+        const juce::ScopedLock sl (pendingRendersLock);
+
+        if (std::find (pendingContentChanges.begin(), pendingContentChanges.end(), audioSource) == pendingContentChanges.end())
+            pendingContentChanges.push_back (audioSource);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void AutoTunesDocumentController::notifyAnalysedContentChanged (juce::ARAAudioSource* audioSource)
+{
+    const auto scopes = juce::ARAContentUpdateScopes::notesAreAffected() + juce::ARAContentUpdateScopes::tuningIsAffected();
+
+    audioSource->notifyContentChanged (scopes, true);
+
+    for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+    {
+        audioModification->notifyContentChanged (scopes, true);
+
+        for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+            playbackRegion->notifyContentChanged (scopes, true);
+    }
+}
+
+void AutoTunesDocumentController::startRender (juce::ARAAudioModification* audioModification)
+{
+    cancelRender (audioModification);
+
+    for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+        startStretchedRender (playbackRegion);
+
+    auto* audioSource = audioModification->getAudioSource();
+    auto  plan        = getRenderPlan (audioModification);
+
+    if (plan == nullptr || ! audioSource->isSampleAccessEnabled())
+    {
+        renderJobs.erase (audioModification);
+        return;
+    }
+
+    auto cache = getRenderCache (audioModification);
+
+    if (cache->isComplete())
+        return;
+
+    auto& job = renderJobs[audioModification];
+    job = std::make_unique<RenderJob> (*audioModification, std::move (cache), std::move (plan),
+                                       getSampleCache (audioSource), getWorkingSampleRate (audioSource));
+    pool.addJob (job.get(), false);
+}
+
+void AutoTunesDocumentController::cancelRender (juce::ARAAudioModification* audioModification)
+{
+    for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+        cancelStretchedRender (playbackRegion);
+
+    const auto it = renderJobs.find (audioModification);
+
+    if (it == renderJobs.end())
+        return;
+
+    [[maybe_unused]] const auto stopped = pool.removeJob (it->second.get(), true, kCancelTimeoutMs);
+    jassert (stopped);
+}
+
+void AutoTunesDocumentController::startStretchedRender (juce::ARAPlaybackRegion* playbackRegion)
+{
+    cancelStretchedRender (playbackRegion);
+
+    auto* audioModification = playbackRegion->getAudioModification();
+    auto* audioSource       = audioModification->getAudioSource();
+
+    if (! getStretch (*playbackRegion).isStretched())
+    {
+        stretchJobs.erase (playbackRegion);
+
+        const juce::ScopedLock sl (renderCachesLock);
+        stretchedRenders.erase (playbackRegion);
+        return;
+    }
+
+    auto plan = getRenderPlan (playbackRegion);
+
+    if (plan == nullptr || ! audioSource->isSampleAccessEnabled())
+    {
+        stretchJobs.erase (playbackRegion);
+        return;
+    }
+
+    auto cache = getStretchedRenderCache (playbackRegion);
+    cache->setPlayheadHint (0);
+
+    if (cache->isComplete())
+        return;
+
+    auto& job = stretchJobs[playbackRegion];
+    job = std::make_unique<RenderJob> (*audioModification, std::move (cache), std::move (plan),
+                                       getSampleCache (audioSource), getWorkingSampleRate (audioSource));
+    pool.addJob (job.get(), false);
+}
+
+void AutoTunesDocumentController::cancelStretchedRender (const juce::ARAPlaybackRegion* playbackRegion)
+{
+    const auto it = stretchJobs.find (playbackRegion);
+
+    if (it == stretchJobs.end())
+        return;
+
+    [[maybe_unused]] const auto stopped = pool.removeJob (it->second.get(), true, kCancelTimeoutMs);
+    jassert (stopped);
+}
+
+void AutoTunesDocumentController::discardRenders (juce::ARAAudioSource* audioSource, bool dropCaches)
+{
+    const auto numSamples = getWorkingSampleCount (audioSource);
+
+    for (auto* audioModification : audioSource->getAudioModifications<juce::ARAAudioModification>())
+    {
+        cancelRender (audioModification);
+        renderJobs.erase (audioModification);
+
+        const juce::ScopedLock sl (renderCachesLock);
+        renderPlans.erase (audioModification);
+
+        for (auto* playbackRegion : audioModification->getPlaybackRegions<juce::ARAPlaybackRegion>())
+        {
+            stretchJobs.erase (playbackRegion);
+
+            const auto stretched = stretchedRenders.find (playbackRegion);
+
+            if (stretched == stretchedRenders.end())
+                continue;
+
+            stretched->second.plan = {};
+
+            if (stretched->second.cache == nullptr)
+                continue;
+
+            if (dropCaches || stretched->second.stretch != getStretch (*playbackRegion))
+            {
+                stretched->second.cache->discard();
+                stretched->second.cache = nullptr;
+            }
+            else
+            {
+                stretched->second.cache->invalidateAll();
+            }
+        }
+
+        const auto it = renderCaches.find (audioModification);
+
+        if (it == renderCaches.end())
+            continue;
+
+        if (dropCaches || it->second->getNumSamples() != numSamples)
+        {
+            // A renderer still holding it then finds nothing to play
+            it->second->discard();
+            renderCaches.erase (it);
+        }
+        else
+        {
+            it->second->invalidateAll();
+        }
+    }
+}
+
+//==============================================================================
+// Archive: int32 version, int64 count, then per analysed audio source its
+// persistent ID, int64 size and that many bytes of PitchAnalysis::toBinary().
+// From version 2 on, another int64 count and per audio modification its
+// persistent ID, int64 size and NoteEdits::toBinary(), empty edits too.
+
 bool AutoTunesDocumentController::doRestoreObjectsFromStream (juce::ARAInputStream& input, const juce::ARARestoreObjectsFilter* filter) noexcept
 {
-    // You should use this method to read any persistent data associated with
-    // your ARA model graph stored in an archive using the supplied ARAInputStream.
-    // Be sure to check the ARARestoreObjectsFilter to determine which objects to restore.
-    return true;
+    auto* archivingController = getDocumentController()->getHostArchivingController();
+    const juce::ScopeGuard reportDone { [archivingController] { archivingController->notifyDocumentUnarchivingProgress (1.0f); } };
+
+    // A newer build's archive: nothing here can be trusted to read, but the
+    // document still works; its sources are simply analysed again
+    const auto version = input.readInt();
+
+    if (version > kArchiveVersion)
+        return ! input.failed();
+
+    const auto numAnalyses = input.readInt64();
+
+    for (juce::int64 i = 0; i < numAnalyses && ! input.failed(); ++i)
+    {
+        const auto persistentID = input.readString();
+        const auto numBytes     = input.readInt64();
+
+        if (input.failed() || numBytes < 0 || numBytes > kMaxArchivedAnalysis)
+            return false;
+
+        juce::MemoryBlock encoded ((size_t) numBytes);
+
+        if (input.read (encoded.getData(), (int) numBytes) != (int) numBytes)
+            return false;
+
+        archivingController->notifyDocumentUnarchivingProgress ((float) (i + 1) / (float) numAnalyses);
+
+        // Only the sources the host asked for, and only if they still hold
+        // the samples the analysis was made from, at the rate they'd be
+        // worked at now; decoding waits for a reader
+        auto* audioSource = filter->getAudioSourceToRestoreStateWithID<juce::ARAAudioSource> (persistentID.toRawUTF8());
+
+        if (audioSource == nullptr)
+            continue;
+
+        const auto sampleRate = getWantedSampleRate (audioSource);
+
+        if (! PitchAnalysis::matchesSource (encoded.getData(), encoded.getSize(), sampleRate,
+                                            SampleRateConverter::getNumOutputSamples (audioSource->getSampleCount(),
+                                                                                      audioSource->getSampleRate(), sampleRate)))
+            continue;
+
+        cancelAnalysis (audioSource);
+
+        {
+            const juce::ScopedLock sl (analysesLock);
+            analyses[audioSource]     = { nullptr, std::move (encoded), nullptr, nullptr, nullptr };
+            workingRates[audioSource] = sampleRate;
+        }
+
+        discardRenders (audioSource, false);
+        queueRenders (audioSource);
+        queueContentChanged (audioSource);
+        startScan (audioSource);
+    }
+
+    if (version < 2)
+        return ! input.failed();
+
+    const auto numEdited = input.readInt64();
+
+    for (juce::int64 i = 0; i < numEdited && ! input.failed(); ++i)
+    {
+        const auto persistentID = input.readString();
+        const auto numBytes     = input.readInt64();
+
+        if (input.failed() || numBytes < 0 || numBytes > kMaxArchivedAnalysis)
+            return false;
+
+        juce::MemoryBlock encoded ((size_t) numBytes);
+
+        if (input.read (encoded.getData(), (int) numBytes) != (int) numBytes)
+            return false;
+
+        auto* audioModification = filter->getAudioModificationToRestoreStateWithID<juce::ARAAudioModification> (persistentID.toRawUTF8());
+        NoteEdits edits;
+
+        if (audioModification == nullptr || ! NoteEdits::fromBinary (encoded.getData(), encoded.getSize(), edits))
+            continue;
+
+        // Usually the host's own undo: its history is the one that counts
+        // now, so ours starts again from here
+        {
+            const juce::ScopedLock sl (renderCachesLock);
+            auto& history = editHistories[audioModification];
+            history.undo.clear();
+            history.redo.clear();
+            history.archived = edits;
+            history.encoded  = std::move (encoded);
+        }
+
+        replaceNoteEdits (audioModification, std::move (edits), false);
+    }
+
+    return ! input.failed();
 }
 
 bool AutoTunesDocumentController::doStoreObjectsToStream (juce::ARAOutputStream& output, const juce::ARAStoreObjectsFilter* filter) noexcept
 {
-    // You should use this method to write any persistent data associated with
-    // your ARA model graph into the an archive using the supplied ARAOutputStream.
-    // Be sure to check the ARAStoreObjectsFilter to determine which objects to store.
+    auto* archivingController = getDocumentController()->getHostArchivingController();
+    const juce::ScopeGuard reportDone { [archivingController] { archivingController->notifyDocumentArchivingProgress (1.0f); } };
+
+    // Encoded copies are kept, so saving again only encodes what's new
+    std::vector<std::pair<juce::String, juce::MemoryBlock>> toStore;
+
+    {
+        const juce::ScopedLock sl (analysesLock);
+
+        for (auto* audioSource : filter->getAudioSourcesToStore<juce::ARAAudioSource>())
+        {
+            const auto it = analyses.find (audioSource);
+
+            if (it == analyses.end())
+                continue;
+
+            auto& stored = it->second;
+
+            if (stored.encoded.isEmpty())
+                stored.encoded = stored.decoded->toBinary();
+
+            toStore.emplace_back (audioSource->getPersistentID(), stored.encoded);
+        }
+    }
+
+    // Likewise the edits: a host snapshots the document after every change,
+    // and only the modifications changed since the last one encode anew
+    std::vector<std::pair<juce::String, juce::MemoryBlock>> editsToStore;
+
+    {
+        const juce::ScopedLock sl (renderCachesLock);
+
+        for (auto* audioModification : filter->getAudioModificationsToStore<juce::ARAAudioModification>())
+        {
+            auto& history = editHistories[audioModification];
+
+            if (history.encoded.isEmpty() || ! history.archived.isSameVersionAs (history.current))
+            {
+                history.encoded  = history.current.toBinary();
+                history.archived = history.current;
+            }
+
+            editsToStore.emplace_back (audioModification->getPersistentID(), history.encoded);
+        }
+    }
+
+    if (! output.writeInt (kArchiveVersion) || ! output.writeInt64 ((juce::int64) toStore.size()))
+        return false;
+
+    for (size_t i = 0; i < toStore.size(); ++i)
+    {
+        const auto& [persistentID, encoded] = toStore[i];
+
+        if (! output.writeString (persistentID)
+            || ! output.writeInt64 ((juce::int64) encoded.getSize())
+            || ! output.write (encoded.getData(), encoded.getSize()))
+            return false;
+
+        archivingController->notifyDocumentArchivingProgress ((float) (i + 1) / (float) toStore.size());
+    }
+
+    if (! output.writeInt64 ((juce::int64) editsToStore.size()))
+        return false;
+
+    for (const auto& [persistentID, encoded] : editsToStore)
+        if (! output.writeString (persistentID)
+            || ! output.writeInt64 ((juce::int64) encoded.getSize())
+            || ! output.write (encoded.getData(), encoded.getSize()))
+            return false;
+
     return true;
 }
 
+//==============================================================================
+// Content reading.  A modification plays its source's time unchanged (there's
+// no time stretching), and a region only the part of it it's cut to.
+
+ARA::PlugIn::ContentReader* AutoTunesDocumentController::createContentReader (const juce::ARAAudioSource* audioSource, ARA::ARAContentType type,
+                                                                              const ARA::ARAContentTimeRange* range,
+                                                                              double sourceToTarget, juce::Range<double> clip) const
+{
+    const auto notes = getNoteIndex (audioSource);
+
+    if (notes == nullptr || ! isAnalysedContent (type))
+        return nullptr;
+
+    if (type == ARA::kARAContentTypeStaticTuning)
+        return new TuningReader (notes->getConcertPitchHz());
+
+    if (range != nullptr)
+        clip = clip.getIntersectionWith ({ range->start - sourceToTarget, range->start + range->duration - sourceToTarget });
+
+    const auto [first, last] = notes->findNotes (clip.getStart(), clip.getEnd());
+    std::vector<ARA::ARAContentNote> events;
+    events.reserve (last - first);
+
+    for (auto i = first; i < last; ++i)
+    {
+        const auto& note = notes->getNotes()[i];
+
+        // A note the region cuts into starts (or stops) where it's cut
+        const auto start = juce::jmax (note.start, clip.getStart());
+        const auto end   = juce::jmin (note.end,   clip.getEnd());
+
+        ARA::ARAContentNote event {};
+        event.frequency      = NoteIndex::midiToHz (note.midi);
+        event.pitchNumber    = (ARA::ARAPitchNumber) std::lround (note.midi);
+        event.volume         = 1.0f;
+        event.startPosition  = start + sourceToTarget;
+        event.attackDuration = 0.0;
+        event.noteDuration   = end - start;
+        event.signalDuration = end - start;
+        events.push_back (event);
+    }
+
+    return new NoteReader (std::move (events));
+}
+
+bool AutoTunesDocumentController::isAudioSourceContentAvailable (const ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type)
+{
+    return isAnalysedContent (type) && hasAnalysis (static_cast<const juce::ARAAudioSource*> (audioSource));
+}
+
+ARA::ARAContentGrade AutoTunesDocumentController::getAudioSourceContentGrade (const ARA::PlugIn::AudioSource*, ARA::ARAContentType)
+{
+    return ARA::kARAContentGradeDetected;
+}
+
+ARA::PlugIn::ContentReader* AutoTunesDocumentController::createAudioSourceContentReader (ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type,
+                                                                                         const ARA::ARAContentTimeRange* range)
+{
+    auto* source = static_cast<const juce::ARAAudioSource*> (audioSource);
+    return createContentReader (source, type, range, 0.0, { 0.0, (double) source->getSampleCount() / source->getSampleRate() });
+}
+
+bool AutoTunesDocumentController::isAudioModificationContentAvailable (const ARA::PlugIn::AudioModification* audioModification, ARA::ARAContentType type)
+{
+    return isAudioSourceContentAvailable (audioModification->getAudioSource(), type);
+}
+
+ARA::ARAContentGrade AutoTunesDocumentController::getAudioModificationContentGrade (const ARA::PlugIn::AudioModification*, ARA::ARAContentType)
+{
+    return ARA::kARAContentGradeDetected;
+}
+
+ARA::PlugIn::ContentReader* AutoTunesDocumentController::createAudioModificationContentReader (ARA::PlugIn::AudioModification* audioModification, ARA::ARAContentType type,
+                                                                                               const ARA::ARAContentTimeRange* range)
+{
+    auto* source = static_cast<juce::ARAAudioModification*> (audioModification)->getAudioSource();
+    return createContentReader (source, type, range, 0.0, { 0.0, (double) source->getSampleCount() / source->getSampleRate() });
+}
+
+bool AutoTunesDocumentController::isPlaybackRegionContentAvailable (const ARA::PlugIn::PlaybackRegion* playbackRegion, ARA::ARAContentType type)
+{
+    return isAudioModificationContentAvailable (playbackRegion->getAudioModification(), type);
+}
+
+ARA::ARAContentGrade AutoTunesDocumentController::getPlaybackRegionContentGrade (const ARA::PlugIn::PlaybackRegion*, ARA::ARAContentType)
+{
+    return ARA::kARAContentGradeDetected;
+}
+
+ARA::PlugIn::ContentReader* AutoTunesDocumentController::createPlaybackRegionContentReader (ARA::PlugIn::PlaybackRegion* playbackRegion, ARA::ARAContentType type,
+                                                                                            const ARA::ARAContentTimeRange* range)
+{
+    auto* region = static_cast<juce::ARAPlaybackRegion*> (playbackRegion);
+
+    return createContentReader (region->getAudioModification()->getAudioSource(), type, range,
+                                region->getStartInPlaybackTime() - region->getStartInAudioModificationTime(),
+                                { region->getStartInAudioModificationTime(), region->getEndInAudioModificationTime() });
+}
+
+bool AutoTunesDocumentController::isAudioSourceContentAnalysisIncomplete (const ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type)
+{
+    // Queued or running; a source that can't be read isn't being analysed
+    auto* source = static_cast<const juce::ARAAudioSource*> (audioSource);
+    return isAnalysedContent (type) && scheduler.isAnalysing (source) && ! hasAnalysis (source);
+}
+
 //==============================================================================
 // This creates the static ARAFactory instances for the plugin.
 const ARA::ARAFactory* JUCE_CALLTYPE createARAFactory()
@@ -11,26 +11,435 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "PitchAnalysis.h"
+#include "AnalysisCache.h"
+#include "AnalysisScheduler.h"
+#include "NoteEdits.h"
+#include "NoteIndex.h"
+#include "Overview.h"
+#include "PsolaPlan.h"
+#include "RenderCache.h"
+#include "SampleCache.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
 
 //==============================================================================
 /**
+    Analyses every audio source's pitch in the background as soon as the
+    host lets us read its samples, so playback never waits on detection.
+
+    An AnalysisScheduler works through the sources a chunk at a time on a
+    ThreadPool, nearest the playhead (or the region last edited) first, and
+    reports their progress to the host.  A source whose samples change, or
+    whose sample access is withdrawn, has its analysis cancelled and (once
+    it can be read again) restarted.
+
+    Finished analyses are kept in the ARA archive (see PitchAnalysis for the
+    format), so a reopened project doesn't analyse its vocals again.  They
+    are restored still encoded and decoded the first time they're asked for.
+    They also go into an AnalysisCache on disk, which is checked before
+    analysing, so a stem imported into another project is ready at once.
+
+    As it's hashed, each source is decoded into a SampleCache, a float32
+    file the OS maps in, so the renders after it don't call into the host.
+    A source at another rate from the playback renderers' (a 44.1 kHz stem
+    in a 48 kHz session) is converted to theirs on the way in, once, and
+    from then on is analysed, corrected, rendered and played at that
+    working rate; see getWorkingSampleRate().
+
+    Once a source is analysed, each of its audio modifications is rendered
+    pitch-corrected (see PsolaPlan) into a RenderCache by a job on the same
+    pool; playback renderers copy from that cache and play the source as it
+    is wherever the render hasn't got to yet.  Changes mark only the chunks
+    they touch dirty, and those play as they were until re-rendered.
+
+    A playback region the host time-stretches (its playback duration not
+    its modification duration) gets a RenderCache of its own, in region
+    time, rendered the same way from a stretched plan, so it too plays by
+    copying.
+
+    Each modification's note edits are a NoteEdits version, kept with the
+    versions before and after it for undo; a new version shares all but a
+    few nodes with the last, so an edit, an undo or a clone of the
+    modification copies nothing, and comparing two versions only looks at
+    the notes that differ, which are all that's re-rendered.  The edits go
+    into the archive with the analyses.
+
+    For views, each analysis comes with overviews of the waveform and the
+    pitch track (see Overview.h), to draw any zoom level in one pass over
+    the pixels.
+
+    Hosts that read ARA content get the notes and tuning each analysis
+    heard, for a source, a modification or a region, from its NoteIndex:
+    built once per analysis, so a read never analyses or touches samples.
 */
-class AutoTunesDocumentController  : public juce::ARADocumentControllerSpecialisation
+class AutoTunesDocumentController  : public juce::ARADocumentControllerSpecialisation,
+                                     private juce::ARAAudioSource::Listener,
+                                     private juce::ARAAudioModification::Listener,
+                                     private juce::ARAPlaybackRegion::Listener,
+                                     private juce::AsyncUpdater
 {
 public:
     //==============================================================================
     using ARADocumentControllerSpecialisation::ARADocumentControllerSpecialisation;
+    ~AutoTunesDocumentController() override;
+
+    /** The finished analysis of audioSource, or nullptr while it is still
+        queued or running (or can't run: no sample access).  One restored
+        from the archive is decoded by the first call.  Any thread but the
+        audio thread; takes a lock. */
+    std::shared_ptr<const PitchAnalysis> getAnalysis (const juce::ARAAudioSource* audioSource) const;
+
+    /** The notes in audioSource's finished analysis, or nullptr as for
+        getAnalysis().  Any thread but the audio thread; takes a lock. */
+    std::shared_ptr<const NoteIndex> getNoteIndex (const juce::ARAAudioSource* audioSource) const;
+
+    /** The pitch track of audioSource's finished analysis at every zoom
+        level, or nullptr as for getAnalysis().  Any thread but the audio
+        thread; takes a lock. */
+    std::shared_ptr<const PitchOverview> getPitchOverview (const juce::ARAAudioSource* audioSource) const;
+
+    /** audioSource's waveform at every zoom level, made as its analysis
+        read it; nullptr until then.  A restored analysis's source is read
+        through once more for it.  Any thread but the audio thread; takes a
+        lock. */
+    std::shared_ptr<const WaveformOverview> getWaveformOverview (const juce::ARAAudioSource* audioSource) const;
+
+    /** audioSource's samples as decoded by its analysis, at its working
+        rate, read by the renders instead of the host, or nullptr if the
+        cache is off (or the disk wouldn't take it).  Complete once the
+        analysis is past hashing.  Any thread but the audio thread; takes a
+        lock. */
+    std::shared_ptr<const SampleCache> getSampleCache (const juce::ARAAudioSource* audioSource) const;
+
+    /** Whether analyses decode their sources into a SampleCache; on by
+        default.  Sources analysed before it's turned on read from the host
+        until they're next analysed.  Nothing can be converted without it,
+        so the sources whose working rate that changes are analysed again
+        at once.  Message thread. */
+    void setSampleCacheEnabled (bool shouldBeEnabled);
+
+    /** The rate the playback renderers run at, which sources at any other
+        rate are converted to; renderers set it in prepareToPlay().  A new
+        rate analyses those sources again.  Message thread. */
+    void setPlaybackSampleRate (double newSampleRate);
+
+    /** The rate audioSource is analysed, corrected and rendered at, and
+        every cache of it holds: the playback rate if it's converted to
+        that, otherwise its own.  Any thread but the audio thread; takes a
+        lock. */
+    double getWorkingSampleRate (const juce::ARAAudioSource* audioSource) const;
+
+    /** audioSource's length at its working rate.  Same threads as that. */
+    juce::int64 getWorkingSampleCount (const juce::ARAAudioSource* audioSource) const;
+
+    /** playbackRegion's span of its modification, in samples at its
+        source's working rate.  Same threads as getWorkingSampleRate(). */
+    juce::Range<juce::int64> getModificationSampleRange (const juce::ARAPlaybackRegion& playbackRegion) const;
+
+    /** audioModification's corrected audio, created empty on first use and
+        filled as its render runs.  A source whose sample rate, working rate
+        or layout changes gets a new cache; renderers pick it up at their
+        next prepareToPlay().  Any thread but the audio thread; takes a lock. */
+    std::shared_ptr<RenderCache> getRenderCache (const juce::ARAAudioModification* audioModification);
+
+    /** How audioModification is corrected, made from its source's analysis
+        and the correction when first asked for; nullptr until the source
+        is analysed.  The background render and offline bounces both use
+        it.  Any thread but the audio thread during live playback; takes a
+        lock. */
+    std::shared_ptr<const PsolaPlan> getRenderPlan (const juce::ARAAudioModification* audioModification);
+
+    /** How playbackRegion's source is stretched to its playback duration,
+        or an unstretched Stretch if it plays at its own length (or the
+        host hasn't enabled stretching for it), in samples at its source's
+        working rate.  Any thread but the audio thread; takes a lock. */
+    PsolaPlan::Stretch getStretch (const juce::ARAPlaybackRegion& playbackRegion) const;
+
+    /** playbackRegion's corrected audio stretched to its playback duration,
+        from the start of the region, filled as its render runs; nullptr for
+        a region that isn't stretched, which plays from its modification's
+        cache.  A new stretch gets a new cache.  Any thread but the audio
+        thread; takes a lock. */
+    std::shared_ptr<RenderCache> getStretchedRenderCache (const juce::ARAPlaybackRegion* playbackRegion);
+
+    /** The plan playbackRegion plays with: its stretched one, made as
+        getRenderPlan() makes the modification's, or its modification's if
+        it isn't stretched.  Same threads as that. */
+    std::shared_ptr<const PsolaPlan> getRenderPlan (const juce::ARAPlaybackRegion* playbackRegion);
+
+    /** The correction every modification is rendered with.  Changing it
+        re-renders them all.  Message thread. */
+    void setCorrection (const PitchCorrection& newCorrection);
+    const PitchCorrection& getCorrection() const noexcept { return correction; }
+
+    /** Where playback is, in song seconds, so the sources under it are
+        analysed first.  Lock-free: renderers call it every block. */
+    void setPlayheadPosition (double songSeconds) noexcept;
+
+    /** Where the user is working, so that source is analysed from there
+        first, as soon as no playback is nearer.  Message thread. */
+    void setEditFocus (const juce::ARAAudioSource* audioSource, double sourceSeconds);
+
+    /** Has samples of audioModification rendered again, nearest the
+        playhead first, for an edit that only changes them.  Message thread. */
+    void invalidateRender (juce::ARAAudioModification* audioModification, juce::Range<juce::int64> samples);
+
+    //==============================================================================
+    /** audioModification's note edits as they are now; empty until edited.
+        Any thread but the audio thread; takes a lock. */
+    NoteEdits getNoteEdits (const juce::ARAAudioModification* audioModification) const;
+
+    /** Makes newEdits audioModification's edits as one undoable step, and
+        re-renders the notes it changes.  Message thread. */
+    void setNoteEdits (juce::ARAAudioModification* audioModification, NoteEdits newEdits);
+
+    /** Steps audioModification's edits back or forward through the versions
+        setNoteEdits() made; false if there's none that way.  Message thread. */
+    bool undoNoteEdits (juce::ARAAudioModification* audioModification);
+    bool redoNoteEdits (juce::ARAAudioModification* audioModification);
 
 protected:
     //==============================================================================
     // Override document controller customization methods here
 
+    juce::ARAAudioSource* doCreateAudioSource (juce::ARADocument* document, ARA::ARAAudioSourceHostRef hostRef) noexcept override;
+    juce::ARAAudioModification* doCreateAudioModification (juce::ARAAudioSource* audioSource,
+                                                           ARA::ARAAudioModificationHostRef hostRef,
+                                                           const juce::ARAAudioModification* optionalModificationToClone) noexcept override;
+    juce::ARAPlaybackRegion* doCreatePlaybackRegion (juce::ARAAudioModification* modification,
+                                                     ARA::ARAPlaybackRegionHostRef hostRef) noexcept override;
     juce::ARAPlaybackRenderer* doCreatePlaybackRenderer() noexcept override;
 
     bool doRestoreObjectsFromStream (juce::ARAInputStream& input, const juce::ARARestoreObjectsFilter* filter) noexcept override;
     bool doStoreObjectsToStream (juce::ARAOutputStream& output, const juce::ARAStoreObjectsFilter* filter) noexcept override;
 
+    // Content reading: notes and static tuning, once a source is analysed
+    bool isAudioSourceContentAvailable (const ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type) override;
+    ARA::ARAContentGrade getAudioSourceContentGrade (const ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type) override;
+    ARA::PlugIn::ContentReader* createAudioSourceContentReader (ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type,
+                                                                const ARA::ARAContentTimeRange* range) override;
+
+    bool isAudioModificationContentAvailable (const ARA::PlugIn::AudioModification* audioModification, ARA::ARAContentType type) override;
+    ARA::ARAContentGrade getAudioModificationContentGrade (const ARA::PlugIn::AudioModification* audioModification, ARA::ARAContentType type) override;
+    ARA::PlugIn::ContentReader* createAudioModificationContentReader (ARA::PlugIn::AudioModification* audioModification, ARA::ARAContentType type,
+                                                                      const ARA::ARAContentTimeRange* range) override;
+
+    bool isPlaybackRegionContentAvailable (const ARA::PlugIn::PlaybackRegion* playbackRegion, ARA::ARAContentType type) override;
+    ARA::ARAContentGrade getPlaybackRegionContentGrade (const ARA::PlugIn::PlaybackRegion* playbackRegion, ARA::ARAContentType type) override;
+    ARA::PlugIn::ContentReader* createPlaybackRegionContentReader (ARA::PlugIn::PlaybackRegion* playbackRegion, ARA::ARAContentType type,
+                                                                   const ARA::ARAContentTimeRange* range) override;
+
+    bool isAudioSourceContentAnalysisIncomplete (const ARA::PlugIn::AudioSource* audioSource, ARA::ARAContentType type) override;
+
 private:
+    //==============================================================================
+    class RenderJob;
+    class NoteReader;
+    class TuningReader;
+
+    // Model notifications, all on the message thread
+    void didUpdateAudioSourceProperties (juce::ARAAudioSource* audioSource) override;
+    void doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags) override;
+    void willEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable) override;
+    void didEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable) override;
+    void willDestroyAudioSource (juce::ARAAudioSource* audioSource) override;
+    void didUpdateAudioModificationContent (juce::ARAAudioModification* audioModification, juce::ARAContentUpdateScopes scopeFlags) override;
+    void didAddPlaybackRegionToAudioModification (juce::ARAAudioModification* audioModification, juce::ARAPlaybackRegion* playbackRegion) override;
+    void willRemovePlaybackRegionFromAudioModification (juce::ARAAudioModification* audioModification, juce::ARAPlaybackRegion* playbackRegion) override;
+    void willDestroyAudioModification (juce::ARAAudioModification* audioModification) override;
+    void didUpdatePlaybackRegionProperties (juce::ARAPlaybackRegion* playbackRegion) override;
+
+    /** Starts the renders of every source queued by queueRenders(), and
+        sends the notifications queued by queueContentChanged(). */
+    void handleAsyncUpdate() override;
+
+    /** Drops any result for audioSource and queues it to be analysed
+        again, if its samples can be read.  Message thread. */
+    void startAnalysis (juce::ARAAudioSource* audioSource);
+
+    /** Stops audioSource's analysis and waits for it.  Message thread. */
+    void cancelAnalysis (juce::ARAAudioSource* audioSource);
+
+    /** Tells the scheduler where audioSource's regions place it in the
+        song, leaving out one on its way out if not null.  Message thread. */
+    void updatePlacements (juce::ARAAudioSource* audioSource, const juce::ARAPlaybackRegion* leaving);
+
+    /** Has a restored analysis's source read through for its waveform and
+        SampleCache, unless that's done or under way.  Message thread. */
+    void startScan (juce::ARAAudioSource* audioSource);
+
+    /** A new SampleCache for audioSource, replacing any it had, or nullptr
+        (and none) if it's off or there's no disk for it; at the rate it's
+        wanted at if it's made, and that's its working rate from now on,
+        otherwise the source's own.  Message thread. */
+    std::shared_ptr<SampleCache> makeSampleCache (juce::ARAAudioSource* audioSource);
+
+    /** The working rate audioSource's next analysis should have: the
+        playback rate, if that's known and the source isn't at it and can
+        be converted.  Message thread. */
+    double getWantedSampleRate (const juce::ARAAudioSource* audioSource) const;
+
+    /** Analyses again every source whose working rate isn't the one it
+        should have now.  Message thread. */
+    void updateWorkingRates();
+
+    /** Called by the scheduler on a worker when it has analysed the whole
+        source, or just read it through for startScan() (analysis null). */
+    void publishAnalysis (const juce::ARAAudioSource* audioSource, std::shared_ptr<const PitchAnalysis> analysis,
+                          std::shared_ptr<const WaveformOverview> waveform);
+
+    /** True if audioSource has an analysis, decoded or not.  Any thread. */
+    bool hasAnalysis (const juce::ARAAudioSource* audioSource) const;
+
+    /** Has audioSource's modifications rendered, from the message thread,
+        soon.  Any thread. */
+    void queueRenders (const juce::ARAAudioSource* audioSource);
+
+    /** (Re)starts audioModification's render if its source is analysed and
+        readable; chunks already rendered are kept.  Message thread. */
+    void startRender (juce::ARAAudioModification* audioModification);
+
+    /** Stops audioModification's render, and those of its stretched
+        regions, and waits for them.  Message thread. */
+    void cancelRender (juce::ARAAudioModification* audioModification);
+
+    /** (Re)starts playbackRegion's stretched render, as startRender() does,
+        or forgets the render if the region is no longer stretched.
+        Message thread. */
+    void startStretchedRender (juce::ARAPlaybackRegion* playbackRegion);
+
+    /** Stops playbackRegion's stretched render and waits for it.  Message
+        thread. */
+    void cancelStretchedRender (const juce::ARAPlaybackRegion* playbackRegion);
+
+    /** Swaps audioModification's edits for next, then re-renders what the
+        notes that differ from the version before reach, telling the host
+        unless this is its own undo.  Message thread. */
+    void replaceNoteEdits (juce::ARAAudioModification* audioModification, NoteEdits next, bool notifyHost = true);
+
+    static bool isAnalysedContent (ARA::ARAContentType type) noexcept
+    {
+        return type == ARA::kARAContentTypeNotes || type == ARA::kARAContentTypeStaticTuning;
+    }
+
+    /**
+     * A reader for type over audioSource's analysis, in a timeline
+     * sourceToTarget seconds on from the source's, holding only what lies
+     * in clip (source seconds) and overlaps range (target seconds, all of
+     * it if null).  Nullptr before the analysis is done.
+     */
+    ARA::PlugIn::ContentReader* createContentReader (const juce::ARAAudioSource* audioSource, ARA::ARAContentType type,
+                                                     const ARA::ARAContentTimeRange* range,
+                                                     double sourceToTarget, juce::Range<double> clip) const;
+
+    /** Tells the host the notes and tuning of audioSource, and of
+        everything made from it, have changed.  Message thread. */
+    void notifyAnalysedContentChanged (juce::ARAAudioSource* audioSource);
+
+    /** Has notifyAnalysedContentChanged() called from the message thread,
+        soon.  Any thread. */
+    void queueContentChanged (const juce::ARAAudioSource* audioSource);
+
+    /** Stops every render of audioSource's modifications and marks all they
+        rendered dirty (it plays on until replaced), or drops the caches
+        altogether if their shape no longer fits the source; a cache that's
+        not the source's working length is dropped either way.  Message
+        thread. */
+    void discardRenders (juce::ARAAudioSource* audioSource, bool dropCaches);
+
+    static constexpr int          kCancelTimeoutMs      = 10000;
+    static constexpr juce::int32  kArchiveVersion       = 2;                   // 2: note edits after the analyses
+    static constexpr juce::int64  kMaxArchivedAnalysis  = 256 * 1024 * 1024;   // bytes; anything larger is damage
+    static constexpr size_t       kMaxUndoSteps         = 1000;                // versions are cheap, not free
+
+    /** An analysis as produced, or as restored and not yet needed. */
+    struct StoredAnalysis
+    {
+        std::shared_ptr<const PitchAnalysis>    decoded;         // null until first asked for, if restored
+        juce::MemoryBlock                       encoded;         // PitchAnalysis::toBinary(), once archived or restored
+        std::shared_ptr<const NoteIndex>        notes;           // null until first asked for, if restored
+        std::shared_ptr<const PitchOverview>    pitchOverview;   // likewise
+        std::shared_ptr<const WaveformOverview> waveform;        // null until scanned, if restored
+    };
+
+    mutable juce::CriticalSection                                 analysesLock;
+    mutable std::map<const juce::ARAAudioSource*, StoredAnalysis> analyses;
+    std::map<const juce::ARAAudioSource*, std::shared_ptr<SampleCache>> sampleCaches;   // also under analysesLock
+    std::map<const juce::ARAAudioSource*, double>                       workingRates;   // also under analysesLock; set by makeSampleCache()
+
+    bool                sampleCacheEnabled = true;   // message thread
+    std::atomic<double> playbackSampleRate { 0.0 };  // unknown until a renderer is prepared
+
+    std::map<const juce::ARAAudioModification*, std::unique_ptr<RenderJob>> renderJobs;   // message thread
+    std::map<const juce::ARAPlaybackRegion*, std::unique_ptr<RenderJob>>    stretchJobs;  // message thread
+
+    /** A modification's plan, stale once its source's analysis or its
+        edits aren't the ones it was made from. */
+    struct StoredPlan
+    {
+        std::shared_ptr<const PitchAnalysis> analysis;
+        NoteEdits                            edits;
+        std::shared_ptr<const PsolaPlan>     plan;
+    };
+
+    /** A modification's edits, and the versions undo and redo go to. */
+    struct EditHistory
+    {
+        NoteEdits              current;
+        std::vector<NoteEdits> undo, redo;   // the nearest at the back
+        NoteEdits              archived;     // what encoded holds
+        juce::MemoryBlock      encoded;
+    };
+
+    /** A stretched region's cache and plan, both made for stretch. */
+    struct StretchedRender
+    {
+        PsolaPlan::Stretch           stretch;
+        std::shared_ptr<RenderCache> cache;
+        StoredPlan                   plan;
+    };
+
+    /** playbackRegion's entry, emptied first if it was made for another
+        stretch.  Call with renderCachesLock held. */
+    StretchedRender& getStretchedRender (const juce::ARAPlaybackRegion* playbackRegion, const PsolaPlan::Stretch& stretch);
+
+    mutable juce::CriticalSection                                           renderCachesLock;
+    std::map<const juce::ARAAudioModification*, std::shared_ptr<RenderCache>> renderCaches;
+    std::map<const juce::ARAAudioModification*, StoredPlan>                   renderPlans;   // dropped on a correction change
+    std::map<const juce::ARAAudioModification*, EditHistory>                  editHistories;
+    std::map<const juce::ARAPlaybackRegion*, StretchedRender>                 stretchedRenders;
+
+    // Sources analysed since the last handleAsyncUpdate(); only compared
+    // against the document's sources, never dereferenced
+    juce::CriticalSection                  pendingRendersLock;
+    std::vector<const juce::ARAAudioSource*> pendingRenders;
+    std::vector<const juce::ARAAudioSource*> pendingContentChanges;   // also under pendingRendersLock
+
+    PitchCorrection correction;   // written on the message thread under renderCachesLock
+
+    // Shared with every other instance through the user's cache folder
+    AnalysisCache analysisCache;
+
+    // Leaves a core for the host's audio threads.  Its analysis and render
+    // jobs stay out of the host's audio workgroup, unlike NewProject's
+    // render workers and PFix's analysis pool while it makes notes: they
+    // work ahead of the playhead into the RenderCaches, so no block waits
+    // on them, and in the workgroup they'd count against its deadline
+    juce::ThreadPool pool { juce::ThreadPoolOptions{}.withThreadName ("AutoTunes analysis")
+                                                     .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1))
+                                                     .withDesiredThreadPriority (juce::Thread::Priority::low) };
+
+    // After the pool and cache it works with, so it's gone before them
+    AnalysisScheduler scheduler { pool, analysisCache,
+                                  [this] (const juce::ARAAudioSource* audioSource, std::shared_ptr<const PitchAnalysis> analysis,
+                                          std::shared_ptr<const WaveformOverview> waveform)
+                                  {
+                                      publishAnalysis (audioSource, std::move (analysis), std::move (waveform));
+                                  } };
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoTunesDocumentController)
 };
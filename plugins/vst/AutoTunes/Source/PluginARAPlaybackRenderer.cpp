@@ -9,18 +9,460 @@
 */
 
 #include "PluginARAPlaybackRenderer.h"
+#include "PluginARADocumentController.h"
+#include "PsolaPlan.h"
+#include "SampleCache.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 //==============================================================================
+/** A source converted to the playback rate, read from its SampleCache, the
+    only copy of it at that rate.  What isn't decoded yet reads as silence. */
+class AutoTunesPlaybackRenderer::SampleCacheReader  : public juce::AudioFormatReader
+{
+public:
+    explicit SampleCacheReader (std::shared_ptr<const SampleCache> samplesIn)
+        : AudioFormatReader (nullptr, "AutoTunes sample cache"),
+          samples (std::move (samplesIn))
+    {
+        sampleRate            = samples->getSampleRate();
+        bitsPerSample         = 32;
+        lengthInSamples       = samples->getNumSamples();
+        numChannels           = (unsigned int) samples->getNumChannels();
+        usesFloatingPointData = true;
+    }
+
+    bool readSamples (int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+                      juce::int64 startSampleInFile, int numSamples) override
+    {
+        clearSamplesBeyondAvailableLength (destChannels, numDestChannels, startOffsetInDestBuffer,
+                                           startSampleInFile, numSamples, lengthInSamples);
+
+        if (numSamples <= 0)
+            return true;
+
+        // Float data, so the int pointers are really float ones
+        std::array<float*, kMaxChannels> channels {};
+        const auto numToRead = juce::jmin (numDestChannels, kMaxChannels);
+
+        for (int c = 0; c < numToRead; ++c)
+            channels[(size_t) c] = destChannels[c] != nullptr ? reinterpret_cast<float*> (destChannels[c]) + startOffsetInDestBuffer : nullptr;
+
+        // A null channel isn't wanted, so only those before it are read
+        const auto numWanted = (int) (std::find (channels.begin(), channels.begin() + numToRead, nullptr) - channels.begin());
+
+        if (samples->read (channels.data(), numWanted, startSampleInFile, numSamples))
+            return true;
+
+        for (int c = 0; c < numWanted; ++c)
+            juce::FloatVectorOperations::clear (channels[(size_t) c], numSamples);
+
+        return false;
+    }
+
+private:
+    static constexpr int kMaxChannels = 32;
+
+    const std::shared_ptr<const SampleCache> samples;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCacheReader)
+};
+
+//==============================================================================
+AutoTunesPlaybackRenderer::~AutoTunesPlaybackRenderer()
+{
+    releaseRegions();
+}
+
 void AutoTunesPlaybackRenderer::prepareToPlay (double sampleRateIn, int maximumSamplesPerBlockIn, int numChannelsIn, juce::AudioProcessor::ProcessingPrecision, AlwaysNonRealtime alwaysNonRealtime)
 {
     numChannels = numChannelsIn;
     sampleRate = sampleRateIn;
     maximumSamplesPerBlock = maximumSamplesPerBlockIn;
     useBufferedAudioSourceReader = alwaysNonRealtime == AlwaysNonRealtime::no;
+    perfProbe.prepare (sampleRate);
+    perfProbe.reset();
+
+    mixBuffer.setSize (numChannels, maximumSamplesPerBlock);
+    probeBuffer.setSize (numChannels, 1);
+    fadeGains.resize ((size_t) maximumSamplesPerBlock);
+
+    for (int i = 0; i <= kFadeTableSize; ++i)
+        fadeTable[(size_t) i] = std::sin (juce::MathConstants<float>::halfPi * (float) i / (float) kFadeTableSize);
+
+    // Hosts only change a renderer's regions while it isn't prepared
+    releaseRegions();
+
+    documentController = juce::ARADocumentControllerSpecialisation::getSpecialisedDocumentController<AutoTunesDocumentController> (getDocumentController());
+
+    // Before any cache is asked for, so a source at another rate is worked at ours
+    documentController->setPlaybackSampleRate (sampleRate);
+
+    for (auto* playbackRegion : getPlaybackRegions())
+    {
+        auto region = std::make_unique<RegionReader>();
+        region->playbackRegion = playbackRegion;
+        region->renderCache    = documentController->getRenderCache (playbackRegion->getAudioModification());
+
+        auto sourceReader = makeSourceReader (*playbackRegion->getAudioModification()->getAudioSource());
+
+        if (useBufferedAudioSourceReader)
+        {
+            const auto readAhead = juce::jmax (4 * maximumSamplesPerBlock, juce::roundToInt (kReadAheadSeconds * sampleRate));
+            auto buffering = std::make_unique<juce::BufferingAudioReader> (sourceReader.release(), *prefetchThread, readAhead);
+
+            // Never waited on.  A read moves the read-ahead, so this one
+            // (which just misses) starts it filling from where the region begins
+            buffering->setReadTimeout (0);
+            buffering->read (&probeBuffer, 0, 1, documentController->getModificationSampleRange (*playbackRegion).getStart(), true, true);
+
+            region->bufferingReader = buffering.get();
+            region->reader          = std::move (buffering);
+            region->directReader    = makeSourceReader (*playbackRegion->getAudioModification()->getAudioSource());
+        }
+        else
+        {
+            region->reader = std::move (sourceReader);
+        }
+
+        regionReaders.push_back (std::move (region));
+        playbackRegion->addListener (this);
+    }
+
+    rebuildRegionIndex();
+}
+
+std::unique_ptr<juce::AudioFormatReader> AutoTunesPlaybackRenderer::makeSourceReader (juce::ARAAudioSource& audioSource) const
+{
+    const auto sampleRate = documentController->getWorkingSampleRate (&audioSource);
+
+    if (sampleRate != audioSource.getSampleRate())
+        if (auto samples = documentController->getSampleCache (&audioSource); samples != nullptr && samples->getSampleRate() == sampleRate)
+            return std::make_unique<SampleCacheReader> (std::move (samples));
+
+    return std::make_unique<juce::ARAAudioSourceReader> (&audioSource);
 }
 
 void AutoTunesPlaybackRenderer::releaseResources()
 {
+    releaseRegions();
+}
+
+void AutoTunesPlaybackRenderer::releaseRegions()
+{
+    cancelPendingUpdate();
+
+    for (const auto& region : regionReaders)
+        region->playbackRegion->removeListener (this);
+
+    regionReaders.clear();
+
+    // Not processing now, so the audio thread's index is ours too
+    const decltype (regionIndexLock)::ScopedLockType lock (regionIndexLock);
+    regionIndex.reset();
+    pendingRegionIndex.reset();
+    retiredRegionIndex.reset();
+    hasPendingRegionIndex.store (false);
+}
+
+//==============================================================================
+void AutoTunesPlaybackRenderer::rebuildRegionIndex()
+{
+    std::vector<RegionIndex::Entry> entries;
+    entries.reserve (regionReaders.size());
+
+    for (size_t i = 0; i < regionReaders.size(); ++i)
+    {
+        auto* playbackRegion = regionReaders[i]->playbackRegion;
+
+        // Evaluate region borders in song time.  Note that this does not use
+        // head- or tailtime, so includeHeadAndTail is no - this might need to
+        // be adjusted in actual plug-ins.
+        const auto playbackSampleRange = playbackRegion->getSampleRange (sampleRate,
+                                                                         juce::ARAPlaybackRegion::IncludeHeadAndTail::no);
+
+        RegionIndex::Entry entry;
+        entry.region = (int) i;
+
+        // Stretched, it plays its own cache from the region's start
+        if (auto stretched = documentController->getStretchedRenderCache (playbackRegion))
+        {
+            entry.songRange      = playbackSampleRange.getIntersectionWith (playbackSampleRange.withLength (stretched->getNumSamples()));
+            entry.sourceOffset   = -playbackSampleRange.getStart();
+            entry.stretchedCache = std::move (stretched);
+            entries.push_back (std::move (entry));
+            continue;
+        }
+
+        // Then in modification/source time, for the offset between song and
+        // source samples, clipping song time to the modification
+        const auto modificationSampleRange = documentController->getModificationSampleRange (*playbackRegion);
+
+        entry.songRange    = playbackSampleRange.getIntersectionWith (modificationSampleRange.movedToStartAt (playbackSampleRange.getStart()));
+        entry.sourceOffset = modificationSampleRange.getStart() - playbackSampleRange.getStart();
+        entries.push_back (std::move (entry));
+    }
+
+    auto index = std::make_unique<RegionIndex> (std::move (entries));
+    std::unique_ptr<RegionIndex> superseded, retired;   // freed here, outside the lock
+
+    const decltype (regionIndexLock)::ScopedLockType lock (regionIndexLock);
+    superseded = std::exchange (pendingRegionIndex, std::move (index));
+    retired    = std::move (retiredRegionIndex);
+    hasPendingRegionIndex.store (true);
+}
+
+void AutoTunesPlaybackRenderer::swapInRegionIndex() noexcept
+{
+    if (! hasPendingRegionIndex.load())
+        return;
+
+    // The message thread only ever holds this lock for a few pointer moves;
+    // if it has it now, the next block takes the index up instead
+    const decltype (regionIndexLock)::ScopedTryLockType lock (regionIndexLock);
+
+    if (! lock.isLocked())
+        return;
+
+    retiredRegionIndex = std::exchange (regionIndex, std::move (pendingRegionIndex));
+    hasPendingRegionIndex.store (false);
+}
+
+juce::uint64 AutoTunesPlaybackRenderer::getPrefetchMisses (const juce::ARAPlaybackRegion* playbackRegion) const noexcept
+{
+    for (const auto& region : regionReaders)
+        if (region->playbackRegion == playbackRegion)
+            return region->prefetchMisses.load (std::memory_order_relaxed);
+
+    return 0;
+}
+
+juce::uint64 AutoTunesPlaybackRenderer::getTotalPrefetchMisses() const noexcept
+{
+    juce::uint64 total = 0;
+
+    for (const auto& region : regionReaders)
+        total += region->prefetchMisses.load (std::memory_order_relaxed);
+
+    return total;
+}
+
+bool AutoTunesPlaybackRenderer::readRegion (RegionReader& region, RenderCache* stretchedCache, juce::AudioBuffer<float>& destination,
+                                            int startInDestination, int numSamples, juce::int64 startInSource,
+                                            juce::AudioProcessor::Realtime realtime) noexcept
+{
+    if (realtime == juce::AudioProcessor::Realtime::no)
+    {
+        const RealtimeSafety::ScopedAllowance offline;   // reads and corrects a span, with no deadline to miss
+        return readRegionOffline (region, stretchedCache, destination, startInDestination, numSamples, startInSource);
+    }
+
+    // Only what's rendered: the source as recorded is the wrong length
+    if (stretchedCache != nullptr)
+    {
+        stretchedCache->setPlayheadHint (startInSource);
+
+        if (! stretchedCache->read (destination, startInDestination, startInSource, numSamples))
+        {
+            destination.clear (startInDestination, numSamples);
+            TRACE_INSTANT ("stretch not rendered");
+        }
+
+        return true;
+    }
+
+    // Modification and source time are the same for an unstretched region
+    if (region.renderCache != nullptr)
+        region.renderCache->setPlayheadHint (startInSource);
+
+    if (region.renderCache != nullptr && region.renderCache->read (destination, startInDestination, startInSource, numSamples))
+    {
+        // A one-sample read keeps the read-ahead following the playhead, so
+        // falling back where the render hasn't reached doesn't start cold
+        if (region.bufferingReader != nullptr)
+            region.bufferingReader->read (&probeBuffer, 0, 1, startInSource + numSamples, true, true);
+
+        return true;
+    }
+
+    // A mono source plays on both sides
+    if (region.reader->read (&destination, startInDestination, numSamples, startInSource, true, true))
+        return true;
+
+    // A live miss has already been filled with silence, which is the best
+    // the block can have
+    if (region.bufferingReader != nullptr)
+    {
+        region.prefetchMisses.fetch_add (1, std::memory_order_relaxed);
+        TRACE_INSTANT ("prefetch miss");
+        return true;
+    }
+
+    return false;
+}
+
+bool AutoTunesPlaybackRenderer::readRegionOffline (RegionReader& region, RenderCache* stretchedCache, juce::AudioBuffer<float>& destination,
+                                                   int startInDestination, int numSamples, juce::int64 startInSource) noexcept
+{
+    const auto stretched = stretchedCache != nullptr;
+    auto*      cache     = stretched ? stretchedCache : region.renderCache.get();
+
+    if (cache != nullptr)
+    {
+        cache->setPlayheadHint (startInSource);
+
+        // Dirty chunks are the last correction, not the current one
+        if (cache->read (destination, startInDestination, startInSource, numSamples, false))
+            return true;
+    }
+
+    const auto wanted = juce::Range<juce::int64>::withStartAndLength (startInSource, numSamples);
+
+    if (! region.offlineRange.contains (wanted))
+        renderOfflineSpan (region, stretched, startInSource);
+
+    if (region.offlineRange.contains (wanted))
+    {
+        const auto offset          = (int) (startInSource - region.offlineRange.getStart());
+        const auto numSpanChannels = region.offlineAudio.getNumChannels();
+
+        // A mono source plays on both sides
+        for (int c = 0; c < destination.getNumChannels(); ++c)
+            destination.copyFrom (c, startInDestination, region.offlineAudio, juce::jmin (c, numSpanChannels - 1), offset, numSamples);
+
+        return true;
+    }
+
+    // Not analysed yet: as recorded, which a stretch can't use
+    if (stretched)
+    {
+        destination.clear (startInDestination, numSamples);
+        return true;
+    }
+
+    return region.getDirectReader().read (&destination, startInDestination, numSamples, startInSource, true, true);
+}
+
+bool AutoTunesPlaybackRenderer::renderOfflineSpan (RegionReader& region, bool stretched, juce::int64 startInSource)
+{
+    region.offlineRange = {};
+
+    // A stretched plan's output is the region alone
+    const auto plan = stretched ? documentController->getRenderPlan (region.playbackRegion)
+                                : documentController->getRenderPlan (region.playbackRegion->getAudioModification());
+
+    if (plan == nullptr)
+        return false;
+
+    auto& reader = region.getDirectReader();
+    const auto numSourceChannels = (int) reader.numChannels;
+    const auto spanEnd    = juce::jmin (startInSource + kOfflineSpanSamples, plan->getNumSamples(),
+                                        stretched ? plan->getNumSamples() : documentController->getModificationSampleRange (*region.playbackRegion).getEnd());
+    const auto numOutput  = (int) (spanEnd - startInSource);
+
+    if (numOutput <= 0 || numSourceChannels <= 0)
+        return false;
+
+    // One contiguous read for the whole span, then the workers all render
+    // from the same input
+    const auto inputRange = plan->getInputRange (startInSource, numOutput);
+    const auto numInput   = (int) inputRange.getLength();
+
+    offlineInput.setSize (numSourceChannels, numInput, false, false, true);
+
+    if (! reader.read (offlineInput.getArrayOfWritePointers(), numSourceChannels, inputRange.getStart(), numInput))
+        return false;
+
+    region.offlineAudio.setSize (numSourceChannels, numOutput, false, false, true);
+
+    const auto numSlices   = juce::jlimit (1, offlineWorkers->getNumThreads() + 1, numOutput / kMinOfflineSlice);
+    const auto sliceLength = (numOutput + numSlices - 1) / numSlices;
+
+    if ((int) offlineWeights.size() < numSlices)
+        offlineWeights.resize ((size_t) numSlices);
+
+    const auto renderSlice = [&] (int slice)
+    {
+        const auto start  = slice * sliceLength;
+        const auto length = juce::jmin (sliceLength, numOutput - start);
+        auto&      weights = offlineWeights[(size_t) slice];
+
+        if ((int) weights.size() < length)
+            weights.resize ((size_t) length);
+
+        // Each slice renders into its own stretch of the span
+        juce::AudioBuffer<float> output (region.offlineAudio.getArrayOfWritePointers(), numSourceChannels, start, length);
+        plan->render (offlineInput, inputRange.getStart(), output, startInSource + start, length, weights);
+    };
+
+    std::atomic<int>  remaining { numSlices };
+    juce::WaitableEvent allDone;
+
+    for (int slice = 1; slice < numSlices; ++slice)
+    {
+        offlineWorkers->addJob ([&, slice]
+        {
+            renderSlice (slice);
+
+            if (--remaining == 0)
+                allDone.signal();
+        });
+    }
+
+    // This thread takes a slice too rather than only waiting
+    renderSlice (0);
+
+    if (--remaining != 0)
+        allDone.wait();
+
+    region.offlineRange = { startInSource, spanEnd };
+    return true;
+}
+
+//==============================================================================
+void AutoTunesPlaybackRenderer::applyFades (const RegionIndex::Entry& entry, juce::AudioBuffer<float>& destination,
+                                            int startInDestination, juce::Range<juce::int64> songRange) noexcept
+{
+    if (! entry.fadeIn.isEmpty())
+        applyFade (entry.fadeIn, true, destination, startInDestination, songRange);
+
+    if (! entry.fadeOut.isEmpty())
+        applyFade (entry.fadeOut, false, destination, startInDestination, songRange);
+}
+
+void AutoTunesPlaybackRenderer::applyFade (juce::Range<juce::int64> fade, bool fadingIn, juce::AudioBuffer<float>& destination,
+                                           int startInDestination, juce::Range<juce::int64> songRange) noexcept
+{
+    const auto covered = fade.getIntersectionWith (songRange);
+
+    if (covered.isEmpty())
+        return;
+
+    const auto offset     = (int) (covered.getStart() - songRange.getStart());
+    const auto numSamples = (int) covered.getLength();
+
+    // Table positions at sample centres, so the two sides of a crossfade
+    // take sin and cos of the same angle and their powers sum to one
+    const auto step  = (double) kFadeTableSize / (double) fade.getLength();
+    auto       first = ((double) (covered.getStart() - fade.getStart()) + 0.5) * step;
+
+    if (! fadingIn)
+        first = (double) kFadeTableSize - first;
+
+    const auto increment = (float) (fadingIn ? step : -step);
+    const auto start     = (float) first;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto position = juce::jlimit (0.0f, (float) kFadeTableSize - 0.001f, start + increment * (float) i);
+        const auto index    = (int) position;
+        const auto between  = position - (float) index;
+        fadeGains[(size_t) i] = fadeTable[(size_t) index] + between * (fadeTable[(size_t) index + 1] - fadeTable[(size_t) index]);
+    }
+
+    for (int c = 0; c < destination.getNumChannels(); ++c)
+        juce::FloatVectorOperations::multiply (destination.getWritePointer (c, startInDestination + offset), fadeGains.data(), numSamples);
 }
 
 //==============================================================================
@@ -28,7 +470,11 @@ bool AutoTunesPlaybackRenderer::processBlock (juce::AudioBuffer<float>& buffer,
                                                        juce::AudioProcessor::Realtime realtime,
                                                        const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept
 {
+    REALTIME_SAFETY_AUDIO_THREAD ("AutoTunes playback renderer");
+    TRACE_SCOPE ("AutoTunes playback renderer");
     const auto numSamples = buffer.getNumSamples();
+    const PerfProbe::Scope blockTimer (perfProbe, blockScope, numSamples);
+
     jassert (numSamples <= maximumSamplesPerBlock);
     jassert (numChannels == buffer.getNumChannels());
     jassert (realtime == juce::AudioProcessor::Realtime::no || useBufferedAudioSourceReader);
@@ -38,65 +484,45 @@ bool AutoTunesPlaybackRenderer::processBlock (juce::AudioBuffer<float>& buffer,
     bool success = true;
     bool didRenderAnyRegion = false;
 
-    if (isPlaying)
+    swapInRegionIndex();
+
+    // Parked or playing, what's here is what's wanted next
+    documentController->setPlayheadPosition ((double) timeInSamples / sampleRate);
+
+    if (isPlaying && regionIndex != nullptr)
     {
+        const PerfProbe::Scope regionsTimer (perfProbe, regionsScope, numSamples);
         const auto blockRange = juce::Range<juce::int64>::withStartAndLength (timeInSamples, numSamples);
 
-        for (const auto& playbackRegion : getPlaybackRegions())
+        regionIndex->forEachOverlapping (blockRange, [&] (const RegionIndex::Entry& entry)
         {
-            // Evaluate region borders in song time, calculate sample range to render in song time.
-            // Note that this example does not use head- or tailtime, so the includeHeadAndTail
-            // parameter is set to false here - this might need to be adjusted in actual plug-ins.
-            const auto playbackSampleRange = playbackRegion->getSampleRange (sampleRate,
-                                                                             juce::ARAPlaybackRegion::IncludeHeadAndTail::no);
-            auto renderRange = blockRange.getIntersectionWith (playbackSampleRange);
-
-            if (renderRange.isEmpty())
-                continue;
-
-            // Evaluate region borders in modification/source time and calculate offset between
-            // song and source samples, then clip song samples accordingly
-            // (if an actual plug-in supports time stretching, this must be taken into account here).
-            juce::Range<juce::int64> modificationSampleRange { playbackRegion->getStartInAudioModificationSamples(),
-                                                               playbackRegion->getEndInAudioModificationSamples() };
-            const auto modificationSampleOffset = modificationSampleRange.getStart() - playbackSampleRange.getStart();
-
-            renderRange = renderRange.getIntersectionWith (modificationSampleRange.movedToStartAt (playbackSampleRange.getStart()));
-
-            if (renderRange.isEmpty())
-                continue;
-
-            // Now calculate the samples in renderRange for this PlaybackRegion based on the ARA model
-            // graph. If didRenderAnyRegion is true, add the region's output samples in renderRange to
-            // the buffer. Otherwise the buffer needs to be initialised so the sample value must be
-            // overwritten.
+            auto& region = *regionReaders[(size_t) entry.region];
+            const auto renderRange = blockRange.getIntersectionWith (entry.songRange);
+
+            // The first region is read straight into the output; any later one
+            // overlapping it is read aside and added in.
             const int numSamplesToRead = (int) renderRange.getLength();
             const int startInBuffer = (int) (renderRange.getStart() - blockRange.getStart());
-            const auto startInSource = renderRange.getStart() + modificationSampleOffset;
+            const auto startInSource = renderRange.getStart() + entry.sourceOffset;
+
+            auto&     destination        = didRenderAnyRegion ? mixBuffer : buffer;
+            const int startInDestination = didRenderAnyRegion ? 0 : startInBuffer;
+
+            success = readRegion (region, entry.stretchedCache.get(), destination, startInDestination, numSamplesToRead, startInSource, realtime) && success;
+            applyFades (entry, destination, startInDestination, renderRange);
 
-            for (int c = 0; c < numChannels; ++c)
+            if (didRenderAnyRegion)
             {
-                auto* channelData = buffer.getWritePointer (c);
-
-                for (int i = 0; i < numSamplesToRead; ++i)
-                {
-                    // Calculate region output sample at index startInSource + i ...
-                    float sample = 0.0f;
-
-                    if (didRenderAnyRegion)
-                        channelData[startInBuffer + i] += sample;
-                    else
-                        channelData[startInBuffer + i] = sample;
-                }
+                for (int c = 0; c < numChannels; ++c)
+                    juce::FloatVectorOperations::add (buffer.getWritePointer (c, startInBuffer), mixBuffer.getReadPointer (c), numSamplesToRead);
             }
-
-            // If rendering first region, clear any excess at start or end of the region.
-            if (! didRenderAnyRegion)
+            else
             {
+                // Clear any excess at start or end of the first region
                 if (startInBuffer != 0)
                     buffer.clear (0, startInBuffer);
 
-                const int endInBuffer = startInBuffer + numSamples;
+                const int endInBuffer = startInBuffer + numSamplesToRead;
                 const int remainingSamples = numSamples - endInBuffer;
 
                 if (remainingSamples != 0)
@@ -104,7 +530,7 @@ bool AutoTunesPlaybackRenderer::processBlock (juce::AudioBuffer<float>& buffer,
 
                 didRenderAnyRegion = true;
             }
-        }
+        });
     }
 
     if (! didRenderAnyRegion)
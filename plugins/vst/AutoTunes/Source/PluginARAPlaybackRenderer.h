@@ -11,15 +11,67 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/RealtimeSafety.h"
+#include "../../Shared/TraceEvents.h"
+#include "RegionIndex.h"
+#include "RenderCache.h"
+#include <array>
+#include <vector>
+
+class AutoTunesDocumentController;
 
 //==============================================================================
 /**
+    Plays each of its playback regions pitch-corrected, copied from its
+    audio modification's RenderCache, and from its own reader (uncorrected)
+    wherever the cache isn't rendered yet.
+
+    For live playback that's a BufferingAudioReader over an
+    ARAAudioSourceReader, filled ahead of the region's playhead on a shared
+    background thread, so the audio thread never waits on the host's
+    audio-source reads: a block that isn't buffered in time plays silence
+    for that region and counts as a prefetch miss.  Hosts that only ever
+    render offline get the ARAAudioSourceReader itself.
+
+    Offline blocks (bounces) never touch the buffering reader.  Wherever the
+    cache isn't rendered and clean, the renderer reads a span of several
+    seconds straight from the source and corrects it with the modification's
+    PsolaPlan, split across a pool of workers, before the block returns; the
+    blocks after it then copy from that span.
+
+    A block finds its regions through a RegionIndex of their song-time
+    ranges, rebuilt on the message thread whenever a region changes and
+    swapped in at the start of the next block.
+
+    A region the host time-stretches plays from its own cache instead, in
+    region time (see AutoTunesDocumentController::getStretchedRenderCache()),
+    which the index carries with it: the same copy as any other region,
+    and silence where that render hasn't got to yet, since the source
+    can't stand in at another length.  Offline, the span rendered on the
+    spot comes from the region's stretched plan.
+
+    A source at another rate from ours has been converted to ours by the
+    document controller (see AutoTunesDocumentController::
+    getWorkingSampleRate()), and everything of it, caches and offsets, is
+    at our rate; where it isn't rendered it's read from its SampleCache,
+    the one copy at our rate, through the same buffering, so nothing is
+    resampled here.
+
+    Regions are copied into the output a block at a time, the first
+    straight in and any other overlapping it read aside and added.  Where
+    a comp's regions overlap (see RegionIndex), the earlier fades out and
+    the later in across the overlap, equal power, with gains interpolated
+    from a quarter-sine table built in prepareToPlay().
 */
-class AutoTunesPlaybackRenderer  : public juce::ARAPlaybackRenderer
+class AutoTunesPlaybackRenderer  : public juce::ARAPlaybackRenderer,
+                                   private juce::ARAPlaybackRegion::Listener,
+                                   private juce::AsyncUpdater
 {
 public:
     //==============================================================================
     using juce::ARAPlaybackRenderer::ARAPlaybackRenderer;
+    ~AutoTunesPlaybackRenderer() override;
 
     //==============================================================================
     void prepareToPlay (double sampleRate,
@@ -34,12 +86,141 @@ public:
                        juce::AudioProcessor::Realtime realtime,
                        const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept override;
 
+    /** CPU load of this renderer: "block" is all of processBlock(), "regions"
+        the per-region rendering.  Offline blocks are timed against the same
+        real-time deadline.  Safe to read from any thread. */
+    const PerfProbe& getPerfProbe() const noexcept { return perfProbe; }
+
+    /** Realtime blocks in which playbackRegion's audio wasn't buffered in
+        time, since prepareToPlay().  Any thread. */
+    juce::uint64 getPrefetchMisses (const juce::ARAPlaybackRegion* playbackRegion) const noexcept;
+
+    /** The same, summed over every region. */
+    juce::uint64 getTotalPrefetchMisses() const noexcept;
+
 private:
     //==============================================================================
+    class SampleCacheReader;
+
+    /** One region's reader.  Per region rather than per audio source, so
+        two regions cut from one take each get read-ahead at their own
+        position. */
+    struct RegionReader
+    {
+        juce::ARAPlaybackRegion*                 playbackRegion = nullptr;
+        std::shared_ptr<RenderCache>             renderCache;   // shared by the modification's regions
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::BufferingAudioReader*              bufferingReader = nullptr;   // reader, when it buffers
+        std::unique_ptr<juce::AudioFormatReader> directReader;                // for offline blocks, when reader buffers
+        std::atomic<juce::uint64>                prefetchMisses { 0 };
+
+        // The corrected span offline blocks last rendered, in modification samples
+        juce::AudioBuffer<float>  offlineAudio;
+        juce::Range<juce::int64>  offlineRange;
+
+        juce::AudioFormatReader& getDirectReader() const noexcept { return directReader != nullptr ? *directReader : *reader; }
+    };
+
+    /** A reader of audioSource at its working rate: its SampleCache if
+        that's been converted to ours, else the source itself.  Message
+        thread. */
+    std::unique_ptr<juce::AudioFormatReader> makeSourceReader (juce::ARAAudioSource& audioSource) const;
+
+    /** Reads numSamples of region's source from startInSource into
+        destination at startInDestination, straight into its channels:
+        corrected if the cache has it, else as recorded.  False only if
+        the render failed; a live prefetch miss plays silence and is
+        counted instead.  With a stretchedCache, startInSource is a sample
+        of the stretched region, read from that cache. */
+    bool readRegion (RegionReader& region, RenderCache* stretchedCache, juce::AudioBuffer<float>& destination,
+                     int startInDestination, int numSamples, juce::int64 startInSource,
+                     juce::AudioProcessor::Realtime realtime) noexcept;
+
+    /** readRegion() for an offline block: the cache if it's clean there,
+        else a corrected span rendered now, else (source not analysed yet)
+        the source as recorded, or silence if it's stretched. */
+    bool readRegionOffline (RegionReader& region, RenderCache* stretchedCache, juce::AudioBuffer<float>& destination,
+                            int startInDestination, int numSamples, juce::int64 startInSource) noexcept;
+
+    /** Renders region's corrected audio from startInSource (a sample of the
+        region if stretched) into its offline span.  False if there's no
+        plan or the source couldn't be read. */
+    bool renderOfflineSpan (RegionReader& region, bool stretched, juce::int64 startInSource);
+
+    /** Scales what readRegion() put in destination from startInDestination,
+        the song samples songRange, by entry's fades where they fall in it. */
+    void applyFades (const RegionIndex::Entry& entry, juce::AudioBuffer<float>& destination,
+                     int startInDestination, juce::Range<juce::int64> songRange) noexcept;
+
+    /** One fade's gains over the part of songRange it covers, into
+        fadeGains, for multiplying in. */
+    void applyFade (juce::Range<juce::int64> fade, bool fadingIn, juce::AudioBuffer<float>& destination,
+                    int startInDestination, juce::Range<juce::int64> songRange) noexcept;
+
+    //==============================================================================
+    /** Indexes where every region plays now and queues it for the audio
+        thread.  Message thread, or prepareToPlay(). */
+    void rebuildRegionIndex();
+
+    /** Takes up the index rebuildRegionIndex() last queued.  Audio thread. */
+    void swapInRegionIndex() noexcept;
+
+    void didUpdatePlaybackRegionProperties (juce::ARAPlaybackRegion*) override { triggerAsyncUpdate(); }
+    void handleAsyncUpdate() override { rebuildRegionIndex(); }
+
+    /** Stops listening to the regions and drops their readers. */
+    void releaseRegions();
+
+    /** The background thread every renderer's BufferingAudioReaders fill from. */
+    struct PrefetchThread  : public juce::TimeSliceThread
+    {
+        PrefetchThread()  : TimeSliceThread ("AutoTunes prefetch") { startThread(); }
+        ~PrefetchThread() override { stopThread (1000); }
+    };
+
+    /** Normal priority, unlike the analysis pool: a bounce is the user waiting.
+        Not in the host's audio workgroup either, as a bounce has no
+        deadline (see AutoTunesDocumentController's pool). */
+    struct OfflineWorkers  : public juce::ThreadPool
+    {
+        OfflineWorkers()
+            : ThreadPool (juce::ThreadPoolOptions{}.withThreadName ("AutoTunes bounce")
+                                                   .withNumberOfThreads (juce::jmax (1, juce::SystemStats::getNumCpus() - 1))) {}
+    };
+
+    static constexpr double kReadAheadSeconds   = 2.0;
+    static constexpr int    kOfflineSpanSamples = 8 * RenderCache::kChunkSize;   // ~5 s at 48 kHz
+    static constexpr int    kMinOfflineSlice    = 16384;                         // smaller isn't worth a worker
+    static constexpr int    kFadeTableSize      = 1024;
+
     double sampleRate = 44100.0;
     int maximumSamplesPerBlock = 4096;
     int numChannels = 1;
     bool useBufferedAudioSourceReader = true;
 
+    std::vector<std::unique_ptr<RegionReader>>     regionReaders;   // rebuilt in prepareToPlay()
+    juce::AudioBuffer<float>                       mixBuffer;       // a region overlapping one already rendered
+    juce::AudioBuffer<float>                       probeBuffer;     // one sample, for moving a read-ahead
+    std::array<float, kFadeTableSize + 1>          fadeTable {};    // sin over a quarter turn, 0 … 1
+    std::vector<float>                             fadeGains;       // one block's gains for a fade
+    juce::SharedResourcePointer<PrefetchThread>    prefetchThread;
+
+    // The audio thread's index; the message thread only hands over a new
+    // one, and takes back the one it replaced to free the next time round
+    std::unique_ptr<RegionIndex>            regionIndex;
+    RealtimeSafety::Checked<juce::SpinLock> regionIndexLock;
+    std::unique_ptr<RegionIndex>            pendingRegionIndex;    // guarded by regionIndexLock
+    std::unique_ptr<RegionIndex>            retiredRegionIndex;    // guarded by regionIndexLock
+    std::atomic<bool>                       hasPendingRegionIndex { false };
+
+    AutoTunesDocumentController*                   documentController = nullptr;
+    juce::SharedResourcePointer<OfflineWorkers>    offlineWorkers;
+    juce::AudioBuffer<float>                       offlineInput;     // source samples for a span
+    std::vector<std::vector<float>>                offlineWeights;   // per slice
+
+    PerfProbe perfProbe;
+    const int blockScope   { perfProbe.addScope ("block") };
+    const int regionsScope { perfProbe.addScope ("regions") };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoTunesPlaybackRenderer)
 };
@@ -20,11 +20,18 @@ AutoTunesAudioProcessorEditor::AutoTunesAudioProcessorEditor (AutoTunesAudioProc
    #if JucePlugin_Enable_ARA
     // ARA plugins must be resizable for proper view embedding
     setResizable (true, false);
+
+    if (auto* editorView = getARAEditorView())
+        if (auto* documentController = juce::ARADocumentControllerSpecialisation::getSpecialisedDocumentController<AutoTunesDocumentController> (editorView->getDocumentController()))
+        {
+            noteEditor = std::make_unique<NoteEditor> (*documentController);
+            addAndMakeVisible (*noteEditor);
+        }
    #endif
 
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (900, 500);
 }
 
 AutoTunesAudioProcessorEditor::~AutoTunesAudioProcessorEditor()
@@ -37,13 +44,16 @@ void AutoTunesAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
+    if (noteEditor != nullptr)
+        return;
+
     g.setColour (juce::Colours::white);
     g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.drawFittedText ("Open AutoTunes as an ARA extension to edit its notes.", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void AutoTunesAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    if (noteEditor != nullptr)
+        noteEditor->setBounds (getLocalBounds());
 }
@@ -10,9 +10,12 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "NoteEditor.h"
 
 //==============================================================================
 /**
+    Shows the document's notes in a NoteEditor when the host opens us as an
+    ARA editor view, and says so otherwise.
 */
 class AutoTunesAudioProcessorEditor  : public juce::AudioProcessorEditor
                             #if JucePlugin_Enable_ARA
@@ -32,5 +35,7 @@ private:
     // access the processor object that created it.
     AutoTunesAudioProcessor& audioProcessor;
 
+    std::unique_ptr<NoteEditor> noteEditor;   // null unless bound to an ARA document
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoTunesAudioProcessorEditor)
 };
@@ -9,6 +9,8 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS
+
 //==============================================================================
 AutoTunesAudioProcessor::AutoTunesAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -19,15 +21,34 @@ AutoTunesAudioProcessor::AutoTunesAudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       )
+                       ),
 #endif
+       parameters (*this, nullptr, "AutoTunes", createParameterLayout())
 {
+    amountParameter = parameters.getRawParameterValue ("amount");
+    retuneParameter = parameters.getRawParameterValue ("retune");
 }
 
 AutoTunesAudioProcessor::~AutoTunesAudioProcessor()
 {
 }
 
+juce::AudioProcessorValueTreeState::ParameterLayout AutoTunesAudioProcessor::createParameterLayout()
+{
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "amount", "Amount",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 1.0f));
+
+    // Skew factor 0.4 gives more resolution at the fast, robotic end
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "retune", "Retune Speed",
+        juce::NormalisableRange<float> (0.0f, 400.0f, 0.1f, 0.4f), RealtimeCorrector::kDefaultRetuneMs));
+
+    return { params.begin(), params.end() };
+}
+
 //==============================================================================
 const juce::String AutoTunesAudioProcessor::getName() const
 {
@@ -93,14 +114,38 @@ void AutoTunesAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void AutoTunesAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
+    // The trace rings are allocated here, not by the first traced block
+    // (nor by a host's scan, which never plays)
+    TraceRecorder::getInstance();
+
+   #if JucePlugin_Enable_ARA
+    // Bound to ARA, the playback renderer plays the regions from here on
+    prepareToPlayForARA (sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), getProcessingPrecision());
+   #else
+    juce::ignoreUnused (samplesPerBlock);
+   #endif
+
+    corrector.prepare (sampleRate, getTotalNumInputChannels());
+    perfProbe.prepare (sampleRate);
+    perfProbe.reset();
+    qualityGovernor.prepare (sampleRate);
+
+    // The renderer reads the regions at their own positions, so only the
+    // live path delays anything
+    auto live = true;
+
+   #if JucePlugin_Enable_ARA
+    live = ! isBoundToARA();
+   #endif
+
+    setLatencySamples (live ? corrector.getLatencySamples() : 0);
 }
 
 void AutoTunesAudioProcessor::releaseResources()
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+   #if JucePlugin_Enable_ARA
+    releaseResourcesForARA();
+   #endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -131,31 +176,40 @@ bool AutoTunesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 
 void AutoTunesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    REALTIME_SAFETY_AUDIO_THREAD ("AutoTunes processBlock");
+    TRACE_SCOPE ("AutoTunes processBlock");
     juce::ScopedNoDenormals noDenormals;
+
+   #if JucePlugin_Enable_ARA
+    if (isBoundToARA())
+    {
+        if (! processBlockForARA (buffer, isRealtime(), getPlayHead()))
+            processBlockBypassed (buffer, midiMessages);
+
+        return;
+    }
+   #endif
+
+    const PerfProbe::Scope blockTimer (perfProbe, blockScope, buffer.getNumSamples());
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
+    // Outputs with no input may hold garbage
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer (channel);
+    PitchCorrection correction;
+    correction.amount    = amountParameter->load (std::memory_order_relaxed);
+    correction.scaleMask = 0x0fff;   // chromatic; a scale needs the ARA editor for now
 
-        // ..do something to the data...
-    }
+    corrector.setCorrection (correction);
+    corrector.setRetuneTime (retuneParameter->load (std::memory_order_relaxed));
+
+    // Fewer detections while the last blocks ran close to their deadline
+    const auto level = isNonRealtime() ? 0 : qualityGovernor.update (perfProbe, blockScope, buffer.getNumSamples());
+    corrector.setDetectionSpacing (kDetectionSpacings[level]);
+    corrector.process (buffer, totalNumInputChannels);
 }
 
 //==============================================================================
@@ -172,15 +226,16 @@ juce::AudioProcessorEditor* AutoTunesAudioProcessor::createEditor()
 //==============================================================================
 void AutoTunesAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // The notes and corrections an ARA host edits live in its document, not here
+    if (const auto xml = parameters.copyState().createXml())
+        copyXmlToBinary (*xml, destData);
 }
 
 void AutoTunesAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    if (const auto xml = getXmlFromBinary (data, sizeInBytes))
+        if (xml->hasTagName (parameters.state.getType()))
+            parameters.replaceState (juce::ValueTree::fromXml (*xml));
 }
 
 //==============================================================================
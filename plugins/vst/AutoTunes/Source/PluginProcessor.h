@@ -9,6 +9,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "RealtimeCorrector.h"
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/QualityGovernor.h"
+#include "../../Shared/RealtimeSafety.h"
+#include "../../Shared/TraceEvents.h"
 
 //==============================================================================
 /**
@@ -56,7 +61,38 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    juce::AudioProcessorValueTreeState& getParameters() noexcept { return parameters; }
+
+    /** CPU load of the live path ("block"); ARA playback has its own, on
+        the renderer.  Safe to read from any thread. */
+    const PerfProbe& getPerfProbe() const noexcept { return perfProbe; }
+
+    /** Spaces the live path's detections out (every 4 hops, then 8) while
+        its blocks run close to their deadline, and logs each change.  On
+        by default; offline blocks are never governed. */
+    QualityGovernor& getQualityGovernor() noexcept { return qualityGovernor; }
+
 private:
     //==============================================================================
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    juce::AudioProcessorValueTreeState parameters;
+    std::atomic<float>*                amountParameter = nullptr;
+    std::atomic<float>*                retuneParameter = nullptr;
+
+    // Corrects the live input when no ARA host is driving the plug-in
+    RealtimeCorrector corrector;
+
+    static constexpr int kDetectionSpacings[] { 1, 4, 8 };   // per governor level
+
+    PerfProbe       perfProbe;
+    const int       blockScope      { perfProbe.addScope ("block") };
+    QualityGovernor qualityGovernor { "AutoTunes", (int) std::size (kDetectionSpacings) };
+
+   #if REALTIME_SAFETY_CHECKS
+    RealtimeSafety::ViolationReporter realtimeSafetyReporter;   // the ARA renderers' too
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoTunesAudioProcessor)
 };
@@ -0,0 +1,461 @@
+/*
+  ==============================================================================
+    PsolaPlan.cpp  –  PsolaPlan implementation
+  ==============================================================================
+*/
+
+#include "PsolaPlan.h"
+#include <algorithm>
+#include <cmath>
+
+//==============================================================================
+PsolaPlan::PsolaPlan (const PitchAnalysis& analysis, const PitchCorrection& correction, const NoteEdits& edits,
+                      Stretch stretchIn)
+    : stretch (stretchIn),
+      numSamples (stretchIn.isStretched() ? stretchIn.numOutputSamples : analysis.numSamples),
+      numSourceSamples (analysis.numSamples),
+      envelopeOrder (analysis.hasEnvelopes() ? analysis.envelopeOrder : 0)
+{
+    const auto& points     = analysis.points;
+    const auto  numFrames  = (juce::int64) points.size();
+    const auto  hop        = analysis.hop;
+    const auto  sampleRate = analysis.sampleRate;
+
+    // Output and source positions; the same numbers when unstretched
+    const auto toSource = [this] (double output) { return (double) stretch.sourceStart + output * stretch.ratio; };
+    const auto toOutput = [this] (double source) { return (source - (double) stretch.sourceStart) / stretch.ratio; };
+
+    // A frame's pitch belongs to the middle of its window
+    const auto frameCentre = [&] (juce::int64 frame) { return frame * hop + analysis.analysisSize / 2; };
+
+    /** A per-frame value at a source sample, interpolated between voiced frames. */
+    const auto interpolate = [&] (auto&& valueOf, double position, juce::int64 firstFrame, juce::int64 lastFrame)
+    {
+        const auto exact = (position - analysis.analysisSize / 2) / hop;
+        const auto frame = juce::jlimit (firstFrame, lastFrame, (juce::int64) std::floor (exact));
+        const auto next  = juce::jmin (frame + 1, lastFrame);
+        const auto t     = (float) juce::jlimit (0.0, 1.0, exact - (double) frame);
+        return valueOf (frame) + t * (valueOf (next) - valueOf (frame));
+    };
+
+    const auto pitchAt = [&] (double position, juce::int64 firstFrame, juce::int64 lastFrame)
+    {
+        return interpolate ([&] (juce::int64 f) { return points[(size_t) f].pitchHz; }, position, firstFrame, lastFrame);
+    };
+
+    //==============================================================================
+    // Edits in samples, by start, each with the mean pitch of its note
+    struct SampleEdit
+    {
+        juce::int64 start, end;
+        NoteEdit    edit;
+        float       meanMidi;
+        float       formantRatio;
+    };
+
+    std::vector<SampleEdit> sampleEdits;
+    std::vector<float>      slowMidi;   // per voiced frame, only with edits
+
+    if (! edits.isEmpty())
+    {
+        for (const auto& edit : edits.getAll())
+        {
+            const auto start = (juce::int64) std::llround (edit.start * sampleRate);
+            const auto end   = (juce::int64) std::llround (edit.end * sampleRate);
+
+            double sum = 0.0;
+            int    numVoiced = 0;
+
+            for (auto frame = juce::jmax ((juce::int64) 0, (start - analysis.analysisSize / 2) / hop);
+                 frame < numFrames && frameCentre (frame) < end; ++frame)
+            {
+                if (frameCentre (frame) >= start && points[(size_t) frame].pitchHz > 0.0f)
+                {
+                    sum += PitchCorrection::hzToMidi (points[(size_t) frame].pitchHz);
+                    ++numVoiced;
+                }
+            }
+
+            sampleEdits.push_back ({ start, end, edit,
+                                     numVoiced > 0 ? (float) (sum / numVoiced) : edit.targetMidi,
+                                     std::exp2 (edit.formant / 12.0f) });
+        }
+
+        // Each voiced frame's pitch averaged over kDriftSeconds of its own
+        // voiced stretch, from prefix sums
+        const auto halfWindow = juce::jmax ((juce::int64) 1, (juce::int64) std::llround (kDriftSeconds * sampleRate / hop / 2.0));
+
+        slowMidi.assign ((size_t) numFrames, 0.0f);
+        std::vector<double> sums ((size_t) numFrames + 1, 0.0);
+
+        for (juce::int64 frame = 0; frame < numFrames; ++frame)
+            sums[(size_t) frame + 1] = sums[(size_t) frame]
+                                     + (points[(size_t) frame].pitchHz > 0.0f ? PitchCorrection::hzToMidi (points[(size_t) frame].pitchHz) : 0.0);
+
+        for (juce::int64 frame = 0; frame < numFrames; ++frame)
+        {
+            if (points[(size_t) frame].pitchHz <= 0.0f)
+                continue;
+
+            auto last = frame;
+            while (last + 1 < numFrames && points[(size_t) (last + 1)].pitchHz > 0.0f)
+                ++last;
+
+            for (auto f = frame; f <= last; ++f)
+            {
+                const auto lo = juce::jmax (frame, f - halfWindow);
+                const auto hi = juce::jmin (last, f + halfWindow);
+                slowMidi[(size_t) f] = (float) ((sums[(size_t) hi + 1] - sums[(size_t) lo]) / (double) (hi - lo + 1));
+            }
+
+            frame = last;
+        }
+    }
+
+    // Synthesis marks only move forward, so the edit they're in is tracked
+    // with a cursor
+    size_t nextEdit = 0;
+
+    const auto editAt = [&] (double position) -> const SampleEdit*
+    {
+        while (nextEdit < sampleEdits.size() && (double) sampleEdits[nextEdit].end <= position)
+            ++nextEdit;
+
+        return nextEdit < sampleEdits.size() && (double) sampleEdits[nextEdit].start <= position ? &sampleEdits[nextEdit] : nullptr;
+    };
+
+    // Consecutive grains mostly share an envelope, so it's copied once for them
+    const float* lastEnvelope    = nullptr;
+    int          maxReshapedHalf = 0;
+
+    const auto envelopeAt = [&] (double position)
+    {
+        const auto* coefficients = analysis.getEnvelopeAt (position);
+
+        if (coefficients != lastEnvelope)
+        {
+            envelopes.insert (envelopes.end(), coefficients, coefficients + envelopeOrder);
+            lastEnvelope = coefficients;
+        }
+
+        return (int) (envelopes.size() / (size_t) envelopeOrder) - 1;
+    };
+
+    //==============================================================================
+    const auto addUnvoiced = [&] (juce::int64 start, juce::int64 end)
+    {
+        for (auto centre = start; centre < end; centre += kUnvoicedHalfLength)
+            grains.push_back ({ centre, (juce::int64) std::llround (toSource ((double) centre)), kUnvoicedHalfLength, 1.0f });
+    };
+
+    juce::int64 covered = 0;   // output planned so far
+
+    for (juce::int64 frame = 0; frame < numFrames; ++frame)
+    {
+        if (points[(size_t) frame].pitchHz <= 0.0f)
+            continue;
+
+        auto lastFrame = frame;
+        while (lastFrame + 1 < numFrames && points[(size_t) (lastFrame + 1)].pitchHz > 0.0f)
+            ++lastFrame;
+
+        const auto voicedStart = juce::jmax (covered, (juce::int64) std::ceil (toOutput ((double) (frameCentre (frame) - hop / 2))));
+        const auto voicedEnd   = juce::jmin (numSamples, (juce::int64) std::ceil (toOutput ((double) (frameCentre (lastFrame) + hop / 2))));
+
+        // A stretch only plans the runs it covers
+        if (voicedStart >= numSamples)
+            break;
+
+        if (voicedEnd <= covered)
+        {
+            frame = lastFrame;
+            continue;
+        }
+
+        addUnvoiced (covered, voicedStart);
+        voicedRuns.push_back ({ voicedStart, juce::jmax (voicedStart, voicedEnd) });
+
+        // Synthesis marks at the corrected period; each grain is cut at the
+        // analysis mark (spaced at the detected period) nearest where its
+        // mark falls in the source
+        double synthesis = (double) voicedStart;
+        double analysisMark = toSource (synthesis);
+
+        while (synthesis < (double) voicedEnd)
+        {
+            const auto periodAt = [&] (double position) { return sampleRate / pitchAt (position, frame, lastFrame); };
+            const auto target   = toSource (synthesis);
+
+            for (auto next = analysisMark + periodAt (analysisMark);
+                 std::abs (next - target) < std::abs (analysisMark - target);
+                 next = analysisMark + periodAt (analysisMark))
+                analysisMark = next;
+
+            const auto hz           = pitchAt (target, frame, lastFrame);
+            auto       shift        = correction.getShiftSemitones (hz);
+            auto       formantRatio = 1.0f;
+
+            // An edited note: its mean onto the target, drift and vibrato scaled around it
+            if (const auto* edited = editAt (target))
+            {
+                const auto midi = PitchCorrection::hzToMidi (hz);
+                const auto slow = interpolate ([&] (juce::int64 f) { return slowMidi[(size_t) f]; }, target, frame, lastFrame);
+
+                shift = edited->edit.targetMidi
+                      + edited->edit.drift   * (slow - edited->meanMidi)
+                      + edited->edit.vibrato * (midi - slow)
+                      - midi;
+                formantRatio = edited->formantRatio;
+            }
+
+            const auto period   = sampleRate / (hz * std::exp2 (shift / 12.0f));
+            const auto half     = juce::jmax (16, juce::roundToInt (periodAt (analysisMark)));
+            const auto envelope = formantRatio != 1.0f && envelopeOrder > 0 ? envelopeAt (analysisMark) : -1;
+
+            grains.push_back ({ (juce::int64) std::llround (synthesis), (juce::int64) std::llround (analysisMark), half, formantRatio, envelope });
+            maxHalfLength = juce::jmax (maxHalfLength, getOutputReach (grains.back()));
+            synthesis += period;
+
+            if (envelope >= 0)
+                maxReshapedHalf = juce::jmax (maxReshapedHalf, half);
+        }
+
+        covered = voicedEnd;
+        frame   = lastFrame;
+    }
+
+    addUnvoiced (covered, numSamples);
+
+    // Room for the longest grain and its ringing either side, so nothing wraps
+    if (! envelopes.empty())
+        reshapeFft = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 (juce::nextPowerOfTwo (2 * (maxReshapedHalf + envelopeOrder)))));
+}
+
+size_t PsolaPlan::firstGrainFor (juce::int64 outputStart) const noexcept
+{
+    const auto it = std::lower_bound (grains.begin(), grains.end(), outputStart - maxHalfLength,
+                                      [] (const Grain& g, juce::int64 position) { return g.synthesisCentre < position; });
+    return (size_t) (it - grains.begin());
+}
+
+juce::Range<juce::int64> PsolaPlan::getInputRange (juce::int64 outputStart, int numOutput) const noexcept
+{
+    const auto outputEnd = outputStart + numOutput;
+    auto start = (juce::int64) std::floor ((double) stretch.sourceStart + (double) outputStart * stretch.ratio);
+    auto end   = (juce::int64) std::ceil  ((double) stretch.sourceStart + (double) outputEnd   * stretch.ratio);
+
+    for (auto i = firstGrainFor (outputStart); i < grains.size() && grains[i].synthesisCentre - maxHalfLength < outputEnd; ++i)
+    {
+        const auto& g = grains[i];
+
+        if (g.synthesisCentre + getOutputReach (g) <= outputStart || g.synthesisCentre - getOutputReach (g) >= outputEnd)
+            continue;
+
+        start = juce::jmin (start, g.analysisCentre - getInputReach (g));
+        end   = juce::jmax (end,   g.analysisCentre + getInputReach (g));
+    }
+
+    return { juce::jmax ((juce::int64) 0, start), juce::jmin (numSourceSamples, end) };
+}
+
+juce::uint64 PsolaPlan::getGrainHash (juce::int64 outputStart, int numOutput) const noexcept
+{
+    const auto outputEnd = outputStart + numOutput;
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+
+    const auto mix = [&hash] (juce::uint64 value)
+    {
+        hash = (hash ^ value) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    };
+
+    for (auto i = firstGrainFor (outputStart); i < grains.size() && grains[i].synthesisCentre - maxHalfLength < outputEnd; ++i)
+    {
+        const auto& g = grains[i];
+
+        if (g.synthesisCentre + getOutputReach (g) <= outputStart || g.synthesisCentre - getOutputReach (g) >= outputEnd)
+            continue;
+
+        mix ((juce::uint64) g.synthesisCentre);
+        mix ((juce::uint64) g.analysisCentre);
+        mix ((juce::uint64) g.halfLength);
+        mix ((juce::uint64) juce::roundToInt (g.formantRatio * 65536.0f));
+        mix ((juce::uint64) (g.envelope >= 0));
+    }
+
+    return hash;
+}
+
+juce::Range<juce::int64> PsolaPlan::getAffectedRange (juce::Range<juce::int64> samples) const noexcept
+{
+    // Into output samples first
+    const auto first = (juce::int64) std::floor (((double) samples.getStart() - (double) stretch.sourceStart) / stretch.ratio);
+    const auto last  = (juce::int64) std::ceil  (((double) samples.getEnd()   - (double) stretch.sourceStart) / stretch.ratio);
+
+    auto end = last;
+
+    auto it = std::lower_bound (voicedRuns.begin(), voicedRuns.end(), first,
+                                [] (const juce::Range<juce::int64>& run, juce::int64 position) { return run.getEnd() <= position; });
+
+    for (; it != voicedRuns.end() && it->getStart() < last; ++it)
+        end = juce::jmax (end, it->getEnd());
+
+    return { juce::jmax ((juce::int64) 0, first - maxHalfLength),
+             juce::jmin (numSamples, end + maxHalfLength) };
+}
+
+void PsolaPlan::render (const juce::AudioBuffer<float>& input, juce::int64 inputStart,
+                        juce::AudioBuffer<float>& output, juce::int64 outputStart, int numOutput,
+                        std::vector<float>& weights) const noexcept
+{
+    const auto numChannels = juce::jmin (input.getNumChannels(), output.getNumChannels());
+    const auto outputEnd   = outputStart + numOutput;
+    const auto inputEnd    = inputStart + input.getNumSamples();
+    const auto inputs      = input.getArrayOfReadPointers();
+    const auto outputs     = output.getArrayOfWritePointers();
+
+    output.clear (0, numOutput);
+    std::fill (weights.begin(), weights.begin() + numOutput, 0.0f);
+
+    std::vector<float> reshapeScratch;   // only for a span with a reshaped grain
+
+    for (auto i = firstGrainFor (outputStart); i < grains.size() && grains[i].synthesisCentre - maxHalfLength < outputEnd; ++i)
+    {
+        const auto& g = grains[i];
+
+        if (g.envelope >= 0)
+        {
+            if (reshapeScratch.empty())
+                reshapeScratch.resize (getReshapeScratchSize());
+
+            renderReshaped (g, input, inputStart, output, outputStart, numOutput, weights, reshapeScratch.data());
+            continue;
+        }
+
+        // Only the part of the grain inside both the output span and the source
+        const auto first = juce::jmax ((juce::int64) -g.halfLength, outputStart - g.synthesisCentre,
+                                       inputStart - g.analysisCentre);
+        const auto last  = juce::jmin ((juce::int64) g.halfLength, outputEnd - g.synthesisCentre,
+                                       inputEnd - g.analysisCentre);
+
+        const auto scale = juce::MathConstants<float>::pi / (float) g.halfLength;
+
+        if (g.formantRatio == 1.0f)
+        {
+            for (auto n = first; n < last; ++n)
+            {
+                const auto w   = 0.5f + 0.5f * std::cos ((float) n * scale);
+                const auto out = (int) (g.synthesisCentre + n - outputStart);
+                const auto in  = (int) (g.analysisCentre + n - inputStart);
+
+                for (int c = 0; c < numChannels; ++c)
+                    outputs[c][out] += w * inputs[c][in];
+
+                weights[(size_t) out] += w;
+            }
+
+            continue;
+        }
+
+        // Formant shift: the grain read at formantRatio input samples per
+        // output sample, between samples, and kept where both neighbours are
+        const auto ratio  = (double) g.formantRatio;
+        const auto offset = (double) (g.analysisCentre - inputStart);
+        const auto from   = juce::jmax ((juce::int64) -g.halfLength, outputStart - g.synthesisCentre,
+                                        (juce::int64) std::ceil (-offset / ratio));
+        const auto to     = juce::jmin ((juce::int64) g.halfLength, outputEnd - g.synthesisCentre,
+                                        (juce::int64) std::floor (((double) input.getNumSamples() - 2.0 - offset) / ratio) + 1);
+
+        for (auto n = from; n < to; ++n)
+        {
+            const auto w     = 0.5f + 0.5f * std::cos ((float) n * scale);
+            const auto out   = (int) (g.synthesisCentre + n - outputStart);
+            const auto exact = offset + (double) n * ratio;
+            const auto in    = (int) exact;
+            const auto t     = (float) (exact - (double) in);
+
+            for (int c = 0; c < numChannels; ++c)
+                outputs[c][out] += w * (inputs[c][in] + t * (inputs[c][in + 1] - inputs[c][in]));
+
+            weights[(size_t) out] += w;
+        }
+    }
+
+    // The window sum is 1 in place and near it elsewhere; dividing it out
+    // keeps the level steady where grains bunch up or spread
+    for (int c = 0; c < numChannels; ++c)
+        for (int i = 0; i < numOutput; ++i)
+            outputs[c][i] /= juce::jmax (kMinWeight, weights[(size_t) i]);
+}
+
+void PsolaPlan::renderReshaped (const Grain& g, const juce::AudioBuffer<float>& input, juce::int64 inputStart,
+                                juce::AudioBuffer<float>& output, juce::int64 outputStart, int numOutput,
+                                std::vector<float>& weights, float* scratch) const noexcept
+{
+    const auto& fft     = *reshapeFft;
+    const auto  size    = fft.getSize();
+    const auto  numBins = size / 2 + 1;
+    const auto  half    = g.halfLength;
+    const auto  pad     = envelopeOrder;   // the filter rings about this far either side
+    const auto  scale   = juce::MathConstants<float>::pi / (float) half;
+
+    auto* gains  = scratch;
+    auto* buffer = scratch + numBins;
+
+    // The filter, zero phase: the envelope moved up by formantRatio over
+    // the envelope as it is, bin by bin
+    SpectralEnvelope::evaluate (envelopes.data() + (size_t) g.envelope * (size_t) envelopeOrder, envelopeOrder, fft, gains, buffer);
+    std::copy (gains, gains + numBins, buffer);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const auto from  = juce::jmin ((float) (numBins - 1), (float) k / g.formantRatio);
+        const auto bin   = (int) from;
+        const auto next  = juce::jmin (bin + 1, numBins - 1);
+        const auto moved = buffer[bin] + (from - (float) bin) * (buffer[next] - buffer[bin]);
+
+        gains[k] = std::exp (juce::jlimit (-kMaxReshape, kMaxReshape, moved - buffer[k]));
+    }
+
+    const auto inputEnd  = inputStart + input.getNumSamples();
+    const auto firstOut  = g.synthesisCentre - half - pad - outputStart;   // where buffer[0] goes
+    const auto numKept   = 2 * (half + pad);
+
+    for (int c = 0; c < juce::jmin (input.getNumChannels(), output.getNumChannels()); ++c)
+    {
+        const auto* in  = input.getReadPointer (c);
+        auto*       out = output.getWritePointer (c);
+
+        std::fill (buffer, buffer + 2 * size, 0.0f);
+
+        for (int n = -half; n < half; ++n)
+        {
+            const auto position = g.analysisCentre + n;
+
+            if (position >= inputStart && position < inputEnd)
+                buffer[pad + half + n] = (0.5f + 0.5f * std::cos ((float) n * scale)) * in[position - inputStart];
+        }
+
+        fft.performRealOnlyForwardTransform (buffer, true);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            buffer[2 * k]     *= gains[k];
+            buffer[2 * k + 1] *= gains[k];
+        }
+
+        fft.performRealOnlyInverseTransform (buffer);
+
+        for (auto j = juce::jmax ((juce::int64) 0, -firstOut); j < numKept && firstOut + j < numOutput; ++j)
+            out[firstOut + j] += buffer[j];
+    }
+
+    // Weighted as the window it was cut with, as any other grain
+    for (int n = -half; n < half; ++n)
+    {
+        const auto position = g.synthesisCentre + n - outputStart;
+
+        if (position >= 0 && position < numOutput)
+            weights[(size_t) position] += 0.5f + 0.5f * std::cos ((float) n * scale);
+    }
+}
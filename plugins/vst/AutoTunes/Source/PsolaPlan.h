@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+    PsolaPlan.h  –  Offline TD-PSOLA pitch correction for a whole source
+
+    Built once from an audio source's PitchAnalysis and the correction
+    wanted, the plan lists every grain of the corrected output: where it
+    goes (the synthesis mark), where in the source it's cut from (the
+    analysis mark) and how long it is.  Voiced stretches get two-period
+    Hann grains, their synthesis marks spaced at the corrected period and
+    each taking the nearest analysis mark, so the source's duration is
+    kept; unvoiced stretches get fixed grains played in place.
+
+    Because the plan fixes every grain up front, any range of the output
+    can be rendered on its own and comes out sample-identical to rendering
+    it all at once: the render cache fills chunk by chunk, in any order.
+
+    Inside an edited note (see NoteEdits) the edit decides the pitch
+    instead of the correction: the note's mean moves to the target, and
+    its drift (the pitch smoothed over kDriftSeconds) and vibrato (what's
+    left) are scaled around it.  A formant shift moves the spectral
+    envelope by its ratio while the period, set by the grain spacing,
+    stays put: each grain is played as cut, through a filter that turns
+    the analysis's cached envelope nearest it (see SpectralEnvelope) into
+    that envelope moved, so the formants move and nothing else does.  An
+    analysis without envelopes reads the note's grains faster or slower
+    than they play instead, which smears the harmonics at large shifts.
+    Plain correction needs neither: a grain keeps the envelope of where
+    it was cut, whatever its spacing.
+
+    A plan can also time-stretch part of the source (see Stretch): its
+    synthesis marks are laid out in the stretched output and each takes the
+    analysis mark nearest where that output falls in the source, so grains
+    are repeated or skipped to fit the length and the pitch is kept.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "PitchAnalysis.h"
+#include "PitchCorrection.h"
+#include "NoteEdits.h"
+#include "SpectralEnvelope.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+class PsolaPlan
+{
+public:
+    static constexpr double kDriftSeconds = 0.15;   // slower than this is drift, faster is vibrato
+
+    /** Which source samples the output is made from: output sample n from
+        around source sample sourceStart + n * ratio.  The default is the
+        whole source as it is. */
+    struct Stretch
+    {
+        juce::int64 sourceStart      = 0;
+        juce::int64 numOutputSamples = -1;    // -1: the source's length, unstretched
+        double      ratio            = 1.0;   // source samples per output sample
+
+        bool isStretched() const noexcept { return numOutputSamples >= 0; }
+
+        bool operator== (const Stretch& other) const noexcept
+        {
+            return sourceStart == other.sourceStart && numOutputSamples == other.numOutputSamples && ratio == other.ratio;
+        }
+
+        bool operator!= (const Stretch& other) const noexcept { return ! operator== (other); }
+    };
+
+    PsolaPlan (const PitchAnalysis& analysis, const PitchCorrection& correction, const NoteEdits& edits = {},
+               Stretch stretch = {});
+
+    /** The output's length: the source's, unless it's stretched. */
+    juce::int64 getNumSamples() const noexcept { return numSamples; }
+
+    /** The source samples that rendering [outputStart, outputStart + numOutput)
+        reads, clipped to the source. */
+    juce::Range<juce::int64> getInputRange (juce::int64 outputStart, int numOutput) const noexcept;
+
+    /** A hash of every grain that renders into [outputStart, outputStart +
+        numOutput): equal for two plans means that span comes out the same
+        from the same input. */
+    juce::uint64 getGrainHash (juce::int64 outputStart, int numOutput) const noexcept;
+
+    /** The output that can change when the pitch inside samples (of the
+        source) does: on to the end of every voiced stretch it touches (each
+        mark there follows the ones before), and a grain's reach either side. */
+    juce::Range<juce::int64> getAffectedRange (juce::Range<juce::int64> samples) const noexcept;
+
+    /**
+     * Renders output [outputStart, outputStart + numOutput) into `output`,
+     * from `input`, which holds the source from inputStart on and must cover
+     * getInputRange() for the same span.  `weights` is numOutput samples of
+     * scratch.
+     */
+    void render (const juce::AudioBuffer<float>& input, juce::int64 inputStart,
+                 juce::AudioBuffer<float>& output, juce::int64 outputStart, int numOutput,
+                 std::vector<float>& weights) const noexcept;
+
+private:
+    struct Grain
+    {
+        juce::int64 synthesisCentre;
+        juce::int64 analysisCentre;
+        int         halfLength;
+        float       formantRatio;   // input samples read per output sample
+        int         envelope = -1;  // into envelopes, if the shift reshapes the grain rather than reading it faster
+    };
+
+    /** How far either side of its analysis mark a grain reads. */
+    static int getInputReach (const Grain& g) noexcept
+    {
+        return g.envelope >= 0 ? g.halfLength + 1 : (int) std::ceil ((float) g.halfLength * g.formantRatio) + 1;
+    }
+
+    /** How far either side of its synthesis mark a grain writes: a reshaped
+        one rings on for about the filter's length. */
+    int getOutputReach (const Grain& g) const noexcept { return g.halfLength + (g.envelope >= 0 ? envelopeOrder : 0); }
+
+    /** render() for a grain with an envelope; scratch is getReshapeScratchSize() floats. */
+    void renderReshaped (const Grain& g, const juce::AudioBuffer<float>& input, juce::int64 inputStart,
+                         juce::AudioBuffer<float>& output, juce::int64 outputStart, int numOutput,
+                         std::vector<float>& weights, float* scratch) const noexcept;
+
+    size_t getReshapeScratchSize() const noexcept { return (size_t) (reshapeFft->getSize() / 2 + 1 + 2 * reshapeFft->getSize()); }
+
+    /** Index of the first grain that can reach outputStart. */
+    size_t firstGrainFor (juce::int64 outputStart) const noexcept;
+
+    static constexpr int   kUnvoicedHalfLength = 256;
+    static constexpr float kMinWeight          = 0.25f;   // where grains barely overlap, don't boost the gap
+    static constexpr float kMaxReshape         = 2.3f;    // nepers either way, ~20 dB, so a deep valley isn't boosted into noise
+
+    std::vector<Grain>                    grains;       // by synthesis mark
+    std::vector<juce::Range<juce::int64>> voicedRuns;   // in order, in output samples
+    Stretch                               stretch;
+    juce::int64                           numSamples       = 0;   // output
+    juce::int64                           numSourceSamples = 0;
+    int                                   maxHalfLength = kUnvoicedHalfLength;   // or output reach, if longer
+
+    // The envelopes reshaped grains use, envelopeOrder coefficients each,
+    // and one transform size for all of them
+    std::vector<float>              envelopes;
+    int                             envelopeOrder = 0;
+    std::unique_ptr<juce::dsp::FFT> reshapeFft;
+};
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+    RealtimeCorrector.cpp  –  RealtimeCorrector implementation
+  ==============================================================================
+*/
+
+#include "RealtimeCorrector.h"
+#include <cmath>
+
+//==============================================================================
+void RealtimeCorrector::prepare (double newSampleRate, int numChannels)
+{
+    sampleRate   = newSampleRate;
+    analysisSize = PitchDetector::analysisSizeFor (sampleRate, kMinFrequencyHz);
+    hop          = analysisSize / kHopsPerWindow;   // a quarter of the half-window: the incremental update's limit
+
+    PitchDetector::Settings settings;
+    settings.analysisSize = analysisSize;
+    settings.tracking     = true;   // a sung line rarely jumps; this also stops octave flips retuning it
+    detector.applySettings (settings);
+
+    history.assign ((size_t) (2 * analysisSize), 0.0f);
+
+    latency   = juce::jmax (16, juce::roundToInt (kLatencySeconds * sampleRate));
+    maxWindow = 2.0 * (latency - 2);
+
+    const auto lineSize = juce::nextPowerOfTwo (2 * latency + 8);
+    delayLines.setSize (juce::jmax (1, numChannels), lineSize);
+    delayMask = lineSize - 1;
+
+    setRetuneTime (retuneMs);
+    reset();
+}
+
+void RealtimeCorrector::reset() noexcept
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    historyPos   = 0;
+    samplesToHop = hop;
+    detectedHz   = 0.0f;
+    detector.resetTracking();
+
+    delayLines.clear();
+    writePos = 0;
+
+    targetShift  = 0.0f;
+    shift        = 0.0f;
+    targetWindow = latency;
+    window       = latency;
+    phase        = 0.0;
+}
+
+void RealtimeCorrector::setRetuneTime (float milliseconds) noexcept
+{
+    retuneMs          = milliseconds;
+    retuneCoefficient = milliseconds <= 0.0f ? 1.0f
+                                             : 1.0f - (float) std::exp (-1000.0 / (milliseconds * sampleRate));
+}
+
+//==============================================================================
+void RealtimeCorrector::updateTarget (float hz) noexcept
+{
+    detectedHz = hz;
+
+    // Unvoiced: glide back to no shift, keeping the window
+    if (hz <= 0.0f)
+    {
+        targetShift = 0.0f;
+        return;
+    }
+
+    targetShift = correction.getShiftSemitones (hz);
+
+    // Two periods put the taps a period apart, in phase where they cross.
+    // A voice too low for that gets the longest window there is: the taps
+    // come a little under a period apart, still close to in phase, where
+    // one period would put them half a period apart and cancel
+    targetWindow = juce::jmin (2.0 * sampleRate / hz, maxWindow);
+}
+
+float RealtimeCorrector::readDelayed (const float* line, double delay) const noexcept
+{
+    const auto position = (double) writePos - delay;
+    const auto base     = (int) std::floor (position);
+    const auto t        = (float) (position - base);
+
+    const auto xm1 = line[(base - 1) & delayMask];
+    const auto x0  = line[base & delayMask];
+    const auto x1  = line[(base + 1) & delayMask];
+    const auto x2  = line[(base + 2) & delayMask];
+
+    const auto c1 = 0.5f * (x1 - xm1);
+    const auto c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    const auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+    return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+void RealtimeCorrector::process (juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+    numChannels = juce::jmin (numChannels, buffer.getNumChannels(), delayLines.getNumChannels());
+
+    if (numChannels <= 0 || analysisSize == 0)
+        return;
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto channels   = buffer.getArrayOfWritePointers();
+    const auto lines      = delayLines.getArrayOfWritePointers();
+    const auto monoScale  = 1.0f / (float) numChannels;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto mono = 0.0f;
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            lines[c][writePos] = channels[c][i];
+            mono += channels[c][i];
+        }
+
+        history[(size_t) historyPos] = history[(size_t) (historyPos + analysisSize)] = mono * monoScale;
+
+        if (++historyPos == analysisSize)
+            historyPos = 0;
+
+        // The window is the last analysisSize samples, oldest first
+        if (--samplesToHop == 0)
+        {
+            samplesToHop = hop * detectionSpacing;
+            updateTarget (detector.detectPitchOverlapped (history.data() + historyPos, analysisSize, samplesToHop, sampleRate));
+        }
+
+        shift += (targetShift - shift) * retuneCoefficient;
+        const auto ratio = std::exp2 ((double) shift / 12.0);
+
+        // Reading at ratio while writing at 1 grows the delay by 1 - ratio a
+        // sample.  A window change waits for a tap to reach the end of its
+        // window, where it's silent and the other tap is mid-window, at the
+        // nominal delay whatever the window
+        const auto before = phase;
+        phase += (1.0 - ratio) / window;
+
+        if (std::floor (phase * 2.0) != std::floor (before * 2.0))
+            window = targetWindow;
+
+        phase -= std::floor (phase);
+
+        const auto phaseB = phase < 0.5 ? phase + 0.5 : phase - 0.5;
+        const auto delayA = latency + (phase  - 0.5) * window;
+        const auto delayB = latency + (phaseB - 0.5) * window;
+
+        const auto s     = (float) std::sin (juce::MathConstants<double>::pi * phase);
+        const auto gainA = s * s;
+        const auto gainB = 1.0f - gainA;
+
+        for (int c = 0; c < numChannels; ++c)
+            channels[c][i] = gainA * readDelayed (lines[c], delayA) + gainB * readDelayed (lines[c], delayB);
+
+        writePos = (writePos + 1) & delayMask;
+    }
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+    RealtimeCorrector.h  –  Live pitch correction for hosts without ARA
+
+    Two parts, both running sample by sample on the audio thread so the
+    host's block size doesn't matter (64 samples is as cheap per sample as
+    1024):
+
+      • Detection: PFix's PitchDetector on a short window (1024 samples at
+        44.1 / 48 kHz, down to ~95 Hz), slid forward every hop with
+        detectPitchOverlapped(), over a mono mix of the input.
+
+      • Shifting: a delay line read by two taps half a window apart, each
+        faded in and out with sin², moving at the correction ratio.  The
+        window is two periods of the detected pitch (as near as fits, for
+        voices below ~110 Hz), so the taps stay in phase where they cross,
+        and a new window is only taken when one tap is silent and the other
+        sits exactly at the nominal delay: changing it never clicks.
+
+    The nominal delay is the reported latency, 9 ms.  The detector's window
+    is centred about as far back, so the pitch the shift is steered by is
+    the pitch of the audio being shifted.
+
+    No allocation, locks or virtual calls after prepare().
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../PFix/Source/PitchDetector.h"
+#include "PitchCorrection.h"
+#include <vector>
+
+class RealtimeCorrector
+{
+public:
+    static constexpr float  kMinFrequencyHz  = 95.0f;    // 1024-sample window at 44.1 / 48 kHz
+    static constexpr int    kHopsPerWindow   = 8;
+    static constexpr double kLatencySeconds  = 0.009;
+    static constexpr float  kDefaultRetuneMs = 20.0f;
+
+    /** Allocates for up to numChannels channels.  Not realtime-safe. */
+    void prepare (double sampleRate, int numChannels);
+
+    /** Forgets the signal so far, e.g. when playback restarts. */
+    void reset() noexcept;
+
+    /** The delay every sample comes out with; report it to the host. */
+    int getLatencySamples() const noexcept { return latency; }
+
+    /** Audio thread, usually once per block from the parameters. */
+    void setCorrection (const PitchCorrection& newCorrection) noexcept { correction = newCorrection; }
+
+    /** How long a new target takes to settle (about 63 % of the way). */
+    void setRetuneTime (float milliseconds) noexcept;
+
+    /** Detects every hops hops instead of every one, to shed load.  Past
+        one the detector recomputes each window rather than updating it,
+        so 2 costs as much as 1: use 4 (half the cost) or more.  Audio
+        thread; takes effect at the next detection. */
+    void setDetectionSpacing (int hops) noexcept { detectionSpacing = juce::jlimit (1, kHopsPerWindow, hops); }
+
+    /** Corrects the first numChannels channels of buffer in place. */
+    void process (juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+    /** The pitch last detected, 0 when unvoiced.  Audio thread. */
+    float getDetectedHz() const noexcept { return detectedHz; }
+
+private:
+    /** Sets the target shift and the window from a new detection. */
+    void updateTarget (float hz) noexcept;
+
+    /** 4-point Hermite read delay samples behind the write position. */
+    float readDelayed (const float* line, double delay) const noexcept;
+
+    PitchDetector      detector;
+    std::vector<float> history;          // 2 × analysisSize: each sample is written twice, so a window is contiguous
+    int                analysisSize = 0;
+    int                hop          = 0;
+    int                historyPos   = 0;
+    int                samplesToHop = 0;
+    int                detectionSpacing = 1;   // hops per detection
+    float              detectedHz   = 0.0f;
+
+    juce::AudioBuffer<float> delayLines;
+    int                      delayMask = 0;
+    int                      writePos  = 0;
+
+    double sampleRate   = 44100.0;
+    int    latency      = 0;        // the taps' delay mid-window
+    double maxWindow    = 0.0;      // so the shortest delay stays two samples back
+
+    PitchCorrection correction;
+    float  retuneMs          = kDefaultRetuneMs;
+    float  retuneCoefficient = 0.0f;   // one-pole, per sample
+    float  targetShift       = 0.0f;   // semitones
+    float  shift             = 0.0f;
+    double targetWindow      = 0.0;
+    double window            = 0.0;
+    double phase             = 0.0;    // of tap A, in windows; tap B is half a window on
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeCorrector)
+};
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+    RegionIndex.cpp  –  RegionIndex implementation
+  ==============================================================================
+*/
+
+#include "RegionIndex.h"
+#include <algorithm>
+
+//==============================================================================
+RegionIndex::RegionIndex (std::vector<Entry> entriesIn)
+    : entries (std::move (entriesIn))
+{
+    entries.erase (std::remove_if (entries.begin(), entries.end(), [] (const Entry& e) { return e.songRange.isEmpty(); }),
+                   entries.end());
+
+    std::sort (entries.begin(), entries.end(),
+               [] (const Entry& a, const Entry& b) { return a.songRange.getStart() < b.songRange.getStart(); });
+
+    const auto numEntries = (juce::int64) entries.size();
+
+    if (numEntries == 0)
+        return;
+
+    // Only pairs that overlap are visited, so this is linear unless many
+    // regions are stacked at once.  With several overlaps at one end the
+    // fade spans all of them.
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto& earlier = entries[i];
+
+        for (auto j = i + 1; j < entries.size() && entries[j].songRange.getStart() < earlier.songRange.getEnd(); ++j)
+        {
+            auto& later = entries[j];
+
+            if (later.songRange.getStart() == earlier.songRange.getStart() || later.songRange.getEnd() <= earlier.songRange.getEnd())
+                continue;
+
+            const juce::Range<juce::int64> overlap (later.songRange.getStart(), earlier.songRange.getEnd());
+
+            earlier.fadeOut = earlier.fadeOut.isEmpty() ? overlap : earlier.fadeOut.getUnionWith (overlap);
+            later.fadeIn    = later.fadeIn.isEmpty()    ? overlap : later.fadeIn.getUnionWith (overlap);
+        }
+    }
+
+    maxEnds.resize (entries.size());
+
+    // Leaves are the even entries.  lastIndex follows the subtree that
+    // the tree's ragged right edge falls in, and last is its latest end,
+    // standing in for children past the end of the array.
+    juce::int64 lastIndex = 0, last = 0;
+
+    for (juce::int64 i = 0; i < numEntries; i += 2)
+    {
+        lastIndex = i;
+        last = maxEnds[(size_t) i] = entries[(size_t) i].songRange.getEnd();
+    }
+
+    int level = 1;
+
+    for (; ((juce::int64) 1 << level) <= numEntries; ++level)
+    {
+        const auto half = (juce::int64) 1 << (level - 1);
+
+        for (auto i = (half << 1) - 1; i < numEntries; i += half << 2)
+        {
+            const auto leftEnd  = maxEnds[(size_t) (i - half)];
+            const auto rightEnd = i + half < numEntries ? maxEnds[(size_t) (i + half)] : last;
+            maxEnds[(size_t) i] = juce::jmax (entries[(size_t) i].songRange.getEnd(), leftEnd, rightEnd);
+        }
+
+        lastIndex = ((lastIndex >> level) & 1) != 0 ? lastIndex - half : lastIndex + half;
+
+        if (lastIndex < numEntries)
+            last = juce::jmax (last, maxEnds[(size_t) lastIndex]);
+    }
+
+    maxLevel = level - 1;
+    jassert (maxLevel < kMaxLevels);
+}
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+    RegionIndex.h  –  Which playback regions a block of song time touches
+
+    An immutable interval index over the regions' song-time ranges, built
+    off the audio thread whenever a region moves and handed to the
+    renderer, so a block finds its regions in O(log n + hits) instead of
+    asking every region for its range.
+
+    The entries are sorted by start and read as an implicit balanced
+    binary tree over that array, each node holding the latest end in its
+    subtree (the layout of Heng Li's cgranges): a query skips any subtree
+    that ends before the block starts, and stops at the first start past
+    its end.
+
+    Building it also finds where comped regions overlap: where one starts
+    inside another and plays on past its end, the overlap is the earlier
+    region's fade out and the later one's fade in.  A region wholly
+    inside another is layered over it, as before, with no fades.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+class RenderCache;
+
+class RegionIndex
+{
+public:
+    struct Entry
+    {
+        juce::Range<juce::int64> songRange;          ///< Where the region plays, clipped to its modification
+        juce::int64              sourceOffset = 0;   ///< Source sample = song sample + sourceOffset
+        int                      region       = 0;   ///< The builder's own index for the region
+
+        /** A time-stretched region's own cache, kept alive with the index;
+            sourceOffset then leads to its samples instead of the source's. */
+        std::shared_ptr<RenderCache> stretchedCache;
+
+        /** Song samples over which the region crossfades with one it
+            overlaps: fading in from the start, fading out to the end.
+            Empty where it doesn't; set by the index. */
+        juce::Range<juce::int64> fadeIn, fadeOut;
+    };
+
+    explicit RegionIndex (std::vector<Entry> entries);
+
+    bool isEmpty() const noexcept { return entries.empty(); }
+
+    /** Calls visit (const Entry&) for every entry overlapping range, in
+        order of start.  Allocation-free; audio thread. */
+    template <typename Visitor>
+    void forEachOverlapping (juce::Range<juce::int64> range, Visitor&& visit) const noexcept
+    {
+        if (maxLevel < 0 || range.isEmpty())
+            return;
+
+        const auto numEntries = (juce::int64) entries.size();
+        const auto start      = range.getStart();
+        const auto end        = range.getEnd();
+
+        struct Node { juce::int64 index; int level; bool leftDone; };
+
+        Node stack[2 * kMaxLevels];
+        int  depth = 0;
+        stack[depth++] = { ((juce::int64) 1 << maxLevel) - 1, maxLevel, false };
+
+        while (depth > 0)
+        {
+            const auto node = stack[--depth];
+
+            if (node.level <= kScanLevel)
+            {
+                // A small subtree is cheaper to scan in order than to walk
+                const auto first = node.index >> node.level << node.level;
+                const auto last  = juce::jmin (numEntries, first + ((juce::int64) 1 << (node.level + 1)) - 1);
+
+                for (auto i = first; i < last && entries[(size_t) i].songRange.getStart() < end; ++i)
+                    if (start < entries[(size_t) i].songRange.getEnd())
+                        visit (entries[(size_t) i]);
+            }
+            else if (! node.leftDone)
+            {
+                const auto left = node.index - ((juce::int64) 1 << (node.level - 1));
+                stack[depth++] = { node.index, node.level, true };
+
+                // A node past the end still has entries down its left side
+                if (left >= numEntries || maxEnds[(size_t) left] > start)
+                    stack[depth++] = { left, node.level - 1, false };
+            }
+            else if (node.index < numEntries && entries[(size_t) node.index].songRange.getStart() < end)
+            {
+                if (start < entries[(size_t) node.index].songRange.getEnd())
+                    visit (entries[(size_t) node.index]);
+
+                stack[depth++] = { node.index + ((juce::int64) 1 << (node.level - 1)), node.level - 1, false };
+            }
+        }
+    }
+
+private:
+    static constexpr int kMaxLevels = 32;
+    static constexpr int kScanLevel = 3;   // subtrees of 15 entries or fewer
+
+    std::vector<Entry>       entries;   // sorted by start
+    std::vector<juce::int64> maxEnds;   // the latest end in each node's subtree
+    int                      maxLevel = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RegionIndex)
+};
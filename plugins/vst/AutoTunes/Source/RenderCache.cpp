@@ -0,0 +1,267 @@
+/*
+  ==============================================================================
+    RenderCache.cpp  –  RenderCache implementation
+  ==============================================================================
+*/
+
+#include "RenderCache.h"
+
+std::atomic<juce::int64> RenderCache::ramInUse { 0 };
+
+//==============================================================================
+RenderCache::RenderCache (int numChannelsIn, juce::int64 numSamplesIn)
+    : numChannels (juce::jmax (1, numChannelsIn)),
+      numSamples (juce::jmax ((juce::int64) 0, numSamplesIn)),
+      numChunks ((int) ((numSamples + kChunkSize - 1) / kChunkSize)),
+      numSlots (numChunks + 1),
+      slotFloats ((size_t) numChannels * (size_t) kChunkSize),
+      chunkStates (std::make_unique<std::atomic<juce::uint64>[]> ((size_t) numChunks)),
+      slotVersions (std::make_unique<std::atomic<juce::uint32>[]> ((size_t) numSlots)),
+      renderedKeys ((size_t) numChunks, 0)
+{
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        chunkStates[(size_t) chunk].store (makeState (kNoSlot, 0, false), std::memory_order_relaxed);
+
+    const auto slotBytes = (juce::int64) (slotFloats * sizeof (float));
+
+    // Take as many whole slots of the budget as are left, and are needed
+    auto inUse = ramInUse.load();
+
+    do
+    {
+        const auto available = juce::jmax ((juce::int64) 0, kRamBudgetBytes - inUse);
+        numRamSlots = (int) juce::jmin ((juce::int64) numSlots, available / slotBytes);
+    }
+    while (! ramInUse.compare_exchange_weak (inUse, inUse + numRamSlots * slotBytes));
+
+    if (numRamSlots > 0)
+    {
+        ram.malloc ((size_t) numRamSlots * slotFloats);
+
+        if (ram == nullptr)
+        {
+            ramInUse -= numRamSlots * slotBytes;
+            numRamSlots = 0;
+        }
+    }
+
+    // Handed out lowest first, so RAM fills before the spill file
+    for (auto slot = numSlots; --slot >= 0;)
+        freeSlots.push_back ((juce::uint32) slot);
+
+    if (numRamSlots == numSlots)
+        return;
+
+    // Seeking past the end leaves the file sparse, so disk is only used as
+    // slots are written
+    const auto spillBytes = (juce::int64) (numSlots - numRamSlots) * slotBytes;
+    spillFile = std::make_unique<juce::TemporaryFile> (".atrc");
+
+    {
+        juce::FileOutputStream out (spillFile->getFile());
+
+        if (! out.openedOk() || ! out.setPosition (spillBytes - 1) || ! out.writeByte (0))
+            return;
+    }
+
+    spill = std::make_unique<juce::MemoryMappedFile> (spillFile->getFile(), juce::MemoryMappedFile::readWrite);
+
+    // Spilled slots then have no storage: write() runs out of slots and the
+    // renderer plays the uncorrected source in the chunks left over
+    if (spill->getData() == nullptr || (juce::int64) spill->getSize() < spillBytes)
+        spill.reset();
+}
+
+RenderCache::~RenderCache()
+{
+    if (numRamSlots > 0)
+        ramInUse -= numRamSlots * (juce::int64) (slotFloats * sizeof (float));
+}
+
+juce::Range<juce::int64> RenderCache::getChunkRange (int chunk) const noexcept
+{
+    const auto start = (juce::int64) chunk * kChunkSize;
+    return { start, juce::jmin (start + kChunkSize, numSamples) };
+}
+
+float* RenderCache::getSlotData (juce::uint32 slot) const noexcept
+{
+    if ((int) slot < numRamSlots)
+        return ram + (size_t) slot * slotFloats;
+
+    if (spill == nullptr)
+        return nullptr;
+
+    return static_cast<float*> (spill->getData()) + (size_t) ((int) slot - numRamSlots) * slotFloats;
+}
+
+//==============================================================================
+bool RenderCache::read (juce::AudioBuffer<float>& destination, int destStart,
+                        juce::int64 start, int numSamplesToRead, bool includeDirty) const noexcept
+{
+    if (start < 0 || numSamplesToRead < 0 || start + numSamplesToRead > numSamples)
+        return false;
+
+    const auto numDestChannels = destination.getNumChannels();
+
+    while (numSamplesToRead > 0)
+    {
+        const auto chunk  = (int) (start / kChunkSize);
+        const auto offset = (int) (start % kChunkSize);
+        const auto length = juce::jmin (numSamplesToRead, kChunkSize - offset);
+
+        const auto& state   = chunkStates[(size_t) chunk];
+        const auto  current = state.load (std::memory_order_acquire);
+        const auto  slot    = slotOf (current);
+
+        if (slot == kNoSlot || (isDirty (current) && ! includeDirty))
+            return false;
+
+        const auto before = slotVersions[slot].load (std::memory_order_acquire);
+
+        if ((before & 1u) != 0)
+            return false;
+
+        const auto* data = getSlotData (slot) + offset;
+
+        for (int c = 0; c < numDestChannels; ++c)
+            juce::FloatVectorOperations::copy (destination.getWritePointer (c, destStart),
+                                               data + (size_t) juce::jmin (c, numChannels - 1) * kChunkSize,
+                                               length);
+
+        // A write into the slot while we copied moves its version on.  A
+        // chunk swapped out meanwhile may have had its old slot reused
+        // before we even looked at the version, so that counts as a miss too.
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (slotVersions[slot].load (std::memory_order_relaxed) != before
+            || slotOf (state.load (std::memory_order_relaxed)) != slot)
+            return false;
+
+        start            += length;
+        destStart        += length;
+        numSamplesToRead -= length;
+    }
+
+    return true;
+}
+
+//==============================================================================
+void RenderCache::invalidateChunk (int chunk) noexcept
+{
+    auto& state   = chunkStates[(size_t) chunk];
+    auto  current = state.load (std::memory_order_relaxed);
+
+    while (! state.compare_exchange_weak (current, makeState (slotOf (current), generationOf (current) + 1, true),
+                                          std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+void RenderCache::invalidate (juce::Range<juce::int64> samples) noexcept
+{
+    const auto first = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numChunks, samples.getStart() / kChunkSize);
+    const auto end   = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numChunks, (samples.getEnd() + kChunkSize - 1) / kChunkSize);
+
+    for (auto chunk = first; chunk < end; ++chunk)
+        invalidateChunk (chunk);
+}
+
+void RenderCache::invalidateAll() noexcept
+{
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        invalidateChunk (chunk);
+}
+
+void RenderCache::discard() noexcept
+{
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        chunkStates[(size_t) chunk].store (makeState (kNoSlot, 0, false), std::memory_order_release);
+}
+
+bool RenderCache::isComplete() const noexcept
+{
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        if (needsRender (chunkStates[(size_t) chunk].load (std::memory_order_relaxed)))
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+int RenderCache::findChunkToRender() const noexcept
+{
+    const auto playheadChunk = (int) juce::jlimit ((juce::int64) 0, (juce::int64) juce::jmax (0, numChunks - 1),
+                                                   playheadHint.load (std::memory_order_relaxed) / kChunkSize);
+
+    // Playback runs forward, so what's just behind the playhead is the
+    // last thing it'll need
+    for (auto chunk = playheadChunk; chunk < numChunks; ++chunk)
+        if (needsRender (chunkStates[(size_t) chunk].load (std::memory_order_relaxed)))
+            return chunk;
+
+    for (auto chunk = playheadChunk; --chunk >= 0;)
+        if (needsRender (chunkStates[(size_t) chunk].load (std::memory_order_relaxed)))
+            return chunk;
+
+    return -1;
+}
+
+juce::uint32 RenderCache::beginRender (int chunk) const noexcept
+{
+    return generationOf (chunkStates[(size_t) chunk].load (std::memory_order_acquire));
+}
+
+void RenderCache::markClean (int chunk, juce::uint32 token) noexcept
+{
+    auto& state   = chunkStates[(size_t) chunk];
+    auto  current = state.load (std::memory_order_relaxed);
+
+    // Only the state the token was taken from; an invalidation since wins
+    if (generationOf (current) == token && slotOf (current) != kNoSlot)
+        state.compare_exchange_strong (current, makeState (slotOf (current), token, false), std::memory_order_release);
+}
+
+bool RenderCache::write (int chunk, const juce::AudioBuffer<float>& rendered, juce::uint64 key, juce::uint32 token) noexcept
+{
+    if (freeSlots.empty())
+        return false;
+
+    const auto slot = freeSlots.back();
+    auto* data = getSlotData (slot);
+
+    if (data == nullptr)
+        return false;
+
+    freeSlots.pop_back();
+
+    const auto length = (int) getChunkRange (chunk).getLength();
+    jassert (rendered.getNumChannels() >= numChannels && rendered.getNumSamples() >= length);
+
+    // The slot may be one a reader was still copying a swapped-out chunk
+    // from; an odd version tells it to give up
+    auto& version = slotVersions[slot];
+    version.store (version.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    for (int c = 0; c < numChannels; ++c)
+        juce::FloatVectorOperations::copy (data + (size_t) c * kChunkSize, rendered.getReadPointer (c), length);
+
+    version.store (version.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Swap it in: clean if nothing invalidated the chunk since beginRender(),
+    // else still dirty, but newer than what it replaces
+    auto& state   = chunkStates[(size_t) chunk];
+    auto  current = state.load (std::memory_order_relaxed);
+
+    while (! state.compare_exchange_weak (current, makeState (slot, generationOf (current), generationOf (current) != token),
+                                          std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+
+    if (const auto previous = slotOf (current); previous != kNoSlot)
+        freeSlots.push_back (previous);
+
+    renderedKeys[(size_t) chunk] = key;
+    return true;
+}
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+    RenderCache.h  –  Pitch-corrected audio, rendered ahead for playback
+
+    Holds one audio modification's corrected audio, filled in fixed-size
+    chunks by a background render job and copied out by the playback
+    renderer, so the audio thread's share of pitch correction is a copy.
+
+    Chunks are stored in slots, one more than there are chunks: a chunk
+    being re-rendered goes into the spare slot and is swapped in when it's
+    done, so until then the renderer keeps playing the last good audio.
+    An edit only marks the chunks it touches dirty (see invalidate()), and
+    the render job takes dirty chunks nearest to the playhead first.
+
+    Slots live in RAM while a process-wide budget lasts and spill to a
+    sparse temporary file, memory-mapped, after that.  The OS pages that
+    file in and out as it sees fit, so a block reading spilled audio that
+    has been paged out may take a page fault on the audio thread; the
+    budget keeps that to sessions with hours of corrected audio.
+
+    Every slot carries a version, so read() copies without locks and can
+    tell if the slot was reused while it copied; the writer never waits
+    for the audio thread or the other way round.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class RenderCache
+{
+public:
+    static constexpr int         kChunkSize      = 32768;               // samples per channel
+    static constexpr juce::int64 kRamBudgetBytes = 256 * 1024 * 1024;   // shared by every cache in the process
+
+    RenderCache (int numChannels, juce::int64 numSamples);
+    ~RenderCache();
+
+    int         getNumChannels() const noexcept { return numChannels; }
+    juce::int64 getNumSamples() const noexcept  { return numSamples; }
+    int         getNumChunks() const noexcept   { return numChunks; }
+
+    /** The samples chunk covers; the last one may be short. */
+    juce::Range<juce::int64> getChunkRange (int chunk) const noexcept;
+
+    //==============================================================================
+    /**
+     * Copies [start, start + numSamples) into destination at destStart, if
+     * every chunk it touches has been rendered (and is clean, unless
+     * includeDirty).  A mono cache plays on every destination channel;
+     * false (and a partly written destination) if any of it isn't there.
+     * Audio thread.
+     */
+    bool read (juce::AudioBuffer<float>& destination, int destStart,
+               juce::int64 start, int numSamples, bool includeDirty = true) const noexcept;
+
+    /** Where playback is reading, in samples; steers findChunkToRender().
+        Audio thread, or the message thread on a region edit. */
+    void setPlayheadHint (juce::int64 position) noexcept { playheadHint.store (position, std::memory_order_relaxed); }
+
+    /** Marks the chunks overlapping samples dirty.  They play as they were
+        until re-rendered.  Any thread. */
+    void invalidate (juce::Range<juce::int64> samples) noexcept;
+    void invalidateAll() noexcept;
+
+    /** Forgets everything rendered, for a cache that no longer fits its
+        source and is being dropped.  Call with no render running. */
+    void discard() noexcept;
+
+    /** True once every chunk is rendered and clean. */
+    bool isComplete() const noexcept;
+
+    //==============================================================================
+    // The render job's side; one writer at a time.
+
+    /** The chunk most worth rendering next: never rendered or dirty, and
+        nearest ahead of the playhead hint, else nearest behind it.  -1
+        once there's none. */
+    int findChunkToRender() const noexcept;
+
+    /** Call before reading chunk's input.  The token makes a write or
+        markClean() leave the chunk dirty if it was invalidated since. */
+    juce::uint32 beginRender (int chunk) const noexcept;
+
+    /** The key write() last stored chunk with (0 if none). */
+    juce::uint64 getRenderedKey (int chunk) const noexcept { return renderedKeys[(size_t) chunk]; }
+
+    /** Marks chunk clean without rewriting it: its key says nothing it
+        depends on has changed. */
+    void markClean (int chunk, juce::uint32 token) noexcept;
+
+    /**
+     * Stores chunk from the start of rendered, which must hold at least
+     * getNumChannels() channels of the chunk's length, under key (a hash
+     * of everything it was rendered from), and swaps it in.  False if
+     * there was no slot to write to (the spill file couldn't be made).
+     */
+    bool write (int chunk, const juce::AudioBuffer<float>& rendered, juce::uint64 key, juce::uint32 token) noexcept;
+
+private:
+    // A chunk's state: its slot in the top half, then a generation that
+    // every invalidation bumps, then the dirty bit.
+    static constexpr juce::uint32 kNoSlot = 0xffffffffu;
+
+    static juce::uint64 makeState (juce::uint32 slot, juce::uint32 generation, bool dirty) noexcept
+    {
+        return ((juce::uint64) slot << 32) | ((juce::uint64) (generation & 0x7fffffffu) << 1) | (dirty ? 1u : 0u);
+    }
+
+    static juce::uint32 slotOf (juce::uint64 state) noexcept        { return (juce::uint32) (state >> 32); }
+    static juce::uint32 generationOf (juce::uint64 state) noexcept  { return (juce::uint32) (state >> 1) & 0x7fffffffu; }
+    static bool         isDirty (juce::uint64 state) noexcept       { return (state & 1u) != 0; }
+
+    static bool needsRender (juce::uint64 state) noexcept { return slotOf (state) == kNoSlot || isDirty (state); }
+
+    void invalidateChunk (int chunk) noexcept;
+
+    /** Channel 0 of slot; the others follow at kChunkSize apart.  Null if
+        it has no storage. */
+    float* getSlotData (juce::uint32 slot) const noexcept;
+
+    static std::atomic<juce::int64> ramInUse;
+
+    const int         numChannels;
+    const juce::int64 numSamples;
+    const int         numChunks;
+    const int         numSlots;
+    const size_t      slotFloats;
+    int               numRamSlots = 0;
+
+    juce::HeapBlock<float>                       ram;         // uninitialised; a slot is written before it's read
+    std::unique_ptr<juce::TemporaryFile>         spillFile;
+    std::unique_ptr<juce::MemoryMappedFile>      spill;       // unmapped before spillFile deletes the file
+
+    std::unique_ptr<std::atomic<juce::uint64>[]> chunkStates;
+    std::unique_ptr<std::atomic<juce::uint32>[]> slotVersions;   // odd while being written
+    std::atomic<juce::int64>                     playheadHint { 0 };
+
+    // Writer only
+    std::vector<juce::uint32> freeSlots;
+    std::vector<juce::uint64> renderedKeys;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderCache)
+};
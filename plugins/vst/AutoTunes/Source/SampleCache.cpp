@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+    SampleCache.cpp  –  SampleCache implementation
+  ==============================================================================
+*/
+
+#include "SampleCache.h"
+
+//==============================================================================
+SampleCache::SampleCache (int numChannelsIn, juce::int64 numSamplesIn, double sampleRateIn)
+    : numChannels (numChannelsIn),
+      numSamples (numSamplesIn),
+      sampleRate (sampleRateIn)
+{
+    const auto numBytes = (juce::int64) numChannels * numSamples * (juce::int64) sizeof (float);
+
+    if (numBytes <= 0)
+        return;
+
+    // Seeking past the end leaves the file sparse, so disk is only used as
+    // samples are appended
+    file = std::make_unique<juce::TemporaryFile> (".atsc");
+
+    {
+        juce::FileOutputStream out (file->getFile());
+
+        if (! out.openedOk() || ! out.setPosition (numBytes - 1) || ! out.writeByte (0))
+            return;
+    }
+
+    mapped = std::make_unique<juce::MemoryMappedFile> (file->getFile(), juce::MemoryMappedFile::readWrite);
+
+    if (mapped->getData() == nullptr || (juce::int64) mapped->getSize() < numBytes)
+    {
+        mapped.reset();
+        return;
+    }
+
+    samples = static_cast<float*> (mapped->getData());
+}
+
+void SampleCache::append (const float* const* channels, int numSamplesToAppend) noexcept
+{
+    const auto start = numDecoded.load (std::memory_order_relaxed);
+
+    if (samples == nullptr || numSamplesToAppend <= 0)
+        return;
+
+    jassert (start + numSamplesToAppend <= numSamples);
+    const auto length = (int) juce::jmin ((juce::int64) numSamplesToAppend, numSamples - start);
+
+    for (int c = 0; c < numChannels; ++c)
+        juce::FloatVectorOperations::copy (samples + (size_t) (c * numSamples + start), channels[c], length);
+
+    numDecoded.store (start + length, std::memory_order_release);
+}
+
+bool SampleCache::read (float* const* destination, int numDestChannels, juce::int64 start, int numSamplesToRead) const noexcept
+{
+    if (samples == nullptr || numDestChannels > numChannels || start < 0
+        || start + numSamplesToRead > getNumDecoded())
+        return false;
+
+    for (int c = 0; c < numDestChannels; ++c)
+        juce::FloatVectorOperations::copy (destination[c], samples + (size_t) (c * numSamples + start), numSamplesToRead);
+
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+    SampleCache.h  –  An audio source's samples, decoded once to disk
+
+    Reading through an ARAAudioSourceReader calls into the host on the
+    reading thread, and with analysis, rendering and scrubbing all reading
+    the same source at once that adds up.  The analysis already reads
+    every sample once, to hash it; it appends them here as it goes, and
+    every later reader copies from this file instead of asking the host.
+    A source at another rate from the session's is decoded at the
+    session's, through a SampleRateConverter, and then this is the only
+    copy of it at that rate.
+
+    The samples go into a sparse temporary file, memory-mapped, one
+    float32 channel after another, so a read is one copy per channel and
+    the OS page cache decides how much of it stays in RAM: nothing here
+    grows the plug-in's own footprint.
+
+    Written front to back by one thread at a time; any number of threads
+    may read the part written so far, without locks.  Not for the audio
+    thread, which would take the page faults.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <memory>
+
+class SampleCache
+{
+public:
+    /** Makes and maps the file, for numSamples at sampleRate; isValid() is
+        false if the disk wouldn't have it, and then every read() fails. */
+    SampleCache (int numChannels, juce::int64 numSamples, double sampleRate);
+
+    bool        isValid() const noexcept        { return samples != nullptr; }
+    int         getNumChannels() const noexcept { return numChannels; }
+    juce::int64 getNumSamples() const noexcept  { return numSamples; }
+    double      getSampleRate() const noexcept  { return sampleRate; }
+
+    /** Samples [0, getNumDecoded()) can be read. */
+    juce::int64 getNumDecoded() const noexcept  { return numDecoded.load (std::memory_order_acquire); }
+    bool        isComplete() const noexcept     { return getNumDecoded() == numSamples; }
+
+    /** Adds the next numSamples of every channel.  Writer only. */
+    void append (const float* const* channels, int numSamplesToAppend) noexcept;
+
+    /** Copies [start, start + numSamples) of the first numChannels channels
+        into destination; false, copying nothing, unless all of it has been
+        decoded.  Any thread but the audio thread. */
+    bool read (float* const* destination, int numDestChannels, juce::int64 start, int numSamplesToRead) const noexcept;
+
+private:
+    const int         numChannels;
+    const juce::int64 numSamples;
+    const double      sampleRate;
+
+    std::unique_ptr<juce::TemporaryFile>    file;
+    std::unique_ptr<juce::MemoryMappedFile> mapped;   // unmapped before file deletes the file
+    float*                                  samples = nullptr;
+
+    std::atomic<juce::int64> numDecoded { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCache)
+};
@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+    SampleRateConverter.cpp  –  SampleRateConverter implementation
+  ==============================================================================
+*/
+
+#include "SampleRateConverter.h"
+#include <cmath>
+#include <cstring>
+
+//==============================================================================
+SampleRateConverter::SampleRateConverter (int numChannelsIn, double sourceRate, double targetRate, juce::int64 numSourceSamples)
+    : numChannels (numChannelsIn),
+      ratio (sourceRate / targetRate),
+      halfWidth ((int) std::ceil (kZeroCrossings / (kBandwidth * juce::jmin (1.0, targetRate / sourceRate)))),
+      numInput (numSourceSamples),
+      numOutput (getNumOutputSamples (numSourceSamples, sourceRate, targetRate))
+{
+    // In input samples, so converting down widens the kernel as it lowers the cutoff
+    const auto cutoff = kBandwidth * juce::jmin (1.0, 1.0 / ratio);
+    const auto numTaps = 2 * halfWidth;
+
+    kernel.resize ((size_t) ((kPhases + 1) * numTaps));
+    coefficients.resize ((size_t) numTaps);
+
+    for (int phase = 0; phase <= kPhases; ++phase)
+    {
+        auto* row = kernel.data() + phase * numTaps;
+        auto  sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto x      = (double) (tap - halfWidth + 1) - (double) phase / kPhases;
+            const auto u      = x / halfWidth;
+            const auto sinc   = x == 0.0 ? 1.0 : std::sin (juce::MathConstants<double>::pi * cutoff * x) / (juce::MathConstants<double>::pi * cutoff * x);
+            const auto window = std::abs (u) >= 1.0 ? 0.0
+                                                    : 0.42 + 0.5 * std::cos (juce::MathConstants<double>::pi * u)
+                                                           + 0.08 * std::cos (2.0 * juce::MathConstants<double>::pi * u);
+
+            row[tap] = (float) (sinc * window);
+            sum += row[tap];
+        }
+
+        // Unity gain at every phase, or the level would ripple at the ratio's beat
+        for (int tap = 0; tap < numTaps; ++tap)
+            row[tap] = (float) (row[tap] / sum);
+    }
+
+    // Silence before the start, so the first outputs need no special case
+    historyStart = -halfWidth;
+    appendToHistory (nullptr, halfWidth);
+}
+
+juce::int64 SampleRateConverter::getNumOutputSamples (juce::int64 numSourceSamples, double sourceRate, double targetRate) noexcept
+{
+    if (sourceRate == targetRate || sourceRate <= 0.0 || targetRate <= 0.0)
+        return numSourceSamples;
+
+    // Every output sample lies within the input
+    return (juce::int64) std::ceil ((double) numSourceSamples * targetRate / sourceRate);
+}
+
+//==============================================================================
+void SampleRateConverter::appendToHistory (const float* const* input, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    if (history.getNumSamples() < historyLength + numSamples)
+        history.setSize (numChannels, 2 * (historyLength + numSamples), true, false, true);
+
+    for (int c = 0; c < numChannels; ++c)
+    {
+        if (input != nullptr)
+            juce::FloatVectorOperations::copy (history.getWritePointer (c, historyLength), input[c], numSamples);
+        else
+            juce::FloatVectorOperations::clear (history.getWritePointer (c, historyLength), numSamples);
+    }
+
+    historyLength += numSamples;
+}
+
+int SampleRateConverter::process (const float* const* input, int numSamples)
+{
+    const auto wasComplete = numReceived >= numInput;
+
+    appendToHistory (input, numSamples);
+    numReceived += numSamples;
+
+    // Silence after the end too, once it's here, for the last outputs
+    if (! wasComplete && numReceived >= numInput)
+        appendToHistory (nullptr, halfWidth + 1);
+
+    const auto historyEnd = historyStart + historyLength;
+    auto       end        = nextOutput;
+
+    while (end < numOutput && (juce::int64) std::floor ((double) end * ratio) + halfWidth < historyEnd)
+        ++end;
+
+    const auto count   = (int) (end - nextOutput);
+    const auto numTaps = 2 * halfWidth;
+
+    output.setSize (numChannels, juce::jmax (1, count), false, false, true);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const auto position = (double) (nextOutput + i) * ratio;
+        const auto base     = (juce::int64) std::floor (position);
+        const auto phase    = (position - (double) base) * kPhases;
+        const auto row      = juce::jmin ((int) phase, kPhases - 1);
+        const auto between  = (float) (phase - row);
+
+        const auto* lower = kernel.data() + row * numTaps;
+        const auto* upper = lower + numTaps;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            coefficients[(size_t) tap] = lower[tap] + between * (upper[tap] - lower[tap]);
+
+        const auto first = (int) (base - halfWidth + 1 - historyStart);
+
+        for (int c = 0; c < numChannels; ++c)
+        {
+            const auto* in  = history.getReadPointer (c, first);
+            auto        sum = 0.0f;
+
+            for (int tap = 0; tap < numTaps; ++tap)
+                sum += coefficients[(size_t) tap] * in[tap];
+
+            output.setSample (c, i, sum);
+        }
+    }
+
+    nextOutput = end;
+
+    // Only what the next output's taps reach back to is kept
+    const auto keepFrom = nextOutput < numOutput ? (juce::int64) std::floor ((double) nextOutput * ratio) - halfWidth + 1
+                                                 : historyEnd;
+    const auto drop     = (int) juce::jlimit ((juce::int64) 0, (juce::int64) historyLength, keepFrom - historyStart);
+
+    if (drop > 0)
+    {
+        for (int c = 0; c < numChannels && drop < historyLength; ++c)
+            std::memmove (history.getWritePointer (c), history.getReadPointer (c, drop), (size_t) (historyLength - drop) * sizeof (float));
+
+        historyStart  += drop;
+        historyLength -= drop;
+    }
+
+    return count;
+}
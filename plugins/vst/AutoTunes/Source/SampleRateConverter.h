@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+    SampleRateConverter.h  –  An audio source's samples at another rate,
+                              converted once as they're decoded
+
+    A 44.1 kHz stem in a 48 kHz session is decoded through one of these
+    into its SampleCache at the session's rate, so its analysis, renders
+    and playback all work at the one rate and none of them resamples a
+    block at a time.
+
+    Each output sample is a windowed sinc over kZeroCrossings zero
+    crossings either side of its position, the cutoff brought down to the
+    output's Nyquist frequency when converting down so nothing above it
+    folds back.  The kernel is tabulated at kPhases fractional positions
+    and interpolated between them.  Output sample n is input position
+    n * ratio exactly, with no delay, so a note is at the same time at
+    either rate.
+
+    Input goes in front to back, in blocks of any size; the few samples
+    the next output still needs are kept from one block to the next.
+    Not for the audio thread: blocks larger than any seen before allocate.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+class SampleRateConverter
+{
+public:
+    static constexpr int    kZeroCrossings = 16;
+    static constexpr int    kPhases        = 512;
+    static constexpr double kBandwidth     = 0.97;   // of the lower Nyquist frequency; the window's transition fits above it
+
+    SampleRateConverter (int numChannels, double sourceRate, double targetRate, juce::int64 numSourceSamples);
+
+    /** How long numSourceSamples at sourceRate are at targetRate. */
+    static juce::int64 getNumOutputSamples (juce::int64 numSourceSamples, double sourceRate, double targetRate) noexcept;
+
+    juce::int64 getNumOutputSamples() const noexcept  { return numOutput; }
+
+    /** Converts the next numInput samples of every channel, and returns how
+        many output samples that completes, which getOutput() then holds.
+        The last of the input completes all of them. */
+    int process (const float* const* input, int numInput);
+
+    const juce::AudioBuffer<float>& getOutput() const noexcept  { return output; }
+
+private:
+    /** Appends numSamples of every channel (zeros if input is null) to the history. */
+    void appendToHistory (const float* const* input, int numSamples);
+
+    const int         numChannels;
+    const double      ratio;        // input samples per output sample
+    const int         halfWidth;    // taps either side, in input samples
+    const juce::int64 numInput;
+    const juce::int64 numOutput;
+
+    std::vector<float> kernel;         // (kPhases + 1) rows of 2 * halfWidth taps
+    std::vector<float> coefficients;   // the current output sample's taps
+
+    juce::AudioBuffer<float> history;           // input from historyStart on
+    juce::int64              historyStart  = 0;
+    int                      historyLength = 0;
+    juce::int64              numReceived   = 0;
+    juce::int64              nextOutput    = 0;
+
+    juce::AudioBuffer<float> output;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleRateConverter)
+};
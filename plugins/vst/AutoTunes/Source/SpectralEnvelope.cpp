@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+    SpectralEnvelope.cpp  –  SpectralEnvelope implementation
+  ==============================================================================
+*/
+
+#include "SpectralEnvelope.h"
+#include <algorithm>
+#include <cmath>
+
+int SpectralEnvelope::getOrder (double sampleRate) noexcept
+{
+    return juce::jmax (8, juce::roundToInt (kCepstrumSeconds * sampleRate));
+}
+
+//==============================================================================
+SpectralEnvelope::Analyser::Analyser (int frameSizeIn, int orderIn)
+    : frameSize (frameSizeIn),
+      order (juce::jmin (orderIn, frameSizeIn / 2)),
+      fft (juce::roundToInt (std::log2 (frameSizeIn))),
+      window ((size_t) frameSizeIn),
+      buffer ((size_t) (2 * frameSizeIn))
+{
+    jassert (juce::isPowerOfTwo (frameSize));
+
+    for (int i = 0; i < frameSize; ++i)
+        window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) frameSize);
+}
+
+void SpectralEnvelope::Analyser::analyse (const float* frame, float* coefficients) noexcept
+{
+    // Far below anything audible, so silence has a floor rather than -inf
+    constexpr float kMinPower = 1.0e-14f;
+
+    auto* data = buffer.data();
+
+    for (int i = 0; i < frameSize; ++i)
+        data[i] = frame[i] * window[(size_t) i];
+
+    std::fill (data + frameSize, data + 2 * frameSize, 0.0f);
+    fft.performRealOnlyForwardTransform (data, true);
+
+    // Log magnitude, real and even, so its inverse is the real cepstrum
+    for (int k = 0; k <= frameSize / 2; ++k)
+    {
+        const auto re = data[2 * k], im = data[2 * k + 1];
+        data[2 * k]     = 0.5f * std::log (juce::jmax (kMinPower, re * re + im * im));
+        data[2 * k + 1] = 0.0f;
+    }
+
+    fft.performRealOnlyInverseTransform (data);
+
+    // A half-cosine lifter over the kept coefficients, then quantised
+    for (int n = 0; n < order; ++n)
+    {
+        const auto taper = 0.5f + 0.5f * std::cos (juce::MathConstants<float>::pi * (float) n / (float) order);
+        coefficients[n] = std::round (data[n] * taper / kQuantum) * kQuantum;
+    }
+}
+
+//==============================================================================
+void SpectralEnvelope::evaluate (const float* coefficients, int order, const juce::dsp::FFT& fft,
+                                 float* logMagnitudes, float* scratch) noexcept
+{
+    const auto size = fft.getSize();
+    order = juce::jmin (order, size / 2);
+
+    // The cepstrum is even, so its transform is real: c0 + 2 sum cn cos (2 pi k n / size)
+    std::fill (scratch, scratch + 2 * size, 0.0f);
+    scratch[0] = coefficients[0];
+
+    for (int n = 1; n < order; ++n)
+        scratch[n] = scratch[size - n] = coefficients[n];
+
+    fft.performRealOnlyForwardTransform (scratch, true);
+
+    for (int k = 0; k <= size / 2; ++k)
+        logMagnitudes[k] = scratch[2 * k];
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+    SpectralEnvelope.h  –  Compact spectral envelopes for formant handling
+
+    An envelope is the low-quefrency end of a frame's real cepstrum: the
+    first getOrder() coefficients of the inverse transform of its log
+    magnitude spectrum, about a millisecond's worth, which keeps the shape
+    the vocal tract gives the spectrum (the formants) and drops the
+    harmonics.  Tapered at the top so it doesn't ripple, and quantised to
+    kQuantum nepers, so one read back from the archive is the same one.
+
+    The background analysis computes one every kFramesPerEnvelope pitch
+    frames (see PitchAnalysis::envelopes), from the same windows as the
+    pitch, so a render never has to estimate one: PsolaPlan reshapes a
+    formant-shifted grain with the envelope nearest it instead.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+class SpectralEnvelope
+{
+public:
+    static constexpr double kCepstrumSeconds   = 0.001;        // below the period of any sung note
+    static constexpr int    kFramesPerEnvelope = 4;            // ~20 ms at 48 kHz; formants move slower
+    static constexpr float  kQuantum           = 1.0f / 64.0f; // nepers, ~0.14 dB
+
+    /** Coefficients per envelope at sampleRate. */
+    static int getOrder (double sampleRate) noexcept;
+
+    //==============================================================================
+    /** Works out envelopes of frames of one size.  Allocates only when
+        constructed; one per thread. */
+    class Analyser
+    {
+    public:
+        /** frameSize must be a power of two. */
+        Analyser (int frameSize, int order);
+
+        int getFrameSize() const noexcept { return frameSize; }
+        int getOrder() const noexcept     { return order; }
+
+        /** Writes getOrder() coefficients of frameSize samples' envelope. */
+        void analyse (const float* frame, float* coefficients) noexcept;
+
+    private:
+        const int          frameSize, order;
+        juce::dsp::FFT     fft;
+        std::vector<float> window, buffer;
+    };
+
+    //==============================================================================
+    /** The envelope's log magnitude (nepers) at bins 0 … size / 2 of a
+        size-point transform, where fft is that transform: into logMagnitudes,
+        using scratch (2 * size floats). */
+    static void evaluate (const float* coefficients, int order, const juce::dsp::FFT& fft,
+                          float* logMagnitudes, float* scratch) noexcept;
+};
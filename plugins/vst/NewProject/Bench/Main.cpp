@@ -0,0 +1,550 @@
+/*
+  ==============================================================================
+    Main.cpp  –  NewProjectBench: headless synth render benchmark
+
+    Drives NewProjectAudioProcessor the way a host does (prepareToPlay, then
+    processBlock with MIDI, output thrown away) for every combination of
+    the requested voice counts, block sizes, sample rates and scenarios,
+    and prints one JSON document so results can be diffed between commits.
+
+    Usage:
+      NewProjectBench  [--voices=1,8,32,64]  [--engines=bank,voices]
+                       [--blocks=64,256,1024]
+                       [--rates=44100,48000,96000]
+                       [--scenarios=chords,arpeggio,mpe]  [--seconds=10]
+                       [--oversampling=0]  [--reverb=fdn | convolution]
+                       [--unison=2]  [--spread=0]  [--note-cache]
+                       [--sub-block=32]  [--reverb-rate=1]
+                       [--multithreaded]  [--offline]  [--out=results.json]
+                       [--trace=trace.json]
+      NewProjectBench  --budget  [--blocks=…]  [--rates=…]  [--scenarios=…]
+      NewProjectBench  --startup=100  [--out=results.json]
+
+    Scenarios, each keeping about `voices` notes sounding:
+      chords    all of them struck together, restruck every 2 s
+      arpeggio  one note every 1/16 at 120 bpm, each held for `voices` steps
+      mpe       sustained notes, one per MPE member channel, each with its
+                own pitch bend, CC74 and pressure streams at 1 kHz
+
+    Per run: realtimeFactor (audio seconds per wall second), nsPerVoiceSample
+    (wall time over sample frames x mean sounding voices), and the mean,
+    p99 and worst block times in microseconds.  The first second is
+    rendered untimed, to warm caches and let the voices start.
+
+    --engines picks what renders the voices ("voiceEngine"): the SIMD
+    bank, DSPVoices, or both, one run each.  Builds without SIMD play
+    DSPVoices for both; each run's "engine" says which rendered it.
+
+    --budget checks the bank's target: 64 voices for no more CPU than 8
+    DSPVoices take.  Instead of the --voices and --engines runs it renders
+    8 DSPVoices and 64 voices on the bank for every block size, rate and
+    scenario, and reports each pair under "budget": both mean block times,
+    their ratio, and withinBudget if the 64 took no longer.  The bank
+    renders on the audio thread alone, as the DSPVoices do, whatever
+    --multithreaded says.
+
+    Blocks come faster than real time, so the convolution reverb's tail
+    thread falls behind and skips; its work isn't in the block times.
+    --offline renders as a bounce does (the offline profile, with the tail
+    convolved inline) and times everything.
+
+    Debug builds also count the realtime-safety violations the renders
+    made (see RealtimeSafety.h), print each one, and exit with 1 if there
+    were any, so a change that allocates or locks in processBlock() fails.
+
+    --unison sets the saws per note (1 … 16) and --spread their stereo
+    width (0 … 1); a spread stack filters each side, so it costs about a
+    second filter per voice on top of the stack.
+
+    --sub-block sets the fixed size the voices and reverb render in (16,
+    32, 64 or 128; see SubBlockEngine), which --blocks then no longer
+    changes; compare nsPerVoiceSample across block sizes to see it.
+
+    --reverb-rate runs the reverb at 1/1, 1/2 or 1/4 of the rate (see
+    ReverbSlot; never below 44.1 kHz); try it with --rates=96000,192000.
+
+    --note-cache stills the LFO (depth 0) and turns the note cache on, so
+    repeated notes replay their attacks; the arpeggio shows it best.
+
+    --trace captures every run as a Chrome trace (see TraceEvents.h) for
+    chrome://tracing or ui.perfetto.dev: the audio thread's blocks, the
+    render workers' voice slices and the reverb, side by side.
+
+    --startup times what a session load or plugin scan pays instead of
+    rendering: constructing that many instances side by side (mean and
+    worst, in microseconds), the first prepareToPlay() of each, opening
+    and closing one editor, and destroying them all.
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    // ── Options ──────────────────────────────────────────────────────────────
+    juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    constexpr int subBlockSizes[] { 16, 32, 64, 128 };   // "subBlock"'s choices, in order
+
+    void setParameter (NewProjectAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* parameter = processor.apvts.getParameter (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    // ── Scripted MIDI ────────────────────────────────────────────────────────
+    enum class Scenario { chords, arpeggio, mpe };
+
+    bool parseScenario (const juce::String& name, Scenario& scenario)
+    {
+        if (name == "chords")   { scenario = Scenario::chords;   return true; }
+        if (name == "arpeggio") { scenario = Scenario::arpeggio; return true; }
+        if (name == "mpe")      { scenario = Scenario::mpe;      return true; }
+        return false;
+    }
+
+    /** Writes each block's MIDI for one scenario, from a running sample
+        clock. */
+    class Script
+    {
+    public:
+        Script (Scenario scenarioToUse, int numVoicesToUse, double sampleRateToUse)
+            : scenario (scenarioToUse), numVoices (numVoicesToUse), sampleRate (sampleRateToUse) {}
+
+        void fillBlock (juce::MidiBuffer& midi, int numSamples)
+        {
+            midi.clear();
+
+            for (int i = 0; i < numSamples; ++i, ++clock)
+            {
+                switch (scenario)
+                {
+                    case Scenario::chords:   chordsAt   (midi, i); break;
+                    case Scenario::arpeggio: arpeggioAt (midi, i); break;
+                    case Scenario::mpe:      mpeAt      (midi, i); break;
+                }
+            }
+        }
+
+    private:
+        // Spread over five octaves, so no two voices share a note
+        int noteFor (int voice) const noexcept { return 36 + (voice * 7) % 60; }
+
+        void chordsAt (juce::MidiBuffer& midi, int position)
+        {
+            const auto period = (juce::int64) (2.0 * sampleRate);
+
+            if (clock % period != 0)
+                return;
+
+            for (int v = 0; v < numVoices; ++v)
+            {
+                if (clock > 0)
+                    midi.addEvent (juce::MidiMessage::noteOff (1, noteFor (v)), position);
+
+                midi.addEvent (juce::MidiMessage::noteOn (1, noteFor (v), 0.8f), position);
+            }
+        }
+
+        void arpeggioAt (juce::MidiBuffer& midi, int position)
+        {
+            const auto step = (juce::int64) (0.125 * sampleRate);
+
+            if (clock % step != 0)
+                return;
+
+            const auto index = (int) (clock / step);
+
+            if (index >= numVoices)
+                midi.addEvent (juce::MidiMessage::noteOff (1, noteFor ((index - numVoices) % 60)), position);
+
+            midi.addEvent (juce::MidiMessage::noteOn (1, noteFor (index % 60), 0.8f), position);
+        }
+
+        void mpeAt (juce::MidiBuffer& midi, int position)
+        {
+            // Member channels 2 … 16; past 15 notes they share channels
+            const auto channelFor = [] (int voice) { return 2 + voice % 15; };
+
+            if (clock == 0)
+                for (int v = 0; v < numVoices; ++v)
+                    midi.addEvent (juce::MidiMessage::noteOn (channelFor (v), noteFor (v), 0.8f), position);
+
+            const auto interval = juce::jmax ((juce::int64) 1, (juce::int64) (sampleRate / 1000.0));
+
+            if (clock % interval != 0)
+                return;
+
+            const auto t = (double) clock / sampleRate;
+
+            for (int v = 0; v < juce::jmin (numVoices, 15); ++v)
+            {
+                const auto wobble = std::sin (juce::MathConstants<double>::twoPi * (0.5 + 0.1 * v) * t);
+                const auto bend   = juce::jlimit (0, 16383, 8192 + (int) (1500.0 * wobble));
+                const auto amount = juce::jlimit (0, 127, 64 + (int) (50.0 * wobble));
+
+                midi.addEvent (juce::MidiMessage::pitchWheel        (channelFor (v), bend),       position);
+                midi.addEvent (juce::MidiMessage::controllerEvent   (channelFor (v), 74, amount), position);
+                midi.addEvent (juce::MidiMessage::channelPressureChange (channelFor (v), amount), position);
+            }
+        }
+
+        Scenario    scenario;
+        int         numVoices;
+        double      sampleRate;
+        juce::int64 clock = 0;
+    };
+
+    // ── One run ──────────────────────────────────────────────────────────────
+    struct RunConfig
+    {
+        int          numVoices;
+        int          engine;         // "voiceEngine"'s choice
+        int          blockSize;
+        double       sampleRate;
+        Scenario     scenario;
+        juce::String scenarioName;
+        double       seconds;
+        int          oversampling;
+        int          unison;
+        float        spread;
+        bool         noteCache;
+        int          subBlock;       // an index into "subBlock"'s choices
+        int          reverbRateLog2; // "reverbRate"'s choice: 0 full, 1 half, 2 quarter
+        bool         convolution;
+        bool         multithreaded;
+        bool         offline;
+    };
+
+    juce::var runOnce (const RunConfig& config)
+    {
+        NewProjectAudioProcessor processor;
+
+        setParameter (processor, "polyphony",     (float) config.numVoices);
+        setParameter (processor, "voiceEngine",   (float) config.engine);
+        setParameter (processor, "cpuLimiter",    0.0f);
+        setParameter (processor, "multithreaded", config.multithreaded ? 1.0f : 0.0f);
+        setParameter (processor, "oversampling",  (float) config.oversampling);
+        setParameter (processor, "reverbEngine",  config.convolution ? 1.0f : 0.0f);
+        setParameter (processor, "unisonVoices",  (float) config.unison);
+        setParameter (processor, "unisonSpread",  config.spread);
+        setParameter (processor, "lfoDepth",      config.noteCache ? 0.0f : 1.0f);
+        setParameter (processor, "noteCache",     config.noteCache ? 1.0f : 0.0f);
+        setParameter (processor, "subBlock",      (float) config.subBlock);
+        setParameter (processor, "reverbRate",    (float) config.reverbRateLog2);
+
+        processor.setNonRealtime (config.offline);
+        processor.setPlayConfigDetails (0, 2, config.sampleRate, config.blockSize);
+        processor.prepareToPlay (config.sampleRate, config.blockSize);
+
+        Script                   script (config.scenario, config.numVoices, config.sampleRate);
+        juce::AudioBuffer<float> buffer (2, config.blockSize);
+        juce::MidiBuffer         midi;
+
+        const auto warmUpBlocks = (int) std::ceil (config.sampleRate / config.blockSize);
+        const auto timedBlocks  = juce::jmax (1, (int) (config.seconds * config.sampleRate / config.blockSize));
+
+        for (int b = 0; b < warmUpBlocks; ++b)
+        {
+            script.fillBlock (midi, config.blockSize);
+            processor.processBlock (buffer, midi);
+        }
+
+        std::vector<double> blockSeconds ((size_t) timedBlocks);
+        double voiceBlocks = 0.0;
+
+        for (auto& seconds : blockSeconds)
+        {
+            script.fillBlock (midi, config.blockSize);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+            seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+            voiceBlocks += processor.getNumActiveVoices();
+        }
+
+        const juce::String engineName = processor.isBankRendering() ? "bank" : "voices";
+        processor.releaseResources();
+
+        const auto totalSeconds = std::accumulate (blockSeconds.begin(), blockSeconds.end(), 0.0);
+        const auto meanVoices   = voiceBlocks / (double) timedBlocks;
+        const auto frames       = (double) timedBlocks * config.blockSize;
+
+        auto sorted = blockSeconds;
+        std::sort (sorted.begin(), sorted.end());
+        const auto p99 = sorted[(size_t) juce::jmin ((int) sorted.size() - 1, (int) std::ceil (0.99 * (double) sorted.size()) - 1)];
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty ("scenario",         config.scenarioName);
+        run->setProperty ("voices",           config.numVoices);
+        run->setProperty ("engine",           engineName);
+        run->setProperty ("blockSize",        config.blockSize);
+        run->setProperty ("sampleRate",       config.sampleRate);
+        run->setProperty ("oversampling",     config.oversampling);
+        run->setProperty ("unison",           config.unison);
+        run->setProperty ("spread",           config.spread);
+        run->setProperty ("noteCache",        config.noteCache);
+        run->setProperty ("subBlock",         subBlockSizes[(size_t) config.subBlock]);
+        run->setProperty ("reverb",           config.convolution ? "convolution" : "fdn");
+        run->setProperty ("reverbRate",       1 << config.reverbRateLog2);
+        run->setProperty ("multithreaded",    config.multithreaded);
+        run->setProperty ("offline",          config.offline);
+        run->setProperty ("blocks",           timedBlocks);
+        run->setProperty ("meanActiveVoices", meanVoices);
+        run->setProperty ("realtimeFactor",   totalSeconds > 0.0 ? frames / config.sampleRate / totalSeconds : 0.0);
+        run->setProperty ("nsPerVoiceSample", meanVoices > 0.0 ? totalSeconds * 1.0e9 / (frames * meanVoices) : 0.0);
+        run->setProperty ("meanBlockMicros",  totalSeconds * 1.0e6 / (double) timedBlocks);
+        run->setProperty ("p99BlockMicros",   p99 * 1.0e6);
+        run->setProperty ("maxBlockMicros",   sorted.back() * 1.0e6);
+        run->setProperty ("deadlineMicros",   config.blockSize * 1.0e6 / config.sampleRate);
+        return run;
+    }
+
+    juce::var runStartup (int numInstances)
+    {
+        const auto secondsSince = [] (juce::int64 startTicks)
+        {
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        };
+
+        const auto summarise = [] (const std::vector<double>& seconds)
+        {
+            auto* times = new juce::DynamicObject();
+            times->setProperty ("meanMicros",  std::accumulate (seconds.begin(), seconds.end(), 0.0) * 1.0e6 / (double) seconds.size());
+            times->setProperty ("maxMicros",   *std::max_element (seconds.begin(), seconds.end()) * 1.0e6);
+            times->setProperty ("totalMillis", std::accumulate (seconds.begin(), seconds.end(), 0.0) * 1.0e3);
+            return juce::var (times);
+        };
+
+        std::vector<std::unique_ptr<NewProjectAudioProcessor>> processors;
+        std::vector<double> construct, prepare;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processors.push_back (std::make_unique<NewProjectAudioProcessor>());
+            construct.push_back (secondsSince (startTicks));
+        }
+
+        for (auto& processor : processors)
+        {
+            processor->setPlayConfigDetails (0, 2, 48000.0, 512);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor->prepareToPlay (48000.0, 512);
+            prepare.push_back (secondsSince (startTicks));
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        std::unique_ptr<juce::AudioProcessorEditor> editor (processors.front()->createEditor());
+        const auto editorSeconds = secondsSince (startTicks);
+        editor.reset();
+
+        startTicks = juce::Time::getHighResolutionTicks();
+        processors.clear();
+        const auto destroySeconds = secondsSince (startTicks);
+
+        auto* startup = new juce::DynamicObject();
+        startup->setProperty ("instances",        numInstances);
+        startup->setProperty ("construct",        summarise (construct));
+        startup->setProperty ("prepare",          summarise (prepare));
+        startup->setProperty ("editorMicros",     editorSeconds * 1.0e6);
+        startup->setProperty ("destroyAllMillis", destroySeconds * 1.0e3);
+        return startup;
+    }
+
+    /** The --budget entry for one 8-DSPVoice run and its 64-voice bank
+        run. */
+    juce::var compareBudget (const juce::var& eightVoices, const juce::var& bank)
+    {
+        const auto budgetMicros = (double) eightVoices.getProperty ("meanBlockMicros", 0.0);
+        const auto bankMicros   = (double) bank.getProperty ("meanBlockMicros", 0.0);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("scenario",              bank.getProperty ("scenario", {}));
+        entry->setProperty ("blockSize",             bank.getProperty ("blockSize", {}));
+        entry->setProperty ("sampleRate",            bank.getProperty ("sampleRate", {}));
+        entry->setProperty ("bankEngine",            bank.getProperty ("engine", {}));
+        entry->setProperty ("eightVoicesMicros",     budgetMicros);
+        entry->setProperty ("sixtyFourVoicesMicros", bankMicros);
+        entry->setProperty ("ratio",                 budgetMicros > 0.0 ? bankMicros / budgetMicros : 0.0);
+        entry->setProperty ("withinBudget",          bankMicros <= budgetMicros);
+        return entry;
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "NewProjectBench: " << message << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    // The processor's parameter tree and async updates expect a message manager
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto voices    = splitList (optionOr (args, "--voices",    "1,8,32,64"));
+    const auto engines   = splitList (optionOr (args, "--engines",   "bank"));
+    const auto blocks    = splitList (optionOr (args, "--blocks",    "64,256,1024"));
+    const auto rates     = splitList (optionOr (args, "--rates",     "44100,48000,96000"));
+    const auto scenarios = splitList (optionOr (args, "--scenarios", "chords,arpeggio,mpe"));
+    const auto seconds   = optionOr (args, "--seconds", "10").getDoubleValue();
+    const auto reverb    = optionOr (args, "--reverb",  "fdn");
+    const auto oversampling  = optionOr (args, "--oversampling", "0").getIntValue();
+    const auto unison        = optionOr (args, "--unison", "2").getIntValue();
+    const auto spread        = optionOr (args, "--spread", "0").getFloatValue();
+    const bool noteCache     = args.containsOption ("--note-cache");
+    const auto subBlock      = optionOr (args, "--sub-block", "32").getIntValue();
+    const auto subBlockIndex = (int) (std::find (std::begin (subBlockSizes), std::end (subBlockSizes), subBlock)
+                                        - std::begin (subBlockSizes));
+    const auto reverbRate    = optionOr (args, "--reverb-rate", "1").getIntValue();
+    const bool multithreaded = args.containsOption ("--multithreaded");
+    const bool offline       = args.containsOption ("--offline");
+    const auto trace         = args.getValueForOption ("--trace");
+    const auto startup       = args.getValueForOption ("--startup").getIntValue();
+    const bool budget        = args.containsOption ("--budget");
+
+    if (args.containsOption ("--startup") && startup < 1)
+        return fail ("--startup needs an instance count");
+
+    for (const auto& engine : engines)
+        if (engine != "bank" && engine != "voices")
+            return fail ("unknown engine '" + engine + "' (bank or voices)");
+
+    if (seconds <= 0.0)
+        return fail ("--seconds must be positive");
+
+    if (reverb != "fdn" && reverb != "convolution")
+        return fail ("unknown reverb '" + reverb + "' (fdn or convolution)");
+
+    if (oversampling < 0 || oversampling > 2)
+        return fail ("--oversampling is 0 (off), 1 (2x) or 2 (4x)");
+
+    if (unison < 1 || unison > UnisonLayout::kMaxVoices || spread < 0.0f || spread > 1.0f)
+        return fail ("--unison is 1 … " + juce::String (UnisonLayout::kMaxVoices) + ", --spread 0 … 1");
+
+    if (subBlockIndex == (int) std::size (subBlockSizes))
+        return fail ("--sub-block is 16, 32, 64 or 128");
+
+    if (reverbRate != 1 && reverbRate != 2 && reverbRate != 4)
+        return fail ("--reverb-rate is 1 (full), 2 (half) or 4 (quarter)");
+
+    juce::Array<juce::var> runs, budgetRuns;
+
+    if (trace.isNotEmpty())
+    {
+        TRACE_THREAD_NAME ("NewProjectBench");
+        TraceRecorder::getInstance().start();
+    }
+
+    // --startup replaces the renders; --budget replaces the voice counts
+    // and engines with its pair, 8 DSPVoices then 64 on the bank
+    const auto runVoices  = budget ? juce::StringArray { "8", "64" } : voices;
+    const auto enginesFor = [&] (const juce::String& voiceText)
+    {
+        return budget ? juce::StringArray { voiceText == "8" ? "voices" : "bank" } : engines;
+    };
+
+    for (const auto& scenarioName : startup > 0 ? juce::StringArray() : scenarios)
+    for (const auto& rateText : rates)
+    for (const auto& blockText : blocks)
+    for (const auto& voiceText : runVoices)
+    for (const auto& engineText : enginesFor (voiceText))
+    {
+        RunConfig config { voiceText.getIntValue(),
+                           engineText == "bank" ? NewProjectAudioProcessor::bankEngine : NewProjectAudioProcessor::dspVoiceEngine,
+                           blockText.getIntValue(), rateText.getDoubleValue(),
+                           Scenario::chords, scenarioName, seconds, oversampling, unison, spread, noteCache, subBlockIndex,
+                           juce::roundToInt (std::log2 (reverbRate)),
+                           reverb == "convolution", multithreaded && ! budget, offline };
+
+        if (! parseScenario (scenarioName, config.scenario))
+            return fail ("unknown scenario '" + scenarioName + "' (chords, arpeggio or mpe)");
+
+        if (config.numVoices < 1 || config.numVoices > VoicePoolSynthesiser::kMaxVoices)
+            return fail ("voice counts must be 1 … " + juce::String (VoicePoolSynthesiser::kMaxVoices));
+
+        if (config.blockSize <= 0 || config.sampleRate <= 0.0)
+            return fail ("block sizes and sample rates must be positive");
+
+        runs.add (runOnce (config));
+
+        // The 64-voice run follows its 8-voice one
+        if (budget && config.numVoices == 64)
+            budgetRuns.add (compareBudget (runs.getReference (runs.size() - 2), runs.getLast()));
+    }
+
+    if (trace.isNotEmpty())
+    {
+        auto& recorder = TraceRecorder::getInstance();
+
+        if (! recorder.stopAndWrite (juce::File::getCurrentWorkingDirectory().getChildFile (trace)))
+            return fail ("can't write " + trace);
+
+        if (const auto dropped = recorder.getNumDropped(); dropped > 0)
+            std::cerr << "NewProjectBench: trace dropped " << dropped << " events" << std::endl;
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool", "NewProjectBench");
+    root->setProperty ("runs", runs);
+
+    if (budget)
+        root->setProperty ("budget", budgetRuns);
+
+    if (startup > 0)
+        root->setProperty ("startup", runStartup (startup));
+
+   #if REALTIME_SAFETY_CHECKS
+    const auto& violationLog = RealtimeSafety::ViolationLog::getInstance();
+    const auto  violations   = violationLog.getNumViolations();
+    root->setProperty ("realtimeSafetyViolations", violations);
+   #endif
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+   #if REALTIME_SAFETY_CHECKS
+    if (violations > 0)
+    {
+        RealtimeSafety::ViolationLog::Record record;
+
+        for (int i = 0; violationLog.getRecord (i, record); ++i)
+            std::cerr << RealtimeSafety::ViolationLog::describe (record) << std::endl;
+
+        return fail (juce::String (violations) + " realtime-safety violations");
+    }
+   #endif
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+    MathBench.cpp  –  NewProjectMathBench: accuracy and speed of FastMath
+                      (see Shared/FastMath.h)
+
+    For exp2, log2, sin and tanh at each accuracy:
+
+      accuracy  the worst error over the function's documented domain,
+                swept evenly (log2 through every exponent), against the
+                double-precision std function; exits with 1 if any is past
+                its FastMath::Bounds entry
+      speed     nanoseconds per value of the block form over a buffer that
+                stays in L1, against the std function in the same loop
+
+    Both go through the block forms, so what's checked is the vectorised
+    code a caller gets.  Prints one JSON document.
+
+    Usage:
+      NewProjectMathBench  [--functions=exp2,log2,sin,tanh]
+                           [--points=4194304]  [--repeats=20000]
+                           [--out=results.json]
+  ==============================================================================
+*/
+
+#include "../../Shared/FastMath.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    constexpr int kTimingBlock = 1024;   // 4 KB in and out, well inside L1
+
+    // ── Options ──────────────────────────────────────────────────────────────
+    juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    // ── The functions ────────────────────────────────────────────────────────
+    using BlockFunction = void (*) (float*, const float*, int);
+
+    enum class ErrorKind { relative, absolute, perUnitOfResult };
+
+    struct Function
+    {
+        const char*   name;
+        const char*   domain;
+        ErrorKind     errorKind;
+        BlockFunction exact, fine, coarse;
+        float         fineBound, coarseBound;
+        double      (*reference) (double);
+        std::vector<float> (*inputs) (int numPoints);
+    };
+
+    std::vector<float> evenly (float lowest, float highest, int numPoints)
+    {
+        std::vector<float> inputs ((size_t) numPoints);
+
+        for (int i = 0; i < numPoints; ++i)
+            inputs[(size_t) i] = lowest + (highest - lowest) * (float) ((double) i / (numPoints - 1));
+
+        return inputs;
+    }
+
+    // Every exponent gets the same share of points, whatever its size
+    std::vector<float> positiveNormals (int numPoints)
+    {
+        constexpr juce::uint32 lowest = 0x00800000u, highest = 0x7f7fffffu;
+        std::vector<float> inputs ((size_t) numPoints);
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const auto bits = lowest + (juce::uint32) ((double) (highest - lowest) * i / (numPoints - 1));
+            std::memcpy (&inputs[(size_t) i], &bits, sizeof (float));
+        }
+
+        return inputs;
+    }
+
+    double exp2Reference (double x) { return std::exp2 (x); }
+    double log2Reference (double x) { return std::log2 (x); }
+    double sinReference  (double x) { return std::sin  (x); }
+    double tanhReference (double x) { return std::tanh (x); }
+
+    const Function functions[] =
+    {
+        { "exp2", "[-126, 127]",      ErrorKind::relative,
+          FastMath::exp2<FastMath::exact>, FastMath::exp2<FastMath::fine>, FastMath::exp2<FastMath::coarse>,
+          FastMath::Bounds::exp2Fine, FastMath::Bounds::exp2Coarse, exp2Reference,
+          [] (int n) { return evenly (-126.0f, 127.0f, n); } },
+
+        { "log2", "positive normals", ErrorKind::perUnitOfResult,
+          FastMath::log2<FastMath::exact>, FastMath::log2<FastMath::fine>, FastMath::log2<FastMath::coarse>,
+          FastMath::Bounds::log2Fine, FastMath::Bounds::log2Coarse, log2Reference,
+          positiveNormals },
+
+        { "sin",  "[-pi, pi]",        ErrorKind::absolute,
+          FastMath::sin<FastMath::exact>, FastMath::sin<FastMath::fine>, FastMath::sin<FastMath::coarse>,
+          FastMath::Bounds::sinFine, FastMath::Bounds::sinCoarse, sinReference,
+          [] (int n) { return evenly (-3.14159265f, 3.14159265f, n); } },
+
+        { "tanh", "[-20, 20]",        ErrorKind::absolute,
+          FastMath::tanh<FastMath::exact>, FastMath::tanh<FastMath::fine>, FastMath::tanh<FastMath::coarse>,
+          FastMath::Bounds::tanhFine, FastMath::Bounds::tanhCoarse, tanhReference,
+          [] (int n) { return evenly (-20.0f, 20.0f, n); } },
+    };
+
+    double errorOf (const Function& function, float input, float output)
+    {
+        const auto expected = function.reference ((double) input);
+        const auto error    = std::abs ((double) output - expected);
+
+        switch (function.errorKind)
+        {
+            case ErrorKind::relative:         return error / expected;
+            case ErrorKind::perUnitOfResult:  return error / juce::jmax (1.0, std::abs (expected));
+            case ErrorKind::absolute:         break;
+        }
+
+        return error;
+    }
+
+    // ── Accuracy ─────────────────────────────────────────────────────────────
+    struct Accuracy
+    {
+        double maxError = 0.0;
+        float  worstInput = 0.0f;
+    };
+
+    Accuracy measureAccuracy (const Function& function, BlockFunction block, const std::vector<float>& inputs)
+    {
+        std::vector<float> outputs (inputs.size());
+        block (outputs.data(), inputs.data(), (int) inputs.size());
+
+        Accuracy result;
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const auto error = errorOf (function, inputs[i], outputs[i]);
+
+            // NaN counts as the worst there is
+            if (! (error <= result.maxError))
+            {
+                result.maxError   = std::isnan (error) ? HUGE_VAL : error;
+                result.worstInput = inputs[i];
+            }
+        }
+
+        return result;
+    }
+
+    // ── Speed ────────────────────────────────────────────────────────────────
+    /** Nanoseconds per value, the best of five passes so a preempted one
+        doesn't count; the outputs are summed so nothing is optimised away. */
+    double measureSpeed (BlockFunction block, const std::vector<float>& inputs, int repeats, double& checksum)
+    {
+        std::vector<float> source ((size_t) kTimingBlock), dest ((size_t) kTimingBlock);
+
+        // An even spread of the domain, in a scrambled order
+        juce::Random random (1);
+
+        for (auto& x : source)
+            x = inputs[(size_t) random.nextInt ((int) inputs.size())];
+
+        auto best = HUGE_VAL;
+
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (int r = 0; r < repeats; ++r)
+            {
+                block (dest.data(), source.data(), kTimingBlock);
+                checksum += dest[(size_t) (r % kTimingBlock)];
+            }
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+            best = juce::jmin (best, seconds * 1.0e9 / ((double) repeats * kTimingBlock));
+        }
+
+        return best;
+    }
+
+    juce::var runFunction (const Function& function, int numPoints, int repeats, bool& allOk, double& checksum)
+    {
+        const auto inputs  = function.inputs (numPoints);
+        const auto exactNs = measureSpeed (function.exact, inputs, repeats, checksum);
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty ("function",  function.name);
+        run->setProperty ("domain",    function.domain);
+        run->setProperty ("error",     function.errorKind == ErrorKind::relative ? "relative"
+                                     : function.errorKind == ErrorKind::absolute ? "absolute"
+                                                                                 : "absolute, over max (1, |log2 x|)");
+        run->setProperty ("points",    numPoints);
+        run->setProperty ("stdNsPerValue", exactNs);
+
+        const auto addAccuracy = [&] (const char* name, BlockFunction block, float bound)
+        {
+            const auto accuracy = measureAccuracy (function, block, inputs);
+            const auto ns       = measureSpeed (block, inputs, repeats, checksum);
+            const auto ok       = accuracy.maxError <= bound;
+
+            if (! ok)
+            {
+                std::cerr << "NewProjectMathBench: " << function.name << " " << name << " error " << accuracy.maxError
+                          << " at " << accuracy.worstInput << " is past its bound of " << bound << std::endl;
+                allOk = false;
+            }
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("maxError",   accuracy.maxError);
+            result->setProperty ("worstInput", accuracy.worstInput);
+            result->setProperty ("bound",      bound);
+            result->setProperty ("ok",         ok);
+            result->setProperty ("nsPerValue", ns);
+            result->setProperty ("speedup",    ns > 0.0 ? exactNs / ns : 0.0);
+            run->setProperty (name, result);
+        };
+
+        addAccuracy ("fine",   function.fine,   function.fineBound);
+        addAccuracy ("coarse", function.coarse, function.coarseBound);
+        return run;
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "NewProjectMathBench: " << message << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    const auto names     = splitList (optionOr (args, "--functions", "exp2,log2,sin,tanh"));
+    const int  numPoints = optionOr (args, "--points",  "4194304").getIntValue();
+    const int  repeats   = optionOr (args, "--repeats", "20000").getIntValue();
+
+    if (numPoints < 2 || repeats <= 0)
+        return fail ("usage: NewProjectMathBench [--functions=exp2,log2,sin,tanh] [--points=4194304] "
+                     "[--repeats=20000] [--out=file.json]");
+
+    juce::Array<juce::var> runs;
+    bool   allOk    = true;
+    double checksum = 0.0;
+
+    for (const auto& name : names)
+    {
+        const Function* function = nullptr;
+
+        for (const auto& f : functions)
+            if (name == f.name)
+                function = &f;
+
+        if (function == nullptr)
+            return fail ("unknown function '" + name + "' (exp2, log2, sin or tanh)");
+
+        runs.add (runFunction (*function, numPoints, repeats, allOk, checksum));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool",     "NewProjectMathBench");
+    root->setProperty ("ok",       allOk);
+    root->setProperty ("checksum", checksum);
+    root->setProperty ("runs",     runs);
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+    RenderCheck.cpp  –  NewProjectRenderCheck: golden-output and timing
+                        regression check (see Shared/RenderHarness.h)
+
+    Renders with the CPU limiter off, so the voice cap never follows the
+    machine's load.  The golden files are the SIMD bank's; every render is
+    repeated on DSPVoices, which must sound the same within
+    --engine-tolerance (builds without SIMD play DSPVoices for both).
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "../../Shared/RenderHarness.h"
+
+namespace
+{
+    std::unique_ptr<juce::AudioProcessor> createProcessor (NewProjectAudioProcessor::VoiceEngine engine)
+    {
+        auto processor = std::make_unique<NewProjectAudioProcessor>();
+
+        if (auto* limiter = processor->apvts.getParameter ("cpuLimiter"))
+            limiter->setValueNotifyingHost (0.0f);
+
+        if (auto* voiceEngine = processor->apvts.getParameter ("voiceEngine"))
+            voiceEngine->setValueNotifyingHost (voiceEngine->convertTo0to1 ((float) engine));
+
+        return processor;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    return RenderHarness::run (argc, argv, "NewProject",
+                               [] { return createProcessor (NewProjectAudioProcessor::bankEngine); },
+                               [] { return createProcessor (NewProjectAudioProcessor::dspVoiceEngine); });
+}
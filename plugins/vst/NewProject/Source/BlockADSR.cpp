@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+    BlockADSR.cpp  –  BlockADSR implementation
+  ==============================================================================
+*/
+
+#include "BlockADSR.h"
+#include <cmath>
+
+void BlockADSR::noteOn() noexcept
+{
+    if (attackRate > 0.0f)
+    {
+        state = State::attack;
+    }
+    else if (decayRate > 0.0f)
+    {
+        envelopeVal = 1.0f;
+        state       = State::decay;
+    }
+    else
+    {
+        envelopeVal = parameters.sustain;
+        state       = State::sustain;
+    }
+}
+
+void BlockADSR::noteOff() noexcept
+{
+    if (state == State::idle)
+        return;
+
+    if (parameters.release > 0.0f)
+    {
+        releaseRate = (float) (envelopeVal / (parameters.release * sampleRate));
+        state       = State::release;
+    }
+    else
+    {
+        reset();
+    }
+}
+
+void BlockADSR::render (float* gains, int numSamples) noexcept
+{
+    while (numSamples > 0)
+    {
+        bool reachedEnd = false;
+        int  run        = numSamples;
+
+        switch (state)
+        {
+            case State::idle:
+                juce::FloatVectorOperations::fill (gains, 0.0f, numSamples);
+                return;
+
+            case State::sustain:
+                envelopeVal = parameters.sustain;
+                juce::FloatVectorOperations::fill (gains, envelopeVal, numSamples);
+                return;
+
+            case State::attack:  run = renderRamp (gains, numSamples,  attackRate,  1.0f,              reachedEnd); break;
+            case State::decay:   run = renderRamp (gains, numSamples, -decayRate,   parameters.sustain, reachedEnd); break;
+            case State::release: run = renderRamp (gains, numSamples, -releaseRate, 0.0f,              reachedEnd); break;
+        }
+
+        if (reachedEnd)
+            goToNextState();
+
+        gains      += run;
+        numSamples -= run;
+    }
+}
+
+int BlockADSR::renderRamp (float* gains, int numSamples, float step, float target, bool& reachedTarget) noexcept
+{
+    const float  start     = envelopeVal;
+    const double remaining = std::ceil ((double) (target - start) / (double) step);
+
+    reachedTarget = remaining <= (double) numSamples;
+    const int run = reachedTarget ? juce::jmax (1, (int) remaining) : numSamples;
+
+    for (int i = 0; i < run; ++i)
+        gains[i] = start + step * (float) (i + 1);
+
+    if (reachedTarget)
+        gains[run - 1] = target;
+
+    envelopeVal = gains[run - 1];
+    return run;
+}
+
+void BlockADSR::goToNextState() noexcept
+{
+    if (state == State::attack)
+        state = (decayRate > 0.0f ? State::decay : State::sustain);
+    else if (state == State::decay)
+        state = State::sustain;
+    else if (state == State::release)
+        reset();
+}
+
+void BlockADSR::recalculateRates() noexcept
+{
+    const auto getRate = [this] (float distance, float timeInSeconds)
+    {
+        return timeInSeconds > 0.0f ? (float) (distance / (timeInSeconds * sampleRate)) : -1.0f;
+    };
+
+    attackRate  = getRate (1.0f, parameters.attack);
+    decayRate   = getRate (1.0f - parameters.sustain, parameters.decay);
+    releaseRate = getRate (parameters.sustain, parameters.release);
+
+    if ((state == State::attack  && attackRate <= 0.0f)
+     || (state == State::decay   && (decayRate <= 0.0f || envelopeVal <= parameters.sustain))
+     || (state == State::release && releaseRate <= 0.0f))
+        goToNextState();
+}
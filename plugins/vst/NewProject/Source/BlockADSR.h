@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+    BlockADSR.h  –  juce::ADSR's envelope, rendered a block at a time
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** juce::ADSR's envelope, rendered a block at a time.
+
+    Every segment is a straight line (juce::ADSR steps by a constant rate),
+    so rather than stepping sample by sample, render() works out how many
+    samples are left in the current segment and writes that run in one go:
+    a ramp for attack, decay and release, a constant for sustain and idle.
+    Same parameters, states and transitions as juce::ADSR. */
+class BlockADSR
+{
+public:
+    void setSampleRate (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        recalculateRates();
+    }
+
+    void setParameters (const juce::ADSR::Parameters& newParameters)
+    {
+        parameters = newParameters;
+        recalculateRates();
+    }
+
+    void reset() noexcept
+    {
+        envelopeVal = 0.0f;
+        state       = State::idle;
+    }
+
+    bool  isActive() const noexcept { return state != State::idle; }
+    float getLevel() const noexcept { return envelopeVal; }
+
+    void noteOn() noexcept;
+    void noteOff() noexcept;
+
+    /** The next numSamples gains, as numSamples calls to
+        juce::ADSR::getNextSample() would return them. */
+    void render (float* gains, int numSamples) noexcept;
+
+private:
+    enum class State { idle, attack, decay, sustain, release };
+
+    /** Up to numSamples of the line from envelopeVal by `step` per sample,
+        stopping at the sample that reaches `target` (which is then written
+        as exactly `target`).  Returns the number of samples written. */
+    int renderRamp (float* gains, int numSamples, float step, float target, bool& reachedTarget) noexcept;
+
+    void goToNextState() noexcept;
+    void recalculateRates() noexcept;
+
+    juce::ADSR::Parameters parameters;
+    double                 sampleRate  = 44100.0;
+    State                  state       = State::idle;
+    float                  envelopeVal = 0.0f;
+    float                  attackRate  = 0.0f, decayRate = 0.0f, releaseRate = 0.0f;
+};
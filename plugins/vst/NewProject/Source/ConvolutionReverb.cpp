@@ -0,0 +1,434 @@
+/*
+  ==============================================================================
+    ConvolutionReverb.cpp  –  ConvolutionReverb implementation
+  ==============================================================================
+*/
+
+#include "ConvolutionReverb.h"
+#include "FDNReverb.h"
+#include <algorithm>
+#include <cmath>
+
+void TailConvolver::prepare (int maximumBlockSize)
+{
+    release();
+
+    partitionSize = juce::jmax (kMinPartition, juce::nextPowerOfTwo (2 * maximumBlockSize));
+    fftOrder      = juce::roundToInt (std::log2 (2 * partitionSize));
+    fft           = std::make_unique<juce::dsp::FFT> (fftOrder);
+
+    for (int s = 0; s < kSlots; ++s)
+    {
+        inputs[s] .setSize (kNumChannels, partitionSize);
+        outputs[s].setSize (kNumChannels, partitionSize);
+        inputs[s].clear();
+        outputStamps[s].store (-1);
+    }
+
+    for (auto& window : windows)
+        window.assign ((size_t) (2 * partitionSize), 0.0f);
+
+    transform.assign ((size_t) (2 * partitionSize), {});
+    fadeOut  .assign ((size_t) partitionSize, 0.0f);
+
+    // An impulse cut for another partition size would be misread
+    if (current != nullptr && current->partitionSize != partitionSize)
+        current.reset();
+
+    writeBlock = nextBlock = acceptFrom = 0;
+    fill = 0;
+    submitted.store (0);
+    clearFrom.store (0);
+    clearedFrom = -1;
+
+    startThread (juce::Thread::Priority::high);
+}
+
+void TailConvolver::release()
+{
+    signalThreadShouldExit();
+    wake.signal();
+    stopThread (1000);
+}
+
+std::unique_ptr<TailConvolver::Impulse> TailConvolver::makeImpulse (const juce::AudioBuffer<float>& ir) const
+{
+    const auto tailLength = ir.getNumSamples() - getHeadLength();
+
+    if (tailLength <= 0)
+        return nullptr;
+
+    auto impulse = std::make_unique<Impulse>();
+    impulse->partitionSize = partitionSize;
+    impulse->numPartitions = (tailLength + partitionSize - 1) / partitionSize;
+
+    const auto numBins = (size_t) (partitionSize + 1);
+    juce::dsp::FFT localFft (fftOrder);
+    std::vector<std::complex<float>> scratch ((size_t) (2 * partitionSize));
+    auto* samples = reinterpret_cast<float*> (scratch.data());
+
+    for (int ch = 0; ch < kNumChannels; ++ch)
+    {
+        const auto* source = ir.getReadPointer (juce::jmin (ch, ir.getNumChannels() - 1));
+        auto& spectra = impulse->spectra[ch];
+
+        spectra.resize (numBins * (size_t) impulse->numPartitions);
+        impulse->history[ch].assign (spectra.size(), {});
+
+        for (int j = 0; j < impulse->numPartitions; ++j)
+        {
+            const auto start = getHeadLength() + j * partitionSize;
+            const auto count = juce::jmin (partitionSize, ir.getNumSamples() - start);
+
+            std::fill (scratch.begin(), scratch.end(), std::complex<float>());
+            std::copy (source + start, source + start + count, samples);
+            localFft.performRealOnlyForwardTransform (samples, true);
+            std::copy (scratch.begin(), scratch.begin() + (std::ptrdiff_t) numBins, spectra.begin() + (std::ptrdiff_t) (numBins * (size_t) j));
+        }
+    }
+
+    return impulse;
+}
+
+void TailConvolver::setImpulse (std::unique_ptr<Impulse> impulse)
+{
+    std::unique_ptr<Impulse> superseded;   // freed here, outside the lock
+
+    const decltype (pendingLock)::ScopedLockType lock (pendingLock);
+    superseded = std::exchange (pending, std::move (impulse));
+    hasPending.store (true);
+}
+
+void TailConvolver::reset() noexcept
+{
+    fill       = 0;
+    acceptFrom = writeBlock;
+    clearFrom.store (writeBlock);
+}
+
+void TailConvolver::process (const float* const* input, float* const* output, int numSamples) noexcept
+{
+    for (int done = 0; done < numSamples;)
+    {
+        const auto playingBlock = writeBlock - 2;
+        const auto& played      = outputs[slotOf (playingBlock)];
+
+        // Heard whole or not at all
+        if (fill == 0)
+            playing = playingBlock >= acceptFrom
+                   && outputStamps[slotOf (playingBlock)].load (std::memory_order_acquire) == playingBlock;
+
+        const auto run = juce::jmin (numSamples - done, partitionSize - fill);
+
+        for (int ch = 0; ch < kNumChannels; ++ch)
+        {
+            juce::FloatVectorOperations::copy (inputs[slotOf (writeBlock)].getWritePointer (ch, fill), input[ch] + done, run);
+
+            if (playing)
+                juce::FloatVectorOperations::add (output[ch] + done, played.getReadPointer (ch, fill), run);
+        }
+
+        fill += run;
+        done += run;
+
+        if (fill == partitionSize)
+        {
+            fill = 0;
+            submitted.store (++writeBlock, std::memory_order_release);
+
+            if (processInline)
+            {
+                const RealtimeSafety::ScopedAllowance offline;   // no deadline to miss
+                processPending();
+            }
+            else
+                wake.signal();
+        }
+    }
+}
+
+void TailConvolver::run()
+{
+    while (! threadShouldExit())
+    {
+        wake.wait (100);
+        processPending();
+    }
+}
+
+void TailConvolver::processPending() noexcept
+{
+    const decltype (processLock)::ScopedLockType sl (processLock);
+
+    for (;;)
+    {
+        const auto available = submitted.load (std::memory_order_acquire);
+
+        if (nextBlock >= available)
+            return;
+
+        // Too far behind for anything still to be in time: start again
+        // from the newest block
+        if (available - nextBlock >= kSlots - 1)
+        {
+            nextBlock = available - 1;
+            clearHistory();
+        }
+
+        if (const auto from = clearFrom.load(); nextBlock >= from && clearedFrom != from)
+        {
+            clearHistory();
+            clearedFrom = from;
+        }
+
+        swapInPending();
+
+        // Overlap-save: the last two blocks of input
+        const auto& input = inputs[slotOf (nextBlock)];
+
+        for (int ch = 0; ch < kNumChannels; ++ch)
+        {
+            auto* window = windows[ch].data();
+            std::copy (window + partitionSize, window + 2 * partitionSize, window);
+            std::copy (input.getReadPointer (ch), input.getReadPointer (ch) + partitionSize, window + partitionSize);
+        }
+
+        // The audio thread may have lapped the slot while it was read
+        if (submitted.load (std::memory_order_acquire) - nextBlock >= kSlots)
+        {
+            clearHistory();
+            continue;
+        }
+
+        auto& output = outputs[slotOf (nextBlock)];
+
+        if (current != nullptr)
+        {
+            for (int ch = 0; ch < kNumChannels; ++ch)
+                convolve (ch, output.getWritePointer (ch));
+
+            outputStamps[slotOf (nextBlock)].store (nextBlock, std::memory_order_release);
+        }
+
+        previous.reset();   // faded out over this block; offline the only free on the audio thread
+        ++nextBlock;
+    }
+}
+
+void TailConvolver::swapInPending()
+{
+    if (! hasPending.load())
+        return;
+
+    std::unique_ptr<Impulse> incoming;
+
+    {
+        const decltype (pendingLock)::ScopedLockType lock (pendingLock);
+        incoming = std::move (pending);
+        hasPending.store (false);
+    }
+
+    if (incoming != nullptr && incoming->partitionSize != partitionSize)
+        return;
+
+    if (current != nullptr && incoming != nullptr)
+    {
+        const auto numBins = (size_t) (partitionSize + 1);
+        const auto carried = juce::jmin (current->numPartitions, incoming->numPartitions);
+
+        for (int ch = 0; ch < kNumChannels; ++ch)
+            for (int j = 1; j < carried; ++j)
+                std::copy_n (current ->history[ch].begin() + (std::ptrdiff_t) (numBins * historyIndex (*current,  nextBlock - j)), numBins,
+                             incoming->history[ch].begin() + (std::ptrdiff_t) (numBins * historyIndex (*incoming, nextBlock - j)));
+    }
+
+    previous = std::move (current);
+    current  = std::move (incoming);
+}
+
+void TailConvolver::convolve (int ch, float* output) noexcept
+{
+    const auto numBins = (size_t) (partitionSize + 1);
+    auto* samples = reinterpret_cast<float*> (transform.data());
+
+    std::copy (windows[ch].begin(), windows[ch].end(), samples);
+    fft->performRealOnlyForwardTransform (samples, true);
+
+    for (auto* impulse : { current.get(), previous.get() })
+        if (impulse != nullptr)
+            std::copy_n (transform.begin(), numBins, impulse->history[ch].begin() + (std::ptrdiff_t) (numBins * historyIndex (*impulse, nextBlock)));
+
+    accumulate (*current, ch, output);
+
+    // The block after a swap fades over from the last impulse
+    if (previous != nullptr)
+    {
+        accumulate (*previous, ch, fadeOut.data());
+
+        for (int i = 0; i < partitionSize; ++i)
+        {
+            const auto fade = (float) (i + 1) / (float) partitionSize;
+            output[i] = fadeOut[(size_t) i] + fade * (output[i] - fadeOut[(size_t) i]);
+        }
+    }
+}
+
+void TailConvolver::accumulate (const Impulse& impulse, int ch, float* output) noexcept
+{
+    const auto numBins = (size_t) (partitionSize + 1);
+    auto* sum = transform.data();
+
+    std::fill_n (sum, numBins, std::complex<float>());
+
+    for (int j = 0; j < impulse.numPartitions; ++j)
+    {
+        const auto* x = impulse.history[ch].data() + numBins * historyIndex (impulse, nextBlock - j);
+        const auto* h = impulse.spectra[ch].data() + numBins * (size_t) j;
+
+        for (size_t bin = 0; bin < numBins; ++bin)
+            sum[bin] += x[bin] * h[bin];
+    }
+
+    auto* samples = reinterpret_cast<float*> (transform.data());
+    fft->performRealOnlyInverseTransform (samples);
+    std::copy (samples + partitionSize, samples + 2 * partitionSize, output);
+}
+
+void TailConvolver::clearHistory() noexcept
+{
+    for (auto& window : windows)
+        std::fill (window.begin(), window.end(), 0.0f);
+
+    for (auto* impulse : { current.get(), previous.get() })
+        if (impulse != nullptr)
+            for (auto& history : impulse->history)
+                std::fill (history.begin(), history.end(), std::complex<float>());
+}
+
+juce::AudioBuffer<float> ConvolutionReverb::makeRoomImpulse (double sampleRate, float roomSize, float damping)
+{
+    const auto decay      = (double) FDNReverb::getDecaySeconds (roomSize);
+    const auto length     = juce::jmax (1, (int) (decay * sampleRate));
+    const auto fadeIn     = 0.005 * sampleRate;
+    const auto endCutoff  = juce::jmin ((double) FDNReverb::getDampingCutoff (damping), 0.45 * sampleRate);
+    const auto startCutoff = juce::jmin (20000.0, 0.45 * sampleRate);
+    const auto cutoffStep = std::pow (endCutoff / startCutoff, 1.0 / length);
+    const auto decayStep  = std::exp (std::log (0.001) / length);
+
+    juce::AudioBuffer<float> impulse (2, length);
+
+    for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+    {
+        juce::Random random (0x5eed + ch);
+        auto* samples = impulse.getWritePointer (ch);
+        auto  cutoff  = startCutoff;
+        auto  gain    = 1.0;
+        auto  state   = 0.0;
+
+        for (int n = 0; n < length; ++n)
+        {
+            const auto coefficient = std::exp (-juce::MathConstants<double>::twoPi * cutoff / sampleRate);
+            state += (1.0 - coefficient) * (random.nextFloat() * 2.0 - 1.0 - state);
+
+            samples[n] = (float) (state * gain * juce::jmin (1.0, n / fadeIn));
+            cutoff *= cutoffStep;
+            gain   *= decayStep;
+        }
+    }
+
+    return impulse;
+}
+
+void ConvolutionReverb::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    const juce::ScopedLock sl (configLock);
+
+    sampleRate = spec.sampleRate;
+    tail.prepare ((int) spec.maximumBlockSize);
+
+    if (head == nullptr)
+        head = std::make_unique<Head>();
+
+    head->convolution.prepare ({ spec.sampleRate, spec.maximumBlockSize, (juce::uint32) TailConvolver::kNumChannels });
+    load();
+}
+
+void ConvolutionReverb::release()
+{
+    const juce::ScopedLock sl (configLock);
+
+    tail.release();
+    sampleRate = 0.0;
+}
+
+void ConvolutionReverb::reset() noexcept
+{
+    if (head != nullptr)
+        head->convolution.reset();
+
+    tail.reset();
+}
+
+void ConvolutionReverb::setImpulseResponse (juce::AudioBuffer<float> impulse, double impulseSampleRate)
+{
+    const juce::ScopedLock sl (configLock);
+
+    source     = std::move (impulse);
+    sourceRate = impulseSampleRate;
+
+    if (sampleRate > 0.0)
+        load();
+}
+
+void ConvolutionReverb::process (const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept
+{
+    const float* input[]  { inLeft, inRight };
+    float*       output[] { outLeft, outRight };
+
+    juce::FloatVectorOperations::copy (outLeft,  inLeft,  numSamples);
+    juce::FloatVectorOperations::copy (outRight, inRight, numSamples);
+
+    juce::dsp::AudioBlock<float> block (output, TailConvolver::kNumChannels, (size_t) numSamples);
+    head->convolution.process (juce::dsp::ProcessContextReplacing<float> (block));
+    tail.process (input, output, numSamples);
+}
+
+void ConvolutionReverb::load()
+{
+    if (source.getNumSamples() == 0)
+        return;
+
+    const auto ratio  = sourceRate / sampleRate;
+    const auto length = juce::jmin ((int) (source.getNumSamples() / ratio), (int) (kMaxSeconds * sampleRate));
+
+    juce::AudioBuffer<float> impulse (TailConvolver::kNumChannels, juce::jmax (1, length));
+    juce::AudioBuffer<float> padded  (1, source.getNumSamples() + 8);   // what the interpolator reads past the end
+
+    for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+    {
+        padded.clear();
+        padded.copyFrom (0, 0, source, juce::jmin (ch, source.getNumChannels() - 1), 0, source.getNumSamples());
+
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process (ratio, padded.getReadPointer (0), impulse.getWritePointer (ch), impulse.getNumSamples());
+    }
+
+    auto energy = 0.0;
+
+    for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+        for (int n = 0; n < impulse.getNumSamples(); ++n)
+            energy += juce::square ((double) impulse.getSample (ch, n));
+
+    if (energy > 0.0)
+        impulse.applyGain ((float) std::sqrt (impulse.getNumChannels() / energy));
+
+    juce::AudioBuffer<float> headPart (impulse.getNumChannels(), juce::jmin (impulse.getNumSamples(), tail.getHeadLength()));
+
+    for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+        headPart.copyFrom (ch, 0, impulse, ch, 0, headPart.getNumSamples());
+
+    head->convolution.loadImpulseResponse (std::move (headPart), sampleRate, juce::dsp::Convolution::Stereo::yes,
+                                           juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+    tail.setImpulse (tail.makeImpulse (impulse));
+    lengthSeconds.store (impulse.getNumSamples() / sampleRate);
+}
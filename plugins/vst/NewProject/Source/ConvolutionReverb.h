@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+    ConvolutionReverb.h  –  The reverb's convolution engine: a zero-latency
+                            head on the audio thread and a partitioned tail
+                            on its own
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "../../Shared/RealtimeSafety.h"
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/** The late part of a convolution: the impulse response from
+    getHeadLength() on, convolved on its own thread.
+
+    Uniformly partitioned overlap-save in blocks of B samples (a power of
+    two, at least twice the host's block): each block of input is
+    transformed once, into a history of as many spectra as the tail has
+    partitions, and one multiply-add over that history gives the block's
+    output.  The tail starts 2B samples into the response, so the output
+    of block k is first heard a whole block after block k is handed over,
+    which is the worker's deadline; ConvolutionReverb covers the first 2B
+    samples itself, at zero latency.
+
+    The audio thread only copies samples in and out.  A block the worker
+    hasn't finished in time is left out rather than waited for; offline,
+    where nobody is listening in real time, setProcessInline() does the
+    work on the calling thread instead, so renders are exact. */
+class TailConvolver  : private juce::Thread
+{
+public:
+    static constexpr int kNumChannels  = 2;
+    static constexpr int kMinPartition = 1024;
+
+    /** The tail's partitions as spectra, with the input history they're
+        applied to.  Built by makeImpulse(), away from the audio thread. */
+    struct Impulse
+    {
+        int partitionSize = 0;
+        int numPartitions = 0;
+        std::vector<std::complex<float>> spectra[kNumChannels];   // numPartitions × (B + 1)
+        std::vector<std::complex<float>> history[kNumChannels];   // the last numPartitions input spectra
+    };
+
+    TailConvolver() : juce::Thread ("Reverb tail") {}
+    ~TailConvolver() override { release(); }
+
+    void prepare (int maximumBlockSize);
+
+    /** Stops the worker; prepare() starts it again. */
+    void release();
+
+    /** Where the tail takes over from the head, in samples. */
+    int getHeadLength() const noexcept { return 2 * partitionSize; }
+
+    /** Cuts ir (at the processing rate) from getHeadLength() on into
+        partitions, or returns nullptr if it ends before that.  Any thread
+        but the audio one; call after prepare(). */
+    std::unique_ptr<Impulse> makeImpulse (const juce::AudioBuffer<float>& ir) const;
+
+    /** Queues an impulse (or nullptr for none) that the worker swaps in at
+        the start of its next block, crossfading over that block. */
+    void setImpulse (std::unique_ptr<Impulse> impulse);
+
+    /** Offline: convolve on the audio thread, as each block completes,
+        instead of handing blocks to the worker.  Audio thread. */
+    void setProcessInline (bool shouldProcessInline) noexcept { processInline = shouldProcessInline; }
+
+    /** Drops the input so far; what the worker is still busy with is never
+        played.  Audio thread. */
+    void reset() noexcept;
+
+    /** Adds the tail for numSamples of input to output.  Audio thread. */
+    void process (const float* const* input, float* const* output, int numSamples) noexcept;
+
+private:
+    static constexpr int kSlots = 4;
+
+    static size_t slotOf (juce::int64 block) noexcept { return (size_t) ((block + kSlots) % kSlots); }   // block >= -kSlots
+
+    void run() override;
+
+    /** Convolves every block handed over and not yet done.  The worker, or
+        the audio thread when processing inline. */
+    void processPending() noexcept;
+
+    /** Takes up an impulse from setImpulse(), carrying the input history
+        over so the new tail picks up where the old one was. */
+    void swapInPending();
+
+    static size_t historyIndex (const Impulse& impulse, juce::int64 block) noexcept
+    {
+        return (size_t) (((block % impulse.numPartitions) + impulse.numPartitions) % impulse.numPartitions);
+    }
+
+    /** One channel's output for block nextBlock, from windows[ch]. */
+    void convolve (int ch, float* output) noexcept;
+
+    /** Σ history[k - j] · spectra[j] over the partitions, transformed back;
+        the last B samples of the window are the block's output. */
+    void accumulate (const Impulse& impulse, int ch, float* output) noexcept;
+
+    void clearHistory() noexcept;
+
+    int partitionSize = kMinPartition;
+    int fftOrder      = 0;
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    // Audio thread
+    juce::AudioBuffer<float> inputs[kSlots];
+    juce::int64  writeBlock = 0;    // the block being filled
+    juce::int64  acceptFrom = 0;    // first block whose output may be played
+    int          fill       = 0;
+    bool         playing    = false;
+    bool         processInline = false;
+
+    // Handed over
+    std::atomic<juce::int64> submitted { 0 };      // blocks complete
+    std::atomic<juce::int64> clearFrom { 0 };      // reset() at this block
+    juce::AudioBuffer<float> outputs[kSlots];
+    std::atomic<juce::int64> outputStamps[kSlots]; // the block each slot holds
+    juce::WaitableEvent      wake;
+
+    // Worker (or the audio thread inline), under processLock
+    RealtimeSafety::Checked<juce::CriticalSection> processLock;
+    juce::int64 nextBlock   = 0;
+    juce::int64 clearedFrom = -1;
+    std::vector<float> windows[kNumChannels];
+    std::vector<std::complex<float>> transform;   // 2B, room for the FFT's scratch
+    std::vector<float> fadeOut;
+    std::unique_ptr<Impulse> current, previous;
+
+    RealtimeSafety::Checked<juce::SpinLock> pendingLock;
+    std::unique_ptr<Impulse>                pending;              // guarded by pendingLock
+    std::atomic<bool>                       hasPending { false };
+};
+
+//==============================================================================
+/** The reverb's convolution engine: an impulse response split in two, each
+    part partitioned for where it runs.
+
+    The first TailConvolver::getHeadLength() samples go through a
+    zero-latency juce::dsp::Convolution on the audio thread, in partitions
+    of the host's block size; everything after that through a
+    TailConvolver, in partitions of at least 1024 samples on its own
+    thread.  A response of many seconds then costs the audio thread a few
+    short partitions per block, and nothing is added to the latency.
+
+    Responses are resampled to the processing rate and scaled to unit
+    energy per channel.  Until one is given there is no wet signal. */
+class ConvolutionReverb
+{
+public:
+    static constexpr double kMaxSeconds = 12.0;
+
+    /** A stereo room the length of FDNReverb's decay for these settings:
+        decorrelated noise under an exponential decay, through a lowpass
+        that closes towards FDNReverb::getDampingCutoff() as it dies. */
+    static juce::AudioBuffer<float> makeRoomImpulse (double sampleRate, float roomSize, float damping);
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+
+    /** Stops the tail's thread; nothing is loaded until the next
+        prepare(). */
+    void release();
+
+    /** Audio thread. */
+    void reset() noexcept;
+
+    /** Replaces the response, crossfading to it; loaded now if prepared,
+        or else by prepare().  Not the audio thread. */
+    void setImpulseResponse (juce::AudioBuffer<float> impulse, double impulseSampleRate);
+
+    /** The response's length, as heard.  Any thread. */
+    double getLengthSeconds() const noexcept { return lengthSeconds.load(); }
+
+    /** See TailConvolver::setProcessInline().  Audio thread. */
+    void setProcessTailInline (bool shouldProcessInline) noexcept { tail.setProcessInline (shouldProcessInline); }
+
+    /** Writes the wet signal.  Audio thread. */
+    void process (const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept;
+
+private:
+    /** Brings source to the processing rate and unit energy, then hands the
+        head to the Convolution (which loads it in the background) and the
+        tail to the TailConvolver.  Under configLock. */
+    void load();
+
+    // The zero-latency head.  A Convolution made without a queue starts a
+    // loading thread of its own; this one shares a single thread with
+    // every instance, and neither exists until the first prepare()
+    struct Head
+    {
+        juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> loadQueue;
+        juce::dsp::Convolution                                          convolution { *loadQueue.get() };
+    };
+
+    std::unique_ptr<Head>  head;
+    TailConvolver          tail;
+
+    juce::CriticalSection    configLock;   // prepare() against setImpulseResponse()
+    juce::AudioBuffer<float> source;
+    double                   sourceRate = 44100.0;
+    double                   sampleRate = 0.0;
+    std::atomic<double>      lengthSeconds { 0.0 };
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+    ExpressionCoalescer.cpp  –  ExpressionCoalescer implementation
+  ==============================================================================
+*/
+
+#include "ExpressionCoalescer.h"
+#include <algorithm>
+
+void ExpressionCoalescer::process (juce::MidiBuffer& midiMessages)
+{
+    coalesced.clear();
+
+    for (const auto metadata : midiMessages)
+    {
+        const auto* data = metadata.data;
+        const auto  slot = slotFor (data, metadata.numBytes);
+
+        if (slot < 0)
+        {
+            flush();
+            coalesced.addEvent (data, metadata.numBytes, metadata.samplePosition);
+            continue;
+        }
+
+        if (numPending > 0 && metadata.samplePosition >= quantumStart + quantum)
+            flush();
+
+        if (numPending == 0)
+            quantumStart = metadata.samplePosition;
+
+        auto& event = pending[(size_t) slot];
+
+        if (! event.queued)
+        {
+            event.queued = true;
+            order[(size_t) numPending++] = slot;
+        }
+
+        event.size = metadata.numBytes;
+        std::copy (data, data + metadata.numBytes, event.data);
+    }
+
+    flush();
+    midiMessages.swapWith (coalesced);
+}
+
+int ExpressionCoalescer::slotFor (const juce::uint8* data, int numBytes) noexcept
+{
+    if (numBytes < 2)
+        return -1;
+
+    const auto channel = data[0] & 0x0f;
+
+    switch (data[0] & 0xf0)
+    {
+        case 0xe0: return numBytes == 3 ? channel * numKinds + pitchWheelKind : -1;
+        case 0xd0: return channel * numKinds + pressureKind;
+        case 0xb0: return numBytes == 3 && data[1] == NoteExpression::kTimbreController
+                            ? channel * numKinds + timbreKind : -1;
+        default:   return -1;
+    }
+}
+
+void ExpressionCoalescer::flush()
+{
+    for (int i = 0; i < numPending; ++i)
+    {
+        auto& event = pending[(size_t) order[(size_t) i]];
+        coalesced.addEvent (event.data, event.size, quantumStart);
+        event.queued = false;
+    }
+
+    numPending = 0;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+    ExpressionCoalescer.h  –  Thins a block's MPE expression to one event per
+                              channel, kind and control quantum
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "NoteExpression.h"
+#include <array>
+
+//==============================================================================
+/** Thins out streamed expression before the synth sees it.
+
+    juce::Synthesiser splits its render at every MIDI event, so ten fingers
+    streaming pitch bend and CC74 cut a block into dozens of sub-renders.
+    Pitch bend, channel pressure and CC74 only set NoteExpression targets,
+    which the voices glide towards anyway, so within each quantum only the
+    latest of each per channel is kept, and all of them are moved to where
+    the quantum started: one split per quantum whatever the finger count.
+    Any other event closes the quantum first, so expression sent just
+    before a note-on (MPE resets the bend there) still arrives before it. */
+class ExpressionCoalescer
+{
+public:
+    static constexpr int kDefaultQuantum = NoteExpression::kControlSamples;
+
+    /** Reserves room for a block's worth of events, so process() doesn't
+        allocate in practice. */
+    void prepare (int maximumBlockSize)
+    {
+        coalesced.ensureSize ((size_t) maximumBlockSize * 3);
+        numPending = 0;
+    }
+
+    /** Samples per quantum; 1 keeps every event. */
+    void setQuantum (int numSamples) noexcept { quantum = juce::jmax (1, numSamples); }
+
+    void process (juce::MidiBuffer& midiMessages);
+
+private:
+    enum { pitchWheelKind, pressureKind, timbreKind, numKinds };
+    static constexpr int kNumSlots = 16 * numKinds;
+
+    struct PendingEvent
+    {
+        juce::uint8 data[3];
+        int         size   = 0;
+        bool        queued = false;
+    };
+
+    /** The channel and kind a coalescable event is kept under, or -1. */
+    static int slotFor (const juce::uint8* data, int numBytes) noexcept;
+
+    /** Emits the quantum's events, in the order they first arrived. */
+    void flush();
+
+    juce::MidiBuffer                     coalesced;
+    std::array<PendingEvent, kNumSlots>  pending;
+    std::array<int, kNumSlots>           order;   // the first numPending are queued
+    int                                  numPending   = 0;
+    int                                  quantumStart = 0;
+    int                                  quantum      = kDefaultQuantum;
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+    ExpressionSmoother.h  –  A one-euro filter for expression targets, and the
+                             settings it follows
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <cmath>
+#include <type_traits>
+
+//==============================================================================
+/** How NoteExpression's smoothers follow their targets (see
+    ExpressionSmoother).  The defaults glide like a 5 ms one-pole, which
+    suits MIDI's dense streams; a controller sending sparse updates wants a
+    lower minCutoffHz, with some beta so fast gestures still keep up. */
+struct ExpressionSmoothing
+{
+    float minCutoffHz = 30.0f;   // at rest
+    float beta        = 0.0f;    // Hz more per semitone a second the target moves
+};
+
+//==============================================================================
+/** A one-euro filter (Casiez et al., as virtual-key's filters.py) for an
+    expression target, stepped once per control step: a one-pole lowpass
+    whose cutoff rises with how fast the target is moving.  At rest it
+    glides across the gaps between a controller's sparse updates; in a
+    fast gesture it opens up so the sound doesn't lag.
+
+    Type is float for one voice, or juce::dsp::SIMDRegister<float> for a
+    lane per voice, as LadderCore.  The coefficient is the forward-Euler
+    2 pi fc / step rate, clamped to 1, so a step has no divide or exp. */
+template <typename Type>
+class ExpressionSmoother
+{
+public:
+    /** stepRate: steps per second. */
+    void prepare (double stepRate) noexcept
+    {
+        stepsPerSecond  = (float) stepRate;
+        omega           = (float) (juce::MathConstants<double>::twoPi / stepRate);
+        derivativeAlpha = juce::jmin (1.0f, omega * kDerivativeCutoffHz);
+        setResponse (response);
+    }
+
+    void setResponse (const ExpressionSmoothing& newResponse) noexcept
+    {
+        response  = newResponse;
+        restAlpha = omega * juce::jmax (0.0f, response.minCutoffHz);
+        speedGain = omega * juce::jmax (0.0f, response.beta);
+    }
+
+    /** Jumps to value, at rest. */
+    void reset (float value) noexcept
+    {
+        smoothed = lastTarget = broadcast (value);
+        derivative = broadcast (0.0f);
+    }
+
+    /** As reset(), for one lane of a SIMDRegister Type. */
+    void resetLane (size_t lane, float value) noexcept
+    {
+        smoothed  .set (lane, value);
+        lastTarget.set (lane, value);
+        derivative.set (lane, 0.0f);
+    }
+
+    Type step (Type target) noexcept
+    {
+        derivative = derivative + ((target - lastTarget) * stepsPerSecond - derivative) * derivativeAlpha;
+        lastTarget = target;
+
+        const auto alpha = minimum (absolute (derivative) * speedGain + restAlpha, 1.0f);
+        smoothed = smoothed + (target - smoothed) * alpha;
+        return smoothed;
+    }
+
+private:
+    static constexpr float kDerivativeCutoffHz = 1.0f;   // filters.py's d_cutoff
+
+    static Type broadcast (float value) noexcept
+    {
+        if constexpr (std::is_same_v<Type, float>)
+            return value;
+        else
+            return Type::expand (value);
+    }
+
+    static Type minimum (Type x, float limit) noexcept
+    {
+        if constexpr (std::is_same_v<Type, float>)
+            return juce::jmin (x, limit);
+        else
+            return Type::min (x, Type::expand (limit));
+    }
+
+    static Type absolute (Type x) noexcept
+    {
+        if constexpr (std::is_same_v<Type, float>)
+            return std::abs (x);
+        else
+            return Type::max (x, Type::expand (0.0f) - x);
+    }
+
+    Type                smoothed {}, lastTarget {}, derivative {};
+    ExpressionSmoothing response;
+    float               stepsPerSecond  = 1.0f;
+    float               omega           = 0.0f;   // 2 pi / stepsPerSecond
+    float               derivativeAlpha = 1.0f;
+    float               restAlpha       = 1.0f;   // unprepared: no smoothing
+    float               speedGain       = 0.0f;
+};
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+    FDNReverb.cpp  –  FDNReverb implementation
+  ==============================================================================
+*/
+
+#include "FDNReverb.h"
+#include <algorithm>
+
+void FDNReverb::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    const auto longest   = (kDelayMs[kNumLines - 1] + kModulationMs) * 0.001 * sampleRate + 2.0;
+    const auto numFrames = juce::nextPowerOfTwo ((int) std::ceil (longest));
+
+    memory.assign ((size_t) (numFrames * kNumChunks), expand (0.0f));
+    frameMask = numFrames - 1;
+
+    for (int i = 0; i < kNumLines; ++i)
+    {
+        const auto chunk = i / kLinesPerChunk;
+        const auto lane  = i % kLinesPerChunk;
+        const auto omega = juce::MathConstants<double>::twoPi * kLfoHz[i] / sampleRate;
+
+        setLane (delays[chunk],      lane, (float) (kDelayMs[i] * 0.001 * sampleRate));
+        setLane (rotationCos[chunk], lane, (float) std::cos (omega));
+        setLane (rotationSin[chunk], lane, (float) std::sin (omega));
+        setLane (inputSigns[chunk],  lane, kInputSigns[i]);
+        setLane (leftSigns[chunk],   lane, kLeftSigns[i]);
+        setLane (rightSigns[chunk],  lane, kRightSigns[i]);
+    }
+
+    depth     = (float) (kModulationMs * 0.001 * sampleRate);
+    smoothing = (float) (1.0 - std::exp (-1.0 / (0.05 * sampleRate)));   // 50 ms
+
+    setRoom (roomSize, damping);
+    reset();
+}
+
+void FDNReverb::reset() noexcept
+{
+    std::fill (memory.begin(), memory.end(), expand (0.0f));
+    writeFrame = 0;
+
+    for (int c = 0; c < kNumChunks; ++c)
+    {
+        lowpass[c] = expand (0.0f);
+        gains[c]   = gainTargets[c];
+        dampings[c] = dampingTarget;
+
+        // LFO phases spread round the circle
+        for (int lane = 0; lane < kLinesPerChunk; ++lane)
+        {
+            const auto phase = juce::MathConstants<float>::twoPi * (float) (c * kLinesPerChunk + lane) / (float) kNumLines;
+            setLane (sines[c],   lane, std::sin (phase));
+            setLane (cosines[c], lane, std::cos (phase));
+        }
+    }
+}
+
+void FDNReverb::setRoom (float newRoomSize, float newDamping) noexcept
+{
+    roomSize = newRoomSize;
+    damping  = newDamping;
+
+    // A line of d samples loses 60 dB over the decay time in
+    // decay / d trips round the loop
+    const auto decaySamples = getDecaySeconds (roomSize) * (float) sampleRate;
+
+    for (int i = 0; i < kNumLines; ++i)
+        setLane (gainTargets[i / kLinesPerChunk], i % kLinesPerChunk,
+                 std::pow (0.001f, getLane (delays[i / kLinesPerChunk], i % kLinesPerChunk) / decaySamples));
+
+    const auto cutoff = juce::jmin (getDampingCutoff (damping), 0.45f * (float) sampleRate);
+    dampingTarget = expand (std::exp (-juce::MathConstants<float>::twoPi * cutoff / (float) sampleRate));
+}
+
+void FDNReverb::process (const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept
+{
+    for (int n = 0; n < numSamples; ++n)
+    {
+        Lines taps[kNumChunks];
+
+        // The modulated reads, linearly interpolated, line by line
+        for (int c = 0; c < kNumChunks; ++c)
+        {
+            const auto position = delays[c] + sines[c] * depth;
+
+            for (int lane = 0; lane < kLinesPerChunk; ++lane)
+            {
+                const auto delay    = getLane (position, lane);
+                const auto whole    = (int) delay;
+                const auto fraction = delay - (float) whole;
+                const auto newer    = getLane (memory[(size_t) (((writeFrame - whole)     & frameMask) * kNumChunks + c)], lane);
+                const auto older    = getLane (memory[(size_t) (((writeFrame - whole - 1) & frameMask) * kNumChunks + c)], lane);
+
+                setLane (taps[c], lane, newer + fraction * (older - newer));
+            }
+        }
+
+        float sum = 0.0f, left = 0.0f, right = 0.0f;
+
+        for (int c = 0; c < kNumChunks; ++c)
+        {
+            gains[c]    = gains[c]    + (gainTargets[c] - gains[c])    * smoothing;
+            dampings[c] = dampings[c] + (dampingTarget  - dampings[c]) * smoothing;
+            lowpass[c]  = taps[c]     + (lowpass[c]     - taps[c])     * dampings[c];
+            taps[c]     = lowpass[c] * gains[c];
+
+            sum   += sumLanes (taps[c]);
+            left  += sumLanes (taps[c] * leftSigns[c]);
+            right += sumLanes (taps[c] * rightSigns[c]);
+
+            const auto sine = sines[c];
+            sines[c]   = sine       * rotationCos[c] + cosines[c] * rotationSin[c];
+            cosines[c] = cosines[c] * rotationCos[c] - sine       * rotationSin[c];
+        }
+
+        const auto reflection = sum * (2.0f / (float) kNumLines);
+        const auto input      = (inLeft[n] + inRight[n]) * (0.5f * kInputGain);
+
+        writeFrame = (writeFrame + 1) & frameMask;
+
+        for (int c = 0; c < kNumChunks; ++c)
+            memory[(size_t) (writeFrame * kNumChunks + c)] = taps[c] - reflection + inputSigns[c] * input;
+
+        outLeft[n]  = left  * kOutputGain;
+        outRight[n] = right * kOutputGain;
+    }
+
+    // The LFO rotations creep off the unit circle; one Newton step
+    // towards 1 / |z| per block pulls them back
+    for (int c = 0; c < kNumChunks; ++c)
+    {
+        const auto correction = (expand (3.0f) - (sines[c] * sines[c] + cosines[c] * cosines[c])) * 0.5f;
+        sines[c]   = sines[c]   * correction;
+        cosines[c] = cosines[c] * correction;
+    }
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+    FDNReverb.h  –  The reverb's default engine, an eight-line feedback
+                    delay network
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/** An eight-line feedback delay network, the reverb's default engine.
+
+    Every line is a delay of 29.7 … 73.3 ms whose read point wanders by up
+    to 0.3 ms on its own slow LFO, so the tail never settles into a ring,
+    followed by a one-pole lowpass (damping) and the gain that gives the
+    decay time (room size).  The lines feed back through a Householder
+    reflection, x - (2/8) Σx, which spreads every line into all the others
+    for one sum per sample.
+
+    The lines are stepped as juce::dsp::SIMDRegister chunks (two with SSE
+    or NEON, one with AVX) and their delay memory holds a frame of all
+    eight per sample, so each sample is written with whole-register stores
+    and only the modulated reads go line by line.  The work per sample is
+    fixed, whatever the decay time. */
+class FDNReverb
+{
+public:
+   #if JUCE_USE_SIMD
+    using Lines = juce::dsp::SIMDRegister<float>;
+    static constexpr int kLinesPerChunk = (int) Lines::SIMDNumElements;
+   #else
+    using Lines = float;
+    static constexpr int kLinesPerChunk = 1;
+   #endif
+
+    static constexpr int kNumLines  = 8;
+    static constexpr int kNumChunks = kNumLines / kLinesPerChunk;
+    static_assert (kNumLines % kLinesPerChunk == 0, "the lines must fill whole registers");
+
+    /** Seconds to fall by 60 dB at a room size of 0 … 1: 0.2 s up to 10 s. */
+    static float getDecaySeconds (float roomSize) noexcept { return 0.2f * std::pow (50.0f, roomSize); }
+
+    /** The lowpass every line (and the convolution engine's room) ends up
+        at for a damping of 0 … 1: 20 kHz down to 400 Hz. */
+    static float getDampingCutoff (float damping) noexcept { return 20000.0f * std::pow (0.02f, damping); }
+
+    void prepare (double newSampleRate);
+    void reset() noexcept;
+
+    /** Room size sets the decay time, damping each line's lowpass (see
+        getDecaySeconds() and getDampingCutoff()).  Both glide over 50 ms. */
+    void setRoom (float newRoomSize, float newDamping) noexcept;
+
+    /** Writes the wet signal of numSamples of stereo input, fed to the
+        lines as mono. */
+    void process (const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept;
+
+private:
+   #if JUCE_USE_SIMD
+    static Lines expand   (float value) noexcept                      { return Lines::expand (value); }
+    static float getLane  (const Lines& chunk, int lane) noexcept     { return chunk.get ((size_t) lane); }
+    static void  setLane  (Lines& chunk, int lane, float value) noexcept { chunk.set ((size_t) lane, value); }
+    static float sumLanes (const Lines& chunk) noexcept               { return chunk.sum(); }
+   #else
+    static Lines expand   (float value) noexcept                      { return value; }
+    static float getLane  (float chunk, int) noexcept                 { return chunk; }
+    static void  setLane  (float& chunk, int, float value) noexcept   { chunk = value; }
+    static float sumLanes (float chunk) noexcept                      { return chunk; }
+   #endif
+
+    // Mutually prime-ish lengths, so no two lines' echoes pile up together
+    static constexpr double kDelayMs[kNumLines] { 29.7, 37.1, 41.1, 43.7, 53.3, 59.9, 67.1, 73.3 };
+    static constexpr double kLfoHz[kNumLines]   { 0.31, 0.37, 0.43, 0.53, 0.61, 0.71, 0.83, 0.97 };
+    static constexpr double kModulationMs = 0.3;
+
+    // Three rows of an 8x8 Hadamard matrix: the input and the two outputs
+    // see the lines through orthogonal sign patterns, which keeps left and
+    // right uncorrelated
+    static constexpr float kInputSigns[kNumLines] { 1, -1,  1, -1,  1, -1,  1, -1 };
+    static constexpr float kLeftSigns[kNumLines]  { 1,  1, -1, -1,  1,  1, -1, -1 };
+    static constexpr float kRightSigns[kNumLines] { 1, -1, -1,  1,  1, -1, -1,  1 };
+    static constexpr float kInputGain  = 0.5f;
+    static constexpr float kOutputGain = 1.2f;
+
+    std::vector<Lines> memory;   // a frame of kNumChunks registers per sample
+    int frameMask  = 0;
+    int writeFrame = 0;
+
+    Lines delays[kNumChunks] {}, gains[kNumChunks] {}, gainTargets[kNumChunks] {};
+    Lines lowpass[kNumChunks] {}, dampings[kNumChunks] {};
+    Lines sines[kNumChunks] {}, cosines[kNumChunks] {}, rotationCos[kNumChunks] {}, rotationSin[kNumChunks] {};
+    Lines inputSigns[kNumChunks] {}, leftSigns[kNumChunks] {}, rightSigns[kNumChunks] {};
+    Lines dampingTarget {};
+
+    double sampleRate = 44100.0;
+    float  depth      = 0.0f;   // samples of modulation
+    float  smoothing  = 1.0f;
+    float  roomSize   = 0.5f;
+    float  damping    = 0.5f;
+};
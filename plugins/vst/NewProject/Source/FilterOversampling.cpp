@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+    FilterOversampling.cpp  –  FilterOversampling implementation
+  ==============================================================================
+*/
+
+#include "FilterOversampling.h"
+
+std::unique_ptr<juce::dsp::Oversampling<float>> FilterOversampling::create (size_t numChannels, size_t maximumBlockSize) const
+{
+    if (factorLog2 == 0)
+        return nullptr;
+
+    using Oversampling = juce::dsp::Oversampling<float>;
+
+    auto oversampling = std::make_unique<Oversampling> (numChannels, (size_t) factorLog2,
+                                                         linearPhase ? Oversampling::filterHalfBandFIREquiripple
+                                                                     : Oversampling::filterHalfBandPolyphaseIIR,
+                                                         true, true);   // max quality, whole-sample latency
+    oversampling->initProcessing (maximumBlockSize);
+    return oversampling;
+}
+
+int FilterOversampling::getLatencyInSamples() const
+{
+    const auto oversampling = create (1, 1);
+    return oversampling != nullptr ? juce::roundToInt (oversampling->getLatencyInSamples()) : 0;
+}
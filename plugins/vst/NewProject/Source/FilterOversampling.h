@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+    FilterOversampling.h  –  How far the voices' filter is oversampled
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+
+//==============================================================================
+/** How far above the base rate the voices run their ladder filter, the
+    one nonlinear stage and the one that aliases: off, 2x or 4x, through
+    polyphase IIR half-bands (low latency) or equiripple FIR ones (linear
+    phase).  The oscillators, envelope and mix stay at the base rate. */
+struct FilterOversampling
+{
+    int  factorLog2  = 0;       // 0 = off, 1 = 2x, 2 = 4x
+    bool linearPhase = false;   // FIR rather than IIR half-bands
+
+    int getFactor() const noexcept { return 1 << factorLog2; }
+
+    /** An oversampler for numChannels mono signals, ready for blocks of up
+        to maximumBlockSize base-rate samples; nullptr when off. */
+    std::unique_ptr<juce::dsp::Oversampling<float>> create (size_t numChannels, size_t maximumBlockSize) const;
+
+    /** Base-rate samples the filtered signal lags behind; 0 when off. */
+    int getLatencyInSamples() const;
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+    LadderCore.h  –  The voices' ladder lowpass, with a per-sample cutoff
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <cmath>
+
+//==============================================================================
+/** juce::dsp::LadderFilter's LPF12 mode at resonance 0.7 and drive 1.2,
+    taking its cutoff per sample as the coefficient exp (-2 pi fc / fs), so
+    a modulated cutoff needs neither smoothing nor sub-blocks.
+
+    Type is float for one voice, or juce::dsp::SIMDRegister<float> for one
+    filter per lane.  LadderFilter's tanh table becomes a clamped [5/4] Padé
+    approximant (within 1.3e-3 of it); SIMDRegister has no divide, so the
+    reciprocal is a linear guess refined by four Newton steps. */
+template <typename Type>
+class LadderCore
+{
+public:
+    static constexpr size_t kNumStages = 5;
+
+    void reset() noexcept
+    {
+        for (auto& s : stage)
+            s = broadcast (0.0f);
+    }
+
+    /** Clears one lane's state, for a SIMDRegister Type. */
+    void resetLane (size_t lane) noexcept
+    {
+        for (auto& s : stage)
+            s.set (lane, 0.0f);
+    }
+
+    /** One lane's state, kNumStages floats, for a SIMDRegister Type: to keep,
+        and to put back with setLane(). */
+    void copyLane (size_t lane, float* state) const noexcept
+    {
+        for (size_t i = 0; i < kNumStages; ++i)
+            state[i] = stage[i].get (lane);
+    }
+
+    void setLane (size_t lane, const float* state) noexcept
+    {
+        for (size_t i = 0; i < kNumStages; ++i)
+            stage[i].set (lane, state[i]);
+    }
+
+    Type processSample (Type input, Type a1) noexcept
+    {
+        const auto g  = broadcast (1.0f) - a1;
+        const auto b0 = g * 0.76923076923f;
+        const auto b1 = g * 0.23076923076f;
+
+        auto& s = stage;
+        const auto dx = saturate (input * drive) * driveGain;
+        const auto a  = dx + (saturate (s[4] * drive2) * drive2Gain - dx * 0.5f) * (resonance * -4.0f);
+        const auto b  = b1 * s[0] + a1 * s[1] + b0 * a;
+        const auto c  = b1 * s[1] + a1 * s[2] + b0 * b;
+        const auto d  = b1 * s[2] + a1 * s[3] + b0 * c;
+        const auto e  = b1 * s[3] + a1 * s[4] + b0 * d;
+        s[0] = a;  s[1] = b;  s[2] = c;  s[3] = d;  s[4] = e;
+
+        return c * 1.2f;   // LPF12 tap, with LadderFilter's output gain
+    }
+
+private:
+    static Type broadcast (float value) noexcept
+    {
+        if constexpr (std::is_same_v<Type, float>)
+            return value;
+        else
+            return Type::expand (value);
+    }
+
+    static Type clampTo (Type x, float limit) noexcept
+    {
+        if constexpr (std::is_same_v<Type, float>)
+            return juce::jlimit (-limit, limit, x);
+        else
+            return Type::min (Type::max (x, Type::expand (-limit)), Type::expand (limit));
+    }
+
+    /** tanh: x (945 + 105x² + x⁴) / (945 + 420x² + 15x⁴), clamped where it
+        meets 1. */
+    static Type saturate (Type x) noexcept
+    {
+        x = clampTo (x, 3.6f);
+
+        const auto u           = x * x;
+        const auto numerator   = x * ((u + 105.0f) * u + 945.0f);
+        const auto denominator = (u * 15.0f + 420.0f) * u + 945.0f;
+
+        auto reciprocal = u * -4.1058e-5f + 5.9788e-4f;
+        for (int i = 0; i < 4; ++i)
+            reciprocal = reciprocal * (broadcast (2.0f) - denominator * reciprocal);
+
+        return numerator * reciprocal;
+    }
+
+    // LadderFilter's coefficients for resonance 0.7 and drive 1.2
+    static constexpr float resonance  = 0.1f + 0.7f * 0.9f;
+    static constexpr float drive      = 1.2f;
+    static constexpr float drive2     = drive * 0.04f + 0.96f;
+    static inline const float driveGain  = std::pow (drive,  -2.642f) * 0.6103f + 0.3903f;
+    static inline const float drive2Gain = std::pow (drive2, -2.642f) * 0.6103f + 0.3903f;
+
+    Type stage[kNumStages] {};
+};
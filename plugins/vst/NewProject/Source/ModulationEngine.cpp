@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+    ModulationEngine.cpp  –  ModulationEngine implementation
+  ==============================================================================
+*/
+
+#include "ModulationEngine.h"
+
+void ModulationEngine::prepare (double newSampleRate, int maximumBlockSize, int maximumOversamplingFactor)
+{
+    baseSampleRate = newSampleRate;
+    cutoffCoefficients.resize ((size_t) (maximumBlockSize * maximumOversamplingFactor));
+    setResolution (1, false);
+}
+
+void ModulationEngine::setResolution (int newOversamplingFactor, bool everySample) noexcept
+{
+    oversamplingFactor = newOversamplingFactor;
+    sampleRate         = baseSampleRate * oversamplingFactor;
+    controlPeriod      = everySample ? 1 : juce::jmax (1, juce::roundToInt (sampleRate / kControlRateHz));
+    reset();
+}
+
+void ModulationEngine::reset() noexcept
+{
+    lfoPhase           = 0.0f;
+    coefficient        = target = cutoffCoefficientAt (lfoPhase);
+    step               = 0.0f;
+    samplesToNextPoint = 0;
+}
+
+void ModulationEngine::process (int numSamples) noexcept
+{
+    auto* out = cutoffCoefficients.data();
+    numSamples *= oversamplingFactor;
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        if (samplesToNextPoint == 0)
+        {
+            lfoPhase += juce::MathConstants<float>::twoPi * lfoFrequencyHz
+                          * (float) controlPeriod / (float) sampleRate;
+
+            if (lfoPhase >= juce::MathConstants<float>::twoPi)
+                lfoPhase -= juce::MathConstants<float>::twoPi;
+
+            target             = cutoffCoefficientAt (lfoPhase);
+            step               = (target - coefficient) / (float) controlPeriod;
+            samplesToNextPoint = controlPeriod;
+        }
+
+        const auto run = juce::jmin (numSamples - pos, samplesToNextPoint);
+
+        for (int i = 0; i < run; ++i)
+            out[pos + i] = coefficient + step * (float) (i + 1);
+
+        pos                += run;
+        samplesToNextPoint -= run;
+        coefficient         = samplesToNextPoint == 0 ? target : coefficient + step * (float) run;
+    }
+}
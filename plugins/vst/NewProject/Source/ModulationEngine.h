@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+    ModulationEngine.h  –  The block's control signals, worked out once before
+                           the voices render
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../../Shared/FastMath.h"
+#include <vector>
+
+//==============================================================================
+/** Control signals for a whole block, worked out once before any voice
+    renders.
+
+    One LFO, shared by every voice, sweeps the filter cutoff between 100 Hz
+    and 2 kHz, or less of that range about its midpoint as its depth is
+    turned down; at depth 0 the cutoff stands still.  It is evaluated kControlRateHz times a second, whatever the
+    sample rate (or every sample, for offline renders), and the cutoff
+    coefficient is interpolated linearly in between, so the voices read a
+    smooth per-sample curve and never have to split their blocks.  With the
+    filter oversampled, the curve is worked out at the filter's rate,
+    oversamplingFactor points per sample. */
+class ModulationEngine
+{
+public:
+    static constexpr double kControlRateHz = 500.0;
+    static constexpr float  kMinCutoffHz   = 100.0f;    // the LFO's sweep at full depth
+    static constexpr float  kMaxCutoffHz   = 2000.0f;
+
+    void prepare (double newSampleRate, int maximumBlockSize, int maximumOversamplingFactor = 1);
+
+    /** Sets the filter's oversampling factor, no more than prepare() was
+        given, and whether to evaluate the LFO at every filter sample rather
+        than kControlRateHz.  Resets, but never allocates. */
+    void setResolution (int newOversamplingFactor, bool everySample) noexcept;
+
+    int getOversamplingFactor() const noexcept { return oversamplingFactor; }
+
+    void reset() noexcept;
+
+    void setLfoFrequency (float newFrequencyHz) noexcept { lfoFrequencyHz = newFrequencyHz; }
+
+    /** How far the LFO sweeps the cutoff, 0 … 1 of kMinCutoffHz … kMaxCutoffHz;
+        at 0 the cutoff stays at their midpoint.  From the next control point. */
+    void setLfoDepth (float newDepth) noexcept { lfoDepth = juce::jlimit (0.0f, 1.0f, newDepth); }
+    float getLfoDepth() const noexcept         { return lfoDepth; }
+
+    /** Works out the next numSamples (at the base rate) of every signal.
+        Audio thread, once per block, before the voices render. */
+    void process (int numSamples) noexcept;
+
+    /** One LadderCore coefficient per filter sample of the block process()
+        last worked out, from its first sample: base-rate sample n starts at
+        n * getOversamplingFactor(). */
+    const float* getCutoffCoefficients() const noexcept { return cutoffCoefficients.data(); }
+
+private:
+    float cutoffCoefficientAt (float phase) const noexcept
+    {
+        const auto cutoffHz = juce::jmap (FastMath::sin (phase) * lfoDepth, -1.0f, 1.0f, kMinCutoffHz, kMaxCutoffHz);
+        return FastMath::exp (cutoffHz * -juce::MathConstants<float>::twoPi / (float) sampleRate);
+    }
+
+    double             baseSampleRate = 44100.0;
+    double             sampleRate     = 44100.0;   // the filter's
+    int                oversamplingFactor = 1;
+    int                controlPeriod  = 88;   // samples
+    float              lfoFrequencyHz = 3.0f;
+    float              lfoDepth       = 1.0f;
+    float              lfoPhase       = 0.0f; // radians
+    float              coefficient    = 0.0f, target = 0.0f, step = 0.0f;
+    int                samplesToNextPoint = 0;
+    std::vector<float> cutoffCoefficients;   // one block, sized in prepare()
+};
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+    NoteCache.cpp  –  NoteCache implementation
+  ==============================================================================
+*/
+
+#include "NoteCache.h"
+
+#if JUCE_USE_SIMD
+
+void NoteCache::allocate (DspArena& arena, double sampleRate) noexcept
+{
+    const auto samples = (int) std::ceil (sampleRate * kLengthMs / 1000.0);
+    length = (samples + kSnapshotSamples - 1) / kSnapshotSamples * kSnapshotSamples;
+
+    for (auto& entry : entries)
+    {
+        for (auto& side : entry.samples)
+            side = arena.allocate<float> ((size_t) length);
+
+        entry.snapshots = arena.allocate<Snapshot> ((size_t) (length / kSnapshotSamples + 1));
+    }
+
+    clear();
+}
+
+void NoteCache::clear() noexcept
+{
+    for (auto& entry : entries)
+    {
+        entry.note     = -1;
+        entry.complete = false;
+    }
+}
+
+int NoteCache::find (int note, int bucket) const noexcept
+{
+    for (int e = 0; e < kMaxEntries; ++e)
+        if (entries[(size_t) e].note == note && entries[(size_t) e].bucket == bucket)
+            return e;
+
+    return -1;
+}
+
+#endif
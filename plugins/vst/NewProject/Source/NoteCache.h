@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+    NoteCache.h  –  The first milliseconds of notes as the voice bank
+                    rendered them, to play back
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "LadderCore.h"
+#include "NoteExpression.h"
+#include "UnisonOscillator.h"
+#include "../../Shared/DspArena.h"
+#include <array>
+#include <cmath>
+
+#if JUCE_USE_SIMD
+//==============================================================================
+/** The first kLengthMs of notes as SIMDVoiceBank rendered them, to play
+    back rather than render again.
+
+    While the cutoff stands still and a note has no expression, its signal
+    before the envelope depends only on its key, its velocity and the
+    patch, so a pluck played over and over renders the same attack each
+    time.  An entry keeps that signal (a side per channel of a spread
+    stack) for one key and one of kVelocityBuckets velocities, and every
+    kSnapshotSamples the voice's state: its stack's phases and its
+    filter's stages.  A note streaming the entry can go back to rendering
+    at any of those points from exactly where it would have been.
+
+    The first note to miss records the entry; entries are replaced least
+    recently used first, never while a voice is on one.  The bank clears
+    the cache when anything they were recorded under changes, so the
+    patch itself is the key rather than a hash of it.  Lives in a
+    DspArena; nothing allocates afterwards. */
+class NoteCache
+{
+public:
+    static constexpr int    kMaxEntries      = 32;
+    static constexpr double kLengthMs        = 50.0;   // covers a pluck's attack and early decay
+    static constexpr int    kSnapshotSamples = NoteExpression::kControlSamples;
+    static constexpr int    kVelocityBuckets = 32;     // 4 MIDI velocities each
+
+    struct Snapshot
+    {
+        std::array<float, UnisonLayout::kMaxVoices>                     phases;
+        std::array<std::array<float, LadderCore<float>::kNumStages>, 2> filters;   // per side
+    };
+
+    /** Entries kLengthMs long at sampleRate, from inside DspArena::build(). */
+    void allocate (DspArena& arena, double sampleRate) noexcept;
+
+    /** Samples per entry, a whole number of snapshots. */
+    int getLength() const noexcept { return length; }
+
+    /** The bucket velocity falls in, and the velocity its notes play at:
+        the top of it, so a full-velocity note stays at 1. */
+    static int   bucketFor   (float velocity) noexcept { return juce::jlimit (0, kVelocityBuckets - 1, (int) std::ceil (velocity * kVelocityBuckets) - 1); }
+    static float velocityFor (int bucket) noexcept     { return (float) (bucket + 1) / (float) kVelocityBuckets; }
+
+    /** Forgets every entry.  Voices already streaming one may finish
+        reading it: it isn't reused until they let go. */
+    void clear() noexcept;
+
+    /** The entry for note and bucket, recorded or still being recorded,
+        or -1. */
+    int find (int note, int bucket) const noexcept;
+
+    /** An entry to record note and bucket into, with numSides sides: the
+        least recently used one inUse (an entry index) says nobody is on,
+        or -1 if they all are. */
+    template <typename InUse>
+    int claim (int note, int bucket, int numSides, InUse&& inUse) noexcept
+    {
+        int oldest = -1;
+
+        for (int e = 0; e < kMaxEntries; ++e)
+            if (! inUse (e) && (oldest < 0 || entries[(size_t) e].lastUsed < entries[(size_t) oldest].lastUsed))
+                oldest = e;
+
+        if (oldest >= 0)
+        {
+            auto& entry    = entries[(size_t) oldest];
+            entry.note     = note;
+            entry.bucket   = bucket;
+            entry.numSides = numSides;
+            entry.complete = false;
+            touch (oldest);
+        }
+
+        return oldest;
+    }
+
+    void touch (int e) noexcept { entries[(size_t) e].lastUsed = ++clock; }
+
+    bool isComplete (int e) const noexcept  { return entries[(size_t) e].complete; }
+    int  getNumSides (int e) const noexcept { return entries[(size_t) e].numSides; }
+
+    /** The recording reached getLength(). */
+    void markComplete (int e) noexcept { entries[(size_t) e].complete = true; }
+
+    /** The recording couldn't finish; the entry is free again. */
+    void abandon (int e) noexcept
+    {
+        entries[(size_t) e].note     = -1;
+        entries[(size_t) e].complete = false;
+    }
+
+    float*       getSamples (int e, int side) noexcept       { return entries[(size_t) e].samples[(size_t) side]; }
+    const float* getSamples (int e, int side) const noexcept { return entries[(size_t) e].samples[(size_t) side]; }
+
+    /** The state at offset, a multiple of kSnapshotSamples up to getLength(). */
+    Snapshot& getSnapshot (int e, int offset) noexcept
+    {
+        jassert (offset % kSnapshotSamples == 0 && offset <= length);
+        return entries[(size_t) e].snapshots[offset / kSnapshotSamples];
+    }
+
+private:
+    struct Entry
+    {
+        int                    note     = -1;
+        int                    bucket   = 0;
+        int                    numSides = 1;
+        bool                   complete = false;
+        juce::uint32           lastUsed = 0;
+        std::array<float*, 2>  samples {};           // per side, from the arena
+        Snapshot*              snapshots = nullptr;   // one per kSnapshotSamples, and the end
+    };
+
+    std::array<Entry, kMaxEntries> entries;
+    int                            length = 0;
+    juce::uint32                   clock  = 0;
+};
+#endif
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+    NoteExpression.h  –  One note's MPE expression, smoothed per control step
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "ExpressionSmoother.h"
+#include "../../Shared/FastMath.h"
+
+//==============================================================================
+/** One note's MPE expression, as the virtual-key controller sends it: a
+    channel per note, each with its own pitch bend (±48 semitones), CC74
+    timbre and pressure, and the master channel's bend (±2 semitones) over
+    every note.
+
+    MIDI only stores targets here, so a stream of expression costs nothing
+    per event.  The voice calls step() once every kControlSamples, which
+    glides the smoothed values towards the targets and works out the
+    frequency ratio and cutoff exponent the voice renders with.  Timbre and
+    pressure both move the cutoff, so they're smoothed as one brightness,
+    in semitones like the pitch. */
+class NoteExpression
+{
+public:
+    static constexpr int    kMasterChannel    = 1;       // MPE lower zone
+    static constexpr int    kTimbreController = 74;
+    static constexpr int    kControlSamples   = 32;      // per step, at the base rate
+    static constexpr float  kNoteBendRange    = 48.0f;   // semitones, MPE's default
+    static constexpr float  kMasterBendRange  = 2.0f;
+    static constexpr float  kTimbreOctaves    = 2.0f;    // CC74 0 … 127 moves the cutoff by ± this
+    static constexpr float  kPressureOctaves  = 1.0f;    // full pressure opens the cutoff by this
+
+    void prepare (double sampleRate) noexcept
+    {
+        pitch     .prepare (sampleRate / kControlSamples);
+        brightness.prepare (sampleRate / kControlSamples);
+    }
+
+    void setSmoothing (const ExpressionSmoothing& smoothing) noexcept
+    {
+        pitch     .setResponse (smoothing);
+        brightness.setResponse (smoothing);
+    }
+
+    /** Starts at the targets, unsmoothed: the bends as the synth last saw
+        them, the timbre centred and no pressure. */
+    void noteStarted (int pitchWheelPosition, int masterPitchWheelPosition) noexcept
+    {
+        setPitchWheel (pitchWheelPosition);
+        setMasterPitchWheel (masterPitchWheelPosition);
+        targetTimbre   = 0.0f;
+        targetPressure = 0.0f;
+
+        pitch     .reset (getTargetSemitones());
+        brightness.reset (getTargetBrightness());
+        update (getTargetSemitones(), getTargetBrightness());
+    }
+
+    void setPitchWheel       (int value) noexcept { noteBend   = toBipolar (value) * kNoteBendRange; }
+    void setMasterPitchWheel (int value) noexcept { masterBend = toBipolar (value) * kMasterBendRange; }
+
+    /** A CC74 value, 0 … 127; 64 is neutral. */
+    void setTimbre (int value) noexcept { targetTimbre = juce::jlimit (-1.0f, 1.0f, (float) (value - 64) / 63.0f); }
+
+    // The same targets unquantised, as a control stream sends them; the
+    // latest of these and the MIDI above wins
+    void setNoteBendSemitones (float semitones) noexcept { noteBend = juce::jlimit (-kNoteBendRange, kNoteBendRange, semitones); }
+    void setTimbreTarget (float bipolar) noexcept        { targetTimbre = juce::jlimit (-1.0f, 1.0f, bipolar); }
+
+    /** Channel pressure or polyphonic aftertouch, 0 … 127. */
+    void setPressure (int value) noexcept { targetPressure = juce::jlimit (0.0f, 1.0f, (float) value / 127.0f); }
+
+    /** Where the smoothers are heading: the note's whole bend, and how far
+        timbre and pressure move its cutoff, both in semitones. */
+    float getTargetSemitones() const noexcept  { return noteBend + masterBend; }
+    float getTargetBrightness() const noexcept { return 12.0f * (targetTimbre * kTimbreOctaves + targetPressure * kPressureOctaves); }
+
+    void step() noexcept
+    {
+        update (pitch.step (getTargetSemitones()), brightness.step (getTargetBrightness()));
+    }
+
+    /** Multiplies the note's frequency. */
+    float getFrequencyRatio() const noexcept { return frequencyRatio; }
+
+    /** Raising a LadderCore coefficient exp (-2 pi fc / fs) to this power
+        scales fc by it. */
+    float getCutoffExponent() const noexcept { return cutoffExponent; }
+
+    // What step() works out from the smoothed values, for voices that
+    // smooth the targets themselves (SIMDVoiceBank, a lane per voice)
+    static float frequencyRatioFor (float semitones) noexcept { return FastMath::semitonesToRatio (semitones); }
+    static float cutoffExponentFor (float brightness) noexcept { return FastMath::exp2 (brightness / 12.0f); }
+
+private:
+    static float toBipolar (int wheelValue) noexcept { return (float) (wheelValue - 8192) / 8192.0f; }
+
+    void update (float semitones, float brightnessSemitones) noexcept
+    {
+        frequencyRatio = frequencyRatioFor (semitones);
+        cutoffExponent = cutoffExponentFor (brightnessSemitones);
+    }
+
+    ExpressionSmoother<float> pitch, brightness;   // semitones
+    float noteBend       = 0.0f, masterBend = 0.0f;   // semitones
+    float targetTimbre   = 0.0f;   // -1 … 1
+    float targetPressure = 0.0f;   // 0 … 1
+    float frequencyRatio = 1.0f;
+    float cutoffExponent = 1.0f;
+};
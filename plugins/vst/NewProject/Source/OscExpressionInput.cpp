@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+    OscExpressionInput.cpp  –  OscExpressionInput implementation
+  ==============================================================================
+*/
+
+#include "OscExpressionInput.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool OscExpressionInput::setPort (int port)
+{
+    receiver.disconnect();
+    listeningPort = 0;
+
+    if (port <= 0)
+        return true;
+
+    if (! receiver.connect (port))
+        return false;
+
+    listeningPort = port;
+    return true;
+}
+
+int OscExpressionInput::collectDue (double blockStartMs, double sampleRate, int numSamples, int quantum) noexcept
+{
+    Event event;
+
+    // Kept sorted by time; senders' events arrive nearly in order
+    while (numPending < kMaxPending && queue.pop (event))
+    {
+        int i = numPending++;
+
+        for (; i > 0 && pending[(size_t) i - 1].timeMs > event.timeMs; --i)
+            pending[(size_t) i] = pending[(size_t) i - 1];
+
+        pending[(size_t) i] = event;
+    }
+
+    const auto msPerBlock = 1000.0 * numSamples / sampleRate;
+    int numDue = 0;
+
+    for (; numDue < numPending && pending[(size_t) numDue].timeMs < blockStartMs + msPerBlock; ++numDue)
+    {
+        auto& due = dueEvents[(size_t) numDue];
+        due = pending[(size_t) numDue];
+
+        const auto offset = juce::jlimit (0, numSamples - 1, (int) ((due.timeMs - blockStartMs) * sampleRate * 0.001));
+        due.sampleOffset  = offset - offset % juce::jmax (1, quantum);
+    }
+
+    std::copy (pending.begin() + numDue, pending.begin() + numPending, pending.begin());
+    numPending -= numDue;
+    return numDue;
+}
+
+void OscExpressionInput::oscBundleReceived (const juce::OSCBundle& bundle)
+{
+    const auto tag = bundle.getTimeTag();
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+
+    // The tag is wall-clock time; the events are on the hi-res counter
+    const auto timeMs = tag.isImmediately() ? now
+                                            : now + (double) (tag.toTime().toMilliseconds() - juce::Time::currentTimeMillis());
+
+    for (const auto& element : bundle)
+    {
+        if (element.isBundle())
+            oscBundleReceived (element.getBundle());
+        else if (element.isMessage())
+            handleMessage (element.getMessage(), timeMs);
+    }
+}
+
+void OscExpressionInput::handleMessage (const juce::OSCMessage& message, double timeMs)
+{
+    if (! message.getAddressPattern().matches (address))
+        return;
+
+    const auto number = [&message] (int index)
+    {
+        const auto& arg = message[index];
+        return arg.isFloat32() ? arg.getFloat32()
+             : arg.isInt32()   ? (float) arg.getInt32()
+                               : std::numeric_limits<float>::quiet_NaN();
+    };
+
+    if (message.size() != 4)
+    {
+        numMalformed.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto channel = number (0), note = number (1), bend = number (2), timbre = number (3);
+
+    if (! (channel >= 1.0f && channel <= 16.0f && note >= 0.0f && note <= 127.0f
+            && std::isfinite (bend) && std::isfinite (timbre)))
+    {
+        numMalformed.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    Event event;
+    event.timeMs  = timeMs;
+    event.channel = (juce::uint8) channel;
+    event.note    = (juce::uint8) note;
+    event.bend    = bend;
+    event.timbre  = juce::jlimit (-1.0f, 1.0f, timbre);
+    queue.push (event);   // counted as dropped when full
+}
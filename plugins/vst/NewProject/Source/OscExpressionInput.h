@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+    OscExpressionInput.h  –  Per-note expression over OSC, queued for the
+                             audio thread at the sample it's due
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_osc/juce_osc.h>
+#include "../../Shared/LockFreeRing.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/** Per-note expression over OSC, at float precision, for controllers that
+    would otherwise send a pitch bend and a CC74 per finger per frame.  A
+    note's bend and timbre travel together in one message:
+
+        /vst-garage/expression  <channel> <note> <bend> <timbre>
+
+    channel (1 … 16) and note name the note as MIDI started it, bend is in
+    semitones and timbre -1 … 1; ints and floats are both accepted.
+
+    juce::OSCReceiver parses on its own thread, which turns each message
+    into an Event on a lock-free ring, so the audio thread never sees a
+    packet.  A bundle's time tag schedules its messages at that time on
+    this machine's clock, so a sender that tags a few milliseconds ahead
+    gets its expression at the right sample, free of network jitter;
+    untagged messages (and late ones) apply where the next block starts. */
+class OscExpressionInput  : private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>
+{
+public:
+    static constexpr const char* kAddress    = "/vst-garage/expression";
+    static constexpr int         kQueueSize  = 2048;   // ten fingers at 200 Hz for a second
+    static constexpr int         kMaxPending = 512;    // tagged for later blocks
+
+    struct Event
+    {
+        double      timeMs       = 0.0;   // on Time::getMillisecondCounterHiRes()
+        int         sampleOffset = 0;     // set by collectDue()
+        juce::uint8 channel      = 0, note = 0;
+        float       bend         = 0.0f, timbre = 0.0f;
+    };
+
+    OscExpressionInput()            { receiver.addListener (this); }
+    ~OscExpressionInput() override  { receiver.disconnect(); receiver.removeListener (this); }
+
+    /** Listens on this UDP port, or stops on 0.  False if it can't be
+        bound.  Message thread. */
+    bool setPort (int port);
+
+    int getPort() const noexcept { return listeningPort; }
+
+    /** Messages at the address that didn't parse, and events lost because
+        the queue was full.  Any thread. */
+    juce::uint64 getNumMalformed() const noexcept { return numMalformed.load (std::memory_order_relaxed); }
+    juce::uint64 getNumDropped()   const noexcept { return queue.getStats().dropped; }
+
+    /** Audio thread, every block.  Lifts out the events due before the
+        block ends, oldest first, with sample offsets rounded down to a
+        multiple of quantum so they split the render no more often than the
+        MIDI expression does.  They stay valid in getDue() until the next
+        call. */
+    int collectDue (double blockStartMs, double sampleRate, int numSamples, int quantum) noexcept;
+
+    const Event* getDue() const noexcept { return dueEvents.data(); }
+
+private:
+    // ── Receiver thread ──────────────────────────────────────────────────────
+    void oscMessageReceived (const juce::OSCMessage& message) override
+    {
+        handleMessage (message, juce::Time::getMillisecondCounterHiRes());
+    }
+
+    void oscBundleReceived (const juce::OSCBundle& bundle) override;
+    void handleMessage (const juce::OSCMessage& message, double timeMs);
+
+    juce::OSCReceiver               receiver { "OSC expression" };
+    const juce::OSCAddress          address  { kAddress };
+    int                             listeningPort = 0;
+    LockFreeRing<Event, kQueueSize> queue;
+    std::atomic<juce::uint64>       numMalformed { 0 };
+
+    // Audio thread
+    std::array<Event, kMaxPending>  pending;
+    std::array<Event, kMaxPending>  dueEvents;
+    int                             numPending = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OscExpressionInput)
+};
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+    Oscillators.h  –  PolyBLEP waveforms, and BandLimitedOscillator to play
+                      one in a juce::dsp chain
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/** Waveforms for BandLimitedOscillator.  Each renders one sample from the
+    phase (0 … 1) and the per-sample phase increment; PolyBLEP residuals
+    round off the discontinuities, so the harmonics that would fold back
+    from above Nyquist are mostly cancelled. */
+struct PolyBLEP
+{
+    /** Correction for a unit step at phase 0 (t = phase, dt = increment). */
+    template <typename Type>
+    static Type residual (Type t, Type dt) noexcept
+    {
+        if (t < dt)
+        {
+            t /= dt;
+            return t + t - t * t - Type (1);
+        }
+
+        if (t > Type (1) - dt)
+        {
+            t = (t - Type (1)) / dt;
+            return t * t + t + t + Type (1);
+        }
+
+        return Type (0);
+    }
+};
+
+struct SawWave
+{
+    template <typename Type>
+    static Type render (Type phase, Type increment) noexcept
+    {
+        return Type (2) * phase - Type (1) - PolyBLEP::residual (phase, increment);
+    }
+
+   #if JUCE_USE_SIMD
+    /** render() for a register of phases, the PolyBLEP branches as masks;
+        SIMDRegister has no divide, so it takes 1 / increment as well. */
+    static juce::dsp::SIMDRegister<float> render (juce::dsp::SIMDRegister<float> phase,
+                                                  juce::dsp::SIMDRegister<float> increment,
+                                                  juce::dsp::SIMDRegister<float> inverseIncrement) noexcept
+    {
+        using Lanes = juce::dsp::SIMDRegister<float>;
+
+        const auto one = Lanes::expand (1.0f);
+        const auto x   = phase * inverseIncrement;
+        const auto y   = (phase - one) * inverseIncrement;
+
+        const auto nearStart = (x + x - x * x - one) & Lanes::lessThan (phase, increment);
+        const auto nearEnd   = (y * y + y + y + one) & Lanes::greaterThan (phase, one - increment);
+
+        return phase + phase - one - nearStart - nearEnd;
+    }
+   #endif
+};
+
+struct SquareWave
+{
+    template <typename Type>
+    static Type render (Type phase, Type increment) noexcept
+    {
+        auto halfCycle = phase + Type (0.5);
+        if (halfCycle >= Type (1))
+            halfCycle -= Type (1);
+
+        return (phase < Type (0.5) ? Type (1) : Type (-1))
+             + PolyBLEP::residual (phase, increment)
+             - PolyBLEP::residual (halfCycle, increment);
+    }
+};
+
+//==============================================================================
+/** Oscillator with a compile-time waveform: no per-sample indirect call.
+
+    Like juce::dsp::Oscillator it adds into the context's output, so several
+    can follow each other in a ProcessorChain, and frequency changes that
+    aren't forced glide over 50 ms.  At a steady frequency the phases of a
+    whole block are worked out in one vectorisable pass before the
+    waveform is rendered. */
+template <typename Type, typename Waveform>
+class BandLimitedOscillator
+{
+public:
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        rendered.resize ((size_t) spec.maximumBlockSize);
+        frequency.reset (sampleRate, 0.05);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        phase = Type (0);
+        frequency.setCurrentAndTargetValue (frequency.getTargetValue());
+    }
+
+    void setFrequency (Type newValue, bool force = false)
+    {
+        if (force)
+            frequency.setCurrentAndTargetValue (newValue);
+        else
+            frequency.setTargetValue (newValue);
+    }
+
+    void setLevel (Type newValue) noexcept { level = newValue; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        auto&& outBlock = context.getOutputBlock();
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outBlock.copyFrom (context.getInputBlock());
+
+        if (context.isBypassed)
+            return;
+
+        const auto numSamples = (int) outBlock.getNumSamples();
+        jassert ((size_t) numSamples <= rendered.size());
+
+        auto* out = rendered.data();
+
+        if (frequency.isSmoothing())
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto increment = incrementFor (frequency.getNextValue());
+                phase = wrap (phase + increment);
+                out[i] = level * Waveform::render (phase, increment);
+            }
+        }
+        else
+        {
+            // Each phase straight from the block's start, so the loop
+            // carries no dependency and vectorises
+            const auto increment = incrementFor (frequency.getNextValue());
+            const auto start     = phase;
+
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = wrap (start + increment * (Type) (i + 1));
+
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = level * Waveform::render (out[i], increment);
+
+            phase = wrap (start + increment * (Type) numSamples);
+        }
+
+        for (size_t ch = 0; ch < outBlock.getNumChannels(); ++ch)
+            juce::FloatVectorOperations::add (outBlock.getChannelPointer (ch), out, numSamples);
+    }
+
+private:
+    Type incrementFor (Type hz) const noexcept
+    {
+        // Above half the sample rate the residuals no longer make sense
+        return juce::jmin ((Type) (hz / sampleRate), Type (0.5));
+    }
+
+    static Type wrap (Type x) noexcept    { return x - std::floor (x); }
+
+    double                    sampleRate = 44100.0;
+    Type                      phase      = Type (0);
+    Type                      level      = Type (1);
+    juce::SmoothedValue<Type> frequency;
+    std::vector<Type>         rendered;   // one block, sized in prepare()
+};
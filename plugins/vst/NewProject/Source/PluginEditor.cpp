@@ -9,6 +9,275 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+#if JucePlugin_Build_Standalone
+ #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+#endif
+
+//==============================================================================
+BufferSizeTuner::BufferSizeTuner (NewProjectAudioProcessor& p, juce::AudioDeviceManager& dm)
+    : processor (p), deviceManager (dm)
+{
+}
+
+BufferSizeTuner::~BufferSizeTuner()
+{
+    cancel();
+}
+
+void BufferSizeTuner::start()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (running || device == nullptr)
+        return;
+
+    candidates = device->getAvailableBufferSizes();
+    candidates.sort();
+
+    if (candidates.isEmpty())
+        return;
+
+    originalSize = device->getCurrentBufferSizeSamples();
+    trial        = 0;
+    running      = true;
+
+    processor.setOutputMuted (true);
+    beginTrial();
+    startTimerHz (10);
+}
+
+void BufferSizeTuner::cancel()
+{
+    if (running)
+        finish (originalSize, "Cancelled");
+}
+
+void BufferSizeTuner::beginTrial()
+{
+    const auto bufferSize = candidates[trial];
+
+    if (! setBufferSize (bufferSize))
+    {
+        finish (originalSize, "Couldn't set " + juce::String (bufferSize) + " samples");
+        return;
+    }
+
+    // The restart may have dropped the chord's voices
+    holdTestChord (false);
+    holdTestChord (true);
+
+    settling   = true;
+    phaseEndMs = juce::Time::getMillisecondCounterHiRes() + kSettleSeconds * 1000.0;
+    status     = "Trying " + juce::String (bufferSize) + " samples (" + juce::String (trial + 1)
+                   + " of " + juce::String (candidates.size()) + ")";
+}
+
+void BufferSizeTuner::timerCallback()
+{
+    if (juce::Time::getMillisecondCounterHiRes() < phaseEndMs)
+        return;
+
+    auto& monitor = processor.getXrunMonitor();
+
+    if (settling)
+    {
+        // The restart's own hiccup isn't the size's fault
+        auto* device = deviceManager.getCurrentAudioDevice();
+
+        startOverruns      = monitor.getNumOverruns();
+        startLateCallbacks = monitor.getNumLateCallbacks();
+        startDeviceXruns   = device != nullptr ? juce::jmax (0, device->getXRunCount()) : 0;
+        startBlockSummary  = processor.getPerfProbe().getSummary (processor.getBlockScope());
+
+        settling   = false;
+        phaseEndMs = juce::Time::getMillisecondCounterHiRes() + kTrialSeconds * 1000.0;
+        return;
+    }
+
+    if (trialPassed())
+        finish (candidates[trial], "Stable at " + juce::String (candidates[trial]) + " samples");
+    else if (++trial < candidates.size())
+        beginTrial();
+    else
+        finish (candidates.getLast(), "Nothing stable; left at " + juce::String (candidates.getLast()) + " samples");
+}
+
+bool BufferSizeTuner::trialPassed() const
+{
+    auto&      monitor = processor.getXrunMonitor();
+    auto*      device  = deviceManager.getCurrentAudioDevice();
+    const auto now     = processor.getPerfProbe().getSummary (processor.getBlockScope());
+
+    if (device == nullptr
+         || monitor.getNumOverruns()      != startOverruns
+         || monitor.getNumLateCallbacks() != startLateCallbacks
+         || juce::jmax (0, device->getXRunCount()) != startDeviceXruns)
+        return false;
+
+    // The trial's own p99, from the histogram's growth since it began (all
+    // of it, if a restart cleared the probe meanwhile)
+    const bool restarted = now.count < startBlockSummary.count;
+    std::array<juce::uint64, PerfProbe::kNumLoadBuckets> buckets {};
+    juce::uint64 count = 0;
+
+    for (size_t b = 0; b < buckets.size(); ++b)
+    {
+        buckets[b] = now.loadBuckets[b] - (restarted ? 0 : startBlockSummary.loadBuckets[b]);
+        count += buckets[b];
+    }
+
+    if (count == 0)
+        return false;   // no callbacks at all is no pass
+
+    const auto   target     = (juce::uint64) std::ceil (0.99 * (double) count);
+    juce::uint64 cumulative = 0;
+
+    for (size_t b = 0; b < buckets.size(); ++b)
+        if ((cumulative += buckets[b]) >= target)
+            return (double) (b + 1) * PerfProbe::kLoadBucketWidth <= kMaxLoad;
+
+    return false;
+}
+
+void BufferSizeTuner::finish (int bufferSize, const juce::String& result)
+{
+    stopTimer();
+    holdTestChord (false);
+
+    if (auto* device = deviceManager.getCurrentAudioDevice(); device != nullptr && device->getCurrentBufferSizeSamples() != bufferSize)
+        setBufferSize (bufferSize);
+
+    processor.setOutputMuted (false);
+    running = false;
+    status  = result;
+}
+
+void BufferSizeTuner::holdTestChord (bool shouldHold)
+{
+    if (! shouldHold)
+    {
+        for (auto note : chord)
+            processor.keyboardState.noteOff (1, note, 0.0f);
+
+        chord.clearQuick();
+        return;
+    }
+
+    // One note per voice the polyphony allows, as far as the keyboard goes
+    const auto polyphony = (int) processor.apvts.getRawParameterValue ("polyphony")->load();
+
+    for (int i = 0; i < juce::jmin (polyphony, 104); ++i)
+    {
+        chord.add (24 + i);
+        processor.keyboardState.noteOn (1, 24 + i, 0.8f);
+    }
+}
+
+bool BufferSizeTuner::setBufferSize (int bufferSize)
+{
+    auto setup = deviceManager.getAudioDeviceSetup();
+    setup.bufferSize = bufferSize;
+
+    return deviceManager.setAudioDeviceSetup (setup, true).isEmpty();
+}
+
+//==============================================================================
+XrunStatusView::XrunStatusView (NewProjectAudioProcessor& p, juce::AudioDeviceManager& dm)
+    : processor (p), deviceManager (dm), tuner (p, dm)
+{
+    for (auto* label : { &summaryLabel, &historyLabel })
+    {
+        label->setFont (juce::FontOptions (11.0f));
+        label->setColour (juce::Label::textColourId, juce::Colours::lightgrey);
+        label->setJustificationType (juce::Justification::topLeft);
+        addAndMakeVisible (*label);
+    }
+
+    tuneButton.onClick = [this]
+    {
+        if (tuner.isRunning())
+            tuner.cancel();
+        else
+            tuner.start();
+
+        update();
+    };
+
+    addAndMakeVisible (tuneButton);
+    update();
+}
+
+void XrunStatusView::update()
+{
+    // Newest first, as wall-clock times
+    const auto nowMs   = juce::Time::getMillisecondCounterHiRes();
+    const auto nowTime = juce::Time::getCurrentTime();
+
+    const auto addToHistory = [this, nowMs, nowTime] (double timeMs, const juce::String& what)
+    {
+        const auto when = nowTime - juce::RelativeTime::milliseconds ((juce::int64) (nowMs - timeMs));
+        history.insert (0, when.formatted ("%H:%M:%S") + "   " + what);
+        history.removeRange (kHistoryLength, history.size());
+    };
+
+    processor.getXrunMonitor().popEvents ([&addToHistory] (const XrunMonitor::Event* events, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            const auto& e = events[i];
+
+            addToHistory (e.timeMs, e.kind == XrunMonitor::overrun
+                                      ? "Overrun: " + juce::String (e.blockSize) + " samples took "
+                                          + juce::String (100.0f * e.amount, 0) + " % of their time"
+                                      : "Late callback: " + juce::String (e.amount, 1) + " periods of "
+                                          + juce::String (e.blockSize) + " samples");
+        }
+    });
+
+    // The device's own count, where it keeps one; a new device starts again
+    auto*      device      = deviceManager.getCurrentAudioDevice();
+    const auto deviceCount = device != nullptr ? device->getXRunCount() : -1;
+
+    if (device != countedDevice)
+    {
+        countedDevice = device;
+        deviceXruns   = deviceCount;
+    }
+    else if (deviceCount > deviceXruns)
+    {
+        addToHistory (nowMs, "Device reported " + juce::String (deviceCount - deviceXruns) + " xrun(s)");
+        totalDeviceXruns += (juce::uint64) (deviceCount - deviceXruns);
+        deviceXruns = deviceCount;
+    }
+
+    const auto& monitor = processor.getXrunMonitor();
+    auto        summary = device != nullptr ? "Buffer " + juce::String (device->getCurrentBufferSizeSamples()) + " samples at "
+                                                + juce::String (device->getCurrentSampleRate() / 1000.0, 1) + " kHz"
+                                            : juce::String ("No audio device");
+
+    summary << "    Overruns " << (juce::int64) monitor.getNumOverruns()
+            << "    Late " << (juce::int64) monitor.getNumLateCallbacks()
+            << "    Device " << (deviceCount >= 0 ? juce::String ((juce::int64) totalDeviceXruns) : juce::String ("n/a"));
+
+    if (tuner.getStatus().isNotEmpty())
+        summary << "    " << tuner.getStatus();
+
+    summaryLabel.setText (summary, juce::dontSendNotification);
+    historyLabel.setText (history.isEmpty() ? juce::String ("No xruns yet") : history.joinIntoString ("\n"),
+                          juce::dontSendNotification);
+    tuneButton.setButtonText (tuner.isRunning() ? "Cancel tuning" : "Auto-tune buffer");
+}
+
+void XrunStatusView::resized()
+{
+    auto area = getLocalBounds();
+
+    auto top = area.removeFromTop (24);
+    tuneButton.setBounds (top.removeFromRight (130).reduced (0, 2));
+    summaryLabel.setBounds (top);
+    historyLabel.setBounds (area);
+}
+
 //==============================================================================
 NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor (NewProjectAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
@@ -50,13 +319,75 @@ NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor (NewProjectAudioP
     reverbWidthAttachment   = std::make_unique<SliderAttachment> (p.apvts, "reverbWidth",   reverbWidthSlider);
 
     addAndMakeVisible (keyboardComponent);
-    setSize (700, 480);
+
+    telemetryLabel.setFont (juce::FontOptions (11.0f));
+    telemetryLabel.setColour (juce::Label::textColourId, juce::Colours::lightgrey);
+    telemetryLabel.setJustificationType (juce::Justification::centredLeft);
+    addAndMakeVisible (telemetryLabel);
+    lastTelemetry = p.getTelemetry();
+
+   #if JucePlugin_Build_Standalone
+    if (auto* holder = juce::StandalonePluginHolder::getInstance())
+    {
+        xrunStatus = std::make_unique<XrunStatusView> (p, holder->deviceManager);
+        addAndMakeVisible (*xrunStatus);
+    }
+   #endif
+
+    setSize (700, 500 + (xrunStatus != nullptr ? XrunStatusView::kHeight : 0));
+    startTimerHz (30);
 }
 
 NewProjectAudioProcessorEditor::~NewProjectAudioProcessorEditor()
 {
 }
 
+//==============================================================================
+void NewProjectAudioProcessorEditor::timerCallback()
+{
+    TRACE_THREAD_NAME ("Message thread");
+    TRACE_SCOPE ("NewProject editor timer");
+    audioProcessor.updateKeyboardDisplay();
+
+    // Twice a second: averages over a few dozen blocks rather than one
+    if (--ticksUntilTelemetry <= 0)
+    {
+        ticksUntilTelemetry = 15;
+        updateTelemetry();
+
+        if (xrunStatus != nullptr)
+            xrunStatus->update();
+    }
+}
+
+void NewProjectAudioProcessorEditor::updateTelemetry()
+{
+    const auto now        = audioProcessor.getTelemetry();
+    const auto sampleRate = audioProcessor.getSampleRate();
+
+    // prepareToPlay() restarts the totals; start averaging again from there
+    if (now.voiceSamples < lastTelemetry.voiceSamples || now.reverbSamples < lastTelemetry.reverbSamples)
+        lastTelemetry = {};
+
+    // Share of the real-time budget, that many samples' worth of seconds
+    const auto load = [sampleRate] (double seconds, juce::uint64 numSamples)
+    {
+        return numSamples > 0 && sampleRate > 0.0 ? 100.0 * seconds * sampleRate / (double) numSamples : 0.0;
+    };
+
+    const auto voiceLoad  = load (now.voiceSeconds  - lastTelemetry.voiceSeconds,  now.voiceSamples  - lastTelemetry.voiceSamples);
+    const auto reverbLoad = load (now.reverbSeconds - lastTelemetry.reverbSeconds, now.reverbSamples - lastTelemetry.reverbSamples);
+
+    telemetryLabel.setText ("Voices " + juce::String (now.activeVoices) + " / " + juce::String (now.voiceCap)
+                              + "    Stolen " + juce::String ((juce::int64) now.stolenVoices)
+                              + "    Per voice " + juce::String (voiceLoad, 2) + " %"
+                              + "    Reverb " + juce::String (reverbLoad, 1) + " %"
+                              + "    Quality -" + juce::String (now.qualityLevel),
+                            juce::dontSendNotification);
+
+    lastTelemetry = now;
+}
+
 //==============================================================================
 void NewProjectAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -96,6 +427,7 @@ void NewProjectAudioProcessorEditor::resized()
     const int knobH         = 110;
     const int rowGap        = 8;
     const int keyboardH     = 120;
+    const int telemetryH    = 18;
 
     // --- Row 1: ADSR (4 knobs) ---
     const int numADSR  = 4;
@@ -130,4 +462,11 @@ void NewProjectAudioProcessorEditor::resized()
     // --- Keyboard ---
     const int keyboardY = row2Y + knobLabelH + knobH + rowGap;
     keyboardComponent.setBounds (padding, keyboardY, totalW, keyboardH);
+
+    // --- Voice / reverb readout ---
+    telemetryLabel.setBounds (padding, keyboardY + keyboardH + 2, totalW, telemetryH);
+
+    // --- Standalone xruns and buffer tuning ---
+    if (xrunStatus != nullptr)
+        xrunStatus->setBounds (padding, keyboardY + keyboardH + 2 + telemetryH + rowGap, totalW, XrunStatusView::kHeight - rowGap);
 }
@@ -11,10 +11,98 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
+//==============================================================================
+/** Finds the smallest buffer size the standalone app's device runs without
+    xruns on this machine.
+
+    Each of the device's sizes, smallest first, gets a trial: the device is
+    switched to it, given kSettleSeconds to restart, then kTrialSeconds
+    holding a chord as wide as the polyphony with the synth's output
+    muted.  A size passes with no overrun, late callback or device xrun
+    (see XrunMonitor) and a p99 block load under kMaxLoad, headroom for a
+    heavier patch; the first to pass is kept.  If none does the largest is
+    kept, and cancelling puts back the size there was.  Message thread. */
+class BufferSizeTuner  : private juce::Timer
+{
+public:
+    static constexpr double kSettleSeconds = 0.5;
+    static constexpr double kTrialSeconds  = 4.0;
+    static constexpr double kMaxLoad       = 0.7;
+
+    BufferSizeTuner (NewProjectAudioProcessor&, juce::AudioDeviceManager&);
+    ~BufferSizeTuner() override;
+
+    void start();
+    void cancel();
+    bool isRunning() const noexcept { return running; }
+
+    /** The trial under way, or what the last search found. */
+    const juce::String& getStatus() const noexcept { return status; }
+
+private:
+    void timerCallback() override;
+    void beginTrial();
+    bool trialPassed() const;
+    void finish (int bufferSize, const juce::String& result);
+    void holdTestChord (bool shouldHold);
+    bool setBufferSize (int bufferSize);
+
+    NewProjectAudioProcessor& processor;
+    juce::AudioDeviceManager& deviceManager;
+
+    juce::Array<int> candidates;   // the device's sizes, ascending
+    int              trial        = 0;
+    int              originalSize = 0;
+    bool             running      = false;
+    bool             settling     = false;
+    double           phaseEndMs   = 0.0;
+    juce::Array<int> chord;
+
+    // Where the counts stood when the trial's measuring began
+    juce::uint64       startOverruns = 0, startLateCallbacks = 0;
+    int                startDeviceXruns = 0;
+    PerfProbe::Summary startBlockSummary;
+
+    juce::String status;
+};
+
+//==============================================================================
+/** The standalone app's xruns (XrunMonitor's and the device's own counts,
+    and the most recent few) and the BufferSizeTuner's button. */
+class XrunStatusView  : public juce::Component
+{
+public:
+    static constexpr int kHistoryLength = 4;
+    static constexpr int kHeight        = 92;
+
+    XrunStatusView (NewProjectAudioProcessor&, juce::AudioDeviceManager&);
+
+    /** Message thread, a few times a second. */
+    void update();
+
+    void resized() override;
+
+private:
+    NewProjectAudioProcessor& processor;
+    juce::AudioDeviceManager& deviceManager;
+    BufferSizeTuner           tuner;
+
+    juce::Label       summaryLabel, historyLabel;
+    juce::TextButton  tuneButton { "Auto-tune buffer" };
+    juce::StringArray history;   // newest first
+
+    const juce::AudioIODevice* countedDevice = nullptr;
+    int                        deviceXruns   = 0;   // as of the last update
+    juce::uint64               totalDeviceXruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (XrunStatusView)
+};
+
 //==============================================================================
 /**
 */
-class NewProjectAudioProcessorEditor  : public juce::AudioProcessorEditor
+class NewProjectAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                        private juce::Timer
 {
 public:
     NewProjectAudioProcessorEditor (NewProjectAudioProcessor&);
@@ -25,10 +113,23 @@ public:
     void resized() override;
 
 private:
+    // Lights the keys for notes from the host and MIDI inputs, and now
+    // and then refreshes the voice and reverb readout
+    void timerCallback() override;
+    void updateTelemetry();
+
     NewProjectAudioProcessor& audioProcessor;
 
     juce::MidiKeyboardComponent keyboardComponent;
 
+    // Only in the standalone app, where the device's buffer is ours to pick
+    std::unique_ptr<XrunStatusView> xrunStatus;
+
+    // Voices, steals and render cost, averaged since the last refresh
+    juce::Label                          telemetryLabel;
+    NewProjectAudioProcessor::Telemetry  lastTelemetry;
+    int                                  ticksUntilTelemetry = 0;
+
     // ADSR knobs
     juce::Slider attackSlider,  decaySlider,  sustainSlider,  releaseSlider;
     juce::Label  attackLabel,   decayLabel,   sustainLabel,   releaseLabel;
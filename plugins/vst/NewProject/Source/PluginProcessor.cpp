@@ -9,6 +9,25 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS
+
+// Every parameter the processor reads, and the group it belongs to
+const NewProjectAudioProcessor::ListenedParameter NewProjectAudioProcessor::listenedParameters[]
+{
+    { "attack",     envelopeChanged }, { "decay",         envelopeChanged },
+    { "sustain",    envelopeChanged }, { "release",       envelopeChanged },
+    { "lfoFreq",    lfoChanged },      { "lfoDepth",      lfoChanged },
+    { "unisonVoices", unisonChanged }, { "unisonDetune", unisonChanged }, { "unisonSpread", unisonChanged },
+    { "wavetablePosition", wavetableChanged },
+    { "reverbSize", reverbChanged },   { "reverbDamping", reverbChanged },
+    { "reverbWet",  reverbChanged },   { "reverbWidth",   reverbChanged },
+    { "reverbEngine", reverbChanged },
+    { "oversampling", engineChanged }, { "linearPhase", engineChanged },
+    { "offlineOversampling", engineChanged }, { "offlineLinearPhase", engineChanged },
+    { "subBlock", engineChanged },     { "reverbRate", engineChanged },
+    { "voiceEngine", engineChanged },
+};
+
 //==============================================================================
 NewProjectAudioProcessor::NewProjectAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -25,15 +44,87 @@ NewProjectAudioProcessor::NewProjectAudioProcessor()
      : apvts (*this, nullptr, "Parameters", createParameterLayout())
 #endif
 {
-    // Add 8 polyphonic DSP voices (2x sawtooth oscs, ladder filter, LFO, ADSR)
-    for (auto i = 0; i < 8; ++i)
-        synth.addVoice (new DSPVoice());
+    // The voice pools are allocated in prepareToPlay()
+    voiceSynth.addSound (new SineWaveSound());
+   #if JUCE_USE_SIMD
+    bankSynth.addSound (new SineWaveSound());
+   #endif
+
+    for (const auto& param : listenedParameters)
+        apvts.addParameterListener (param.id, this);
+
+    keyboardState.addListener (this);
+
+    // Not overwriteOldest: that lets the audio thread rewrite slots while
+    // updateKeyboardDisplay() is still reading them.  A ring filled while
+    // the editor was closed drops the newest instead, and the display
+    // starts again from the next notes (see updateKeyboardDisplay())
+    displayNotes.setOverflowPolicy (LockFreeRing<DisplayNote, 512>::OverflowPolicy::dropNewest);
+
+    // Nothing else is built until prepareToPlay(): hosts construct every
+    // plugin while scanning and loading sessions, and most never play
 
-    synth.addSound (new SineWaveSound());
+    // Looks for the control stream, and publishes telemetry once started
+    startTimerHz (5);
 }
 
 NewProjectAudioProcessor::~NewProjectAudioProcessor()
 {
+    stopTimer();
+    cancelPendingUpdate();
+    keyboardState.removeListener (this);
+
+    for (const auto& param : listenedParameters)
+        apvts.removeParameterListener (param.id, this);
+}
+
+void NewProjectAudioProcessor::parameterChanged (const juce::String& parameterID, float)
+{
+    for (const auto& param : listenedParameters)
+    {
+        if (parameterID != param.id)
+            continue;
+
+        if (param.group == engineChanged)
+        {
+            reprepareRequested.store (true);
+            triggerAsyncUpdate();
+        }
+        else
+            changedGroups.fetch_or (param.group);
+    }
+
+    // The convolution engine's room is built from the FDN's settings
+    if ((parameterID == "reverbSize" || parameterID == "reverbDamping" || parameterID == "reverbEngine")
+         && (int) reverbEngineParam->load() == ReverbSlot::convolutionEngine)
+    {
+        roomRequested.store (true);
+        triggerAsyncUpdate();
+    }
+}
+
+void NewProjectAudioProcessor::handleAsyncUpdate()
+{
+    juce::ValueTree newState;
+
+    {
+        const juce::SpinLock::ScopedLockType lock (pendingStateLock);
+        std::swap (newState, pendingState);
+    }
+
+    if (newState.isValid())
+        applyState (newState);
+
+    if (roomRequested.exchange (false))
+        updateRoomImpulse();
+
+    // Not playing: the next prepareToPlay() picks the setting up anyway
+    if (! reprepareRequested.exchange (false) || ! isPrepared)
+        return;
+
+    suspendProcessing (true);
+    prepareToPlay (getSampleRate(), getBlockSize());
+    suspendProcessing (false);
 }
 
 //==============================================================================
@@ -63,6 +154,72 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewProjectAudioProcessor::cr
         "lfoFreq", "LFO Freq",
         juce::NormalisableRange<float> (0.1f, 20.0f, 0.01f, 0.5f), 3.0f));
 
+    // How much of its range the LFO sweeps the cutoff through; at 0 it
+    // stands still, and notes may play from the note cache
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "lfoDepth", "LFO Depth",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 1.0f));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        "noteCache", "Note Cache", false));
+
+    // Unison: the saws per note, their total detune in cents and how wide
+    // they spread; the defaults are the old pair, 1% apart and centred
+    params.push_back (std::make_unique<juce::AudioParameterInt> (
+        "unisonVoices", "Unison Voices", 1, UnisonLayout::kMaxVoices, 2));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "unisonDetune", "Unison Detune",
+        juce::NormalisableRange<float> (0.0f, 100.0f, 0.1f, 0.5f), 17.2f));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "unisonSpread", "Unison Spread",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 0.0f));
+
+    // Where a loaded wavetable plays from, first frame to last; the saws
+    // ignore it
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "wavetablePosition", "Wavetable Position",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.001f), 0.0f));
+
+    // Voices: the most that may sound at once, and whether CPU load may
+    // lower that further
+    params.push_back (std::make_unique<juce::AudioParameterInt> (
+        "polyphony",  "Polyphony", 1, VoicePoolSynthesiser::kMaxVoices, 32));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        "cpuLimiter", "CPU Limiter", false));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        "multithreaded", "Multithreaded", false));
+
+    // What renders them: a DSPVoice per note, or the SIMD bank, which
+    // renders several notes per instruction (see SIMDVoiceBank).  Both
+    // play the same patch; changing it re-prepares and stops every note.
+    // Only the bank has the note cache and the render workers
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "voiceEngine", "Voice Engine", juce::StringArray { "Voices", "SIMD Bank" }, bankEngine));
+
+    // Filter oversampling: the ladder filter alone runs at 2x or 4x, through
+    // low-latency IIR or linear-phase FIR half-bands
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "oversampling", "Oversampling", juce::StringArray { "Off", "2x", "4x" }, 0));
+
+    // The fixed size the voices and reverb render in, whatever the host's
+    // blocks (see SubBlockEngine); notes land on its grid
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "subBlock", "Sub-block", juce::StringArray { "16", "32", "64", "128" }, 1));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        "linearPhase",  "Linear Phase", false));
+
+    // The same for offline renders, which also modulate every sample
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "offlineOversampling", "Offline Oversampling", juce::StringArray { "Off", "2x", "4x" }, 2));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool> (
+        "offlineLinearPhase",  "Offline Linear Phase", true));
+
     // Reverb
     params.push_back (std::make_unique<juce::AudioParameterFloat> (
         "reverbSize",    "Room Size",
@@ -80,6 +237,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewProjectAudioProcessor::cr
         "reverbWidth",   "Width",
         juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f), 1.0f));
 
+    // Feedback delay network, or convolution with a room built from the
+    // same size and damping
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "reverbEngine",  "Reverb Engine", juce::StringArray { "FDN", "Convolution" }, 0));
+
+    // The reverb at a half or a quarter of the session's rate, for 88.2 kHz
+    // and up (see ReverbSlot); changing it re-prepares
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "reverbRate",    "Reverb Rate", juce::StringArray { "Full", "Half", "Quarter" }, 0));
+
     return { params.begin(), params.end() };
 }
 
@@ -118,7 +285,13 @@ bool NewProjectAudioProcessor::isMidiEffect() const
 
 double NewProjectAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The reverb's time to -60 dB (the response's length, for convolution)
+    // after the release of the last note; damping only shortens it
+    const auto reverbSeconds = (int) reverbEngineParam->load() == ReverbSlot::convolutionEngine
+                                 ? fxChain.get<reverbIndex>().getConvolution().getLengthSeconds()
+                                 : (double) FDNReverb::getDecaySeconds (reverbSizeParam->load());
+
+    return reverbSeconds + releaseParam->load();
 }
 
 int NewProjectAudioProcessor::getNumPrograms()
@@ -148,27 +321,178 @@ void NewProjectAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void NewProjectAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    synth.setCurrentPlaybackSampleRate (sampleRate);
-    midiCollector.reset (sampleRate);
+    // The trace rings are allocated and the kernels picked here, not by
+    // the first block
+    TraceRecorder::getInstance();
+    VectorKernels::get();
+
+    // The engine the parameter asks for, with any notes the other was
+    // playing stopped, so they don't resume if it's picked again
+    VoicePoolSynthesiser* engine = &voiceSynth;
+
+   #if JUCE_USE_SIMD
+    if ((int) voiceEngineParam->load() == bankEngine)
+        engine = &bankSynth;
+   #endif
+
+    if (engine != synth)
+        synth->allNotesOff (0, false);
+
+    synth = engine;
+    synth->setCurrentPlaybackSampleRate (sampleRate);
+    hardwareMidi.prepare (sampleRate);
+    keyboardMidi.prepare (sampleRate);
+    expressionCoalescer.prepare (samplesPerBlock);
+    perfProbe.prepare (sampleRate);
+    xrunMonitor.prepare (sampleRate);
+    perfProbe.reset();
+    telemetryVoiceSamples.store (0);
+    telemetryVoiceTicks.store (0);
+    telemetryReverbSamples.store (0);
+    telemetryReverbTicks.store (0);
+    telemetryFormatChanged.store (true);
+
+    // Everything after the MIDI inputs sees sub-blocks, never the host's
+    // blocks, so it's prepared for one of those whatever samplesPerBlock is
+    const auto subBlockSize = kSubBlockSizes[(size_t) juce::jlimit (0, (int) std::size (kSubBlockSizes) - 1,
+                                                                    (int) subBlockParam->load())];
+    subBlocks.prepare (getTotalNumOutputChannels(), subBlockSize);
 
     juce::dsp::ProcessSpec spec;
     spec.sampleRate       = sampleRate;
-    spec.maximumBlockSize = (juce::uint32) samplesPerBlock;
+    spec.maximumBlockSize = (juce::uint32) subBlockSize;
     spec.numChannels      = (juce::uint32) getTotalNumOutputChannels();
 
+    // Allocate the engine's whole pool once, whatever the polyphony:
+    // changing it then only moves the cap (unison saws, ladder filter,
+    // LFO, ADSR)
+    const bool bankRendering = isBankRendering();
+
+    if (synth->getNumVoices() == 0)
+    {
+        for (auto i = 0; i < VoicePoolSynthesiser::kMaxVoices; ++i)
+        {
+           #if JUCE_USE_SIMD
+            if (bankRendering)
+            {
+                bankSynth.addPooledVoice (new BankVoice (voiceBank, i));
+                continue;
+            }
+           #endif
+
+            voices.push_back (static_cast<DSPVoice*> (voiceSynth.addPooledVoice (new DSPVoice (voiceParameters, modulation))));
+        }
+    }
+
+    // Only the ladder filter runs oversampled; the whole voice goes through
+    // it, so its half-bands set the latency of everything we output
+    auto& live    = renderProfiles[RenderProfile::realtime];
+    auto& offline = renderProfiles[RenderProfile::offline];
+
+    live.filterOversampling.factorLog2     = juce::jlimit (0, 2, (int) oversamplingParam->load());
+    live.filterOversampling.linearPhase    = linearPhaseParam->load() >= 0.5f;
+    live.everySampleModulation             = false;
+    offline.filterOversampling.factorLog2  = juce::jlimit (0, 2, (int) offlineOversamplingParam->load());
+    offline.filterOversampling.linearPhase = offlineLinearPhaseParam->load() >= 0.5f;
+    offline.everySampleModulation          = true;
+
+    for (size_t i = 0; i < renderProfiles.size(); ++i)
+        profileLatencies[i] = renderProfiles[i].filterOversampling.getLatencyInSamples();
+
+    modulation.prepare (sampleRate, subBlockSize,
+                        juce::jmax (live.filterOversampling.getFactor(), offline.filterOversampling.getFactor()));
+
+    // Voices pick the profile up from voiceParameters when they're prepared
+    applyRenderProfile (isNonRealtime() ? RenderProfile::offline : RenderProfile::realtime);
+
+    // The playing engine's block buffers in one pre-faulted block, so the
+    // first block after a prepare doesn't take a page fault per fresh
+    // buffer.  The other engine's are left dangling, unread until it's
+    // picked and prepared again
+    dspArena.build ([this, bankRendering, subBlockSize, sampleRate] (DspArena& arena)
+    {
+       #if JUCE_USE_SIMD
+        if (bankRendering)
+        {
+            voiceBank.allocate (arena, subBlockSize, sampleRate);
+            return;
+        }
+       #else
+        juce::ignoreUnused (bankRendering, sampleRate);
+       #endif
+
+        for (auto* voice : voices)
+            voice->allocate (arena, subBlockSize);
+    });
+
+   #if JUCE_USE_SIMD
+    if (bankRendering)
+    {
+        voiceBank.prepare (spec, bankSynth.getNumVoices(), renderProfiles);
+
+        // Helpers for the audio thread, one per spare core, up to the most
+        // tasks the bank splits a block into
+        renderWorkers.start (juce::jlimit (0, SIMDVoiceBank::kMaxTasks - 1, juce::SystemStats::getNumPhysicalCpus() - 1),
+                             subBlockSize, sampleRate);
+    }
+    else
+    {
+        renderWorkers.stop();
+    }
+   #endif
+
     // Prepare each DSP voice with the audio spec
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-        if (auto* voice = dynamic_cast<DSPVoice*> (synth.getVoice (i)))
-            voice->prepare (spec);
+    if (! bankRendering)
+        for (auto* voice : voices)
+            voice->prepare (spec, renderProfiles);
+
+    qualityGovernor.prepare (sampleRate);
+    appliedQualityLevel = 0;
+    limiterCap          = VoicePoolSynthesiser::kMaxVoices;
+    applyQualityLevel (0);
+
+    // Prepare reverb effects chain, with the convolution engine's response
+    // at the rate its engines will run at
+    auto& reverb = fxChain.get<reverbIndex>();
+    reverb.setRateReduction ((int) reverbRateParam->load());
+
+    auto& convolution = reverb.getConvolution();
+    convolution.release();
+
+    if (! hasLoadedImpulse.load())
+    {
+        const auto reverbRate = reverb.getEngineSampleRate (sampleRate);
+        convolution.setImpulseResponse (ConvolutionReverb::makeRoomImpulse (reverbRate, reverbSizeParam->load(), reverbDampingParam->load()),
+                                        reverbRate);
+    }
 
-    // Prepare reverb effects chain
     fxChain.prepare (spec);
+    reverbAsleep = true;
+
+    changedGroups.fetch_or (allChanged);   // the voices and reverb start from scratch
+    isPrepared = true;
 }
 
 void NewProjectAudioProcessor::releaseResources()
 {
     keyboardState.reset();
     fxChain.reset();
+    fxChain.get<reverbIndex>().getConvolution().release();
+    reverbAsleep = true;
+    isPrepared   = false;
+
+   #if JUCE_USE_SIMD
+    renderWorkers.stop();
+   #endif
+}
+
+void NewProjectAudioProcessor::audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup)
+{
+   #if JUCE_USE_SIMD
+    renderWorkers.setWorkgroup (workgroup);
+   #else
+    juce::ignoreUnused (workgroup);
+   #endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -197,53 +521,596 @@ bool NewProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
+// The on-screen keyboard, on the message thread
+void NewProjectAudioProcessor::handleNoteOn (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    if (! updatingDisplay)
+        keyboardMidi.pushNow (juce::MidiMessage::noteOn (midiChannel, midiNoteNumber, velocity));
+}
+
+void NewProjectAudioProcessor::handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity)
+{
+    if (! updatingDisplay)
+        keyboardMidi.pushNow (juce::MidiMessage::noteOff (midiChannel, midiNoteNumber, velocity));
+}
+
+void NewProjectAudioProcessor::updateKeyboardDisplay()
+{
+    const juce::ScopedValueSetter<bool> applying (updatingDisplay, true);
+
+    // Lost notes could leave keys lit, and what's queued is older than
+    // what was lost: drop it all and start again from the next notes
+    if (const auto dropped = displayNotes.getStats().dropped; dropped != displayNotesDropped)
+    {
+        displayNotesDropped = dropped;
+        displayNotes.popAll ([] (const DisplayNote*, int) {});
+        keyboardState.reset();
+        return;
+    }
+
+    displayNotes.popAll ([this] (const DisplayNote* notes, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            if (notes[i].isNoteOn)
+                keyboardState.noteOn  (notes[i].channel, notes[i].note, notes[i].velocity);
+            else
+                keyboardState.noteOff (notes[i].channel, notes[i].note, notes[i].velocity);
+        }
+    });
+}
+
+void NewProjectAudioProcessor::applyRenderProfile (RenderProfile::Index profile) noexcept
+{
+    const auto& settings = renderProfiles[(size_t) profile];
+
+    activeProfile = profile;
+    modulation.setResolution (settings.filterOversampling.getFactor(), settings.everySampleModulation);
+
+    // The voices switch oversamplers when they next render
+    voiceParameters.renderProfile = profile;
+    ++voiceParameters.version;
+
+    // Offline the reverb's tail can't fall behind
+    fxChain.get<reverbIndex>().getConvolution().setProcessTailInline (profile == RenderProfile::offline);
+
+    // Hosts normally switch before preparing for a bounce; if not, they're
+    // told here, which doesn't allocate
+    setLatencySamples (profileLatencies[(size_t) profile]);
+}
+
+void NewProjectAudioProcessor::loadImpulseResponse (juce::AudioBuffer<float> impulse, double impulseSampleRate)
+{
+    hasLoadedImpulse.store (true);
+    fxChain.get<reverbIndex>().getConvolution().setImpulseResponse (std::move (impulse), impulseSampleRate);
+}
+
+void NewProjectAudioProcessor::useRoomImpulse()
+{
+    hasLoadedImpulse.store (false);
+    updateRoomImpulse();
+}
+
+void NewProjectAudioProcessor::updateRoomImpulse()
+{
+    if (hasLoadedImpulse.load() || getSampleRate() <= 0.0)
+        return;
+
+    auto&      reverb     = fxChain.get<reverbIndex>();
+    const auto reverbRate = reverb.getEngineSampleRate (getSampleRate());
+
+    reverb.getConvolution().setImpulseResponse (
+        ConvolutionReverb::makeRoomImpulse (reverbRate, reverbSizeParam->load(), reverbDampingParam->load()),
+        reverbRate);
+}
+
+void NewProjectAudioProcessor::applyQualityLevel (int level)
+{
+    const auto polyphony = (int) polyphonyParam->load();
+
+    // A level down halves the voices sounding (or the cap, if fewer); a
+    // level back up doubles the cap again, and level 1 lifts it
+    if (level < 2)
+        limiterCap = VoicePoolSynthesiser::kMaxVoices;
+    else if (level > appliedQualityLevel)
+        for (int l = juce::jmax (2, appliedQualityLevel + 1); l <= level; ++l)
+            limiterCap = juce::jmax (1, juce::jmin (limiterCap, polyphony, synth->getNumActiveVoices()) / 2);
+    else
+        for (int l = level; l < appliedQualityLevel; ++l)
+            limiterCap = juce::jmin (VoicePoolSynthesiser::kMaxVoices, limiterCap * 2);
+
+    appliedQualityLevel = level;
+
+    synth->setVoiceCap (juce::jmin (polyphony, limiterCap));
+    synth->releaseVoicesOverCap();
+
+    const auto engine = level >= 1 ? ReverbSlot::fdnEngine
+                                   : (ReverbSlot::Engine) juce::jlimit (0, ReverbSlot::numEngines - 1, (int) reverbEngineParam->load());
+    fxChain.get<reverbIndex>().setEngine (engine);
+}
+
 void NewProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    REALTIME_SAFETY_AUDIO_THREAD ("NewProject processBlock");
+    TRACE_SCOPE ("NewProject processBlock");
     juce::ScopedNoDenormals noDenormals;
+    const PerfProbe::Scope blockTimer (perfProbe, blockScope, buffer.getNumSamples());
+    const auto blockStartMs    = juce::Time::getMillisecondCounterHiRes();
+
+    // Whether the last callback went wrong; bounces have no deadline
+    if (isNonRealtime())
+        xrunMonitor.pause();
+    else
+        xrunMonitor.beginBlock (blockStartMs, buffer.getNumSamples(), perfProbe.getLatestLoad (blockScope));
 
     // Clear the output buffer
     buffer.clear();
 
-    // Push current ADSR parameter values to all voices
-    juce::ADSR::Parameters adsrParams;
-    adsrParams.attack  = apvts.getRawParameterValue ("attack")->load();
-    adsrParams.decay   = apvts.getRawParameterValue ("decay")->load();
-    adsrParams.sustain = apvts.getRawParameterValue ("sustain")->load();
-    adsrParams.release = apvts.getRawParameterValue ("release")->load();
+    // Bounces get the offline profile, live playing the cheap one
+    if (const auto profile = isNonRealtime() ? RenderProfile::offline : RenderProfile::realtime;
+        profile != activeProfile)
+        applyRenderProfile (profile);
+
+    // The CPU limiter's level, from the last block's load, sets the cap
+    // this block's notes are allocated against.  Bounces have no deadline
+    qualityGovernor.setEnabled (cpuLimiterParam->load() >= 0.5f && ! isNonRealtime());
+    applyQualityLevel (qualityGovernor.update (perfProbe, blockScope, buffer.getNumSamples()));
+
+    // Merge MIDI from external hardware and the on-screen keyboard into
+    // midiMessages, without taking any lock a MIDI or UI thread could hold
+    hardwareMidi.removeNextBlockOfMessages (midiMessages, buffer.getNumSamples());
+
+    // The on-screen keyboard shows its own notes already; these are the rest
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+
+        if (message.isNoteOnOrOff())
+            displayNotes.push ({ (juce::uint8) message.getChannel(), (juce::uint8) message.getNoteNumber(),
+                                 message.isNoteOn(), message.getFloatVelocity() });
+    }
+
+    keyboardMidi.removeNextBlockOfMessages (midiMessages, buffer.getNumSamples());
 
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-        if (auto* voice = dynamic_cast<DSPVoice*> (synth.getVoice (i)))
-            voice->setADSRParameters (adsrParams);
+    // The controller's finger positions, straight onto the expression of
+    // the notes they're playing
+    {
+        const juce::SpinLock::ScopedTryLockType lock (controlStreamLock);
 
-    // Push LFO frequency to all voices
-    const float lfoFreq = apvts.getRawParameterValue ("lfoFreq")->load();
-    for (int i = 0; i < synth.getNumVoices(); ++i)
-        if (auto* voice = dynamic_cast<DSPVoice*> (synth.getVoice (i)))
-            voice->setLFOFrequency (lfoFreq);
+        if (lock.isLocked() && controlStream != nullptr)
+            applyControlStream (*controlStream);
+    }
 
-    // Update reverb parameters
-    juce::Reverb::Parameters reverbParams;
-    reverbParams.roomSize   = apvts.getRawParameterValue ("reverbSize")->load();
-    reverbParams.damping    = apvts.getRawParameterValue ("reverbDamping")->load();
-    reverbParams.wetLevel   = apvts.getRawParameterValue ("reverbWet")->load();
-    reverbParams.dryLevel   = 1.0f - reverbParams.wetLevel;
-    reverbParams.width      = apvts.getRawParameterValue ("reverbWidth")->load();
-    reverbParams.freezeMode = 0.0f;
-    fxChain.get<reverbIndex>().setParameters (reverbParams);
+    // MIDI 2.0 packets, each straight onto the synth
+    umpInput.popPackets ([this] (const juce::uint32* packet) { handleUniversalMidiPacket (packet); });
 
-    // Collect any MIDI from external hardware and merge into midiMessages
-    midiCollector.removeNextBlockOfMessages (midiMessages, buffer.getNumSamples());
+    // Streamed expression down to one split per quantum, and the OSC
+    // expression that falls in this block on the same grid
+    const auto quantum = expressionQuantum.load (std::memory_order_relaxed);
+    expressionCoalescer.setQuantum (quantum);
+    expressionCoalescer.process (midiMessages);
 
-    // Let the keyboard state process the buffer
-    keyboardState.processNextMidiBuffer (midiMessages, 0, buffer.getNumSamples(), true);
+    const auto  numOscEvents = oscInput.collectDue (blockStartMs, getSampleRate(), buffer.getNumSamples(), quantum);
+    const auto* oscEvents    = oscInput.getDue();
 
-    // Render all active synth voices into the buffer
-    synth.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+    // OSC expression takes effect from the next sub-block rendered
+    for (int event = 0; event < numOscEvents; ++event)
+        synth->applyControl (oscEvents[event].channel, oscEvents[event].note,
+                             oscEvents[event].bend, oscEvents[event].timbre);
 
-    // Apply reverb to the full mix
-    auto block        = juce::dsp::AudioBlock<float> (buffer);
-    auto contextToUse = juce::dsp::ProcessContextReplacing<float> (block);
-    fxChain.process (contextToUse);
+   #if JUCE_USE_SIMD
+    if (isBankRendering())
+    {
+        bankSynth.setRenderWorkers (multithreadedParam->load() >= 0.5f ? &renderWorkers : nullptr);
+        voiceBank.setNoteCacheEnabled (noteCacheParam->load() >= 0.5f);
+    }
+   #endif
+
+    // Voices and reverb, a fixed sub-block at a time
+    callbackVoiceTicks = callbackReverbTicks = 0;
+
+    subBlocks.process (buffer, midiMessages, [this] (juce::AudioBuffer<float>& block, juce::MidiBuffer& blockMidi)
+    {
+        renderSubBlock (block, blockMidi);
+    });
+
+    publishTelemetry (buffer.getNumSamples(), callbackVoiceTicks, callbackReverbTicks);
+
+    if (outputMuted.load (std::memory_order_relaxed))
+        buffer.clear();
+}
+
+void NewProjectAudioProcessor::applyParameterChanges()
+{
+    // Only the groups that moved since the last sub-block are recomputed;
+    // a preset part-way through loading waits for a later one
+    const auto changed = applyingState.load() ? 0u : changedGroups.exchange (0);
+
+    if ((changed & envelopeChanged) != 0)
+    {
+        // Publish new voice parameters; each voice picks them up when it
+        // next renders
+        voiceParameters.adsr.attack  = attackParam->load();
+        voiceParameters.adsr.decay   = decayParam->load();
+        voiceParameters.adsr.sustain = sustainParam->load();
+        voiceParameters.adsr.release = releaseParam->load();
+        ++voiceParameters.version;
+    }
+
+    if ((changed & smoothingChanged) != 0)
+    {
+        voiceParameters.expression.minCutoffHz = smoothingMinCutoffHz.load();
+        voiceParameters.expression.beta        = smoothingBeta.load();
+        ++voiceParameters.version;
+    }
+
+    if ((changed & unisonChanged) != 0)
+    {
+        UnisonSettings unison;
+        unison.voices      = (int) unisonVoicesParam->load();
+        unison.detuneCents = unisonDetuneParam->load();
+        unison.spread      = unisonSpreadParam->load();
+
+        voiceParameters.unison = UnisonLayout::from (unison);
+        ++voiceParameters.version;
+    }
+
+    // A newly built wavetable: the set it replaces went back to the loader
+    // to be freed, and no voice reads it once they've taken this up
+    if (wavetables.update())
+    {
+        voiceParameters.wavetable = wavetables.getCurrent();
+        ++voiceParameters.version;
+    }
+
+    if ((changed & wavetableChanged) != 0)
+    {
+        voiceParameters.wavetablePosition = wavetablePositionParam->load();
+        ++voiceParameters.version;
+    }
+
+    if ((changed & lfoChanged) != 0)
+    {
+        modulation.setLfoFrequency (lfoFreqParam->load());
+        modulation.setLfoDepth (lfoDepthParam->load());
+    }
+
+    if ((changed & reverbChanged) != 0)
+    {
+        // Both engines glide their gains, decay and damping towards these
+        // per sample, so automation doesn't step per block
+        juce::Reverb::Parameters reverbParams;
+        reverbParams.roomSize   = reverbSizeParam->load();
+        reverbParams.damping    = reverbDampingParam->load();
+        reverbParams.wetLevel   = reverbWetParam->load();
+        reverbParams.dryLevel   = 1.0f - reverbParams.wetLevel;
+        reverbParams.width      = reverbWidthParam->load();
+        reverbParams.freezeMode = 0.0f;
+        fxChain.get<reverbIndex>().setParameters (reverbParams);
+    }
+}
+
+void NewProjectAudioProcessor::renderSubBlock (juce::AudioBuffer<float>& block, juce::MidiBuffer& midi)
+{
+    applyParameterChanges();
+
+    const auto numSamples = block.getNumSamples();
+
+    // With no voice sounding and no MIDI to start one the synth would only
+    // add silence, so it's skipped along with its control signals
+    const bool synthActive = synth->getNumActiveVoices() > 0 || ! midi.isEmpty();
+
+    if (synthActive)
+    {
+        // Control signals for the whole sub-block, before any voice reads them
+        modulation.process (numSamples);
+
+        const auto voicesStart = juce::Time::getHighResolutionTicks();
+        TRACE_SCOPE ("voices");
+
+        synth->renderNextBlock (block, midi, 0, numSamples);
+
+        const auto voiceTicks = juce::Time::getHighResolutionTicks() - voicesStart;
+        perfProbe.record (voicesScope, voiceTicks, numSamples);
+        callbackVoiceTicks += voiceTicks;
+        reverbAsleep = false;
+    }
+
+    // Apply reverb to the full mix, until its tail has died away
+    if (! reverbAsleep)
+    {
+        const auto reverbStart = juce::Time::getHighResolutionTicks();
+        TRACE_SCOPE ("reverb");
+        auto audioBlock   = juce::dsp::AudioBlock<float> (block);
+        auto contextToUse = juce::dsp::ProcessContextReplacing<float> (audioBlock);
+        fxChain.process (contextToUse);
+
+        const auto reverbTicks = juce::Time::getHighResolutionTicks() - reverbStart;
+        perfProbe.record (reverbScope, reverbTicks, numSamples);
+        callbackReverbTicks += reverbTicks;
+
+        if (! synthActive && block.getMagnitude (0, numSamples) < kTailFloor)
+        {
+            fxChain.reset();   // drop the residue rather than carry denormal-sized state
+            reverbAsleep = true;
+        }
+    }
+}
+
+void NewProjectAudioProcessor::publishTelemetry (int numSamples, juce::int64 voiceTicks, juce::int64 reverbTicks) noexcept
+{
+    // Single writer, so plain load-and-store rather than read-modify-write
+    const auto addTo = [] (auto& total, auto amount)
+    {
+        total.store (total.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    };
+
+    const auto activeVoices = synth->getNumActiveVoices();
+
+    telemetryActiveVoices.store (activeVoices,           std::memory_order_relaxed);
+    telemetryVoiceCap    .store (synth->getVoiceCap(),  std::memory_order_relaxed);
+    telemetryStolenVoices.store (synth->getNumStolen(), std::memory_order_relaxed);
+    TRACE_COUNTER ("active voices", activeVoices);
+
+    // Voices that finished during the block rendered part of it, so this
+    // counts the survivors; close enough for an average
+    if (voiceTicks > 0 && activeVoices > 0)
+    {
+        addTo (telemetryVoiceSamples, (juce::uint64) activeVoices * (juce::uint64) numSamples);
+        addTo (telemetryVoiceTicks,   voiceTicks);
+    }
+
+    if (reverbTicks > 0)
+    {
+        addTo (telemetryReverbSamples, (juce::uint64) numSamples);
+        addTo (telemetryReverbTicks,   reverbTicks);
+    }
+}
+
+NewProjectAudioProcessor::Telemetry NewProjectAudioProcessor::getTelemetry() const noexcept
+{
+    const auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    Telemetry t;
+    t.activeVoices  = telemetryActiveVoices.load (std::memory_order_relaxed);
+    t.voiceCap      = telemetryVoiceCap.load (std::memory_order_relaxed);
+    t.stolenVoices  = telemetryStolenVoices.load (std::memory_order_relaxed);
+    t.voiceSamples  = telemetryVoiceSamples.load (std::memory_order_relaxed);
+    t.voiceSeconds  = (double) telemetryVoiceTicks.load (std::memory_order_relaxed) / ticksPerSecond;
+    t.reverbSamples = telemetryReverbSamples.load (std::memory_order_relaxed);
+    t.reverbSeconds = (double) telemetryReverbTicks.load (std::memory_order_relaxed) / ticksPerSecond;
+    t.qualityLevel  = qualityGovernor.getLevel();
+    return t;
+}
+
+bool NewProjectAudioProcessor::startTelemetryPublishing()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    stopTelemetryPublishing();
+
+    if (! telemetryPublisher.open ("NewProject"))
+        return false;
+
+    lastPublishedTelemetry = getTelemetry();
+    telemetryFormatChanged.store (true);
+    return true;
+}
+
+void NewProjectAudioProcessor::stopTelemetryPublishing()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    telemetryPublisher.close();
+}
+
+void NewProjectAudioProcessor::timerCallback()
+{
+    updateControlStream();
+
+    if (telemetryPublisher.isOpen())
+        publishTelemetryRecords();
+}
+
+void NewProjectAudioProcessor::publishTelemetryRecords()
+{
+    const auto sampleRate = getSampleRate();
+
+    if (telemetryFormatChanged.exchange (false))
+        telemetryPublisher.setInfo (sampleRate, getTotalNumOutputChannels(), &perfProbe);
+
+    // Averages since the last tick, as the editor shows them
+    const auto now = getTelemetry();
+
+    if (now.voiceSamples < lastPublishedTelemetry.voiceSamples || now.reverbSamples < lastPublishedTelemetry.reverbSamples)
+        lastPublishedTelemetry = {};   // prepareToPlay() restarted the totals
+
+    const auto load = [sampleRate] (double seconds, juce::uint64 numSamples)
+    {
+        return numSamples > 0 && sampleRate > 0.0 ? (float) (100.0 * seconds * sampleRate / (double) numSamples) : 0.0f;
+    };
+
+    TelemetryRecord record;
+    record.time   = SharedTelemetry::now();
+    record.kind   = TelemetryRecord::voices;
+    record.values = { (float) now.activeVoices, (float) now.voiceCap,
+                      load (now.voiceSeconds  - lastPublishedTelemetry.voiceSeconds,  now.voiceSamples  - lastPublishedTelemetry.voiceSamples),
+                      load (now.reverbSeconds - lastPublishedTelemetry.reverbSeconds, now.reverbSamples - lastPublishedTelemetry.reverbSamples) };
+
+    telemetryPublisher.publish (record);
+    telemetryPublisher.publishLoads (perfProbe);
+    lastPublishedTelemetry = now;
+}
+
+//==============================================================================
+void NewProjectAudioProcessor::handleUniversalMidiPacket (const juce::uint32* packet)
+{
+    const auto word = packet[0];
+    const auto type = word >> 28;
+
+    // Channel voice messages only: 0x2 is MIDI 1.0's, 0x4 MIDI 2.0's
+    if (type != 0x2 && type != 0x4)
+        return;
+
+    const bool midi2   = type == 0x4;
+    const auto status  = (word >> 20) & 0x0f;
+    const auto channel = (int) ((word >> 16) & 0x0f) + 1;
+    const auto byte3   = (int) ((word >> 8) & 0x7f);   // note or controller number
+    const auto byte4   = (int) (word & 0x7f);
+    const auto data    = midi2 ? packet[1] : 0u;
+
+    const auto bipolar   = [data] { return (float) (((double) data - 2147483648.0) / 2147483648.0); };
+    const auto sevenBits = [data] { return (int) (data >> 25); };
+    const bool isMember  = channel != NoteExpression::kMasterChannel;
+
+    // handlePitchWheel() is public on juce::Synthesiser itself
+    juce::Synthesiser& base = *synth;
+
+    switch (status)
+    {
+        case 0x9:
+        case 0x8:
+        {
+            const auto velocity = midi2 ? (float) (data >> 16) / 65535.0f : (float) byte4 / 127.0f;
+            const bool isNoteOn = status == 0x9 && (midi2 || byte4 > 0);   // MIDI 1.0: velocity 0 is a note-off
+
+            if (isNoteOn)
+                synth->noteOn (channel, byte3, juce::jmax (velocity, 1.0f / 127.0f));
+            else
+                synth->noteOff (channel, byte3, velocity, true);
+
+            displayNotes.push ({ (juce::uint8) channel, (juce::uint8) byte3, isNoteOn, velocity });
+            break;
+        }
+
+        case 0xe:
+            base.handlePitchWheel (channel, midi2 ? (int) (data >> 18) : (byte4 << 7 | byte3));
+
+            // The above keeps the 14 bits new notes start from; the sounding
+            // ones get all 32
+            if (midi2 && isMember)
+                synth->forEachVoicePlaying (channel, -1, [bend = bipolar() * NoteExpression::kNoteBendRange] (PooledVoice& voice)
+                {
+                    voice.setControlBend (bend);
+                });
+            break;
+
+        case 0xb:
+            base.handleController (channel, byte3, midi2 ? sevenBits() : byte4);
+
+            if (midi2 && isMember && byte3 == NoteExpression::kTimbreController)
+                synth->forEachVoicePlaying (channel, -1, [timbre = (float) (data / 2147483648.0) - 1.0f] (PooledVoice& voice)
+                {
+                    voice.setControlTimbre (timbre);
+                });
+            break;
+
+        case 0xd: base.handleChannelPressure (channel, midi2 ? sevenBits() : byte3); break;
+        case 0xa: base.handleAftertouch (channel, byte3, midi2 ? sevenBits() : byte4); break;
+
+        case 0x6:   // MIDI 2.0 per-note pitch bend
+            if (midi2)
+                synth->forEachVoicePlaying (channel, byte3, [bend = bipolar() * NoteExpression::kNoteBendRange] (PooledVoice& voice)
+                {
+                    voice.setControlBend (bend);
+                });
+            break;
+
+        case 0x0:   // MIDI 2.0 registered / assignable per-note controllers
+        case 0x1:
+        {
+            if (! midi2)
+                break;
+
+            const auto index = (int) (word & 0xff);
+
+            if (status == 0x0 && index == 3)   // Pitch 7.25: the note's absolute pitch
+                synth->forEachVoicePlaying (channel, byte3, [bend = (float) (data / 33554432.0) - (float) byte3] (PooledVoice& voice)
+                {
+                    voice.setControlBend (bend);
+                });
+            else if (index == NoteExpression::kTimbreController)
+                synth->forEachVoicePlaying (channel, byte3, [timbre = (float) (data / 2147483648.0) - 1.0f] (PooledVoice& voice)
+                {
+                    voice.setControlTimbre (timbre);
+                });
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void NewProjectAudioProcessor::updateControlStream()
+{
+    // Only this thread swaps the reader, so it can look at it unlocked
+    const bool wanted = controlStreamWanted.load();
+    const bool alive  = controlStream != nullptr && controlStream->isAlive (kControlStreamStaleMs);
+
+    std::unique_ptr<ControlStream::Reader> next;
+
+    if (wanted && ! alive)
+    {
+        // A region left behind by a controller that crashed is never alive,
+        // so it isn't attached
+        next = std::make_unique<ControlStream::Reader>();
+
+        if (! next->open (ControlStream::getRegionFile ("virtual-key")) || ! next->isAlive (kControlStreamStaleMs))
+            next.reset();
+    }
+
+    if (next != nullptr || (controlStream != nullptr && ! (wanted && alive)))
+    {
+        // Mapping and unmapping happen out here; the lock only covers the swap
+        const juce::SpinLock::ScopedLockType lock (controlStreamLock);
+        std::swap (controlStream, next);
+    }
+
+    controlStreamLive.store (controlStream != nullptr);
+}
+
+void NewProjectAudioProcessor::applyControlStream (ControlStream::Reader& reader)
+{
+    const auto semitonesPerUnitX = reader.getSemitonesPerUnitX();
+
+    // Every frame moves the anchors, but only the latest positions reach
+    // the voices, which glide to them anyway
+    reader.readNew ([this, semitonesPerUnitX] (const ControlFrame& frame)
+    {
+        for (size_t i = 0; i < controlFingers.size(); ++i)
+        {
+            const auto finger = i < frame.numFingers ? frame.fingers[i] : ControlFinger();
+            auto&      state  = controlFingers[i];
+
+            // A new note bends from wherever the finger landed on its key
+            if (finger.channel != state.channel || finger.note != state.note)
+            {
+                state.channel = finger.channel;
+                state.note    = finger.note;
+                state.anchorX = finger.x;
+            }
+
+            if (state.channel == 0)
+                continue;
+
+            state.bend   = (finger.x - state.anchorX) * semitonesPerUnitX;
+            state.timbre = 2.0f * finger.y - 1.0f;
+            state.moved  = true;
+        }
+    });
+
+    // z, the press depth, travels in the frames too but has no modulator yet
+    for (auto& state : controlFingers)
+    {
+        if (! state.moved)
+            continue;
+
+        state.moved = false;
+
+        if (state.channel != 0)
+            synth->applyControl (state.channel, state.note, state.bend, state.timbre);
+    }
 }
 
 //==============================================================================
@@ -260,17 +1127,71 @@ juce::AudioProcessorEditor* NewProjectAudioProcessor::createEditor()
 //==============================================================================
 void NewProjectAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    const auto state = apvts.copyState();
+
+    destData.reset();
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt ((int) kStateMagic);
+    stream.writeInt ((int) kStateVersion);
+    state.writeToStream (stream);
 }
 
 void NewProjectAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
-    if (xmlState != nullptr)
-        if (xmlState->hasTagName (apvts.state.getType()))
-            apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+    auto newState = decodeState (data, sizeInBytes);
+
+    if (! newState.isValid())
+        return;
+
+    // Hosts that restore from another thread get it applied on the message
+    // thread, where the tree's listeners and attachments expect it; the
+    // decoding is all done here
+    if (juce::MessageManager::existsAndIsCurrentThread())
+    {
+        applyState (newState);
+        return;
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock (pendingStateLock);
+        pendingState = std::move (newState);
+    }
+
+    triggerAsyncUpdate();
+}
+
+juce::ValueTree NewProjectAudioProcessor::decodeState (const void* data, int sizeInBytes) const
+{
+    juce::ValueTree state;
+
+    if (sizeInBytes >= 8 && (juce::uint32) juce::ByteOrder::littleEndianInt (data) == kStateMagic)
+    {
+        juce::MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+        stream.skipNextBytes (4);
+
+        // A newer build's layout may mean something else; leave the
+        // parameters alone rather than guess
+        if ((juce::uint32) stream.readInt() > kStateVersion)
+            return {};
+
+        state = juce::ValueTree::readFromStream (stream);
+    }
+    else if (auto xml = getXmlFromBinary (data, sizeInBytes))
+    {
+        state = juce::ValueTree::fromXml (*xml);
+    }
+
+    return state.hasType (apvts.state.getType()) ? state : juce::ValueTree();
+}
+
+void NewProjectAudioProcessor::applyState (const juce::ValueTree& newState)
+{
+    // replaceState() moves one parameter at a time; holding processBlock()
+    // to the groups it already has until all of them have moved means no
+    // block renders with half the old preset and half the new
+    applyingState.store (true);
+    apvts.replaceState (newState);
+    applyingState.store (false);
 }
 
 //==============================================================================
@@ -9,90 +9,89 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "Oscillators.h"
+#include "WavetableSet.h"
+#include "WavetableLoader.h"
+#include "UnisonOscillator.h"
+#include "BlockADSR.h"
+#include "ExpressionSmoother.h"
+#include "VoiceParameters.h"
+#include "NoteExpression.h"
+#include "ExpressionCoalescer.h"
+#include "OscExpressionInput.h"
+#include "UniversalMidiFifo.h"
+#include "ModulationEngine.h"
+#include "LadderCore.h"
+#include "FilterOversampling.h"
+#include "RenderProfile.h"
+#include "VoicePool.h"
+#include "RenderWorkers.h"
+#include "NoteCache.h"
+#include "SIMDVoiceBank.h"
+#include "ReverbSlot.h"
+#include "SubBlockEngine.h"
+#include "XrunMonitor.h"
+#include "../../Shared/LockFreeRing.h"
+#include "../../Shared/MidiEventFifo.h"
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/QualityGovernor.h"
+#include "../../Shared/RealtimeSafety.h"
+#include "../../Shared/SharedTelemetry.h"
+#include "../../Shared/TraceEvents.h"
+#include "../../Shared/VectorKernels.h"
+#include "../../Shared/ControlStream.h"
+#include "../../Shared/DspArena.h"
 
 //==============================================================================
-struct SineWaveSound : public juce::SynthesiserSound
-{
-    SineWaveSound() {}
-    bool appliesToNote    (int) override { return true; }
-    bool appliesToChannel (int) override { return true; }
-};
-
-//==============================================================================
-template <typename Type>
-class CustomOscillator
+class DSPVoice : public PooledVoice
 {
 public:
-    enum { oscIndex, gainIndex };
-
-    CustomOscillator()
+    /** The parameters and the modulation must outlive the voice. */
+    DSPVoice (const VoiceParameters& sharedParameters, const ModulationEngine& sharedModulation)
+        : parameters (sharedParameters), modulation (sharedModulation)
     {
-        // Sawtooth wave: linearly maps -pi..pi to -1..1
-        auto& osc = processorChain.template get<oscIndex>();
-        osc.initialise ([] (Type x)
-        {
-            return juce::jmap (x,
-                               Type (-juce::MathConstants<double>::pi),
-                               Type ( juce::MathConstants<double>::pi),
-                               Type (-1), Type (1));
-        }, 2);
     }
 
-    void prepare (const juce::dsp::ProcessSpec& spec) { processorChain.prepare (spec); }
-    void reset()  noexcept                             { processorChain.reset();  }
-
-    void setFrequency (Type newValue, bool force = false)
+    /** Where the voice sits in the stereo field, -1 (left) … 1 (right).
+        Centre (the default) plays at full level on every channel. */
+    void setPan (float newPan) noexcept
     {
-        processorChain.template get<oscIndex>().setFrequency (newValue, force);
+        pan = juce::jlimit (-1.0f, 1.0f, newPan);
     }
 
-    void setLevel (Type newValue)
+    /** Takes the voice's block buffers, a signal per side and its
+        envelope, from the processor's arena; from inside DspArena::build(). */
+    void allocate (DspArena& arena, int maximumBlockSize) noexcept
     {
-        processorChain.template get<gainIndex>().setGainLinear (newValue);
-    }
+        for (auto& channel : tempChannels)
+            channel = arena.allocate<float> ((size_t) maximumBlockSize);
 
-    template <typename ProcessContext>
-    void process (const ProcessContext& context) noexcept
-    {
-        processorChain.process (context);
+        envelopeGains = arena.allocate<float> ((size_t) maximumBlockSize);
+        tempBlock     = juce::dsp::AudioBlock<float> (tempChannels.data(), tempChannels.size(), (size_t) maximumBlockSize);
     }
 
-private:
-    juce::dsp::ProcessorChain<juce::dsp::Oscillator<Type>, juce::dsp::Gain<Type>> processorChain;
-};
-
-//==============================================================================
-class DSPVoice : public juce::SynthesiserVoice
-{
-public:
-    void setADSRParameters (const juce::ADSR::Parameters& params)
-    {
-        adsr.setParameters (params);
-    }
-
-    void setLFOFrequency (float freqHz)
-    {
-        lfo.setFrequency (freqHz);
-    }
-
-    void prepare (const juce::dsp::ProcessSpec& spec)
+    /** `spec` describes the output; the voice renders mono, or a signal
+        per side while the unison is spread over a stereo output, and fans
+        out to spec.numChannels when mixing, with the filter oversampled as
+        the published renderProfile says.  After allocate(), for the same
+        maximumBlockSize. */
+    void prepare (const juce::dsp::ProcessSpec& spec, const RenderProfiles& profiles)
     {
         currentSampleRate = spec.sampleRate;
-        tempBlock = juce::dsp::AudioBlock<float> (heapBlock, spec.numChannels, spec.maximumBlockSize);
-        processorChain.prepare (spec);
+        numOutputChannels = (int) spec.numChannels;
+        oscillator.prepare (spec.sampleRate);
+
+        for (auto& filter : filters)
+            filter.reset();
 
-        // Set initial ladder filter and master gain
-        auto& filter = processorChain.get<filterIndex>();
-        filter.setCutoffFrequencyHz (1000.0f);
-        filter.setResonance (0.7f);
-        processorChain.get<masterGainIndex>().setGainLinear (0.7f);
+        for (size_t i = 0; i < profiles.size(); ++i)
+            oversamplers[i] = profiles[i].filterOversampling.create (tempChannels.size(), spec.maximumBlockSize);
 
-        // LFO: sine wave at 3 Hz, processed 100x less often than audio rate
-        lfo.initialise ([] (float x) { return std::sin (x); }, 128);
-        lfo.setFrequency (3.0f);
-        lfo.prepare ({ spec.sampleRate / lfoUpdateRate, spec.maximumBlockSize, spec.numChannels });
+        oversampling   = oversamplers[(size_t) parameters.renderProfile].get();
+        appliedVersion = ~0u;
 
         adsr.setSampleRate (spec.sampleRate);
+        expression.prepare (spec.sampleRate);
     }
 
     bool canPlaySound (juce::SynthesiserSound* sound) override
@@ -101,20 +100,22 @@ public:
     }
 
     void startNote (int midiNoteNumber, float velocity,
-                    juce::SynthesiserSound*, int /*pitchWheelPosition*/) override
+                    juce::SynthesiserSound*, int pitchWheelPosition) override
     {
-        auto freqHz = (float) juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber);
+        noteHz = (float) juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber);
 
-        // OSC1: fundamental frequency
-        processorChain.get<osc1Index>().setFrequency (freqHz, true);
-        processorChain.get<osc1Index>().setLevel (velocity);
-
-        // OSC2: slightly detuned (+1%) for a thicker sound
-        processorChain.get<osc2Index>().setFrequency (freqHz * 1.01f, true);
-        processorChain.get<osc2Index>().setLevel (velocity);
+        expression.noteStarted (pitchWheelPosition, getMasterPitchWheel());
+        samplesToControlStep = NoteExpression::kControlSamples;
+        cutoffRatio          = 1.0f;   // timbre starts centred
 
+        // Parameters first: an idle voice may still hold a wavetable
+        // that's been freed since it last played
         adsr.setSampleRate (currentSampleRate);
+        applyParameters();
+        retune();
+        oscillator.setLevel (velocity);
         adsr.noteOn();
+        noteStarted();
     }
 
     void stopNote (float /*velocity*/, bool allowTailOff) override
@@ -122,17 +123,32 @@ public:
         if (allowTailOff)
         {
             adsr.noteOff();
+            noteReleased();
         }
         else
         {
-            clearCurrentNote();
+            noteFinished();
             adsr.reset();
-            processorChain.reset();
+            resetSignalPath();
         }
     }
 
-    void pitchWheelMoved (int) override {}
-    void controllerMoved (int, int) override {}
+    float getEnvelopeLevel() const noexcept override { return adsr.getLevel(); }
+
+    // MPE: the synth sends these for the note's own channel only
+    void pitchWheelMoved (int newPitchWheelValue) override { expression.setPitchWheel (newPitchWheelValue); }
+
+    void controllerMoved (int controllerNumber, int newControllerValue) override
+    {
+        if (controllerNumber == NoteExpression::kTimbreController)
+            expression.setTimbre (newControllerValue);
+    }
+
+    void channelPressureChanged (int newValue) override { expression.setPressure (newValue); }
+    void aftertouchChanged      (int newValue) override { expression.setPressure (newValue); }
+
+    void setControlBend   (float semitones) noexcept override { expression.setNoteBendSemitones (semitones); }
+    void setControlTimbre (float bipolar) noexcept override   { expression.setTimbreTarget (bipolar); }
 
     void renderNextBlock (juce::AudioSampleBuffer& outputBuffer,
                           int startSample, int numSamples) override
@@ -140,70 +156,292 @@ public:
         if (! adsr.isActive())
             return;
 
-        auto output = tempBlock.getSubBlock (0, (size_t) numSamples);
-        output.clear();
-
-        // Process DSP chain in chunks so the LFO can update between them
-        for (size_t pos = 0; pos < (size_t) numSamples;)
+        applyParameters();
+
+        const auto numSides = stereo ? (size_t) 2 : (size_t) 1;
+        auto       output   = tempBlock.getSubsetChannelBlock (0, numSides).getSubBlock (0, (size_t) numSamples);
+
+        // At the base rate and to a mono or stereo output, every run is one
+        // fused pass straight into outputBuffer (renderFusedRun()); the
+        // oversampled filter, or more channels, take a pass per stage over
+        // tempBlock.  The envelope is rendered first either way: BlockADSR
+        // writes whole segments, far cheaper than stepping it per sample
+        const int  numChannels = outputBuffer.getNumChannels();
+        const bool fused       = oversampling == nullptr && numChannels <= 2;
+        adsr.render (envelopeGains, numSamples);
+
+        // Oscillators and filter a run at a time, the runs ending at the
+        // expression's control steps, where the oscillators are retuned;
+        // the filter follows the shared cutoff curve from where this block
+        // starts in it, at the oversampled rate if there is one
+        auto* left         = tempBlock.getChannelPointer (0);
+        auto* right        = stereo ? tempBlock.getChannelPointer (1) : nullptr;
+        const auto  factor = modulation.getOversamplingFactor();
+        const auto* cutoff = modulation.getCutoffCoefficients() + startSample * factor;
+
+        for (int pos = 0; pos < numSamples;)
         {
-            auto max   = juce::jmin ((size_t) numSamples - pos, lfoUpdateCounter);
-            auto block = output.getSubBlock (pos, max);
-
-            juce::dsp::ProcessContextReplacing<float> context (block);
-            processorChain.process (context);
+            if (samplesToControlStep == 0)
+            {
+                expression.setMasterPitchWheel (getMasterPitchWheel());
+                expression.step();
+                retune();
+                samplesToControlStep = NoteExpression::kControlSamples;
+            }
 
-            pos              += max;
-            lfoUpdateCounter -= max;
+            const auto run = juce::jmin (numSamples - pos, samplesToControlStep);
 
-            if (lfoUpdateCounter == 0)
+            if (fused)
             {
-                lfoUpdateCounter  = lfoUpdateRate;
-                auto lfoOut       = lfo.processSample (0.0f);
-                // LFO modulates ladder filter cutoff between 100 Hz and 2 kHz
-                auto cutoffFreqHz = juce::jmap (lfoOut, -1.0f, 1.0f, 100.0f, 2000.0f);
-                processorChain.get<filterIndex>().setCutoffFrequencyHz (cutoffFreqHz);
+                renderFusedRun (outputBuffer, startSample + pos, run, cutoff + pos, envelopeGains + pos);
             }
+            else
+            {
+                auto chunk = output.getSubBlock ((size_t) pos, (size_t) run);
+                oscillator.render (left + pos, right != nullptr ? right + pos : nullptr, run);
+                filterRun (chunk, cutoff + pos * factor, run * factor);
+            }
+
+            pos                  += run;
+            samplesToControlStep -= run;
         }
 
-        // Apply ADSR envelope per-sample, then mix into output buffer
-        for (int i = 0; i < numSamples; ++i)
+        if (fused)
+            finishBlock();
+        else
+            mixBlock (outputBuffer, startSample, numSamples, left, right);
+    }
+
+private:
+    /** The multi-pass path's end: applies the envelope to the signal once,
+        then fans it out, one scaled add per output channel (balance law, so
+        centre is unity).  Spread, each side goes to its own channel, and
+        both to the rest. */
+    void mixBlock (juce::AudioSampleBuffer& outputBuffer, int startSample, int numSamples,
+                   float* left, float* right) noexcept
+    {
+        const auto& kernels = VectorKernels::get();
+        kernels.multiply (left, envelopeGains, numSamples);
+
+        if (right != nullptr)
+            kernels.multiply (right, envelopeGains, numSamples);
+
+        const int numChannels = outputBuffer.getNumChannels();
+        for (int ch = 0; ch < numChannels; ++ch)
         {
-            const float env = adsr.getNextSample();
-            for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
-                outputBuffer.getWritePointer (ch, startSample)[i] +=
-                    tempBlock.getChannelPointer (ch)[i] * env;
+            const float gain = numChannels < 2 ? 1.0f
+                             : ch == 0         ? juce::jmin (1.0f, 1.0f - pan)
+                             : ch == 1         ? juce::jmin (1.0f, 1.0f + pan)
+                                               : 1.0f;
+
+            auto* out = outputBuffer.getWritePointer (ch, startSample);
+
+            if (right == nullptr)
+                kernels.multiplyAdd (out, left, gain * masterGain, numSamples);
+            else if (ch < 2)
+                kernels.multiplyAdd (out, ch == 0 ? left : right, gain * masterGain, numSamples);
+            else
+            {
+                kernels.multiplyAdd (out, left,  0.5f * masterGain, numSamples);
+                kernels.multiplyAdd (out, right, 0.5f * masterGain, numSamples);
+            }
         }
 
+        finishBlock();
+    }
+
+    void finishBlock()
+    {
         if (! adsr.isActive())
         {
-            clearCurrentNote();
-            processorChain.reset();
+            noteFinished();
+            resetSignalPath();
         }
     }
 
-private:
-    static constexpr size_t lfoUpdateRate    = 100;
-    size_t                  lfoUpdateCounter = lfoUpdateRate;
+    /** One run at the base rate, fused: the stack, the filter, the
+        envelope and the pan, a sample at a time, added straight into
+        outputBuffer (one or two channels) from firstSample. */
+    void renderFusedRun (juce::AudioSampleBuffer& outputBuffer, int firstSample, int run,
+                         const float* cutoff, const float* envelope) noexcept
+    {
+        float      step;
+        const auto ratio = beginCutoffRamp (cutoff, run, step);
+        auto*      out0  = outputBuffer.getWritePointer (0, firstSample);
+
+        if (outputBuffer.getNumChannels() < 2)
+            fusedRun<false, 1> (out0, nullptr, run, cutoff, envelope, ratio, step);
+        else if (stereo)
+            fusedRun<true, 2>  (out0, outputBuffer.getWritePointer (1, firstSample), run, cutoff, envelope, ratio, step);
+        else
+            fusedRun<false, 2> (out0, outputBuffer.getWritePointer (1, firstSample), run, cutoff, envelope, ratio, step);
+    }
+
+    /** The filters are copied into locals for the run, so their state can
+        live in registers rather than being stored back every sample. */
+    template <bool spread, int numChannels>
+    void fusedRun (float* out0, float* out1, int run, const float* cutoff, const float* envelope,
+                   float ratio, float step) noexcept
+    {
+        const auto gainLeft  = masterGain * (numChannels < 2 ? 1.0f : juce::jmin (1.0f, 1.0f - pan));
+        const auto gainRight = masterGain * juce::jmin (1.0f, 1.0f + pan);
+
+        auto filterLeft  = filters[0];
+        auto filterRight = filters[1];
+
+        for (int i = 0; i < run; ++i)
+        {
+            float left, right;
+            oscillator.next<spread> (left, right);
+
+            ratio += step;
+            const auto coefficient = cutoff[i] * ratio;
+            left = filterLeft.processSample (left, coefficient) * envelope[i];
+
+            if constexpr (spread)
+                right = filterRight.processSample (right, coefficient) * envelope[i];
+            else
+                right = left;
+
+            out0[i] += left * gainLeft;
+
+            if constexpr (numChannels == 2)
+                out1[i] += right * gainRight;
+        }
+
+        filters[0] = filterLeft;
+
+        if constexpr (spread)
+            filters[1] = filterRight;
+    }
+
+    void retune() noexcept
+    {
+        oscillator.setFrequency (noteHz * expression.getFrequencyRatio());
+    }
+
+    /** The timbre scales the cutoff as a1^s = a1 * a1^(s - 1): the shared
+        curve times a correction, ramped linearly to its value at the end
+        of the run.  Returns the ratio the run starts from, and its step
+        per filter sample. */
+    float beginCutoffRamp (const float* cutoff, int numFilterSamples, float& step) noexcept
+    {
+        const auto exponent = expression.getCutoffExponent();
+        const auto endRatio = exponent == 1.0f ? 1.0f : std::pow (cutoff[numFilterSamples - 1], exponent - 1.0f);
+        const auto ratio    = cutoffRatio;
+        step                = (endRatio - cutoffRatio) / (float) numFilterSamples;
+        cutoffRatio         = endRatio;
+        return ratio;
+    }
+
+    /** A run through the filter, each side its own on the same curve. */
+    void filterRun (juce::dsp::AudioBlock<float>& block, const float* cutoff, int numFilterSamples) noexcept
+    {
+        float      step;
+        const auto ratio = beginCutoffRamp (cutoff, numFilterSamples, step);
 
-    juce::HeapBlock<char>        heapBlock;
-    juce::dsp::AudioBlock<float> tempBlock;
+        const auto filterSides = [&] (const juce::dsp::AudioBlock<float>& sides)
+        {
+            for (size_t ch = 0; ch < sides.getNumChannels(); ++ch)
+            {
+                auto* x = sides.getChannelPointer (ch);
+                auto& filter = filters[ch];
+                auto  r = ratio;
+
+                for (int i = 0; i < numFilterSamples; ++i)
+                {
+                    r += step;
+                    x[i] = filter.processSample (x[i], cutoff[i] * r);
+                }
+            }
+        };
+
+        if (oversampling == nullptr)
+        {
+            filterSides (block);
+        }
+        else
+        {
+            // The oversampler has room for both sides; only block's are live
+            filterSides (oversampling->processSamplesUp (block).getSubsetChannelBlock (0, block.getNumChannels()));
+            oversampling->processSamplesDown (block);
+        }
+    }
+
+    void resetSignalPath()
+    {
+        oscillator.reset();
+
+        for (auto& filter : filters)
+            filter.reset();
+
+        if (oversampling != nullptr)
+            oversampling->reset();
+    }
+
+    /** Picks up a new publish; idle voices skip it until their next note. */
+    void applyParameters()
+    {
+        if (appliedVersion == parameters.version)
+            return;
+
+        adsr.setParameters (parameters.adsr);
+        expression.setSmoothing (parameters.expression);
+        appliedVersion = parameters.version;
 
-    enum { osc1Index, osc2Index, filterIndex, masterGainIndex };
+        // The right side picks up where the mono filter is, so spreading
+        // a held note doesn't click
+        const auto spread = parameters.unison.stereo && numOutputChannels >= 2;
 
-    juce::dsp::ProcessorChain<CustomOscillator<float>,
-                               CustomOscillator<float>,
-                               juce::dsp::LadderFilter<float>,
-                               juce::dsp::Gain<float>> processorChain;
+        if (spread && ! stereo)
+            filters[1] = filters[0];
 
-    juce::dsp::Oscillator<float> lfo;
-    juce::ADSR                   adsr;
+        stereo = spread;
+        oscillator.setLayout (parameters.unison);
+        oscillator.setWavetable (parameters.wavetable, parameters.wavetablePosition);
+        retune();
+
+        if (auto* profileOversampling = oversamplers[(size_t) parameters.renderProfile].get();
+            profileOversampling != oversampling)
+        {
+            oversampling = profileOversampling;
+            resetSignalPath();
+        }
+    }
+
+    const VoiceParameters&  parameters;
+    const ModulationEngine& modulation;
+    juce::uint32            appliedVersion = ~0u;
+
+    static constexpr float masterGain = 0.7f;
+
+    std::array<float*, 2>        tempChannels {};        // one block per side, from the arena
+    juce::dsp::AudioBlock<float> tempBlock;               // over tempChannels
+    float                        pan = 0.0f;
+    int                          numOutputChannels = 2;
+    bool                         stereo = false;          // the unison is spread: a signal per side
+
+    UnisonOscillator             oscillator;
+    std::array<LadderCore<float>, 2> filters;            // per side
+    NoteExpression               expression;
+    float                        noteHz               = 440.0f;
+    int                          samplesToControlStep = 0;
+    float                        cutoffRatio          = 1.0f;   // timbre's correction, where the last run ended
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, RenderProfile::numProfiles> oversamplers;
+    juce::dsp::Oversampling<float>* oversampling = nullptr;   // the current profile's; nullptr when off
+    BlockADSR                    adsr;
+    float*                       envelopeGains = nullptr;   // one block of adsr output, from the arena
     double                       currentSampleRate = 44100.0;
 };
 
 //==============================================================================
 /**
 */
-class NewProjectAudioProcessor  : public juce::AudioProcessor
+class NewProjectAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AudioProcessorValueTreeState::Listener,
+                                  private juce::MidiKeyboardState::Listener,
+                                  private juce::AsyncUpdater,
+                                  private juce::Timer
 {
 public:
     //==============================================================================
@@ -232,6 +470,9 @@ public:
     bool isMidiEffect() const override;
     double getTailLengthSeconds() const override;
 
+    /** Hands the host's workgroup on to the render workers. */
+    void audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup) override;
+
     //==============================================================================
     int getNumPrograms() override;
     int getCurrentProgram() override;
@@ -243,22 +484,393 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    // Exposed so the editor can attach a MidiKeyboardComponent to it
+    // Exposed so the editor can attach a MidiKeyboardComponent to it; its
+    // notes reach the audio thread through keyboardMidi
     juce::MidiKeyboardState keyboardState;
 
+    /** Lights keyboardState's keys for the notes the audio thread has seen
+        from the host and MIDI inputs since the last call.  Message thread;
+        the editor calls it from a timer. */
+    void updateKeyboardDisplay();
+
+    /** Plays the synth from a MIDI input outside the host, e.g. a
+        standalone app's AudioDeviceManager::addMidiInputDeviceCallback().
+        Wait-free for the audio thread; one input at a time. */
+    juce::MidiInputCallback& getMidiInputCallback() noexcept { return hardwareMidi; }
+
     // Parameter tree — public so the editor can create SliderAttachments
     juce::AudioProcessorValueTreeState apvts;
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    /** CPU load of this instance: "block" (all of processBlock), "voices"
+        (synth rendering) and "reverb".  Safe to read from any thread. */
+    const PerfProbe& getPerfProbe() const noexcept { return perfProbe; }
+    int              getBlockScope() const noexcept { return blockScope; }
+
+    /** The callbacks that went wrong (see XrunMonitor): counts from any
+        thread, events for the message thread. */
+    XrunMonitor& getXrunMonitor() noexcept { return xrunMonitor; }
+
+    /** Keeps rendering but outputs silence, so the standalone app's buffer
+        tuner can load the synth without being heard.  Any thread. */
+    void setOutputMuted (bool shouldMute) noexcept { outputMuted.store (shouldMute); }
+
+    /** Voices sounding after the last processBlock(), for tools that drive
+        the processor from the thread that renders it. */
+    int getNumActiveVoices() const noexcept { return synth->getNumActiveVoices(); }
+
+    /** "voiceEngine"'s choices.  Builds without SIMD play DSPVoices for
+        both. */
+    enum VoiceEngine { dspVoiceEngine, bankEngine };
+
+    /** Whether the SIMD bank rendered the last block, rather than
+        DSPVoices; follows "voiceEngine" from the next prepareToPlay(). */
+    bool isBankRendering() const noexcept
+    {
+       #if JUCE_USE_SIMD
+        return synth == &bankSynth;
+       #else
+        return false;
+       #endif
+    }
+
+    /** What the voices and reverb have been doing, as of the last block.
+        The totals only grow (until prepareToPlay()), so the difference
+        between two snapshots gives the averages over the time between
+        them: voiceSeconds / voiceSamples is the cost of one voice for one
+        sample, reverbSeconds / reverbSamples the reverb's per sample. */
+    struct Telemetry
+    {
+        int          activeVoices  = 0;
+        int          voiceCap      = 0;   // polyphony, lowered by the CPU limiter
+        int          qualityLevel  = 0;   // the CPU limiter's QualityGovernor level
+        juce::uint64 stolenVoices  = 0;
+        juce::uint64 voiceSamples  = 0;   // sounding voices × samples, summed over blocks
+        double       voiceSeconds  = 0.0;
+        juce::uint64 reverbSamples = 0;
+        double       reverbSeconds = 0.0;
+    };
+
+    /** Any thread; the fields come from the same block or adjacent ones. */
+    Telemetry getTelemetry() const noexcept;
+
+    /** Publishes the telemetry (as TelemetryRecord::voices) and the probe's
+        loads, a few times a second, into a "NewProject" shared-memory region
+        for external dashboards (see SharedTelemetry.h).  Message thread;
+        false if the region can't be created. */
+    bool startTelemetryPublishing();
+    void stopTelemetryPublishing();
+    bool isPublishingTelemetry() const noexcept { return telemetryPublisher.isOpen(); }
+
+    /** Follows the virtual-key controller's shared-memory control stream
+        (see ControlStream.h) whenever it is running: each finger's slide
+        in x bends its note, and its y sets the note's timbre, at camera
+        rate and without MIDI's quantisation.  The notes still come over
+        MIDI.  On by default; any thread. */
+    void setControlStreamInput (bool shouldFollow) noexcept { controlStreamWanted.store (shouldFollow); }
+    bool isReceivingControlStream() const noexcept          { return controlStreamLive.load(); }
+
+    /** Takes per-note expression over OSC on this UDP port (see
+        OscExpressionInput for the message), or stops listening on 0.  Off
+        by default and not kept with the session.  Message thread; false if
+        the port can't be bound. */
+    bool setOscInputPort (int port)       { return oscInput.setPort (port); }
+    int  getOscInputPort() const noexcept { return oscInput.getPort(); }
+
+    /** For its malformed and dropped counts.  Any thread. */
+    const OscExpressionInput& getOscInput() const noexcept { return oscInput; }
+
+    /** Plays the synth from MIDI 2.0 Universal MIDI Packets (and MIDI 1.0
+        ones), e.g. from a MIDI 2.0 input outside the host.  Per-note pitch
+        bend, the per-note Pitch 7.25 and #74 (timbre) controllers, and the
+        member channels' bends and CC74, keep their 32 bits and go straight
+        to the voices, with no MPE pitch bend and CC pair to split a block.
+        Applied where the next block starts, in order.  Wait-free; one
+        producer thread at a time; false if the packets didn't fit. */
+    bool pushUniversalMidiPackets (const juce::uint32* words, int numWords) noexcept
+    {
+        return umpInput.push (words, numWords);
+    }
+
+    /** Gives the convolution reverb this response instead of the room
+        built from the reverb's size and damping; useRoomImpulse() goes back
+        to that.  Not kept with the session.  Message thread. */
+    void loadImpulseResponse (juce::AudioBuffer<float> impulse, double impulseSampleRate);
+    void useRoomImpulse();
+
+    /** Plays the voices' stacks from a user wavetable instead of saws:
+        frameSize-sample single cycles (a power of two; 2048 is what most
+        editors write) back to back in the first channel, up to
+        WavetableSet::kMaxFrames of them, swept by "wavetablePosition".
+        Band-limited on a background thread while the current sound plays
+        on; useSawWave() goes back.  Not kept with the session.  Message
+        thread. */
+    void loadWavetable (juce::AudioBuffer<float> frames, int frameSize) { wavetables.load (std::move (frames), frameSize); }
+    void loadWavetable (const juce::File& file, int frameSize = 2048)   { wavetables.load (file, frameSize); }
+    void useSawWave()                                                   { wavetables.clear(); }
+
+    /** Within each quantum of this many samples the synth keeps only the
+        latest pitch bend, pressure and CC74 per channel (see
+        ExpressionCoalescer); 1 passes every event through.  Any thread. */
+    void setExpressionQuantum (int numSamples) noexcept { expressionQuantum.store (juce::jmax (1, numSamples)); }
+
+    /** How the voices glide to new pitch, timbre and pressure targets (see
+        ExpressionSmoother).  With the voices smoothing, a controller can
+        send sparse updates, e.g. a camera's 60 a second, and still not
+        zipper.  Any thread; the next block applies it. */
+    void setExpressionSmoothing (ExpressionSmoothing newSmoothing) noexcept
+    {
+        smoothingMinCutoffHz.store (newSmoothing.minCutoffHz);
+        smoothingBeta       .store (newSmoothing.beta);
+        changedGroups.fetch_or (smoothingChanged);
+    }
+
 private:
     //==============================================================================
-    juce::Synthesiser synth;
-    juce::MidiMessageCollector midiCollector;
+    // Parameter change tracking: the tree's listeners set a bit per group,
+    // from whichever thread moved the value, and processBlock() takes them
+    // all at once.  Only a set bit recomputes anything.
+    enum ParameterGroup : juce::uint32
+    {
+        envelopeChanged  = 1u << 0,
+        lfoChanged       = 1u << 1,
+        reverbChanged    = 1u << 2,
+        smoothingChanged = 1u << 4,   // setExpressionSmoothing()
+        unisonChanged    = 1u << 5,
+        wavetableChanged = 1u << 6,
+        allChanged       = envelopeChanged | lfoChanged | reverbChanged | smoothingChanged | unisonChanged | wavetableChanged,
+
+        // Reallocates every voice (oversampling, the sub-block size, the
+        // voice engine), so
+        // it's applied by prepareToPlay(), on the message thread, rather
+        // than by processBlock()
+        engineChanged = 1u << 3
+    };
+
+    struct ListenedParameter
+    {
+        const char*  id;
+        juce::uint32 group;
+    };
+
+    static const ListenedParameter listenedParameters[22];
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+
+    // Applies a state setStateInformation() decoded away from the message
+    // thread, rebuilds the convolution engine's room, then re-prepares
+    // with any new filter oversampling, processing suspended
+    void handleAsyncUpdate() override;
+
+    // The convolution engine's response from the room size and damping,
+    // unless one was loaded; not the audio thread
+    void updateRoomImpulse();
+
+    std::atomic<bool> roomRequested { false };   // size or damping moved under the convolution engine
+    std::atomic<bool> hasLoadedImpulse { false };
+
+    // The voices' wavetable, swapped into voiceParameters between sub-blocks
+    WavetableLoader wavetables;
+
+    //==============================================================================
+    // Saved state: a versioned header followed by the tree in JUCE's binary
+    // ValueTree encoding, which writes and parses far faster than XML.
+    // Sessions saved as XML by earlier builds still load.
+    static constexpr juce::uint32 kStateMagic   = 0x7453504e;   // "NPSt"
+    static constexpr juce::uint32 kStateVersion = 1;
+
+    juce::ValueTree decodeState (const void* data, int sizeInBytes) const;
+
+    // Swaps a decoded tree into the parameters in one go, message thread
+    void applyState (const juce::ValueTree& newState);
+
+    juce::SpinLock    pendingStateLock;
+    juce::ValueTree   pendingState;                  // guarded by pendingStateLock
+    std::atomic<bool> reprepareRequested { false };  // oversampling, the sub-block size or the voice engine moved
+    std::atomic<bool> applyingState      { false };  // processBlock() holds off meanwhile
+
+    // Realtime and offline settings, both prepared by prepareToPlay();
+    // processBlock() follows isNonRealtime() between them
+    void applyRenderProfile (RenderProfile::Index profile) noexcept;
+
+    RenderProfiles        renderProfiles;
+    std::array<int, RenderProfile::numProfiles> profileLatencies {};   // samples
+    RenderProfile::Index  activeProfile = RenderProfile::realtime;
+
+    std::atomic<juce::uint32> changedGroups { allChanged };
+    bool                      isPrepared = false;   // between prepareToPlay() and releaseResources()
+
+    // Declared before synth, which owns the voices that read them
+    VoiceParameters  voiceParameters;
+    ModulationEngine modulation;
+
+    // The two engines "voiceEngine" picks between.  Each allocates its pool
+    // the first time it's picked; prepareToPlay() switches synth over
+    VoicePoolSynthesiser   voiceSynth;
+    std::vector<DSPVoice*> voices;   // owned by voiceSynth
+
+   #if JUCE_USE_SIMD
+    // The bank renders; bankSynth only allocates its voices
+    SIMDVoiceBank          voiceBank { voiceParameters, modulation };
+    BankSynthesiser        bankSynth { voiceBank };
+   #endif
+
+    VoicePoolSynthesiser*  synth = &voiceSynth;   // the engine playing; changed only by prepareToPlay()
+    DspArena               dspArena;   // the playing engine's block buffers, built in prepareToPlay()
+
+    // CPU limiter: while "cpuLimiter" is on, the governor sheds quality
+    // as live blocks near their deadline.  Level 1 swaps the convolution
+    // reverb for the FDN; every level after it halves the voice cap,
+    // counted from the voices sounding when it was reached
+    static constexpr int kQualityLevels = 6;   // down to a sixteenth of the voices
+
+    void applyQualityLevel (int level);
+
+    int appliedQualityLevel = 0;
+    int limiterCap          = VoicePoolSynthesiser::kMaxVoices;
+
+    // Each source has its own single-producer fifo: hardwareMidi is fed by
+    // a MIDI input thread, keyboardMidi by the message thread
+    MidiEventFifo hardwareMidi, keyboardMidi;
+
+    // Host and hardware notes on their way to the keyboard display; the
+    // audio thread only pushes, so a closed editor costs it nothing more
+    struct DisplayNote
+    {
+        juce::uint8 channel, note;
+        bool        isNoteOn;
+        float       velocity;
+    };
+
+    LockFreeRing<DisplayNote, 512> displayNotes;
+    juce::uint64 displayNotesDropped = 0;   // as of the last update; message thread
+    bool         updatingDisplay     = false;   // our own keyboardState calls, kept out of keyboardMidi
+
+    ExpressionCoalescer expressionCoalescer;
+    std::atomic<int>    expressionQuantum { ExpressionCoalescer::kDefaultQuantum };
+    std::atomic<float>  smoothingMinCutoffHz { ExpressionSmoothing().minCutoffHz };
+    std::atomic<float>  smoothingBeta        { ExpressionSmoothing().beta };
+    OscExpressionInput  oscInput;
+
+    // MIDI 2.0 input: each packet acts on the synth directly, audio thread
+    void handleUniversalMidiPacket (const juce::uint32* packet);
+
+    UniversalMidiFifo   umpInput;
+
+    void handleNoteOn  (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
+    void handleNoteOff (juce::MidiKeyboardState*, int midiChannel, int midiNoteNumber, float velocity) override;
 
     // Post-process effects chain: reverb applied to the full mix
     enum { reverbIndex };
-    juce::dsp::ProcessorChain<juce::dsp::Reverb> fxChain;
+    juce::dsp::ProcessorChain<ReverbSlot> fxChain;
+
+    // Voices and reverb render a sub-block at a time, whatever the host's
+    // blocks; see SubBlockEngine.  Each sub-block picks up the parameters
+    // that moved and adds its time to the callback's
+    static constexpr int kSubBlockSizes[] { 16, 32, 64, 128 };
+
+    void renderSubBlock (juce::AudioBuffer<float>& block, juce::MidiBuffer& midi);
+    void applyParameterChanges();
+
+    SubBlockEngine subBlocks;
+    juce::int64    callbackVoiceTicks = 0, callbackReverbTicks = 0;
+
+    // Once nothing feeds it and a whole sub-block of its output stays under
+    // kTailFloor (-100 dB), the reverb is reset and skipped until a note
+    // arrives, so an idle instance only clears its buffer
+    static constexpr float kTailFloor = 1.0e-5f;
+    bool reverbAsleep = true;
+
+    // Looked up once; the tree owns them
+    std::atomic<float>* const attackParam        { apvts.getRawParameterValue ("attack") };
+    std::atomic<float>* const decayParam         { apvts.getRawParameterValue ("decay") };
+    std::atomic<float>* const sustainParam       { apvts.getRawParameterValue ("sustain") };
+    std::atomic<float>* const releaseParam       { apvts.getRawParameterValue ("release") };
+    std::atomic<float>* const lfoFreqParam       { apvts.getRawParameterValue ("lfoFreq") };
+    std::atomic<float>* const lfoDepthParam      { apvts.getRawParameterValue ("lfoDepth") };
+    std::atomic<float>* const noteCacheParam     { apvts.getRawParameterValue ("noteCache") };
+    std::atomic<float>* const unisonVoicesParam  { apvts.getRawParameterValue ("unisonVoices") };
+    std::atomic<float>* const unisonDetuneParam  { apvts.getRawParameterValue ("unisonDetune") };
+    std::atomic<float>* const unisonSpreadParam  { apvts.getRawParameterValue ("unisonSpread") };
+    std::atomic<float>* const wavetablePositionParam { apvts.getRawParameterValue ("wavetablePosition") };
+    std::atomic<float>* const reverbSizeParam    { apvts.getRawParameterValue ("reverbSize") };
+    std::atomic<float>* const reverbDampingParam { apvts.getRawParameterValue ("reverbDamping") };
+    std::atomic<float>* const reverbWetParam     { apvts.getRawParameterValue ("reverbWet") };
+    std::atomic<float>* const reverbWidthParam   { apvts.getRawParameterValue ("reverbWidth") };
+    std::atomic<float>* const reverbEngineParam  { apvts.getRawParameterValue ("reverbEngine") };
+    std::atomic<float>* const reverbRateParam    { apvts.getRawParameterValue ("reverbRate") };
+    std::atomic<float>* const polyphonyParam     { apvts.getRawParameterValue ("polyphony") };
+    std::atomic<float>* const voiceEngineParam   { apvts.getRawParameterValue ("voiceEngine") };
+    std::atomic<float>* const cpuLimiterParam    { apvts.getRawParameterValue ("cpuLimiter") };
+    std::atomic<float>* const multithreadedParam { apvts.getRawParameterValue ("multithreaded") };
+    std::atomic<float>* const oversamplingParam  { apvts.getRawParameterValue ("oversampling") };
+    std::atomic<float>* const linearPhaseParam   { apvts.getRawParameterValue ("linearPhase") };
+    std::atomic<float>* const offlineOversamplingParam { apvts.getRawParameterValue ("offlineOversampling") };
+    std::atomic<float>* const offlineLinearPhaseParam  { apvts.getRawParameterValue ("offlineLinearPhase") };
+    std::atomic<float>* const subBlockParam            { apvts.getRawParameterValue ("subBlock") };
+
+   #if JUCE_USE_SIMD
+    RenderWorkers renderWorkers;   // started in prepareToPlay(), used while "multithreaded" is on
+   #endif
+
+    PerfProbe perfProbe;
+    const int blockScope  { perfProbe.addScope ("block") };
+    const int voicesScope { perfProbe.addScope ("voices") };
+    const int reverbScope { perfProbe.addScope ("reverb") };
+
+    XrunMonitor       xrunMonitor;
+    std::atomic<bool> outputMuted { false };
+
+    QualityGovernor qualityGovernor { "NewProject", kQualityLevels };
+
+   #if REALTIME_SAFETY_CHECKS
+    RealtimeSafety::ViolationReporter realtimeSafetyReporter;
+   #endif
+
+    // getTelemetry()'s fields; written only by the audio thread
+    void publishTelemetry (int numSamples, juce::int64 voiceTicks, juce::int64 reverbTicks) noexcept;
+
+    std::atomic<int>          telemetryActiveVoices  { 0 };
+    std::atomic<int>          telemetryVoiceCap      { 0 };
+    std::atomic<juce::uint64> telemetryStolenVoices  { 0 };
+    std::atomic<juce::uint64> telemetryVoiceSamples  { 0 };
+    std::atomic<juce::int64>  telemetryVoiceTicks    { 0 };
+    std::atomic<juce::uint64> telemetryReverbSamples { 0 };
+    std::atomic<juce::int64>  telemetryReverbTicks   { 0 };
+
+    // Shared memory, on the message thread: timerCallback() runs from
+    // construction on, keeps the control stream attached, and publishes
+    // telemetry while startTelemetryPublishing() has a region open
+    void timerCallback() override;
+
+    SharedTelemetry::Publisher telemetryPublisher;
+    Telemetry                  lastPublishedTelemetry;
+    std::atomic<bool>          telemetryFormatChanged { true };   // prepareToPlay() ran
+
+    // The control stream: the timer attaches and drops the reader, and
+    // processBlock() drains it into the voices.  A block that finds the
+    // lock taken skips it, and the frames wait for the next one.
+    static constexpr juce::int64 kControlStreamStaleMs = 1000;
+
+    void publishTelemetryRecords();
+    void updateControlStream();
+    void applyControlStream (ControlStream::Reader& reader);
+
+    // Per frame slot: the note it played last, and the x its bend is from
+    struct ControlFingerState
+    {
+        juce::uint8 channel = 0, note = 0;
+        float       anchorX = 0.0f;
+        float       bend = 0.0f, timbre = 0.0f;
+        bool        moved = false;
+    };
+
+    juce::SpinLock                                            controlStreamLock;
+    std::unique_ptr<ControlStream::Reader>                    controlStream;   // guarded by controlStreamLock
+    std::array<ControlFingerState, ControlFrame::kMaxFingers> controlFingers;  // audio thread
+    std::atomic<bool>                                         controlStreamWanted { true };
+    std::atomic<bool>                                         controlStreamLive   { false };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NewProjectAudioProcessor)
 };
@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+    RenderProfile.h  –  Engine settings that trade CPU for quality, live
+                        and offline
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterOversampling.h"
+#include <array>
+
+//==============================================================================
+/** Engine settings that trade CPU for quality: the cheapest for playing
+    live, a costlier one for when the host renders offline.  The voices
+    prepare for both up front, so switching allocates nothing. */
+struct RenderProfile
+{
+    enum Index { realtime, offline, numProfiles };
+
+    FilterOversampling filterOversampling;
+    bool               everySampleModulation = false;   // else ModulationEngine::kControlRateHz
+};
+
+using RenderProfiles = std::array<RenderProfile, RenderProfile::numProfiles>;
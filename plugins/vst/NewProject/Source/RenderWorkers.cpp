@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+    RenderWorkers.cpp  –  RenderWorkers implementation
+  ==============================================================================
+*/
+
+#include "RenderWorkers.h"
+#include "../../Shared/RealtimeSafety.h"
+#include "../../Shared/TraceEvents.h"
+#include <thread>
+
+void RenderWorkers::start (int numThreads, int blockSize, double sampleRate)
+{
+    stop();
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        auto* worker = workers.add (new Worker (*this));
+        worker->startRealtimeThread (juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime (blockSize, sampleRate));
+    }
+}
+
+void RenderWorkers::stop()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto* worker : workers)
+    {
+        worker->wake.signal();
+        worker->stopThread (1000);
+    }
+
+    workers.clear();
+}
+
+void RenderWorkers::setWorkgroup (const juce::AudioWorkgroup& newWorkgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType sl (workgroupLock);
+        workgroup = newWorkgroup;
+    }
+
+    workgroupGeneration.fetch_add (1, std::memory_order_release);
+}
+
+void RenderWorkers::run (Job& job, int numTasks) noexcept
+{
+    currentJob.store (&job,     std::memory_order_relaxed);
+    tasksLeft .store (numTasks, std::memory_order_relaxed);
+    tickets   .store ((juce::uint64) numTasks << 32, std::memory_order_release);   // publishes the job
+    generation.fetch_add (1);
+
+    for (auto* worker : workers)
+        if (worker->sleeping.exchange (false))
+            worker->wake.signal();
+
+    runTasks();
+
+    for (int spins = 0; tasksLeft.load (std::memory_order_acquire) > 0; ++spins)
+        if (spins >= kSpinsBeforeYield)
+            std::this_thread::yield();
+}
+
+void RenderWorkers::Worker::run()
+{
+    TRACE_THREAD_NAME ("NewProject render worker");
+    auto seen = owner.generation.load();
+
+    // Left when this goes out of scope, on this thread as it must be
+    juce::WorkgroupToken token;
+    auto joined = owner.workgroupGeneration.load (std::memory_order_acquire) - 1;
+
+    while (! threadShouldExit())
+    {
+        for (int waits = 0; owner.generation.load() == seen && ! threadShouldExit(); ++waits)
+        {
+            if (waits < kSpinsBeforeYield)
+                continue;
+
+            if (waits < kSpinsBeforeYield + kYieldsBeforeSleep)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Re-checked after raising the flag, so a job published
+            // in between is never slept through
+            sleeping = true;
+
+            if (owner.generation.load() == seen && ! threadShouldExit())
+                wake.wait (-1);
+
+            sleeping = false;
+            waits    = 0;
+        }
+
+        seen = owner.generation.load();
+
+        // Only when the host's workgroup has changed, so this is
+        // outside the realtime check: joining is a system call
+        if (const auto current = owner.workgroupGeneration.load (std::memory_order_acquire); current != joined)
+        {
+            joined = current;
+            owner.joinWorkgroup (token);
+        }
+
+        REALTIME_SAFETY_AUDIO_THREAD ("NewProject render worker");
+        TRACE_SCOPE ("voice tasks");
+        owner.runTasks();
+    }
+}
+
+void RenderWorkers::joinWorkgroup (juce::WorkgroupToken& token) const
+{
+    token.reset();
+
+    juce::AudioWorkgroup current;
+
+    {
+        const juce::SpinLock::ScopedLockType sl (workgroupLock);
+        current = workgroup;
+    }
+
+    if (current)
+        current.join (token);
+}
+
+void RenderWorkers::runTasks() noexcept
+{
+    for (;;)
+    {
+        const auto ticket = tickets.fetch_add (1, std::memory_order_acquire);
+        const auto task   = (int) (ticket & 0xffffffffu);
+
+        if (task >= (int) (ticket >> 32))
+            return;
+
+        // A live ticket means its job can't have finished, so this is
+        // still that job
+        currentJob.load (std::memory_order_relaxed)->runTask (task);
+        tasksLeft.fetch_sub (1, std::memory_order_release);
+    }
+}
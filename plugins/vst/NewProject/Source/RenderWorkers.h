@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+    RenderWorkers.h  –  Realtime threads that help the audio thread
+                        through a job's tasks
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+//==============================================================================
+/** A few realtime-priority threads that help the audio thread through one
+    job at a time.
+
+    run() splits a job into tasks; the audio thread and the workers claim
+    them from one atomic counter, so nobody waits for a particular thread,
+    and the audio thread then waits for the last one on a lock-free
+    counter, spinning briefly and then yielding.  Workers that found
+    nothing to do for a while sleep on their own event, which run() only
+    signals (briefly taking its lock) when they really are asleep.
+
+    Where the host gives the audio thread a workgroup (see
+    setWorkgroup()), each worker joins it before its next tasks, and
+    leaves and joins again whenever it changes, so the OS schedules the
+    workers against the same deadline as the thread waiting on them. */
+class RenderWorkers
+{
+public:
+    /** One job, split into tasks that may run on any thread at once. */
+    struct Job
+    {
+        virtual ~Job() = default;
+        virtual void runTask (int taskIndex) = 0;
+    };
+
+    ~RenderWorkers() { stop(); }
+
+    /** Starts numThreads workers (none if 0), expecting blocks of about
+        blockSize samples.  Not while run() may be called. */
+    void start (int numThreads, int blockSize, double sampleRate);
+
+    void stop();
+
+    int getNumThreads() const noexcept { return workers.size(); }
+
+    /** The workgroup the workers should be in: the host's audio thread's,
+        or a default-constructed one for none.  Any thread, including the
+        audio thread (it copies the workgroup, which may allocate, but only
+        when the host's changes); kept across start() and stop(). */
+    void setWorkgroup (const juce::AudioWorkgroup& newWorkgroup);
+
+    /** Runs tasks 0 … numTasks - 1 of `job` and returns once all are done.
+        Audio thread. */
+    void run (Job& job, int numTasks) noexcept;
+
+private:
+    static constexpr int kSpinsBeforeYield = 1000;
+    static constexpr int kYieldsBeforeSleep = 2000;
+
+    class Worker : public juce::Thread
+    {
+    public:
+        explicit Worker (RenderWorkers& ownerToUse) : juce::Thread ("Voice render"), owner (ownerToUse) {}
+
+        void run() override;
+
+        std::atomic<bool>   sleeping { false };
+        juce::WaitableEvent wake;
+
+    private:
+        RenderWorkers& owner;
+    };
+
+    /** Leaves whichever workgroup token is in and joins the current one, if
+        there is one.  A worker past the most threads the workgroup takes
+        is turned away and runs outside it, as before.  The calling worker. */
+    void joinWorkgroup (juce::WorkgroupToken& token) const;
+
+    /** Claims tasks until none are left.  A ticket carries its job's task
+        count, so one drawn late, from a job that has already finished, is
+        recognised as spent whatever run() has published since. */
+    void runTasks() noexcept;
+
+    juce::OwnedArray<Worker>  workers;
+    std::atomic<Job*>         currentJob { nullptr };
+    std::atomic<juce::uint64> tickets    { 0 };   // task count << 32 | next task
+    std::atomic<int>          tasksLeft  { 0 };
+    std::atomic<juce::uint32> generation { 0 };   // bumped per job, to wake workers
+
+    mutable juce::SpinLock    workgroupLock;
+    juce::AudioWorkgroup      workgroup;                    // guarded by workgroupLock
+    std::atomic<juce::uint32> workgroupGeneration { 0 };    // bumped per setWorkgroup()
+};
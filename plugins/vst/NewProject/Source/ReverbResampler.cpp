@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+    ReverbResampler.cpp  –  ReverbResampler implementation
+  ==============================================================================
+*/
+
+#include "ReverbResampler.h"
+
+void ReverbResampler::prepare (int newFactorLog2, int maximumBlockSize)
+{
+    factorLog2 = juce::jlimit (0, kMaxFactorLog2, newFactorLog2);
+
+    if (directCoefficients.empty())
+    {
+        const auto structure = juce::dsp::FilterDesign<float>::designIIRLowpassHalfBandPolyphaseAllpassMethod (kTransitionWidth, kStopbandDb);
+
+        // Each section is (a + z^-2) / (1 + a z^-2); the delayed path
+        // starts with its z^-1
+        for (int i = 0; i < structure.directPath.size(); ++i)
+            directCoefficients.push_back (structure.directPath.getObjectPointer (i)->coefficients[0]);
+
+        for (int i = 1; i < structure.delayedPath.size(); ++i)
+            delayedCoefficients.push_back (structure.delayedPath.getObjectPointer (i)->coefficients[0]);
+    }
+
+    for (auto* stages : { &downStages, &upStages })
+        for (auto& channels : *stages)
+            for (auto& halfBand : channels)
+            {
+                halfBand.directState .assign (directCoefficients.size(),  0.0f);
+                halfBand.delayedState.assign (delayedCoefficients.size(), 0.0f);
+            }
+
+    intermediate.setSize (2, juce::jmax (1, maximumBlockSize / 2));
+    reset();
+}
+
+void ReverbResampler::down (const float* const* input, float* const* output, int numSamples) noexcept
+{
+    jassert (numSamples % getFactor() == 0);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float* source = input[ch];
+        auto         n      = numSamples;
+
+        for (int stage = 0; stage < factorLog2; ++stage)
+        {
+            n /= 2;
+            auto* destination = stage == factorLog2 - 1 ? output[ch] : intermediate.getWritePointer (ch);
+            downStages[(size_t) stage][(size_t) ch].decimate (source, destination, n, directCoefficients, delayedCoefficients);
+            source = destination;
+        }
+    }
+}
+
+void ReverbResampler::up (const float* const* input, float* const* output, int numSamples) noexcept
+{
+    jassert (numSamples % getFactor() == 0);
+
+    for (int ch = 0; ch < 2; ++ch)
+    {
+        const float* source = input[ch];
+        auto         n      = numSamples >> factorLog2;
+
+        for (int stage = factorLog2 - 1; stage >= 0; --stage)
+        {
+            auto* destination = stage == 0 ? output[ch] : intermediate.getWritePointer (ch);
+            upStages[(size_t) stage][(size_t) ch].interpolate (source, destination, n, directCoefficients, delayedCoefficients);
+            source = destination;
+            n *= 2;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+    ReverbResampler.h  –  The reverb's send down to a half or a quarter of
+                          the rate, and its wet signal back up
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+//==============================================================================
+/** Takes the reverb's stereo send down to a half or a quarter of the rate
+    and its wet signal back up, through one or two 2x polyphase IIR
+    half-bands each way.
+
+    Each half-band is juce::dsp::FilterDesign's two paths of first-order
+    allpasses at the lower rate, so the filter costs a few multiplies per
+    low-rate sample and nothing is computed for the samples decimation
+    drops or interpolation's zeros.  Its transition band is wide (past
+    0.4 of the lower rate) because nothing a reverb tail needs lives
+    there, and its group delay, a few samples, only adds to the wet
+    signal's pre-delay. */
+class ReverbResampler
+{
+public:
+    static constexpr int   kMaxFactorLog2    = 2;
+    static constexpr float kTransitionWidth  = 0.1f;     // of the higher rate
+    static constexpr float kStopbandDb       = -70.0f;
+
+    /** For 2^factorLog2, taking blocks of up to maximumBlockSize at the
+        full rate.  Not realtime-safe. */
+    void prepare (int newFactorLog2, int maximumBlockSize);
+
+    void reset() noexcept
+    {
+        for (auto* stages : { &downStages, &upStages })
+            for (auto& channels : *stages)
+                for (auto& halfBand : channels)
+                    halfBand.reset();
+    }
+
+    int getFactorLog2() const noexcept { return factorLog2; }
+    int getFactor() const noexcept     { return 1 << factorLog2; }
+
+    /** numSamples at the full rate, a multiple of getFactor(), into
+        numSamples / getFactor() at the lower one. */
+    void down (const float* const* input, float* const* output, int numSamples) noexcept;
+
+    /** numSamples / getFactor() at the lower rate into numSamples at the
+        full one. */
+    void up (const float* const* input, float* const* output, int numSamples) noexcept;
+
+private:
+    /** One channel's 2x half-band, either way. */
+    struct HalfBand
+    {
+        void reset() noexcept
+        {
+            std::fill (directState.begin(),  directState.end(),  0.0f);
+            std::fill (delayedState.begin(), delayedState.end(), 0.0f);
+            heldOdd = 0.0f;
+        }
+
+        static float allpasses (const std::vector<float>& coefficients, std::vector<float>& state, float input) noexcept
+        {
+            for (size_t k = 0; k < coefficients.size(); ++k)
+            {
+                const auto output = coefficients[k] * input + state[k];
+                state[k] = input - coefficients[k] * output;
+                input    = output;
+            }
+
+            return input;
+        }
+
+        /** Even samples through the direct path, the odd ones a sample
+            late through the delayed path, averaged. */
+        void decimate (const float* input, float* output, int numOutput,
+                       const std::vector<float>& direct, const std::vector<float>& delayed) noexcept
+        {
+            for (int i = 0; i < numOutput; ++i)
+            {
+                const auto even = allpasses (direct,  directState,  input[2 * i]);
+                const auto odd  = allpasses (delayed, delayedState, heldOdd);
+                output[i] = 0.5f * (even + odd);
+                heldOdd   = input[2 * i + 1];
+            }
+        }
+
+        /** Every sample through both paths, the direct one giving the even
+            outputs and the delayed one the odd. */
+        void interpolate (const float* input, float* output, int numInput,
+                          const std::vector<float>& direct, const std::vector<float>& delayed) noexcept
+        {
+            for (int i = 0; i < numInput; ++i)
+            {
+                const auto x = input[i];
+                output[2 * i]     = allpasses (direct,  directState,  x);
+                output[2 * i + 1] = allpasses (delayed, delayedState, x);
+            }
+        }
+
+        std::vector<float> directState, delayedState;
+        float              heldOdd = 0.0f;
+    };
+
+    using Stages = std::array<std::array<HalfBand, 2>, (size_t) kMaxFactorLog2>;
+
+    std::vector<float>       directCoefficients, delayedCoefficients;
+    Stages                   downStages, upStages;
+    juce::AudioBuffer<float> intermediate;   // between the two stages of a quarter
+    int                      factorLog2 = 0;
+};
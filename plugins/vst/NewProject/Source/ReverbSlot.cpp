@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+    ReverbSlot.cpp  –  ReverbSlot implementation
+  ==============================================================================
+*/
+
+#include "ReverbSlot.h"
+
+void ReverbSlot::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    const auto factorLog2 = getFactorLog2For (spec.sampleRate);
+    const auto engineRate = spec.sampleRate / (1 << factorLog2);
+
+    resampler.prepare (factorLog2, (int) spec.maximumBlockSize);
+    fdn.prepare (engineRate);
+    convolution.prepare ({ engineRate, (juce::uint32) juce::jmax (1, (int) spec.maximumBlockSize >> factorLog2), spec.numChannels });
+    scratch.setSize (kNumScratchChannels, (int) spec.maximumBlockSize);
+
+    for (auto* level : { &dryLevel, &wetDirect, &wetCrossed })
+        level->reset (spec.sampleRate, 0.01);
+
+    fadeLength = juce::jmax (1, (int) (0.05 * engineRate));
+    reset();
+}
+
+void ReverbSlot::reset() noexcept
+{
+    fdn.reset();
+    convolution.reset();
+    resampler.reset();
+    fadeRemaining = 0;
+
+    for (auto* level : { &dryLevel, &wetDirect, &wetCrossed })
+        level->setCurrentAndTargetValue (level->getTargetValue());
+}
+
+void ReverbSlot::setParameters (const juce::Reverb::Parameters& parameters) noexcept
+{
+    fdn.setRoom (parameters.roomSize, parameters.damping);
+    dryLevel  .setTargetValue (parameters.dryLevel);
+    wetDirect .setTargetValue (0.5f * parameters.wetLevel * (1.0f + parameters.width));
+    wetCrossed.setTargetValue (0.5f * parameters.wetLevel * (1.0f - parameters.width));
+}
+
+void ReverbSlot::setEngine (Engine newEngine) noexcept
+{
+    if (newEngine == engine)
+        return;
+
+    previousEngine = engine;
+    engine         = newEngine;
+    fadeRemaining  = fadeLength;
+}
+
+void ReverbSlot::render (Engine which, const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept
+{
+    if (which == convolutionEngine)
+        convolution.process (inLeft, inRight, outLeft, outRight, numSamples);
+    else
+        fdn.process (inLeft, inRight, outLeft, outRight, numSamples);
+}
+
+void ReverbSlot::resetEngine (Engine which) noexcept
+{
+    if (which == convolutionEngine)
+        convolution.reset();
+    else
+        fdn.reset();
+}
+
+int ReverbSlot::getFactorLog2For (double sampleRate) const noexcept
+{
+    auto factorLog2 = requestedFactorLog2;
+
+    while (factorLog2 > 0 && sampleRate / (1 << factorLog2) < kMinEngineRate)
+        --factorLog2;
+
+    return factorLog2;
+}
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+    ReverbSlot.h  –  fxChain's reverb, switching between the FDN and
+                     the convolution engine
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "ConvolutionReverb.h"
+#include "FDNReverb.h"
+#include "ReverbResampler.h"
+
+//==============================================================================
+/** fxChain's reverb: the FDN or the convolution engine, with the dry/wet
+    mix and width of the juce::Reverb it replaces (levels taken as they
+    are, without its x3 and x2 scaling).  Switching engines crossfades
+    over 50 ms, both running meanwhile.
+
+    Optionally the engines run at a half or a quarter of the rate, the send
+    and the wet signal going through a ReverbResampler, so a 96 or 192 kHz
+    session doesn't pay for a tail above anything it needs.  The engines'
+    rate never goes below kMinEngineRate; the dry signal and the mix stay
+    at the full rate. */
+class ReverbSlot
+{
+public:
+    enum Engine { fdnEngine, convolutionEngine, numEngines };
+
+    static constexpr double kMinEngineRate = 44100.0;
+
+    /** Asks for the engines at 1 / 2^factorLog2 of the rate from the next
+        prepare(), as far as kMinEngineRate allows. */
+    void setRateReduction (int factorLog2) noexcept
+    {
+        requestedFactorLog2 = juce::jlimit (0, ReverbResampler::kMaxFactorLog2, factorLog2);
+    }
+
+    /** The rate the engines will run at for a host's sampleRate. */
+    double getEngineSampleRate (double sampleRate) const noexcept
+    {
+        return sampleRate / (1 << getFactorLog2For (sampleRate));
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Room size and damping are the FDN's; the convolution engine's room
+        is rebuilt from them by the processor. */
+    void setParameters (const juce::Reverb::Parameters& parameters) noexcept;
+
+    void setEngine (Engine newEngine) noexcept;
+
+    Engine getEngine() const noexcept { return engine; }
+
+    ConvolutionReverb&       getConvolution() noexcept       { return convolution; }
+    const ConvolutionReverb& getConvolution() const noexcept { return convolution; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock  = context.getInputBlock();
+        auto&       outputBlock = context.getOutputBlock();
+        const auto  numSamples  = (int) outputBlock.getNumSamples();
+        const auto  stereo      = outputBlock.getNumChannels() > 1;
+
+        const auto* inLeft  = inputBlock.getChannelPointer (0);
+        const auto* inRight = inputBlock.getNumChannels() > 1 ? inputBlock.getChannelPointer (1) : inLeft;
+        auto* wetLeft  = scratch.getWritePointer (0);
+        auto* wetRight = scratch.getWritePointer (1);
+
+        // The engines' send and wet signal, at their own rate
+        const float* send[] { inLeft, inRight };
+        float*       wet[]  { wetLeft, wetRight };
+        const auto   engineSamples = numSamples >> resampler.getFactorLog2();
+
+        if (resampler.getFactorLog2() > 0)
+        {
+            float* reducedSend[] { scratch.getWritePointer (4), scratch.getWritePointer (5) };
+            resampler.down (send, reducedSend, numSamples);
+
+            send[0] = reducedSend[0];
+            send[1] = reducedSend[1];
+            wet[0]  = scratch.getWritePointer (6);
+            wet[1]  = scratch.getWritePointer (7);
+        }
+
+        render (engine, send[0], send[1], wet[0], wet[1], engineSamples);
+
+        if (fadeRemaining > 0)
+        {
+            auto* fadeLeft  = scratch.getWritePointer (2);
+            auto* fadeRight = scratch.getWritePointer (3);
+
+            render (previousEngine, send[0], send[1], fadeLeft, fadeRight, engineSamples);
+
+            for (int i = 0; i < engineSamples; ++i)
+            {
+                const auto outgoing = (float) juce::jmax (0, fadeRemaining - i) / (float) fadeLength;
+                wet[0][i] += outgoing * (fadeLeft[i]  - wet[0][i]);
+                wet[1][i] += outgoing * (fadeRight[i] - wet[1][i]);
+            }
+
+            fadeRemaining = juce::jmax (0, fadeRemaining - engineSamples);
+
+            if (fadeRemaining == 0)
+                resetEngine (previousEngine);
+        }
+
+        if (resampler.getFactorLog2() > 0)
+        {
+            float* fullRateWet[] { wetLeft, wetRight };
+            resampler.up (wet, fullRateWet, numSamples);
+        }
+
+        auto* outLeft  = outputBlock.getChannelPointer (0);
+        auto* outRight = stereo ? outputBlock.getChannelPointer (1) : nullptr;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto dry     = dryLevel  .getNextValue();
+            const auto direct  = wetDirect .getNextValue();
+            const auto crossed = wetCrossed.getNextValue();
+            const auto left    = inLeft[i];
+            const auto right   = inRight[i];
+
+            outLeft[i] = left * dry + wetLeft[i] * direct + wetRight[i] * crossed;
+
+            if (stereo)
+                outRight[i] = right * dry + wetRight[i] * direct + wetLeft[i] * crossed;
+        }
+    }
+
+private:
+    void render (Engine which, const float* inLeft, const float* inRight, float* outLeft, float* outRight, int numSamples) noexcept;
+    void resetEngine (Engine which) noexcept;
+    int getFactorLog2For (double sampleRate) const noexcept;
+
+    static constexpr int kNumScratchChannels = 8;
+
+    FDNReverb         fdn;
+    ConvolutionReverb convolution;
+    ReverbResampler   resampler;
+
+    Engine engine              = fdnEngine;
+    Engine previousEngine      = fdnEngine;
+    int    requestedFactorLog2 = 0;
+    int    fadeLength          = 1;   // at the engines' rate, as is the rest
+    int    fadeRemaining       = 0;   // samples left of the switch's crossfade
+
+    // Full-rate wet left/right; the outgoing engine's; and at a reduced
+    // rate, the send and the wet signal
+    juce::AudioBuffer<float> scratch;
+    juce::SmoothedValue<float> dryLevel, wetDirect, wetCrossed;
+};
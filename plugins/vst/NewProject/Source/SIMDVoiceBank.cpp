@@ -0,0 +1,887 @@
+/*
+  ==============================================================================
+    SIMDVoiceBank.cpp  –  SIMDVoiceBank implementation
+  ==============================================================================
+*/
+
+#include "SIMDVoiceBank.h"
+#include "../../Shared/VectorKernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if JUCE_USE_SIMD
+
+void SIMDVoiceBank::allocate (DspArena& arena, int maximumBlockSize, double newSampleRate) noexcept
+{
+    noteCache.allocate (arena, newSampleRate);
+
+    const auto blockSize = (size_t) maximumBlockSize;
+
+    for (auto& s : scratch)
+    {
+        s.envelope      = arena.allocate<Lanes> (blockSize);
+        s.mixLeft       = arena.allocate<Lanes> (blockSize);
+        s.mixRight      = arena.allocate<Lanes> (blockSize);
+        s.mixCentre     = arena.allocate<Lanes> (blockSize);
+        s.signal        = arena.allocate<Lanes> (blockSize);
+        s.signalRight   = arena.allocate<Lanes> (blockSize);
+        s.envelopeGains = arena.allocate<float> (blockSize);
+
+        for (auto& channel : s.laneChannels)
+            channel = arena.allocate<float> (blockSize);
+    }
+
+    mixed = arena.allocate<float> (blockSize);
+}
+
+void SIMDVoiceBank::prepare (const juce::dsp::ProcessSpec& spec, int numVoices, const RenderProfiles& profiles)
+{
+    sampleRate = spec.sampleRate;
+    voices.resize ((size_t) numVoices);
+    groups.resize ((size_t) ((numVoices + kLanes - 1) / kLanes));
+
+    activeGroups.clear();
+    activeGroups.reserve (groups.size());
+
+    const auto zero = Lanes::expand (0.0f);
+
+    unison = parameters.unison;
+
+    for (auto& group : groups)
+    {
+        for (size_t u = 0; u < (size_t) UnisonLayout::kMaxVoices; ++u)
+        {
+            group.phases[u] = Lanes::expand (unison.startPhases[u]);
+            group.increments[u] = group.inverseIncrements[u] = zero;
+        }
+
+        group.tableLanes = 0;
+        group.frequency = zero;
+        group.level = zero;
+        group.panLeft = group.panRight = Lanes::expand (1.0f);
+        group.cutoffExponent = group.cutoffRatio = Lanes::expand (1.0f);
+
+        for (auto& filter : group.filters)
+            filter.reset();
+        group.pitch     .prepare (sampleRate / NoteExpression::kControlSamples);
+        group.brightness.prepare (sampleRate / NoteExpression::kControlSamples);
+        group.pitch     .reset (0.0f);
+        group.brightness.reset (0.0f);
+
+        for (size_t i = 0; i < profiles.size(); ++i)
+            group.oversamplers[i] = profiles[i].filterOversampling.create ((size_t) (2 * kLanes), blockSize);
+
+        group.oversampling = group.oversamplers[(size_t) parameters.renderProfile].get();
+    }
+
+    for (auto& voice : voices)
+    {
+        voice.adsr.setSampleRate (sampleRate);
+        voice.adsr.reset();
+        voice.expression.prepare (sampleRate);
+        voice.cacheUse = CacheUse::none;
+    }
+
+    noteCache.clear();
+    cacheUsable = false;
+
+    samplesToControlStep = 0;
+
+    for (int i = 0; i < getNumVoices(); ++i)
+        setPan (i, voices[(size_t) i].pan);
+
+    appliedVersion = ~0u;
+}
+
+void SIMDVoiceBank::startNote (int voiceIndex, int midiNoteNumber, float velocity, int pitchWheelPosition)
+{
+    auto& group = groups[(size_t) (voiceIndex / kLanes)];
+    auto& voice = voices[(size_t) voiceIndex];
+    const auto lane = (size_t) (voiceIndex % kLanes);
+
+    // Parameters first, so the note is tuned into the current wavetable
+    applyParameters();
+
+    voice.noteHz = (float) juce::MidiMessage::getMidiNoteInHertz (midiNoteNumber);
+    voice.expression.noteStarted (pitchWheelPosition, masterPitchWheel);
+    group.pitch     .resetLane (lane, voice.expression.getTargetSemitones());
+    group.brightness.resetLane (lane, voice.expression.getTargetBrightness());
+    retune (group, lane, voice.noteHz * voice.expression.getFrequencyRatio(), voice.expression.getCutoffExponent());
+
+    for (size_t u = 0; u < (size_t) UnisonLayout::kMaxVoices; ++u)
+        group.phases[u].set (lane, unison.startPhases[u]);
+
+    group.cutoffRatio.set (lane, 1.0f);   // timbre starts centred
+
+    for (auto& filter : group.filters)
+        filter.resetLane (lane);
+
+    // A stolen voice gives up what it was recording
+    stopCaching (voice);
+
+    if (cacheUsable && cacheVersion == parameters.version && isAtRest (voice))
+    {
+        const auto bucket = NoteCache::bucketFor (velocity);
+        velocity = NoteCache::velocityFor (bucket);
+
+        if (const auto e = noteCache.find (midiNoteNumber, bucket); e >= 0)
+        {
+            if (noteCache.isComplete (e))
+                startCaching (voice, CacheUse::streaming, e);
+        }
+        else if (const auto claimed = noteCache.claim (midiNoteNumber, bucket, unison.stereo ? 2 : 1,
+                                                       [this] (int entry) { return isCacheEntryInUse (entry); });
+                 claimed >= 0)
+        {
+            startCaching (voice, CacheUse::recording, claimed);
+        }
+    }
+
+    group.level.set (lane, velocity);
+    voice.adsr.noteOn();
+}
+
+void SIMDVoiceBank::stopNote (int voiceIndex, bool allowTailOff)
+{
+    auto& adsr = voices[(size_t) voiceIndex].adsr;
+
+    if (allowTailOff)
+        adsr.noteOff();
+    else
+        adsr.reset();
+}
+
+void SIMDVoiceBank::setPan (int voiceIndex, float newPan) noexcept
+{
+    auto& voice = voices[(size_t) voiceIndex];
+    voice.pan = juce::jlimit (-1.0f, 1.0f, newPan);
+
+    auto& group = groups[(size_t) (voiceIndex / kLanes)];
+    const auto lane = (size_t) (voiceIndex % kLanes);
+    group.panLeft .set (lane, juce::jmin (1.0f, 1.0f - voice.pan));
+    group.panRight.set (lane, juce::jmin (1.0f, 1.0f + voice.pan));
+}
+
+void SIMDVoiceBank::render (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples,
+                            RenderWorkers* workers)
+{
+    applyParameters();
+    syncNoteCache (startSample, numSamples);
+
+    activeGroups.clear();
+    for (int g = 0; g < (int) groups.size(); ++g)
+        if (isGroupActive (g))
+            activeGroups.push_back (g);
+
+    blockStart   = startSample;
+    blockSamples = numSamples;
+    firstStep    = samplesToControlStep;
+
+    const auto numTasks = workers == nullptr ? 1
+                        : juce::jlimit (1, juce::jmin (kMaxTasks, workers->getNumThreads() + 1),
+                                        (int) activeGroups.size() / kMinGroupsPerTask);
+
+    if (numTasks > 1)
+    {
+        taskCount = numTasks;
+        workers->run (*this, numTasks);
+    }
+    else
+    {
+        taskCount = 1;
+        runTask (0);
+    }
+
+    // Every group stepped at the same positions; carry on from the last
+    auto nextStep = firstStep;
+    while (nextStep < numSamples)
+        nextStep += NoteExpression::kControlSamples;
+
+    samplesToControlStep = nextStep - numSamples;
+
+    for (int t = 1; t < numTasks; ++t)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            scratch[0].mixLeft[(size_t) i]   = scratch[0].mixLeft[(size_t) i]   + scratch[(size_t) t].mixLeft[(size_t) i];
+            scratch[0].mixRight[(size_t) i]  = scratch[0].mixRight[(size_t) i]  + scratch[(size_t) t].mixRight[(size_t) i];
+            scratch[0].mixCentre[(size_t) i] = scratch[0].mixCentre[(size_t) i] + scratch[(size_t) t].mixCentre[(size_t) i];
+        }
+    }
+
+    // One horizontal add per sample and channel, for all groups at once
+    const int numChannels = outputBuffer.getNumChannels();
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto& lanes = numChannels < 2 || ch >= 2 ? scratch[0].mixCentre
+                          : ch == 0                    ? scratch[0].mixLeft
+                                                       : scratch[0].mixRight;
+
+        for (int i = 0; i < numSamples; ++i)
+            mixed[(size_t) i] = lanes[(size_t) i].sum();
+
+        VectorKernels::get().add (outputBuffer.getWritePointer (ch, startSample), mixed, numSamples);
+    }
+}
+
+void SIMDVoiceBank::runTask (int taskIndex)
+{
+    auto& s = scratch[(size_t) taskIndex];
+    const auto numSamples = blockSamples;
+    const auto zero       = Lanes::expand (0.0f);
+
+    std::fill_n (s.mixLeft,   numSamples, zero);
+    std::fill_n (s.mixRight,  numSamples, zero);
+    std::fill_n (s.mixCentre, numSamples, zero);
+
+    const auto numActive = (int) activeGroups.size();
+    const auto end       = numActive * (taskIndex + 1) / taskCount;
+
+    for (int a = numActive * taskIndex / taskCount; a < end; ++a)
+    {
+        const auto g        = activeGroups[(size_t) a];
+        const auto sounding = renderEnvelopes (g, numSamples, s);
+        renderGroup (g, s, numSamples, sounding);
+    }
+}
+
+bool SIMDVoiceBank::isGroupActive (int g) const noexcept
+{
+    const auto first = g * kLanes;
+    const auto last  = juce::jmin (first + kLanes, getNumVoices());
+
+    for (int i = first; i < last; ++i)
+        if (voices[(size_t) i].adsr.isActive())
+            return true;
+
+    return false;
+}
+
+juce::uint32 SIMDVoiceBank::renderEnvelopes (int g, int numSamples, Scratch& s)
+{
+    const auto first = g * kLanes;
+    const auto last  = juce::jmin (first + kLanes, getNumVoices());
+
+    auto* envelope      = s.envelope;
+    auto* envelopeGains = s.envelopeGains;
+    std::fill_n (envelope, numSamples, Lanes::expand (0.0f));
+
+    juce::uint32 sounding = 0;
+
+    for (int i = first; i < last; ++i)
+    {
+        auto& adsr = voices[(size_t) i].adsr;
+
+        if (! adsr.isActive())
+            continue;
+
+        adsr.render (envelopeGains, numSamples);
+        sounding |= 1u << (i - first);
+
+        for (int n = 0; n < numSamples; ++n)
+            envelope[(size_t) n].set ((size_t) (i - first), envelopeGains[(size_t) n] * masterGain);
+    }
+
+    return sounding;
+}
+
+void SIMDVoiceBank::renderGroup (int g, Scratch& s, int numSamples, juce::uint32 sounding) noexcept
+{
+    auto&       group  = groups[(size_t) g];
+    const auto  factor = modulation.getOversamplingFactor();
+    const auto* cutoff = modulation.getCutoffCoefficients() + blockStart * factor;
+
+    for (int pos = 0, nextStep = firstStep; pos < numSamples;)
+    {
+        if (pos == nextStep)
+        {
+            stepExpression (g);
+            nextStep += NoteExpression::kControlSamples;
+        }
+
+        auto       run    = juce::jmin (numSamples, nextStep) - pos;
+        const auto cached = updateCachedLanes (g, sounding, run);
+
+        if (cached.streaming)
+            streamCachedLanes (g, s, pos, run);
+
+        if (cached.live)
+            renderRun (group, s, pos, run, cutoff + pos * factor, run * factor, cached.recording);
+
+        if (cached.recording)
+            recordCachedLanes (g, s, pos, run);
+
+        pos += run;
+    }
+}
+
+void SIMDVoiceBank::stepExpression (int g) noexcept
+{
+    const auto first = g * kLanes;
+    const auto last  = juce::jmin (first + kLanes, getNumVoices());
+    auto&      group = groups[(size_t) g];
+
+    // The voices only keep targets; the group's smoothers step every
+    // lane at once, and just the exp2s are left per lane
+    auto pitchTargets      = Lanes::expand (0.0f);
+    auto brightnessTargets = Lanes::expand (0.0f);
+
+    for (int i = first; i < last; ++i)
+    {
+        auto& expression = voices[(size_t) i].expression;
+        const auto lane  = (size_t) (i - first);
+
+        expression.setMasterPitchWheel (masterPitchWheel);
+        pitchTargets     .set (lane, expression.getTargetSemitones());
+        brightnessTargets.set (lane, expression.getTargetBrightness());
+    }
+
+    const auto semitones  = group.pitch     .step (pitchTargets);
+    const auto brightness = group.brightness.step (brightnessTargets);
+
+    for (int i = first; i < last; ++i)
+    {
+        const auto lane = (size_t) (i - first);
+
+        retune (group, lane, voices[(size_t) i].noteHz * NoteExpression::frequencyRatioFor (semitones.get (lane)),
+                NoteExpression::cutoffExponentFor (brightness.get (lane)));
+    }
+}
+
+void SIMDVoiceBank::retune (Group& group, size_t lane, float hz, float cutoffExponent) noexcept
+{
+    for (size_t u = 0; u < (size_t) unison.numVoices; ++u)
+    {
+        const auto increment = juce::jmin (hz * unison.ratios[u] / (float) sampleRate, 0.5f);
+        group.increments[u].set (lane, increment);
+        group.inverseIncrements[u].set (lane, 1.0f / increment);
+
+        if (wavetable != nullptr)
+            group.waves[u][lane] = wavetable->cursorFor (increment, wavetablePosition);
+    }
+
+    if (wavetable != nullptr)
+        group.tableLanes |= 1u << lane;
+    else
+        group.tableLanes &= ~(1u << lane);
+
+    group.frequency.set (lane, hz);
+    group.cutoffExponent.set (lane, cutoffExponent);
+}
+
+template <bool spread, bool record>
+void SIMDVoiceBank::renderRunFused (Group& group, Scratch& s, int pos, int run,
+                                    const float* cutoff, Lanes ratio, Lanes ratioStep) noexcept
+{
+    const auto one     = Lanes::expand (1.0f);
+    const auto zero    = Lanes::expand (0.0f);
+    const auto numOscs = (size_t) unison.numVoices;
+
+    std::array<Lanes, UnisonLayout::kMaxVoices> gainsLeft, gainsRight;
+
+    for (size_t u = 0; u < numOscs; ++u)
+    {
+        gainsLeft[u]  = group.level * (spread ? unison.gainsLeft[u] : unison.gainsCentre[u]);
+        gainsRight[u] = group.level * unison.gainsRight[u];
+    }
+
+    auto filterLeft  = group.filters[0];
+    auto filterRight = group.filters[1];
+
+    for (int n = 0; n < run; ++n)
+    {
+        auto left = zero, right = zero;
+
+        for (size_t u = 0; u < numOscs; ++u)
+        {
+            auto& phase = group.phases[u];
+            phase = phase + group.increments[u];
+            phase = phase - (one & Lanes::greaterThanOrEqual (phase, one));
+
+            const auto x = oscillate (group, u, phase);
+            left = left + x * gainsLeft[u];
+
+            if constexpr (spread)
+                right = right + x * gainsRight[u];
+        }
+
+        ratio = ratio + ratioStep;
+        const auto coefficient = Lanes::expand (cutoff[n]) * ratio;
+        const auto i           = (size_t) (pos + n);
+
+        const auto filteredL = filterLeft.processSample (left, coefficient);
+        const auto outL      = filteredL * s.envelope[i];
+
+        if constexpr (record)
+            s.signal[i] = filteredL;
+
+        if constexpr (spread)
+        {
+            const auto filteredR = filterRight.processSample (right, coefficient);
+            const auto outR      = filteredR * s.envelope[i];
+
+            if constexpr (record)
+                s.signalRight[i] = filteredR;
+
+            s.mixLeft[i]   = s.mixLeft[i]   + outL * group.panLeft;
+            s.mixRight[i]  = s.mixRight[i]  + outR * group.panRight;
+            s.mixCentre[i] = s.mixCentre[i] + (outL + outR) * 0.5f;
+        }
+        else
+        {
+            s.mixLeft[i]   = s.mixLeft[i]   + outL * group.panLeft;
+            s.mixRight[i]  = s.mixRight[i]  + outL * group.panRight;
+            s.mixCentre[i] = s.mixCentre[i] + outL;
+        }
+    }
+
+    group.filters[0] = filterLeft;
+
+    if constexpr (spread)
+        group.filters[1] = filterRight;
+}
+
+void SIMDVoiceBank::renderRun (Group& group, Scratch& s, int pos, int run,
+                               const float* cutoff, int numFilterSamples, bool record) noexcept
+{
+    const auto one = Lanes::expand (1.0f);
+
+    // As DSPVoice: the timbre's correction to the shared cutoff curve,
+    // ramped to its value at the end of the run
+    const auto endCoefficient = cutoff[numFilterSamples - 1];
+    auto       endRatio       = one;
+
+    for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+        if (const auto exponent = group.cutoffExponent.get (lane); exponent != 1.0f)
+            endRatio.set (lane, std::pow (endCoefficient, exponent - 1.0f));
+
+    const auto ratio     = group.cutoffRatio;
+    const auto ratioStep = (endRatio - ratio) * (1.0f / (float) numFilterSamples);
+    group.cutoffRatio    = endRatio;
+
+    if (group.oversampling == nullptr)
+    {
+        if (record)
+        {
+            if (unison.stereo)
+                renderRunFused<true,  true>  (group, s, pos, run, cutoff, ratio, ratioStep);
+            else
+                renderRunFused<false, true>  (group, s, pos, run, cutoff, ratio, ratioStep);
+        }
+        else
+        {
+            if (unison.stereo)
+                renderRunFused<true,  false> (group, s, pos, run, cutoff, ratio, ratioStep);
+            else
+                renderRunFused<false, false> (group, s, pos, run, cutoff, ratio, ratioStep);
+        }
+
+        return;
+    }
+
+    jassert (! record);   // the cache is only used at the base rate
+
+    auto* const signal = s.signal + pos;
+    auto* const right  = unison.stereo ? s.signalRight + pos : nullptr;
+
+    std::fill_n (signal, run, Lanes::expand (0.0f));
+
+    if (right != nullptr)
+        std::fill_n (right, run, Lanes::expand (0.0f));
+
+    // Oscillators: advance, then render, as BandLimitedOscillator, one
+    // of the stack at a time through the run
+    for (size_t u = 0; u < (size_t) unison.numVoices; ++u)
+    {
+        auto       phase     = group.phases[u];
+        const auto increment = group.increments[u];
+
+        if (right == nullptr)
+        {
+            const auto gain = group.level * unison.gainsCentre[u];
+
+            for (int n = 0; n < run; ++n)
+            {
+                phase = phase + increment;
+                phase = phase - (one & Lanes::greaterThanOrEqual (phase, one));
+                signal[n] = signal[n] + oscillate (group, u, phase) * gain;
+            }
+        }
+        else
+        {
+            const auto gainLeft  = group.level * unison.gainsLeft[u];
+            const auto gainRight = group.level * unison.gainsRight[u];
+
+            for (int n = 0; n < run; ++n)
+            {
+                phase = phase + increment;
+                phase = phase - (one & Lanes::greaterThanOrEqual (phase, one));
+
+                const auto x = oscillate (group, u, phase);
+                signal[n] = signal[n] + x * gainLeft;
+                right[n]  = right[n]  + x * gainRight;
+            }
+        }
+
+        group.phases[u] = phase;
+    }
+
+    Lanes* const sides[] { signal, right };
+    filterOversampled (group, s, sides, right != nullptr ? 2 : 1, run, cutoff, ratio, ratioStep);
+
+    for (int n = 0; n < run; ++n)
+    {
+        const auto i    = (size_t) (pos + n);
+        const auto outL = signal[n] * s.envelope[i];
+        const auto outR = right != nullptr ? right[n] * s.envelope[i] : outL;
+
+        s.mixLeft[i]   = s.mixLeft[i]   + outL * group.panLeft;
+        s.mixRight[i]  = s.mixRight[i]  + outR * group.panRight;
+        s.mixCentre[i] = s.mixCentre[i] + (right != nullptr ? (outL + outR) * 0.5f : outL);
+    }
+}
+
+SIMDVoiceBank::Lanes SIMDVoiceBank::oscillate (const Group& group, size_t u, Lanes phase) noexcept
+{
+    if (group.tableLanes == 0)
+        return SawWave::render (phase, group.increments[u], group.inverseIncrements[u]);
+
+    auto x = Lanes::expand (0.0f);
+
+    for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+        if ((group.tableLanes & (1u << lane)) != 0)
+            x.set (lane, WavetableSet::read (group.waves[u][lane], phase.get (lane)));
+
+    return x;
+}
+
+void SIMDVoiceBank::filterOversampled (Group& group, Scratch& s, Lanes* const* sides, int numSides, int run,
+                                       const float* cutoff, Lanes ratio, Lanes ratioStep) noexcept
+{
+    auto* const* channels    = s.laneChannels.data();
+    const auto   numChannels = (size_t) (numSides * kLanes);
+
+    for (int side = 0; side < numSides; ++side)
+        for (int n = 0; n < run; ++n)
+            for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+                channels[(size_t) side * kLanes + lane][n] = sides[side][n].get (lane);
+
+    const auto base      = juce::dsp::AudioBlock<float> (channels, numChannels, (size_t) run);
+    auto       upsampled = group.oversampling->processSamplesUp (base);
+
+    for (int side = 0; side < numSides; ++side)
+    {
+        float* up[kLanes];
+        for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+            up[lane] = upsampled.getChannelPointer ((size_t) side * kLanes + lane);
+
+        Lanes x;
+        auto  r = ratio;
+
+        for (size_t n = 0; n < upsampled.getNumSamples(); ++n)
+        {
+            for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+                x.set (lane, up[lane][n]);
+
+            r = r + ratioStep;
+            x = group.filters[(size_t) side].processSample (x, Lanes::expand (cutoff[n]) * r);
+
+            for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+                up[lane][n] = x.get (lane);
+        }
+    }
+
+    group.oversampling->processSamplesDown (base);
+
+    for (int side = 0; side < numSides; ++side)
+        for (int n = 0; n < run; ++n)
+            for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+                sides[side][n].set (lane, channels[(size_t) side * kLanes + lane][n]);
+}
+
+void SIMDVoiceBank::syncNoteCache (int startSample, int numSamples) noexcept
+{
+    const auto  factor      = modulation.getOversamplingFactor();
+    const auto* cutoff      = modulation.getCutoffCoefficients() + startSample * factor;
+    const auto  coefficient = cutoff[0];
+
+    const auto usable = noteCacheEnabled && numSamples > 0 && ! groups.empty()
+                     && groups.front().oversampling == nullptr
+                     && modulation.getLfoDepth() == 0.0f
+                     && cutoff[numSamples * factor - 1] == coefficient;
+
+    if (usable != cacheUsable || (usable && (cacheVersion != parameters.version || cacheCoefficient != coefficient)))
+    {
+        noteCache.clear();
+        cacheUsable      = usable;
+        cacheVersion     = parameters.version;
+        cacheCoefficient = coefficient;
+
+        for (auto& voice : voices)
+            if (voice.cacheUse == CacheUse::recording)
+                stopCaching (voice);
+    }
+
+    for (auto& voice : voices)
+        if (voice.cacheUse != CacheUse::none && ! voice.adsr.isActive())
+            stopCaching (voice);
+}
+
+void SIMDVoiceBank::startCaching (Voice& voice, CacheUse use, int entry) noexcept
+{
+    voice.cacheUse    = use;
+    voice.cacheEntry  = entry;
+    voice.cacheOffset = 0;
+    noteCache.touch (entry);
+}
+
+void SIMDVoiceBank::stopCaching (Voice& voice) noexcept
+{
+    if (voice.cacheUse == CacheUse::recording)
+        noteCache.abandon (voice.cacheEntry);
+
+    voice.cacheUse = CacheUse::none;
+}
+
+bool SIMDVoiceBank::isCacheEntryInUse (int entry) const noexcept
+{
+    return std::any_of (voices.begin(), voices.end(), [entry] (const Voice& voice)
+    {
+        return voice.cacheUse != CacheUse::none && voice.cacheEntry == entry;
+    });
+}
+
+SIMDVoiceBank::CachedRun SIMDVoiceBank::updateCachedLanes (int g, juce::uint32 sounding, int& run) noexcept
+{
+    const auto first = g * kLanes;
+    const auto last  = juce::jmin (first + kLanes, getNumVoices());
+    auto&      group = groups[(size_t) g];
+
+    const auto untilSnapshot = [] (const Voice& voice)
+    {
+        return NoteCache::kSnapshotSamples - voice.cacheOffset % NoteCache::kSnapshotSamples;
+    };
+
+    CachedRun cached;
+    cached.live = false;
+
+    for (int i = first; i < last; ++i)
+    {
+        auto&      voice = voices[(size_t) i];
+        const auto lane  = (size_t) (i - first);
+
+        if (voice.cacheUse == CacheUse::recording)
+        {
+            if (! isAtRest (voice))
+            {
+                stopCaching (voice);
+            }
+            else if (voice.cacheOffset % NoteCache::kSnapshotSamples == 0)
+            {
+                saveLane (group, lane, noteCache.getSnapshot (voice.cacheEntry, voice.cacheOffset));
+
+                if (voice.cacheOffset == noteCache.getLength())
+                {
+                    noteCache.markComplete (voice.cacheEntry);
+                    voice.cacheUse = CacheUse::none;
+                }
+            }
+
+            if (voice.cacheUse == CacheUse::recording)
+            {
+                cached.recording = true;
+                run = juce::jmin (run, untilSnapshot (voice));
+            }
+        }
+
+        if (voice.cacheUse != CacheUse::streaming && (sounding & (1u << lane)) != 0)
+            cached.live = true;
+    }
+
+    for (int i = first; i < last; ++i)
+    {
+        auto&      voice = voices[(size_t) i];
+        const auto lane  = (size_t) (i - first);
+
+        if (voice.cacheUse != CacheUse::streaming)
+            continue;
+
+        if (voice.cacheOffset % NoteCache::kSnapshotSamples == 0
+             && (cached.live || voice.cacheOffset == noteCache.getLength()
+                  || ! noteCache.isComplete (voice.cacheEntry) || ! isAtRest (voice)))
+        {
+            restoreLane (group, lane, noteCache.getSnapshot (voice.cacheEntry, voice.cacheOffset));
+            voice.cacheUse = CacheUse::none;
+            cached.live    = true;
+            continue;
+        }
+
+        cached.streaming = true;
+        run = juce::jmin (run, untilSnapshot (voice));
+    }
+
+    return cached;
+}
+
+void SIMDVoiceBank::streamCachedLanes (int g, Scratch& s, int pos, int run) noexcept
+{
+    const auto  first = g * kLanes;
+    const auto  last  = juce::jmin (first + kLanes, getNumVoices());
+    const auto& group = groups[(size_t) g];
+
+    for (int i = first; i < last; ++i)
+    {
+        auto& voice = voices[(size_t) i];
+
+        if (voice.cacheUse != CacheUse::streaming)
+            continue;
+
+        const auto  lane     = (size_t) (i - first);
+        const auto  spread   = noteCache.getNumSides (voice.cacheEntry) == 2;
+        const auto* left     = noteCache.getSamples (voice.cacheEntry, 0) + voice.cacheOffset;
+        const auto* right    = spread ? noteCache.getSamples (voice.cacheEntry, 1) + voice.cacheOffset : left;
+        const auto  panLeft  = group.panLeft .get (lane);
+        const auto  panRight = group.panRight.get (lane);
+
+        for (int n = 0; n < run; ++n)
+        {
+            const auto at   = (size_t) (pos + n);
+            const auto gain = s.envelope[at].get (lane);
+            s.envelope[at].set (lane, 0.0f);
+
+            const auto outL = left[n]  * gain;
+            const auto outR = right[n] * gain;
+
+            s.mixLeft[at]  .set (lane, s.mixLeft[at]  .get (lane) + outL * panLeft);
+            s.mixRight[at] .set (lane, s.mixRight[at] .get (lane) + outR * panRight);
+            s.mixCentre[at].set (lane, s.mixCentre[at].get (lane) + (spread ? (outL + outR) * 0.5f : outL));
+        }
+
+        voice.cacheOffset += run;
+    }
+}
+
+void SIMDVoiceBank::recordCachedLanes (int g, Scratch& s, int pos, int run) noexcept
+{
+    const auto first = g * kLanes;
+    const auto last  = juce::jmin (first + kLanes, getNumVoices());
+
+    for (int i = first; i < last; ++i)
+    {
+        auto& voice = voices[(size_t) i];
+
+        if (voice.cacheUse != CacheUse::recording)
+            continue;
+
+        const auto lane = (size_t) (i - first);
+        Lanes* const sides[] { s.signal + pos, s.signalRight + pos };
+
+        for (int side = 0; side < noteCache.getNumSides (voice.cacheEntry); ++side)
+        {
+            auto* out = noteCache.getSamples (voice.cacheEntry, side) + voice.cacheOffset;
+
+            for (int n = 0; n < run; ++n)
+                out[n] = sides[side][n].get (lane);
+        }
+
+        voice.cacheOffset += run;
+    }
+}
+
+void SIMDVoiceBank::saveLane (const Group& group, size_t lane, NoteCache::Snapshot& snapshot) const noexcept
+{
+    for (size_t u = 0; u < (size_t) unison.numVoices; ++u)
+        snapshot.phases[u] = group.phases[u].get (lane);
+
+    for (size_t side = 0; side < group.filters.size(); ++side)
+        group.filters[side].copyLane (lane, snapshot.filters[side].data());
+}
+
+void SIMDVoiceBank::restoreLane (Group& group, size_t lane, const NoteCache::Snapshot& snapshot) noexcept
+{
+    for (size_t u = 0; u < (size_t) unison.numVoices; ++u)
+        group.phases[u].set (lane, snapshot.phases[u]);
+
+    for (size_t side = 0; side < group.filters.size(); ++side)
+        group.filters[side].setLane (lane, snapshot.filters[side].data());
+
+    group.cutoffRatio.set (lane, 1.0f);   // at rest throughout
+}
+
+void SIMDVoiceBank::applyParameters()
+{
+    if (appliedVersion == parameters.version)
+        return;
+
+    for (auto& voice : voices)
+        voice.adsr.setParameters (parameters.adsr);
+
+    appliedVersion = parameters.version;
+
+    const auto previous = unison;
+    unison = parameters.unison;
+
+    // Every lane's cursors go, whether it's retuned into the new
+    // wavetable or not: the old one may be freed from now on
+    const auto tableChanged = parameters.wavetable != wavetable;
+    wavetable         = parameters.wavetable;
+    wavetablePosition = parameters.wavetablePosition;
+
+    for (auto& group : groups)
+    {
+        group.pitch     .setResponse (parameters.expression);
+        group.brightness.setResponse (parameters.expression);
+
+        if (tableChanged)
+            group.tableLanes = 0;
+
+        // Oscillators joining the stack start where a note's would, at
+        // the voices' current pitch; the right side picks up where the
+        // centred filter is, so spreading a held note doesn't click
+        for (size_t u = (size_t) previous.numVoices; u < (size_t) unison.numVoices; ++u)
+            group.phases[u] = Lanes::expand (unison.startPhases[u]);
+
+        for (size_t lane = 0; lane < (size_t) kLanes; ++lane)
+            if (const auto hz = group.frequency.get (lane); hz > 0.0f)
+                retune (group, lane, hz, group.cutoffExponent.get (lane));
+
+        if (unison.stereo && ! previous.stereo)
+            group.filters[1] = group.filters[0];
+
+        if (auto* profileOversampling = group.oversamplers[(size_t) parameters.renderProfile].get();
+            profileOversampling != group.oversampling)
+        {
+            group.oversampling = profileOversampling;
+
+            for (auto& filter : group.filters)
+                filter.reset();
+
+            if (profileOversampling != nullptr)
+                profileOversampling->reset();
+        }
+    }
+}
+
+void BankVoice::stopNote (float /*velocity*/, bool allowTailOff)
+{
+    bank.stopNote (index, allowTailOff);
+
+    if (allowTailOff)
+        noteReleased();
+    else
+        noteFinished();
+}
+
+void BankSynthesiser::renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    bank.setMasterPitchWheel (getMasterPitchWheel());
+    bank.render (outputAudio, startSample, numSamples, workers);
+
+    for (auto* voice : voices)
+        static_cast<BankVoice*> (voice)->clearIfFinished();
+
+    advanceClock (numSamples);
+}
+
+#endif
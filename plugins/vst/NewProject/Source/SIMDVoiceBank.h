@@ -0,0 +1,357 @@
+/*
+  ==============================================================================
+    SIMDVoiceBank.h  –  A whole bank of voices rendered lane-parallel, and
+                        the synthesiser that plays it
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "BlockADSR.h"
+#include "ExpressionSmoother.h"
+#include "LadderCore.h"
+#include "ModulationEngine.h"
+#include "NoteCache.h"
+#include "NoteExpression.h"
+#include "Oscillators.h"
+#include "RenderProfile.h"
+#include "RenderWorkers.h"
+#include "UnisonOscillator.h"
+#include "VoiceParameters.h"
+#include "VoicePool.h"
+#include "WavetableSet.h"
+#include "../../Shared/DspArena.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+#if JUCE_USE_SIMD
+//==============================================================================
+/** DSPVoice's patch for a whole bank of voices, rendered lane-parallel.
+
+    Voice i is lane i % kLanes of group i / kLanes.  Each group keeps its
+    oscillators, ladder filter and pan as structure-of-arrays registers, so
+    one instruction steps kLanes voices (4 with SSE or NEON, 8 with AVX),
+    and groups without a sounding lane are skipped.  Envelopes only change
+    once per block, so they stay scalar per voice; the cutoff comes from
+    the shared ModulationEngine.
+
+    Given RenderWorkers, a block with enough sounding groups is split into
+    up to kMaxTasks runs of groups, each mixed into its own scratch
+    buffers, which are then summed.
+
+    The sound is DSPVoice's: the published UnisonLayout's stack of PolyBLEP
+    saws (a register per oscillator of the stack, each lane a voice's),
+    or of the published wavetable, read a lane at a time, LadderCore, a
+    side each when the stack is spread, the 0.7 master gain, BlockADSR and
+    the same balance law for pan.
+
+    With the note cache on, the cutoff standing still (LFO depth 0) and the
+    filter at the base rate, a note with no expression streams its first
+    NoteCache::kLengthMs from the cache, mixed through its own envelope,
+    and its velocity is rounded to the cache's buckets.  It goes back to
+    rendering at the entry's end, or at the next snapshot once it's bent,
+    its group has another voice rendering anyway (a lane costs nothing
+    then), or the patch changes; a group whose voices are all streaming
+    isn't rendered at all. */
+class SIMDVoiceBank  : private RenderWorkers::Job
+{
+public:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int kLanes = (int) Lanes::SIMDNumElements;
+
+    static constexpr int kMaxTasks         = 4;
+    static constexpr int kMinGroupsPerTask = 4;   // below this a task costs more to hand off than to run
+
+    /** The parameters and the modulation must outlive the bank. */
+    SIMDVoiceBank (const VoiceParameters& sharedParameters, const ModulationEngine& sharedModulation)
+        : parameters (sharedParameters), modulation (sharedModulation)
+    {
+    }
+
+    int getNumVoices() const noexcept { return (int) voices.size(); }
+
+    /** Takes every task's block buffers and the note cache from the
+        processor's arena; from inside DspArena::build(). */
+    void allocate (DspArena& arena, int maximumBlockSize, double newSampleRate) noexcept;
+
+    /** `spec` describes the output; every voice is mono until the mix.
+        Allocates, so keep numVoices and the profiles fixed once playing;
+        the filter is oversampled as the published renderProfile says.
+        After allocate(), for the same maximumBlockSize. */
+    void prepare (const juce::dsp::ProcessSpec& spec, int numVoices, const RenderProfiles& profiles);
+
+    void startNote (int voiceIndex, int midiNoteNumber, float velocity, int pitchWheelPosition);
+
+    /** Whether notes may use the cache: see the class comment.  Audio
+        thread, between blocks. */
+    void setNoteCacheEnabled (bool shouldCache) noexcept { noteCacheEnabled = shouldCache; }
+
+    // MPE, as NoteExpression: the events only store targets
+    void setPitchWheel (int voiceIndex, int value) noexcept { voices[(size_t) voiceIndex].expression.setPitchWheel (value); }
+    void setTimbre     (int voiceIndex, int value) noexcept { voices[(size_t) voiceIndex].expression.setTimbre (value); }
+    void setNoteBendSemitones (int voiceIndex, float semitones) noexcept { voices[(size_t) voiceIndex].expression.setNoteBendSemitones (semitones); }
+    void setTimbreTarget      (int voiceIndex, float bipolar) noexcept   { voices[(size_t) voiceIndex].expression.setTimbreTarget (bipolar); }
+    void setPressure          (int voiceIndex, int value) noexcept       { voices[(size_t) voiceIndex].expression.setPressure (value); }
+    void setMasterPitchWheel (int value) noexcept           { masterPitchWheel = value; }
+
+    void stopNote (int voiceIndex, bool allowTailOff);
+
+    bool  isVoiceActive     (int voiceIndex) const noexcept { return voices[(size_t) voiceIndex].adsr.isActive(); }
+    float getEnvelopeLevel  (int voiceIndex) const noexcept { return voices[(size_t) voiceIndex].adsr.getLevel(); }
+
+    /** As DSPVoice::setPan(). */
+    void setPan (int voiceIndex, float newPan) noexcept;
+
+    /** Adds every sounding voice into outputBuffer, helped by `workers`
+        if given and the block is big enough to be worth splitting. */
+    void render (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples,
+                 RenderWorkers* workers = nullptr);
+
+private:
+    struct Group
+    {
+        using Stack = std::array<Lanes, UnisonLayout::kMaxVoices>;   // a register per oscillator of the stack
+
+        Stack phases;                                  // 0 … 1
+        Stack increments;                              // per sample
+        Stack inverseIncrements;                       // for PolyBLEP, which would otherwise divide
+        std::array<std::array<WavetableSet::Cursor, kLanes>, UnisonLayout::kMaxVoices> waves;   // per oscillator and lane
+        juce::uint32 tableLanes = 0;                   // a bit per lane reading waves rather than a saw
+        Lanes frequency;                               // Hz, before the stack's detune
+        Lanes level;                                   // velocity
+        Lanes panLeft, panRight;
+        Lanes cutoffExponent;                          // NoteExpression::getCutoffExponent()
+        Lanes cutoffRatio;                             // timbre's correction, where the last run ended
+        ExpressionSmoother<Lanes> pitch, brightness;   // the voices' NoteExpression targets, smoothed together
+        std::array<LadderCore<Lanes>, 2> filters;      // per side; the first alone while the stack is centred
+        std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, RenderProfile::numProfiles> oversamplers;
+        juce::dsp::Oversampling<float>* oversampling = nullptr;   // the current profile's, a channel per lane and side
+    };
+
+    enum class CacheUse { none, recording, streaming };
+
+    struct Voice
+    {
+        BlockADSR      adsr;
+        NoteExpression expression;
+        float          noteHz = 440.0f;
+        float          pan    = 0.0f;
+
+        CacheUse       cacheUse    = CacheUse::none;
+        int            cacheEntry  = -1;
+        int            cacheOffset = 0;   // samples into the entry
+    };
+
+    /** What a run of a group does with its voices' cache entries. */
+    struct CachedRun
+    {
+        bool live      = true;    // some voice renders, so the group does
+        bool recording = false;   // into an entry, from renderRun()'s signal
+        bool streaming = false;   // from an entry, in place of rendering
+    };
+
+    /** One task's working buffers, a block each, from the arena. */
+    struct Scratch
+    {
+        Lanes*                         envelope = nullptr, *mixLeft = nullptr, *mixRight = nullptr, *mixCentre = nullptr;
+        Lanes*                         signal        = nullptr;   // the group's voices, before the envelope
+        Lanes*                         signalRight   = nullptr;   // their right sides, while the stack is spread
+        float*                         envelopeGains = nullptr;
+        std::array<float*, 2 * kLanes> laneChannels {};           // the signals, a channel per lane and side, for oversampling
+    };
+
+    /** Renders one contiguous run of the sounding groups into its own
+        scratch; several may run at once, as no two share a group. */
+    void runTask (int taskIndex) override;
+
+    bool isGroupActive (int g) const noexcept;
+
+    /** Fills s.envelope with the group's kLanes envelopes and the master
+        gain; returns a bit per lane whose voice sounds in the block. */
+    juce::uint32 renderEnvelopes (int g, int numSamples, Scratch& s);
+
+    /** Renders a run at a time, the runs ending at the expression's
+        control steps, where the group's voices are retuned, and at its
+        voices' cache snapshots. */
+    void renderGroup (int g, Scratch& s, int numSamples, juce::uint32 sounding) noexcept;
+
+    void stepExpression (int g) noexcept;
+    void retune (Group& group, size_t lane, float hz, float cutoffExponent) noexcept;
+
+    /** Samples pos … pos + run of the group, mixed into s; cutoff is
+        where the run starts in the curve, numFilterSamples long.  At the
+        base rate that's one fused pass (renderRunFused()); the oversampled
+        filter needs the run's oscillators in a block first. */
+    void renderRun (Group& group, Scratch& s, int pos, int run,
+                    const float* cutoff, int numFilterSamples, bool record) noexcept;
+
+    /** renderRun() at the base rate, in one pass per sample: the stack,
+        the filter, the envelope and the mix, with the filter state and the
+        stack's gains in locals rather than a scratch block per stage.
+        Recording, the filtered sides also go to s.signal (and
+        s.signalRight) for recordCachedLanes(). */
+    template <bool spread, bool record>
+    void renderRunFused (Group& group, Scratch& s, int pos, int run,
+                         const float* cutoff, Lanes ratio, Lanes ratioStep) noexcept;
+
+    /** Oscillator u of the stack for every lane: its saw, or for the lanes
+        with a wavetable, a read from that. */
+    static Lanes oscillate (const Group& group, size_t u, Lanes phase) noexcept;
+
+    /** sides[0 … numSides), each run long, through their filters at the
+        oversampled rate: each lane of each side is a channel to
+        juce::dsp::Oversampling, and a lane again to the filter. */
+    void filterOversampled (Group& group, Scratch& s, Lanes* const* sides, int numSides, int run,
+                            const float* cutoff, Lanes ratio, Lanes ratioStep) noexcept;
+
+    //==============================================================================
+    /** Clears the cache when what it was recorded under has changed, and
+        lets go of the entries of notes that have ended.  Before a block. */
+    void syncNoteCache (int startSample, int numSamples) noexcept;
+
+    /** Targets the voice was started at: no bend, timbre or pressure. */
+    static bool isAtRest (const Voice& voice) noexcept
+    {
+        return voice.expression.getTargetSemitones() == 0.0f && voice.expression.getTargetBrightness() == 0.0f;
+    }
+
+    void startCaching (Voice& voice, CacheUse use, int entry) noexcept;
+    void stopCaching (Voice& voice) noexcept;
+    bool isCacheEntryInUse (int entry) const noexcept;
+
+    /** The group's caching voices at the start of a run: recording ones
+        take their snapshots and finish, streaming ones go back to
+        rendering where they must, and run is cut short at the next
+        snapshot of any still caching. */
+    CachedRun updateCachedLanes (int g, juce::uint32 sounding, int& run) noexcept;
+
+    /** The streaming voices' run from their entries, through their
+        envelopes into s's mix, as renderRunFused() would have mixed them;
+        their envelopes are then zeroed, so their lanes of the group add
+        nothing if it renders. */
+    void streamCachedLanes (int g, Scratch& s, int pos, int run) noexcept;
+
+    /** The recording voices' run, from the filtered signal renderRun()
+        left in s, into their entries. */
+    void recordCachedLanes (int g, Scratch& s, int pos, int run) noexcept;
+
+    void saveLane (const Group& group, size_t lane, NoteCache::Snapshot& snapshot) const noexcept;
+    void restoreLane (Group& group, size_t lane, const NoteCache::Snapshot& snapshot) noexcept;
+
+    //==============================================================================
+    /** Picks up a new publish for every voice at once. */
+    void applyParameters();
+
+    static constexpr float masterGain = 0.7f;
+
+    const VoiceParameters&  parameters;
+    const ModulationEngine& modulation;
+    juce::uint32            appliedVersion = ~0u;
+    double                  sampleRate     = 44100.0;
+    UnisonLayout            unison;   // the last published, for every group
+    const WavetableSet*     wavetable         = nullptr;   // likewise
+    float                   wavetablePosition = 0.0f;
+
+    std::vector<Voice> voices;
+    std::vector<Group> groups;
+
+    Scratch            scratch[kMaxTasks];
+    float*             mixed = nullptr;   // one block, from the arena
+    std::vector<int>   activeGroups;   // this block's, reserved for every group
+
+    // The block being rendered, for runTask()
+    int blockStart   = 0;
+    int blockSamples = 0;
+    int taskCount    = 1;
+    int firstStep    = 0;   // where the block's first control step falls
+
+    int samplesToControlStep = 0;
+    int masterPitchWheel     = 8192;   // centred
+
+    // What the cache's entries were recorded under, checked every block
+    NoteCache    noteCache;
+    bool         noteCacheEnabled = false;
+    bool         cacheUsable      = false;
+    juce::uint32 cacheVersion     = 0;      // parameters.version
+    float        cacheCoefficient = 0.0f;   // the cutoff, standing still
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SIMDVoiceBank)
+};
+
+//==============================================================================
+/** One of an SIMDVoiceBank's voices, for juce::Synthesiser: the synth still
+    allocates, steals and releases voices, and the bank renders them. */
+class BankVoice : public PooledVoice
+{
+public:
+    BankVoice (SIMDVoiceBank& owner, int voiceIndex)
+        : bank (owner), index (voiceIndex)
+    {
+    }
+
+    bool canPlaySound (juce::SynthesiserSound* sound) override
+    {
+        return dynamic_cast<SineWaveSound*> (sound) != nullptr;
+    }
+
+    void startNote (int midiNoteNumber, float velocity,
+                    juce::SynthesiserSound*, int pitchWheelPosition) override
+    {
+        bank.startNote (index, midiNoteNumber, velocity, pitchWheelPosition);
+        noteStarted();
+    }
+
+    void stopNote (float /*velocity*/, bool allowTailOff) override;
+
+    float getEnvelopeLevel() const noexcept override { return bank.getEnvelopeLevel (index); }
+
+    void pitchWheelMoved (int newPitchWheelValue) override { bank.setPitchWheel (index, newPitchWheelValue); }
+
+    void controllerMoved (int controllerNumber, int newControllerValue) override
+    {
+        if (controllerNumber == NoteExpression::kTimbreController)
+            bank.setTimbre (index, newControllerValue);
+    }
+
+    void channelPressureChanged (int newValue) override { bank.setPressure (index, newValue); }
+    void aftertouchChanged      (int newValue) override { bank.setPressure (index, newValue); }
+
+    void setControlBend   (float semitones) noexcept override { bank.setNoteBendSemitones (index, semitones); }
+    void setControlTimbre (float bipolar) noexcept override   { bank.setTimbreTarget (index, bipolar); }
+
+    // BankSynthesiser renders the whole bank instead
+    void renderNextBlock (juce::AudioSampleBuffer&, int, int) override {}
+
+    /** Frees the voice for the synth once its release has finished. */
+    void clearIfFinished()
+    {
+        if (isVoiceActive() && ! bank.isVoiceActive (index))
+            noteFinished();
+    }
+
+private:
+    SIMDVoiceBank& bank;
+    const int      index;
+};
+
+//==============================================================================
+/** VoicePoolSynthesiser whose BankVoices all render in one SIMDVoiceBank pass. */
+class BankSynthesiser : public VoicePoolSynthesiser
+{
+public:
+    explicit BankSynthesiser (SIMDVoiceBank& voiceBank) : bank (voiceBank) {}
+
+    /** Workers to split big blocks across, or nullptr to render on the
+        audio thread alone.  Audio thread, between blocks. */
+    void setRenderWorkers (RenderWorkers* workersToUse) noexcept { workers = workersToUse; }
+
+protected:
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
+private:
+    SIMDVoiceBank& bank;
+    RenderWorkers* workers = nullptr;
+};
+#endif
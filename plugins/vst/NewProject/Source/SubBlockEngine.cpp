@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+    SubBlockEngine.cpp  –  SubBlockEngine implementation
+  ==============================================================================
+*/
+
+#include "SubBlockEngine.h"
+
+void SubBlockEngine::prepare (int numChannels, int newSubBlockSize)
+{
+    subBlockSize = newSubBlockSize;
+    block.setSize (numChannels, subBlockSize);
+    blockMidi.ensureSize (kMidiBytes);
+    heldMidi .ensureSize (kMidiBytes);
+    reset();
+}
+
+void SubBlockEngine::reset() noexcept
+{
+    block.clear();
+    blockMidi.clear();
+    heldMidi.clear();
+    numLeft = 0;
+}
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+    SubBlockEngine.h  –  Renders in sub-blocks of one fixed size,
+                         whatever blocks the host sends
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** Renders in sub-blocks of one fixed size, whatever blocks the host sends.
+
+    Hosts send more than prepareToPlay() announced, or anything from one
+    sample to thousands a callback, and every per-block cost follows them.
+    Instead the processor renders its voices and reverb through this,
+    always getSubBlockSize() samples at a time into a buffer of its own,
+    and the callbacks are served from that: what's left of the last
+    sub-block first, then as many more as the callback needs, the rest of
+    the last one kept for the next.  Nothing is added to the latency.
+
+    MIDI lands on the grid: an event goes at the start of the first
+    sub-block rendered at or after its sample, so it is up to a sub-block
+    late, never early, and the synth never splits one.  Events after the
+    last sub-block a callback starts wait for the next callback's first.
+
+    Nothing allocates after prepare() unless a sub-block's MIDI outgrows
+    kMidiBytes. */
+class SubBlockEngine
+{
+public:
+    static constexpr int kMidiBytes = 4096;   // per sub-block's events, and the ones held over
+
+    /** Allocates a sub-block of numChannels.  Message thread. */
+    void prepare (int numChannels, int newSubBlockSize);
+
+    void reset() noexcept;
+
+    int getSubBlockSize() const noexcept { return subBlockSize; }
+
+    /** Adds output.getNumSamples() samples to output, calling
+        render (juce::AudioBuffer<float>& subBlock, juce::MidiBuffer& events)
+        for as many sub-blocks as that takes; each comes cleared, with its
+        events all at sample 0.  Audio thread. */
+    template <typename RenderFn>
+    void process (juce::AudioBuffer<float>& output, const juce::MidiBuffer& midi, RenderFn&& render)
+    {
+        const auto numSamples = output.getNumSamples();
+        auto       event      = midi.cbegin();
+
+        auto pos = juce::jmin (numLeft, numSamples);
+        addLeftTo (output, 0, pos);
+
+        while (pos < numSamples)
+        {
+            blockMidi.clear();
+            blockMidi.addEvents (heldMidi, 0, -1, 0);
+            heldMidi.clear();
+
+            for (; event != midi.cend() && (*event).samplePosition <= pos; ++event)
+                blockMidi.addEvent ((*event).data, (*event).numBytes, 0);
+
+            block.clear();
+            render (block, blockMidi);
+            numLeft = subBlockSize;
+
+            const auto count = juce::jmin (subBlockSize, numSamples - pos);
+            addLeftTo (output, pos, count);
+            pos += count;
+        }
+
+        for (; event != midi.cend(); ++event)
+            heldMidi.addEvent ((*event).data, (*event).numBytes, 0);
+    }
+
+private:
+    /** The next count samples of the sub-block, at output's destStart. */
+    void addLeftTo (juce::AudioBuffer<float>& output, int destStart, int count) noexcept
+    {
+        const auto numChannels = juce::jmin (output.getNumChannels(), block.getNumChannels());
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            output.addFrom (ch, destStart, block, ch, subBlockSize - numLeft, count);
+
+        numLeft -= count;
+    }
+
+    juce::AudioBuffer<float> block;
+    juce::MidiBuffer         blockMidi, heldMidi;   // the sub-block's events; those past the last one started
+    int                      subBlockSize = 32;
+    int                      numLeft      = 0;   // samples of block not yet handed out
+};
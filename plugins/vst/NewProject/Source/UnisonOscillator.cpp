@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+    UnisonOscillator.cpp  –  UnisonOscillator implementation
+  ==============================================================================
+*/
+
+#include "UnisonOscillator.h"
+#include <cmath>
+
+UnisonLayout UnisonLayout::from (const UnisonSettings& settings) noexcept
+{
+    UnisonLayout layout;
+    const auto n      = juce::jlimit (1, kMaxVoices, settings.voices);
+    const auto spread = juce::jlimit (0.0f, 1.0f, settings.spread);
+    const auto gain   = std::sqrt (2.0f / (float) n);
+
+    layout.numVoices = n;
+    layout.stereo    = spread > 0.0f;
+
+    for (int u = 0; u < kMaxVoices; ++u)
+    {
+        const auto i        = (size_t) u;
+        const auto used     = u < n;
+        const auto position = n > 1 ? 2.0f * (float) u / (float) (n - 1) - 1.0f : 0.0f;   // -1 … 1
+        const auto pan      = position * spread;
+
+        // Lanes past the count stay silent, at a harmless increment
+        layout.ratios[i]      = used ? std::exp2 (position * 0.5f * settings.detuneCents / 1200.0f) : 1.0f;
+        layout.gainsCentre[i] = used ? gain : 0.0f;
+        layout.gainsLeft[i]   = layout.gainsCentre[i] * juce::jmin (1.0f, 1.0f - pan);
+        layout.gainsRight[i]  = layout.gainsCentre[i] * juce::jmin (1.0f, 1.0f + pan);
+
+        const auto golden      = (float) u * 0.6180339887f;
+        layout.startPhases[i]  = golden - std::floor (golden);
+    }
+
+    return layout;
+}
+
+void UnisonOscillator::setLayout (const UnisonLayout& newLayout) noexcept
+{
+    for (int u = layout.numVoices; u < newLayout.numVoices; ++u)
+        setLane (phases[(size_t) (u / kLanes)], u % kLanes, newLayout.startPhases[(size_t) u]);
+
+    layout    = newLayout;
+    numChunks = (layout.numVoices + kLanes - 1) / kLanes;
+    updateGains();
+}
+
+void UnisonOscillator::setFrequency (float hz) noexcept
+{
+    for (int u = 0; u < numChunks * kLanes; ++u)
+    {
+        // Above half the sample rate the residuals no longer make sense
+        const auto increment = juce::jmin (hz * layout.ratios[(size_t) u] / (float) sampleRate, 0.5f);
+        setLane (increments[(size_t) (u / kLanes)],        u % kLanes, increment);
+        setLane (inverseIncrements[(size_t) (u / kLanes)], u % kLanes, 1.0f / increment);
+
+        if (table != nullptr)
+            cursors[(size_t) u] = table->cursorFor (increment, tablePosition);
+    }
+}
+
+void UnisonOscillator::render (float* left, float* right, int numSamples) noexcept
+{
+    float unused;
+
+    if (right == nullptr)
+        for (int n = 0; n < numSamples; ++n)
+            next<false> (left[n], unused);
+    else
+        for (int n = 0; n < numSamples; ++n)
+            next<true> (left[n], right[n]);
+}
+
+void UnisonOscillator::updateGains() noexcept
+{
+    for (int u = 0; u < UnisonLayout::kMaxVoices; ++u)
+    {
+        const auto c = (size_t) (u / kLanes);
+        setLane (gainsLeft[c],   u % kLanes, level * layout.gainsLeft  [(size_t) u]);
+        setLane (gainsRight[c],  u % kLanes, level * layout.gainsRight [(size_t) u]);
+        setLane (gainsCentre[c], u % kLanes, level * layout.gainsCentre[(size_t) u]);
+    }
+}
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+    UnisonOscillator.h  –  The voices' unison stack: its settings, their layout
+                           per oscillator, and the oscillator that plays it
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "Oscillators.h"
+#include "WavetableSet.h"
+#include <array>
+
+//==============================================================================
+/** The voices' oscillator stack: how many detuned saws play each note, and
+    how far apart they sit in pitch and in the stereo field. */
+struct UnisonSettings
+{
+    int   voices      = 2;        // 1 … UnisonLayout::kMaxVoices
+    float detuneCents = 17.2f;    // lowest to highest; 2 at 17.2 is the old +1% pair
+    float spread      = 0.0f;     // 0 = all centred … 1 = the outermost hard left and right
+};
+
+/** UnisonSettings worked out per oscillator, once per change, for
+    UnisonOscillator and SIMDVoiceBank alike.
+
+    The oscillators sit evenly from -detune/2 to +detune/2, panned with
+    their detune (lowest left) by the balance law the voices use.  Their
+    phases start spread by the golden ratio, so a stack doesn't begin with
+    one big in-phase spike, and always at the same places, so renders
+    repeat.  Each plays at √(2/N): uncorrelated saws add as power, so any
+    count is as loud as the pair was. */
+struct UnisonLayout
+{
+    static constexpr int kMaxVoices = 16;
+
+    int  numVoices = 1;
+    bool stereo    = false;   // spread > 0: the voice needs a signal per side
+    std::array<float, kMaxVoices> ratios {}, gainsLeft {}, gainsRight {}, gainsCentre {}, startPhases {};
+
+    static UnisonLayout from (const UnisonSettings& settings) noexcept;
+};
+
+//==============================================================================
+/** One voice's unison stack of PolyBLEP saws, kLanes oscillators to a
+    register (4 with SSE or NEON, 8 with AVX), so a sample of sixteen costs
+    four register steps rather than sixteen oscillators, and the common
+    two-to-four stack one.  The stack is summed in registers and reduced
+    once per sample and side.  Given a wavetable, the stack reads that
+    instead, a lane at a time.
+
+    Unlike BandLimitedOscillator it writes rather than adds, and the
+    frequency changes at once: DSPVoice retunes it per control step. */
+class UnisonOscillator
+{
+public:
+   #if JUCE_USE_SIMD
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    static constexpr int kLanes = (int) Lanes::SIMDNumElements;
+   #else
+    using Lanes = float;
+    static constexpr int kLanes = 1;
+   #endif
+
+    static constexpr int kMaxChunks = UnisonLayout::kMaxVoices / kLanes;
+    static_assert (UnisonLayout::kMaxVoices % kLanes == 0, "the stack must fill whole registers");
+
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    /** Every oscillator back to its start phase. */
+    void reset() noexcept
+    {
+        for (int u = 0; u < UnisonLayout::kMaxVoices; ++u)
+            setLane (phases[(size_t) (u / kLanes)], u % kLanes, layout.startPhases[(size_t) u]);
+    }
+
+    /** Takes effect at the next setFrequency(); oscillators joining the
+        stack start where reset() would put them. */
+    void setLayout (const UnisonLayout& newLayout) noexcept;
+
+    const UnisonLayout& getLayout() const noexcept { return layout; }
+
+    /** Plays the stack from `set` at `position` through its frames, or the
+        saws if nullptr, from the next setFrequency().  The set is read
+        until the next call. */
+    void setWavetable (const WavetableSet* set, float position) noexcept
+    {
+        table         = set;
+        tablePosition = position;
+    }
+
+    void setLevel (float newLevel) noexcept
+    {
+        level = newLevel;
+        updateGains();
+    }
+
+    void setFrequency (float hz) noexcept;
+
+    /** Writes numSamples of the stack into left, and into right too if
+        given (else left is the centred mix). */
+    void render (float* left, float* right, int numSamples) noexcept;
+
+    /** One sample of the stack, for a caller that fuses it with what
+        follows: a side each if stereo, else the centred mix in left. */
+    template <bool stereo>
+    void next (float& left, float& right) noexcept
+    {
+        auto sumLeft = expand (0.0f), sumRight = expand (0.0f);
+
+        for (int c = 0; c < numChunks; ++c)
+        {
+            auto& phase = phases[(size_t) c];
+            phase = wrap (phase + increments[(size_t) c]);
+
+            const auto x = table != nullptr ? readTable (c, phase)
+                                            : saw (phase, increments[(size_t) c], inverseIncrements[(size_t) c]);
+
+            if constexpr (stereo)
+            {
+                sumLeft  = sumLeft  + x * gainsLeft[(size_t) c];
+                sumRight = sumRight + x * gainsRight[(size_t) c];
+            }
+            else
+            {
+                sumLeft = sumLeft + x * gainsCentre[(size_t) c];
+            }
+        }
+
+        left = sumLanes (sumLeft);
+
+        if constexpr (stereo)
+            right = sumLanes (sumRight);
+    }
+
+private:
+    void updateGains() noexcept;
+
+    Lanes readTable (int chunk, Lanes phase) const noexcept
+    {
+        auto x = expand (0.0f);
+
+        for (int lane = 0; lane < kLanes; ++lane)
+            setLane (x, lane, WavetableSet::read (cursors[(size_t) (chunk * kLanes + lane)], getLane (phase, lane)));
+
+        return x;
+    }
+
+   #if JUCE_USE_SIMD
+    static Lanes expand   (float value) noexcept                       { return Lanes::expand (value); }
+    static void  setLane  (Lanes& chunk, int lane, float value) noexcept { chunk.set ((size_t) lane, value); }
+    static float getLane  (const Lanes& chunk, int lane) noexcept      { return chunk.get ((size_t) lane); }
+    static float sumLanes (const Lanes& chunk) noexcept                { return chunk.sum(); }
+
+    static Lanes wrap (Lanes phase) noexcept
+    {
+        const auto one = Lanes::expand (1.0f);
+        return phase - (one & Lanes::greaterThanOrEqual (phase, one));
+    }
+
+    static Lanes saw (Lanes phase, Lanes increment, Lanes inverseIncrement) noexcept
+    {
+        return SawWave::render (phase, increment, inverseIncrement);
+    }
+   #else
+    static Lanes expand   (float value) noexcept                       { return value; }
+    static void  setLane  (float& chunk, int, float value) noexcept    { chunk = value; }
+    static float getLane  (float chunk, int) noexcept                  { return chunk; }
+    static float sumLanes (float chunk) noexcept                       { return chunk; }
+    static Lanes wrap     (float phase) noexcept                       { return phase >= 1.0f ? phase - 1.0f : phase; }
+    static Lanes saw      (float phase, float increment, float) noexcept { return SawWave::render (phase, increment); }
+   #endif
+
+    UnisonLayout layout;
+    int          numChunks  = 1;
+    double       sampleRate = 44100.0;
+    float        level      = 1.0f;
+
+    std::array<Lanes, kMaxChunks> phases {}, increments {}, inverseIncrements {};
+    std::array<Lanes, kMaxChunks> gainsLeft {}, gainsRight {}, gainsCentre {};   // level times the layout's
+
+    const WavetableSet* table         = nullptr;   // the saws if nullptr
+    float               tablePosition = 0.0f;
+    std::array<WavetableSet::Cursor, UnisonLayout::kMaxVoices> cursors {};   // per oscillator, while there's a table
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+    UniversalMidiFifo.h  –  MIDI 2.0 packets from one producer thread to the
+                            audio thread
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../Shared/LockFreeRing.h"
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/** MIDI 2.0 Universal MIDI Packets, as their raw 32-bit words, from one
+    producer thread to the audio thread.  Only whole packets go in, so the
+    consumer always finds a packet's remaining words behind its first. */
+class UniversalMidiFifo
+{
+public:
+    static constexpr int kCapacity = 4096;   // words
+
+    /** Producer.  False, with nothing queued, if the packets don't fit or
+        the last one is cut short. */
+    bool push (const juce::uint32* words, int numWords) noexcept
+    {
+        for (int i = 0; i < numWords;)
+        {
+            i += (int) juce::universal_midi_packets::Utils::getNumWordsForMessageType (words[i]);
+
+            if (i > numWords)
+                return false;
+        }
+
+        // Only the consumer moves meanwhile, and it only makes more room
+        if (numWords > kCapacity - ring.numReady())
+        {
+            numDropped.fetch_add ((juce::uint64) numWords, std::memory_order_relaxed);
+            return false;
+        }
+
+        return ring.pushBlock (words, numWords) == numWords;
+    }
+
+    /** Words refused because the fifo was full.  Any thread. */
+    juce::uint64 getNumDropped() const noexcept { return numDropped.load (std::memory_order_relaxed); }
+
+    /** Consumer.  Calls handler (const juce::uint32* packet) for each queued
+        packet, in order. */
+    template <typename Handler>
+    void popPackets (Handler&& handler)
+    {
+        std::array<juce::uint32, 4> packet;
+
+        while (ring.pop (packet[0]))
+        {
+            const auto numWords = juce::universal_midi_packets::Utils::getNumWordsForMessageType (packet[0]);
+
+            for (juce::uint32 i = 1; i < numWords; ++i)
+                ring.pop (packet[i]);
+
+            handler (static_cast<const juce::uint32*> (packet.data()));
+        }
+    }
+
+private:
+    LockFreeRing<juce::uint32, kCapacity> ring;
+    std::atomic<juce::uint64>             numDropped { 0 };
+};
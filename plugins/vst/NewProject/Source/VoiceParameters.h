@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+    VoiceParameters.h  –  Everything the voices read from the parameters
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "ExpressionSmoother.h"
+#include "UnisonOscillator.h"
+#include "WavetableSet.h"
+
+//==============================================================================
+/** Everything the voices read from the parameters.  The processor publishes
+    it before rendering a block in which one of them moved, and the voices
+    only read it while rendering, so it needs no locking. */
+struct VoiceParameters
+{
+    juce::ADSR::Parameters adsr;
+    ExpressionSmoothing    expression;
+    UnisonLayout           unison { UnisonLayout::from ({}) };
+    const WavetableSet*    wavetable { nullptr };   // the stack's waveform, or the saws if nullptr
+    float                  wavetablePosition { 0.0f };
+    int                    renderProfile { 0 };   // a RenderProfile::Index
+    juce::uint32           version   { 0 };   // bumped by every publish
+};
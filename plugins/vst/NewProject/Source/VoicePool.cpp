@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+    VoicePool.cpp  –  VoicePool implementation
+  ==============================================================================
+*/
+
+#include "VoicePool.h"
+#include <limits>
+
+void PooledVoice::noteStarted() noexcept
+{
+    released    = false;
+    startSample = pool->sampleClock;
+    pool->markBusy (poolIndex);
+}
+
+void PooledVoice::noteFinished()
+{
+    clearCurrentNote();
+    released = false;
+    pool->markFree (poolIndex);
+}
+
+int PooledVoice::getMasterPitchWheel() const noexcept
+{
+    return pool->getMasterPitchWheel();
+}
+
+PooledVoice* VoicePoolSynthesiser::addPooledVoice (PooledVoice* voice)
+{
+    voice->pool      = this;
+    voice->poolIndex = getNumVoices();
+    addVoice (voice);
+
+    freeListPosition.push_back (-1);
+    freeVoices.reserve ((size_t) getNumVoices());
+    markFree (voice->poolIndex);
+    return voice;
+}
+
+void VoicePoolSynthesiser::applyControl (int midiChannel, int midiNoteNumber, float bendSemitones, float timbre)
+{
+    forEachVoicePlaying (midiChannel, midiNoteNumber, [=] (PooledVoice& voice)
+    {
+        voice.applyControl (bendSemitones, timbre);
+    });
+}
+
+void VoicePoolSynthesiser::releaseVoicesOverCap()
+{
+    const juce::ScopedLock sl (lock);
+
+    int numHeld = 0;
+    for (auto* voice : voices)
+        if (voice->isVoiceActive() && ! static_cast<PooledVoice*> (voice)->isReleasing())
+            ++numHeld;
+
+    for (; numHeld > voiceCap; --numHeld)
+        if (auto* victim = findCheapestVoice (true))
+        {
+            victim->stopNote (1.0f, true);
+            ++numStolen;
+        }
+}
+
+juce::SynthesiserVoice* VoicePoolSynthesiser::findFreeVoice (juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                                             int midiNoteNumber, bool stealIfNoneAvailable) const
+{
+    if (! freeVoices.empty() && getNumActiveVoices() < voiceCap)
+        return voices.getUnchecked (freeVoices.back());
+
+    if (! stealIfNoneAvailable)
+        return nullptr;
+
+    // juce::Synthesiser::noteOn() restarts whatever this returns
+    auto* victim = findVoiceToSteal (soundToPlay, midiChannel, midiNoteNumber);
+
+    if (victim != nullptr)
+        ++numStolen;
+
+    return victim;
+}
+
+void VoicePoolSynthesiser::handlePitchWheel (int midiChannel, int wheelValue)
+{
+    if (midiChannel == NoteExpression::kMasterChannel)
+        masterPitchWheel = wheelValue;
+    else
+        juce::Synthesiser::handlePitchWheel (midiChannel, wheelValue);
+}
+
+PooledVoice* VoicePoolSynthesiser::findCheapestVoice (bool heldOnly) const
+{
+    PooledVoice* cheapest = nullptr;
+    float        lowestCost = std::numeric_limits<float>::max();
+
+    for (auto* v : voices)
+    {
+        auto* voice = static_cast<PooledVoice*> (v);
+
+        if (! voice->isVoiceActive() || (heldOnly && voice->isReleasing()))
+            continue;
+
+        const auto ageSeconds = (float) ((double) (sampleClock - voice->startSample) / getSampleRate());
+        const auto cost       = voice->getEnvelopeLevel() * (voice->isReleasing() ? 0.5f : 1.0f)
+                                  / (1.0f + ageSeconds);
+
+        if (cost < lowestCost)
+        {
+            lowestCost = cost;
+            cheapest   = voice;
+        }
+    }
+
+    return cheapest;
+}
+
+void VoicePoolSynthesiser::markFree (int index)
+{
+    if (freeListPosition[(size_t) index] >= 0)
+        return;
+
+    freeListPosition[(size_t) index] = (int) freeVoices.size();
+    freeVoices.push_back (index);
+}
+
+void VoicePoolSynthesiser::markBusy (int index) noexcept
+{
+    const auto position = freeListPosition[(size_t) index];
+
+    if (position < 0)
+        return;
+
+    // Swap the last entry into its place
+    const auto last = freeVoices.back();
+    freeVoices[(size_t) position]     = last;
+    freeListPosition[(size_t) last]   = position;
+    freeVoices.pop_back();
+    freeListPosition[(size_t) index]  = -1;
+}
@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+    VoicePool.h  –  Voices handed out from a fixed pool, and the sound
+                    they play
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "NoteExpression.h"
+#include <vector>
+
+//==============================================================================
+struct SineWaveSound : public juce::SynthesiserSound
+{
+    SineWaveSound() {}
+    bool appliesToNote    (int) override { return true; }
+    bool appliesToChannel (int) override { return true; }
+};
+
+//==============================================================================
+class VoicePoolSynthesiser;
+
+/** A voice VoicePoolSynthesiser can hand out from its free list and weigh
+    for stealing.  Subclasses report their envelope and call the three
+    note hooks below. */
+class PooledVoice : public juce::SynthesiserVoice
+{
+public:
+    /** The envelope's current output, 0 … 1. */
+    virtual float getEnvelopeLevel() const noexcept = 0;
+
+    /** Set the note's expression targets unquantised, from a control
+        stream, OSC or MIDI 2.0 rather than MIDI 1.0: its own bend in
+        semitones, and its timbre, -1 … 1. */
+    virtual void setControlBend   (float semitones) noexcept = 0;
+    virtual void setControlTimbre (float bipolar) noexcept = 0;
+
+    void applyControl (float bendSemitones, float timbre) noexcept
+    {
+        setControlBend (bendSemitones);
+        setControlTimbre (timbre);
+    }
+
+    bool isReleasing() const noexcept { return released; }
+
+protected:
+    /** Call from startNote(). */
+    void noteStarted() noexcept;
+
+    /** Call from stopNote() when the note tails off. */
+    void noteReleased() noexcept { released = true; }
+
+    /** Call instead of clearCurrentNote(), so the voice goes back on the
+        free list. */
+    void noteFinished();
+
+    /** The MPE master channel's pitch wheel, which bends every note. */
+    int getMasterPitchWheel() const noexcept;
+
+private:
+    friend class VoicePoolSynthesiser;
+
+    VoicePoolSynthesiser* pool        = nullptr;
+    int                   poolIndex   = -1;
+    juce::int64           startSample = 0;
+    bool                  released    = false;
+};
+
+//==============================================================================
+/** juce::Synthesiser over a fixed pool of PooledVoices.
+
+    Free voices sit on a stack, so finding one is O(1) rather than a scan
+    of the pool.  At most getVoiceCap() voices sound at once; past that a
+    new note steals the voice that costs least to lose: its envelope level,
+    halved once it is releasing, over (1 + its age in seconds).  So quiet
+    and old voices go first, and a loud fresh note is the last to be cut. */
+class VoicePoolSynthesiser : public juce::Synthesiser
+{
+public:
+    static constexpr int kMaxVoices = 128;
+
+    /** Adds a free voice to the pool, which owns it.  Only while nothing
+        is rendering. */
+    PooledVoice* addPooledVoice (PooledVoice* voice);
+
+    /** Most voices allowed to sound at once, 1 … the pool size. */
+    void setVoiceCap (int newCap) noexcept  { voiceCap = juce::jlimit (1, juce::jmax (1, getNumVoices()), newCap); }
+    int  getVoiceCap() const noexcept       { return voiceCap; }
+
+    int  getNumActiveVoices() const noexcept { return getNumVoices() - (int) freeVoices.size(); }
+
+    /** Notes cut short so far: voices taken over by a newer note, and
+        held voices released by releaseVoicesOverCap().  Only ever grows. */
+    juce::uint64 getNumStolen() const noexcept { return numStolen; }
+
+    /** The MPE master channel's latest pitch wheel, 0 … 16383. */
+    int  getMasterPitchWheel() const noexcept { return masterPitchWheel; }
+
+    /** Calls fn (PooledVoice&) for the voices playing this note on this
+        channel (any note, for -1), as long as they still are.  Audio
+        thread, between blocks. */
+    template <typename Function>
+    void forEachVoicePlaying (int midiChannel, int midiNoteNumber, Function&& fn)
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (auto* voice : voices)
+            if (voice->isPlayingChannel (midiChannel)
+                 && (midiNoteNumber < 0 || voice->getCurrentlyPlayingNote() == midiNoteNumber))
+                fn (*static_cast<PooledVoice*> (voice));
+    }
+
+    /** Hands a control stream's expression to the voice playing this note
+        on this channel, if one still is. */
+    void applyControl (int midiChannel, int midiNoteNumber, float bendSemitones, float timbre);
+
+    /** Releases the cheapest voices to lose until no more than the cap
+        are still held, so a lowered cap sheds load without waiting for
+        notes to end.  Audio thread, between blocks. */
+    void releaseVoicesOverCap();
+
+protected:
+    juce::SynthesiserVoice* findFreeVoice (juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                           int midiNoteNumber, bool stealIfNoneAvailable) const override;
+
+    juce::SynthesiserVoice* findVoiceToSteal (juce::SynthesiserSound*, int, int) const override
+    {
+        return findCheapestVoice (false);
+    }
+
+    /** The master channel's wheel bends every note, so it isn't passed to
+        the voices playing that channel as a note's own bend; the voices
+        read it when they step their expression. */
+    void handlePitchWheel (int midiChannel, int wheelValue) override;
+
+    void renderVoices (juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override
+    {
+        juce::Synthesiser::renderVoices (outputAudio, startSample, numSamples);
+        advanceClock (numSamples);
+    }
+
+    /** For subclasses that render their voices some other way. */
+    void advanceClock (int numSamples) noexcept { sampleClock += numSamples; }
+
+private:
+    friend class PooledVoice;
+
+    PooledVoice* findCheapestVoice (bool heldOnly) const;
+    void markFree (int index);
+    void markBusy (int index) noexcept;
+
+    std::vector<int> freeVoices;         // pool indices, reserved for the whole pool
+    std::vector<int> freeListPosition;   // per voice: its slot in freeVoices, -1 while busy
+    int              voiceCap    = kMaxVoices;
+    juce::int64      sampleClock = 0;
+    int              masterPitchWheel = 8192;   // centred
+    mutable juce::uint64 numStolen  = 0;        // counted by findFreeVoice(), under the synth's lock
+};
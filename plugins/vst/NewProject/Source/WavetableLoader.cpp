@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+    WavetableLoader.cpp  –  WavetableLoader implementation
+  ==============================================================================
+*/
+
+#include "WavetableLoader.h"
+#include <memory>
+
+WavetableLoader::~WavetableLoader()
+{
+    stopThread (2000);
+    freeRetired();
+    delete ready.exchange (nullptr);
+    delete current;
+}
+
+bool WavetableLoader::update() noexcept
+{
+    if (ready.load (std::memory_order_acquire) == nullptr)
+        return false;
+
+    // The set being replaced is handed back first; with the ring full
+    // the new one waits for a later block
+    if (current != nullptr && ! retired.push (current))
+        return false;
+
+    current = ready.exchange (nullptr, std::memory_order_acq_rel);
+    return true;
+}
+
+void WavetableLoader::queue (Request request)
+{
+    Request superseded;   // freed here, outside the lock
+
+    {
+        const juce::SpinLock::ScopedLockType lock (pendingLock);
+        superseded = std::exchange (pending, std::move (request));
+        hasPending.store (true);
+    }
+
+    if (! isThreadRunning())
+        startThread (juce::Thread::Priority::low);
+
+    notify();
+}
+
+void WavetableLoader::run()
+{
+    while (! threadShouldExit())
+    {
+        freeRetired();
+
+        if (hasPending.load())
+        {
+            Request request;
+
+            {
+                const juce::SpinLock::ScopedLockType lock (pendingLock);
+                request = std::move (pending);
+                hasPending.store (false);
+            }
+
+            // One the audio thread never took up is simply replaced
+            if (auto* set = build (request))
+                delete ready.exchange (set, std::memory_order_acq_rel);
+        }
+
+        wait (kPollMs);
+    }
+}
+
+WavetableSet* WavetableLoader::build (const Request& request)
+{
+    if (request.frameSize == 0)
+        return new WavetableSet();
+
+    std::unique_ptr<WavetableSet> set;
+
+    if (request.file == juce::File())
+    {
+        set = std::make_unique<WavetableSet> (request.frames, request.frameSize);
+    }
+    else if (std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (request.file)); reader != nullptr)
+    {
+        const auto numSamples = (int) juce::jmin (reader->lengthInSamples, (juce::int64) WavetableSet::kMaxFrames * request.frameSize);
+        juce::AudioBuffer<float> frames (1, juce::jmax (0, numSamples));
+
+        if (numSamples > 0 && reader->read (&frames, 0, numSamples, 0, true, false))
+            set = std::make_unique<WavetableSet> (frames, request.frameSize);
+    }
+
+    return set != nullptr && ! set->isEmpty() ? set.release() : nullptr;
+}
+
+void WavetableLoader::freeRetired()
+{
+    WavetableSet* set = nullptr;
+
+    while (retired.pop (set))
+        delete set;
+}
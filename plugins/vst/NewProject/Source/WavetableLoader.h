@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+    WavetableLoader.h  –  Builds WavetableSets off the audio thread
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "WavetableSet.h"
+#include "../../Shared/LockFreeRing.h"
+#include <atomic>
+
+//==============================================================================
+/** Builds WavetableSets on its own thread and hands them to the audio
+    thread, so loading even a full 256-frame table never holds up a block.
+
+    load() queues frames, or a file to decode, and wakes the thread; a load
+    queued before the last was built replaces it.  The finished set waits
+    in one atomic pointer until update() swaps it in, before the voices
+    render, so neither side ever waits for the other.  The set it replaces
+    goes back to the thread through a lock-free ring to be freed: the
+    processor publishes the new set to the voices in the same step, and a
+    voice takes up a publish before it next reads its oscillators, so by
+    then no voice is left referencing the old one.  The thread starts with
+    the first load; hosts construct plugins that never play. */
+class WavetableLoader  : private juce::Thread
+{
+public:
+    WavetableLoader() : juce::Thread ("Wavetable loader")
+    {
+        formats.registerBasicFormats();
+    }
+
+    ~WavetableLoader() override;
+
+    /** Queues frameSize-sample frames, back to back in frames' first
+        channel, to be built into the next set.  Message thread. */
+    void load (juce::AudioBuffer<float> frames, int frameSize) { queue ({ std::move (frames), {}, frameSize }); }
+
+    /** The same from an audio file's first channel, decoded on the
+        loader's thread; one that doesn't decode, or holds no whole frame,
+        leaves the current set playing.  Message thread. */
+    void load (const juce::File& file, int frameSize)           { queue ({ {}, file, frameSize }); }
+
+    /** Queues a return to the saws.  Message thread. */
+    void clear()                                                { queue ({ {}, {}, 0 }); }
+
+    /** Swaps in a newly built set, if there is one; true if it did, and
+        getCurrent() is then to be published.  Audio thread, while no voice
+        renders. */
+    bool update() noexcept;
+
+    /** The set the voices play, or nullptr for the saws.  Audio thread. */
+    const WavetableSet* getCurrent() const noexcept
+    {
+        return current != nullptr && ! current->isEmpty() ? current : nullptr;
+    }
+
+private:
+    static constexpr int kPollMs = 100;   // how often retired sets are freed, with nothing to load
+
+    struct Request
+    {
+        juce::AudioBuffer<float> frames;
+        juce::File               file;
+        int                      frameSize = 0;   // 0: back to the saws
+    };
+
+    void queue (Request request);
+    void run() override;
+    WavetableSet* build (const Request& request);
+    void freeRetired();
+
+    juce::AudioFormatManager formats;   // the loader's thread only, once constructed
+
+    juce::SpinLock    pendingLock;
+    Request           pending;                 // guarded by pendingLock
+    std::atomic<bool> hasPending { false };
+
+    std::atomic<WavetableSet*>     ready { nullptr };   // built, not yet taken up
+    WavetableSet*                  current = nullptr;   // the audio thread's
+    LockFreeRing<WavetableSet*, 8> retired;             // replaced, for the thread to free
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableLoader)
+};
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+    WavetableSet.cpp  –  WavetableSet implementation
+  ==============================================================================
+*/
+
+#include "WavetableSet.h"
+#include <algorithm>
+#include <complex>
+
+WavetableSet::WavetableSet (const juce::AudioBuffer<float>& frames, int frameSize)
+{
+    if (frameSize < 4 || ! juce::isPowerOfTwo (frameSize) || frames.getNumChannels() == 0)
+        return;
+
+    numFrames = juce::jmin (kMaxFrames, frames.getNumSamples() / frameSize);
+
+    if (numFrames == 0)
+        return;
+
+    size_t total = 0;
+
+    for (int k = 0; k < kNumLevels; ++k)
+    {
+        auto& level     = levels[(size_t) k];
+        level.harmonics = juce::jmin ((kFrameSize / 2) >> k, frameSize / 2 - 1);   // the frames' Nyquist bin is left out
+        level.size      = juce::jlimit (kMinLevelSize, kFrameSize, juce::nextPowerOfTwo (4 * level.harmonics));
+        level.offset    = total;
+        total          += (size_t) (numFrames * (level.size + 1));
+    }
+
+    samples.assign (total, 0.0f);
+
+    // Every frame's spectrum, up to the most harmonics any level keeps
+    const auto numBins = (size_t) levels[0].harmonics + 1;
+    std::vector<std::complex<float>> spectra (numBins * (size_t) numFrames);
+
+    {
+        juce::dsp::FFT     forward (juce::roundToInt (std::log2 (frameSize)));
+        std::vector<float> transform ((size_t) (2 * frameSize));
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            std::fill (transform.begin(), transform.end(), 0.0f);
+            std::copy_n (frames.getReadPointer (0, f * frameSize), frameSize, transform.begin());
+            forward.performRealOnlyForwardTransform (transform.data(), true);
+
+            const auto* bins = reinterpret_cast<const std::complex<float>*> (transform.data());
+            std::copy_n (bins, numBins, spectra.begin() + (std::ptrdiff_t) (numBins * (size_t) f));
+        }
+    }
+
+    // The inverse transform scales by 1 / size, the forward not at all
+    float peak = 0.0f;
+
+    for (int k = 0; k < kNumLevels; ++k)
+    {
+        const auto& level = levels[(size_t) k];
+        const auto  scale = (float) level.size / (float) frameSize;
+
+        juce::dsp::FFT                   inverse (juce::roundToInt (std::log2 (level.size)));
+        std::vector<std::complex<float>> transform ((size_t) level.size);
+
+        for (int f = 0; f < numFrames; ++f)
+        {
+            std::fill (transform.begin(), transform.end(), std::complex<float>());
+
+            const auto* spectrum = spectra.data() + numBins * (size_t) f;
+
+            for (int h = 1; h <= level.harmonics; ++h)
+                transform[(size_t) h] = spectrum[h] * scale;
+
+            inverse.performRealOnlyInverseTransform (reinterpret_cast<float*> (transform.data()));
+
+            auto* frame = samples.data() + level.offset + (size_t) (f * (level.size + 1));
+            std::copy_n (reinterpret_cast<const float*> (transform.data()), level.size, frame);
+            frame[level.size] = frame[0];
+
+            if (k == 0)
+                peak = juce::jmax (peak, juce::FloatVectorOperations::findMaximum (frame, level.size),
+                                        -juce::FloatVectorOperations::findMinimum (frame, level.size));
+        }
+    }
+
+    if (peak > 0.0f)
+        juce::FloatVectorOperations::multiply (samples.data(), 1.0f / peak, (int) samples.size());
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+    WavetableSet.h  –  A user wavetable's frames, band-limited at every mip level
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/** A user wavetable, band-limited for every pitch: its single-cycle frames
+    at kNumLevels mip levels, an octave apart, each keeping only the
+    harmonics that stay under Nyquist for the notes that read it.
+
+    Each frame is transformed once; every level is then an inverse
+    transform of its lowest harmonics, at the fewest samples that still
+    hold its top one four times a cycle (kFrameSize at the lowest two), so
+    a full 256-frame table is a few megabytes.  DC is removed and the whole
+    table scaled to a peak of 1, as loud as the saws.
+
+    Building allocates and transforms, so it's WavetableLoader's job; once
+    built a set is only read, a few loads and two lerps a sample. */
+class WavetableSet
+{
+public:
+    static constexpr int kFrameSize    = 2048;   // the lowest levels' size, and twice the most harmonics kept
+    static constexpr int kMaxFrames    = 256;
+    static constexpr int kNumLevels    = 11;     // 1024 harmonics down to 1
+    static constexpr int kMinLevelSize = 64;
+
+    /** Where an oscillator reads: one level of two neighbouring frames, and
+        how far it is from the first to the second. */
+    struct Cursor
+    {
+        const float* frame  = nullptr;   // size + 1 samples, the last repeating the first
+        int          stride = 0;         // to the second frame; 0 from the last
+        int          size   = 1;
+        float        mix    = 0.0f;
+    };
+
+    /** The empty set, which plays the saws. */
+    WavetableSet() = default;
+
+    /** Up to kMaxFrames single cycles of frameSize samples (a power of two)
+        back to back in frames' first channel; a partial frame at the end is
+        left out.  Any thread but the audio one. */
+    WavetableSet (const juce::AudioBuffer<float>& frames, int frameSize);
+
+    bool isEmpty()      const noexcept { return numFrames == 0; }
+    int  getNumFrames() const noexcept { return numFrames; }
+
+    /** Where an oscillator stepping `increment` cycles a sample reads, at
+        `position` (0 … 1) through the frames: the lowest level whose top
+        harmonic stays under Nyquist.  Not for the empty set. */
+    Cursor cursorFor (float increment, float position) const noexcept
+    {
+        jassert (! isEmpty());
+
+        // Level k's top harmonic is (kFrameSize / 2 >> k) times the increment
+        const auto k     = juce::jlimit (0, kNumLevels - 1,
+                                         (int) std::floor (std::log2 (juce::jmax (increment, 1.0e-7f) * (float) kFrameSize)) + 1);
+        const auto& level = levels[(size_t) k];
+        const auto x      = juce::jlimit (0.0f, 1.0f, position) * (float) (numFrames - 1);
+        const auto first  = juce::jmin ((int) x, numFrames - 1);
+
+        Cursor cursor;
+        cursor.frame  = samples.data() + level.offset + (size_t) (first * (level.size + 1));
+        cursor.stride = first < numFrames - 1 ? level.size + 1 : 0;
+        cursor.size   = level.size;
+        cursor.mix    = x - (float) first;
+        return cursor;
+    }
+
+    /** One sample at phase (0 … 1): between the cursor's samples, then
+        between its frames. */
+    static float read (const Cursor& cursor, float phase) noexcept
+    {
+        const auto x = phase * (float) cursor.size;
+        const auto i = juce::jmin ((int) x, cursor.size - 1);
+        const auto t = x - (float) i;
+
+        const auto* a = cursor.frame + i;
+        const auto* b = a + cursor.stride;
+        const auto  first  = a[0] + t * (a[1] - a[0]);
+        const auto  second = b[0] + t * (b[1] - b[0]);
+
+        return first + cursor.mix * (second - first);
+    }
+
+private:
+    struct Level
+    {
+        int    harmonics = 0;
+        int    size      = 0;
+        size_t offset    = 0;   // into samples, numFrames × (size + 1)
+    };
+
+    int                           numFrames = 0;
+    std::array<Level, kNumLevels> levels {};
+    std::vector<float>            samples;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableSet)
+};
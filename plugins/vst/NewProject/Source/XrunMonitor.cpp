@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+    XrunMonitor.cpp  –  XrunMonitor implementation
+  ==============================================================================
+*/
+
+#include "XrunMonitor.h"
+
+void XrunMonitor::beginBlock (double nowMs, int numSamples, float previousLoad) noexcept
+{
+    if (previousStartMs > 0.0)
+    {
+        if (previousLoad >= 1.0f)
+            report ({ previousStartMs, overrun, previousNumSamples, previousLoad }, numOverruns);
+
+        const auto periods = (nowMs - previousStartMs) * 0.001 * sampleRate / previousNumSamples;
+
+        if (periods > kLateFactor)
+            report ({ previousStartMs, lateCallback, previousNumSamples, (float) periods }, numLateCallbacks);
+    }
+
+    previousStartMs    = nowMs;
+    previousNumSamples = juce::jmax (1, numSamples);
+}
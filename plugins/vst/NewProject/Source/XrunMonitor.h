@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+    XrunMonitor.h  –  Counts and queues the audio callbacks that
+                      overran or came late
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../../Shared/LockFreeRing.h"
+#include <atomic>
+
+//==============================================================================
+/** Notices the audio callbacks that went wrong, for a player choosing the
+    standalone app's buffer size.
+
+    Two kinds, each found at the start of the callback after, so the one
+    that went wrong pays nothing more:
+      • an overrun: the callback took longer than the audio it carried
+        lasts (its "block" PerfProbe load reached 1), so the device ran
+        dry unless its other buffers covered for it;
+      • a late callback: the next one started more than kLateFactor of
+        those periods after it, so the driver was starved whatever the
+        synth cost (another process, power management, the driver).
+
+    Both are counted and queued for the message thread, which keeps the
+    recent ones.  Devices that count their own xruns
+    (AudioIODevice::getXRunCount()) are read alongside by the editor.  In
+    a host that stops calling between playbacks a late callback means
+    little, so only the standalone app shows them. */
+class XrunMonitor
+{
+public:
+    static constexpr double kLateFactor = 1.8;   // periods, allowing for drivers that jitter
+
+    enum Kind { overrun, lateCallback };
+
+    struct Event
+    {
+        double timeMs    = 0.0;    // Time::getMillisecondCounterHiRes() of the callback that went wrong
+        Kind   kind      = overrun;
+        int    blockSize = 0;
+        float  amount    = 0.0f;   // the load for an overrun, periods until the next callback for a late one
+    };
+
+    XrunMonitor() { events.setOverflowPolicy (LockFreeRing<Event, 64>::OverflowPolicy::overwriteOldest); }
+
+    /** Audio thread (or while it isn't running). */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        pause();
+    }
+
+    /** The next callback starts afresh, e.g. after an offline render. */
+    void pause() noexcept { previousStartMs = 0.0; }
+
+    /** Audio thread, at the start of each callback: nowMs from
+        Time::getMillisecondCounterHiRes(), previousLoad the block probe's
+        load for the callback before. */
+    void beginBlock (double nowMs, int numSamples, float previousLoad) noexcept;
+
+    /** Totals since construction.  Any thread. */
+    juce::uint64 getNumOverruns() const noexcept      { return numOverruns.load (std::memory_order_relaxed); }
+    juce::uint64 getNumLateCallbacks() const noexcept { return numLateCallbacks.load (std::memory_order_relaxed); }
+
+    /** Hands consumer (const Event*, int) the events queued since the last
+        call, oldest first; the oldest are lost once 64 wait.  One reader:
+        the message thread. */
+    template <typename Consumer>
+    void popEvents (Consumer&& consumer) { events.popAll (std::forward<Consumer> (consumer)); }
+
+private:
+    void report (const Event& event, std::atomic<juce::uint64>& counter) noexcept
+    {
+        counter.fetch_add (1, std::memory_order_relaxed);
+        events.push (event);
+    }
+
+    LockFreeRing<Event, 64>   events;
+    std::atomic<juce::uint64> numOverruns { 0 }, numLateCallbacks { 0 };
+    double                    sampleRate         = 44100.0;
+    double                    previousStartMs    = 0.0;
+    int                       previousNumSamples = 1;
+};
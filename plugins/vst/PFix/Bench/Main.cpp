@@ -0,0 +1,389 @@
+/*
+  ==============================================================================
+    Main.cpp  –  PFixBench: headless PitchDetector speed / accuracy harness
+
+    Runs PitchDetector over WAV files exactly like the live path (first
+    window with detectPitch(), then detectPitchOverlapped() every hop) for
+    every combination of the requested settings, and prints one JSON
+    document so results can be diffed between commits.  The "mpm" engine
+    runs MpmPitchDetector instead, with the same thresholds (both are on
+    YIN's scale) and without --lazy and --tracking, which are YIN's.
+
+    Usage:
+      PFixBench --wav=take.wav[,other.wav]  [--ref=take.csv[,other.csv]]
+                [--sizes=2048]  [--thresholds=0.15]  [--hops=256]
+                [--rates=native | 44100,48000]  [--engines=direct,fft,fixedSize,mpm]
+                [--lazy]  [--tracking]  [--no-voicing-gate]  [--out=results.json]
+
+    Reference CSV: one "time_seconds,f0_hz" row per line (f0 <= 0 means
+    unvoiced); blank lines, '#' comments and a non-numeric header are
+    skipped.  Each frame is compared with the reference at its window
+    centre.  Gross error = more than 20 % off; fine error = mean |cents| of
+    the remaining frames.  "unvoicedGated" is the share of frames the
+    voicing gate kept from the pitch search.
+  ==============================================================================
+*/
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "PitchDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // ── Options ──────────────────────────────────────────────────────────────
+    juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    bool parseEngine (const juce::String& name, PitchDetector::DifferenceEngine& engine)
+    {
+        if (name == "direct")    { engine = PitchDetector::DifferenceEngine::direct;    return true; }
+        if (name == "fft")       { engine = PitchDetector::DifferenceEngine::fft;       return true; }
+        if (name == "fixedSize") { engine = PitchDetector::DifferenceEngine::fixedSize; return true; }
+        if (name == "mpm")       { engine = PitchDetector::DifferenceEngine::fft;       return true; }   // its own detector
+        return false;
+    }
+
+    // ── Input ────────────────────────────────────────────────────────────────
+    struct MonoAudio
+    {
+        std::vector<float> samples;
+        double             sampleRate { 0.0 };
+    };
+
+    bool loadMono (juce::AudioFormatManager& formats, const juce::File& file, MonoAudio& out, juce::String& error)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+
+        if (reader == nullptr)
+        {
+            error = "can't read " + file.getFullPathName();
+            return false;
+        }
+
+        const auto numSamples  = static_cast<int> (reader->lengthInSamples);
+        const auto numChannels = static_cast<int> (reader->numChannels);
+
+        juce::AudioBuffer<float> buffer (numChannels, numSamples);
+        reader->read (&buffer, 0, numSamples, 0, true, true);
+
+        // Equal-weight mono mix, as in PFixAudioProcessor
+        out.samples.assign ((size_t) numSamples, 0.0f);
+        out.sampleRate = reader->sampleRate;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::addWithMultiply (out.samples.data(), buffer.getReadPointer (ch),
+                                                          1.0f / (float) numChannels, numSamples);
+        return true;
+    }
+
+    MonoAudio resampled (const MonoAudio& in, double newRate)
+    {
+        if (newRate <= 0.0 || newRate == in.sampleRate)
+            return in;
+
+        const double ratio = in.sampleRate / newRate;
+
+        MonoAudio out;
+        out.sampleRate = newRate;
+        out.samples.assign ((size_t) (static_cast<double> (in.samples.size()) / ratio), 0.0f);
+
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process (ratio, in.samples.data(), out.samples.data(), (int) out.samples.size());
+        return out;
+    }
+
+    /** Sorted (time, f0) rows; f0 <= 0 is unvoiced. */
+    using Reference = std::vector<std::pair<double, float>>;
+
+    bool loadReference (const juce::File& file, Reference& out, juce::String& error)
+    {
+        juce::StringArray lines;
+        file.readLines (lines);
+
+        for (auto line : lines)
+        {
+            line = line.trim();
+            if (line.isEmpty() || line.startsWithChar ('#'))
+                continue;
+
+            juce::StringArray fields;
+            fields.addTokens (line, ", \t;", "\"");
+            fields.removeEmptyStrings();
+
+            if (fields.size() < 2 || ! fields[0].containsOnly ("0123456789.-+eE"))
+                continue;   // header row
+
+            out.emplace_back (fields[0].getDoubleValue(), fields[1].getFloatValue());
+        }
+
+        std::sort (out.begin(), out.end());
+
+        if (out.empty())
+        {
+            error = "no reference rows in " + file.getFullPathName();
+            return false;
+        }
+
+        return true;
+    }
+
+    /** Reference f0 at time t: interpolated between two voiced rows,
+        otherwise the nearer row. */
+    float referenceAt (const Reference& ref, double t) noexcept
+    {
+        auto next = std::lower_bound (ref.begin(), ref.end(), std::make_pair (t, -1.0e30f));
+
+        if (next == ref.begin())  return next->second;
+        if (next == ref.end())    return std::prev (next)->second;
+
+        const auto& a = *std::prev (next);
+        const auto& b = *next;
+
+        if (a.second > 0.0f && b.second > 0.0f && b.first > a.first)
+            return a.second + (b.second - a.second) * static_cast<float> ((t - a.first) / (b.first - a.first));
+
+        return (t - a.first < b.first - t) ? a.second : b.second;
+    }
+
+    // ── One run ──────────────────────────────────────────────────────────────
+    struct RunConfig
+    {
+        int                             analysisSize;
+        float                           threshold;
+        int                             hop;
+        PitchDetector::DifferenceEngine engine;
+        juce::String                    engineName;
+        bool                            lazy;
+        bool                            tracking;
+        bool                            voicingGate;
+    };
+
+    void resetDetector (PitchDetector& detector)  { detector.resetTracking(); }
+    void resetDetector (MpmPitchDetector&)        {}
+
+    template <typename Detector>
+    juce::var runWith (Detector& detector, const MonoAudio& audio, const Reference* reference, const RunConfig& config)
+    {
+        const int  size      = config.analysisSize;
+        const auto numInput  = static_cast<juce::int64> (audio.samples.size());
+        const auto numFrames = numInput < size ? 0 : (numInput - size) / config.hop + 1;
+
+        std::vector<float> estimates ((size_t) numFrames, 0.0f);
+
+        const auto analyse = [&] (juce::int64 count)
+        {
+            resetDetector (detector);
+
+            for (juce::int64 f = 0; f < count; ++f)
+            {
+                const float* window = audio.samples.data() + f * config.hop;
+                estimates[(size_t) f] = (f == 0) ? detector.detectPitch (window, size, audio.sampleRate)
+                                                 : detector.detectPitchOverlapped (window, size, config.hop,
+                                                                                   audio.sampleRate);
+            }
+        };
+
+        analyse (juce::jmin (numFrames, (juce::int64) 64));   // warm caches and branch predictors
+        const auto countsBefore = detector.getCounters().getSnapshot();
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        analyse (numFrames);
+        const double seconds  = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        const auto   counts   = detector.getCounters().getSnapshot() - countsBefore;
+        const auto   perFrame = [numFrames] (juce::uint64 count) { return numFrames > 0 ? (double) count / (double) numFrames : 0.0; };
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty ("sampleRate",     audio.sampleRate);
+        run->setProperty ("analysisSize",   size);
+        run->setProperty ("threshold",      config.threshold);
+        run->setProperty ("hop",            config.hop);
+        run->setProperty ("engine",         config.engineName);
+        run->setProperty ("lazy",           config.lazy);
+        run->setProperty ("tracking",       config.tracking);
+        run->setProperty ("voicingGate",    config.voicingGate);
+        run->setProperty ("frames",         (juce::int64) numFrames);
+        run->setProperty ("nsPerFrame",     numFrames > 0 ? seconds * 1.0e9 / (double) numFrames : 0.0);
+        run->setProperty ("realtimeFactor", seconds > 0.0 ? (double) numInput / audio.sampleRate / seconds : 0.0);
+        run->setProperty ("energyGated",    perFrame (counts.energyGated));
+        run->setProperty ("unvoicedGated",  perFrame (counts.unvoicedGated));
+        run->setProperty ("lagsPerFrame",   perFrame (counts.lagsSearched));
+        run->setProperty ("trackingFallbacks",     perFrame (counts.trackingFallbacks));
+        run->setProperty ("interpolationFailures", perFrame (counts.interpolationFailures));
+
+        if (reference == nullptr)
+            return run;
+
+        // ── Accuracy against the reference ───────────────────────────────────
+        juce::int64 refVoiced = 0, refUnvoiced = 0, hits = 0, falseAlarms = 0, bothVoiced = 0, gross = 0;
+        double      fineCentsSum = 0.0;
+
+        for (juce::int64 f = 0; f < numFrames; ++f)
+        {
+            const double centre = static_cast<double> (f * config.hop + size / 2) / audio.sampleRate;
+            const float  refHz  = referenceAt (*reference, centre);
+            const float  estHz  = estimates[(size_t) f];
+
+            if (refHz <= 0.0f)
+            {
+                ++refUnvoiced;
+                falseAlarms += estHz > 0.0f ? 1 : 0;
+                continue;
+            }
+
+            ++refVoiced;
+            if (estHz <= 0.0f)
+                continue;
+
+            ++hits;
+            ++bothVoiced;
+
+            if (std::abs (estHz / refHz - 1.0f) > 0.2f)
+                ++gross;
+            else
+                fineCentsSum += std::abs (1200.0 * std::log2 ((double) estHz / (double) refHz));
+        }
+
+        const auto ratio = [] (juce::int64 num, juce::int64 den) { return den > 0 ? (double) num / (double) den : 0.0; };
+
+        auto* accuracy = new juce::DynamicObject();
+        accuracy->setProperty ("referenceVoicedFrames", (juce::int64) refVoiced);
+        accuracy->setProperty ("voicingRecall",         ratio (hits, refVoiced));
+        accuracy->setProperty ("voicingFalseAlarm",     ratio (falseAlarms, refUnvoiced));
+        accuracy->setProperty ("grossErrorRate",        ratio (gross, bothVoiced));
+        accuracy->setProperty ("fineErrorCents",        bothVoiced > gross ? fineCentsSum / (double) (bothVoiced - gross) : 0.0);
+        run->setProperty ("accuracy", accuracy);
+        return run;
+    }
+
+    juce::var runOnce (const MonoAudio& audio, const Reference* reference, RunConfig config)
+    {
+        if (config.engineName == "mpm")
+        {
+            config.lazy     = false;
+            config.tracking = false;
+
+            MpmPitchDetector detector (config.analysisSize);
+            detector.setThreshold   (config.threshold);
+            detector.setVoicingGate (config.voicingGate);
+            return runWith (detector, audio, reference, config);
+        }
+
+        PitchDetector detector (config.analysisSize);
+        detector.setDifferenceEngine (config.engine);
+        detector.setThreshold        (config.threshold);
+        detector.setLazyEvaluation   (config.lazy);
+        detector.setTracking         (config.tracking);
+        detector.setVoicingGate      (config.voicingGate);
+        return runWith (detector, audio, reference, config);
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "PFixBench: " << message << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    const auto wavPaths = splitList (args.getValueForOption ("--wav"));
+    const auto refPaths = splitList (args.getValueForOption ("--ref"));
+
+    if (wavPaths.isEmpty())
+        return fail ("usage: PFixBench --wav=a.wav[,b.wav] [--ref=a.csv,...] [--sizes=] [--thresholds=] "
+                     "[--hops=] [--rates=] [--engines=] [--lazy] [--tracking] [--no-voicing-gate] [--out=file.json]");
+
+    if (refPaths.size() > 0 && refPaths.size() != wavPaths.size())
+        return fail ("--ref needs one CSV per --wav file");
+
+    const auto sizes      = splitList (optionOr (args, "--sizes",      "2048"));
+    const auto thresholds = splitList (optionOr (args, "--thresholds", "0.15"));
+    const auto hops       = splitList (optionOr (args, "--hops",       "256"));
+    const auto rates      = splitList (optionOr (args, "--rates",      "native"));
+    const auto engines    = splitList (optionOr (args, "--engines",    "fft"));
+    const bool lazy       = args.containsOption ("--lazy");
+    const bool tracking   = args.containsOption ("--tracking");
+    const bool gated      = ! args.containsOption ("--no-voicing-gate");
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    juce::Array<juce::var> runs;
+
+    for (int i = 0; i < wavPaths.size(); ++i)
+    {
+        const auto wavFile = juce::File::getCurrentWorkingDirectory().getChildFile (wavPaths[i]);
+
+        MonoAudio    source;
+        Reference    reference;
+        juce::String error;
+
+        if (! loadMono (formats, wavFile, source, error))
+            return fail (error);
+
+        if (refPaths.size() > 0
+            && ! loadReference (juce::File::getCurrentWorkingDirectory().getChildFile (refPaths[i]), reference, error))
+            return fail (error);
+
+        for (const auto& rate : rates)
+        {
+            const auto audio = resampled (source, rate == "native" ? 0.0 : rate.getDoubleValue());
+
+            for (const auto& engineName : engines)
+            for (const auto& sizeText : sizes)
+            for (const auto& thresholdText : thresholds)
+            for (const auto& hopText : hops)
+            {
+                RunConfig config { sizeText.getIntValue(), thresholdText.getFloatValue(), hopText.getIntValue(),
+                                   PitchDetector::DifferenceEngine::fft, engineName, lazy, tracking, gated };
+
+                if (! parseEngine (engineName, config.engine))
+                    return fail ("unknown engine '" + engineName + "' (direct, fft, fixedSize or mpm)");
+
+                if (config.analysisSize < PitchDetector::kMinAnalysisSize || ! juce::isPowerOfTwo (config.analysisSize))
+                    return fail ("analysis size " + sizeText + " must be a power of two >= "
+                                 + juce::String (PitchDetector::kMinAnalysisSize));
+
+                if (config.hop <= 0)
+                    return fail ("hop must be positive");
+
+                auto run = runOnce (audio, reference.empty() ? nullptr : &reference, config);
+                run.getDynamicObject()->setProperty ("file", wavPaths[i]);
+                runs.add (run);
+            }
+        }
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool",    "PFixBench");
+    root->setProperty ("kernels", juce::String (PitchDetector().getKernelName()));
+    root->setProperty ("runs",    runs);
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+    return 0;
+}
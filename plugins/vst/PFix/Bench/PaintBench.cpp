@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+    PaintBench.cpp  –  PFixPaintBench: offscreen PitchGraphComponent paint timing
+
+    Feeds a PitchGraphComponent synthetic pitch points through a PitchStream
+    and its PitchHistory, exactly the live path, and paints it into an image
+    frame after frame at 60 frames per second of simulated time, for every
+    combination of the requested patterns, sizes, display windows and curve
+    modes.  No display or message loop is needed: the history is drained and
+    the view advanced by hand each frame.  Prints one JSON document with the
+    mean time of each paint pass and of the whole paint per run, so UI
+    changes can be compared between commits.
+
+    Patterns:
+      voiced    one channel, a held melody with vibrato, never unvoiced
+      unvoiced  the same melody broken into syllables by unvoiced gaps
+      dense     eight channels at four times the point rate, jittering
+
+    Usage:
+      PFixPaintBench  [--patterns=voiced,unvoiced,dense]  [--sizes=800x400]
+                      [--windows=8]  [--modes=scrollBlit,fullRedraw]
+                      [--frames=300]  [--out=results.json]
+
+    Each run first fills the display window (plus a second) and paints a few
+    unmeasured frames, so caches are built before the timing starts.
+  ==============================================================================
+*/
+
+#include "PitchGraphComponent.h"
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    constexpr double kFrameRate    = 60.0;
+    constexpr double kPointRate    = 48000.0 / 256.0;   // a 256-sample hop at 48 kHz
+    constexpr double kViewLatency  = 0.05;              // the right edge trails the newest point, as live
+    constexpr int    kWarmUpFrames = 10;
+
+    // ── Options ──────────────────────────────────────────────────────────────
+    juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    bool parseSize (const juce::String& text, int& width, int& height)
+    {
+        width  = text.upToFirstOccurrenceOf ("x", false, true).getIntValue();
+        height = text.fromFirstOccurrenceOf ("x", false, true).getIntValue();
+        return width > 0 && height > 0;
+    }
+
+    bool parseMode (const juce::String& name, PitchGraphComponent::CurveRendering& mode)
+    {
+        if (name == "scrollBlit") { mode = PitchGraphComponent::CurveRendering::scrollBlit; return true; }
+        if (name == "fullRedraw") { mode = PitchGraphComponent::CurveRendering::fullRedraw; return true; }
+        return false;
+    }
+
+    // ── Synthetic pitch ──────────────────────────────────────────────────────
+    enum class Pattern { voiced, unvoiced, dense };
+
+    bool parsePattern (const juce::String& name, Pattern& pattern)
+    {
+        if (name == "voiced")   { pattern = Pattern::voiced;   return true; }
+        if (name == "unvoiced") { pattern = Pattern::unvoiced; return true; }
+        if (name == "dense")    { pattern = Pattern::dense;    return true; }
+        return false;
+    }
+
+    /** Writes the pattern's points into the stream, on from where the last
+        call stopped, and drains the history before the ring could fill. */
+    class PitchFeed
+    {
+    public:
+        PitchFeed (Pattern patternToUse, PitchStream& streamToFill, PitchHistory& historyToDrain)
+            : pattern (patternToUse), stream (streamToFill), history (historyToDrain),
+              numChannels (patternToUse == Pattern::dense ? 8 : 1),
+              pointRate (patternToUse == Pattern::dense ? kPointRate * 4.0 : kPointRate)
+        {
+        }
+
+        void feedUntil (double to)
+        {
+            for (; nextIndex / pointRate < to; ++nextIndex)
+            {
+                const double t = (double) nextIndex / pointRate;
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    if (points.size() == (size_t) kChunk)
+                        flush();
+
+                    points.push_back ({ pitchAt (t, ch), ch, t });
+                }
+            }
+
+            flush();
+        }
+
+        double getPointRate() const noexcept { return pointRate; }
+
+    private:
+        // Well under the ring's capacity, so nothing is lapped between drains
+        static constexpr int kChunk = PitchStream::kCapacity / 2;
+
+        float pitchAt (double t, int channel)
+        {
+            // A note every half second, stepping around C3 – C5
+            static constexpr int melody[] = { 48, 52, 55, 60, 64, 67, 72, 67, 64, 60, 55, 52 };
+            const auto note    = (int) (t * 2.0);
+            const auto vibrato = 0.3 * std::sin (juce::MathConstants<double>::twoPi * 5.5 * t);
+
+            double midi = melody[(size_t) note % std::size (melody)] + vibrato + 2.0 * channel;
+
+            if (pattern == Pattern::unvoiced && std::fmod (t, 0.37) > 0.25)
+                return 0.0f;
+
+            if (pattern == Pattern::dense)
+                midi += 0.5 * (random.nextDouble() - 0.5);
+
+            return (float) (440.0 * std::pow (2.0, (midi - 69.0) / 12.0));
+        }
+
+        void flush()
+        {
+            if (points.empty())
+                return;
+
+            stream.pushBlock (points.data(), (int) points.size());
+            history.drainStreams();
+            points.clear();
+        }
+
+        const Pattern           pattern;
+        PitchStream&            stream;
+        PitchHistory&           history;
+        const int               numChannels;
+        const double            pointRate;
+        juce::int64             nextIndex = 0;
+        juce::Random            random { 1 };   // the same jitter every run
+        std::vector<PitchPoint> points;
+    };
+
+    // ── One run ──────────────────────────────────────────────────────────────
+    struct RunConfig
+    {
+        Pattern                             pattern;
+        juce::String                        patternName;
+        int                                 width, height;
+        float                               windowSecs;
+        PitchGraphComponent::CurveRendering mode;
+        juce::String                        modeName;
+        int                                 frames;
+    };
+
+    juce::var runOnce (const RunConfig& config, double& totalPaintMs)
+    {
+        PitchStream  stream;
+        PitchHistory history ({ &stream });
+        PitchFeed    feed (config.pattern, stream, history);
+
+        PitchGraphComponent graph (history);
+        graph.setPointRate      (feed.getPointRate());
+        graph.setDisplayWindow  (config.windowSecs);
+        graph.setCurveRendering (config.mode);
+        graph.setBounds (0, 0, config.width, config.height);
+
+        juce::Image image (juce::Image::RGB, config.width, config.height, true);
+
+        double now = (double) config.windowSecs + 1.0;
+        feed.feedUntil (now);
+
+        double backgroundMs = 0.0, spectrogramMs = 0.0, notesMs = 0.0, curvesMs = 0.0, axisMs = 0.0, hudMs = 0.0;
+        double paintMs = 0.0, maxPaintMs = 0.0;
+        juce::int64 pointsDrawn = 0;
+
+        for (int frame = -kWarmUpFrames; frame < config.frames; ++frame)
+        {
+            now += 1.0 / kFrameRate;
+            feed.feedUntil (now);
+            graph.advanceViewTo (now - kViewLatency);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            {
+                juce::Graphics g (image);
+                graph.paintEntireComponent (g, false);
+            }
+            const double ms = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+            if (frame < 0)
+                continue;
+
+            const auto& stats = graph.getLastFrameStats();
+            backgroundMs  += stats.backgroundMs;
+            spectrogramMs += stats.spectrogramMs;
+            notesMs       += stats.notesMs;
+            curvesMs      += stats.curvesMs;
+            axisMs        += stats.axisMs;
+            hudMs         += stats.hudMs;
+            pointsDrawn   += stats.pointsDrawn;
+            paintMs       += ms;
+            maxPaintMs     = juce::jmax (maxPaintMs, ms);
+        }
+
+        totalPaintMs += paintMs;
+
+        const auto perFrame = [&config] (double sum) { return config.frames > 0 ? sum / config.frames : 0.0; };
+
+        auto* passes = new juce::DynamicObject();
+        passes->setProperty ("background",  perFrame (backgroundMs));
+        passes->setProperty ("spectrogram", perFrame (spectrogramMs));
+        passes->setProperty ("notes",       perFrame (notesMs));
+        passes->setProperty ("curves",      perFrame (curvesMs));
+        passes->setProperty ("axis",        perFrame (axisMs));
+        passes->setProperty ("hud",         perFrame (hudMs));
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty ("pattern",        config.patternName);
+        run->setProperty ("width",          config.width);
+        run->setProperty ("height",         config.height);
+        run->setProperty ("windowSeconds",  config.windowSecs);
+        run->setProperty ("curveRendering", config.modeName);
+        run->setProperty ("frames",         config.frames);
+        run->setProperty ("msPerPass",      passes);
+        run->setProperty ("msPerPaint",     perFrame (paintMs));
+        run->setProperty ("maxMsPerPaint",  maxPaintMs);
+        run->setProperty ("totalPaintMs",   paintMs);
+        run->setProperty ("pointsPerPaint", perFrame ((double) pointsDrawn));
+        return run;
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "PFixPaintBench: " << message << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;   // components need a message manager
+
+    const auto patterns = splitList (optionOr (args, "--patterns", "voiced,unvoiced,dense"));
+    const auto sizes    = splitList (optionOr (args, "--sizes",    "800x400"));
+    const auto windows  = splitList (optionOr (args, "--windows",  "8"));
+    const auto modes    = splitList (optionOr (args, "--modes",    "scrollBlit,fullRedraw"));
+    const int  frames   = optionOr (args, "--frames", "300").getIntValue();
+
+    if (frames <= 0)
+        return fail ("usage: PFixPaintBench [--patterns=voiced,unvoiced,dense] [--sizes=800x400,...] "
+                     "[--windows=8,...] [--modes=scrollBlit,fullRedraw] [--frames=300] [--out=file.json]");
+
+    juce::Array<juce::var> runs;
+    double totalPaintMs = 0.0;
+
+    for (const auto& patternName : patterns)
+    for (const auto& sizeText : sizes)
+    for (const auto& windowText : windows)
+    for (const auto& modeName : modes)
+    {
+        RunConfig config { Pattern::voiced, patternName, 0, 0, windowText.getFloatValue(),
+                           PitchGraphComponent::CurveRendering::scrollBlit, modeName, frames };
+
+        if (! parsePattern (patternName, config.pattern))
+            return fail ("unknown pattern '" + patternName + "' (voiced, unvoiced or dense)");
+
+        if (! parseSize (sizeText, config.width, config.height))
+            return fail ("size '" + sizeText + "' must be WIDTHxHEIGHT");
+
+        if (config.windowSecs <= 0.0f)
+            return fail ("display window must be positive");
+
+        if (! parseMode (modeName, config.mode))
+            return fail ("unknown curve mode '" + modeName + "' (scrollBlit or fullRedraw)");
+
+        runs.add (runOnce (config, totalPaintMs));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool",         "PFixPaintBench");
+    root->setProperty ("totalPaintMs", totalPaintMs);
+    root->setProperty ("runs",         runs);
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+    return 0;
+}
@@ -0,0 +1,741 @@
+/*
+  ==============================================================================
+    QueueStress.cpp  –  PFixQueueStress: throughput, latency and correctness
+                        of the lock-free queues under contention
+
+    Runs one producer thread against one or more consumer threads, each
+    pinned to its own core, through every requested scenario:
+
+      spsc        LockFreeRing, 64-item blocks; the producer waits when it's full
+      sampleFeed  SampleFeed, 64-sample blocks; full chunks are dropped
+      midi        MidiEventFifo, one controller message at a time; the
+                  producer waits when it's full
+      broadcast   PitchStream (the pitch points' BroadcastRing), --readers
+                  readers; the producer never waits, so slow readers miss items
+      telemetry   SharedTelemetry, a Publisher and --readers Readers mapping
+                  the same region
+
+    Every item carries its sequence number and when it was sent.  The
+    consumers check that items arrive in order, that the content of each
+    is intact, and that every item was either received or counted as lost
+    by the queue itself (none may be lost where the producer waits), and
+    sample the hand-off latency of every 64th item.  Prints one JSON
+    document with items per second and p50 / p99 / max latency per
+    consumer; exits with 1 if any check failed.  The midi scenario has no
+    latency: the fifo hands out sample offsets, not timestamps.
+
+    Usage:
+      PFixQueueStress  [--scenarios=spsc,sampleFeed,midi,broadcast,telemetry]
+                       [--items=100000000]  [--readers=2]
+                       [--cores=0,1,2 | --no-pin]  [--out=results.json]
+
+    --cores lists the cores in thread order, producer first, reusing them
+    when there are more threads (default: 0, 1, 2 ...).
+
+    ThreadSanitizer: configure with -DPFIX_QUEUE_STRESS_TSAN=ON and run as
+    usual, with no suppressions; anything it reports is a bug.
+  ==============================================================================
+*/
+
+#include "../../Shared/BroadcastRing.h"
+#include "../../Shared/LockFreeRing.h"
+#include "../../Shared/MidiEventFifo.h"
+#include "../../Shared/SharedTelemetry.h"
+#include "PitchDataQueue.h"
+#include "SampleFeed.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr int kBlock = 64;   // items per push, and every kBlock-th item's latency is sampled
+
+    // ── Options ──────────────────────────────────────────────────────────────
+    juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    struct Options
+    {
+        juce::uint64     items   = 100000000;
+        int              readers = 2;
+        std::vector<int> cores;   // empty: not pinned
+
+        int coreFor (int threadIndex) const noexcept
+        {
+            return cores.empty() ? -1 : cores[(size_t) threadIndex % cores.size()];
+        }
+    };
+
+    // ── Measurement ──────────────────────────────────────────────────────────
+    juce::int64 nowTicks() noexcept { return juce::Time::getHighResolutionTicks(); }
+
+    // A PitchPoint has only its channel left for the send time: the low 31
+    // bits of the ticks, which is plenty for a hand-off (over 2 s even at
+    // nanosecond ticks)
+    constexpr juce::int64 kTicksMask = 0x7fffffff;
+
+    juce::int64 sentTicksFrom (int lowBits, juce::int64 receivedTicks) noexcept
+    {
+        return receivedTicks - ((receivedTicks - lowBits) & kTicksMask);
+    }
+
+    /** Hand-off latencies in ticks, the most recent kMaxSamples of them,
+        in storage allocated before the run. */
+    class LatencySampler
+    {
+    public:
+        static constexpr juce::uint64 kMaxSamples = 1 << 20;
+
+        LatencySampler() : samples ((size_t) kMaxSamples) {}
+
+        void add (juce::int64 sentTicks, juce::int64 receivedTicks) noexcept
+        {
+            samples[(size_t) (count++ & (kMaxSamples - 1))] = (float) (receivedTicks - sentTicks);
+        }
+
+        juce::var toVar()
+        {
+            auto* latency = new juce::DynamicObject();
+            const auto n  = (size_t) juce::jmin (count, kMaxSamples);
+            latency->setProperty ("samples", (juce::int64) count);
+
+            if (n > 0)
+            {
+                const auto toNs = [] (float ticks) { return (double) ticks * 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond(); };
+                const auto at   = [this, n] (double fraction)
+                {
+                    const auto nth = samples.begin() + (std::ptrdiff_t) juce::jmin (n - 1, (size_t) (fraction * (double) n));
+                    std::nth_element (samples.begin(), nth, samples.begin() + (std::ptrdiff_t) n);
+                    return *nth;
+                };
+
+                latency->setProperty ("p50Ns", toNs (at (0.5)));
+                latency->setProperty ("p99Ns", toNs (at (0.99)));
+                latency->setProperty ("maxNs", toNs (*std::max_element (samples.begin(), samples.begin() + (std::ptrdiff_t) n)));
+            }
+
+            return latency;
+        }
+
+    private:
+        std::vector<float> samples;
+        juce::uint64       count = 0;
+    };
+
+    struct ConsumerResult
+    {
+        juce::uint64   received = 0;
+        juce::uint64   lost     = 0;   // skipped in the sequence, which the queue must have counted
+        LatencySampler latency;
+        juce::String   error;          // the first check that failed
+
+        void fail (const juce::String& message)
+        {
+            if (error.isEmpty())
+                error = message;
+        }
+    };
+
+    // ── Threads ──────────────────────────────────────────────────────────────
+    void pinTo (int core)
+    {
+        if (core >= 0)
+            juce::Thread::setCurrentThreadAffinityMask ((juce::uint32) 1 << (core % 32));
+    }
+
+    /** Starts the producer and the consumers together, each pinned, and
+        returns the seconds until the last of them finished. */
+    double runThreads (const Options& options, std::function<void()> producer, std::vector<std::function<void()>> consumers)
+    {
+        std::atomic<bool>        go { false };
+        std::vector<std::thread> threads;
+
+        const auto start = [&] (int index, std::function<void()> body)
+        {
+            threads.emplace_back ([&go, core = options.coreFor (index), body = std::move (body)]
+            {
+                pinTo (core);
+
+                while (! go.load (std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                body();
+            });
+        };
+
+        start (0, std::move (producer));
+
+        for (size_t i = 0; i < consumers.size(); ++i)
+            start ((int) i + 1, std::move (consumers[i]));
+
+        const auto startTicks = nowTicks();
+        go.store (true, std::memory_order_release);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        return juce::Time::highResolutionTicksToSeconds (nowTicks() - startTicks);
+    }
+
+    juce::var report (const juce::String& scenario, juce::uint64 items, double seconds,
+                      std::vector<ConsumerResult>& consumers, bool withLatency, bool& allOk)
+    {
+        juce::Array<juce::var> perConsumer;
+        juce::String           error;
+
+        for (auto& result : consumers)
+        {
+            auto* consumer = new juce::DynamicObject();
+            consumer->setProperty ("received", (juce::int64) result.received);
+            consumer->setProperty ("lost",     (juce::int64) result.lost);
+
+            if (withLatency)
+                consumer->setProperty ("latency", result.latency.toVar());
+
+            perConsumer.add (consumer);
+
+            if (error.isEmpty())
+                error = result.error;
+        }
+
+        if (error.isNotEmpty())
+        {
+            allOk = false;
+            std::cerr << "PFixQueueStress: " << scenario << ": " << error << std::endl;
+        }
+
+        auto* run = new juce::DynamicObject();
+        run->setProperty ("scenario",       scenario);
+        run->setProperty ("items",          (juce::int64) items);
+        run->setProperty ("seconds",        seconds);
+        run->setProperty ("itemsPerSecond", seconds > 0.0 ? (double) items / seconds : 0.0);
+        run->setProperty ("consumers",      perConsumer);
+        run->setProperty ("ok",             error.isEmpty());
+
+        if (error.isNotEmpty())
+            run->setProperty ("error", error);
+
+        return run;
+    }
+
+    // ── spsc: LockFreeRing, lossless ─────────────────────────────────────────
+    struct Item
+    {
+        juce::uint64 sequence;
+        juce::int64  sentTicks;
+    };
+
+    juce::var runSpsc (const Options& options, bool& allOk)
+    {
+        using Ring = LockFreeRing<Item, 4096>;
+
+        auto                        ring = std::make_unique<Ring>();
+        std::atomic<bool>           done { false };
+        std::vector<ConsumerResult> results (1);
+        const auto                  total = options.items;
+
+        const auto seconds = runThreads (options, [&]
+        {
+            std::array<Item, kBlock> block;
+
+            for (juce::uint64 sequence = 0; sequence < total;)
+            {
+                const int  n     = (int) juce::jmin ((juce::uint64) kBlock, total - sequence);
+                const auto ticks = nowTicks();
+
+                for (int i = 0; i < n; ++i)
+                    block[(size_t) i] = { sequence + (juce::uint64) i, ticks };
+
+                for (int sent = 0; sent < n;)
+                {
+                    const int pushed = ring->pushBlock (block.data() + sent, n - sent);
+                    sent += pushed;
+
+                    if (pushed == 0)
+                        std::this_thread::yield();   // full: wait for the consumer
+                }
+
+                sequence += (juce::uint64) n;
+            }
+
+            done.store (true, std::memory_order_release);
+        },
+        { [&]
+        {
+            auto&        result   = results[0];
+            juce::uint64 expected = 0;
+
+            for (;;)
+            {
+                const bool finished = done.load (std::memory_order_acquire);
+                const int  n = ring->popAll ([&] (const Item* items, int num)
+                {
+                    const auto ticks = nowTicks();
+
+                    for (int i = 0; i < num; ++i)
+                    {
+                        if (items[i].sequence != expected)
+                            result.fail ("expected item " + juce::String ((juce::int64) expected)
+                                         + ", got " + juce::String ((juce::int64) items[i].sequence));
+
+                        if (items[i].sequence % kBlock == 0)
+                            result.latency.add (items[i].sentTicks, ticks);
+
+                        expected = items[i].sequence + 1;
+                    }
+                });
+
+                result.received += (juce::uint64) n;
+
+                if (n == 0)
+                {
+                    if (finished)
+                        break;
+
+                    std::this_thread::yield();
+                }
+            }
+
+            if (result.received != total)
+                result.fail (juce::String ((juce::int64) result.received) + " of " + juce::String ((juce::int64) total) + " items received");
+        } });
+
+        return report ("spsc", total, seconds, results, true, allOk);
+    }
+
+    // ── sampleFeed: SampleFeed, drops counted ────────────────────────────────
+    float sampleValue (juce::int64 index) noexcept { return (float) (index & 0xffff); }   // exact in a float
+
+    juce::var runSampleFeed (const Options& options, bool& allOk)
+    {
+        auto                        feed = std::make_unique<SampleFeed>();
+        std::atomic<bool>           done { false };
+        std::vector<ConsumerResult> results (1);
+
+        // Whole chunks only, so every drop is one full chunk
+        const auto total = (options.items + SampleChunk::kSize - 1) / SampleChunk::kSize * SampleChunk::kSize;
+
+        const auto seconds = runThreads (options, [&]
+        {
+            std::array<float, kBlock> block;
+
+            for (juce::int64 first = 0; first < (juce::int64) total; first += kBlock)
+            {
+                for (int i = 0; i < kBlock; ++i)
+                    block[(size_t) i] = sampleValue (first + i);
+
+                feed->append (block.data(), kBlock, first);
+            }
+
+            feed->flush();
+            done.store (true, std::memory_order_release);
+        },
+        { [&]
+        {
+            auto&       result   = results[0];
+            SampleChunk chunk;
+            juce::int64 expected = 0;
+
+            for (;;)
+            {
+                const bool finished = done.load (std::memory_order_acquire);
+
+                if (! feed->pop (chunk))
+                {
+                    if (finished)
+                        break;
+
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                result.latency.add (chunk.sentTicks, nowTicks());
+
+                if (chunk.firstSample < expected || (chunk.firstSample - expected) % SampleChunk::kSize != 0)
+                    result.fail ("chunk at sample " + juce::String (chunk.firstSample) + " after " + juce::String (expected));
+
+                if (chunk.numSamples != SampleChunk::kSize)
+                    result.fail ("chunk of " + juce::String (chunk.numSamples) + " samples");
+
+                for (int i = 0; i < chunk.numSamples; ++i)
+                    if (chunk.samples[(size_t) i] != sampleValue (chunk.firstSample + i))
+                        result.fail ("chunk at sample " + juce::String (chunk.firstSample) + " corrupted");
+
+                result.lost     += (juce::uint64) juce::jmax ((juce::int64) 0, chunk.firstSample - expected);
+                result.received += (juce::uint64) chunk.numSamples;
+                expected         = chunk.firstSample + chunk.numSamples;
+            }
+
+            result.lost += total - (juce::uint64) expected;
+
+            if (result.lost != (juce::uint64) feed->getNumDroppedChunks() * SampleChunk::kSize)
+                result.fail (juce::String ((juce::int64) result.lost) + " samples missing, "
+                             + juce::String (feed->getNumDroppedChunks()) + " chunks dropped");
+        } });
+
+        return report ("sampleFeed", total, seconds, results, true, allOk);
+    }
+
+    // ── midi: MidiEventFifo, lossless ────────────────────────────────────────
+    // 18 bits of sequence: channel, controller number and value
+    juce::MidiMessage midiFor (juce::uint64 sequence)
+    {
+        return juce::MidiMessage::controllerEvent (1 + (int) ((sequence >> 14) & 15), (int) ((sequence >> 7) & 127), (int) (sequence & 127));
+    }
+
+    juce::uint32 sequenceOf (const juce::MidiMessage& message) noexcept
+    {
+        return (juce::uint32) (((message.getChannel() - 1) << 14) | (message.getControllerNumber() << 7) | message.getControllerValue());
+    }
+
+    juce::var runMidi (const Options& options, bool& allOk)
+    {
+        auto                        fifo = std::make_unique<MidiEventFifo>();
+        std::atomic<bool>           done { false };
+        std::vector<ConsumerResult> results (1);
+        const auto                  total = options.items;
+
+        fifo->prepare (48000.0);
+
+        const auto seconds = runThreads (options, [&]
+        {
+            for (juce::uint64 sequence = 0; sequence < total; ++sequence)
+            {
+                const auto message = midiFor (sequence);
+
+                while (! fifo->pushNow (message))
+                    std::this_thread::yield();   // full: wait for the consumer
+            }
+
+            done.store (true, std::memory_order_release);
+        },
+        { [&]
+        {
+            auto&            result   = results[0];
+            juce::MidiBuffer buffer;
+            juce::uint64     expected = 0;
+
+            buffer.ensureSize ((size_t) MidiEventFifo::kCapacity * 8);
+
+            for (;;)
+            {
+                const bool finished = done.load (std::memory_order_acquire);
+
+                buffer.clear();
+                fifo->removeNextBlockOfMessages (buffer, 512);
+
+                if (buffer.isEmpty())
+                {
+                    if (finished)
+                        break;
+
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for (const auto metadata : buffer)
+                {
+                    const auto sequence = sequenceOf (metadata.getMessage());
+
+                    if (sequence != (juce::uint32) (expected & 0x3ffff))
+                        result.fail ("expected message " + juce::String ((juce::int64) expected)
+                                     + ", got one numbered " + juce::String ((juce::int64) sequence) + " (mod 2^18)");
+
+                    ++expected;
+                    ++result.received;
+                }
+            }
+
+            if (result.received != total)
+                result.fail (juce::String ((juce::int64) result.received) + " of " + juce::String ((juce::int64) total) + " messages received");
+        } });
+
+        return report ("midi", total, seconds, results, false, allOk);
+    }
+
+    // ── broadcast / telemetry: BroadcastRing, losses counted ─────────────────
+    /** Follows one reader's sequence: items must only move forwards, and
+        what they skip is what the reader lost. */
+    struct SequenceCheck
+    {
+        juce::uint64 expected = 0;
+
+        void next (juce::uint64 sequence, ConsumerResult& result)
+        {
+            if (sequence < expected)
+                result.fail ("item " + juce::String ((juce::int64) sequence) + " after "
+                             + juce::String ((juce::int64) expected - 1));
+
+            result.lost += sequence > expected ? sequence - expected : 0;
+            ++result.received;
+            expected = sequence + 1;
+        }
+    };
+
+    /** Checks a reader's own count of what it received and missed against
+        what the consumer saw. */
+    void checkCounts (ConsumerResult& result, juce::uint64 received, juce::uint64 missed, juce::uint64 total)
+    {
+        if (result.received != received || result.lost != missed)
+            result.fail ("reader counted " + juce::String ((juce::int64) received) + " received / "
+                         + juce::String ((juce::int64) missed) + " missed, saw "
+                         + juce::String ((juce::int64) result.received) + " / " + juce::String ((juce::int64) result.lost));
+        else if (received + missed != total)
+            result.fail (juce::String ((juce::int64) (received + missed)) + " of "
+                         + juce::String ((juce::int64) total) + " items accounted for");
+    }
+
+    juce::var runBroadcast (const Options& options, bool& allOk)
+    {
+        auto                        stream = std::make_unique<PitchStream>();
+        std::atomic<bool>           done { false };
+        std::vector<ConsumerResult> results ((size_t) options.readers);
+        const auto                  total = options.items;
+
+        std::vector<std::unique_ptr<PitchStream::Reader>> readers;
+        std::vector<std::function<void()>>                consumers;
+
+        for (int r = 0; r < options.readers; ++r)
+        {
+            readers.push_back (std::make_unique<PitchStream::Reader> (*stream));
+
+            consumers.push_back ([&, r]
+            {
+                auto&         reader = *readers[(size_t) r];
+                auto&         result = results[(size_t) r];
+                SequenceCheck check;
+
+                for (;;)
+                {
+                    const bool finished = done.load (std::memory_order_acquire);
+                    const int  n = reader.readAll ([&] (const PitchPoint* points, int num)
+                    {
+                        const auto ticks = nowTicks();
+
+                        for (int i = 0; i < num; ++i)
+                        {
+                            const auto sequence = (juce::uint64) points[i].timestamp;   // exact below 2^53
+
+                            if (points[i].pitchHz != (float) (sequence & 0xffff))
+                                result.fail ("item " + juce::String ((juce::int64) sequence) + " corrupted");
+
+                            check.next (sequence, result);
+
+                            if (sequence % kBlock == 0)
+                                result.latency.add (sentTicksFrom (points[i].channel, ticks), ticks);
+                        }
+                    });
+
+                    if (n == 0)
+                    {
+                        if (finished && reader.numBehind() == 0)
+                            break;
+
+                        std::this_thread::yield();
+                    }
+                }
+
+                checkCounts (result, reader.getStats().received, reader.getStats().missed, total);
+            });
+        }
+
+        const auto seconds = runThreads (options, [&]
+        {
+            std::array<PitchPoint, kBlock> block;
+
+            for (juce::uint64 sequence = 0; sequence < total;)
+            {
+                const int  n     = (int) juce::jmin ((juce::uint64) kBlock, total - sequence);
+                const auto ticks = (int) (nowTicks() & kTicksMask);
+
+                for (int i = 0; i < n; ++i)
+                {
+                    const auto number = sequence + (juce::uint64) i;
+                    block[(size_t) i] = { (float) (number & 0xffff), ticks, (double) number };
+                }
+
+                stream->pushBlock (block.data(), n);
+                sequence += (juce::uint64) n;
+            }
+
+            done.store (true, std::memory_order_release);
+        }, std::move (consumers));
+
+        return report ("broadcast", total, seconds, results, true, allOk);
+    }
+
+    juce::var runTelemetry (const Options& options, bool& allOk)
+    {
+        SharedTelemetry::Publisher  publisher;
+        std::atomic<bool>           done { false };
+        std::vector<ConsumerResult> results ((size_t) options.readers);
+        const auto                  total = options.items;
+
+        if (! publisher.open ("PFixQueueStress"))
+        {
+            results[0].fail ("can't create a region in " + SharedTelemetry::getDirectory().getFullPathName());
+            return report ("telemetry", total, 0.0, results, false, allOk);
+        }
+
+        std::vector<std::unique_ptr<SharedTelemetry::Reader>> readers;
+        std::vector<std::function<void()>>                    consumers;
+
+        for (int r = 0; r < options.readers; ++r)
+        {
+            readers.push_back (std::make_unique<SharedTelemetry::Reader>());
+
+            if (! readers.back()->open (publisher.getFile()))
+            {
+                results[(size_t) r].fail ("can't map " + publisher.getFile().getFullPathName());
+                return report ("telemetry", total, 0.0, results, false, allOk);
+            }
+
+            consumers.push_back ([&, r]
+            {
+                auto&         reader = *readers[(size_t) r];
+                auto&         result = results[(size_t) r];
+                SequenceCheck check;
+
+                for (;;)
+                {
+                    const bool finished = done.load (std::memory_order_acquire);
+                    const int  n = reader.readAll ([&] (const TelemetryRecord* records, int num)
+                    {
+                        const auto ticks = nowTicks();
+
+                        for (int i = 0; i < num; ++i)
+                        {
+                            const auto sequence = (juce::uint64) records[i].sourceTime;
+
+                            if (records[i].kind != TelemetryRecord::pitch || records[i].values[0] != (float) (sequence & 0xffff))
+                                result.fail ("record " + juce::String ((juce::int64) sequence) + " corrupted");
+
+                            check.next (sequence, result);
+
+                            if (sequence % kBlock == 0)
+                                result.latency.add ((juce::int64) records[i].time, ticks);
+                        }
+                    });
+
+                    if (n == 0)
+                    {
+                        if (finished && reader.numBehind() == 0)
+                            break;
+
+                        std::this_thread::yield();
+                    }
+                }
+
+                checkCounts (result, reader.getStats().received, reader.getStats().missed, total);
+            });
+        }
+
+        const auto seconds = runThreads (options, [&]
+        {
+            std::array<TelemetryRecord, kBlock> block;
+
+            for (juce::uint64 sequence = 0; sequence < total;)
+            {
+                const int  n     = (int) juce::jmin ((juce::uint64) kBlock, total - sequence);
+                const auto ticks = (double) nowTicks();
+
+                for (int i = 0; i < n; ++i)
+                {
+                    auto& record      = block[(size_t) i];
+                    const auto number = sequence + (juce::uint64) i;
+
+                    record.time       = ticks;            // ticks here, not SharedTelemetry::now()
+                    record.sourceTime = (double) number;
+                    record.kind       = TelemetryRecord::pitch;
+                    record.values[0]  = (float) (number & 0xffff);
+                }
+
+                publisher.publish (block.data(), n);
+                sequence += (juce::uint64) n;
+            }
+
+            done.store (true, std::memory_order_release);
+        }, std::move (consumers));
+
+        return report ("telemetry", total, seconds, results, true, allOk);
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "PFixQueueStress: " << message << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList args (argc, argv);
+
+    const auto scenarios = splitList (optionOr (args, "--scenarios", "spsc,sampleFeed,midi,broadcast,telemetry"));
+
+    Options options;
+    options.items   = (juce::uint64) juce::jmax ((juce::int64) 0, optionOr (args, "--items", "100000000").getLargeIntValue());
+    options.readers = optionOr (args, "--readers", "2").getIntValue();
+
+    if (options.items == 0 || options.readers <= 0)
+        return fail ("usage: PFixQueueStress [--scenarios=spsc,sampleFeed,midi,broadcast,telemetry] [--items=100000000] "
+                     "[--readers=2] [--cores=0,1,2 | --no-pin] [--out=file.json]");
+
+    if (! args.containsOption ("--no-pin"))
+    {
+        const auto cores = splitList (args.getValueForOption ("--cores"));
+
+        for (const auto& core : cores)
+            options.cores.push_back (core.getIntValue());
+
+        for (int core = 0; cores.isEmpty() && core < juce::SystemStats::getNumCpus(); ++core)
+            options.cores.push_back (core);
+    }
+
+    juce::Array<juce::var> runs;
+    bool                   allOk = true;
+
+    for (const auto& scenario : scenarios)
+    {
+        if      (scenario == "spsc")       runs.add (runSpsc       (options, allOk));
+        else if (scenario == "sampleFeed") runs.add (runSampleFeed (options, allOk));
+        else if (scenario == "midi")       runs.add (runMidi       (options, allOk));
+        else if (scenario == "broadcast")  runs.add (runBroadcast  (options, allOk));
+        else if (scenario == "telemetry")  runs.add (runTelemetry  (options, allOk));
+        else return fail ("unknown scenario '" + scenario + "' (spsc, sampleFeed, midi, broadcast or telemetry)");
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool", "PFixQueueStress");
+    root->setProperty ("ok",   allOk);
+    root->setProperty ("runs", runs);
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! juce::File::getCurrentWorkingDirectory().getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+    return allOk ? 0 : 1;
+}
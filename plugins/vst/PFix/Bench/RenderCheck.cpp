@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+    RenderCheck.cpp  –  PFixRenderCheck: golden-output and timing regression
+                        check (see Shared/RenderHarness.h)
+
+    The audio passes through, so the MIDI notes are what's compared.
+    Analysis stays on the audio thread (the default), where it's
+    deterministic, and the governor is off, so the hop never lengthens
+    under --live.
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "../../Shared/RenderHarness.h"
+
+int main (int argc, char* argv[])
+{
+    return RenderHarness::run (argc, argv, "PFix", []
+    {
+        auto processor = std::make_unique<PFixAudioProcessor>();
+        processor->getQualityGovernor().setEnabled (false);
+        return processor;
+    });
+}
@@ -0,0 +1,285 @@
+/*
+  ==============================================================================
+    FixedSizeYin.h  –  YIN specialised at compile time for size and sample type
+
+    FixedSizePitchDetector<SampleType, AnalysisSize> is a self-contained,
+    allocation-free YIN: std::array storage, constexpr loop bounds and
+    constexpr lag limits for the common host rates.  The search stops at the
+    first confirmed dip, kLagBlock lags at a time.
+
+    For float the difference and energy loops go through the hand-vectorised
+    YinKernels (auto-vectorised versions of the same loops measured 5–10x
+    slower).  For double they are portable loops with the lag as the inner
+    loop, so each lane has its own accumulator and no reduction has to be
+    reassociated.
+
+    SpecialisedPitchDetector is the type-erased facade: prepare() picks one of
+    the six instantiations (1024 / 2048 / 4096 × float / double) into a
+    std::variant, so there is no heap allocation and no virtual dispatch.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "YinKernels.h"
+#include <array>
+#include <type_traits>
+#include <variant>
+
+namespace FixedSizeYin
+{
+    /** Lag search band (same limits as PitchDetector: ~1200 Hz … ~40 Hz). */
+    struct TauRange
+    {
+        int tauMin;
+        int tauMax;
+    };
+
+    constexpr int ceilToInt (double v) noexcept
+    {
+        const int i = static_cast<int> (v);
+        return (static_cast<double> (i) < v) ? i + 1 : i;
+    }
+
+    constexpr TauRange tauRangeFor (double sampleRate, int halfSize) noexcept
+    {
+        const int longest = static_cast<int> (sampleRate / 40.0);   // floor for positive rates
+        return { ceilToInt (sampleRate / 1200.0),
+                 longest < halfSize - 2 ? longest : halfSize - 2 };
+    }
+}
+
+//==============================================================================
+template <typename SampleType, int AnalysisSize>
+class FixedSizePitchDetector
+{
+public:
+    static_assert (std::is_floating_point_v<SampleType>, "YIN needs a floating-point sample type");
+    static_assert (AnalysisSize >= 512 && (AnalysisSize & (AnalysisSize - 1)) == 0,
+                   "AnalysisSize must be a power-of-two >= 512");
+
+    static constexpr int kAnalysisSize = AnalysisSize;
+    static constexpr int kHalfSize     = AnalysisSize / 2;
+    static constexpr int kLagBlock     = 32;   // one AVX2 kernel pass
+
+    /** Returns the fundamental in Hz, or 0 when unvoiced.  The input can be
+        float or double; arithmetic is done in SampleType. */
+    template <typename InputType>
+    float detectPitch (const InputType* x, double sampleRate, float threshold,
+                       const YinKernels::Table& kernels) noexcept
+    {
+        // ── Energy gate (roughly –60 dBFS) ───────────────────────────────────
+        SampleType energy = 0;
+
+        if constexpr (usesKernels<InputType>)
+            energy = kernels.sumOfSquares (x, kAnalysisSize);
+        else
+            for (int i = 0; i < kAnalysisSize; ++i)
+                energy += static_cast<SampleType> (x[i]) * static_cast<SampleType> (x[i]);
+
+        if (energy / static_cast<SampleType> (kAnalysisSize) < static_cast<SampleType> (1e-6))
+            return 0.0f;
+
+        const auto range = tauRangeFor (sampleRate);
+        const auto thr   = static_cast<SampleType> (threshold);
+
+        // ── Steps 1–3, one lag block at a time, stopping at the first dip ───
+        yinBuf[0] = 1;
+        SampleType runningSum = 0;
+        int candidate = -1;
+
+        for (int blockStart = 0; blockStart <= range.tauMax + 1; blockStart += kLagBlock)
+        {
+            const int blockEnd = juce::jmin (blockStart + kLagBlock, kHalfSize);
+            differenceBlock (x, blockStart, blockEnd, kernels);
+
+            for (int tau = juce::jmax (1, blockStart); tau < blockEnd; ++tau)
+            {
+                runningSum += yinBuf[(size_t) tau];
+                yinBuf[(size_t) tau] = runningSum > 0 ? yinBuf[(size_t) tau] * static_cast<SampleType> (tau) / runningSum
+                                                      : SampleType (1);
+
+                // Walk to the bottom of the first dip, then one lag past it
+                // for the parabolic fit.
+                if (candidate >= 0)
+                {
+                    if (yinBuf[(size_t) tau] < yinBuf[(size_t) candidate] && tau <= range.tauMax)
+                        candidate = tau;
+                    else
+                        return pitchFromTau (candidate, sampleRate);
+                }
+                else if (tau >= range.tauMin && tau <= range.tauMax && yinBuf[(size_t) tau] < thr)
+                {
+                    candidate = tau;
+                }
+            }
+        }
+
+        return candidate >= 0 ? pitchFromTau (candidate, sampleRate) : 0.0f;
+    }
+
+    /** Lag limits, taken from a compile-time table for the common host rates. */
+    static FixedSizeYin::TauRange tauRangeFor (double sampleRate) noexcept
+    {
+        for (const auto& entry : kCommonRanges)
+            if (entry.first == sampleRate)
+                return entry.second;
+
+        return FixedSizeYin::tauRangeFor (sampleRate, kHalfSize);
+    }
+
+private:
+    template <typename InputType>
+    static constexpr bool usesKernels = std::is_same_v<SampleType, float> && std::is_same_v<InputType, float>;
+
+    using RateAndRange = std::pair<double, FixedSizeYin::TauRange>;
+
+    static constexpr std::array<RateAndRange, 6> kCommonRanges {{
+        { 22050.0,  FixedSizeYin::tauRangeFor (22050.0,  kHalfSize) },
+        { 44100.0,  FixedSizeYin::tauRangeFor (44100.0,  kHalfSize) },
+        { 48000.0,  FixedSizeYin::tauRangeFor (48000.0,  kHalfSize) },
+        { 88200.0,  FixedSizeYin::tauRangeFor (88200.0,  kHalfSize) },
+        { 96000.0,  FixedSizeYin::tauRangeFor (96000.0,  kHalfSize) },
+        { 192000.0, FixedSizeYin::tauRangeFor (192000.0, kHalfSize) },
+    }};
+
+    /** d(τ) for τ in [tauBegin, tauEnd), tauEnd − tauBegin <= kLagBlock. */
+    template <typename InputType>
+    void differenceBlock (const InputType* x, int tauBegin, int tauEnd,
+                          const YinKernels::Table& kernels) noexcept
+    {
+        if constexpr (usesKernels<InputType>)
+        {
+            kernels.difference (x, kHalfSize, tauBegin, tauEnd, yinBuf.data());
+            return;
+        }
+
+        std::array<SampleType, kLagBlock> acc {};
+
+        if (tauEnd - tauBegin == kLagBlock)
+        {
+            for (int j = 0; j < kHalfSize; ++j)
+            {
+                const auto  xj = static_cast<SampleType> (x[j]);
+                const auto* xt = x + j + tauBegin;
+
+                for (int lane = 0; lane < kLagBlock; ++lane)
+                {
+                    const SampleType delta = xj - static_cast<SampleType> (xt[lane]);
+                    acc[(size_t) lane] += delta * delta;
+                }
+            }
+        }
+        else
+        {
+            for (int j = 0; j < kHalfSize; ++j)
+            {
+                const auto xj = static_cast<SampleType> (x[j]);
+
+                for (int lane = 0; lane < tauEnd - tauBegin; ++lane)
+                {
+                    const SampleType delta = xj - static_cast<SampleType> (x[j + tauBegin + lane]);
+                    acc[(size_t) lane] += delta * delta;
+                }
+            }
+        }
+
+        for (int lane = 0; lane < tauEnd - tauBegin; ++lane)
+            yinBuf[(size_t) (tauBegin + lane)] = acc[(size_t) lane];
+    }
+
+    float pitchFromTau (int tauEst, double sampleRate) const noexcept
+    {
+        SampleType refinedTau = static_cast<SampleType> (tauEst);
+
+        // ── Step 4: Parabolic interpolation for sub-sample precision ─────────
+        if (tauEst >= 1 && tauEst < kHalfSize - 1)
+        {
+            const SampleType s0 = yinBuf[(size_t) tauEst - 1];
+            const SampleType s1 = yinBuf[(size_t) tauEst];
+            const SampleType s2 = yinBuf[(size_t) tauEst + 1];
+            const SampleType denom = s0 - 2 * s1 + s2;
+
+            if (std::abs (denom) >= static_cast<SampleType> (1e-8))
+                refinedTau += static_cast<SampleType> (0.5) * (s0 - s2) / denom;
+        }
+
+        if (refinedTau <= 0)
+            return 0.0f;
+
+        const auto pitchHz = static_cast<float> (sampleRate / static_cast<double> (refinedTau));
+        return (pitchHz >= 40.0f && pitchHz <= 2000.0f) ? pitchHz : 0.0f;
+    }
+
+    std::array<SampleType, kHalfSize> yinBuf {};   // d(τ), normalised in place to the CMNDF
+};
+
+//==============================================================================
+/**
+ * Holds whichever FixedSizePitchDetector instantiation matches the current
+ * analysis size and precision.  Lives inside PitchDetector, so it shares that
+ * object's threading rules.
+ */
+class SpecialisedPitchDetector
+{
+public:
+    enum class Precision { float32, float64 };
+
+    SpecialisedPitchDetector() : kernels (YinKernels::select()) {}
+
+    static bool supportsSize (int analysisSize) noexcept
+    {
+        return analysisSize == 1024 || analysisSize == 2048 || analysisSize == 4096;
+    }
+
+    /** Selects an instantiation.  Returns false, leaving the facade inactive,
+        for sizes without a specialisation.  Never allocates. */
+    bool prepare (int analysisSize, Precision precision) noexcept
+    {
+        const bool useDouble = precision == Precision::float64;
+
+        switch (analysisSize)
+        {
+            case 1024: if (useDouble) impl.emplace<FixedSizePitchDetector<double, 1024>>();
+                       else           impl.emplace<FixedSizePitchDetector<float,  1024>>();
+                       return true;
+            case 2048: if (useDouble) impl.emplace<FixedSizePitchDetector<double, 2048>>();
+                       else           impl.emplace<FixedSizePitchDetector<float,  2048>>();
+                       return true;
+            case 4096: if (useDouble) impl.emplace<FixedSizePitchDetector<double, 4096>>();
+                       else           impl.emplace<FixedSizePitchDetector<float,  4096>>();
+                       return true;
+            default:   impl.emplace<std::monostate>();
+                       return false;
+        }
+    }
+
+    bool isActive() const noexcept { return ! std::holds_alternative<std::monostate> (impl); }
+
+    /** Same contract as PitchDetector::detectPitch(); returns 0 when inactive. */
+    template <typename InputType>
+    float detectPitch (const InputType* samples, int numSamples,
+                       double sampleRate, float threshold) noexcept
+    {
+        return std::visit ([&] (auto& detector) -> float
+        {
+            using Detector = std::decay_t<decltype (detector)>;
+
+            if constexpr (std::is_same_v<Detector, std::monostate>)
+                return 0.0f;
+            else
+                return numSamples >= Detector::kAnalysisSize
+                           ? detector.detectPitch (samples, sampleRate, threshold, kernels)
+                           : 0.0f;
+        }, impl);
+    }
+
+private:
+    YinKernels::Table kernels;
+
+    std::variant<std::monostate,
+                 FixedSizePitchDetector<float,  1024>, FixedSizePitchDetector<double, 1024>,
+                 FixedSizePitchDetector<float,  2048>, FixedSizePitchDetector<double, 2048>,
+                 FixedSizePitchDetector<float,  4096>, FixedSizePitchDetector<double, 4096>> impl;
+};
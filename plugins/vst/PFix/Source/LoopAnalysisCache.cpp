@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+    LoopAnalysisCache.cpp  –  LoopAnalysisCache implementation
+  ==============================================================================
+*/
+
+#include "LoopAnalysisCache.h"
+#include <array>
+#include <cstring>
+
+LoopAnalysisCache::LoopAnalysisCache()
+    : slots ((size_t) kNumSlots)
+{
+}
+
+juce::uint64 LoopAnalysisCache::hashWindow (const float* samples, int numSamples) noexcept
+{
+    // FNV-1a over 32-bit words in eight independent lanes, so the loop
+    // vectorises, folded into one 64-bit hash at the end
+    constexpr int kLanes = 8;
+
+    std::array<juce::uint32, kLanes> lanes;
+    lanes.fill (0x811c9dc5u);
+
+    int i = 0;
+
+    for (; i + kLanes <= numSamples; i += kLanes)
+    {
+        std::array<juce::uint32, kLanes> bits;
+        std::memcpy (bits.data(), samples + i, sizeof (bits));
+
+        for (int lane = 0; lane < kLanes; ++lane)
+            lanes[(size_t) lane] = (lanes[(size_t) lane] ^ bits[(size_t) lane]) * 0x01000193u;
+    }
+
+    auto hash = (juce::uint64) 0xcbf29ce484222325ull ^ (juce::uint64) numSamples;
+
+    for (; i < numSamples; ++i)
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, samples + i, sizeof (bits));
+        hash = (hash ^ bits) * 0x100000001b3ull;
+    }
+
+    for (const auto lane : lanes)
+        hash = (hash ^ lane) * 0x100000001b3ull;
+
+    return hash;
+}
+
+LoopAnalysisCache::Slot& LoopAnalysisCache::slotFor (long long timelineEnd) noexcept
+{
+    // Fibonacci hashing spreads the ends, all multiples of a hop, evenly
+    const auto mixed = (juce::uint64) timelineEnd * 0x9e3779b97f4a7c15ull;
+    return slots[(size_t) (mixed >> (64 - kSlotBits))];
+}
+
+bool LoopAnalysisCache::find (long long timelineEnd, juce::uint64 hash, float& pitchHz) noexcept
+{
+    const auto& slot = slotFor (timelineEnd);
+    const bool  hit  = slot.generation == generation && slot.timelineEnd == timelineEnd && slot.hash == hash;
+
+    numLookups.store (numLookups.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (! hit)
+        return false;
+
+    numHits.store (numHits.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    pitchHz = slot.pitchHz;
+    return true;
+}
+
+void LoopAnalysisCache::store (long long timelineEnd, juce::uint64 hash, float pitchHz) noexcept
+{
+    auto& slot = slotFor (timelineEnd);
+
+    slot.timelineEnd = timelineEnd;
+    slot.hash        = hash;
+    slot.pitchHz     = pitchHz;
+    slot.generation  = generation;
+}
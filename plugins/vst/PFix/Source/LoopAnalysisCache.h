@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+    LoopAnalysisCache.h  –  Pitches of windows already analysed, by where
+                            they end on the host's timeline
+
+    A producer looping eight bars plays the same audio at the same places
+    on the timeline pass after pass, and the detector would analyse every
+    pass again.  While the host's transport runs, HopAnalyser ends its
+    windows on the timeline's multiples of the hop, so a loop's windows end
+    where they did the pass before, and looks each one up here by that
+    position and a hash of its samples: where both match, it re-emits the
+    pitch the window got last time instead of running the detector.  A
+    loop then costs a hash per window after its first pass, and its curve
+    comes out exactly as it did then.
+
+    The hash is of the window's sample bits, so anything that changes the
+    audio (an edit, a plugin before this one, a live input) misses and is
+    analysed as usual.  So does the window across the loop point the first
+    time round, which holds what played before the loop; from the second
+    repeat on it hits too.
+
+    Direct-mapped: kNumSlots windows, about 87 s at 48 kHz and the default
+    hop, though two may share a slot, and the later replaces the earlier.
+    Forgetting everything is O(1): slots carry the generation they were
+    stored in.  Allocates only when constructed; everything else is for
+    the one thread that analyses.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <vector>
+
+class LoopAnalysisCache
+{
+public:
+    static constexpr int kSlotBits = 14;
+    static constexpr int kNumSlots = 1 << kSlotBits;
+
+    LoopAnalysisCache();
+
+    /** A hash of numSamples samples' bits, cheap next to any detector. */
+    static juce::uint64 hashWindow (const float* samples, int numSamples) noexcept;
+
+    /** The pitch stored for the window ending at timelineEnd with this
+        hash, into pitchHz.  False if there isn't one. */
+    bool find (long long timelineEnd, juce::uint64 hash, float& pitchHz) noexcept;
+
+    /** Keeps pitchHz for the window ending at timelineEnd with this hash. */
+    void store (long long timelineEnd, juce::uint64 hash, float pitchHz) noexcept;
+
+    /** Forgets every window, e.g. when the detector's settings change and
+        its pitches with them. */
+    void invalidate() noexcept { ++generation; }
+
+    /** Windows looked up, and of those found, since construction.  Safe to
+        read from any thread. */
+    juce::uint64 getNumLookups() const noexcept { return numLookups.load (std::memory_order_relaxed); }
+    juce::uint64 getNumHits()    const noexcept { return numHits   .load (std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        long long    timelineEnd { -1 };
+        juce::uint64 hash        { 0 };
+        float        pitchHz     { 0.0f };
+        juce::uint32 generation  { 0 };   // never current, so an empty slot never matches
+    };
+
+    Slot& slotFor (long long timelineEnd) noexcept;
+
+    std::vector<Slot>         slots;
+    juce::uint32              generation { 1 };
+    std::atomic<juce::uint64> numLookups { 0 }, numHits { 0 };   // written by the analysing thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoopAnalysisCache)
+};
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+    MpmPolicy.cpp  –  MpmPolicy implementation
+  ==============================================================================
+*/
+
+#include "MpmPolicy.h"
+
+MpmPolicy::MpmPolicy (int size)
+{
+    prepare (size);
+}
+
+void MpmPolicy::prepare (int size)
+{
+    prepareCore (size, true);
+}
+
+float MpmPolicy::detectFrame (const float* samples, double sampleRate) noexcept
+{
+    lastClarity = 0.0f;
+
+    const int halfSize = analysisSize / 2;
+
+    int tauMin, tauMax;
+    getTauRange (sampleRate, halfSize, tauMin, tauMax);
+
+    computeNsdf (samples);
+
+    const int peak = pickKeyMaximum (tauMin, tauMax);
+    if (peak < 1)
+        return 0.0f;
+
+    // ── Clarity, then the refined lag ────────────────────────────────────────
+    const float clarity = juce::jmin (1.0f, parabolicPeak (lagBuf.data(), halfSize, peak));
+    if (1.0f - clarity > threshold)
+        return 0.0f;
+
+    const float pitchHz = pitchFromRefinedTau (parabolicInterpolation (lagBuf.data(), halfSize, peak), sampleRate);
+    if (pitchHz <= 0.0f)
+        return 0.0f;
+
+    lastClarity = clarity;
+    return pitchHz;
+}
+
+void MpmPolicy::computeNsdf (const float* samples) noexcept
+{
+    //   m'(0)   = 2·Σ x²
+    //   m'(τ+1) = m'(τ) − x[τ]² − x[W−1−τ]²
+    // The running sum is a double: it only ever shrinks, and in float the
+    // long lags would be left with mostly rounding.
+    const int    n        = analysisSize;
+    const int    halfSize = n / 2;
+    const float* r        = autocorrelateWindow (samples);
+    count (counters->lagsSearched, static_cast<juce::uint64> (halfSize));
+
+    double m = 2.0 * (knownStats != nullptr ? knownStats->energy
+                                            : static_cast<double> (kernels.sumOfSquares (samples, n)));
+
+    for (int tau = 0; tau < halfSize; ++tau)
+    {
+        lagBuf[tau] = m > 0.0 ? static_cast<float> (2.0 * static_cast<double> (r[tau]) / m) : 0.0f;
+
+        const double leaving = static_cast<double> (samples[tau]);
+        const double tail    = static_cast<double> (samples[n - 1 - tau]);
+        m -= leaving * leaving + tail * tail;
+    }
+}
+
+int MpmPolicy::pickKeyMaximum (int tauMin, int tauMax) const noexcept
+{
+    const float* nsdf = lagBuf.data();
+    const int    last = juce::jmin (tauMax + 1, static_cast<int> (lagBuf.size()) - 1);
+
+    // The lobe around τ = 0 is the frame matching itself: key maxima start
+    // after its negative-going zero crossing.
+    int start = 1;
+    while (start <= last && nsdf[start] > 0.0f)
+        ++start;
+
+    // Calls visit (tau) with each lobe's maximum, in lag order, until it
+    // returns true.  A lobe still rising at tauMax (or falling at tauMin)
+    // peaks outside the band, so it doesn't count.
+    const auto forEachKeyMaximum = [nsdf, start, last, tauMin, tauMax] (auto&& visit)
+    {
+        for (int tau = start; tau <= last;)
+        {
+            while (tau <= last && nsdf[tau] <= 0.0f)
+                ++tau;
+
+            int best = -1;
+
+            for (; tau <= last && nsdf[tau] > 0.0f; ++tau)
+                if (tau >= tauMin && tau <= tauMax && (best < 0 || nsdf[tau] > nsdf[best]))
+                    best = tau;
+
+            const bool isPeak = best >= 1 && best < last
+                             && nsdf[best] >= nsdf[best - 1] && nsdf[best] >= nsdf[best + 1];
+
+            if (isPeak && visit (best))
+                return;
+        }
+    };
+
+    float highest = 0.0f;
+    forEachKeyMaximum ([&highest, nsdf] (int tau) { highest = juce::jmax (highest, nsdf[tau]); return false; });
+
+    if (highest <= 0.0f)
+        return -1;
+
+    int chosen = -1;
+    forEachKeyMaximum ([&chosen, nsdf, cutoff = kKeyMaximumRatio * highest] (int tau)
+    {
+        if (nsdf[tau] < cutoff)
+            return false;
+
+        chosen = tau;
+        return true;
+    });
+
+    return chosen;
+}
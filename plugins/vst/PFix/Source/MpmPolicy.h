@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+    MpmPolicy.h  –  McLeod pitch method, as a BasicPitchDetector policy
+
+    McLeod, P. & Wyvill, G. (2005).  "A smarter way to find pitch."
+    Proceedings of the International Computer Music Conference, 138–141.
+
+    The normalised square difference function
+
+        n'(τ) = 2·r'(τ) / m'(τ),   m'(τ) = Σ_{j<W−τ} (x[j]² + x[j+τ]²)
+
+    is the window's type II autocorrelation scaled into [−1, 1] lag by lag,
+    so a peak's height is the frame's clarity whatever the level or the lag.
+    Each positive lobe between zero crossings gives one key maximum; the
+    pitch is the first within kKeyMaximumRatio of the highest, which avoids
+    the octave-down errors of taking the highest outright.  Every lag
+    integrates W − τ products rather than YIN's W/2, so short windows, and
+    hence low latency, lose less accuracy.
+
+    Uses MpmPitchDetector (PitchDetector.h) rather than this class directly.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PitchDetectorCore.h"
+
+class MpmPolicy  : public PitchDetectorCore
+{
+public:
+    static constexpr float kKeyMaximumRatio = 0.9f;   // McLeod's k
+
+    /** Reallocates every buffer for a new analysis size (a power of two
+        >= 512).  Not realtime-safe: call from prepareToPlay(). */
+    void prepare (int newAnalysisSize);
+
+    /** Voicing threshold on YIN's scale, so the two compare like for like:
+        the most 1 − clarity a pitched frame may have (0.05 – 0.5, default
+        0.15, i.e. clarity 0.85). */
+    void  setThreshold (float t)  noexcept { threshold = juce::jlimit (0.05f, 0.5f, t); }
+    float getThreshold ()   const noexcept { return threshold; }
+
+    /** n'(τ) at the last frame's chosen peak, 0 – 1 (0 when it was gated or
+        had no peak). */
+    float getLastClarity() const noexcept { return lastClarity; }
+
+protected:
+    explicit MpmPolicy (int analysisSize);
+
+    // ── The policy interface (see PitchDetector.h) ──────────────────────────
+    bool  gatesItself() const noexcept { return false; }
+    void  gatedFrame() noexcept        { lastClarity = 0.0f; }
+    float detectFrame (const float* samples, double sampleRate) noexcept;
+
+    /** Every frame is computed afresh: the FFT makes that cheaper than
+        sliding n'(τ) forward. */
+    float detectOverlappedFrame (const float* samples, int, double sampleRate) noexcept
+    {
+        return detectFrame (samples, sampleRate);
+    }
+
+private:
+    /** n'(τ) for τ in [0, analysisSize / 2) into lagBuf. */
+    void computeNsdf (const float* samples) noexcept;
+
+    /** The first key maximum in [tauMin, tauMax] within kKeyMaximumRatio
+        of the highest one there, or -1. */
+    int  pickKeyMaximum (int tauMin, int tauMax) const noexcept;
+
+    float threshold   { 0.15f };
+    float lastClarity { 0.0f };
+};
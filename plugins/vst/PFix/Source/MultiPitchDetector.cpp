@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+    MultiPitchDetector.cpp  –  MultiPitchDetector implementation
+  ==============================================================================
+*/
+
+#include "MultiPitchDetector.h"
+#include <cmath>
+
+namespace
+{
+    float midiToHz (float midi) noexcept { return 440.0f * std::exp2 ((midi - 69.0f) / 12.0f); }
+
+    float candidateMidi (float candidate) noexcept
+    {
+        return (float) MultiPitchDetector::kMinMidi + candidate / (float) MultiPitchDetector::kCandidatesPerSemitone;
+    }
+}
+
+MultiPitchDetector::MultiPitchDetector()
+{
+    // 1/h, normalised so a salience reads as a mean partial height
+    float sum = 0.0f;
+
+    for (int h = 0; h < kNumHarmonics; ++h)
+        sum += (harmonicWeights[(size_t) h] = 1.0f / (float) (h + 1));
+
+    for (auto& weight : harmonicWeights)
+        weight /= sum;
+}
+
+void MultiPitchDetector::prepare (double sampleRate, int frameSize)
+{
+    numBins = frameSize / 2 + 1;
+    residual.assign ((size_t) numBins, 0.0f);
+    partialBins.assign ((size_t) (kNumCandidates * kNumHarmonics), -1);
+
+    const auto binsPerHz = (double) frameSize / sampleRate;
+
+    for (int c = 0; c < kNumCandidates; ++c)
+    {
+        const auto f0 = (double) midiToHz (candidateMidi ((float) c));
+
+        for (int h = 0; h < kNumHarmonics; ++h)
+        {
+            const auto bin = (int) std::lround (f0 * (h + 1) * binsPerHz);
+
+            // Room for the bins either side
+            if (bin >= 1 && bin < numBins - 1)
+                partialBins[(size_t) (c * kNumHarmonics + h)] = bin;
+        }
+    }
+
+    reset();
+}
+
+void MultiPitchDetector::reset() noexcept
+{
+    slotHz.fill (0.0f);
+    previousSlotHz.fill (0.0f);
+}
+
+void MultiPitchDetector::process (const SpectralFrames::Frame& frame) noexcept
+{
+    std::array<float, kMaxPitches> found {};
+    int numFound = 0;
+
+    if (frame.numBins != numBins || numBins == 0)
+    {
+        jassertfalse;   // prepared for another frame size
+        track (found.data(), 0);
+        return;
+    }
+
+    // ── Whiten: what stands above the frame's mean ──────────────────────────
+    float mean = 0.0f;
+
+    for (int k = 1; k < numBins; ++k)
+        mean += frame.logMagnitudes[k];
+
+    mean /= (float) (numBins - 1);
+
+    for (int k = 0; k < numBins; ++k)
+        residual[(size_t) k] = juce::jmax (0.0f, frame.logMagnitudes[k] - mean);
+
+    taken.fill (false);
+
+    // ── Best candidate, explain its partials away, again ────────────────────
+    const int limit     = maxPitches.load (std::memory_order_relaxed);
+    float     strongest = 0.0f;
+
+    while (numFound < limit)
+    {
+        scoreCandidates();
+
+        int best = -1;
+
+        for (int c = 0; c < kNumCandidates; ++c)
+            if (! taken[(size_t) c] && (best < 0 || salience[(size_t) c] > salience[(size_t) best]))
+                best = c;
+
+        if (best < 0)
+            break;
+
+        const float score = salience[(size_t) best];
+
+        if (score < kMinSalience || score < kRelativeThreshold * strongest)
+            break;
+
+        strongest = juce::jmax (strongest, score);
+
+        // Between the neighbouring candidates, by a parabola through the three
+        float offset = 0.0f;
+
+        if (best > 0 && best < kNumCandidates - 1)
+        {
+            const float left   = salience[(size_t) (best - 1)];
+            const float right  = salience[(size_t) (best + 1)];
+            const float denom  = left - 2.0f * score + right;
+
+            if (denom < 0.0f)
+                offset = juce::jlimit (-0.5f, 0.5f, 0.5f * (left - right) / denom);
+        }
+
+        found[(size_t) numFound++] = midiToHz (candidateMidi ((float) best + offset));
+
+        for (int h = 0; h < kNumHarmonics; ++h)
+        {
+            const int bin = partialBins[(size_t) (best * kNumHarmonics + h)];
+
+            if (bin < 0)
+                break;
+
+            for (int k = bin - 1; k <= bin + 1; ++k)
+                residual[(size_t) k] *= kResidualShare;
+        }
+
+        // Its neighbours would only find the same note again
+        for (int c = juce::jmax (0, best - kCandidatesPerSemitone);
+                 c <= juce::jmin (kNumCandidates - 1, best + kCandidatesPerSemitone); ++c)
+            taken[(size_t) c] = true;
+    }
+
+    track (found.data(), numFound);
+}
+
+void MultiPitchDetector::scoreCandidates() noexcept
+{
+    const float* r = residual.data();
+
+    for (int c = 0; c < kNumCandidates; ++c)
+    {
+        const int* bins = partialBins.data() + c * kNumHarmonics;
+        float      sum  = 0.0f;
+
+        for (int h = 0; h < kNumHarmonics && bins[h] >= 0; ++h)
+        {
+            const int k = bins[h];
+            sum += harmonicWeights[(size_t) h] * juce::jmax (r[k - 1], r[k], r[k + 1]);
+        }
+
+        salience[(size_t) c] = sum;
+    }
+}
+
+void MultiPitchDetector::track (const float* pitchesHz, int numPitches) noexcept
+{
+    previousSlotHz = slotHz;
+    slotHz.fill (0.0f);
+
+    // Strongest first, each to the nearest slot that was close enough...
+    std::array<bool, kMaxPitches> placed {};
+
+    for (int p = 0; p < numPitches; ++p)
+    {
+        int   bestSlot     = -1;
+        float bestDistance = kMaxTrackSemitones;
+
+        for (int s = 0; s < kMaxPitches; ++s)
+        {
+            if (previousSlotHz[(size_t) s] <= 0.0f || slotHz[(size_t) s] > 0.0f)
+                continue;
+
+            const float distance = std::abs (12.0f * std::log2 (pitchesHz[p] / previousSlotHz[(size_t) s]));
+
+            if (distance <= bestDistance)
+            {
+                bestSlot     = s;
+                bestDistance = distance;
+            }
+        }
+
+        if (bestSlot >= 0)
+        {
+            slotHz[(size_t) bestSlot] = pitchesHz[p];
+            placed[(size_t) p]        = true;
+        }
+    }
+
+    // ...and the new notes to slots that were silent, so no curve jumps
+    for (int p = 0; p < numPitches; ++p)
+    {
+        if (placed[(size_t) p])
+            continue;
+
+        for (int s = 0; s < kMaxPitches; ++s)
+        {
+            if (previousSlotHz[(size_t) s] <= 0.0f && slotHz[(size_t) s] <= 0.0f)
+            {
+                slotHz[(size_t) s] = pitchesHz[p];
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+    MultiPitchDetector.h  –  Several simultaneous pitches from one STFT frame
+
+    YIN and McLeod follow one voice: a guitar chord or a piano's two hands
+    give them a fundamental that belongs to none of the notes.  This reads
+    the hop's SpectralFrames frame instead and finds up to kMaxPitches
+    fundamentals in it by harmonic summation (after Klapuri, "Multiple
+    fundamental frequency estimation by summing harmonic amplitudes", 2006):
+
+      • Every candidate, kCandidatesPerSemitone a semitone from kMinMidi to
+        kMaxMidi, scores the weighted sum of its first kNumHarmonics
+        partials' log magnitudes above the frame's mean (each partial the
+        strongest of three bins, so a slightly mistuned string still
+        counts).  Weights fall as 1/h, so a subharmonic of a real note,
+        which only collects its even partials, scores lower than the note.
+      • The best candidate is a pitch, refined between its neighbours by a
+        parabola; its partials are attenuated in the residual spectrum and
+        every candidate is scored again, until kMaxPitches are found or the
+        best left is under kMinSalience or kRelativeThreshold of the first.
+      • The pitches are tracked into slots: each goes to the slot whose last
+        pitch was within kMaxTrackSemitones, or else to a free one, so a
+        held note keeps its slot while others come and go.
+
+    The cost is fixed by the candidate, harmonic and pitch counts, not by
+    the input: ~kNumCandidates · kNumHarmonics · 3 reads per pass, at most
+    kMaxPitches passes a frame.  Nothing allocates after prepare().
+
+    Single-threaded: whichever thread runs the HopAnalyser owns it.  Only
+    setMaxPitches() may be called from elsewhere.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "SpectralFrames.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+class MultiPitchDetector
+{
+public:
+    static constexpr int   kMaxPitches            = 6;       // a guitar's strings
+    static constexpr int   kMinMidi               = 36;      // C2 (65 Hz)
+    static constexpr int   kMaxMidi               = 96;      // C7 (2093 Hz)
+    static constexpr int   kCandidatesPerSemitone = 3;
+    static constexpr int   kNumCandidates         = (kMaxMidi - kMinMidi) * kCandidatesPerSemitone + 1;
+    static constexpr int   kNumHarmonics          = 8;
+    static constexpr float kMinSalience           = 0.1f;    // mean partial ~-30 dB re full scale
+    static constexpr float kRelativeThreshold     = 0.5f;    // of the strongest pitch's salience
+    static constexpr float kResidualShare         = 0.2f;    // of a found pitch's partials left for the others
+    static constexpr float kMaxTrackSemitones     = 1.0f;    // further than this from a slot's pitch is another note
+
+    MultiPitchDetector();
+
+    /** Tabulates every candidate's partial bins for frames of frameSize at
+        sampleRate, and sizes the residual.  Not realtime-safe. */
+    void prepare (double sampleRate, int frameSize);
+
+    /** Forgets the tracked pitches. */
+    void reset() noexcept;
+
+    /** How many pitches a frame may yield, clamped to [1, kMaxPitches].
+        Safe to call from any thread; applies from the next frame. */
+    void setMaxPitches (int numPitches) noexcept { maxPitches.store (juce::jlimit (1, kMaxPitches, numPitches)); }
+    int  getMaxPitches () const noexcept         { return maxPitches.load(); }
+
+    /** Finds and tracks the pitches in frame, which must be of the size
+        given to prepare().  Realtime-safe. */
+    void process (const SpectralFrames::Frame& frame) noexcept;
+
+    /** Each slot's pitch in Hz after the last process(), 0 where silent. */
+    const std::array<float, kMaxPitches>& getSlots() const noexcept { return slotHz; }
+
+    /** Whether slot has anything to say about the last frame: a pitch, or
+        the end of the one it had the frame before.  Slot 0 always has, so
+        a consumer sees one point per frame even in silence. */
+    bool shouldReport (int slot) const noexcept
+    {
+        return slot == 0 || slotHz[(size_t) slot] > 0.0f || previousSlotHz[(size_t) slot] > 0.0f;
+    }
+
+private:
+    /** Every candidate's salience against the current residual. */
+    void scoreCandidates() noexcept;
+
+    /** The pitches found in this frame go into slots. */
+    void track (const float* pitchesHz, int numPitches) noexcept;
+
+    std::vector<int>   partialBins;     // kNumCandidates × kNumHarmonics, -1 past Nyquist
+    std::vector<float> residual;        // per bin: log magnitude above the frame's mean, as yet unexplained
+    std::array<float, kNumCandidates> salience {};
+    std::array<bool,  kNumCandidates> taken    {};   // within a semitone of a pitch found this frame
+    std::array<float, kNumHarmonics>  harmonicWeights {};
+    int                numBins { 0 };
+
+    std::array<float, kMaxPitches> slotHz         {};
+    std::array<float, kMaxPitches> previousSlotHz {};
+    std::atomic<int>               maxPitches     { kMaxPitches };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultiPitchDetector)
+};
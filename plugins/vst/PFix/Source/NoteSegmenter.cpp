@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+    NoteSegmenter.cpp  –  NoteSegmenter implementation
+  ==============================================================================
+*/
+
+#include "NoteSegmenter.h"
+#include <cmath>
+
+void NoteSegmenter::reset() noexcept
+{
+    numInNote   = 0;
+    numHeld     = 0;
+    unvoicedRun = 0;
+}
+
+bool NoteSegmenter::addPoint (double timestamp, float pitchHz, NoteEvent& finished) noexcept
+{
+    if (pitchHz <= 0.0f)
+    {
+        ++unvoicedRun;
+        return numInNote > 0 && unvoicedRun > kMaxGapPoints && finishNote (finished);
+    }
+
+    unvoicedRun = 0;
+
+    const HeldPoint point { timestamp, 69.0 + 12.0 * std::log2 (pitchHz / 440.0) };
+
+    if (numInNote == 0 || std::abs (point.midi - sumMidi / numInNote) <= kSplitSemitones)
+    {
+        // Back on the note: a short excursion was part of it, though too
+        // brief to count in its pitch
+        if (numHeld > 0)
+            last = juce::jmax (last, held[(size_t) numHeld - 1].timestamp);
+
+        numHeld = 0;
+
+        if (numInNote == 0)
+            startNote (&point, 1);
+        else
+            addToNote (point);
+
+        return false;
+    }
+
+    held[(size_t) numHeld++] = point;
+
+    if (numHeld < kSplitPoints)
+        return false;
+
+    // The pitch has settled elsewhere: those points are the next note
+    const auto next = held;
+    numHeld = 0;
+
+    const bool ended = finishNote (finished);
+    startNote (next.data(), kSplitPoints);
+    return ended;
+}
+
+bool NoteSegmenter::flush (NoteEvent& finished) noexcept
+{
+    return finishNote (finished);
+}
+
+bool NoteSegmenter::getOpenNote (NoteEvent& note) const noexcept
+{
+    if (numInNote == 0)
+        return false;
+
+    describeNote (note);
+    return true;
+}
+
+//==============================================================================
+void NoteSegmenter::startNote (const HeldPoint* points, int numPoints) noexcept
+{
+    double sum = 0.0;
+    for (int i = 0; i < numPoints; ++i)
+        sum += points[i].midi;
+
+    numInNote  = 0;
+    first      = points[0].timestamp;
+    sumMidi    = 0.0;
+    anchor     = sum / numPoints;
+    sumSqCents = 0.0;
+    histogram.fill (0);
+
+    for (int i = 0; i < numPoints; ++i)
+        addToNote (points[i]);
+}
+
+void NoteSegmenter::addToNote (const HeldPoint& point) noexcept
+{
+    const double cents = 100.0 * (point.midi - anchor);
+    const int    bin   = juce::jlimit (0, kNumBins - 1, kHalfBins + (int) std::lround (cents / kCentsPerBin));
+
+    ++histogram[(size_t) bin];
+    ++numInNote;
+    last        = point.timestamp;
+    sumMidi    += point.midi;
+    sumSqCents += cents * cents;
+}
+
+bool NoteSegmenter::finishNote (NoteEvent& finished) noexcept
+{
+    // The note also covers points held back since it was left
+    if (numHeld > 0)
+        last = juce::jmax (last, held[(size_t) numHeld - 1].timestamp);
+
+    numHeld = 0;
+
+    if (numInNote == 0)
+        return false;
+
+    const bool keep = last - first >= minDuration;
+
+    if (keep)
+        describeNote (finished);
+
+    numInNote = 0;
+    return keep;
+}
+
+void NoteSegmenter::describeNote (NoteEvent& note) const noexcept
+{
+    // The bin holding the middle point
+    const auto   middle = (juce::uint32) (numInNote + 1) / 2;
+    juce::uint32 seen   = 0;
+    int          median = 0;
+
+    while (median < kNumBins - 1 && (seen += histogram[(size_t) median]) < middle)
+        ++median;
+
+    const double mean       = sumMidi / numInNote;
+    const double meanCents  = 100.0 * (mean - anchor);
+
+    note.timestamp    = first;
+    note.endTimestamp = last;
+    note.midiNote     = (float) (anchor + (median - kHalfBins) * kCentsPerBin / 100.0);
+    note.meanMidi     = (float) mean;
+    note.spreadCents  = (float) std::sqrt (juce::jmax (0.0, sumSqCents / numInNote - meanCents * meanCents));
+    note.numPoints    = numInNote;
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+    NoteSegmenter.h  –  Notes out of a stream of pitch points
+
+    Turns one channel's pitch points, fed in time order, into NoteEvents:
+    where each note starts and ends, its median and mean pitch, and how
+    steadily it was held.  The rules are NoteIndex's (AutoTunes), which is
+    built on this class, so a take segments the same in the history, the
+    graph and the ARA editor:
+
+      • A voiced point within kSplitSemitones of the note's mean pitch
+        joins it; with no note, any voiced point starts one.
+      • Points further off are held back.  kSplitPoints of them end the
+        note and start the next one with them; fewer, before a point back
+        on the note, were a crack or a detection glitch, and the note
+        covers their time but not their pitch.
+      • More than kMaxGapPoints unvoiced points in a row end the note.
+
+    So a note is known kSplitPoints points, at most, after its last one,
+    and the state is fixed-size however long it runs: the median comes
+    from a histogram of kCentsPerBin bins over kHistogramSemitones either
+    side of where the note started (a glide further than that counts at
+    the edge), the mean and spread from running sums.  Nothing allocates.
+
+    Timestamps are only compared and reported, so any timeline will do:
+    the history's seconds, or NoteIndex's hop numbers.  Single-threaded;
+    one instance per channel.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+/** One segmented note. */
+struct NoteEvent
+{
+    double timestamp    { 0.0 };    ///< Its first point (on the points' own timeline)
+    double endTimestamp { 0.0 };    ///< Its last point, glitches included
+    float  midiNote     { 0.0f };   ///< Median pitch, fractional MIDI
+    float  meanMidi     { 0.0f };   ///< Mean pitch
+    float  spreadCents  { 0.0f };   ///< RMS deviation from the mean: ~5 for a held note, 30+ with vibrato
+    int    numPoints    { 0 };      ///< Points whose pitch counted
+    int    channel      { 0 };      ///< Left to the segmenter's owner
+};
+
+class NoteSegmenter
+{
+public:
+    static constexpr double kSplitSemitones     = 0.75;    // further from a note's pitch than this is another note...
+    static constexpr int    kSplitPoints        = 4;       // ...once it stays there this many points (~23 ms at 256 / 44.1 kHz)
+    static constexpr int    kMaxGapPoints       = 2;       // unvoiced points a note carries on across
+    static constexpr double kMinNoteSeconds     = 0.05;    // the default for setMinDuration()
+    static constexpr float  kHistogramSemitones = 2.0f;
+    static constexpr int    kCentsPerBin        = 2;
+
+    /** Notes shorter than this, first point to last, are dropped.  0 keeps
+        them all, for an owner with its own measure (NoteIndex counts whole
+        hops). */
+    void   setMinDuration (double duration) noexcept { minDuration = duration; }
+    double getMinDuration () const noexcept          { return minDuration; }
+
+    /** Forgets the open note and any points held back. */
+    void reset() noexcept;
+
+    /** One point (pitchHz 0 = unvoiced), no earlier than the previous one.
+        Returns true when it ended a note, which is then in `finished`; at
+        most one note ends per point. */
+    bool addPoint (double timestamp, float pitchHz, NoteEvent& finished) noexcept;
+
+    /** Ends the open note, if any: the end of a take, or a break in the
+        timeline.  True, with it in `finished`, unless there was none or it
+        was too short. */
+    bool flush (NoteEvent& finished) noexcept;
+
+    /** The note in progress, as it stands; false if there is none. */
+    bool getOpenNote (NoteEvent& note) const noexcept;
+
+private:
+    static constexpr int kHalfBins = (int) (kHistogramSemitones * 100.0f) / kCentsPerBin;
+    static constexpr int kNumBins  = 2 * kHalfBins + 1;   // anchor ± kHistogramSemitones
+
+    struct HeldPoint
+    {
+        double timestamp;
+        double midi;
+    };
+
+    void startNote (const HeldPoint* points, int numPoints) noexcept;
+    void addToNote (const HeldPoint& point) noexcept;
+    bool finishNote (NoteEvent& finished) noexcept;
+    void describeNote (NoteEvent& note) const noexcept;
+
+    double minDuration { kMinNoteSeconds };
+
+    // The note being followed
+    int                                numInNote  { 0 };     // 0 = none
+    double                             first      { 0.0 };
+    double                             last       { 0.0 };   // glitches included
+    double                             sumMidi    { 0.0 };
+    double                             anchor     { 0.0 };   // the histogram's centre
+    double                             sumSqCents { 0.0 };   // relative to the anchor
+    std::array<juce::uint32, kNumBins> histogram  {};
+
+    // Points since the pitch left it
+    std::array<HeldPoint, kSplitPoints> held    {};
+    int                                 numHeld { 0 };
+
+    int unvoicedRun { 0 };
+};
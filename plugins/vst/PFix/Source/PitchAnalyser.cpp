@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+    PitchAnalyser.cpp  –  HopAnalyser / PitchAnalysisSource implementation
+  ==============================================================================
+*/
+
+#include "PitchAnalyser.h"
+#include <utility>
+
+HopAnalyser::HopAnalyser (PitchDetector& detectorToUse, PitchStream& streamToUse, int channelIndex)
+    : homeDetector (detectorToUse), detector (&detectorToUse), stream (streamToUse), channel (channelIndex),
+      preparedSize (detectorToUse.getAnalysisSize()), publishedSize (detectorToUse.getAnalysisSize())
+{
+    homeDetector.setCounters (&detectorCounters);
+}
+
+HopAnalyser::~HopAnalyser()
+{
+    homeDetector.setCounters (nullptr);
+    delete pendingConfiguration.exchange (nullptr);
+    delete retiredConfiguration.exchange (nullptr);
+}
+
+HopAnalyser::Configuration::Configuration (const PitchDetector::Settings& settings)
+    : detector (settings.analysisSize)
+{
+    detector.applySettings (settings);
+
+    const auto size = static_cast<size_t> (detector.getAnalysisSize());
+    arena.build ([this, size] (DspArena& a)
+    {
+        ring   = a.allocate<float> (size);
+        window = a.allocate<float> (size);
+    });
+    windowStats.prepare (detector.getAnalysisSize());
+}
+
+void HopAnalyser::prepare (double sampleRate)
+{
+    // Nothing is processing: whatever was handed over can go
+    configuration.reset();
+    delete pendingConfiguration.exchange (nullptr);
+    delete retiredConfiguration.exchange (nullptr);
+    detector    = &homeDetector;
+    windowStats = &homeWindowStats;
+
+    const int size = detector->getAnalysisSize();
+
+    if (size != preparedSize)
+    {
+        const auto scaled = static_cast<long long> (requestedHop.load()) * size / preparedSize;
+        requestedHop.store (juce::jlimit (kMinHop, size, static_cast<int> (scaled)));
+        preparedSize = size;
+    }
+
+    currentSampleRate = sampleRate;
+    analysisSize      = size;
+
+    if (loopCache != nullptr)
+        loopCache->invalidate();
+
+    arena.build ([this, size] (DspArena& a)
+    {
+        analysisRing   = a.allocate<float> (static_cast<size_t> (size));
+        analysisWindow = a.allocate<float> (static_cast<size_t> (size));
+    });
+    windowStats->prepare (size);
+    publishedSize.store (size);
+    reset();
+}
+
+void HopAnalyser::offerConfiguration (std::unique_ptr<Configuration> newConfiguration)
+{
+    if (newConfiguration != nullptr)
+        newConfiguration->detector.setCounters (&detectorCounters);
+
+    // One that was never taken up is freed here, like the retired ones
+    std::unique_ptr<Configuration> superseded (pendingConfiguration.exchange (newConfiguration.release(),
+                                                                              std::memory_order_acq_rel));
+}
+
+bool HopAnalyser::reclaimConfigurations()
+{
+    std::unique_ptr<Configuration> retired (retiredConfiguration.exchange (nullptr, std::memory_order_acq_rel));
+    return pendingConfiguration.load (std::memory_order_acquire) == nullptr;
+}
+
+void HopAnalyser::takeUpConfiguration() noexcept
+{
+    // The configuration it replaces needs the retired slot
+    if (pendingConfiguration.load (std::memory_order_relaxed) == nullptr
+         || retiredConfiguration.load (std::memory_order_acquire) != nullptr)
+        return;
+
+    std::unique_ptr<Configuration> next (pendingConfiguration.exchange (nullptr, std::memory_order_acq_rel));
+
+    if (next == nullptr)
+        return;
+
+    // The newest samples, oldest first, at the start of the new ring: a
+    // smaller window is full at once, a larger one once it has filled
+    const int newSize = next->detector.getAnalysisSize();
+    const int kept    = std::min (ringNumValid, newSize);
+
+    for (int i = 0; i < kept; ++i)
+        next->ring[i] = analysisRing[(ringWritePos - kept + i) & (analysisSize - 1)];
+
+    analysisRing   = next->ring;
+    analysisWindow = next->window;
+    analysisSize   = newSize;
+    ringWritePos   = kept & (newSize - 1);
+    ringNumValid   = kept;
+    detector       = &next->detector;
+    windowStats    = &next->windowStats;
+    windowStats->invalidate();
+    publishedSize.store (newSize, std::memory_order_relaxed);
+
+    // The cached pitches were the old detector's
+    if (loopCache != nullptr)
+        loopCache->invalidate();
+
+    retiredConfiguration.store (configuration.release(), std::memory_order_release);
+    configuration = std::move (next);
+}
+
+void HopAnalyser::reset() noexcept
+{
+    ringWritePos          = 0;
+    ringNumValid          = 0;
+    samplesSinceLastFrame = 0;
+    samplesSinceDetection = 0;
+    detectorSkipped       = false;
+    windowStats->invalidate();   // recounted once the ring has refilled
+
+    if (multiPitchDetector != nullptr)
+        multiPitchDetector->reset();
+}
+
+void HopAnalyser::process (const float* mono, int numSamples, long long firstSample, long long timelineSample) noexcept
+{
+    // A window is analysed every `hop` samples, so consecutive windows overlap
+    // by analysisSize − hop samples and we get one PitchPoint per hop.  The
+    // input is copied into the ring in spans that end at the next analysis
+    // point or the ring's wrap, whichever comes first.
+    takeUpConfiguration();
+
+    if (idle.load (std::memory_order_relaxed))
+    {
+        keepWarm (mono, numSamples);
+        return;
+    }
+
+    const int size = analysisSize;
+    const int hop  = juce::jlimit (kMinHop, size, hopSource->load (std::memory_order_relaxed)
+                                                    / hopDivisor.load (std::memory_order_relaxed)
+                                                    * hopMultiplier.load (std::memory_order_relaxed));
+
+    // On the timeline, a window ends wherever the timeline is a multiple
+    // of the hop, so each pass of a loop ends its windows where the last
+    // did.  Contiguous calls are on the grid already; this moves the hops
+    // onto it after a jump (a loop's return) or a change of hop.
+    const bool onTimeline = loopCache != nullptr && timelineSample >= 0 && multiPitchDetector == nullptr;
+
+    if (onTimeline)
+        samplesSinceLastFrame = static_cast<int> ((timelineSample % hop + hop) % hop);
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        const int untilFrame = juce::jmax (1, hop - samplesSinceLastFrame, size - ringNumValid);
+        const int n          = juce::jmin (numSamples - pos, untilFrame, size - ringWritePos);
+
+        if (ringNumValid == size)
+            windowStats->update (analysisRing, ringWritePos, mono + pos, n);
+
+        juce::FloatVectorOperations::copy (analysisRing + ringWritePos, mono + pos, n);
+        ringWritePos = (ringWritePos + n) & (size - 1);
+        ringNumValid = std::min (ringNumValid + n, size);
+        samplesSinceLastFrame += n;
+        samplesSinceDetection = std::min (samplesSinceDetection + n, size);   // no overlap past a window
+        pos += n;
+
+        if (samplesSinceLastFrame >= hop && ringNumValid == size)
+        {
+            unwrapCurrentWindow();
+
+            // Timestamp = position of the last sample in this window
+            const double timestamp =
+                static_cast<double> (firstSample + pos)
+                / currentSampleRate;
+
+            const bool framed = spectralFrames != nullptr && spectralFrames->getFrameSize() == size;
+
+            if (multiPitchDetector != nullptr && framed)
+            {
+                analysePitchesInWindow (firstSample + pos, timestamp);
+            }
+            else
+            {
+                // ── Run YIN on the window ending at this sample ──────────
+                const float pitchHz = analyseCurrentWindow (onTimeline ? timelineSample + pos : -1);
+                pendingPoints[(size_t) numPendingPoints++] = { pitchHz, channel, timestamp };
+
+                // The window is still unwrapped: the STFT reads it where it is
+                if (framed)
+                    spectralFrames->addFrame (analysisWindow, firstSample + pos);
+            }
+
+            samplesSinceLastFrame = 0;
+
+            // Room for the next hop's points, however many pitches it finds
+            if (numPendingPoints > kMaxPendingPoints - MultiPitchDetector::kMaxPitches)
+                flushPending();
+        }
+    }
+
+    flushPending();
+}
+
+void HopAnalyser::keepWarm (const float* mono, int numSamples) noexcept
+{
+    // Anything older than a window would be overwritten before it's read
+    const int size = analysisSize;
+
+    for (int pos = std::max (0, numSamples - size); pos < numSamples;)
+    {
+        const int n = std::min (numSamples - pos, size - ringWritePos);
+        juce::FloatVectorOperations::copy (analysisRing + ringWritePos, mono + pos, n);
+        ringWritePos = (ringWritePos + n) & (size - 1);
+        pos += n;
+    }
+
+    // A hop is due as soon as analysis resumes, and the detector starts
+    // afresh; the running stats are recounted then too
+    ringNumValid          = std::min (ringNumValid          + numSamples, size);
+    samplesSinceLastFrame = std::min (samplesSinceLastFrame + numSamples, size);
+    samplesSinceDetection = std::min (samplesSinceDetection + numSamples, size);
+    windowStats->invalidate();
+}
+
+void HopAnalyser::flushPending() noexcept
+{
+    if (numPendingPoints > 0)
+        stream.pushBlock (pendingPoints.data(), numPendingPoints);   // once, whoever reads it
+
+    numPendingPoints = 0;
+}
+
+void HopAnalyser::unwrapCurrentWindow() noexcept
+{
+    // ringWritePos is the oldest sample once the ring is full: unwrap it
+    // into one contiguous window for the detector.
+    const int tailLen = analysisSize - ringWritePos;
+    juce::FloatVectorOperations::copy (analysisWindow,
+                                       analysisRing + ringWritePos, tailLen);
+    juce::FloatVectorOperations::copy (analysisWindow + tailLen,
+                                       analysisRing, ringWritePos);
+
+    lastWindowStats = windowStats->snapshot (analysisRing, ringWritePos);
+}
+
+float HopAnalyser::analyseCurrentWindow (long long timelineEnd) noexcept
+{
+    // Same place on the timeline and the same samples: the same pitch
+    const bool   cacheable = timelineEnd >= 0;
+    juce::uint64 hash      = 0;
+
+    if (cacheable)
+    {
+        hash = LoopAnalysisCache::hashWindow (analysisWindow, analysisSize);
+
+        if (float pitchHz; loopCache->find (timelineEnd, hash, pitchHz))
+        {
+            detectorSkipped = true;
+            return pitchHz;
+        }
+    }
+
+    // Its track is from before the windows the cache answered for
+    if (std::exchange (detectorSkipped, false))
+        detector->resetTracking();
+
+    // The real distance from its last window, which may be several hops,
+    // so it only slides its sums forward where that's still valid
+    const float pitchHz = detector->detectPitchOverlapped (analysisWindow, analysisSize,
+                                                           samplesSinceDetection, currentSampleRate, &lastWindowStats);
+    samplesSinceDetection = 0;
+
+    if (cacheable)
+        loopCache->store (timelineEnd, hash, pitchHz);
+
+    return pitchHz;
+}
+
+void HopAnalyser::analysePitchesInWindow (long long endSample, double timestamp) noexcept
+{
+    spectralFrames->addFrame (analysisWindow, endSample);
+
+    // Our own frame, just written on this thread: the read can't be torn
+    spectralFrames->read (spectralFrames->getLatestIndex(), [this] (const SpectralFrames::Frame& frame)
+    {
+        multiPitchDetector->process (frame);
+    });
+
+    const auto& slots = multiPitchDetector->getSlots();
+
+    for (int slot = 0; slot < MultiPitchDetector::kMaxPitches; ++slot)
+        if (multiPitchDetector->shouldReport (slot))
+            pendingPoints[(size_t) numPendingPoints++] = { slots[(size_t) slot], slot, timestamp };
+}
+
+//==============================================================================
+PitchAnalysisSource::PitchAnalysisSource (HopAnalyser& analyserToDrive, SampleFeed& feedToDrain)
+{
+    addLane (analyserToDrive, feedToDrain);
+}
+
+void PitchAnalysisSource::addLane (HopAnalyser& analyserToDrive, SampleFeed& feedToDrain)
+{
+    lanes.push_back ({ &analyserToDrive, &feedToDrain, -1 });
+}
+
+void PitchAnalysisSource::reset() noexcept
+{
+    for (auto& lane : lanes)
+    {
+        lane.expectedSample = -1;
+        lane.holding        = false;
+    }
+}
+
+juce::int64 PitchAnalysisSource::getDeadline()
+{
+    auto deadline = kNothingDue;
+
+    for (size_t i = 0; i < lanes.size(); ++i)
+    {
+        auto& lane = lanes[i];
+
+        if (! lane.holding)
+            lane.holding = lane.feed->pop (lane.chunk);
+
+        if (lane.holding && lane.chunk.sentTicks < deadline)
+        {
+            deadline = lane.chunk.sentTicks;
+            dueLane  = i;
+        }
+    }
+
+    return deadline;
+}
+
+void PitchAnalysisSource::runSlice()
+{
+    auto& lane  = lanes[dueLane];
+    auto& chunk = lane.chunk;
+    jassert (lane.holding);
+
+    // A dropped chunk (feed overflow) or a jump in the input breaks the
+    // ring's continuity: start the history again rather than analysing a
+    // window spliced from two unrelated runs.
+    if (chunk.firstSample != lane.expectedSample)
+        lane.analyser->reset();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    {
+        TRACE_SCOPE ("yin");
+        lane.analyser->process (chunk.samples.data(), chunk.numSamples, chunk.firstSample, chunk.timelineSample);
+    }
+
+    if (perfProbe != nullptr)
+        perfProbe->record (perfScope, juce::Time::getHighResolutionTicks() - startTicks,
+                           chunk.numSamples);
+
+    lane.expectedSample = chunk.firstSample + chunk.numSamples;
+    lane.holding        = false;
+}
@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+    PitchAnalyser.h  –  Hop-based pitch analysis, inline or on the shared
+                        analysis pool
+
+    HopAnalyser keeps a sliding ring of mono history and runs PitchDetector on
+    an overlapping window every `hop` samples, pushing one PitchPoint per hop
+    (or, with a MultiPitchDetector, one per sounding pitch).  Given the
+    host's timeline and a LoopAnalysisCache, windows end on the timeline's
+    multiples of the hop, and one a loop has played before is looked up
+    rather than analysed again.  Idle (nobody wants the points), it only
+    keeps the ring filled, so the first window after it wakes is analysed
+    at once.
+    The window's energy figures are kept running on the ring (see
+    WindowStats.h) and handed to the detector with it.
+    It is single-threaded: whichever thread calls process() owns it.  The
+    detector can still be replaced while it runs: a Configuration built on
+    the message thread is taken up at the next process() call through an
+    atomic pointer, and the one it replaced goes back the same way to be
+    freed there.
+
+    PitchAnalysisSource drives one or more HopAnalysers, each from its own
+    SampleFeed, on the process-wide AnalysisWorkerPool, so that the audio
+    thread only copies samples and never pays for YIN itself.  In the
+    per-channel mode several sources split the channels between them.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "PitchDetector.h"
+#include "MultiPitchDetector.h"
+#include "LoopAnalysisCache.h"
+#include "PitchDataQueue.h"
+#include "SampleFeed.h"
+#include "SpectralFrames.h"
+#include "WindowStats.h"
+#include "../../Shared/AnalysisWorkerPool.h"
+#include "../../Shared/DspArena.h"
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/TraceEvents.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class HopAnalyser
+{
+public:
+    static constexpr int kDefaultHop = 256;   // ~5.8 ms at 44100 Hz → 8x overlap
+    static constexpr int kMinHop     = 32;
+
+    /** @param channelIndex  Written into every PitchPoint this analyser pushes. */
+    HopAnalyser (PitchDetector& detectorToUse, PitchStream& streamToUse, int channelIndex = 0);
+    ~HopAnalyser();
+
+    /** Allocates the ring for the detector's (current) analysis size.  When
+        that size has changed since the last call, the hop is scaled with it
+        so the overlap factor, and hence the cost per second, stays the same.
+        Any Configuration handed over is dropped, and the detector given to
+        the constructor analyses again.  Not realtime-safe. */
+    void prepare (double sampleRate);
+
+    /** A detector configured and prepared off the analysing thread, with
+        the ring and window for its analysis size: everything a change of
+        the detector's settings would otherwise allocate. */
+    struct Configuration
+    {
+        /** Not realtime-safe. */
+        explicit Configuration (const PitchDetector::Settings& settings);
+
+        PitchDetector      detector;
+        DspArena           arena;               // ring and window
+        float*             ring   { nullptr };
+        float*             window { nullptr };
+        RunningWindowStats windowStats;
+
+        JUCE_DECLARE_NON_COPYABLE (Configuration)
+    };
+
+    /** Has the thread that runs process() analyse with configuration from
+        its next call, keeping the newest samples it holds so the curve
+        carries on (after a gap while a larger window fills).  A
+        configuration not yet taken up is replaced.  Message thread. */
+    void offerConfiguration (std::unique_ptr<Configuration> configuration);
+
+    /** Frees the configuration the last one taken up replaced.  False while
+        one is still waiting to be taken up.  Message thread. */
+    bool reclaimConfigurations();
+
+    /** The analysis size in use.  Safe to call from any thread. */
+    int getAnalysisSize() const noexcept { return publishedSize.load (std::memory_order_relaxed); }
+
+    /** Forgets all history, e.g. after a gap in the input. */
+    void reset() noexcept;
+
+    /** Feeds mono samples that start at absolute index firstSample.  Every
+        completed hop analyses the window ending at that sample and pushes the
+        result, timestamped at that sample, into the stream.  timelineSample
+        is where the first sample plays on the host's timeline while its
+        transport runs, or -1; with a loop cache it puts the hops on the
+        timeline's grid. */
+    void process (const float* mono, int numSamples, long long firstSample, long long timelineSample = -1) noexcept;
+
+    /** Clamped to [kMinHop, analysis size].  Safe to call from any thread;
+        takes effect at the next window boundary. */
+    void setHop (int hopSamples) noexcept
+    {
+        requestedHop.store (juce::jlimit (kMinHop, getAnalysisSize(), hopSamples));
+    }
+    int  getHop () const noexcept { return hopSource->load(); }
+
+    /** Analyses every hop / divisor samples instead (still at least
+        kMinHop), e.g. for a denser curve in offline renders, leaving the
+        hop itself alone.  Safe to call from any thread; takes effect at the
+        next window boundary. */
+    void setHopDivisor (int divisor) noexcept { hopDivisor.store (juce::jmax (1, divisor)); }
+
+    /** Idle, process() only keeps the newest window's samples in the ring:
+        no detector, no points, no frames.  Safe to call from any thread;
+        takes effect at the next process() call. */
+    void setIdle (bool shouldBeIdle) noexcept { idle.store (shouldBeIdle, std::memory_order_relaxed); }
+    bool isIdle () const noexcept             { return idle.load (std::memory_order_relaxed); }
+
+    /** Analyses every hop × multiplier samples instead (at most the
+        analysis size), e.g. to shed load when a QualityGovernor asks.
+        Applies after the divisor.  Same threading as setHopDivisor(). */
+    void setHopMultiplier (int multiplier) noexcept { hopMultiplier.store (juce::jmax (1, multiplier)); }
+
+    /** Makes this analyser follow leader's hop instead of its own, so one
+        setHop() call retunes every channel.  Call before processing starts;
+        the leader must outlive this object. */
+    void followHopOf (const HopAnalyser& leader) noexcept { hopSource = &leader.requestedHop; }
+
+    /** Also transforms every analysed window into frames, stamped like the
+        points (see SpectralFrames).  Call before processing starts; the
+        frames must outlive this object (nullptr to stop) and be prepared for
+        the detector's analysis size. */
+    void setSpectralFrames (SpectralFrames* framesToFill) noexcept { spectralFrames = framesToFill; }
+
+    /** Finds every pitch in each hop's frame with multiPitch instead of
+        running the detector, and pushes a point per slot it reports, with
+        the slot as the point's channel.  Needs the spectral frames, since
+        that's where it reads the hop.  Call before processing starts; the
+        detector must outlive this object (nullptr for the single pitch). */
+    void setMultiPitchDetector (MultiPitchDetector* multiPitch) noexcept { multiPitchDetector = multiPitch; }
+
+    /** Looks up every window process() is given a timeline for in cache
+        before running the detector on it, and keeps what the detector finds
+        there (see LoopAnalysisCache); not with a MultiPitchDetector.  Call
+        before processing starts; the cache must outlive this object
+        (nullptr to stop), and is invalidated whenever the detector changes. */
+    void setLoopCache (LoopAnalysisCache* cacheToUse) noexcept { loopCache = cacheToUse; }
+
+    int  getChannel() const noexcept { return channel; }
+
+    /** What every detector this analyser has run counted, the
+        configurations' included (see PitchDetectorCore::Counters); the
+        polyphonic path runs none.  Safe to read from any thread. */
+    const PitchDetectorCore::Counters& getDetectorCounters() const noexcept { return detectorCounters; }
+
+    /** Sum, energy, peak etc. of the last window analysed.  Same thread as
+        process(). */
+    const WindowStats& getLastWindowStats() const noexcept { return lastWindowStats; }
+
+private:
+    /** Switches to a configuration offerConfiguration() left, if the last
+        one replaced has been freed. */
+    void takeUpConfiguration() noexcept;
+
+    /** process() while idle: the newest samples into the ring, and the
+        counts moved on as if the hops had been analysed. */
+    void keepWarm (const float* mono, int numSamples) noexcept;
+
+    /** Copies the ring into analysisWindow, oldest sample first, and takes
+        its stats. */
+    void unwrapCurrentWindow() noexcept;
+
+    /** Runs the detector on the unwrapped window, or takes its pitch from
+        the loop cache when it ends at timelineEnd (-1 for nowhere). */
+    float analyseCurrentWindow (long long timelineEnd) noexcept;
+
+    /** Frames the unwrapped window and queues a point per reported slot. */
+    void analysePitchesInWindow (long long endSample, double timestamp) noexcept;
+
+    /** Hands the points gathered so far to the stream in one pushBlock(). */
+    void flushPending() noexcept;
+
+    static constexpr int kMaxPendingPoints = 32;
+
+    PitchDetector&     homeDetector;             // the constructor's, set up by the caller
+    PitchDetector*     detector;                 // that or the configuration's
+    PitchStream&       stream;                   // every consumer reads it through its own cursor
+    SpectralFrames*    spectralFrames { nullptr };
+    MultiPitchDetector* multiPitchDetector { nullptr };
+    LoopAnalysisCache* loopCache      { nullptr };
+    const int          channel;
+
+    std::array<PitchPoint, kMaxPendingPoints> pendingPoints;   // this process() call's results
+    int                                       numPendingPoints { 0 };
+
+    DspArena           arena;                    // analysisRing and analysisWindow, built in prepare()
+    float*             analysisRing   { nullptr };   // circular mono history, analysisSize long
+    float*             analysisWindow { nullptr };   // ring unwrapped oldest → newest for the detector
+    int                analysisSize   { 0 };
+    RunningWindowStats homeWindowStats;
+    RunningWindowStats* windowStats { &homeWindowStats };   // of the ring, once it's full
+    WindowStats        lastWindowStats;
+    int                ringWritePos          { 0 };
+    int                ringNumValid          { 0 };  // saturates at the analysis size
+    int                samplesSinceLastFrame { 0 };  // or since the hop's grid point on the timeline
+    int                samplesSinceDetection { 0 };  // since the detector's last window, for its overlap
+    bool               detectorSkipped       { false };  // the cache has answered since the detector ran
+    double             currentSampleRate     { 44100.0 };
+    int                preparedSize;                 // analysis size the hop was chosen for
+
+    std::atomic<int>        requestedHop { kDefaultHop };
+    const std::atomic<int>* hopSource    { &requestedHop };   // this or a leader's requestedHop
+    std::atomic<int>        hopDivisor    { 1 };
+    std::atomic<int>        hopMultiplier { 1 };
+    std::atomic<bool>       idle          { false };
+    std::atomic<int>        publishedSize { 0 };
+
+    PitchDetectorCore::Counters detectorCounters;   // written by the analysing thread
+
+    // In use by the analysing thread; handed over by the message thread;
+    // replaced, waiting for the message thread to free it
+    std::unique_ptr<Configuration> configuration;
+    std::atomic<Configuration*>    pendingConfiguration { nullptr };
+    std::atomic<Configuration*>    retiredConfiguration { nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HopAnalyser)
+};
+
+//==============================================================================
+/**
+ * Owns the consumer side of one or more SampleFeeds, for the analysis pool.
+ * The pool polls it (the audio thread never signals, since waking a thread
+ * isn't realtime-safe); each slice forwards one chunk to the matching
+ * HopAnalyser, restarting the analyser's history whenever a chunk doesn't
+ * follow on from the previous one.
+ *
+ * The oldest chunk waiting in any of its feeds goes first, so one busy
+ * channel can't starve the others in the same source.  Its lanes share one
+ * thread at a time, so they may share a PitchStream.
+ */
+class PitchAnalysisSource  : public AnalysisWorkerPool::Source
+{
+public:
+    /** A source with no lanes yet; add them with addLane(). */
+    PitchAnalysisSource() = default;
+
+    /** A source with a single lane. */
+    PitchAnalysisSource (HopAnalyser& analyserToDrive, SampleFeed& feedToDrain);
+
+    /** Only while it's out of the pool.  Both objects must outlive it. */
+    void addLane (HopAnalyser& analyserToDrive, SampleFeed& feedToDrain);
+    int  getNumLanes() const noexcept { return static_cast<int> (lanes.size()); }
+
+    /** Times every chunk's analysis into probe's scope (against the chunk's
+        own duration).  Only while it's out of the pool; nullptr to stop. */
+    void setPerfProbe (PerfProbe* probe, int scopeId) noexcept { perfProbe = probe; perfScope = scopeId; }
+
+    /** Forgets any chunk it's holding and where each lane was up to, for a
+        fresh start.  Only while it's out of the pool. */
+    void reset() noexcept;
+
+    juce::int64 getDeadline() override;
+    void        runSlice() override;
+
+private:
+    struct Lane
+    {
+        HopAnalyser* analyser;
+        SampleFeed*  feed;
+        long long    expectedSample;
+        SampleChunk  chunk;             // popped by getDeadline(), analysed by runSlice()
+        bool         holding { false };
+    };
+
+    std::vector<Lane> lanes;
+    size_t            dueLane   { 0 };
+    PerfProbe*        perfProbe { nullptr };
+    int               perfScope { -1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchAnalysisSource)
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+    PitchBatchAnalyser.cpp  –  PitchBatchAnalyser implementation
+  ==============================================================================
+*/
+
+#include "PitchBatchAnalyser.h"
+
+PitchBatchAnalyser::PitchBatchAnalyser (int numWorkers)
+    : pool (juce::jmax (1, numWorkers))
+{
+    for (int i = 0; i < juce::jmax (1, numWorkers); ++i)
+        detectors.push_back (std::make_unique<PitchDetector> (settings.analysisSize));
+
+    setDetectorSettings (settings);
+}
+
+void PitchBatchAnalyser::setDetectorSettings (const PitchDetector::Settings& newSettings)
+{
+    settings = newSettings;
+
+    for (auto& detector : detectors)
+        detector->applySettings (settings);
+}
+
+juce::int64 PitchBatchAnalyser::getNumFrames (juce::int64 numSamples, int analysisSize, int hop) noexcept
+{
+    if (hop <= 0 || numSamples < analysisSize)
+        return 0;
+
+    return (numSamples - analysisSize) / hop + 1;
+}
+
+juce::int64 PitchBatchAnalyser::detectPitchBatch (const float* samples, juce::int64 numSamples,
+                                                  int hop, double sampleRate, PitchPoint* out)
+{
+    jassert (hop > 0 && sampleRate > 0.0);
+
+    const int         size      = settings.analysisSize;
+    const juce::int64 numFrames = getNumFrames (numSamples, size, hop);
+    if (numFrames == 0)
+        return 0;
+
+    const juce::int64 numChunks = (numFrames + kFramesPerChunk - 1) / kFramesPerChunk;
+    const int         numJobs   = static_cast<int> (juce::jmin (static_cast<juce::int64> (detectors.size()),
+                                                                numChunks));
+
+    // Each job claims the next unprocessed chunk until none are left, so a
+    // slow chunk (lots of voiced frames) doesn't hold up the whole batch.
+    std::atomic<juce::int64> nextChunk    { 0 };
+    std::atomic<int>         jobsRunning  { numJobs };
+    juce::WaitableEvent      allJobsDone;
+
+    for (int job = 0; job < numJobs; ++job)
+    {
+        PitchDetector* detector = detectors[(size_t) job].get();
+
+        pool.addJob ([&, detector, hop, sampleRate]
+        {
+            for (juce::int64 chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+            {
+                const juce::int64 firstFrame = chunk * kFramesPerChunk;
+                const juce::int64 endFrame   = juce::jmin (firstFrame + kFramesPerChunk, numFrames);
+
+                detectPitchRange (*detector, samples + firstFrame * hop, firstFrame, endFrame,
+                                  hop, sampleRate, out + firstFrame);
+            }
+
+            if (--jobsRunning == 0)
+                allJobsDone.signal();
+        });
+    }
+
+    allJobsDone.wait (-1);
+    return numFrames;
+}
+
+void PitchBatchAnalyser::detectPitchRange (PitchDetector& detector, const float* samples,
+                                           juce::int64 firstFrame, juce::int64 endFrame,
+                                           int hop, double sampleRate, PitchPoint* out)
+{
+    jassert (hop > 0 && sampleRate > 0.0);
+
+    const int size = detector.getAnalysisSize();
+
+    // The detector's previous frames were elsewhere in the source: start a
+    // fresh overlapped sequence and track.
+    detector.resetTracking();
+
+    for (juce::int64 frame = firstFrame; frame < endFrame; ++frame)
+    {
+        const float* window = samples + (frame - firstFrame) * hop;
+
+        const float pitchHz = (frame == firstFrame)
+                                ? detector.detectPitch (window, size, sampleRate)
+                                : detector.detectPitchOverlapped (window, size, hop, sampleRate);
+
+        out[frame - firstFrame] = { pitchHz, 0, static_cast<double> (frame * hop + size) / sampleRate };
+    }
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+    PitchBatchAnalyser.h  –  Offline pitch analysis across a juce::ThreadPool
+
+    Analyses a whole buffer at a fixed hop in one call.  The frames are handed
+    out in chunks to one job per worker; each job owns its own PitchDetector
+    (and therefore its own scratch), so workers share nothing but the input
+    and output arrays.  Within a chunk, frames are analysed with
+    detectPitchOverlapped(), exactly like the live path.
+
+    Intended for non-realtime callers: AutoTunes' ARA analysis and offline
+    QA jobs.  Never call it from the audio thread.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "PitchDetector.h"
+#include "PitchDataQueue.h"
+#include <memory>
+#include <vector>
+
+class PitchBatchAnalyser
+{
+public:
+    /** @param numWorkers  Threads in the pool (and detector instances). */
+    explicit PitchBatchAnalyser (int numWorkers = juce::SystemStats::getNumCpus());
+
+    /** Options used by every worker's detector.  Must not be called while a
+        batch is running. */
+    void setDetectorSettings (const PitchDetector::Settings& newSettings);
+    const PitchDetector::Settings& getDetectorSettings() const noexcept { return settings; }
+
+    /** Number of complete windows of analysisSize samples, one every hop. */
+    static juce::int64 getNumFrames (juce::int64 numSamples, int analysisSize, int hop) noexcept;
+
+    /**
+     * Analyses samples[0, numSamples) and writes one PitchPoint per frame,
+     * timestamped at the last sample of its window (the live-path convention).
+     * `out` must hold getNumFrames (numSamples, analysisSize, hop) points.
+     * Blocks until every frame is done; returns the number of points written.
+     */
+    juce::int64 detectPitchBatch (const float* samples, juce::int64 numSamples,
+                                  int hop, double sampleRate, PitchPoint* out);
+
+    /**
+     * One worker's share of a batch: frames [firstFrame, endFrame) as a
+     * single overlapped sequence on `detector`.  `samples` holds firstFrame's
+     * window onwards (absolute sample firstFrame * hop), and out[0] receives
+     * firstFrame's point.  For callers that stream a long source through a
+     * window of their own, such as AutoTunes' ARA analysis jobs.
+     */
+    static void detectPitchRange (PitchDetector& detector, const float* samples,
+                                  juce::int64 firstFrame, juce::int64 endFrame,
+                                  int hop, double sampleRate, PitchPoint* out);
+
+private:
+    static constexpr int kFramesPerChunk = 64;
+
+    juce::ThreadPool                            pool;
+    PitchDetector::Settings                     settings;
+    std::vector<std::unique_ptr<PitchDetector>> detectors;   // one per worker
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchBatchAnalyser)
+};
@@ -1,79 +1,114 @@
 /*
   ==============================================================================
-    PitchDataQueue.h  –  Lock-free SPSC queue for pitch data
+    PitchDataQueue.h  –  Lock-free broadcast stream of pitch data
 
-    Passes PitchPoint structs from the audio thread (producer) to the
-    UI thread (consumer) without any locks or heap allocations.
+    Passes PitchPoint structs from the analysis side (audio or worker thread,
+    the producer) to every thread that wants them (the history's timer, the
+    MIDI output in processBlock, and whatever comes next: a recorder, a
+    network sender) without any locks or heap allocations.
 
-    Built on top of juce::AbstractFifo which provides all the index
-    arithmetic for a single-producer / single-consumer ring buffer.
+    Built on the shared BroadcastRing: the producer writes each point once
+    however many consumers there are, and each consumer reads through its
+    own cursor.
+
+    Readers cost the producer nothing, so it can't tell whether anyone is
+    reading; PitchSubscribers counts the consumers that want the points now
+    (an open editor, a recording, a telemetry feed), so the producer can
+    stop making points nobody will look at.
   ==============================================================================
 */
 
 #pragma once
 
-#include <JuceHeader.h>
-#include <array>
+#include <juce_core/juce_core.h>
+#include "../../Shared/BroadcastRing.h"
+#include <atomic>
+#include <utility>
 
-/** One pitch measurement produced every ~analysisSize / sampleRate seconds. */
+/** One pitch measurement, produced once per analysis hop (~5.8 ms by default). */
 struct PitchPoint
 {
     float  pitchHz   { 0.0f };  ///< Fundamental in Hz; 0 = unvoiced / silence
+    int    channel   { 0    };  ///< Input channel analysed (0 for the mono mix)
     double timestamp { 0.0  };  ///< Seconds elapsed since the processor started
 };
 
 /**
- * Single-Producer Single-Consumer lock-free ring buffer.
+ * Single-producer, multi-consumer ring of PitchPoints.
+ *
+ * Capacity: 4 096 frames ≈ 24 s of unread data at one frame per 256-sample hop
+ * (44.1 kHz) per consumer, so the producer never has to wait even if the UI is
+ * briefly suspended; a consumer further behind than that loses its oldest
+ * points, and counts them (Reader::getStats().missed).
  *
- * Capacity: 4 096 frames ≈ 3+ minutes of unread data at one frame per ~46 ms,
- * so the audio thread never has to wait even if the UI is briefly suspended.
+ * Producer:  call push() or pushBlock()
+ * Consumers: one PitchStream::Reader each, on that consumer's own thread;
+ *            readAll(), numBehind(), skipToNewest()
  *
- * Audio thread:  call push()
- * UI thread:     call pop() / numReady()
+ * The block calls cost one release store (and a read one acquire load) however
+ * many points they move.
+ */
+using PitchStream = BroadcastRing<PitchPoint, 4096>;
+
+//==============================================================================
+/**
+ * How many consumers want the pitch streams' points right now.  Each holds a
+ * Subscription for as long as it does; with none, the analysis may go idle.
+ * Subscribing and checking are lock-free, from any thread.
  */
-class PitchDataQueue
+class PitchSubscribers
 {
 public:
-    static constexpr int kCapacity = 4096;
+    /** One consumer's interest, given up when it's destroyed or reset. */
+    class Subscription
+    {
+    public:
+        /** Holds none. */
+        Subscription() = default;
 
-    PitchDataQueue() : fifo (kCapacity) {}
+        explicit Subscription (PitchSubscribers& subscribersToJoin) noexcept
+            : subscribers (&subscribersToJoin)
+        {
+            subscribers->count.fetch_add (1, std::memory_order_relaxed);
+        }
 
-    // ── Producer (audio thread) ───────────────────────────────────────────────
+        Subscription (Subscription&& other) noexcept
+            : subscribers (std::exchange (other.subscribers, nullptr)) {}
 
-    /** Enqueues a point.  Silently drops it when the ring buffer is full. */
-    void push (PitchPoint pt) noexcept
-    {
-        int s1, n1, s2, n2;
-        fifo.prepareToWrite (1, s1, n1, s2, n2);
+        Subscription& operator= (Subscription&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                subscribers = std::exchange (other.subscribers, nullptr);
+            }
 
-        if      (n1 > 0) ringBuf[s1] = pt;
-        else if (n2 > 0) ringBuf[s2] = pt;
+            return *this;
+        }
 
-        fifo.finishedWrite (n1 + n2 > 0 ? 1 : 0);
-    }
+        ~Subscription() { reset(); }
 
-    // ── Consumer (UI thread) ──────────────────────────────────────────────────
+        void reset() noexcept
+        {
+            if (subscribers != nullptr)
+                subscribers->count.fetch_sub (1, std::memory_order_relaxed);
 
-    /** Dequeues the oldest point.  Returns false when the queue is empty. */
-    bool pop (PitchPoint& out) noexcept
-    {
-        int s1, n1, s2, n2;
-        fifo.prepareToRead (1, s1, n1, s2, n2);
+            subscribers = nullptr;
+        }
 
-        if      (n1 > 0) out = ringBuf[s1];
-        else if (n2 > 0) out = ringBuf[s2];
+        bool isActive() const noexcept { return subscribers != nullptr; }
 
-        const bool hadData = (n1 + n2) > 0;
-        fifo.finishedRead (hadData ? 1 : 0);
-        return hadData;
-    }
+    private:
+        PitchSubscribers* subscribers { nullptr };
 
-    int  numReady () const noexcept { return fifo.getNumReady(); }
-    void reset    ()       noexcept { fifo.reset(); }
+        JUCE_DECLARE_NON_COPYABLE (Subscription)
+    };
 
-private:
-    juce::AbstractFifo                 fifo;
-    std::array<PitchPoint, kCapacity>  ringBuf;
+    Subscription subscribe() noexcept { return Subscription (*this); }
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchDataQueue)
+    bool hasSubscribers()    const noexcept { return getNumSubscribers() > 0; }
+    int  getNumSubscribers() const noexcept { return count.load (std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> count { 0 };
 };
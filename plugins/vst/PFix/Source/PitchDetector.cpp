@@ -1,117 +1,531 @@
 /*
   ==============================================================================
-    PitchDetector.cpp  –  YIN pitch detection implementation
-
-    NOTE: This file is #included directly by PluginProcessor.cpp so it is
-    compiled as part of that translation unit. It does NOT need to appear as
-    a separate compiled source in the Projucer / Xcode project.
+    PitchDetector.cpp  –  YinPolicy implementation
   ==============================================================================
 */
 
 #include "PitchDetector.h"
 
-PitchDetector::PitchDetector (int size)
-    : analysisSize (size),
-      yinBuf (size / 2, 0.0f)
+YinPolicy::YinPolicy (int size)
 {
-    // Must be a power-of-two to keep the algorithm well-behaved
-    jassert (size >= 512 && (size & (size - 1)) == 0);
+    // ── Multi-rate: Blackman-windowed half-band FIR ─────────────────────────
+    // Half-band: every even tap except the centre (0.5) is zero, so only the
+    // odd taps k = 1, 3, 5, … are stored.
+    float tapSum = 0.0f;
+    for (size_t i = 0; i < halfBandTaps.size(); ++i)
+    {
+        const double k      = static_cast<double> (2 * i + 1);
+        const double span   = static_cast<double> (2 * halfBandTaps.size() + 1);
+        const double sinc   = std::sin (juce::MathConstants<double>::halfPi * k)
+                              / (juce::MathConstants<double>::pi * k);
+        const double window = 0.42 + 0.5  * std::cos (juce::MathConstants<double>::pi * k / span)
+                                   + 0.08 * std::cos (juce::MathConstants<double>::twoPi * k / span);
+        halfBandTaps[i] = static_cast<float> (sinc * window);
+        tapSum += halfBandTaps[i];
+    }
+    for (auto& tap : halfBandTaps)
+        tap *= 0.25f / tapSum;   // unity DC gain: 0.5 + 2·Σ taps = 1
+
+    prepare (size);
 }
 
-float PitchDetector::detectPitch (const float* samples, int numSamples, double sampleRate)
+void YinPolicy::prepare (int size)
 {
-    if (numSamples < analysisSize)
-        return 0.0f;
+    prepareCore (size, false);
 
-    // ── Energy gate ─────────────────────────────────────────────────────────
-    // Skip very quiet frames; avoids phantom detections in silence.
-    float energy = 0.0f;
-    for (int i = 0; i < analysisSize; ++i)
-        energy += samples[i] * samples[i];
-    energy /= static_cast<float> (analysisSize);
+    diffBuf       .assign (static_cast<size_t> (size / 2), 0.0f);
+    previousWindow.assign (static_cast<size_t> (size),     0.0f);
+    hasPreviousFrame   = false;
+    framesSinceRefresh = 0;
 
-    if (energy < 1e-6f)   // roughly –60 dBFS
-        return 0.0f;
+    decimatedA.assign (static_cast<size_t> (size / 2), 0.0f);
+    decimatedB.assign (static_cast<size_t> (size / 4), 0.0f);
+    coarseBuf .assign (static_cast<size_t> (size / 4), 0.0f);
 
-    const int halfSize = analysisSize / 2;
+    specialised.prepare (size, precision);
+}
+
+YinPolicy::Settings YinPolicy::getSettings() const noexcept
+{
+    Settings current;
+    current.analysisSize   = analysisSize;
+    current.engine         = engine;
+    current.precision      = precision;
+    current.lazyEvaluation = lazyEvaluation;
+    current.multiRate      = multiRate;
+    current.tracking       = tracking;
+    current.trackSemitones = trackSemitones;
+    current.threshold      = threshold;
+    current.voicingGate    = voicingGate;
+    return current;
+}
+
+void YinPolicy::applySettings (const Settings& newSettings)
+{
+    if (newSettings.analysisSize != analysisSize)
+        prepare (newSettings.analysisSize);
+
+    setDifferenceEngine   (newSettings.engine);
+    setFixedSizePrecision (newSettings.precision);
+    setLazyEvaluation     (newSettings.lazyEvaluation);
+    setMultiRate          (newSettings.multiRate);
+    setTracking           (newSettings.tracking, newSettings.trackSemitones);
+    setThreshold          (newSettings.threshold);
+    setVoicingGate        (newSettings.voicingGate);
+}
+
+float YinPolicy::detectFrame (const float* samples, double sampleRate) noexcept
+{
+    hasPreviousFrame = false;   // a standalone frame breaks any overlapped sequence
+
+    if (usesSpecialised())      // gates on energy itself
+        return detectSpecialised (samples, sampleRate);
+
+    if (multiRate)
+        return searchMultiRate (samples, sampleRate);
+
+    if (tracking)
+        return searchTracked (samples, false, sampleRate);
+
+    // ── Lazy mode: steps 1–3 interleaved, stopping at the first confirmed dip
+    if (lazyEvaluation && engine == DifferenceEngine::direct)
+        return searchLazily (samples, true, sampleRate);
 
     // ── Step 1: Difference function ─────────────────────────────────────────
     //   d(τ) = Σ_{j=0}^{W/2−1} (x[j] − x[j+τ])²
-    for (int tau = 0; tau < halfSize; ++tau)
+    if (engine == DifferenceEngine::fft)
+        computeDifferenceFFT (samples);
+    else
+        computeDifferenceDirect (samples);
+
+    return lazyEvaluation ? searchLazily (samples, false, sampleRate)
+                          : pitchFromDifference (sampleRate);
+}
+
+float YinPolicy::detectOverlappedFrame (const float* samples, int hopSize, double sampleRate) noexcept
+{
+    if (usesSpecialised())
     {
-        float sum = 0.0f;
-        for (int j = 0; j < halfSize; ++j)
-        {
-            const float delta = samples[j] - samples[j + tau];
-            sum += delta * delta;
-        }
-        yinBuf[tau] = sum;
+        hasPreviousFrame = false;
+        return detectSpecialised (samples, sampleRate);
+    }
+
+    // Multi-rate and lazy direct evaluation never compute the whole of d(τ),
+    // so there is nothing to slide forward; both are cheaper anyway.
+    if (multiRate)
+    {
+        hasPreviousFrame = false;
+        return searchMultiRate (samples, sampleRate);
+    }
+
+    if (lazyEvaluation && engine == DifferenceEngine::direct && ! tracking)
+    {
+        hasPreviousFrame = false;
+        return searchLazily (samples, true, sampleRate);
+    }
+
+    const int n        = analysisSize;
+    const int halfSize = analysisSize / 2;
+
+    // The update costs 2·hop·W/2 against W/2·W/2 for a full pass, so it only
+    // pays off for hops well below half a window.  The FFT engine is cheaper
+    // than either, so it always recomputes.
+    const bool canUpdate = engine == DifferenceEngine::direct
+                        && hasPreviousFrame
+                        && hopSize > 0 && hopSize <= halfSize / 4
+                        && framesSinceRefresh < kIncrementalRefreshFrames;
+
+    if (canUpdate)
+    {
+        updateDifferenceIncremental (samples, hopSize);
+        ++framesSinceRefresh;
+    }
+    else
+    {
+        if (engine == DifferenceEngine::fft)
+            computeDifferenceFFT (samples);
+        else
+            computeDifferenceDirect (samples);
+
+        juce::FloatVectorOperations::copy (diffBuf.data(), lagBuf.data(), halfSize);
+        framesSinceRefresh = 0;
     }
 
+    juce::FloatVectorOperations::copy (previousWindow.data(), samples, n);
+    hasPreviousFrame = true;
+
+    if (tracking)
+        return searchTracked (samples, true, sampleRate);
+
+    return lazyEvaluation ? searchLazily (samples, false, sampleRate)
+                          : pitchFromDifference (sampleRate);
+}
+
+float YinPolicy::pitchFromDifference (double sampleRate) noexcept
+{
+    const int halfSize = analysisSize / 2;
+
     // ── Step 2: Cumulative mean normalised difference function (CMNDF) ───────
+    cumulativeMeanNormalise (lagBuf.data(), halfSize);
+
+    // ── Step 3: First local minimum below threshold ──────────────────────────
+    // Constrain the search to a musically meaningful frequency band.
+    int tauMin, tauMax;
+    getTauRange (sampleRate, halfSize, tauMin, tauMax);
+
+    return pitchFromTau (findFirstDip (lagBuf.data(), tauMin, tauMax, threshold), sampleRate);
+}
+
+void YinPolicy::cumulativeMeanNormalise (float* d, int halfSize) noexcept
+{
     //   d'(0) = 1
     //   d'(τ) = d(τ) · τ / Σ_{j=1}^{τ} d(j)
     //
     // This normalisation removes the trivial minimum at τ = 0 and makes the
     // threshold comparison meaningful across different signal levels.
-    yinBuf[0] = 1.0f;
+    d[0] = 1.0f;
     float runningSum = 0.0f;
     for (int tau = 1; tau < halfSize; ++tau)
     {
-        runningSum += yinBuf[tau];
-        yinBuf[tau] = (runningSum > 0.0f)
-                      ? yinBuf[tau] * static_cast<float> (tau) / runningSum
-                      : 1.0f;
+        runningSum += d[tau];
+        d[tau] = (runningSum > 0.0f)
+                 ? d[tau] * static_cast<float> (tau) / runningSum
+                 : 1.0f;
     }
+}
 
-    // ── Step 3: First local minimum below threshold ──────────────────────────
-    // Constrain the search to a musically meaningful frequency band.
-    const int tauMin = static_cast<int> (std::ceil  (sampleRate / 1200.0));  // ~1200 Hz
-    const int tauMax = std::min (static_cast<int> (std::floor (sampleRate / 40.0)),
-                                 halfSize - 2);                               // ~40 Hz
-
-    int tauEst = -1;
+int YinPolicy::findFirstDip (const float* cmndf, int tauMin, int tauMax, float dipThreshold) noexcept
+{
     for (int tau = tauMin; tau <= tauMax; ++tau)
     {
-        if (yinBuf[tau] < threshold)
+        if (cmndf[tau] < dipThreshold)
         {
             // Walk to the bottom of the dip (local minimum)
-            while (tau + 1 <= tauMax && yinBuf[tau + 1] < yinBuf[tau])
+            while (tau + 1 <= tauMax && cmndf[tau + 1] < cmndf[tau])
                 ++tau;
-            tauEst = tau;
-            break;
+            return tau;
+        }
+    }
+    return -1;
+}
+
+float YinPolicy::searchLazily (const float* samples, bool computeDifference,
+                                   double sampleRate) noexcept
+{
+    // Same result as steps 1–3 of the full path, but d(τ) and the running
+    // CMNDF sum advance one block of lags at a time and stop as soon as the
+    // first dip below threshold has turned back up.  Lags below tauMin are
+    // still evaluated because the running sum needs them; they just can't
+    // be picked.
+    const int halfSize = analysisSize / 2;
+
+    int tauMin, tauMax;
+    getTauRange (sampleRate, halfSize, tauMin, tauMax);
+
+    // The dip walk may need to look one lag past tauMax.
+    const int lastTau = tauMax + 1;
+
+    float runningSum = 0.0f;
+    int   candidate  = -1;
+    int   tauEst     = -1;
+
+    for (int blockStart = 0; blockStart <= lastTau && tauEst < 0; blockStart += kLazyBlockSize)
+    {
+        const int blockEnd = std::min (blockStart + kLazyBlockSize, lastTau + 1);
+
+        if (computeDifference)
+        {
+            kernels.difference (samples, halfSize, blockStart, blockEnd, lagBuf.data());
+            count (counters->lagsSearched, static_cast<juce::uint64> (blockEnd - blockStart));
+        }
+
+        if (blockStart == 0)
+            lagBuf[0] = 1.0f;
+
+        for (int tau = std::max (1, blockStart); tau < blockEnd; ++tau)
+        {
+            runningSum += lagBuf[tau];
+            lagBuf[tau] = (runningSum > 0.0f)
+                          ? lagBuf[tau] * static_cast<float> (tau) / runningSum
+                          : 1.0f;
+
+            if (tau < tauMin)
+                continue;
+
+            if (candidate < 0)
+            {
+                if (tau <= tauMax && lagBuf[tau] < threshold)
+                    candidate = tau;
+            }
+            else if (tau <= tauMax && lagBuf[tau] < lagBuf[candidate])
+            {
+                candidate = tau;              // still walking down the dip
+            }
+            else
+            {
+                tauEst = candidate;           // dip confirmed (or hit tauMax)
+                break;
+            }
         }
     }
 
+    return pitchFromTau (tauEst, sampleRate);
+}
+
+float YinPolicy::searchTracked (const float* samples, bool differenceInDiffBuf,
+                                    double sampleRate) noexcept
+{
+    const int halfSize = analysisSize / 2;
+
+    int tauMin, tauMax;
+    getTauRange (sampleRate, halfSize, tauMin, tauMax);
+
+    float heldHz = 0.0f;
+
+    if (trackedHz > 0.0f)
+    {
+        // ── Neighbourhood search around the previous estimate ───────────────
+        const double trackedTau = sampleRate / trackedHz;
+        const double ratio      = std::exp2 (trackSemitones / 12.0);
+        const int    lo = std::max (tauMin, static_cast<int> (std::floor (trackedTau / ratio)));
+        const int    hi = std::min (tauMax, static_cast<int> (std::ceil  (trackedTau * ratio)));
+
+        if (lo < hi)
+        {
+            // The CMNDF's running sum still needs every lag from 1, but
+            // nothing past the top of the neighbourhood (+1 for the fit).
+            const int numLags = differenceInDiffBuf || engine == DifferenceEngine::fft ? halfSize : hi + 2;
+
+            if (! differenceInDiffBuf)
+            {
+                if (engine == DifferenceEngine::fft)
+                {
+                    computeDifferenceFFT (samples);
+                }
+                else
+                {
+                    kernels.difference (samples, halfSize, 0, numLags, lagBuf.data());
+                    count (counters->lagsSearched, static_cast<juce::uint64> (numLags));
+                }
+            }
+
+            cumulativeMeanNormalise (lagBuf.data(), numLags);
+
+            int best = lo;
+            for (int tau = lo + 1; tau <= hi; ++tau)
+                if (lagBuf[tau] < lagBuf[best])
+                    best = tau;
+
+            // A minimum on the edge means the pitch has left the neighbourhood.
+            const bool interior = best > lo && best < hi;
+
+            if (interior && lagBuf[best] < threshold)
+            {
+                octaveHoldFrames = 0;
+                trackedHz        = pitchFromTau (best, sampleRate);
+                return trackedHz;
+            }
+
+            if (interior && lagBuf[best] < kOctaveHoldThreshold)
+                heldHz = pitchFromTau (best, sampleRate);
+        }
+
+        count (counters->trackingFallbacks);
+
+        // lagBuf now holds a (partial) CMNDF: restore or recompute raw d(τ).
+        if (differenceInDiffBuf)
+            juce::FloatVectorOperations::copy (lagBuf.data(), diffBuf.data(), halfSize);
+        else if (engine == DifferenceEngine::fft)
+            computeDifferenceFFT (samples);
+        else
+            computeDifferenceDirect (samples);
+    }
+    else if (! differenceInDiffBuf)
+    {
+        if (engine == DifferenceEngine::fft)
+            computeDifferenceFFT (samples);
+        else
+            computeDifferenceDirect (samples);
+    }
+
+    // ── Full search, with octave jumps held back for a few frames ───────────
+    const float fullHz = pitchFromDifference (sampleRate);
+
+    if (heldHz > 0.0f && fullHz > 0.0f && trackedHz > 0.0f)
+    {
+        const float semitonesAway = std::abs (12.0f * std::log2 (fullHz / trackedHz));
+
+        if (semitonesAway > 10.5f && semitonesAway < 13.5f
+             && ++octaveHoldFrames <= kMaxOctaveHoldFrames)
+        {
+            trackedHz = heldHz;   // keep the track: probably a one-frame octave error
+            return heldHz;
+        }
+    }
+
+    octaveHoldFrames = 0;
+    trackedHz        = fullHz;
+    return fullHz;
+}
+
+float YinPolicy::searchMultiRate (const float* samples, double sampleRate) noexcept
+{
+    // ── Coarse pass: decimate by 2^stages, keeping the coarse rate >= 8 kHz
+    // (comfortably above the 1200 Hz search ceiling), and run full YIN there.
+    int    stages     = 0;
+    double coarseRate = sampleRate;
+    while (stages < kMaxDecimationStages && coarseRate * 0.5 >= kMinCoarseRate)
+    {
+        coarseRate *= 0.5;
+        ++stages;
+    }
+
+    if (stages == 0)
+    {
+        computeDifferenceDirect (samples);
+        return pitchFromDifference (sampleRate);
+    }
+
+    const float* src    = samples;
+    int          srcLen = analysisSize;
+    for (int stage = 0; stage < stages; ++stage)
+    {
+        float* dst = (stage % 2 == 0) ? decimatedA.data() : decimatedB.data();
+        decimateByTwo (src, srcLen, dst);
+        src     = dst;
+        srcLen /= 2;
+    }
+
+    const int factor     = 1 << stages;
+    const int coarseHalf = srcLen / 2;
+    kernels.difference (src, coarseHalf, 0, coarseHalf, coarseBuf.data());
+    count (counters->lagsSearched, static_cast<juce::uint64> (coarseHalf));
+    cumulativeMeanNormalise (coarseBuf.data(), coarseHalf);
+
+    int coarseMin, coarseMax;
+    getTauRange (coarseRate, coarseHalf, coarseMin, coarseMax);
+
+    const int coarseTau = findFirstDip (coarseBuf.data(), coarseMin, coarseMax, threshold);
+    if (coarseTau < 1)
+        return 0.0f;
+
+    // ── Fine pass: raw d(τ) at full rate in a narrow neighbourhood ─────────
+    // Across a few lags the CMNDF factor τ / Σ d is nearly constant, so the
+    // minimum of d(τ) is the minimum of d'(τ).
+    const int halfSize = analysisSize / 2;
+    const float coarseRefined = parabolicInterpolation (coarseBuf.data(), coarseHalf, coarseTau);
+    const int   centre        = juce::roundToInt (coarseRefined * static_cast<float> (factor));
+    const int   radius        = factor + 1;
+    const int   lo            = juce::jlimit (1, halfSize - 3, centre - radius);
+    const int   hi            = juce::jlimit (lo + 2, halfSize - 1, centre + radius);
+
+    kernels.difference (samples, halfSize, lo, hi + 1, lagBuf.data());
+    count (counters->lagsSearched, static_cast<juce::uint64> (hi + 1 - lo));
+
+    int best = lo + 1;
+    for (int tau = lo + 2; tau < hi; ++tau)
+        if (lagBuf[tau] < lagBuf[best])
+            best = tau;
+
+    // ── Step 4 on the raw neighbourhood ────────────────────────────────────
+    return pitchFromRefinedTau (parabolicInterpolation (lagBuf.data(), halfSize, best), sampleRate);
+}
+
+void YinPolicy::decimateByTwo (const float* in, int numIn, float* out) const noexcept
+{
+    // Zero-phase half-band FIR, edges extended by clamping:
+    //   y[n] = 0.5·x[2n] + Σ_k h_k · (x[2n − k] + x[2n + k]),  k odd
+    const int numOut = numIn / 2;
+    const int last   = numIn - 1;
+    const int numTaps = static_cast<int> (halfBandTaps.size());
+
+    for (int n = 0; n < numOut; ++n)
+    {
+        const int centre = 2 * n;
+        float acc = 0.5f * in[centre];
+
+        for (int i = 0; i < numTaps; ++i)
+        {
+            const int k = 2 * i + 1;
+            acc += halfBandTaps[static_cast<size_t> (i)]
+                   * (in[std::max (0, centre - k)] + in[std::min (last, centre + k)]);
+        }
+        out[n] = acc;
+    }
+}
+
+float YinPolicy::pitchFromTau (int tauEst, double sampleRate) noexcept
+{
     if (tauEst < 1)
         return 0.0f;
 
     // ── Step 4: Parabolic interpolation for sub-sample precision ─────────────
-    const float refinedTau = parabolicInterpolation (tauEst);
-    if (refinedTau <= 0.0f)
-        return 0.0f;
+    // then the final sanity check: within the vocal / instrument range we care about
+    return pitchFromRefinedTau (parabolicInterpolation (lagBuf.data(), analysisSize / 2, tauEst), sampleRate);
+}
 
-    const float pitchHz = static_cast<float> (sampleRate) / refinedTau;
+float YinPolicy::detectSpecialised (const float* samples, double sampleRate) noexcept
+{
+    count (counters->lagsSearched, static_cast<juce::uint64> (analysisSize / 2));
+    return specialised.detectPitch (samples, analysisSize, sampleRate, threshold);
+}
 
-    // Final sanity check: keep within the vocal / instrument range we care about
-    return (pitchHz >= 40.0f && pitchHz <= 2000.0f) ? pitchHz : 0.0f;
+void YinPolicy::computeDifferenceDirect (const float* samples) noexcept
+{
+    const int halfSize = analysisSize / 2;
+    kernels.difference (samples, halfSize, 0, halfSize, lagBuf.data());
+    count (counters->lagsSearched, static_cast<juce::uint64> (halfSize));
 }
 
-float PitchDetector::parabolicInterpolation (int tau) const noexcept
+void YinPolicy::computeDifferenceFFT (const float* samples) noexcept
 {
-    const int n = static_cast<int> (yinBuf.size());
-    if (tau < 1 || tau >= n - 1)
-        return static_cast<float> (tau);
+    // Expanding the square gives
+    //   d(τ) = e(0) + e(τ) − 2·r(τ)
+    // with e(τ) = Σ_{j=τ}^{τ+W/2−1} x[j]²   (running energy, O(1) per τ)
+    // and  r(τ) = Σ_{j=0}^{W/2−1} x[j]·x[j+τ] (cross-correlation, via FFT)
+    const int    halfSize = analysisSize / 2;
+    const float* r        = correlateHalfWindow (samples);
+    count (counters->lagsSearched, static_cast<juce::uint64> (halfSize));
+
+    const float energy0 = knownStats != nullptr ? static_cast<float> (knownStats->firstHalfEnergy)
+                                                : kernels.sumOfSquares (samples, halfSize);
+
+    float energyTau = energy0;
+    for (int tau = 0; tau < halfSize; ++tau)
+    {
+        // Clamp: rounding can push a near-perfect match slightly below zero
+        lagBuf[tau] = std::max (0.0f, energy0 + energyTau - 2.0f * r[tau]);
 
-    const float s0 = yinBuf[tau - 1];
-    const float s1 = yinBuf[tau];
-    const float s2 = yinBuf[tau + 1];
+        const float leaving  = samples[tau];
+        const float entering = samples[tau + halfSize];
+        energyTau += entering * entering - leaving * leaving;
+    }
+}
+
+void YinPolicy::updateDifferenceIncremental (const float* samples, int hop) noexcept
+{
+    // Sliding the window by h samples drops the first h terms of every d(τ)
+    // sum and appends h new ones at the end:
+    //   d_new(τ) = d_old(τ) − Σ_{j<h} (o[j] − o[j+τ])²
+    //                       + Σ_{j<h} (x[W/2−h+j] − x[W/2−h+j+τ])²
+    // where o is the previous window and x the current one.
+    const int halfSize = analysisSize / 2;
+    const float* prev  = previousWindow.data();
+    const float* tail  = samples + halfSize - hop;
+    count (counters->lagsSearched, static_cast<juce::uint64> (halfSize));
 
-    // Vertex of the parabola through (τ−1, s0), (τ, s1), (τ+1, s2):
-    //   x_min = τ + 0.5 · (s0 − s2) / (s0 − 2·s1 + s2)
-    const float denom = s0 - 2.0f * s1 + s2;
-    if (std::abs (denom) < 1e-8f)
-        return static_cast<float> (tau);
+    for (int tau = 0; tau < halfSize; ++tau)
+    {
+        float leaving = 0.0f, entering = 0.0f;
+        for (int j = 0; j < hop; ++j)
+        {
+            const float a = prev[j] - prev[j + tau];
+            const float b = tail[j] - tail[j + tau];
+            leaving  += a * a;
+            entering += b * b;
+        }
+        diffBuf[tau] = std::max (0.0f, diffBuf[tau] - leaving + entering);
+    }
 
-    return static_cast<float> (tau) + 0.5f * (s0 - s2) / denom;
+    juce::FloatVectorOperations::copy (lagBuf.data(), diffBuf.data(), halfSize);
 }
@@ -1,13 +1,28 @@
 /*
   ==============================================================================
-    PitchDetector.h  –  YIN pitch detection algorithm
+    PitchDetector.h  –  Pitch detection, with the algorithm as a policy
 
-    de Cheveigné, A. & Kawahara, H. (2002).
-    "YIN, a fundamental frequency estimator for speech and music."
-    Journal of the Acoustical Society of America, 111(4), 1917–1930.
+    BasicPitchDetector<Policy> is the detector the rest of PFix uses; the
+    policy is the algorithm, picked at compile time:
+
+      • YinPolicy (PitchDetector): de Cheveigné, A. & Kawahara, H. (2002).
+        "YIN, a fundamental frequency estimator for speech and music."
+        Journal of the Acoustical Society of America, 111(4), 1917–1930.
+
+      • MpmPolicy (MpmPitchDetector, see MpmPolicy.h): McLeod's normalised
+        square difference function with key-maximum peak picking.
+
+    Both build on PitchDetectorCore's buffers, FFT correlation and gate.
+    The template owns what every frame goes through first (the size check
+    and the gate); a policy provides prepare() and:
+
+        bool  gatesItself() const noexcept;   // skips the shared energy gate
+        void  gatedFrame() noexcept;          // a frame the gate rejected
+        float detectFrame (const float* samples, double sampleRate) noexcept;
+        float detectOverlappedFrame (const float* samples, int hop, double sampleRate) noexcept;
 
     Design constraints (audio-thread safe):
-      • No heap allocation after construction
+      • No heap allocation after construction / prepare()
       • No locks
       • No virtual dispatch
   ==============================================================================
@@ -15,18 +30,214 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include "PitchDetectorCore.h"
+#include "FixedSizeYin.h"
+#include "MpmPolicy.h"
 #include <vector>
 #include <cmath>
+#include <memory>
+#include <array>
+
+/**
+ * Detects the fundamental frequency of a mono audio frame using YIN; the
+ * policy behind PitchDetector.
+ */
+class YinPolicy  : public PitchDetectorCore
+{
+public:
+    /** How step 1 (the difference function d(τ)) is computed.
+        Both engines produce the same d(τ) to within float rounding. */
+    enum class DifferenceEngine
+    {
+        direct,   ///< Time-domain double loop, O(N²), SIMD-vectorised across lags
+        fft,      ///< Autocorrelation via juce::dsp::FFT plus a running energy term, O(N log N)
+        fixedSize ///< Whole search in a FixedSizePitchDetector with compile-time bounds
+                  ///< (1024 / 2048 / 4096 only; other sizes use the direct engine)
+    };
+
+    /** Arithmetic precision of the fixedSize engine. */
+    using Precision = SpecialisedPitchDetector::Precision;
+
+    /** Reallocates every buffer for a new analysis size (a power of two
+        >= 512).  Not realtime-safe: call from prepareToPlay(). */
+    void prepare (int newAnalysisSize);
+
+    /** Selects the difference-function engine (default: direct).
+        Both engines' buffers are allocated up front, so this is safe to
+        call from the audio thread. */
+    void             setDifferenceEngine (DifferenceEngine e) noexcept { engine = e; }
+    DifferenceEngine getDifferenceEngine ()             const noexcept { return engine; }
+
+    /** Precision for the fixedSize engine (default float32).  Never
+        allocates, but resets that engine's state. */
+    void      setFixedSizePrecision (Precision p) noexcept { precision = p; specialised.prepare (analysisSize, p); }
+    Precision getFixedSizePrecision ()      const noexcept { return precision; }
+
+    /** Lazy mode: compute d(τ) and the CMNDF lag by lag and stop at the first
+        confirmed dip instead of evaluating every lag up to analysisSize / 2.
+        Gives the same pitch as the full search.  With the FFT engine only the
+        CMNDF pass is shortened; with the direct engine it disables the
+        incremental update in detectPitchOverlapped(). */
+    void setLazyEvaluation (bool shouldBeLazy) noexcept { lazyEvaluation = shouldBeLazy; }
+    bool isLazyEvaluation  ()            const noexcept { return lazyEvaluation; }
+
+    /** Multi-rate mode: decimate the window (2x half-band stages until the
+        rate is just above 8 kHz, i.e. 4x at 44.1/48 kHz, 16x at 192 kHz), run
+        YIN on that to get a coarse lag, then evaluate d(τ) at full rate only
+        in a few lags around it before parabolic interpolation.  Keeps the
+        detector's cost roughly independent of the host sample rate. */
+    void setMultiRate (bool shouldUseMultiRate) noexcept { multiRate = shouldUseMultiRate; }
+    bool isMultiRate  ()                  const noexcept { return multiRate; }
+
+    /** Tracking mode: after a voiced frame, search only the lags within
+        ±neighbourhoodSemitones of the previous estimate (and, with the direct
+        engine, compute d(τ) only that far).  Falls back to the full search
+        when that neighbourhood has no confident interior minimum.  A full
+        search result an octave away from the track is only accepted once it
+        has persisted for kMaxOctaveHoldFrames frames; until then the
+        neighbourhood estimate is held, which removes single-frame octave
+        spikes.  Not used in multi-rate or fixedSize mode. */
+    void  setTracking (bool shouldTrack, float neighbourhoodSemitones = 3.0f) noexcept
+    {
+        tracking          = shouldTrack;
+        trackSemitones    = juce::jlimit (0.5f, 12.0f, neighbourhoodSemitones);
+        resetTracking();
+    }
+    bool  isTracking    () const noexcept { return tracking; }
+
+    /** Forgets the previous estimate, e.g. at a transport jump. */
+    void  resetTracking () noexcept { trackedHz = 0.0f; octaveHoldFrames = 0; }
+
+    /** Every user-facing option in one value, so that several detectors
+        (e.g. PitchBatchAnalyser's workers) can be configured identically. */
+    struct Settings
+    {
+        int              analysisSize   { 2048 };
+        DifferenceEngine engine         { DifferenceEngine::direct };
+        Precision        precision      { Precision::float32 };
+        bool             lazyEvaluation { false };
+        bool             multiRate      { false };
+        bool             tracking       { false };
+        float            trackSemitones { 3.0f };
+        float            threshold      { 0.15f };
+        bool             voicingGate    { true };
+    };
+
+    Settings getSettings() const noexcept;
+
+    /** Applies all options; reallocates (see prepare()) only if the
+        analysis size changes. */
+    void     applySettings (const Settings& newSettings);
+
+    /** Confidence threshold for the CMNDF minimum (0.05 – 0.5, default 0.15). */
+    void  setThreshold (float t)  noexcept { threshold = juce::jlimit (0.05f, 0.5f, t); }
+    float getThreshold ()   const noexcept { return threshold; }
+
+protected:
+    explicit YinPolicy (int analysisSize);
+
+    // ── The policy interface (see the top of this file) ─────────────────────
+    bool  gatesItself() const noexcept { return usesSpecialised(); }   // the fixedSize engine gates on its own
+    void  gatedFrame() noexcept        { hasPreviousFrame = false; trackedHz = 0.0f; }
+    float detectFrame (const float* samples, double sampleRate) noexcept;
+
+    /** With the direct engine, d(τ) is slid forward in O(hop · W/2) instead
+        of being recomputed in O(W²/4); a full pass is made every
+        kIncrementalRefreshFrames frames to stop float drift accumulating.
+        Any other call pattern (first frame, gated frame, large hop) falls
+        back to a full computation. */
+    float detectOverlappedFrame (const float* samples, int hopSize, double sampleRate) noexcept;
+
+private:
+    /** True when detect calls should go straight to the fixedSize engine. */
+    bool usesSpecialised() const noexcept
+    {
+        return engine == DifferenceEngine::fixedSize && ! multiRate && specialised.isActive();
+    }
+
+    /** Step 1 engines: both write d(τ) for τ in [0, analysisSize / 2) into lagBuf. */
+    void computeDifferenceDirect (const float* samples) noexcept;
+    void computeDifferenceFFT    (const float* samples) noexcept;
+
+    /** Slides diffBuf forward by hop samples, then copies it into lagBuf. */
+    void updateDifferenceIncremental (const float* samples, int hop) noexcept;
 
+    /** Steps 2–4: turns d(τ) in lagBuf into a pitch in Hz (0 = unvoiced). */
+    float pitchFromDifference (double sampleRate) noexcept;
+
+    /** Lazy steps 1–4.  When computeDifference is false, lagBuf already holds d(τ). */
+    float searchLazily (const float* samples, bool computeDifference, double sampleRate) noexcept;
+
+    /** Tracking-mode steps 1–4.  When differenceInDiffBuf is true, lagBuf
+        already holds d(τ) and diffBuf a copy of it (the overlapped path). */
+    float searchTracked (const float* samples, bool differenceInDiffBuf, double sampleRate) noexcept;
+
+    /** Coarse-to-fine search for multi-rate mode. */
+    float searchMultiRate (const float* samples, double sampleRate) noexcept;
+
+    /** One 2x half-band decimation stage; writes numIn / 2 samples. */
+    void  decimateByTwo (const float* in, int numIn, float* out) const noexcept;
+
+    /** Step 2 in place over d[0, halfSize). */
+    static void cumulativeMeanNormalise (float* d, int halfSize) noexcept;
+
+    /** Step 3: first local minimum below threshold in [tauMin, tauMax], or -1. */
+    static int  findFirstDip (const float* cmndf, int tauMin, int tauMax, float dipThreshold) noexcept;
+
+    /** Step 4: interpolates tauEst and converts to Hz (0 when tauEst < 1 or out of range). */
+    float pitchFromTau (int tauEst, double sampleRate) noexcept;
+
+    /** The whole search in the fixedSize engine. */
+    float detectSpecialised (const float* samples, double sampleRate) noexcept;
+
+    float              threshold { 0.15f };
+    DifferenceEngine   engine    { DifferenceEngine::direct };
+    bool               lazyEvaluation { false };
+    bool               multiRate      { false };
+
+    // ── fixedSize engine (instantiation picked in prepare) ──────────────────
+    SpecialisedPitchDetector specialised;
+    Precision                precision { Precision::float32 };
+
+    // ── Tracking state ──────────────────────────────────────────────────────
+    static constexpr int   kMaxOctaveHoldFrames = 3;
+    static constexpr float kOctaveHoldThreshold = 0.3f;   // CMNDF depth still worth holding
+
+    bool  tracking         { false };
+    float trackSemitones   { 3.0f };
+    float trackedHz        { 0.0f };   // previous voiced estimate, 0 = no track
+    int   octaveHoldFrames { 0 };
+
+    // ── Overlapped-analysis state (allocated in prepare) ─────────────────
+    static constexpr int kIncrementalRefreshFrames = 32;
+    static constexpr int kLazyBlockSize            = 32;   // lags per kernel call in lazy mode
+
+    std::vector<float> diffBuf;          // raw d(τ) of the previous frame, length = analysisSize / 2
+    std::vector<float> previousWindow;   // the previous frame's samples, length = analysisSize
+    bool               hasPreviousFrame   { false };
+    int                framesSinceRefresh { 0 };
+
+    // ── Multi-rate state (allocated in prepare) ──────────────────────────
+    static constexpr int    kMaxDecimationStages = 4;        // up to 16x
+    static constexpr double kMinCoarseRate       = 8000.0;
+
+    std::array<float, 6> halfBandTaps {};   // odd taps k = 1, 3, …, 11 (designed once in ctor)
+    std::vector<float>   decimatedA;        // stage outputs, ping-ponged
+    std::vector<float>   decimatedB;
+    std::vector<float>   coarseBuf;         // coarse d(τ) → CMNDF
+};
+
+//==============================================================================
 /**
- * Detects the fundamental frequency of a mono audio frame using YIN.
+ * Detects the fundamental frequency of mono audio frames with the Policy's
+ * algorithm.
  *
  * Typical usage:
  *   PitchDetector pd (2048);
  *   float hz = pd.detectPitch (monoSamples, 2048, 44100.0);
  */
-class PitchDetector
+template <typename Policy>
+class BasicPitchDetector  : public Policy
 {
 public:
     /**
@@ -34,7 +245,7 @@ public:
      *                      2048 works well for vocals at 44100 Hz:
      *                        • detects as low as ~43 Hz (bass), up to ~1 200 Hz
      */
-    explicit PitchDetector (int analysisSize = 2048);
+    explicit BasicPitchDetector (int analysisSize = 2048)  : Policy (analysisSize) {}
 
     /**
      * Returns the fundamental frequency in Hz, or 0.0f when no clear pitch
@@ -44,19 +255,60 @@ public:
      * @param numSamples  Must be >= analysisSize.
      * @param sampleRate  Current sample rate of the host (Hz).
      */
-    float detectPitch (const float* samples, int numSamples, double sampleRate);
+    float detectPitch (const float* samples, int numSamples, double sampleRate) noexcept
+    {
+        if (! admits (samples, numSamples, sampleRate))
+            return 0.0f;
 
-    int   getAnalysisSize () const noexcept { return analysisSize; }
+        return Policy::detectFrame (samples, sampleRate);
+    }
 
-    /** Confidence threshold for the CMNDF minimum (0.05 – 0.5, default 0.15). */
-    void  setThreshold (float t)  noexcept { threshold = juce::jlimit (0.05f, 0.5f, t); }
-    float getThreshold ()   const noexcept { return threshold; }
+    /** Same as detectPitch(), for a window that starts hopSize samples after
+        the window passed to the previous call (overlapping, hop-based
+        analysis), which a policy may use to update instead of recompute.
+        The window's running statistics, if the caller keeps them, spare the
+        gate and the correlations their own passes over it. */
+    float detectPitchOverlapped (const float* samples, int numSamples,
+                                 int hopSize, double sampleRate,
+                                 const WindowStats* windowStats = nullptr) noexcept
+    {
+        this->knownStats = windowStats;   // this frame only
+
+        const float pitchHz = admits (samples, numSamples, sampleRate)
+                                ? Policy::detectOverlappedFrame (samples, hopSize, sampleRate)
+                                : 0.0f;
+
+        this->knownStats = nullptr;
+        return pitchHz;
+    }
 
 private:
-    /** Refines the integer tau estimate using parabolic interpolation. */
-    float parabolicInterpolation (int tau) const noexcept;
+    bool admits (const float* samples, int numSamples, double sampleRate) noexcept
+    {
+        if (numSamples < this->getAnalysisSize())
+            return false;
 
-    int                analysisSize;
-    float              threshold { 0.15f };
-    std::vector<float> yinBuf;   // length = analysisSize / 2, allocated once in ctor
+        PitchDetectorCore::count (this->counters->frames);
+
+        // A policy that gates itself still gets the voicing gate, if it's on
+        if (Policy::gatesItself() && ! this->isVoicingGate())
+            return true;
+
+        const auto gate = this->gateFrame (samples, sampleRate);
+
+        if (gate == PitchDetectorCore::Gate::unvoiced
+            || (gate == PitchDetectorCore::Gate::silent && ! Policy::gatesItself()))
+        {
+            Policy::gatedFrame();
+            return false;
+        }
+
+        return true;
+    }
 };
+
+/** YIN: the detector PFix and AutoTunes analyse with. */
+using PitchDetector    = BasicPitchDetector<YinPolicy>;
+
+/** McLeod: more accurate on short windows, at the cost of YIN's options. */
+using MpmPitchDetector = BasicPitchDetector<MpmPolicy>;
@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+    PitchDetectorCore.cpp  –  PitchDetectorCore implementation
+  ==============================================================================
+*/
+
+#include "PitchDetectorCore.h"
+
+PitchDetectorCore::PitchDetectorCore()
+    : kernels (YinKernels::select())
+{
+}
+
+//==============================================================================
+PitchDetectorCore::Counters::Snapshot PitchDetectorCore::Counters::Snapshot::operator- (const Snapshot& earlier) const noexcept
+{
+    Snapshot difference;
+    difference.frames                = frames                - earlier.frames;
+    difference.energyGated           = energyGated           - earlier.energyGated;
+    difference.unvoicedGated         = unvoicedGated         - earlier.unvoicedGated;
+    difference.lagsSearched          = lagsSearched          - earlier.lagsSearched;
+    difference.trackingFallbacks     = trackingFallbacks     - earlier.trackingFallbacks;
+    difference.interpolationFailures = interpolationFailures - earlier.interpolationFailures;
+    return difference;
+}
+
+PitchDetectorCore::Counters::Snapshot PitchDetectorCore::Counters::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.frames                = frames               .load (std::memory_order_relaxed);
+    snapshot.energyGated           = energyGated          .load (std::memory_order_relaxed);
+    snapshot.unvoicedGated         = unvoicedGated        .load (std::memory_order_relaxed);
+    snapshot.lagsSearched          = lagsSearched         .load (std::memory_order_relaxed);
+    snapshot.trackingFallbacks     = trackingFallbacks    .load (std::memory_order_relaxed);
+    snapshot.interpolationFailures = interpolationFailures.load (std::memory_order_relaxed);
+    return snapshot;
+}
+
+void PitchDetectorCore::Counters::reset() noexcept
+{
+    for (auto* counter : { &frames, &energyGated, &unvoicedGated, &lagsSearched, &trackingFallbacks, &interpolationFailures })
+        counter->store (0, std::memory_order_relaxed);
+}
+
+void PitchDetectorCore::prepareCore (int size, bool withAutocorrelation)
+{
+    // Must be a power-of-two to keep the algorithms well-behaved
+    jassert (size >= kMinAnalysisSize && size <= kMaxAnalysisSize && (size & (size - 1)) == 0);
+
+    analysisSize = size;
+    lagBuf.assign (static_cast<size_t> (size / 2), 0.0f);
+
+    // An FFT of the analysis size is enough for the half-window correlation:
+    // the lags we need (τ < W/2) never wrap around a circular correlation of
+    // a W/2-sample block against W samples.  The whole window against itself
+    // needs W zeros of padding for the same.
+    const int order = juce::roundToInt (std::log2 (size));
+    fft = std::make_unique<juce::dsp::FFT> (order);
+    paddedFft.reset (withAutocorrelation ? new juce::dsp::FFT (order + 1) : nullptr);
+
+    fftWindow.assign (static_cast<size_t> ((withAutocorrelation ? 4 : 2) * size), 0.0f);
+    fftHalf  .assign (static_cast<size_t> (2 * size), 0.0f);
+}
+
+int PitchDetectorCore::analysisSizeFor (double sampleRate, float minFrequencyHz) noexcept
+{
+    // The longest lag searched must fit below halfSize − 1 (the last lag is
+    // needed for the dip test and the parabolic fit): W/2 ≥ sr / fmin + 2.
+    const double longestLag = sampleRate / juce::jmax (1.0f, minFrequencyHz);
+    const int    neededHalf = static_cast<int> (std::ceil (longestLag)) + 2;
+
+    int size = kMinAnalysisSize;
+    while (size / 2 < neededHalf && size < kMaxAnalysisSize)
+        size *= 2;
+
+    return size;
+}
+
+PitchDetectorCore::Gate PitchDetectorCore::gateFrame (const float* samples, double sampleRate) noexcept
+{
+    constexpr float kMinEnergy = 1e-6f;   // roughly –60 dBFS
+    const auto      n          = static_cast<float> (analysisSize);
+
+    // ── Energy gate ─────────────────────────────────────────────────────────
+    // Skip very quiet frames; avoids phantom detections in silence.
+    if (! voicingGate)
+    {
+        const float energy = knownStats != nullptr ? static_cast<float> (knownStats->energy)
+                                                   : kernels.sumOfSquares (samples, analysisSize);
+        if (energy / n >= kMinEnergy)
+            return Gate::open;
+
+        count (counters->energyGated);
+        return Gate::silent;
+    }
+
+    const auto stats = knownStats != nullptr
+                         ? YinKernels::FrameStats { static_cast<float> (knownStats->energy),
+                                                    static_cast<float> (knownStats->slopeEnergy),
+                                                    knownStats->signChanges }
+                         : kernels.frameStats (samples, analysisSize);
+
+    if (stats.energy / n < kMinEnergy)
+    {
+        count (counters->energyGated);
+        return Gate::silent;
+    }
+
+    // ── Voicing gate ────────────────────────────────────────────────────────
+    // A sine of f Hz changes sign 2f times a second, and its first
+    // difference has 4 sin² (πf / sr) times its energy: the frame counts
+    // as unvoiced when both put it above kUnvoicedAboveHz.
+    const float crossingHz = static_cast<float> (stats.signChanges) * static_cast<float> (sampleRate) / (2.0f * n);
+    const float slopeRatio = 4.0f * juce::square (std::sin (juce::MathConstants<float>::pi * kUnvoicedAboveHz
+                                                            / static_cast<float> (sampleRate)));
+
+    if (crossingHz > kUnvoicedAboveHz && stats.slopeEnergy > slopeRatio * stats.energy)
+    {
+        count (counters->unvoicedGated);
+        return Gate::unvoiced;
+    }
+
+    return Gate::open;
+}
+
+const float* PitchDetectorCore::correlateHalfWindow (const float* samples) noexcept
+{
+    const int halfSize = analysisSize / 2;
+    const int n        = analysisSize;
+
+    float* win  = fftWindow.data();
+    float* half = fftHalf.data();
+
+    juce::FloatVectorOperations::copy  (win,  samples, n);
+    juce::FloatVectorOperations::clear (win + n, n);
+    juce::FloatVectorOperations::copy  (half, samples, halfSize);
+    juce::FloatVectorOperations::clear (half + halfSize, 2 * n - halfSize);
+
+    fft->performRealOnlyForwardTransform (win);
+    fft->performRealOnlyForwardTransform (half);
+
+    // Correlation spectrum: conj (H[k]) · X[k]
+    for (int k = 0; k < n; ++k)
+    {
+        const float xr = win [2 * k], xi = win [2 * k + 1];
+        const float hr = half[2 * k], hi = half[2 * k + 1];
+        win[2 * k]     = hr * xr + hi * xi;
+        win[2 * k + 1] = hr * xi - hi * xr;
+    }
+
+    fft->performRealOnlyInverseTransform (win);   // win[τ] = r(τ), already scaled by 1/N
+    return win;
+}
+
+const float* PitchDetectorCore::autocorrelateWindow (const float* samples) noexcept
+{
+    jassert (paddedFft != nullptr);
+
+    const int n   = analysisSize;
+    float*    win = fftWindow.data();
+
+    juce::FloatVectorOperations::copy  (win, samples, n);
+    juce::FloatVectorOperations::clear (win + n, 3 * n);
+
+    paddedFft->performRealOnlyForwardTransform (win);
+
+    // Power spectrum |X[k]|², the transform of the autocorrelation
+    for (int k = 0; k < 2 * n; ++k)
+    {
+        const float xr = win[2 * k], xi = win[2 * k + 1];
+        win[2 * k]     = xr * xr + xi * xi;
+        win[2 * k + 1] = 0.0f;
+    }
+
+    paddedFft->performRealOnlyInverseTransform (win);   // win[τ] = r'(τ), scaled by 1/2N
+    return win;
+}
+
+float PitchDetectorCore::pitchFromRefinedTau (float refinedTau, double sampleRate) noexcept
+{
+    const float pitchHz = refinedTau > 0.0f ? static_cast<float> (sampleRate) / refinedTau : 0.0f;
+
+    if (isInRange (pitchHz))
+        return pitchHz;
+
+    count (counters->interpolationFailures);
+    return 0.0f;
+}
+
+void PitchDetectorCore::getTauRange (double sampleRate, int halfSize, int& tauMin, int& tauMax) noexcept
+{
+    tauMin = static_cast<int> (std::ceil  (sampleRate / 1200.0));   // ~1200 Hz
+    tauMax = std::min (static_cast<int> (std::floor (sampleRate / 40.0)),
+                       halfSize - 2);                                // ~40 Hz
+}
+
+float PitchDetectorCore::parabolicInterpolation (const float* buf, int n, int tau) noexcept
+{
+    if (tau < 1 || tau >= n - 1)
+        return static_cast<float> (tau);
+
+    const float s0 = buf[tau - 1];
+    const float s1 = buf[tau];
+    const float s2 = buf[tau + 1];
+
+    // Vertex of the parabola through (τ−1, s0), (τ, s1), (τ+1, s2):
+    //   x_min = τ + 0.5 · (s0 − s2) / (s0 − 2·s1 + s2)
+    const float denom = s0 - 2.0f * s1 + s2;
+    if (std::abs (denom) < 1e-8f)
+        return static_cast<float> (tau);
+
+    return static_cast<float> (tau) + 0.5f * (s0 - s2) / denom;
+}
+
+float PitchDetectorCore::parabolicPeak (const float* buf, int n, int tau) noexcept
+{
+    if (tau < 1 || tau >= n - 1)
+        return buf[tau];
+
+    //   y_vertex = s1 − (s0 − s2)² / (8 · (s0 − 2·s1 + s2))
+    const float s0 = buf[tau - 1];
+    const float s1 = buf[tau];
+    const float s2 = buf[tau + 1];
+
+    const float denom = s0 - 2.0f * s1 + s2;
+    if (std::abs (denom) < 1e-8f)
+        return s1;
+
+    return s1 - (s0 - s2) * (s0 - s2) / (8.0f * denom);
+}
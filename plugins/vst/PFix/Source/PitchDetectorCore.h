@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+    PitchDetectorCore.h  –  What every pitch detector engine shares
+
+    The buffers, the FFT correlation backend and the gate that both the
+    YIN and the McLeod engine are built on (see BasicPitchDetector in
+    PitchDetector.h).  All of it is allocated in prepareCore(), so the
+    engines never allocate while detecting.
+
+    Two correlations, both through juce::dsp::FFT:
+
+      • correlateHalfWindow():  r(τ) = Σ_{j<W/2} x[j]·x[j+τ], the first half
+        window against the whole one, for τ < W/2.  Every lag sums the same
+        number of products; what YIN's difference function expands into.
+
+      • autocorrelateWindow():  r'(τ) = Σ_{j<W−τ} x[j]·x[j+τ], the window
+        against itself (McLeod's type II ACF), for τ < W.  Needs an FFT of
+        twice the window, prepared only for the engines that ask for it.
+
+    The gate (gateFrame()) turns away silent frames and, with the voicing
+    gate on, frames that are clearly unvoiced: hiss, sibilants and breath,
+    whose zero-crossing rate and first-difference energy both put them
+    above kUnvoicedAboveHz.  Voiced sound, even bright, has its energy in
+    the harmonics below that, so either measure alone keeps it.  Both come
+    from one vectorised pass (YinKernels::frameStats), a small fraction of
+    the lag search it saves.
+
+    Counters say why a detector costs what it does: how many frames each
+    gate turned away, how many lags of d(τ) (or the NSDF) the searches
+    evaluated, how often tracking fell back to the full search and how
+    often a lag found gave no pitch once refined.  The detecting thread
+    keeps them; anything else can read them without a lock.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "YinKernels.h"
+#include "WindowStats.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class PitchDetectorCore
+{
+public:
+    static constexpr int kMinAnalysisSize = 512;
+    static constexpr int kMaxAnalysisSize = 16384;
+
+    /** Smallest power-of-two window (clamped to [kMinAnalysisSize,
+        kMaxAnalysisSize]) whose lag range reaches down to minFrequencyHz at
+        this sample rate, e.g. for 50 Hz: 1024 at 22.05 kHz, 2048 at 44.1/48
+        kHz, 4096 at 96 kHz, 8192 at 192 kHz. */
+    static int analysisSizeFor (double sampleRate, float minFrequencyHz) noexcept;
+
+    int getAnalysisSize () const noexcept { return analysisSize; }
+
+    /** Instruction set picked for the vector kernels ("AVX2", "SSE2", "NEON" or "scalar"). */
+    const char* getKernelName () const noexcept { return kernels.name; }
+
+    static constexpr float kUnvoicedAboveHz = 2500.0f;
+
+    /** Skips the pitch search on clearly unvoiced frames (default on);
+        off, only the energy gate applies. */
+    void setVoicingGate (bool shouldGate) noexcept { voicingGate = shouldGate; }
+    bool isVoicingGate  () const noexcept          { return voicingGate; }
+
+    //==============================================================================
+    /** Running totals, one writer (the detecting thread) and any number of
+        lock-free readers.  Each total is exact, but a snapshot taken while
+        the detector runs may catch one frame half counted. */
+    struct Counters
+    {
+        struct Snapshot
+        {
+            juce::uint64 frames                { 0 };   ///< Every frame offered, gated or not
+            juce::uint64 energyGated           { 0 };   ///< Too quiet to search
+            juce::uint64 unvoicedGated         { 0 };   ///< Turned away by the voicing gate
+            juce::uint64 lagsSearched          { 0 };   ///< Lags evaluated, over every search
+            juce::uint64 trackingFallbacks     { 0 };   ///< Tracked frames that needed the full search
+            juce::uint64 interpolationFailures { 0 };   ///< A lag found, but no pitch in range once refined
+
+            /** The counts between two snapshots, the earlier subtracted. */
+            Snapshot operator- (const Snapshot& earlier) const noexcept;
+        };
+
+        /** Any thread. */
+        Snapshot getSnapshot() const noexcept;
+
+        /** The detecting thread, or while nothing detects. */
+        void reset() noexcept;
+
+        std::atomic<juce::uint64> frames { 0 }, energyGated { 0 }, unvoicedGated { 0 }, lagsSearched { 0 },
+                                  trackingFallbacks { 0 }, interpolationFailures { 0 };
+    };
+
+    /** Counts into counters (which must outlive its use here) instead of
+        this detector's own, e.g. to keep one set across the detectors an
+        analyser switches between; nullptr goes back to its own. */
+    void setCounters (Counters* countersToUse) noexcept { counters = countersToUse != nullptr ? countersToUse : &ownCounters; }
+    const Counters& getCounters() const noexcept        { return *counters; }
+
+protected:
+    PitchDetectorCore();
+
+    /** Reallocates the shared buffers for a power-of-two size >= 512; the
+        padded FFT only if withAutocorrelation.  Not realtime-safe. */
+    void prepareCore (int size, bool withAutocorrelation);
+
+    enum class Gate
+    {
+        silent,     ///< Quieter than roughly –60 dBFS
+        unvoiced,   ///< Loud enough, but noise above kUnvoicedAboveHz (voicing gate only)
+        open        ///< Worth a pitch search
+    };
+
+    /** Classifies one analysis window (from knownStats when set). */
+    Gate gateFrame (const float* samples, double sampleRate) noexcept;
+
+    /** r(τ) for τ in [0, W/2), returned in the FFT scratch (valid until the
+        next correlation). */
+    const float* correlateHalfWindow (const float* samples) noexcept;
+
+    /** r'(τ) for τ in [0, W), likewise.  Needs prepareCore (…, true). */
+    const float* autocorrelateWindow (const float* samples) noexcept;
+
+    /** Lag search band for ~1200 Hz down to ~40 Hz, clamped to a half-window. */
+    static void getTauRange (double sampleRate, int halfSize, int& tauMin, int& tauMax) noexcept;
+
+    /** Refines an integer extremum (minimum or maximum) of buf[0, n) using
+        parabolic interpolation. */
+    static float parabolicInterpolation (const float* buf, int n, int tau) noexcept;
+
+    /** Vertex height of that same parabola: the refined extremum's value. */
+    static float parabolicPeak (const float* buf, int n, int tau) noexcept;
+
+    /** True for a pitch inside the range we care about (40–2000 Hz). */
+    static bool isInRange (float pitchHz) noexcept { return pitchHz >= 40.0f && pitchHz <= 2000.0f; }
+
+    /** Adds to one of the counters.  Only the detecting thread writes, so a
+        load and a store do instead of a locked read-modify-write. */
+    static void count (std::atomic<juce::uint64>& counter, juce::uint64 amount = 1) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    /** The pitch refinedTau lags gives, or 0 (counted as an interpolation
+        failure) when that's not a lag or not in range. */
+    float pitchFromRefinedTau (float refinedTau, double sampleRate) noexcept;
+
+    int                analysisSize { 0 };
+    YinKernels::Table  kernels;   // chosen once for this CPU in the ctor
+    std::vector<float> lagBuf;    // one value per lag, length = analysisSize / 2
+
+    // The caller's running statistics of the frame being analysed, or
+    // nullptr (then the sums are taken from the samples)
+    const WindowStats* knownStats { nullptr };
+
+    bool               voicingGate { true };
+    Counters           ownCounters;
+    Counters*          counters    { &ownCounters };
+
+private:
+    // ── FFT scratch (allocated in prepareCore) ──────────────────────────────
+    std::unique_ptr<juce::dsp::FFT> fft;          // order = log2 (analysisSize)
+    std::unique_ptr<juce::dsp::FFT> paddedFft;    // order = log2 (analysisSize) + 1, or none
+    std::vector<float>              fftWindow;    // full window → spectrum → r(τ); 4W with the padded FFT
+    std::vector<float>              fftHalf;      // 2W: first half-window → spectrum
+};
@@ -1,14 +1,11 @@
 /*
   ==============================================================================
     PitchGraphComponent.cpp  –  Piano-roll pitch visualizer
-
-    NOTE: This file is #included directly by PluginEditor.cpp so it is
-    compiled as part of that translation unit. It does NOT need to appear as
-    a separate compiled source in the Projucer / Xcode project.
   ==============================================================================
 */
 
 #include "PitchGraphComponent.h"
+#include "../../Shared/FastMath.h"
 
 // ── Colour palette (dark, pro-audio aesthetic) ────────────────────────────────
 namespace Pal
@@ -25,14 +22,35 @@ namespace Pal
     const juce::Colour hudBg         { 0xcc161b22 };  // HUD pill background
     const juce::Colour hudText       { 0xffffd700 };  // gold for current note
     const juce::Colour timeTick      { 0xff3d4451 };  // time axis ticks
+
+    // Spectrogram ramp, quiet → loud; faded in with the level so the grid
+    // still shows through where there's nothing
+    const juce::Colour spectrumLow   { 0xff1f3b73 };  // deep blue
+    const juce::Colour spectrumMid   { 0xff7b3fa6 };  // violet
+    const juce::Colour spectrumHigh  { 0xfff2c14e };  // amber
+
+    // Curves for channels 1+ (channel 0 keeps pitchLine), cycled past 8
+    const juce::Colour channelCurves[] { juce::Colour (0xff45aaf2),   // blue
+                                         juce::Colour (0xfffd9644),   // orange
+                                         juce::Colour (0xffa55eea),   // purple
+                                         juce::Colour (0xfffc5c65),   // red
+                                         juce::Colour (0xff2bcbba),   // teal
+                                         juce::Colour (0xfffed330),   // yellow
+                                         juce::Colour (0xfff78fb3),   // pink
+                                         juce::Colour (0xffd1d8e0) }; // grey
 }
 
 // ── Static helpers ────────────────────────────────────────────────────────────
 
+static float ticksToMs (juce::int64 ticks) noexcept
+{
+    return static_cast<float> (juce::Time::highResolutionTicksToSeconds (ticks) * 1000.0);
+}
+
 float PitchGraphComponent::hzToMidi (float hz) noexcept
 {
     if (hz <= 0.0f) return -1.0f;
-    return 69.0f + 12.0f * std::log2f (hz / 440.0f);
+    return FastMath::hzToMidi<FastMath::coarse> (hz);   // far finer than a pixel
 }
 
 int PitchGraphComponent::roundToMidi (float hz) noexcept
@@ -46,6 +64,13 @@ bool PitchGraphComponent::isBlackKey (int midiNote) noexcept
     return s == 1 || s == 3 || s == 6 || s == 8 || s == 10;
 }
 
+juce::Colour PitchGraphComponent::curveColour (int channel) noexcept
+{
+    constexpr int numCurves = (int) std::size (Pal::channelCurves);
+    return channel == 0 ? Pal::pitchLine
+                        : Pal::channelCurves[(channel - 1) % numCurves];
+}
+
 juce::String PitchGraphComponent::midiToNoteName (int midiNote, bool showOctave)
 {
     static constexpr const char* names[] =
@@ -57,45 +82,818 @@ juce::String PitchGraphComponent::midiToNoteName (int midiNote, bool showOctave)
     return s;
 }
 
-// ── Construction ─────────────────────────────────────────────────────────────
+juce::GlyphArrangement PitchGraphComponent::layOutText (const juce::Font& font, const juce::String& text,
+                                                       juce::Rectangle<float> area, juce::Justification justification)
+{
+    juce::GlyphArrangement glyphs;
+    glyphs.addCurtailedLineOfText (font, text, 0.0f, 0.0f, area.getWidth(), true);
+    glyphs.justifyGlyphs (0, glyphs.getNumGlyphs(),
+                          area.getX(), area.getY(), area.getWidth(), area.getHeight(),
+                          justification);
+    return glyphs;
+}
+
+// ── TimeRing ──────────────────────────────────────────────────────────────────
+
+template <typename Item>
+void PitchGraphComponent::TimeRing<Item>::setCapacity (int newCapacity)
+{
+    newCapacity = juce::nextPowerOfTwo (juce::jmax (16, newCapacity));
+    if (newCapacity == getCapacity())
+        return;
+
+    const int numKept = juce::jmin (count, newCapacity);
+
+    std::vector<Item> resized ((size_t) newCapacity);
+    for (int i = 0; i < numKept; ++i)
+        resized[(size_t) i] = (*this)[count - numKept + i];
+
+    points = std::move (resized);
+    head   = 0;
+    count  = numKept;
+    mask   = newCapacity - 1;
+}
+
+template <typename Item>
+void PitchGraphComponent::TimeRing<Item>::push (const Item& item) noexcept
+{
+    if (isFull())
+    {
+        head = (head + 1) & mask;
+        --count;
+    }
+
+    points[(size_t) ((head + count) & mask)] = item;
+    ++count;
+}
+
+template <typename Item>
+void PitchGraphComponent::TimeRing<Item>::dropOlderThan (double timestamp) noexcept
+{
+    const int numOld = lowerBound (timestamp);
+    head   = (head + numOld) & mask;
+    count -= numOld;
+}
+
+template <typename Item>
+int PitchGraphComponent::TimeRing<Item>::lowerBound (double timestamp) const noexcept
+{
+    int lo = 0, hi = count;
+
+    while (lo < hi)
+    {
+        const int mid = (lo + hi) / 2;
+        if ((*this)[mid].timestamp < timestamp)  lo = mid + 1;
+        else                                     hi = mid;
+    }
+
+    return lo;
+}
+
+// ── ChannelSummary ────────────────────────────────────────────────────────────
+
+void PitchGraphComponent::ChannelSummary::setCapacity (int numPoints)
+{
+    for (int level = 0; level < kNumLevels; ++level)
+        levels[(size_t) level].setCapacity (numPoints / pointsPerBucket (level) + 2);
+}
+
+void PitchGraphComponent::ChannelSummary::clear() noexcept
+{
+    for (auto& level : levels)
+        level.clear();
+
+    open = {};
+}
+
+void PitchGraphComponent::ChannelSummary::add (const DisplayPoint& pt) noexcept
+{
+    // Same gaps as the point curve: unvoiced and off-scale points
+    const bool voiced = pt.pitchHz > 0.0f
+                        && pt.midiNote >= kMidiMin - 1.5f
+                        && pt.midiNote <= kMidiMax + 1.5f;
+
+    addToLevel (0, { pt.timestamp, pt.timestamp,
+                     voiced ? pt.midiNote : std::numeric_limits<float>::max(),
+                     voiced ? pt.midiNote : std::numeric_limits<float>::lowest(),
+                     voiced ? pt.midiNote : -1.0f,
+                     1 });
+}
+
+void PitchGraphComponent::ChannelSummary::addToLevel (int level, const SummaryBucket& bucket) noexcept
+{
+    auto& filling = open[(size_t) level];
+
+    if (filling.numPoints == 0)
+    {
+        filling = bucket;
+    }
+    else
+    {
+        filling.endTimestamp = bucket.endTimestamp;
+        filling.minMidi      = juce::jmin (filling.minMidi, bucket.minMidi);
+        filling.maxMidi      = juce::jmax (filling.maxMidi, bucket.maxMidi);
+        filling.lastMidi     = bucket.lastMidi >= 0.0f ? bucket.lastMidi : filling.lastMidi;
+        filling.numPoints   += bucket.numPoints;
+    }
+
+    if (filling.numPoints < pointsPerBucket (level))
+        return;
+
+    const SummaryBucket done = filling;
+    filling = {};
+
+    levels[(size_t) level].push (done);
+
+    if (level + 1 < kNumLevels)
+        addToLevel (level + 1, done);
+}
+
+void PitchGraphComponent::ChannelSummary::dropOlderThan (double timestamp) noexcept
+{
+    for (auto& level : levels)
+        level.dropOlderThan (timestamp);
+}
+
+// ── Construction ─────────────────────────────────────────────────────────────
+
+PitchGraphComponent::PitchGraphComponent (PitchHistory& history)
+    : pitchHistory (history),
+      vblankAttachment (this, [this] { onVBlank(); })
+{
+    for (int level = 0; level < 256; ++level)
+    {
+        const float t      = (float) level / 255.0f;
+        const auto  colour = t < 0.5f ? Pal::spectrumLow.interpolatedWith (Pal::spectrumMid,  t * 2.0f)
+                                      : Pal::spectrumMid.interpolatedWith (Pal::spectrumHigh, t * 2.0f - 1.0f);
+        const float alpha  = 0.85f * std::pow (juce::jlimit (0.0f, 1.0f, (t - 0.15f) / 0.85f), 1.5f);
+
+        spectrogramPalette[(size_t) level] = colour.withAlpha (alpha).getPixelARGB();
+    }
+
+    reloadFromHistory();
+    pitchHistory.addListener (this);
+
+    setOpaque (true);     // we fully paint our bounds → JUCE skips painting behind us
+    setWantsKeyboardFocus (true);   // for the overlay shortcut
+}
+
+PitchGraphComponent::~PitchGraphComponent()
+{
+    setSpectrogramFeed (nullptr);
+    pitchHistory.removeListener (this);
+}
+
+void PitchGraphComponent::setDisplayWindow (float seconds)
+{
+    displayWindowSecs = seconds;
+    curveCache        = {};   // the time scale changed
+    resizeRings();
+    resizeSpectrogram();
+    repaint();
+}
+
+void PitchGraphComponent::setUseOpenGL (bool shouldUseOpenGL)
+{
+    if (shouldUseOpenGL == isUsingOpenGL())
+        return;
+
+    if (shouldUseOpenGL)
+    {
+        const PitchGraphGLRenderer::Style style { kLabelWidth, kMidiMin, kMidiMax,
+                                                  Pal::bg, Pal::blackKeyBand, Pal::semitoneLine,
+                                                  Pal::octaveLine, Pal::labelBg, Pal::labelDivider,
+                                                  Pal::pitchGlow.getFloatAlpha() };
+
+        glRenderer = std::make_unique<PitchGraphGLRenderer> (*this, style);
+        glRenderer->setChannelCapacity (ringCapacity());
+        glRenderer->setContinuousRendering (! isIdle);
+    }
+    else
+    {
+        glRenderer.reset();
+    }
+
+    // The GL output shows through the component layer, which only paints text
+    setOpaque (! shouldUseOpenGL);
+    reloadFromHistory();
+    repaint();
+}
+
+void PitchGraphComponent::setCurveRendering (CurveRendering mode)
+{
+    curveRendering = mode;
+    curveCache     = {};
+    repaint();
+}
+
+// ── Recorded sessions ─────────────────────────────────────────────────────────
+
+bool PitchGraphComponent::showSession (const juce::File& sessionFile)
+{
+    const bool wasShowingSession = isShowingSession();
+
+    if (! session.open (sessionFile))
+    {
+        if (wasShowingSession)
+            showLive();
+
+        return false;
+    }
+
+    // Session curves are drawn in paint(); the GL back end only knows the
+    // live rings
+    if (! wasShowingSession)
+    {
+        glBeforeSession = isUsingOpenGL();
+        setUseOpenGL (false);
+    }
+
+    timeLabelGlyphs.clear();   // session labels read h:mm:ss
+    setSessionView (session.getStartTime(), session.getEndTime() - session.getStartTime());
+    repaint();
+    return true;
+}
+
+void PitchGraphComponent::showLive()
+{
+    if (! isShowingSession())
+        return;
+
+    session.close();
+    sessionBuckets = {};
+    timeLabelGlyphs.clear();
+    curveCache     = {};
+    dataChanged    = true;   // catch up with what arrived meanwhile
+
+    if (glBeforeSession)
+        setUseOpenGL (true);
+
+    repaint();
+}
+
+void PitchGraphComponent::setSessionView (double startTime, double lengthSecs)
+{
+    if (! isShowingSession())
+        return;
+
+    const double sessionStart  = session.getStartTime();
+    const double sessionLength = juce::jmax (kMinSessionViewSecs, session.getEndTime() - sessionStart);
+
+    sessionViewLength = juce::jlimit (kMinSessionViewSecs, sessionLength, lengthSecs);
+    sessionViewStart  = juce::jlimit (sessionStart, sessionStart + sessionLength - sessionViewLength, startTime);
+    repaint();
+}
+
+void PitchGraphComponent::mouseDown (const juce::MouseEvent&)
+{
+    dragStartViewStart = sessionViewStart;
+}
+
+void PitchGraphComponent::mouseDrag (const juce::MouseEvent& e)
+{
+    if (! isShowingSession())
+        return;
+
+    const double secsPerPixel = sessionViewLength / (double) juce::jmax (1, getWidth() - kLabelWidth);
+    setSessionView (dragStartViewStart - e.getDistanceFromDragStartX() * secsPerPixel, sessionViewLength);
+}
+
+void PitchGraphComponent::mouseDoubleClick (const juce::MouseEvent&)
+{
+    if (isShowingSession())
+        setSessionView (session.getStartTime(), session.getEndTime() - session.getStartTime());
+}
+
+void PitchGraphComponent::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    if (! isShowingSession())
+    {
+        Component::mouseWheelMove (e, wheel);   // let a parent viewport scroll
+        return;
+    }
+
+    // Zoom around the time under the pointer; one wheel notch ≈ ×0.75
+    const double anchor = xToTime (e.position.x);
+    const double factor = std::pow (2.0, -4.0 * (double) wheel.deltaY);
+
+    setSessionView (anchor - (anchor - sessionViewStart) * factor, sessionViewLength * factor);
+}
+
+bool PitchGraphComponent::keyPressed (const juce::KeyPress& key)
+{
+    if (key == juce::KeyPress ('p', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        setShowPerformanceOverlay (! showPerfOverlay);
+        return true;
+    }
+
+    if (key == juce::KeyPress ('s', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        setShowSpectrogram (! showSpectrogram);
+        return true;
+    }
+
+    if (key == juce::KeyPress ('n', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        setShowNoteBlocks (! showNoteBlocks);
+        return true;
+    }
+
+    return false;
+}
+
+void PitchGraphComponent::setShowPerformanceOverlay (bool shouldShow)
+{
+    showPerfOverlay = shouldShow;
+    repaint();
+}
+
+void PitchGraphComponent::setPointRate (double newPointsPerSecond)
+{
+    if (newPointsPerSecond <= 0.0)
+        return;
+
+    pointsPerSecond = newPointsPerSecond;
+    resizeRings();
+    resizeSpectrogram();
+}
+
+int PitchGraphComponent::ringCapacity() const noexcept
+{
+    const double seconds = static_cast<double> (displayWindowSecs) + kPruneSlackSecs;
+    return static_cast<int> (std::ceil (seconds * pointsPerSecond * 1.25));
+}
+
+void PitchGraphComponent::resizeRings()
+{
+    for (auto& history : histories)
+        history.setCapacity (ringCapacity());
+
+    for (auto& summary : summaries)
+        summary.setCapacity (ringCapacity());
+
+    // Notes don't overlap, and the history keeps none shorter than this
+    const int noteCapacity = (int) std::ceil (((double) displayWindowSecs + kPruneSlackSecs) / NoteSegmenter::kMinNoteSeconds);
+
+    for (auto& notes : noteBlocks)
+        notes.setCapacity (noteCapacity);
+
+    if (glRenderer != nullptr)
+        glRenderer->setChannelCapacity (ringCapacity());
+}
+
+// ── Spectrogram ───────────────────────────────────────────────────────────────
+
+void PitchGraphComponent::setSpectrogramFeed (SpectrogramFeed* feed)
+{
+    if (spectrogramFeed != nullptr)
+        spectrogramFeed->setEnabled (false);
+
+    spectrogramFeed  = feed;
+    spectrogramCount = 0;
+
+    if (spectrogramFeed != nullptr)
+        spectrogramFeed->setEnabled (showSpectrogram);
+
+    repaint();
+}
+
+void PitchGraphComponent::setShowSpectrogram (bool shouldShow)
+{
+    showSpectrogram = shouldShow;
+    resizeSpectrogram();
+
+    if (spectrogramFeed != nullptr)
+        spectrogramFeed->setEnabled (showSpectrogram);
+
+    repaint();
+}
+
+void PitchGraphComponent::resizeSpectrogram()
+{
+    // The feed's rows are laid out for exactly this scale
+    static_assert ((float) SpectrogramFeed::kLowestNote  == kMidiMin
+                && (float) SpectrogramFeed::kHighestNote == kMidiMax,
+                   "the spectrogram rows must span the graph's note range");
+
+    spectrogramWrite = 0;
+    spectrogramCount = 0;
+
+    if (! showSpectrogram)
+    {
+        spectrogramImage = {};
+        spectrogramTimes = {};
+        return;
+    }
+
+    // One column per point, for the window plus some headroom
+    const int columns = juce::jlimit (16, kMaxSpectrogramColumns,
+                                      (int) std::ceil ((double) displayWindowSecs * pointsPerSecond * 1.25));
+
+    if (! spectrogramImage.isValid() || spectrogramImage.getWidth() != columns)
+        spectrogramImage = juce::Image (juce::Image::ARGB, columns, SpectrogramFeed::kNumRows, true);
+
+    spectrogramTimes.assign ((size_t) columns, 0.0);
+}
+
+int PitchGraphComponent::drainSpectrogram()
+{
+    if (spectrogramFeed == nullptr)
+        return 0;
+
+    if (! spectrogramImage.isValid())
+        return spectrogramFeed->getQueue().popAll ([] (const SpectrogramFeed::Column*, int) {});   // hidden: stale columns
+
+    const double offset   = pitchHistory.getLiveTimeOffset();
+    const int    capacity = spectrogramImage.getWidth();
+    juce::Image::BitmapData pixels (spectrogramImage, juce::Image::BitmapData::writeOnly);
+
+    return spectrogramFeed->getQueue().popAll ([&] (const SpectrogramFeed::Column* columns, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            const auto& column = columns[i];
+
+            // Row 0 of the column is the lowest note: the image's bottom row
+            for (int r = 0; r < SpectrogramFeed::kNumRows; ++r)
+                reinterpret_cast<juce::PixelARGB*> (pixels.getPixelPointer (spectrogramWrite, SpectrogramFeed::kNumRows - 1 - r))
+                    ->set (spectrogramPalette[column.levels[(size_t) r]]);
+
+            spectrogramTimes[(size_t) spectrogramWrite] = column.timestamp + offset;
+            spectrogramWrite = (spectrogramWrite + 1) % capacity;
+            spectrogramCount = juce::jmin (spectrogramCount + 1, capacity);
+        }
+    });
+}
+
+void PitchGraphComponent::drawSpectrogram (juce::Graphics& g) const
+{
+    if (spectrogramCount == 0 || ! spectrogramImage.isValid())
+        return;
+
+    const int capacity = spectrogramImage.getWidth();
+    const int oldest   = (spectrogramWrite - spectrogramCount + capacity) % capacity;
+    const int newest   = (spectrogramWrite - 1 + capacity) % capacity;
+
+    // Columns are a hop apart; their average spacing also covers a hop
+    // that changed without keeping a width per column
+    const double columnSecs = spectrogramCount > 1
+                                ? (spectrogramTimes[(size_t) newest] - spectrogramTimes[(size_t) oldest]) / (spectrogramCount - 1)
+                                : 1.0 / pointsPerSecond;
+    const float  rowScale   = (float) getHeight() / (float) SpectrogramFeed::kNumRows;
+
+    juce::Graphics::ScopedSaveState state (g);
+    g.reduceClipRegion (getLocalBounds().withTrimmedLeft (kLabelWidth + 1));
+    g.setImageResamplingQuality (juce::Graphics::lowResamplingQuality);
+
+    // A run of consecutive image columns, stretched from its first column's
+    // time to its last's
+    const auto drawRun = [&] (int first, int num)
+    {
+        if (num <= 0)
+            return;
+
+        const float x0 = timeToX (spectrogramTimes[(size_t) first] - 0.5 * columnSecs);
+        const float x1 = timeToX (spectrogramTimes[(size_t) (first + num - 1)] + 0.5 * columnSecs);
+
+        if (x1 <= x0 || x1 <= (float) kLabelWidth || x0 >= (float) getWidth())
+            return;
+
+        juce::Graphics::ScopedSaveState runState (g);
+        g.reduceClipRegion (juce::Rectangle<float> (x0, 0.0f, x1 - x0, (float) getHeight()).getSmallestIntegerContainer());
+        g.drawImageTransformed (spectrogramImage,
+                                juce::AffineTransform::translation ((float) -first, 0.0f)
+                                    .scaled ((x1 - x0) / (float) num, rowScale)
+                                    .translated (x0, 0.0f));
+    };
+
+    // The ring is at most two runs: oldest to the image's end, then from 0
+    const int firstRun = juce::jmin (spectrogramCount, capacity - oldest);
+    drawRun (oldest, firstRun);
+    drawRun (0, spectrogramCount - firstRun);
+}
+
+// ── Note blocks ───────────────────────────────────────────────────────────────
+
+void PitchGraphComponent::setShowNoteBlocks (bool shouldShow)
+{
+    showNoteBlocks = shouldShow;
+
+    if (showNoteBlocks)
+        pitchHistory.copyOpenNotes (openNotes);
+
+    repaint();
+}
+
+void PitchGraphComponent::drawNoteBlocks (juce::Graphics& g) const
+{
+    juce::Graphics::ScopedSaveState state (g);
+    g.reduceClipRegion (getLocalBounds().withTrimmedLeft (kLabelWidth + 1));
+
+    const double leftEdge   = viewTime - (double) displayWindowSecs;
+    const double pointSecs  = 1.0 / pointsPerSecond;   // a block also covers its last point's hop
+    const float  blockH     = (float) getHeight() / kMidiRange;   // one semitone
+    const float  rightLimit = (float) getWidth();
+
+    // False once the block starts off the right edge
+    const auto drawBlock = [&] (const NoteEvent& note)
+    {
+        const float x0 = timeToX (note.timestamp);
+        const float x1 = timeToX (note.endTimestamp + pointSecs);
+
+        if (x0 >= rightLimit)
+            return false;
+
+        if (x1 <= (float) kLabelWidth || note.midiNote < kMidiMin - 1.0f || note.midiNote > kMidiMax + 1.0f)
+            return true;
+
+        const float steadiness = 1.0f - juce::jlimit (0.0f, 1.0f, note.spreadCents / kUnsteadyCents);
+        const auto  colour     = curveColour (note.channel);
+        const juce::Rectangle<float> block (x0, midiToY (note.midiNote) - 0.5f * blockH,
+                                            juce::jmax (1.0f, x1 - x0), blockH);
+
+        g.setColour (colour.withAlpha (0.10f + 0.25f * steadiness));
+        g.fillRoundedRectangle (block, 3.0f);
+        g.setColour (colour.withAlpha (0.55f));
+        g.drawRoundedRectangle (block, 3.0f, 1.0f);
+
+        ++pointsDrawn;
+        return true;
+    };
+
+    for (const auto& notes : noteBlocks)
+    {
+        // Notes don't overlap, so only the one before the first starting
+        // inside the view can reach into it
+        for (int i = juce::jmax (0, notes.lowerBound (leftEdge) - 1); i < notes.size(); ++i)
+            if (! drawBlock (notes[i]))
+                break;
+    }
+
+    for (const auto& note : openNotes)
+        drawBlock (note);
+}
+
+void PitchGraphComponent::resized()
+{
+    backgroundCache = {};   // both re-rendered at the new size on the next paint
+    curveCache      = {};
+}
+
+// ── History updates ───────────────────────────────────────────────────────────
+
+void PitchGraphComponent::pitchPointsAdded (const PitchPoint* points, int numPoints)
+{
+    const auto& drain = pitchHistory.getLastDrain();
+    perfDrains[(size_t) (perfDrainCount++ % kPerfFrames)] = { static_cast<float> (drain.drainMs), drain.numPoints };
+
+    addPoints (points, numPoints);
+
+    if (showNoteBlocks)
+        pitchHistory.copyOpenNotes (openNotes);
+}
+
+void PitchGraphComponent::notesAdded (const NoteEvent* notes, int numNotes)
+{
+    addNotes (notes, numNotes);
+}
+
+void PitchGraphComponent::addNotes (const NoteEvent* notes, int numNotes)
+{
+    for (int i = 0; i < numNotes; ++i)
+    {
+        const NoteEvent& note = notes[i];
+        if (note.channel < 0 || note.channel >= kMaxCurves)
+            continue;
+
+        if ((size_t) note.channel >= noteBlocks.size())
+        {
+            noteBlocks.resize ((size_t) note.channel + 1);
+            resizeRings();
+        }
+
+        auto& channelNotes = noteBlocks[(size_t) note.channel];
+
+        // As for the points: grow rather than drop a note still in view
+        if (channelNotes.isFull()
+            && channelNotes[0].endTimestamp >= note.timestamp - displayWindowSecs - kPruneSlackSecs)
+            channelNotes.setCapacity (channelNotes.getCapacity() * 2);
+
+        channelNotes.push (note);
+    }
+}
+
+void PitchGraphComponent::addPoints (const PitchPoint* points, int numPoints)
+{
+    // Each channel's points arrive in time order, so every per-channel
+    // history stays sorted.
+    for (int i = 0; i < numPoints; ++i)
+    {
+        const PitchPoint& pt = points[i];
+        if (pt.channel < 0 || pt.channel >= kMaxCurves)
+            continue;
+
+        if ((size_t) pt.channel >= histories.size())
+        {
+            histories.resize ((size_t) pt.channel + 1);
+            summaries.resize ((size_t) pt.channel + 1);
+            resizeRings();
+        }
+
+        auto& history = histories[(size_t) pt.channel];
+        auto& summary = summaries[(size_t) pt.channel];
+
+        // A full ring whose oldest point is still needed means the point
+        // rate went up: grow rather than cut into the visible curve.
+        if (history.isFull()
+            && history[0].timestamp >= pt.timestamp - displayWindowSecs - kPruneSlackSecs)
+        {
+            history.setCapacity (history.getCapacity() * 2);
+            summary.setCapacity (history.getCapacity());
+        }
+
+        const float        midi = (pt.pitchHz > 0.0f) ? hzToMidi (pt.pitchHz) : -1.0f;
+        const DisplayPoint dp   { pt.pitchHz, midi, pt.timestamp };
+        history.push (dp);
+        summary.add  (dp);
+
+        if (glRenderer != nullptr)
+        {
+            // Same gaps as drawChannelCurve(): unvoiced and off-scale points
+            const bool onScale = midi >= kMidiMin - 1.5f && midi <= kMidiMax + 1.5f;
+            glRenderer->addPoint (pt.channel, onScale ? midi : -1.0f, pt.timestamp, curveColour (pt.channel));
+        }
+
+        if (pt.pitchHz > 0.0f && pt.channel == 0)
+            currentPitchHz = pt.pitchHz;
+
+        newestTimestamp = std::max (newestTimestamp, pt.timestamp);
+    }
+
+    if (numPoints > 0)
+        noteNewData();
+}
+
+void PitchGraphComponent::noteNewData()
+{
+    dataChanged   = true;
+    lastNewDataMs = juce::Time::getMillisecondCounterHiRes();
+
+    // How far the audio clock lags the wall clock, smoothed over batches so
+    // the jitter of their arrival doesn't show.  A jump (first data, a
+    // restored history, a transport relocation) is taken as is.
+    const double offset = lastNewDataMs * 0.001 - newestTimestamp;
+
+    if (! clockValid || std::abs (offset - clockOffset) > kClockResetSecs)
+    {
+        clockOffset = offset;
+        clockValid  = true;
+        viewTime    = newestTimestamp - kDisplayLatencySecs;
+    }
+    else
+    {
+        clockOffset += kClockSmoothing * (offset - clockOffset);
+    }
+
+    if (isIdle)
+    {
+        isIdle = false;
+
+        if (glRenderer != nullptr)
+            glRenderer->setContinuousRendering (true);
+    }
+}
+
+void PitchGraphComponent::pitchHistoryReplaced()
+{
+    curveCache       = {};
+    spectrogramCount = 0;   // its times were on the old timeline
+    reloadFromHistory();
+    repaint();
+}
+
+void PitchGraphComponent::reloadFromHistory()
+{
+    for (auto& history : histories)
+        history.clear();
+
+    for (auto& summary : summaries)
+        summary.clear();
+
+    for (auto& notes : noteBlocks)
+        notes.clear();
+
+    if (glRenderer != nullptr)
+        glRenderer->clear();
+
+    currentPitchHz  = 0.0f;
+    newestTimestamp = 0.0;
+    viewTime        = 0.0;
+    clockValid      = false;
+
+    std::vector<PitchPoint> points;
+    pitchHistory.copyPoints (points);
+    addPoints (points.data(), static_cast<int> (points.size()));
+
+    std::vector<NoteEvent> notes;
+    pitchHistory.copyNotes (notes);
+    addNotes (notes.data(), static_cast<int> (notes.size()));
+    pitchHistory.copyOpenNotes (openNotes);
+
+    pruneToDisplayWindow();
+}
+
+// ── Animation ─────────────────────────────────────────────────────────────────
+
+void PitchGraphComponent::onVBlank()
+{
+    if (isIdle || isShowingSession())
+        return;
+
+    if (drainSpectrogram() > 0)
+        dataChanged = true;
+
+    const double nowMs    = juce::Time::getMillisecondCounterHiRes();
+    const double target   = extrapolatedViewTime (nowMs * 0.001);
+    const double pxPerSec = (double) (getWidth() - kLabelWidth) / (double) displayWindowSecs;
+    const bool   scrolled = (target - viewTime) * pxPerSec >= kMinScrollPx;
+
+    if (! dataChanged && ! scrolled)
+    {
+        // The view has caught up with the data and stopped
+        if (nowMs - lastNewDataMs > kIdleAfterMs)
+        {
+            isIdle = true;
+
+            if (glRenderer != nullptr)
+                glRenderer->setContinuousRendering (false);
+        }
 
-PitchGraphComponent::PitchGraphComponent (PitchDataQueue& q)
-    : dataQueue (q)
-{
-    setOpaque (true);     // we fully paint our bounds → JUCE skips painting behind us
-    startTimerHz (30);    // 30 fps poll + repaint
+        return;
+    }
+
+    moveViewTo (target);
 }
 
-PitchGraphComponent::~PitchGraphComponent()
+void PitchGraphComponent::advanceViewTo (double viewTimeSecs)
 {
-    stopTimer();
-}
+    if (isShowingSession())
+        return;
 
-void PitchGraphComponent::resized() {}
+    if (drainSpectrogram() > 0)
+        dataChanged = true;
 
-// ── Timer callback ────────────────────────────────────────────────────────────
+    moveViewTo (juce::jmax (viewTime, viewTimeSecs));
+}
 
-void PitchGraphComponent::timerCallback()
+void PitchGraphComponent::moveViewTo (double target)
 {
-    PitchPoint pt;
-    while (dataQueue.pop (pt))
+    viewTime = target;
+
+    if (dataChanged)
     {
-        const float midi = (pt.pitchHz > 0.0f) ? hzToMidi (pt.pitchHz) : -1.0f;
-        history.push_back ({ pt.pitchHz, midi, pt.timestamp });
+        dataChanged = false;
+        pruneToDisplayWindow();
+    }
 
-        if (pt.pitchHz > 0.0f)
-            currentPitchHz = pt.pitchHz;
+    if (glRenderer != nullptr)
+        glRenderer->setView (viewTime, displayWindowSecs);
 
-        newestTimestamp = std::max (newestTimestamp, pt.timestamp);
-    }
+    // Curves, time axis and HUD; the label column never changes with data
+    repaint (getLocalBounds().withTrimmedLeft (kLabelWidth + 1));
+}
 
-    // Prune history older than display window + 1 s extra buffer
+void PitchGraphComponent::pruneToDisplayWindow()
+{
+    // Prune history older than display window + kPruneSlackSecs (the view
+    // trails newestTimestamp by well under the slack)
     const double pruneBelow = newestTimestamp
-                              - static_cast<double> (displayWindowSecs) - 1.0;
-    while (!history.empty() && history.front().timestamp < pruneBelow)
-        history.pop_front();
+                              - static_cast<double> (displayWindowSecs) - kPruneSlackSecs;
+    for (auto& history : histories)
+        history.dropOlderThan (pruneBelow);
 
-    repaint();
+    for (auto& summary : summaries)
+        summary.dropOlderThan (pruneBelow);
+
+    // By start time, keeping a note that began earlier but ends inside
+    for (auto& notes : noteBlocks)
+    {
+        const int firstKept = notes.lowerBound (pruneBelow) - 1;
+
+        if (firstKept >= 0)
+            notes.dropOlderThan (notes[firstKept].endTimestamp >= pruneBelow ? notes[firstKept].timestamp
+                                                                              : pruneBelow);
+    }
+}
+
+double PitchGraphComponent::extrapolatedViewTime (double nowSecs) const noexcept
+{
+    if (! clockValid)
+        return newestTimestamp;
+
+    const double t = nowSecs - clockOffset - kDisplayLatencySecs;
+    return juce::jmin (juce::jmax (t, viewTime), newestTimestamp + kMaxExtrapolationSecs);
 }
 
 // ── Coordinate conversion ─────────────────────────────────────────────────────
@@ -107,24 +905,136 @@ float PitchGraphComponent::midiToY (float midiNote) const noexcept
     return h - (midiNote - kMidiMin) / kMidiRange * h;
 }
 
+double PitchGraphComponent::viewRightEdge() const noexcept
+{
+    return isShowingSession() ? sessionViewStart + sessionViewLength : viewTime;
+}
+
+double PitchGraphComponent::viewSeconds() const noexcept
+{
+    return isShowingSession() ? sessionViewLength : static_cast<double> (displayWindowSecs);
+}
+
 float PitchGraphComponent::timeToX (double timestamp) const noexcept
+{
+    return timeToX (timestamp, viewRightEdge());
+}
+
+float PitchGraphComponent::timeToX (double timestamp, double rightEdgeTime) const noexcept
 {
     const float  graphW      = static_cast<float> (getWidth() - kLabelWidth);
-    const double windowStart = newestTimestamp - static_cast<double> (displayWindowSecs);
-    const float  t = static_cast<float> ((timestamp - windowStart) / displayWindowSecs);
+    const double windowStart = rightEdgeTime - viewSeconds();
+    const float  t = static_cast<float> ((timestamp - windowStart) / viewSeconds());
     return static_cast<float> (kLabelWidth) + t * graphW;
 }
 
+double PitchGraphComponent::xToTime (float x) const noexcept
+{
+    const double graphW = (double) juce::jmax (1, getWidth() - kLabelWidth);
+    return viewRightEdge() - viewSeconds()
+           + (double) (x - static_cast<float> (kLabelWidth)) / graphW * viewSeconds();
+}
+
 // ── Paint orchestrator ────────────────────────────────────────────────────────
 
 void PitchGraphComponent::paint (juce::Graphics& g)
 {
-    drawBackground      (g);
-    drawPianoRollGrid   (g);
-    drawNoteLabels      (g);
-    drawPitchCurve      (g);
-    drawTimeAxis        (g);
-    drawCurrentPitchHUD (g);
+    TRACE_THREAD_NAME ("Message thread");
+    TRACE_SCOPE ("pitch graph paint");
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    FrameStats frame {};
+    frame.intervalMs = lastPaintTicks != 0 ? ticksToMs (startTicks - lastPaintTicks) : 0.0f;
+    lastPaintTicks   = startTicks;
+    pointsDrawn      = 0;
+
+    auto       lapTicks = startTicks;
+    const auto endPass  = [&lapTicks] (float& passMs)
+    {
+        const auto now = juce::Time::getHighResolutionTicks();
+        passMs   = ticksToMs (now - lapTicks);
+        lapTicks = now;
+    };
+
+    const bool useGL      = glRenderer != nullptr && ! isShowingSession();
+    float      pixelScale = 1.0f;
+
+    if (useGL)
+    {
+        // Grid and curves are rendered underneath by glRenderer
+        drawNoteLabels (g);
+    }
+    else
+    {
+        // The scale follows the display we're on, so moving the window to a
+        // screen with a different DPI re-renders the cache at full resolution.
+        pixelScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (! backgroundCache.isValid() || pixelScale != backgroundScale)
+            renderBackgroundCache (pixelScale);
+
+        g.drawImage (backgroundCache, getLocalBounds().toFloat());
+    }
+
+    endPass (frame.backgroundMs);
+
+    // Under the curves; the GL back end draws those first, underneath
+    if (showSpectrogram && ! useGL && ! isShowingSession())
+        drawSpectrogram (g);
+
+    endPass (frame.spectrogramMs);
+
+    if (showNoteBlocks && ! useGL && ! isShowingSession())
+        drawNoteBlocks (g);
+
+    endPass (frame.notesMs);
+
+    if (isShowingSession())
+        drawSessionCurves (g);
+    else if (! useGL)
+        drawPitchCurve (g, pixelScale);
+    else if (! hasAnyPoints())
+        drawWaitingPrompt (g);
+
+    endPass (frame.curvesMs);
+
+    drawTimeAxis (g);
+    endPass (frame.axisMs);
+
+    if (! isShowingSession())   // the live readout means nothing over a recording
+        drawCurrentPitchHUD (g);
+
+    endPass (frame.hudMs);
+
+    frame.pointsDrawn = pointsDrawn;
+    perfFrames[(size_t) (perfFrameCount++ % kPerfFrames)] = frame;
+
+    // After the figures are taken, so the overlay's own cost isn't in them
+    if (showPerfOverlay)
+        drawPerformanceOverlay (g);
+}
+
+void PitchGraphComponent::renderBackgroundCache (float pixelScale)
+{
+    backgroundScale = pixelScale;
+
+    const int w = juce::roundToInt ((float) getWidth()  * pixelScale);
+    const int h = juce::roundToInt ((float) getHeight() * pixelScale);
+
+    if (w <= 0 || h <= 0)
+    {
+        backgroundCache = {};
+        return;
+    }
+
+    backgroundCache = juce::Image (juce::Image::RGB, w, h, false);
+
+    juce::Graphics cacheGraphics (backgroundCache);
+    cacheGraphics.addTransform (juce::AffineTransform::scale (pixelScale));
+
+    drawBackground    (cacheGraphics);
+    drawPianoRollGrid (cacheGraphics);
+    drawNoteLabels    (cacheGraphics);
 }
 
 // ── Background ────────────────────────────────────────────────────────────────
@@ -184,8 +1094,31 @@ void PitchGraphComponent::drawPianoRollGrid (juce::Graphics& g) const
 
 // ── Note labels ───────────────────────────────────────────────────────────────
 
+void PitchGraphComponent::layOutNoteLabels() const
+{
+    // C notes bold and larger (octave landmarks), as drawNoteLabels() colours them
+    const juce::Font octaveFont = juce::Font (juce::FontOptions (10.0f)).boldened();
+    const juce::Font noteFont   { juce::FontOptions (9.0f) };
+
+    for (int i = 0; i < kNumNotes; ++i)
+    {
+        const int midi = static_cast<int> (kMidiMin) + i;
+        noteLabelGlyphs[(size_t) i] = layOutText (midi % 12 == 0 ? octaveFont : noteFont,
+                                                  midiToNoteName (midi),
+                                                  { 2.0f, -8.0f, (float) (kLabelWidth - 5), 16.0f },
+                                                  juce::Justification::centredRight);
+    }
+
+    noteLabelsLaidOut = true;
+}
+
 void PitchGraphComponent::drawNoteLabels (juce::Graphics& g) const
 {
+    // Laid out by the first paint, so an editor that's made but never
+    // shown doesn't load the fonts
+    if (! noteLabelsLaidOut)
+        layOutNoteLabels();
+
     for (int midi = static_cast<int> (kMidiMin);
              midi <= static_cast<int> (kMidiMax); ++midi)
     {
@@ -197,47 +1130,186 @@ void PitchGraphComponent::drawNoteLabels (juce::Graphics& g) const
 
         const float y = midiToY (static_cast<float> (midi));
 
-        if (semitone == 0)
-        {
-            // C notes: bold + brighter (octave landmarks)
-            g.setColour (Pal::octaveLine.brighter (0.5f));
-            g.setFont (juce::Font (juce::FontOptions (10.0f)).boldened());
-        }
-        else
-        {
-            g.setColour (Pal::noteLabel);
-            g.setFont (juce::FontOptions (9.0f));
-        }
+        // C notes: brighter (octave landmarks); the glyphs carry the font
+        g.setColour (semitone == 0 ? Pal::octaveLine.brighter (0.5f) : Pal::noteLabel);
 
-        g.drawText (midiToNoteName (midi),
-                    2, static_cast<int> (y) - 8,
-                    kLabelWidth - 5, 16,
-                    juce::Justification::centredRight);
+        noteLabelGlyphs[(size_t) (midi - static_cast<int> (kMidiMin))]
+            .draw (g, juce::AffineTransform::translation (0.0f, static_cast<float> (static_cast<int> (y))));
     }
 }
 
 // ── Pitch curve ───────────────────────────────────────────────────────────────
 
-void PitchGraphComponent::drawPitchCurve (juce::Graphics& g) const
+void PitchGraphComponent::drawPitchCurve (juce::Graphics& g, float pixelScale)
+{
+    if (! hasAnyPoints())
+    {
+        drawWaitingPrompt (g);
+        return;
+    }
+
+    if (curveRendering == CurveRendering::scrollBlit)
+    {
+        updateCurveCache (pixelScale);
+
+        // The image's left edge holds curve scrolled in under the labels
+        juce::Graphics::ScopedSaveState state (g);
+        g.reduceClipRegion (getLocalBounds().withTrimmedLeft (kLabelWidth));
+        g.drawImage (curveCache, getLocalBounds().toFloat());
+        return;
+    }
+
+    // Highest channel first, so channel 0 (the HUD's) ends up on top
+    for (int ch = static_cast<int> (histories.size()); --ch >= 0;)
+    {
+        const auto& history = histories[(size_t) ch];
+        drawChannelCurve (g, ch, firstVisibleIndex (history), history.size(), viewTime);
+    }
+}
+
+bool PitchGraphComponent::hasAnyPoints() const noexcept
+{
+    return std::any_of (histories.begin(), histories.end(),
+                        [] (const auto& history) { return ! history.empty(); });
+}
+
+void PitchGraphComponent::drawWaitingPrompt (juce::Graphics& g) const
+{
+    // No data yet — show a prompt
+    g.setColour (Pal::noteLabel.withAlpha (0.4f));
+    g.setFont (juce::FontOptions (14.0f));
+    g.drawText ("Waiting for audio input...",
+                kLabelWidth, 0,
+                getWidth() - kLabelWidth, getHeight(),
+                juce::Justification::centred);
+}
+
+int PitchGraphComponent::firstVisibleIndex (const DisplayRing& history) const noexcept
+{
+    // One point before the window, so a segment that enters from the left
+    // edge is still drawn.
+    const double windowStart = viewTime - static_cast<double> (displayWindowSecs);
+    return juce::jmax (0, history.lowerBound (windowStart) - 1);
+}
+
+void PitchGraphComponent::updateCurveCache (float pixelScale)
+{
+    const int w = juce::roundToInt ((float) getWidth()  * pixelScale);
+    const int h = juce::roundToInt ((float) getHeight() * pixelScale);
+
+    const double pxPerSecond = (double) (getWidth() - kLabelWidth) * pixelScale
+                               / (double) displayWindowSecs;
+    const double elapsed     = viewTime - curveTime;
+
+    if (! curveCache.isValid() || pixelScale != curveScale
+        || curveCache.getWidth() != w || curveCache.getHeight() != h
+        || elapsed < 0.0 || elapsed * pxPerSecond >= (double) w
+        || lastDrawnTimestamps.size() < histories.size())
+    {
+        renderCurveCache (pixelScale);
+        return;
+    }
+
+    // Scroll by whole physical pixels; curveTime advances by exactly what
+    // was scrolled, so the fractional remainder carries to the next frame.
+    const int shift = static_cast<int> (elapsed * pxPerSecond);
+
+    if (shift > 0)
+    {
+        curveCache.moveImageSection (0, 0, shift, 0, w - shift, h);
+        curveCache.clear ({ w - shift, 0, shift, h });
+        curveTime += (double) shift / pxPerSecond;
+    }
+
+    juce::Graphics cacheGraphics (curveCache);
+    cacheGraphics.addTransform (juce::AffineTransform::scale (pixelScale));
+
+    for (int ch = static_cast<int> (histories.size()); --ch >= 0;)
+    {
+        const auto& history  = histories[(size_t) ch];
+        double&     lastDrawn = lastDrawnTimestamps[(size_t) ch];
+
+        // Points past the right edge would be drawn off the image and lost,
+        // so they wait until the view reaches them.
+        const int end = history.lowerBound (curveTime);
+
+        if (end == 0 || history[end - 1].timestamp <= lastDrawn)
+            continue;
+
+        // Start at the newest point already drawn so the new segment joins it
+        const int first = juce::jmax (firstVisibleIndex (history), history.lowerBound (lastDrawn));
+        drawChannelCurve (cacheGraphics, ch, first, end, curveTime);
+        lastDrawn = history[end - 1].timestamp;
+    }
+}
+
+void PitchGraphComponent::renderCurveCache (float pixelScale)
+{
+    curveScale = pixelScale;
+    curveTime  = viewTime;
+    lastDrawnTimestamps.assign (histories.size(), std::numeric_limits<double>::lowest());
+
+    const int w = juce::roundToInt ((float) getWidth()  * pixelScale);
+    const int h = juce::roundToInt ((float) getHeight() * pixelScale);
+
+    if (w <= 0 || h <= 0)
+    {
+        curveCache = {};
+        return;
+    }
+
+    curveCache = juce::Image (juce::Image::ARGB, w, h, true);
+
+    juce::Graphics cacheGraphics (curveCache);
+    cacheGraphics.addTransform (juce::AffineTransform::scale (pixelScale));
+
+    for (int ch = static_cast<int> (histories.size()); --ch >= 0;)
+    {
+        const auto& history = histories[(size_t) ch];
+        const int   end     = history.lowerBound (curveTime);
+        if (end == 0)
+            continue;
+
+        drawChannelCurve (cacheGraphics, ch, firstVisibleIndex (history), end, curveTime);
+        lastDrawnTimestamps[(size_t) ch] = history[end - 1].timestamp;
+    }
+}
+
+void PitchGraphComponent::drawChannelCurve (juce::Graphics& g, int channel,
+                                            int first, int end, double rightEdgeTime) const
 {
-    if (history.empty())
+    const auto&  history = histories[(size_t) channel];
+    const auto   colour  = curveColour (channel);
+
+    if (first >= end)
+        return;
+
+    // Density of the whole visible window, so full and incremental redraws
+    // agree on the level: the widest buckets still under a pixel's worth
+    const float graphWidth     = static_cast<float> (juce::jmax (1, getWidth() - kLabelWidth));
+    const float pointsPerPixel = static_cast<float> (history.size() - firstVisibleIndex (history)) / graphWidth;
+
+    int level = -1;
+    while (level + 1 < ChannelSummary::kNumLevels
+           && (float) ChannelSummary::pointsPerBucket (level + 1) <= pointsPerPixel)
+        ++level;
+
+    if (level >= 0)
     {
-        // No data yet — show a prompt
-        g.setColour (Pal::noteLabel.withAlpha (0.4f));
-        g.setFont (juce::FontOptions (14.0f));
-        g.drawText ("Waiting for audio input...",
-                    kLabelWidth, 0,
-                    getWidth() - kLabelWidth, getHeight(),
-                    juce::Justification::centred);
+        drawChannelSummary (g, channel, level, first, end, rightEdgeTime);
         return;
     }
 
+    pointsDrawn += end - first;
+
     // Build voiced segments; unvoiced gaps break the path into sub-paths.
     juce::Path curvePath;
     bool inSegment = false;
 
-    for (const auto& pt : history)
+    for (int i = first; i < end; ++i)
     {
+        const auto& pt = history[i];
+
         // Skip unvoiced frames and out-of-range notes
         if (pt.pitchHz <= 0.0f
             || pt.midiNote < kMidiMin - 1.5f
@@ -247,7 +1319,7 @@ void PitchGraphComponent::drawPitchCurve (juce::Graphics& g) const
             continue;
         }
 
-        const float x = timeToX  (pt.timestamp);
+        const float x = timeToX  (pt.timestamp, rightEdgeTime);
         const float y = midiToY  (pt.midiNote);
 
         if (!inSegment)
@@ -261,28 +1333,147 @@ void PitchGraphComponent::drawPitchCurve (juce::Graphics& g) const
         }
     }
 
+    strokeCurve (g, curvePath, colour);
+
+    // ── Dot at each measurement point ─────────────────────────────────────
+    g.setColour (colour);
+    for (int i = first; i < end; ++i)
+    {
+        const auto& pt = history[i];
+        if (pt.pitchHz <= 0.0f) continue;
+        const float x = timeToX (pt.timestamp, rightEdgeTime);
+        const float y = midiToY (pt.midiNote);
+        g.fillEllipse (x - 2.0f, y - 2.0f, 4.0f, 4.0f);
+    }
+}
+
+void PitchGraphComponent::drawChannelSummary (juce::Graphics& g, int channel, int level,
+                                              int firstPoint, int endPoint, double rightEdgeTime) const
+{
+    const auto& buckets = summaries[(size_t) channel].getLevel (level);
+    const auto& history = histories[(size_t) channel];
+    const auto  colour  = curveColour (channel);
+    const auto& newest  = history[endPoint - 1];
+
+    // One bucket before the first point, so the line joins what's already drawn
+    const int first = juce::jmax (0, buckets.lowerBound (history[firstPoint].timestamp) - 1);
+
+    juce::Path                  curvePath;
+    juce::RectangleList<float>  spans;
+    bool                        inSegment = false;
+
+    const auto addPoint = [&] (double timestamp, float midiNote)
+    {
+        const float x = timeToX (timestamp, rightEdgeTime);
+        const float y = midiToY (midiNote);
+
+        if (inSegment)  curvePath.lineTo (x, y);
+        else            curvePath.startNewSubPath (x, y);
+
+        inSegment = true;
+    };
+
+    for (int i = first; i < buckets.size(); ++i)
+    {
+        const auto& bucket = buckets[i];
+
+        if (bucket.endTimestamp > newest.timestamp)
+            break;
+
+        ++pointsDrawn;
+
+        if (bucket.lastMidi < 0.0f)   // nothing voiced in the whole bucket
+        {
+            inSegment = false;
+            continue;
+        }
+
+        addPoint (bucket.endTimestamp, bucket.lastMidi);
+
+        const float x      = timeToX (bucket.endTimestamp, rightEdgeTime);
+        const float top    = midiToY (bucket.maxMidi);
+        const float bottom = midiToY (bucket.minMidi);
+        spans.addWithoutMerging ({ x - 1.0f, top - 1.0f, 2.0f, bottom - top + 2.0f });
+    }
+
+    // Points not yet in a complete bucket span less than a pixel: just
+    // carry the line on to the newest one.
+    if (inSegment && newest.pitchHz > 0.0f
+        && newest.midiNote >= kMidiMin - 1.5f && newest.midiNote <= kMidiMax + 1.5f)
+        addPoint (newest.timestamp, newest.midiNote);
+
+    g.setColour (colour.withAlpha (0.5f));
+    g.fillRectList (spans);
+
+    strokeCurve (g, curvePath, colour);
+}
+
+void PitchGraphComponent::strokeCurve (juce::Graphics& g, const juce::Path& path, juce::Colour colour)
+{
     // ── Glow pass (wide, semi-transparent) ───────────────────────────────
-    g.setColour (Pal::pitchGlow);
-    g.strokePath (curvePath,
+    g.setColour (colour.withAlpha (Pal::pitchGlow.getAlpha()));
+    g.strokePath (path,
                   juce::PathStrokeType (7.0f,
                                         juce::PathStrokeType::curved,
                                         juce::PathStrokeType::rounded));
 
     // ── Main line ─────────────────────────────────────────────────────────
-    g.setColour (Pal::pitchLine);
-    g.strokePath (curvePath,
+    g.setColour (colour);
+    g.strokePath (path,
                   juce::PathStrokeType (2.0f,
                                         juce::PathStrokeType::curved,
                                         juce::PathStrokeType::rounded));
+}
 
-    // ── Dot at each measurement point ─────────────────────────────────────
-    g.setColour (Pal::pitchLine);
-    for (const auto& pt : history)
+void PitchGraphComponent::drawSessionCurves (juce::Graphics& g)
+{
+    const int    graphWidth = juce::jmax (1, getWidth() - kLabelWidth);
+    const double viewEnd    = sessionViewStart + sessionViewLength;
+
+    juce::Graphics::ScopedSaveState state (g);
+    g.reduceClipRegion (getLocalBounds().withTrimmedLeft (kLabelWidth + 1));
+
+    // Highest channel first, as in the live view
+    for (int ch = session.getNumChannels(); --ch >= 0;)
     {
-        if (pt.pitchHz <= 0.0f) continue;
-        const float x = timeToX (pt.timestamp);
-        const float y = midiToY (pt.midiNote);
-        g.fillEllipse (x - 2.0f, y - 2.0f, 4.0f, 4.0f);
+        const double bucketSecs = session.getBuckets (ch, sessionViewStart, viewEnd, graphWidth, sessionBuckets);
+        const auto   colour     = curveColour (ch);
+
+        pointsDrawn += static_cast<int> (sessionBuckets.size());
+
+        juce::Path                  curvePath;
+        juce::RectangleList<float>  spans;
+        bool                        inSegment = false;
+
+        for (const auto& bucket : sessionBuckets)
+        {
+            // Empty, unvoiced and off-scale spans break the line
+            if (bucket.lastMidi < kMidiMin - 1.5f || bucket.lastMidi > kMidiMax + 1.5f)
+            {
+                inSegment = false;
+                continue;
+            }
+
+            const float x = timeToX (bucket.timestamp + 0.5 * bucketSecs);
+            const float y = midiToY (bucket.lastMidi);
+
+            if (inSegment)  curvePath.lineTo (x, y);
+            else            curvePath.startNewSubPath (x, y);
+
+            inSegment = true;
+
+            if (bucketSecs > 0.0)
+            {
+                const float top    = midiToY (bucket.maxMidi);
+                const float bottom = midiToY (bucket.minMidi);
+                spans.addWithoutMerging ({ x - 1.0f, top - 1.0f, 2.0f, bottom - top + 2.0f });
+            }
+        }
+
+        g.setColour (colour.withAlpha (0.5f));
+        g.fillRectList (spans);
+
+        strokeCurve (g, curvePath, colour);
     }
 }
 
@@ -293,26 +1484,72 @@ void PitchGraphComponent::drawTimeAxis (juce::Graphics& g) const
     const float h = static_cast<float> (getHeight());
     const float w = static_cast<float> (getWidth());
 
-    const double windowStart = newestTimestamp - static_cast<double> (displayWindowSecs);
+    const double windowSecs  = viewSeconds();
+    const double windowStart = viewRightEdge() - windowSecs;
+
+    // Session times count from the start of the recording
+    const bool   inSession = isShowingSession();
+    const double origin    = inSession ? session.getStartTime() : 0.0;
+
+    // Whole-second ticks, spread out as the view zooms out so labels
+    // stay at least kMinTickSpacingPx apart
+    static constexpr int    kTickSteps[]      = { 1, 2, 5, 10, 15, 30, 60, 120, 300, 600, 900, 1800, 3600 };
+    static constexpr double kMinTickSpacingPx = 40.0;
+
+    const double pxPerSecond = (double) (getWidth() - kLabelWidth) / windowSecs;
+    int step = kTickSteps[std::size (kTickSteps) - 1];
+
+    for (int candidate : kTickSteps)
+    {
+        if (candidate * pxPerSecond >= kMinTickSpacingPx)
+        {
+            step = candidate;
+            break;
+        }
+    }
 
     g.setColour (Pal::timeTick.withAlpha (0.7f));
-    g.setFont (juce::FontOptions (9.0f));
 
-    const int firstSec = static_cast<int> (std::ceil  (windowStart));
-    const int lastSec  = static_cast<int> (std::floor (newestTimestamp));
+    const auto firstSec = static_cast<juce::int64> (std::ceil  ((windowStart - origin) / step)) * step;
+    const auto lastSec  = static_cast<juce::int64> (std::floor ((windowStart + windowSecs - origin) / step)) * step;
 
-    for (int sec = firstSec; sec <= lastSec; ++sec)
+    for (auto sec = firstSec; sec <= lastSec; sec += step)
     {
-        const float x = timeToX (static_cast<double> (sec));
+        const float x = timeToX (origin + static_cast<double> (sec));
         if (x < static_cast<float> (kLabelWidth) || x > w) continue;
 
         // Tick mark
         g.drawVerticalLine (static_cast<int> (x), h - 18.0f, h - 2.0f);
 
-        // Time label
-        g.drawText (juce::String (sec) + "s",
-                    static_cast<int> (x) - 16, static_cast<int> (h) - 16, 32, 12,
-                    juce::Justification::centred);
+        // Time label: "12s" live, "1:02:03" / "2:03" in a session
+        auto cached = timeLabelGlyphs.find (sec);
+
+        if (cached == timeLabelGlyphs.end())
+        {
+            juce::String label = juce::String (sec) + "s";
+
+            if (inSession)
+            {
+                const auto hours = sec / 3600, minutes = (sec / 60) % 60, seconds = sec % 60;
+                label = (hours > 0 ? juce::String (hours) + ":" + juce::String (minutes).paddedLeft ('0', 2)
+                                   : juce::String (minutes))
+                        + ":" + juce::String (seconds).paddedLeft ('0', 2);
+            }
+
+            cached = timeLabelGlyphs.emplace (sec, layOutText (juce::FontOptions (9.0f), label,
+                                                               { -20.0f, 0.0f, 40.0f, 12.0f },
+                                                               juce::Justification::centred)).first;
+        }
+
+        cached->second.draw (g, juce::AffineTransform::translation (static_cast<float> (static_cast<int> (x)),
+                                                                    static_cast<float> (static_cast<int> (h) - 16)));
+    }
+
+    // Live labels scroll off for good; keep only what's on screen
+    if ((int) timeLabelGlyphs.size() > kMaxTimeLabels)
+    {
+        timeLabelGlyphs.erase (timeLabelGlyphs.begin(), timeLabelGlyphs.lower_bound (firstSec));
+        timeLabelGlyphs.erase (timeLabelGlyphs.upper_bound (lastSec), timeLabelGlyphs.end());
     }
 
     // Bottom border line
@@ -321,17 +1558,110 @@ void PitchGraphComponent::drawTimeAxis (juce::Graphics& g) const
                           static_cast<float> (kLabelWidth), w);
 }
 
+// ── Performance overlay ───────────────────────────────────────────────────────
+
+void PitchGraphComponent::drawPerformanceOverlay (juce::Graphics& g) const
+{
+    struct Figure
+    {
+        double sum { 0.0 }, worst { 0.0 };
+        int    count { 0 };
+
+        void   add  (double v) noexcept { sum += v; worst = juce::jmax (worst, v); ++count; }
+        double mean () const noexcept   { return count > 0 ? sum / count : 0.0; }
+    };
+
+    Figure background, spectrogram, notes, curves, axis, hud, points, interval, drainMs, drainPoints;
+    double intervalSquares = 0.0;
+
+    for (juce::uint32 i = 0; i < juce::jmin (perfFrameCount, kPerfFrames); ++i)
+    {
+        const auto& f = perfFrames[(size_t) i];
+        background.add (f.backgroundMs);
+        spectrogram.add (f.spectrogramMs);
+        notes     .add (f.notesMs);
+        curves    .add (f.curvesMs);
+        axis      .add (f.axisMs);
+        hud       .add (f.hudMs);
+        points    .add (f.pointsDrawn);
+
+        if (f.intervalMs > 0.0f)
+        {
+            interval.add (f.intervalMs);
+            intervalSquares += (double) f.intervalMs * f.intervalMs;
+        }
+    }
+
+    for (juce::uint32 i = 0; i < juce::jmin (perfDrainCount, kPerfFrames); ++i)
+    {
+        drainMs    .add (perfDrains[(size_t) i].drainMs);
+        drainPoints.add (perfDrains[(size_t) i].numPoints);
+    }
+
+    const double jitter = interval.count > 0
+                            ? std::sqrt (juce::jmax (0.0, intervalSquares / interval.count - interval.mean() * interval.mean()))
+                            : 0.0;
+
+    const auto ms = [] (const Figure& f)
+    {
+        return juce::String (f.mean(), 2) + " ms  (max " + juce::String (f.worst, 2) + ")";
+    };
+
+    const juce::String lines[] =
+    {
+        "background  " + ms (background),
+        "spectrogram " + ms (spectrogram),
+        "note blocks " + ms (notes),
+        "curves      " + ms (curves),
+        "time axis   " + ms (axis),
+        "HUD         " + ms (hud),
+        "points      " + juce::String (juce::roundToInt (points.mean())) + "  (max " + juce::String (juce::roundToInt (points.worst)) + ")",
+        "queue       " + juce::String (juce::roundToInt (drainPoints.mean())) + " pts, drain " + ms (drainMs),
+        "frame       " + juce::String (interval.mean(), 1) + " ms, jitter " + juce::String (jitter, 1) + " ms",
+        "dropped     " + juce::String ((juce::int64) pitchHistory.getLastDrain().pointsDropped)
+    };
+
+    constexpr int lineH = 13, boxW = 250;
+    const int     boxH  = (int) std::size (lines) * lineH + 10;
+    const int     boxX  = kLabelWidth + 10;
+    const int     boxY  = 10;
+
+    g.setColour (Pal::hudBg);
+    g.fillRoundedRectangle ((float) boxX, (float) boxY, (float) boxW, (float) boxH, 5.0f);
+
+    g.setColour (Pal::noteLabel);
+    g.setFont (juce::FontOptions (juce::Font::getDefaultMonospacedFontName(), 10.0f, juce::Font::plain));
+
+    for (int i = 0; i < (int) std::size (lines); ++i)
+        g.drawText (lines[i], boxX + 8, boxY + 5 + i * lineH, boxW - 16, lineH,
+                    juce::Justification::centredLeft);
+}
+
 // ── HUD (current pitch readout) ───────────────────────────────────────────────
 
 void PitchGraphComponent::drawCurrentPitchHUD (juce::Graphics& g) const
 {
-    const juce::String noteText =
-        (currentPitchHz > 0.0f)
-        ? midiToNoteName (roundToMidi (currentPitchHz))
-              + "  " + juce::String (static_cast<int> (currentPitchHz)) + " Hz"
-        : "– – –";
-
     constexpr int hudW = 140, hudH = 30;
+
+    // The readout only changes with the rounded note or Hz value
+    const int midi = (currentPitchHz > 0.0f) ? roundToMidi (currentPitchHz) : -1;
+    const int hz   = static_cast<int> (currentPitchHz);
+
+    if (midi != hudMidi || hz != hudHz)
+    {
+        hudMidi = midi;
+        hudHz   = hz;
+
+        const juce::String noteText =
+            (midi >= 0)
+            ? midiToNoteName (midi) + "  " + juce::String (hz) + " Hz"
+            : "– – –";
+
+        hudGlyphs = layOutText (juce::Font (juce::FontOptions (13.0f)).boldened(), noteText,
+                                { 0.0f, 0.0f, (float) hudW, (float) hudH },
+                                juce::Justification::centred);
+    }
+
     const int     hudX = getWidth()  - hudW - 10;
     const int     hudY = 10;
 
@@ -349,6 +1679,5 @@ void PitchGraphComponent::drawCurrentPitchHUD (juce::Graphics& g) const
 
     // Text
     g.setColour (Pal::hudText);
-    g.setFont (juce::Font (juce::FontOptions (13.0f)).boldened());
-    g.drawText (noteText, hudX, hudY, hudW, hudH, juce::Justification::centred);
+    hudGlyphs.draw (g, juce::AffineTransform::translation (static_cast<float> (hudX), static_cast<float> (hudY)));
 }
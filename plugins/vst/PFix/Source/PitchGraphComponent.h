@@ -6,47 +6,257 @@
       • Y axis  – pitch on a MIDI / logarithmic Hz scale (C2 – C6)
       • X axis  – time in seconds; newest data arrives from the right
 
-    The component polls PitchDataQueue at 30 fps via an internal Timer and
-    repaints itself each frame.
+    The component listens to the processor's PitchHistory, seeding itself
+    from it on construction (so reopening the editor, or a restored session,
+    shows the curves at once), and animates from a juce::VBlankAttachment.
+    Points arrive in bursts, so the right edge doesn't jump to the newest
+    point: it follows the wall clock, offset by a smoothed estimate of how
+    far the audio timestamps lag it, and is only allowed a little past the
+    newest point.  A frame is repainted only when new points arrived or the
+    view moved, only the area right of the label column, and the callback
+    does nothing after kIdleAfterMs of silence.
+    Points are grouped by their channel tag and every channel gets its own
+    curve and colour; the HUD follows channel 0.
+
+    With setUseOpenGL (true) grid and curves are drawn by shaders instead
+    (see PitchGraphGLRenderer).  Otherwise the static background is cached
+    in an image.  By default the curves are
+    too (CurveRendering::scrollBlit): each frame scrolls that image left by
+    the elapsed time and draws only the new segments at the right edge, so
+    paint cost follows the data rate rather than the window length.
+
+    showSession() swaps the live curves for a file written by
+    PitchSessionRecorder, read through a PitchSessionIndex: the mouse wheel
+    zooms around the pointer, dragging scrubs, a double-click shows the
+    whole session.  Live points keep arriving in the background for when
+    showLive() switches back.
+
+    setShowSpectrogram() (or Cmd/Ctrl+Shift+S) puts the input's spectrum
+    behind the live curves, from the processor's SpectrogramFeed.  Each
+    column that arrives is written into one column of a ring-shaped image
+    whose rows already follow the C2 – C6 scale, and a frame only draws
+    that image stretched into place (in two pieces where the ring wraps),
+    so the cost doesn't grow with the history shown.  Software rendering
+    only; not in session mode.
+
+    setShowNoteBlocks() (or Cmd/Ctrl+Shift+N) draws the history's segmented
+    notes (see NoteSegmenter) as one block per note behind the live curves,
+    at its median pitch, fainter the less steadily it was held; the note in
+    progress grows at the right edge.  A window holds a few dozen notes
+    where it holds thousands of points.  Software rendering only; not in
+    session mode.
+
+    setShowPerformanceOverlay() (or Cmd/Ctrl+Shift+P) shows what the last
+    kPerfFrames frames cost: time per paint pass, points drawn, the
+    history's queue drain and dropped points, and frame interval jitter.
   ==============================================================================
 */
 
 #pragma once
 
 #include <JuceHeader.h>
-#include "PitchDataQueue.h"
-#include <deque>
+#include "PitchHistory.h"
+#include "PitchGraphGLRenderer.h"
+#include "PitchSessionIndex.h"
+#include "SpectrogramFeed.h"
+#include "../../Shared/TraceEvents.h"
+#include <array>
 #include <cmath>
+#include <limits>
+#include <map>
+#include <vector>
 
 class PitchGraphComponent : public juce::Component,
-                            private juce::Timer
+                            private PitchHistory::Listener
 {
 public:
-    explicit PitchGraphComponent (PitchDataQueue& queue);
+    /** The history must outlive the component. */
+    explicit PitchGraphComponent (PitchHistory& history);
     ~PitchGraphComponent() override;
 
     // juce::Component
     void paint   (juce::Graphics& g) override;
     void resized () override;
 
+    void mouseDown        (const juce::MouseEvent& e) override;
+    void mouseDrag        (const juce::MouseEvent& e) override;
+    void mouseDoubleClick (const juce::MouseEvent& e) override;
+    void mouseWheelMove   (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+    bool keyPressed       (const juce::KeyPress& key) override;
+
     /** How many seconds of pitch history to display (default: 8). */
-    void setDisplayWindow (float seconds) { displayWindowSecs = seconds; }
+    void setDisplayWindow (float seconds);
+
+    /** How the pitch curves are drawn each frame. */
+    enum class CurveRendering
+    {
+        fullRedraw,   ///< Rebuild and stroke the whole visible curve every frame
+        scrollBlit    ///< Keep the curves in an image, scroll it, draw only new segments
+    };
+
+    void           setCurveRendering (CurveRendering mode);
+    CurveRendering getCurveRendering () const noexcept { return curveRendering; }
+
+    /** Hands grid and curves to a PitchGraphGLRenderer (off by default).
+        Labels, time axis and HUD are still painted here, through the same
+        context. */
+    void setUseOpenGL (bool shouldUseOpenGL);
+    bool isUsingOpenGL() const noexcept { return glRenderer != nullptr; }
+
+    /** Expected points per second and channel (sample rate / analysis hop),
+        used to size the display rings.  Non-positive rates are ignored. */
+    void setPointRate (double pointsPerSecond);
+
+    // ── Recorded sessions ─────────────────────────────────────────────────────
+    /** Shows a whole recorded session instead of the live curves.  Returns
+        false, back on the live curves, if the file can't be read. */
+    bool showSession (const juce::File& sessionFile);
+    void showLive();
+    bool isShowingSession() const noexcept { return session.isOpen(); }
+
+    /** The visible part of the session, in its own timestamps; clamped to
+        the session and to at least kMinSessionViewSecs. */
+    void setSessionView (double startTime, double lengthSecs);
+
+    // ── Spectrogram ───────────────────────────────────────────────────────────
+    /** Where the spectrogram comes from (the processor's feed), or nullptr.
+        The feed must outlive the component or be replaced first; it is
+        enabled only while the spectrogram is shown. */
+    void setSpectrogramFeed (SpectrogramFeed* feed);
+
+    void setShowSpectrogram (bool shouldShow);
+    bool isShowingSpectrogram() const noexcept { return showSpectrogram; }
+
+    // ── Note blocks ───────────────────────────────────────────────────────────
+    void setShowNoteBlocks (bool shouldShow);
+    bool isShowingNoteBlocks() const noexcept { return showNoteBlocks; }
+
+    // ── Performance overlay ──────────────────────────────────────────────────
+    void setShowPerformanceOverlay (bool shouldShow);
+    bool isShowingPerformanceOverlay() const noexcept { return showPerfOverlay; }
+
+    /** What one paint() cost, timed with high-resolution ticks. */
+    struct FrameStats
+    {
+        float backgroundMs, spectrogramMs, notesMs, curvesMs, axisMs, hudMs;   // per paint pass
+        float intervalMs;                                                      // since the previous paint, 0 for the first
+        int   pointsDrawn;                                                     // points, buckets and note blocks submitted
+    };
+
+    /** The newest paint()'s figures (all zero before the first). */
+    const FrameStats& getLastFrameStats() const noexcept
+    {
+        return perfFrames[(size_t) ((perfFrameCount + kPerfFrames - 1) % kPerfFrames)];
+    }
+
+    // ── Offscreen painting ────────────────────────────────────────────────────
+    /** One animation frame with the right edge at viewTimeSecs (never moving
+        back) instead of following the wall clock, for painting without a
+        display (PFixPaintBench).  Live view only. */
+    void advanceViewTo (double viewTimeSecs);
 
 private:
-    // ── Timer callback (30 fps) ───────────────────────────────────────────────
-    void timerCallback() override;
+    // ── Animation (vblankAttachment) ──────────────────────────────────────────
+    void onVBlank();
+
+    /** Marks the display dirty, leaves idle and updates the clock offset. */
+    void noteNewData();
+
+    /** Moves the right edge to `target`, prunes if new data came, and
+        repaints the data area. */
+    void moveViewTo (double target);
+
+    /** Where the right edge should be at `nowSecs` (wall clock): never
+        behind the current view, never more than kMaxExtrapolationSecs past
+        the newest point. */
+    double extrapolatedViewTime (double nowSecs) const noexcept;
+
+    // ── PitchHistory::Listener ────────────────────────────────────────────────
+    void pitchPointsAdded (const PitchPoint* points, int numPoints) override;
+    void notesAdded (const NoteEvent* notes, int numNotes) override;
+    void pitchHistoryReplaced() override;
+
+    /** Appends points to the display rings (live batches and reloads). */
+    void addPoints (const PitchPoint* points, int numPoints);
+    void addNotes  (const NoteEvent* notes, int numNotes);
+
+    /** Rebuilds the display from scratch out of the whole history. */
+    void reloadFromHistory();
+    void pruneToDisplayWindow();
+
+    /** Ring size that holds the display window plus the prune slack at the
+        current point rate, with some headroom. */
+    int  ringCapacity() const noexcept;
+    void resizeRings();
 
     // ── Drawing passes ───────────────────────────────────────────────────────
+    struct DisplayPoint;
+    template <typename Item> class TimeRing;
+    using DisplayRing = TimeRing<DisplayPoint>;
+
+    /** Renders background, grid and note labels into backgroundCache at
+        the given physical-pixel scale. */
+    void renderBackgroundCache (float pixelScale);
+
     void drawBackground      (juce::Graphics& g) const;
     void drawPianoRollGrid   (juce::Graphics& g) const;
     void drawNoteLabels      (juce::Graphics& g) const;
-    void drawPitchCurve      (juce::Graphics& g) const;
+    void layOutNoteLabels    () const;
+    void drawPitchCurve      (juce::Graphics& g, float pixelScale);
+    void drawWaitingPrompt   (juce::Graphics& g) const;
+    bool hasAnyPoints        () const noexcept;
+
+    /** Draws points [first, end) of one channel, with the graph's right
+        edge standing for `rightEdgeTime`.  When the visible window holds
+        several points per pixel this switches to drawChannelSummary(). */
+    void drawChannelCurve    (juce::Graphics& g, int channel,
+                              int first, int end, double rightEdgeTime) const;
+
+    /** Draws one summary level over points [first, end): a line through
+        each bucket's last voiced pitch plus its min–max span, one bucket per
+        pixel or so, whatever the window length. */
+    void drawChannelSummary  (juce::Graphics& g, int channel, int level,
+                              int first, int end, double rightEdgeTime) const;
+
+    static void strokeCurve  (juce::Graphics& g, const juce::Path& path, juce::Colour colour);
+
+    /** scrollBlit: brings curveCache up to viewTime, scrolling it and
+        drawing only the segments that entered the view since the last
+        frame, or re-rendering it when it can't be scrolled. */
+    void updateCurveCache    (float pixelScale);
+    void renderCurveCache    (float pixelScale);
+    int  firstVisibleIndex   (const DisplayRing& history) const noexcept;
     void drawTimeAxis        (juce::Graphics& g) const;
     void drawCurrentPitchHUD (juce::Graphics& g) const;
 
+    /** Sizes spectrogramImage for the display window at the point rate, or
+        drops it while the spectrogram is hidden. */
+    void resizeSpectrogram();
+
+    /** Writes every column waiting in the feed into the image.  Returns
+        how many there were. */
+    int  drainSpectrogram();
+    void drawSpectrogram (juce::Graphics& g) const;
+
+    /** The finished notes that overlap the view, then openNotes. */
+    void drawNoteBlocks (juce::Graphics& g) const;
+
+    /** Session mode: every channel's buckets for the visible span, about
+        one per pixel. */
+    void drawSessionCurves   (juce::Graphics& g);
+
+    /** Mean and worst of the figures in perfFrames / perfDrains. */
+    void drawPerformanceOverlay (juce::Graphics& g) const;
+
     // ── Coordinate conversion ─────────────────────────────────────────────────
-    float midiToY   (float midiNote)  const noexcept;
-    float timeToX   (double timestamp) const noexcept;
+    float  midiToY   (float midiNote)  const noexcept;
+    float  timeToX   (double timestamp) const noexcept;
+    float  timeToX   (double timestamp, double rightEdgeTime) const noexcept;
+    double xToTime   (float x) const noexcept;
+
+    /** Live: viewTime and displayWindowSecs.  Session: the session view. */
+    double viewRightEdge () const noexcept;
+    double viewSeconds   () const noexcept;
 
     // ── Note-name utilities ───────────────────────────────────────────────────
     static float        hzToMidi       (float hz)        noexcept;
@@ -54,9 +264,15 @@ private:
     static juce::String midiToNoteName (int midiNote,
                                         bool showOctave = true);
     static bool         isBlackKey     (int midiNote)    noexcept;
+    static juce::Colour curveColour    (int channel)     noexcept;
+
+    /** Lays out one line of text in `area` the way Graphics::drawText()
+        does, so it can be kept and drawn again without reshaping. */
+    static juce::GlyphArrangement layOutText (const juce::Font& font, const juce::String& text,
+                                              juce::Rectangle<float> area, juce::Justification justification);
 
     // ── Data ──────────────────────────────────────────────────────────────────
-    PitchDataQueue& dataQueue;
+    PitchHistory& pitchHistory;
 
     struct DisplayPoint
     {
@@ -65,16 +281,197 @@ private:
         double timestamp;
     };
 
-    std::deque<DisplayPoint> history;
+    /** Time-ordered items (anything with a `timestamp`), oldest first, in
+        a contiguous power-of-two ring.  Pushing and pruning only move
+        indices; memory is allocated when the ring is resized, or when the
+        point ring fills up with points that are all still inside the
+        display window (e.g. after a smaller hop). */
+    template <typename Item>
+    class TimeRing
+    {
+    public:
+        /** Keeps the newest items that fit. */
+        void setCapacity (int newCapacity);
+        int  getCapacity () const noexcept { return (int) points.size(); }
+
+        int  size   () const noexcept { return count; }
+        bool empty  () const noexcept { return count == 0; }
+        bool isFull () const noexcept { return count == (int) points.size(); }
+        void clear  () noexcept       { head = 0; count = 0; }
+
+        /** i = 0 is the oldest item. */
+        const Item& operator[] (int i) const noexcept
+        {
+            return points[(size_t) ((head + i) & mask)];
+        }
+
+        /** Overwrites the oldest item when full. */
+        void push (const Item& item) noexcept;
+
+        void dropOlderThan (double timestamp) noexcept;
+
+        /** Index of the first item at or after `timestamp`, or size(). */
+        int  lowerBound (double timestamp) const noexcept;
+
+    private:
+        std::vector<Item> points;
+        int head  { 0 };
+        int count { 0 };
+        int mask  { 0 };
+    };
+
+    /** Summary of a run of consecutive points. */
+    struct SummaryBucket
+    {
+        double timestamp;      // first point
+        double endTimestamp;   // last point
+        float  minMidi;        // over voiced, on-scale points
+        float  maxMidi;
+        float  lastMidi;       // newest voiced, on-scale point; < 0 if none
+        int    numPoints;
+    };
+
+    /** Min/max pyramid over one channel, built as points arrive: a level-l
+        bucket covers kFanout^(l+1) consecutive points.  Each level holds
+        about as much time as the point ring. */
+    class ChannelSummary
+    {
+    public:
+        static constexpr int kNumLevels = 6;   // 4 … 4096 points per bucket
+        static constexpr int kFanout    = 4;
+
+        static constexpr int pointsPerBucket (int level) noexcept
+        {
+            int n = kFanout;
+            while (level-- > 0) n *= kFanout;
+            return n;
+        }
+
+        /** Sizes every level for `numPoints` points. */
+        void setCapacity   (int numPoints);
+        void clear         () noexcept;
+        void add           (const DisplayPoint& pt) noexcept;
+        void dropOlderThan (double timestamp) noexcept;
+
+        const TimeRing<SummaryBucket>& getLevel (int level) const noexcept { return levels[(size_t) level]; }
+
+    private:
+        void addToLevel (int level, const SummaryBucket& bucket) noexcept;
+
+        std::array<TimeRing<SummaryBucket>, kNumLevels> levels;
+        std::array<SummaryBucket, kNumLevels>           open {};   // filling buckets, numPoints 0 = empty
+    };
+
+    std::vector<DisplayRing>    histories;   // index = channel, grown on demand
+    std::vector<ChannelSummary> summaries;   // parallel to histories
+    double pointsPerSecond  { 44100.0 / 256.0 };
     float  currentPitchHz   { 0.0f };
     double newestTimestamp  { 0.0  };
+    double viewTime         { 0.0  };   // timestamp at the graph's right edge
     float  displayWindowSecs{ 8.0f };
 
+    // Background, grid and labels only change on resize or a DPI change, so
+    // they are drawn once into this image and blitted every frame.
+    juce::Image backgroundCache;
+    float       backgroundScale { 0.0f };   // physical pixels per logical pixel
+
+    // scrollBlit state: the curves as of curveTime (the image's right edge),
+    // and per channel the timestamp of the newest point already drawn
+    // (never past curveTime, so points beyond the edge are drawn later).
+    CurveRendering      curveRendering { CurveRendering::scrollBlit };
+    juce::Image         curveCache;
+    float               curveScale     { 0.0f };
+    double              curveTime      { 0.0 };
+    std::vector<double> lastDrawnTimestamps;
+
+    std::unique_ptr<PitchGraphGLRenderer> glRenderer;   // set while OpenGL is on
+
+    // Spectrogram: column spectrogramWrite is the next to be written, the
+    // spectrogramCount before it (wrapping) hold the newest columns, one
+    // per frame, with their timestamps on the history's timeline.
+    static constexpr int kMaxSpectrogramColumns = 4096;
+
+    SpectrogramFeed*                 spectrogramFeed  { nullptr };
+    bool                             showSpectrogram  { false };
+    juce::Image                      spectrogramImage;            // kNumRows high, top row = kMidiMax
+    std::vector<double>              spectrogramTimes;            // per image column
+    int                              spectrogramWrite { 0 };
+    int                              spectrogramCount { 0 };
+    std::array<juce::PixelARGB, 256> spectrogramPalette;          // level → premultiplied colour
+
+    // Note blocks: each channel's finished notes (sequential, so ordered by
+    // end as well as by start) and, refreshed with every batch while shown,
+    // the notes still in progress
+    std::vector<TimeRing<NoteEvent>> noteBlocks;                  // index = channel, like histories
+    std::vector<NoteEvent>           openNotes;
+    bool                             showNoteBlocks { false };
+
+    // Text laid out once and drawn with a translation, so frames don't
+    // allocate strings or shape text.  All positioned relative to (0, 0).
+    static constexpr int kNumNotes      = 49;    // kMidiMin … kMidiMax
+    static constexpr int kMaxTimeLabels = 128;   // then labels off screen are dropped
+
+    mutable std::array<juce::GlyphArrangement, kNumNotes> noteLabelGlyphs;   // right-aligned in the label column
+    mutable bool                                          noteLabelsLaidOut { false };
+    mutable std::map<juce::int64, juce::GlyphArrangement> timeLabelGlyphs;   // by tick second, in the current format
+    mutable juce::GlyphArrangement                        hudGlyphs;
+    mutable int                                           hudMidi { -2 };    // what hudGlyphs shows; -1 = no pitch
+    mutable int                                           hudHz   { -1 };
+
+    // Session mode (while session.isOpen())
+    static constexpr double kMinSessionViewSecs = 1.0;
+
+    PitchSessionIndex                      session;
+    double                                 sessionViewStart   { 0.0 };
+    double                                 sessionViewLength  { 0.0 };
+    double                                 dragStartViewStart { 0.0 };
+    bool                                   glBeforeSession    { false };   // restored by showLive()
+    std::vector<PitchSessionIndex::Bucket> sessionBuckets;                 // reused by each paint
+
+    // Animation and repaint throttling
+    static constexpr double kIdleAfterMs          = 2000.0;
+    static constexpr double kDisplayLatencySecs   = 0.05;   // right edge trails the average newest point
+    static constexpr double kMaxExtrapolationSecs = 0.25;   // then the view stops and waits for data
+    static constexpr double kClockSmoothing       = 0.05;   // per batch
+    static constexpr double kClockResetSecs       = 0.5;    // offset jumps beyond this are taken as is
+    static constexpr double kMinScrollPx          = 0.25;   // smaller moves aren't worth a frame
+
+    bool   dataChanged   { true };   // new points since the last repaint
+    bool   isIdle        { false };
+    double lastNewDataMs { 0.0 };    // Time::getMillisecondCounterHiRes()
+    double clockOffset   { 0.0 };    // wall clock − audio timestamp, seconds
+    bool   clockValid    { false };
+
+    // Performance overlay: one entry per paint() and per history drain, in
+    // small rings (index = count % kPerfFrames), timed with high-resolution
+    // ticks
+    struct DrainSample
+    {
+        float drainMs;
+        int   numPoints;
+    };
+
+    static constexpr juce::uint32 kPerfFrames = 64;
+
+    std::array<FrameStats,  kPerfFrames> perfFrames {};
+    std::array<DrainSample, kPerfFrames> perfDrains {};
+    juce::uint32 perfFrameCount  { 0 };       // wraps harmlessly
+    juce::uint32 perfDrainCount  { 0 };
+    juce::int64  lastPaintTicks  { 0 };
+    mutable int  pointsDrawn     { 0 };       // this paint so far
+    bool         showPerfOverlay { false };
+
     // ── Layout ────────────────────────────────────────────────────────────────
-    static constexpr int   kLabelWidth = 46;
-    static constexpr float kMidiMin    = 36.0f;   // C2  (~65 Hz)
-    static constexpr float kMidiMax    = 84.0f;   // C6  (~1047 Hz)
-    static constexpr float kMidiRange  = kMidiMax - kMidiMin;
+    static constexpr int    kLabelWidth     = 46;
+    static constexpr double kPruneSlackSecs = 1.0;    // kept beyond the window's left edge
+    static constexpr int    kMaxCurves      = 16;     // higher channel tags are ignored
+    static constexpr float  kMidiMin        = 36.0f;  // C2  (~65 Hz)
+    static constexpr float  kMidiMax        = 84.0f;  // C6  (~1047 Hz)
+    static constexpr float  kMidiRange      = kMidiMax - kMidiMin;
+    static constexpr float  kUnsteadyCents  = 50.0f;  // a note block this spread is drawn faintest
+
+    // Last, so it is destroyed before anything its callback touches
+    juce::VBlankAttachment vblankAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchGraphComponent)
 };
@@ -0,0 +1,472 @@
+/*
+  ==============================================================================
+    PitchGraphGLRenderer.cpp  –  PitchGraphGLRenderer implementation
+  ==============================================================================
+*/
+
+#include "PitchGraphGLRenderer.h"
+#include <cstddef>
+
+using namespace juce::gl;
+
+// ── Shaders ───────────────────────────────────────────────────────────────────
+namespace
+{
+    const char* const gridVertexShader = R"(
+        attribute vec2 position;
+
+        void main()
+        {
+            gl_Position = vec4 (position, 0.0, 1.0);
+        }
+    )";
+
+    // Per pixel: label column, divider, semitone / octave lines, black-key
+    // bands.  Rows match PitchGraphComponent::drawPianoRollGrid().
+    const char* const gridFragmentShader = R"(
+        uniform vec2  viewSize;
+        uniform float scale;
+        uniform float labelWidth;
+        uniform float midiMin;
+        uniform float midiRange;
+        uniform vec4  background;
+        uniform vec4  blackKeyBand;
+        uniform vec4  semitoneLine;
+        uniform vec4  octaveLine;
+        uniform vec4  labelBackground;
+        uniform vec4  labelDivider;
+
+        void main()
+        {
+            if (gl_FragCoord.x < labelWidth)          { gl_FragColor = labelBackground; return; }
+            if (gl_FragCoord.x < labelWidth + scale)  { gl_FragColor = labelDivider;    return; }
+
+            float pxPerSemitone = viewSize.y / midiRange;
+            float midi          = midiMin + gl_FragCoord.y / pxPerSemitone;
+            float nearest       = floor (midi + 0.5);
+
+            if (abs (midi - nearest) * pxPerSemitone < 0.5 * scale)
+            {
+                gl_FragColor = mod (nearest, 12.0) < 0.5 ? octaveLine : semitoneLine;
+                return;
+            }
+
+            float s = mod (floor (midi), 12.0);
+            bool  black = s == 1.0 || s == 3.0 || s == 6.0 || s == 8.0 || s == 10.0;
+            gl_FragColor = black ? blackKeyBand : background;
+        }
+    )";
+
+    // Expands one segment into a quad halfWidth either side (and past each
+    // end), passing the signed distance from the centre line along.
+    const char* const curveVertexShader = R"(
+        attribute vec4 segment;   // tA, midiA, tB, midiB
+        attribute vec2 corner;    // along (0/1), side (-1/+1)
+
+        uniform vec2  viewSize;
+        uniform float labelWidth;
+        uniform float rightEdgeTime;
+        uniform float windowSecs;
+        uniform float midiMin;
+        uniform float midiRange;
+        uniform float halfWidth;
+
+        varying float across;
+
+        vec2 toPixels (float t, float midi)
+        {
+            float graphWidth = viewSize.x - labelWidth;
+            return vec2 (labelWidth + (t - rightEdgeTime + windowSecs) / windowSecs * graphWidth,
+                         (midi - midiMin) / midiRange * viewSize.y);
+        }
+
+        void main()
+        {
+            vec2  a      = toPixels (segment.x, segment.y);
+            vec2  b      = toPixels (segment.z, segment.w);
+            float len    = length (b - a);
+            vec2  dir    = len > 0.0 ? (b - a) / len : vec2 (1.0, 0.0);
+            vec2  normal = vec2 (-dir.y, dir.x);
+
+            vec2 p = mix (a, b, corner.x)
+                   + dir    * (corner.x * 2.0 - 1.0) * halfWidth
+                   + normal * corner.y * halfWidth;
+
+            across      = corner.y * halfWidth;
+            gl_Position = vec4 (p / viewSize * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    // Line core plus glow falloff in one pass.
+    const char* const curveFragmentShader = R"(
+        uniform vec4  colour;
+        uniform float lineHalfWidth;
+        uniform float halfWidth;
+        uniform float glowAlpha;
+
+        varying float across;
+
+        void main()
+        {
+            float d    = abs (across);
+            float line = 1.0 - smoothstep (lineHalfWidth - 0.5, lineHalfWidth + 0.5, d);
+            float glow = glowAlpha * (1.0 - smoothstep (lineHalfWidth, halfWidth, d));
+            gl_FragColor = vec4 (colour.rgb, colour.a * max (line, glow));
+        }
+    )";
+
+    std::unique_ptr<juce::OpenGLShaderProgram> buildProgram (juce::OpenGLContext& context,
+                                                             const char* vertexCode, const char* fragmentCode)
+    {
+        auto program = std::make_unique<juce::OpenGLShaderProgram> (context);
+
+        if (program->addVertexShader   (juce::OpenGLHelpers::translateVertexShaderToV3   (vertexCode))
+            && program->addFragmentShader (juce::OpenGLHelpers::translateFragmentShaderToV3 (fragmentCode))
+            && program->link())
+            return program;
+
+        DBG ("PitchGraphGLRenderer: shader build failed: " << program->getLastError());
+        return nullptr;
+    }
+
+    void setColour (juce::OpenGLShaderProgram& program, const char* name, juce::Colour c)
+    {
+        juce::OpenGLShaderProgram::Uniform (program, name)
+            .set (c.getFloatRed(), c.getFloatGreen(), c.getFloatBlue(), c.getFloatAlpha());
+    }
+
+    // Quad corners in triangle order: (along, side)
+    constexpr float kCorners[6][2] { { 0, -1 }, { 1, -1 }, { 1, 1 },
+                                     { 0, -1 }, { 1,  1 }, { 0, 1 } };
+
+    constexpr float kLineHalfWidth = 1.0f;   // 2 px line, as in the software path
+    constexpr float kGlowHalfWidth = 3.5f;   // 7 px glow
+}
+
+// ── Construction ─────────────────────────────────────────────────────────────
+
+PitchGraphGLRenderer::PitchGraphGLRenderer (juce::Component& target, const Style& styleToUse)
+    : targetComponent (target),
+      style (styleToUse)
+{
+    context.setRenderer (this);
+    context.setComponentPaintingEnabled (true);   // labels, time axis and HUD
+    context.setContinuousRepainting (true);       // render at the display's refresh rate
+    context.attachTo (targetComponent);
+}
+
+PitchGraphGLRenderer::~PitchGraphGLRenderer()
+{
+    context.detach();
+}
+
+// ── Message thread ────────────────────────────────────────────────────────────
+
+void PitchGraphGLRenderer::setChannelCapacity (int numSegments)
+{
+    const juce::ScopedLock sl (lock);
+
+    channelCapacity = juce::jmax (16, numSegments);
+
+    for (auto& channel : channels)
+        resizeChannel (channel, channelCapacity);
+}
+
+void PitchGraphGLRenderer::addPoint (int channelIndex, float midiNote, double timestamp, juce::Colour colour)
+{
+    if (channelIndex < 0)
+        return;
+
+    const juce::ScopedLock sl (lock);
+
+    if (! hasTimeBase)
+    {
+        timeBase    = timestamp;
+        hasTimeBase = true;
+    }
+
+    if ((size_t) channelIndex >= channels.size())
+    {
+        channels.resize ((size_t) channelIndex + 1);
+        for (auto& channel : channels)
+            if (channel.capacity == 0)
+                resizeChannel (channel, channelCapacity);
+    }
+
+    auto&       channel = channels[(size_t) channelIndex];
+    const float t       = static_cast<float> (timestamp - timeBase);
+
+    channel.colour = colour;
+
+    if (midiNote >= 0.0f && channel.lastMidi >= 0.0f)
+        pushSegment (channel, channel.lastT, channel.lastMidi, t, midiNote);
+
+    channel.lastT    = t;
+    channel.lastMidi = midiNote;
+}
+
+void PitchGraphGLRenderer::setView (double rightEdgeTime, float windowSeconds)
+{
+    const juce::ScopedLock sl (lock);
+    viewTime   = rightEdgeTime;
+    windowSecs = windowSeconds;
+}
+
+void PitchGraphGLRenderer::clear()
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto& channel : channels)
+    {
+        channel.head       = 0;
+        channel.count      = 0;
+        channel.lastMidi   = -1.0f;
+        channel.dirtyCount = 0;
+    }
+
+    hasTimeBase = false;
+}
+
+void PitchGraphGLRenderer::pushSegment (Channel& channel, float tA, float midiA, float tB, float midiB)
+{
+    // A full ring whose oldest segment is still on screen: the point rate went
+    // up, so grow instead of eating into the visible curve.
+    if (channel.count == channel.capacity)
+    {
+        const Vertex& oldest = channel.vertices[(size_t) (channel.head * kVerticesPerSegment)];
+
+        if (oldest.tB >= tB - windowSecs - 1.0f)
+            resizeChannel (channel, channel.capacity * 2);
+    }
+
+    int slot;
+
+    if (channel.count == channel.capacity)
+    {
+        slot         = channel.head;
+        channel.head = (channel.head + 1) % channel.capacity;
+    }
+    else
+    {
+        slot = (channel.head + channel.count) % channel.capacity;
+        ++channel.count;
+    }
+
+    Vertex* v = channel.vertices.data() + slot * kVerticesPerSegment;
+
+    for (int i = 0; i < kVerticesPerSegment; ++i)
+        v[i] = { tA, midiA, tB, midiB, kCorners[i][0], kCorners[i][1] };
+
+    // Extend the dirty run; slots are written consecutively, so it stays one
+    // (possibly wrapping) range.
+    if (channel.dirtyCount == 0)
+        channel.dirtyStart = slot;
+
+    channel.dirtyCount = juce::jmin (channel.dirtyCount + 1, channel.capacity);
+}
+
+void PitchGraphGLRenderer::resizeChannel (Channel& channel, int newCapacity)
+{
+    const int numKept = juce::jmin (channel.count, newCapacity);
+
+    std::vector<Vertex> resized ((size_t) (newCapacity * kVerticesPerSegment));
+
+    for (int i = 0; i < numKept; ++i)
+    {
+        const int from = (channel.head + channel.count - numKept + i) % channel.capacity;
+        std::copy_n (channel.vertices.data() + from * kVerticesPerSegment, kVerticesPerSegment,
+                     resized.data() + i * kVerticesPerSegment);
+    }
+
+    channel.vertices     = std::move (resized);
+    channel.head         = 0;
+    channel.count        = numKept;
+    channel.capacity     = newCapacity;
+    channel.dirtyCount   = 0;
+    channel.needsRealloc = true;
+}
+
+// ── Render thread ─────────────────────────────────────────────────────────────
+
+void PitchGraphGLRenderer::newOpenGLContextCreated()
+{
+    gridShader  = buildProgram (context, gridVertexShader,  gridFragmentShader);
+    curveShader = buildProgram (context, curveVertexShader, curveFragmentShader);
+
+    const float quad[] { -1.0f, -1.0f,  1.0f, -1.0f,  -1.0f, 1.0f,  1.0f, 1.0f };
+
+    glGenBuffers (1, &quadVbo);
+    glBindBuffer (GL_ARRAY_BUFFER, quadVbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof (quad), quad, GL_STATIC_DRAW);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+void PitchGraphGLRenderer::openGLContextClosing()
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto& channel : channels)
+    {
+        if (channel.vbo != 0)
+            glDeleteBuffers (1, &channel.vbo);
+
+        channel.vbo          = 0;
+        channel.needsRealloc = true;
+    }
+
+    if (quadVbo != 0)
+        glDeleteBuffers (1, &quadVbo);
+
+    quadVbo = 0;
+    gridShader.reset();
+    curveShader.reset();
+}
+
+void PitchGraphGLRenderer::renderOpenGL()
+{
+    const float scale  = static_cast<float> (context.getRenderingScale());
+    const float width  = std::round (scale * (float) targetComponent.getWidth());
+    const float height = std::round (scale * (float) targetComponent.getHeight());
+
+    if (width <= 0.0f || height <= 0.0f)
+        return;
+
+    glViewport (0, 0, (GLsizei) width, (GLsizei) height);
+    glDisable (GL_DEPTH_TEST);
+
+    drawGrid (scale, width, height);
+
+    const juce::ScopedLock sl (lock);
+
+    for (auto& channel : channels)
+        uploadChannel (channel);
+
+    drawCurves (scale, width, height,
+                static_cast<float> (viewTime - timeBase), windowSecs);
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+void PitchGraphGLRenderer::drawGrid (float scale, float width, float height)
+{
+    if (gridShader == nullptr)
+        return;
+
+    glDisable (GL_BLEND);
+    gridShader->use();
+
+    gridShader->setUniform ("viewSize",   width, height);
+    gridShader->setUniform ("scale",      scale);
+    gridShader->setUniform ("labelWidth", (float) style.labelWidth * scale);
+    gridShader->setUniform ("midiMin",    style.midiMin);
+    gridShader->setUniform ("midiRange",  style.midiMax - style.midiMin);
+
+    setColour (*gridShader, "background",      style.background);
+    setColour (*gridShader, "blackKeyBand",    style.blackKeyBand);
+    setColour (*gridShader, "semitoneLine",    style.semitoneLine);
+    setColour (*gridShader, "octaveLine",      style.octaveLine);
+    setColour (*gridShader, "labelBackground", style.labelBackground);
+    setColour (*gridShader, "labelDivider",    style.labelDivider);
+
+    const juce::OpenGLShaderProgram::Attribute position (*gridShader, "position");
+
+    glBindBuffer (GL_ARRAY_BUFFER, quadVbo);
+    glVertexAttribPointer (position.attributeID, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glEnableVertexAttribArray (position.attributeID);
+    glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray (position.attributeID);
+}
+
+void PitchGraphGLRenderer::uploadChannel (Channel& channel)
+{
+    if (channel.capacity == 0)
+        return;
+
+    constexpr auto slotBytes = (GLsizeiptr) (kVerticesPerSegment * sizeof (Vertex));
+
+    if (channel.vbo == 0)
+    {
+        glGenBuffers (1, &channel.vbo);
+        channel.needsRealloc = true;
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, channel.vbo);
+
+    if (channel.needsRealloc)
+    {
+        glBufferData (GL_ARRAY_BUFFER, slotBytes * channel.capacity, channel.vertices.data(), GL_DYNAMIC_DRAW);
+        channel.needsRealloc = false;
+        channel.dirtyCount   = 0;
+        return;
+    }
+
+    // Only the slots written since the last frame; the run may wrap.
+    const int firstRun = juce::jmin (channel.dirtyCount, channel.capacity - channel.dirtyStart);
+
+    if (firstRun > 0)
+        glBufferSubData (GL_ARRAY_BUFFER, slotBytes * channel.dirtyStart, slotBytes * firstRun,
+                         channel.vertices.data() + channel.dirtyStart * kVerticesPerSegment);
+
+    if (channel.dirtyCount > firstRun)
+        glBufferSubData (GL_ARRAY_BUFFER, 0, slotBytes * (channel.dirtyCount - firstRun),
+                         channel.vertices.data());
+
+    channel.dirtyCount = 0;
+}
+
+void PitchGraphGLRenderer::drawCurves (float scale, float width, float height,
+                                       float rightEdgeTime, float windowSeconds)
+{
+    if (curveShader == nullptr)
+        return;
+
+    const float labelWidth = (float) style.labelWidth * scale;
+
+    glEnable (GL_BLEND);
+    glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable (GL_SCISSOR_TEST);
+    glScissor ((GLint) (labelWidth + scale), 0, (GLsizei) (width - labelWidth - scale), (GLsizei) height);
+
+    curveShader->use();
+    curveShader->setUniform ("viewSize",      width, height);
+    curveShader->setUniform ("labelWidth",    labelWidth);
+    curveShader->setUniform ("rightEdgeTime", rightEdgeTime);
+    curveShader->setUniform ("windowSecs",    windowSeconds);
+    curveShader->setUniform ("midiMin",       style.midiMin);
+    curveShader->setUniform ("midiRange",     style.midiMax - style.midiMin);
+    curveShader->setUniform ("halfWidth",     kGlowHalfWidth * scale);
+    curveShader->setUniform ("lineHalfWidth", kLineHalfWidth * scale);
+    curveShader->setUniform ("glowAlpha",     style.glowAlpha);
+
+    const juce::OpenGLShaderProgram::Attribute segment (*curveShader, "segment");
+    const juce::OpenGLShaderProgram::Attribute corner  (*curveShader, "corner");
+
+    glEnableVertexAttribArray (segment.attributeID);
+    glEnableVertexAttribArray (corner.attributeID);
+
+    // Highest channel first, so channel 0 ends up on top
+    for (int ch = static_cast<int> (channels.size()); --ch >= 0;)
+    {
+        const auto& channel = channels[(size_t) ch];
+        if (channel.count == 0 || channel.vbo == 0)
+            continue;
+
+        setColour (*curveShader, "colour", channel.colour);
+
+        glBindBuffer (GL_ARRAY_BUFFER, channel.vbo);
+        glVertexAttribPointer (segment.attributeID, 4, GL_FLOAT, GL_FALSE, sizeof (Vertex), nullptr);
+        glVertexAttribPointer (corner.attributeID,  2, GL_FLOAT, GL_FALSE, sizeof (Vertex),
+                               reinterpret_cast<const void*> (offsetof (Vertex, along)));
+
+        // The valid slots run from head and may wrap to the start
+        const int firstRun = juce::jmin (channel.count, channel.capacity - channel.head);
+        glDrawArrays (GL_TRIANGLES, channel.head * kVerticesPerSegment, firstRun * kVerticesPerSegment);
+
+        if (channel.count > firstRun)
+            glDrawArrays (GL_TRIANGLES, 0, (channel.count - firstRun) * kVerticesPerSegment);
+    }
+
+    glDisableVertexAttribArray (segment.attributeID);
+    glDisableVertexAttribArray (corner.attributeID);
+    glDisable (GL_SCISSOR_TEST);
+}
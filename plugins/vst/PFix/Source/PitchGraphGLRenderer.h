@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+    PitchGraphGLRenderer.h  –  OpenGL back end for PitchGraphComponent
+
+    Attached to the graph when PitchGraphComponent::setUseOpenGL (true):
+      • grid     – one full-screen quad; the fragment shader works out the
+                   semitone rows, octave lines and label column per pixel
+      • curves   – one quad per segment between consecutive voiced points;
+                   the fragment shader draws the line and its glow from the
+                   distance to the segment, so there is no second stroke
+      • text     – note labels, time axis and HUD stay in the component's
+                   paint(), which JUCE renders through the same context
+
+    Segments are kept per channel in a ring that mirrors a vertex buffer.
+    New points only upload their own slots; scrolling is a uniform, so an
+    unchanged history costs no uploads at all.  Timestamps are stored as
+    floats relative to the first point (~0.25 ms resolution after an hour,
+    well under a pixel).
+
+    Threading: add/clear/setView are message-thread calls; everything GL
+    runs on the context's render thread.  The two meet under `lock`.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_opengl/juce_opengl.h>
+#include <memory>
+#include <vector>
+
+class PitchGraphGLRenderer  : private juce::OpenGLRenderer
+{
+public:
+    /** Fixed geometry and colours, copied from the graph. */
+    struct Style
+    {
+        int          labelWidth;
+        float        midiMin, midiMax;
+        juce::Colour background, blackKeyBand, semitoneLine, octaveLine, labelBackground, labelDivider;
+        float        glowAlpha;   ///< peak alpha of the glow around each curve
+    };
+
+    /** Attaches a context to `target`, which must outlive this object. */
+    PitchGraphGLRenderer (juce::Component& target, const Style& style);
+    ~PitchGraphGLRenderer() override;
+
+    // ── Message thread ──────────────────────────────────────────────────────
+    /** Segments kept per channel before the oldest are overwritten; pass
+        the graph's ring capacity so the whole window fits. */
+    void setChannelCapacity (int numSegments);
+
+    /** Appends one point; `midiNote` < 0 marks an unvoiced or off-scale
+        point, which breaks the curve.  Points must arrive in time order
+        per channel. */
+    void addPoint (int channel, float midiNote, double timestamp, juce::Colour colour);
+
+    /** The timestamp at the graph's right edge, and the visible duration.
+        The edge may run ahead of the newest point. */
+    void setView (double rightEdgeTime, float windowSeconds);
+
+    void clear();
+
+    /** Continuous rendering follows the display refresh; the graph turns
+        it off while idle. */
+    void setContinuousRendering (bool shouldRenderContinuously) { context.setContinuousRepainting (shouldRenderContinuously); }
+
+private:
+    // ── juce::OpenGLRenderer (render thread) ────────────────────────────────
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+
+    void drawGrid   (float scale, float width, float height);
+    void drawCurves (float scale, float width, float height, float rightEdgeTime, float windowSecs);
+
+    /** One quad between two points: 6 vertices of (segment, corner). */
+    struct Vertex
+    {
+        float tA, midiA, tB, midiB;   // segment end points, t relative to timeBase
+        float along, side;            // corner: 0/1 along the segment, -1/+1 across
+    };
+
+    static constexpr int kVerticesPerSegment = 6;
+
+    struct Channel
+    {
+        std::vector<Vertex> vertices;            // CPU mirror of the ring, kVerticesPerSegment per slot
+        int                 head      { 0 };     // oldest slot
+        int                 count     { 0 };
+        int                 capacity  { 0 };     // slots
+        float               lastT     { 0.0f };
+        float               lastMidi  { -1.0f }; // previous point, < 0 = none / unvoiced
+        juce::Colour        colour;
+
+        // Slots written since the last upload; whole buffer after a resize
+        int                 dirtyStart { 0 };
+        int                 dirtyCount { 0 };
+        bool                needsRealloc { true };
+
+        juce::uint32        vbo       { 0 };     // render thread only
+    };
+
+    void pushSegment (Channel& channel, float tA, float midiA, float tB, float midiB);
+    void resizeChannel (Channel& channel, int newCapacity);
+    void uploadChannel (Channel& channel);
+
+    juce::Component&        targetComponent;
+    const Style             style;
+    juce::OpenGLContext     context;
+
+    juce::CriticalSection   lock;             // guards everything below, except the GL objects
+    std::vector<Channel>    channels;
+    int                     channelCapacity { 2048 };
+    double                  timeBase        { 0.0 };
+    bool                    hasTimeBase     { false };
+    double                  viewTime        { 0.0 };   // right edge
+    float                   windowSecs      { 8.0f };
+
+    // Render-thread GL objects
+    std::unique_ptr<juce::OpenGLShaderProgram> gridShader, curveShader;
+    juce::uint32                               quadVbo { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchGraphGLRenderer)
+};
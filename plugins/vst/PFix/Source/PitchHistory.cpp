@@ -0,0 +1,379 @@
+/*
+  ==============================================================================
+    PitchHistory.cpp  –  PitchHistory implementation
+  ==============================================================================
+*/
+
+#include "PitchHistory.h"
+
+// ── Binary encoding helpers ───────────────────────────────────────────────────
+namespace HistoryCodec
+{
+    constexpr juce::uint32 kMagic           = 0x31485850;   // "PXH1", little-endian
+    constexpr double       kTicksPerSecond  = 10000.0;      // 100 µs timestamp resolution
+
+    void writeVarint (juce::MemoryOutputStream& out, juce::uint64 v)
+    {
+        while (v >= 0x80)
+        {
+            out.writeByte (static_cast<char> ((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+
+        out.writeByte (static_cast<char> (v));
+    }
+
+    bool readVarint (const juce::uint8*& p, const juce::uint8* end, juce::uint64& v) noexcept
+    {
+        v = 0;
+
+        for (int shift = 0; shift < 64 && p < end; shift += 7)
+        {
+            const juce::uint8 byte = *p++;
+            v |= static_cast<juce::uint64> (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    juce::uint64 zigZag   (juce::int64  v) noexcept { return (static_cast<juce::uint64> (v) << 1) ^ static_cast<juce::uint64> (v >> 63); }
+    juce::int64  unZigZag (juce::uint64 v) noexcept { return static_cast<juce::int64> (v >> 1) ^ -static_cast<juce::int64> (v & 1); }
+
+    juce::int64 hzToCents (float hz) noexcept
+    {
+        return static_cast<juce::int64> (std::lround (1200.0 * std::log2 (static_cast<double> (hz) / 440.0)));
+    }
+
+    float centsToHz (juce::int64 cents) noexcept
+    {
+        return static_cast<float> (440.0 * std::exp2 (static_cast<double> (cents) / 1200.0));
+    }
+
+    juce::int64 toTicks (double seconds) noexcept
+    {
+        return static_cast<juce::int64> (std::llround (seconds * kTicksPerSecond));
+    }
+}
+
+// ── Construction ─────────────────────────────────────────────────────────────
+
+PitchHistory::PitchHistory (std::vector<PitchStream*> streamsToRead)
+    : lastMissedCounts (streamsToRead.size(), 0)
+{
+    for (auto* stream : streamsToRead)
+        readers.emplace_back (*stream);
+
+    drained.reserve ((size_t) PitchStream::kCapacity);
+    startTimerHz (30);
+}
+
+PitchHistory::~PitchHistory()
+{
+    stopTimer();
+    cancelPendingUpdate();
+}
+
+void PitchHistory::setMaxDuration (double seconds)
+{
+    const juce::ScopedLock sl (lock);
+    maxSeconds = juce::jmax (1.0, seconds);
+}
+
+void PitchHistory::clear()
+{
+    {
+        const juce::ScopedLock sl (lock);
+        channels.clear();
+        segmenters.clear();
+        notes.clear();
+        newestTimestamp = 0.0;
+        timeOffset      = 0.0;
+    }
+
+    triggerAsyncUpdate();
+}
+
+double PitchHistory::getLiveTimeOffset() const
+{
+    const juce::ScopedLock sl (lock);
+    return timeOffset;
+}
+
+// ── Draining ─────────────────────────────────────────────────────────────────
+
+void PitchHistory::drainStreams()
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    drained.clear();
+    endedNotes.clear();
+    lastDrain.pointsDropped = 0;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        // One acquire load per chunk read, however many hops arrived.  A
+        // reader that was lapped resyncs to the oldest point still there.
+        for (size_t r = 0; r < readers.size(); ++r)
+        {
+            readers[r].readAll ([this] (const PitchPoint* points, int num)
+            {
+                for (int i = 0; i < num; ++i)
+                    addPoint (points[i]);
+            });
+
+            // Points are only lost when this timer is starved (host stall);
+            // log it so capacities can be sized from real numbers.
+            const auto& stats = readers[r].getStats();
+            if (stats.missed > lastMissedCounts[r])
+                DBG ("PitchHistory: " << (juce::int64) (stats.missed - lastMissedCounts[r])
+                     << " pitch points missed on stream " << (int) r
+                     << " (max lag " << stats.maxLag
+                     << " / " << PitchStream::kCapacity << ")");
+
+            lastMissedCounts[r] = stats.missed;
+            lastDrain.pointsDropped += stats.missed;
+        }
+
+        // Prune each channel to the last maxSeconds
+        const double pruneBelow = newestTimestamp - maxSeconds;
+        for (auto& history : channels)
+            while (! history.empty() && history.front().timestamp < pruneBelow)
+                history.pop_front();
+
+        for (auto& channelNotes : notes)
+            while (! channelNotes.empty() && channelNotes.front().endTimestamp < pruneBelow)
+                channelNotes.pop_front();
+    }
+
+    lastDrain.numPoints = static_cast<int> (drained.size());
+    lastDrain.drainMs   = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+    if (! drained.empty())
+        listeners.call ([this] (Listener& l) { l.pitchPointsAdded (drained.data(), static_cast<int> (drained.size())); });
+
+    if (! endedNotes.empty())
+        listeners.call ([this] (Listener& l) { l.notesAdded (endedNotes.data(), static_cast<int> (endedNotes.size())); });
+}
+
+void PitchHistory::addPoint (PitchPoint pt)
+{
+    if (pt.channel < 0 || pt.channel >= kMaxChannels)
+        return;
+
+    pt.timestamp += timeOffset;
+
+    if (pt.timestamp < newestTimestamp - kRestartToleranceSeconds)
+    {
+        const double shift = newestTimestamp + kRestartGapSeconds - pt.timestamp;
+        timeOffset   += shift;
+        pt.timestamp += shift;
+
+        // No note carries across the restart
+        for (size_t ch = 0; ch < segmenters.size(); ++ch)
+        {
+            NoteEvent note;
+
+            if (segmenters[ch].flush (note))
+                keepNote (note, (int) ch, &endedNotes);
+        }
+    }
+
+    if ((size_t) pt.channel >= channels.size())
+    {
+        channels  .resize ((size_t) pt.channel + 1);
+        segmenters.resize ((size_t) pt.channel + 1);
+        notes     .resize ((size_t) pt.channel + 1);
+    }
+
+    channels[(size_t) pt.channel].push_back (pt);
+    newestTimestamp = std::max (newestTimestamp, pt.timestamp);
+    drained.push_back (pt);
+    segmentPoint (pt, &endedNotes);
+}
+
+void PitchHistory::segmentPoint (const PitchPoint& pt, std::vector<NoteEvent>* ended)
+{
+    NoteEvent note;
+
+    if (segmenters[(size_t) pt.channel].addPoint (pt.timestamp, pt.pitchHz, note))
+        keepNote (note, pt.channel, ended);
+}
+
+void PitchHistory::keepNote (NoteEvent note, int channel, std::vector<NoteEvent>* ended)
+{
+    note.channel = channel;
+    notes[(size_t) channel].push_back (note);
+
+    if (ended != nullptr)
+        ended->push_back (note);
+}
+
+void PitchHistory::resegmentAll()
+{
+    segmenters.assign (channels.size(), {});
+    notes.assign (channels.size(), {});
+
+    for (const auto& history : channels)
+        for (const auto& pt : history)
+            segmentPoint (pt, nullptr);   // not news: the listeners reload everything
+}
+
+void PitchHistory::copyPoints (std::vector<PitchPoint>& out) const
+{
+    const juce::ScopedLock sl (lock);
+    out.clear();
+
+    for (const auto& history : channels)
+        out.insert (out.end(), history.begin(), history.end());
+}
+
+void PitchHistory::copyNotes (std::vector<NoteEvent>& out) const
+{
+    const juce::ScopedLock sl (lock);
+    out.clear();
+
+    for (const auto& channelNotes : notes)
+        out.insert (out.end(), channelNotes.begin(), channelNotes.end());
+}
+
+void PitchHistory::copyOpenNotes (std::vector<NoteEvent>& out) const
+{
+    const juce::ScopedLock sl (lock);
+    out.clear();
+
+    for (size_t ch = 0; ch < segmenters.size(); ++ch)
+    {
+        NoteEvent note;
+
+        if (segmenters[ch].getOpenNote (note))
+        {
+            note.channel = (int) ch;
+            out.push_back (note);
+        }
+    }
+}
+
+// ── Saving / restoring ───────────────────────────────────────────────────────
+
+juce::MemoryBlock PitchHistory::toBinary() const
+{
+    juce::MemoryBlock block;
+    juce::MemoryOutputStream out (block, false);
+
+    const juce::ScopedLock sl (lock);
+
+    out.writeInt (static_cast<int> (HistoryCodec::kMagic));
+    HistoryCodec::writeVarint (out, channels.size());
+
+    for (const auto& history : channels)
+    {
+        HistoryCodec::writeVarint (out, history.size());
+
+        if (history.empty())
+            continue;
+
+        // Absolute start, then per point: Δtime, and either 0 (unvoiced) or
+        // zig-zag(Δcents) << 1 | 1, where Δcents is from the last voiced point.
+        juce::int64 previousTicks = HistoryCodec::toTicks (history.front().timestamp);
+        juce::int64 previousCents = 0;
+        HistoryCodec::writeVarint (out, (juce::uint64) juce::jmax ((juce::int64) 0, previousTicks));
+
+        for (const auto& pt : history)
+        {
+            const juce::int64 ticks = HistoryCodec::toTicks (pt.timestamp);
+            HistoryCodec::writeVarint (out, (juce::uint64) juce::jmax ((juce::int64) 0, ticks - previousTicks));
+            previousTicks = juce::jmax (previousTicks, ticks);
+
+            if (pt.pitchHz > 0.0f)
+            {
+                const juce::int64 cents = HistoryCodec::hzToCents (pt.pitchHz);
+                HistoryCodec::writeVarint (out, (HistoryCodec::zigZag (cents - previousCents) << 1) | 1);
+                previousCents = cents;
+            }
+            else
+            {
+                HistoryCodec::writeVarint (out, 0);
+            }
+        }
+    }
+
+    out.flush();
+    return block;
+}
+
+bool PitchHistory::restoreFromBinary (const void* data, size_t numBytes)
+{
+    if (data == nullptr || numBytes < 4)
+        return false;
+
+    const auto* p   = static_cast<const juce::uint8*> (data);
+    const auto* end = p + numBytes;
+
+    if (static_cast<juce::uint32> (juce::ByteOrder::littleEndianInt (p)) != HistoryCodec::kMagic)
+        return false;
+
+    p += 4;
+
+    juce::uint64 numChannels = 0;
+    if (! HistoryCodec::readVarint (p, end, numChannels) || numChannels > (juce::uint64) kMaxChannels)
+        return false;
+
+    std::vector<std::deque<PitchPoint>> restored ((size_t) numChannels);
+    double newest = 0.0;
+
+    for (size_t ch = 0; ch < restored.size(); ++ch)
+    {
+        juce::uint64 numPoints = 0;
+        if (! HistoryCodec::readVarint (p, end, numPoints) || numPoints > (juce::uint64) (end - p))
+            return false;   // every point takes at least two bytes
+
+        if (numPoints == 0)
+            continue;
+
+        juce::uint64 startTicks = 0;
+        if (! HistoryCodec::readVarint (p, end, startTicks))
+            return false;
+
+        auto        ticks = static_cast<juce::int64> (startTicks);
+        juce::int64 cents = 0;
+
+        for (juce::uint64 i = 0; i < numPoints; ++i)
+        {
+            juce::uint64 deltaTicks = 0, pitchCode = 0;
+            if (! HistoryCodec::readVarint (p, end, deltaTicks) || ! HistoryCodec::readVarint (p, end, pitchCode))
+                return false;
+
+            ticks += static_cast<juce::int64> (deltaTicks);
+
+            float pitchHz = 0.0f;
+            if ((pitchCode & 1) != 0)
+            {
+                cents  += HistoryCodec::unZigZag (pitchCode >> 1);
+                pitchHz = HistoryCodec::centsToHz (cents);
+            }
+
+            const double timestamp = static_cast<double> (ticks) / HistoryCodec::kTicksPerSecond;
+            restored[ch].push_back ({ pitchHz, static_cast<int> (ch), timestamp });
+            newest = std::max (newest, timestamp);
+        }
+    }
+
+    {
+        const juce::ScopedLock sl (lock);
+        channels        = std::move (restored);
+        newestTimestamp = newest;
+        timeOffset      = 0.0;   // the next live point re-anchors (see addPoint)
+        resegmentAll();
+    }
+
+    triggerAsyncUpdate();
+    return true;
+}
+
+void PitchHistory::handleAsyncUpdate()
+{
+    listeners.call ([] (Listener& l) { l.pitchHistoryReplaced(); });
+}
@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+    PitchHistory.h  –  Message-thread store of recent pitch points
+
+    The processor-side home of the pitch history: reads every PitchStream
+    at 30 Hz (through a Reader of its own), keeps the last few minutes per
+    channel, and hands each batch of new points to its listeners (the graph).
+    Because it lives in the processor, it survives the editor being closed
+    and is what getStateInformation() saves.
+
+    Every channel's points also run through a NoteSegmenter as they are
+    added, and the history keeps the finished notes over the same span, so
+    its listeners get notes as well as points.  Notes aren't saved: a
+    restored history is segmented again.
+
+    Saved form (toBinary / restoreFromBinary), per channel:
+      • timestamps as varint deltas in 100 µs units (~1 byte per hop)
+      • pitch as zig-zag varint deltas of whole cents re A4, with a voiced bit
+    so a steady note costs about two bytes per point.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include "NoteSegmenter.h"
+#include "PitchDataQueue.h"
+#include <deque>
+#include <vector>
+
+class PitchHistory  : private juce::Timer,
+                      private juce::AsyncUpdater
+{
+public:
+    static constexpr double kDefaultMaxSeconds = 600.0;   // 10 minutes per channel
+    static constexpr int    kMaxChannels       = 16;
+
+    /** Message thread only (the callbacks come from this object's timer). */
+    struct Listener
+    {
+        virtual ~Listener() = default;
+
+        /** New points, already on the history's timeline. */
+        virtual void pitchPointsAdded (const PitchPoint* points, int numPoints) = 0;
+
+        /** Notes that ended with those points, channel tags set, in the
+            order they ended.  Called after pitchPointsAdded(). */
+        virtual void notesAdded (const NoteEvent* /*notes*/, int /*numNotes*/) {}
+
+        /** The whole history was swapped (restored from state or cleared):
+            re-read it with copyPoints() and copyNotes(). */
+        virtual void pitchHistoryReplaced() = 0;
+    };
+
+    /** The streams must outlive this object. */
+    explicit PitchHistory (std::vector<PitchStream*> streamsToRead);
+    ~PitchHistory() override;
+
+    /** Points older than this (relative to the newest) are discarded. */
+    void   setMaxDuration (double seconds);
+    double getMaxDuration () const noexcept { return maxSeconds; }
+
+    void addListener    (Listener* l) { listeners.add (l); }
+    void removeListener (Listener* l) { listeners.remove (l); }
+
+    /** Every stored point, channel by channel, each channel oldest first.
+        Safe from any thread. */
+    void copyPoints (std::vector<PitchPoint>& out) const;
+
+    /** Every finished note, channel by channel, each channel oldest first.
+        Safe from any thread. */
+    void copyNotes (std::vector<NoteEvent>& out) const;
+
+    /** The notes still in progress, at most one per channel.  Safe from any
+        thread. */
+    void copyOpenNotes (std::vector<NoteEvent>& out) const;
+
+    /** Compact encoding of the whole history.  Safe from any thread. */
+    juce::MemoryBlock toBinary() const;
+
+    /** Replaces the history with a toBinary() blob.  Returns false, leaving
+        the history untouched, if the data isn't valid.  Safe from any
+        thread; listeners are told on the message thread. */
+    bool restoreFromBinary (const void* data, size_t numBytes);
+
+    void clear();
+
+    /** What is added to a processor timestamp to put it on the history's
+        timeline, for data that reaches the editor by another path (the
+        spectrogram).  Safe from any thread. */
+    double getLiveTimeOffset() const;
+
+    /** What the last timer tick cost, for PitchGraphComponent's
+        performance overlay.  Message thread. */
+    struct DrainStats
+    {
+        int          numPoints     { 0 };     ///< Points drained (the streams' combined backlog)
+        double       drainMs       { 0.0 };   ///< Draining and pruning, listeners excluded
+        juce::uint64 pointsDropped { 0 };     ///< Lapped by the producers before they were read, ever
+    };
+
+    const DrainStats& getLastDrain() const noexcept { return lastDrain; }
+
+    /** Reads the streams and tells the listeners, as the timer does every
+        tick; for driving the history without a message loop (PFixPaintBench).
+        Message thread. */
+    void drainStreams();
+
+private:
+    void timerCallback() override { drainStreams(); }
+    void handleAsyncUpdate() override;   // tells the listeners about a replaced history
+
+    /** Appends one drained point, moving it onto the history's timeline. */
+    void addPoint (PitchPoint pt);
+
+    /** Runs a point already on the timeline through its channel's
+        segmenter; a note it ends is kept, and added to `ended` if given. */
+    void segmentPoint (const PitchPoint& pt, std::vector<NoteEvent>* ended);
+    void keepNote (NoteEvent note, int channel, std::vector<NoteEvent>* ended);
+
+    /** Segments every channel afresh, e.g. after a restore. */
+    void resegmentAll();
+
+    // The processor's clock restarts at 0 on every prepareToPlay(), and a
+    // restored history already has points: when a drained point lands more
+    // than this far *before* the newest one, the live timeline is shifted
+    // to continue just after the history.
+    static constexpr double kRestartToleranceSeconds = 1.0;
+    static constexpr double kRestartGapSeconds       = 0.5;
+
+    std::vector<PitchStream::Reader>      readers;             // one per stream
+    std::vector<juce::uint64>             lastMissedCounts;    // per reader, missed count at the last log
+    std::vector<PitchPoint>               drained;             // this tick's points, for the listeners
+    std::vector<NoteEvent>                endedNotes;          // this tick's notes, likewise
+    DrainStats                            lastDrain;
+
+    juce::CriticalSection                 lock;                // guards everything below
+    std::vector<std::deque<PitchPoint>>   channels;            // index = channel, grown on demand
+    std::vector<NoteSegmenter>            segmenters;          // parallel to channels
+    std::vector<std::deque<NoteEvent>>    notes;               // likewise
+    double                                newestTimestamp { 0.0 };
+    double                                timeOffset      { 0.0 };   // added to live timestamps
+    double                                maxSeconds      { kDefaultMaxSeconds };
+
+    juce::ListenerList<Listener>          listeners;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchHistory)
+};
@@ -0,0 +1,451 @@
+/*
+  ==============================================================================
+    PitchSessionIndex.cpp  –  PitchSessionIndex implementation
+  ==============================================================================
+*/
+
+#include "PitchSessionIndex.h"
+#include "PitchSessionRecorder.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // ── Encoded buckets ──────────────────────────────────────────────────────
+    // Four uint16: min, max, last (MIDI × 256, 0 = none) and a point count
+    // that saturates.
+
+    struct EncodedBucket
+    {
+        juce::uint16 minQ, maxQ, lastQ, count;
+    };
+
+    static_assert (sizeof (EncodedBucket) == 8, "index buckets are 8 bytes on disk");
+
+    juce::uint16 quantiseMidi (float pitchHz) noexcept
+    {
+        if (pitchHz <= 0.0f)
+            return 0;
+
+        const float midi = 69.0f + 12.0f * std::log2 (pitchHz / 440.0f);
+        return (juce::uint16) juce::jlimit (1, 0xffff, juce::roundToInt (midi * 256.0f));
+    }
+
+    float unquantiseMidi (juce::uint16 q) noexcept
+    {
+        return q == 0 ? -1.0f : (float) q / 256.0f;
+    }
+
+    void merge (EncodedBucket& into, const EncodedBucket& newer) noexcept
+    {
+        into.count = (juce::uint16) juce::jmin (0xffff, (int) into.count + (int) newer.count);
+
+        if (newer.lastQ == 0)
+            return;
+
+        into.minQ  = into.minQ == 0 ? newer.minQ : juce::jmin (into.minQ, newer.minQ);
+        into.maxQ  = juce::jmax (into.maxQ, newer.maxQ);
+        into.lastQ = newer.lastQ;
+    }
+
+    struct Record
+    {
+        double      timestamp;
+        float       pitchHz;
+        juce::int32 channel;
+    };
+
+    Record readRecord (const char* sessionBase, juce::int64 index) noexcept
+    {
+        const char* p = sessionBase + PitchSessionRecorder::kHeaderBytes
+                                    + index * PitchSessionRecorder::kRecordBytes;
+        Record r;
+        std::memcpy (&r.timestamp, p,      sizeof (r.timestamp));
+        std::memcpy (&r.pitchHz,   p + 8,  sizeof (r.pitchHz));
+        std::memcpy (&r.channel,   p + 12, sizeof (r.channel));
+        return r;
+    }
+
+    template <typename T>
+    T readValue (const void* base, int offset) noexcept
+    {
+        T value;
+        std::memcpy (&value, static_cast<const char*> (base) + offset, sizeof (T));
+        return value;
+    }
+
+    template <typename T>
+    void writeValue (void* base, int offset, T value) noexcept
+    {
+        std::memcpy (static_cast<char*> (base) + offset, &value, sizeof (T));
+    }
+}
+
+// ── Open / close ──────────────────────────────────────────────────────────────
+
+bool PitchSessionIndex::open (const juce::File& sessionFile)
+{
+    close();
+
+    sessionMap = std::make_unique<juce::MemoryMappedFile> (sessionFile, juce::MemoryMappedFile::readOnly);
+    const auto* base = static_cast<const char*> (sessionMap->getData());
+
+    if (base == nullptr || (juce::int64) sessionMap->getSize() < PitchSessionRecorder::kHeaderBytes
+        || readValue<juce::uint32> (base, 0) != PitchSessionRecorder::kMagic
+        || readValue<juce::uint32> (base, 4) != PitchSessionRecorder::kVersion
+        || readValue<juce::uint32> (base, 8) != (juce::uint32) PitchSessionRecorder::kRecordBytes)
+    {
+        close();
+        return false;
+    }
+
+    // A file still being recorded may have more mapped than the header
+    // covers; one cut short by a crash can't have less.
+    const auto storedPoints = (juce::int64) readValue<juce::uint64> (base, 16);
+    const auto fitsInFile   = ((juce::int64) sessionMap->getSize() - PitchSessionRecorder::kHeaderBytes)
+                              / PitchSessionRecorder::kRecordBytes;
+    numPoints = juce::jmin (storedPoints, fitsInFile);
+
+    // Time range and channels; only per-channel order is guaranteed, so
+    // scan everything rather than trusting the first and last records.
+    startTime = std::numeric_limits<double>::max();
+    endTime   = std::numeric_limits<double>::lowest();
+
+    for (juce::int64 i = 0; i < numPoints; ++i)
+    {
+        const auto r = readRecord (base, i);
+        if (r.channel < 0 || r.channel >= kMaxChannels)
+            continue;
+
+        startTime   = juce::jmin (startTime, r.timestamp);
+        endTime     = juce::jmax (endTime,   r.timestamp);
+        numChannels = juce::jmax (numChannels, (int) r.channel + 1);
+    }
+
+    if (numChannels == 0)
+    {
+        startTime = endTime = 0.0;
+        return true;   // an empty session: nothing to index, nothing to draw
+    }
+
+    numBuckets0 = (juce::int64) std::floor ((endTime - startTime) / kLevel0Secs) + 1;
+
+    const auto sidecar = sessionFile.withFileExtension ("pfxi");
+    const auto fallback = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                              .getChildFile (sessionFile.getFileNameWithoutExtension()
+                                             + "-" + juce::String::toHexString (sessionFile.getFullPathName().hashCode64())
+                                             + ".pfxi");
+
+    if (openIndex (sidecar) || openIndex (fallback)
+        || buildIndex (sidecar) || buildIndex (fallback))
+        return true;
+
+    close();
+    return false;
+}
+
+void PitchSessionIndex::close()
+{
+    tiles.clear();
+    tileLookup.clear();
+    indexMap.reset();
+    sessionMap.reset();
+
+    numPoints   = 0;
+    numBuckets0 = 0;
+    numChannels = 0;
+    startTime   = 0.0;
+    endTime     = 0.0;
+}
+
+// ── Index file ────────────────────────────────────────────────────────────────
+// Header (64 bytes): magic, version, channels, levels, source point count,
+// start and end time, level-0 bucket count and duration.  Then per channel,
+// per level, numBucketsAt (level) encoded buckets.
+
+juce::int64 PitchSessionIndex::numBucketsAt (int level) const noexcept
+{
+    juce::int64 n = numBuckets0;
+    while (level-- > 0)
+        n = (n + kFanout - 1) / kFanout;
+    return n;
+}
+
+juce::int64 PitchSessionIndex::levelOffset (int channel, int level) const noexcept
+{
+    juce::int64 perChannel = 0, withinChannel = 0;
+
+    for (int l = 0; l < kNumLevels; ++l)
+    {
+        if (l == level)
+            withinChannel = perChannel;
+
+        perChannel += numBucketsAt (l);
+    }
+
+    return kIndexHeaderBytes + ((juce::int64) channel * perChannel + withinChannel) * kBucketBytes;
+}
+
+bool PitchSessionIndex::openIndex (const juce::File& indexFile)
+{
+    if (! indexFile.existsAsFile())
+        return false;
+
+    auto map = std::make_unique<juce::MemoryMappedFile> (indexFile, juce::MemoryMappedFile::readOnly);
+    const void* header = map->getData();
+
+    if (header == nullptr || (juce::int64) map->getSize() < kIndexHeaderBytes
+        || readValue<juce::uint32> (header, 0)  != kIndexMagic
+        || readValue<juce::uint32> (header, 4)  != kIndexVersion
+        || readValue<juce::uint32> (header, 8)  != (juce::uint32) numChannels
+        || readValue<juce::uint32> (header, 12) != (juce::uint32) kNumLevels
+        || readValue<juce::uint64> (header, 16) != (juce::uint64) numPoints
+        || readValue<double>       (header, 24) != startTime
+        || readValue<double>       (header, 32) != endTime
+        || readValue<juce::int64>  (header, 40) != numBuckets0
+        || readValue<double>       (header, 48) != kLevel0Secs
+        || (juce::int64) map->getSize() < levelOffset (numChannels, 0))
+        return false;
+
+    indexMap = std::move (map);
+    return true;
+}
+
+bool PitchSessionIndex::buildIndex (const juce::File& indexFile)
+{
+    const juce::int64 totalBytes = levelOffset (numChannels, 0);
+
+    // A zero-filled file of the final size (every bucket starts empty)
+    if (! indexFile.deleteFile() || indexFile.getParentDirectory().createDirectory().failed())
+        return false;
+
+    {
+        juce::FileOutputStream out (indexFile);
+
+        if (! out.openedOk())
+            return false;
+
+        out.setPosition (totalBytes - 1);
+        out.writeByte (0);
+        out.flush();
+
+        if (out.getStatus().failed())
+        {
+            indexFile.deleteFile();
+            return false;
+        }
+    }
+
+    auto map = std::make_unique<juce::MemoryMappedFile> (indexFile, juce::MemoryMappedFile::readWrite);
+    auto* data = static_cast<char*> (map->getData());
+
+    if (data == nullptr || (juce::int64) map->getSize() < totalBytes)
+    {
+        map.reset();
+        indexFile.deleteFile();
+        return false;
+    }
+
+    const auto bucketAt = [&] (int channel, int level, juce::int64 index) -> EncodedBucket*
+    {
+        return reinterpret_cast<EncodedBucket*> (data + levelOffset (channel, level) + index * kBucketBytes);
+    };
+
+    // Level 0 from the records.  Each channel's records are in time order,
+    // so the last voiced one merged into a bucket is its newest.
+    const auto* sessionBase = static_cast<const char*> (sessionMap->getData());
+
+    for (juce::int64 i = 0; i < numPoints; ++i)
+    {
+        const auto r = readRecord (sessionBase, i);
+        if (r.channel < 0 || r.channel >= kMaxChannels)
+            continue;
+
+        const auto          q     = quantiseMidi (r.pitchHz);
+        const EncodedBucket point { q, q, q, 1 };
+        const auto          index = juce::jlimit<juce::int64> (0, numBuckets0 - 1,
+                                        (juce::int64) ((r.timestamp - startTime) / kLevel0Secs));
+        merge (*bucketAt (r.channel, 0, index), point);
+    }
+
+    // Every higher level from the one below
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (int level = 1; level < kNumLevels; ++level)
+        {
+            const juce::int64 numBelow = numBucketsAt (level - 1);
+            const auto*       below    = bucketAt (ch, level - 1, 0);
+            auto*             here     = bucketAt (ch, level, 0);
+
+            for (juce::int64 i = 0; i < numBelow; ++i)
+                merge (here[i / kFanout], below[i]);
+        }
+    }
+
+    // Header last: an index cut short by a crash never validates
+    void* header = data;
+    writeValue<juce::uint32> (header, 4,  kIndexVersion);
+    writeValue<juce::uint32> (header, 8,  (juce::uint32) numChannels);
+    writeValue<juce::uint32> (header, 12, (juce::uint32) kNumLevels);
+    writeValue<juce::uint64> (header, 16, (juce::uint64) numPoints);
+    writeValue<double>       (header, 24, startTime);
+    writeValue<double>       (header, 32, endTime);
+    writeValue<juce::int64>  (header, 40, numBuckets0);
+    writeValue<double>       (header, 48, kLevel0Secs);
+    writeValue<juce::uint32> (header, 0,  kIndexMagic);
+
+    // Keep it mapped read-only from here on
+    map.reset();
+    return openIndex (indexFile);
+}
+
+// ── Queries ───────────────────────────────────────────────────────────────────
+
+const PitchSessionIndex::Tile& PitchSessionIndex::getTile (int channel, int level, juce::int64 tileIndex)
+{
+    const auto key = ((juce::uint64) channel << 56) | ((juce::uint64) level << 48) | (juce::uint64) tileIndex;
+
+    if (auto found = tileLookup.find (key); found != tileLookup.end())
+    {
+        tiles.splice (tiles.begin(), tiles, found->second);
+        return tiles.front();
+    }
+
+    // Reuse the least recently used tile's storage once the cache is full
+    if ((int) tiles.size() >= kMaxCachedTiles)
+    {
+        tileLookup.erase (tiles.back().key);
+        tiles.splice (tiles.begin(), tiles, std::prev (tiles.end()));
+    }
+    else
+    {
+        tiles.emplace_front();
+    }
+
+    auto& tile = tiles.front();
+    tile.key = key;
+    tile.buckets.clear();
+
+    const juce::int64 first = tileIndex * kBucketsPerTile;
+    const juce::int64 end   = juce::jmin (first + kBucketsPerTile, numBucketsAt (level));
+    const auto*       data  = static_cast<const char*> (indexMap->getData()) + levelOffset (channel, level);
+
+    for (juce::int64 i = first; i < end; ++i)
+    {
+        EncodedBucket e;
+        std::memcpy (&e, data + i * kBucketBytes, sizeof (e));
+        tile.buckets.push_back ({ unquantiseMidi (e.minQ), unquantiseMidi (e.maxQ),
+                                  unquantiseMidi (e.lastQ), (int) e.count });
+    }
+
+    tileLookup[key] = tiles.begin();
+    return tile;
+}
+
+double PitchSessionIndex::getBuckets (int channel, double rangeStart, double rangeEnd,
+                                      int maxBuckets, std::vector<Bucket>& out)
+{
+    out.clear();
+
+    if (indexMap == nullptr || channel < 0 || channel >= numChannels || rangeEnd <= rangeStart)
+        return 0.0;
+
+    const double span = rangeEnd - rangeStart;
+    maxBuckets = juce::jmax (1, maxBuckets);
+
+    // Zoomed in far enough that level 0 would be no denser than the records
+    if (span / kLevel0Secs <= (double) maxBuckets / kFanout)
+    {
+        getPoints (channel, rangeStart, rangeEnd, out);
+        return 0.0;
+    }
+
+    int    level     = 0;
+    double bucketLen = kLevel0Secs;
+
+    while (level + 1 < kNumLevels && span / bucketLen > (double) maxBuckets)
+    {
+        ++level;
+        bucketLen *= kFanout;
+    }
+
+    const juce::int64 numBuckets = numBucketsAt (level);
+    const juce::int64 first = juce::jmax<juce::int64> (0, (juce::int64) std::floor ((rangeStart - startTime) / bucketLen));
+    const juce::int64 end   = juce::jmin<juce::int64> (numBuckets, (juce::int64) std::ceil ((rangeEnd - startTime) / bucketLen));
+
+    for (juce::int64 i = first; i < end;)
+    {
+        const juce::int64 tileIndex = i / kBucketsPerTile;
+        const auto&       tile      = getTile (channel, level, tileIndex);
+        const juce::int64 tileEnd   = juce::jmin (end, (tileIndex + 1) * kBucketsPerTile);
+
+        for (; i < tileEnd; ++i)
+        {
+            const auto& b = tile.buckets[(size_t) (i - tileIndex * kBucketsPerTile)];
+            out.push_back ({ startTime + (double) i * bucketLen, b.minMidi, b.maxMidi, b.lastMidi, b.numPoints });
+        }
+    }
+
+    return bucketLen;
+}
+
+juce::int64 PitchSessionIndex::lowerBoundRecord (double timestamp) const noexcept
+{
+    const auto* base = static_cast<const char*> (sessionMap->getData());
+    juce::int64 lo = 0, hi = numPoints;
+
+    while (lo < hi)
+    {
+        const juce::int64 mid = lo + (hi - lo) / 2;
+
+        if (readRecord (base, mid).timestamp < timestamp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+void PitchSessionIndex::getPoints (int channel, double rangeStart, double rangeEnd,
+                                   std::vector<Bucket>& out) const
+{
+    const auto* base = static_cast<const char*> (sessionMap->getData());
+
+    // One point either side, so lines run on to the view's edges
+    bool haveBefore = false;
+    Bucket before {};
+
+    for (juce::int64 i = lowerBoundRecord (rangeStart - kOrderSlackSecs); i < numPoints; ++i)
+    {
+        const auto r = readRecord (base, i);
+
+        if (r.timestamp > rangeEnd + kOrderSlackSecs)
+            break;
+
+        if (r.channel != channel)
+            continue;
+
+        const float  midi = r.pitchHz > 0.0f ? unquantiseMidi (quantiseMidi (r.pitchHz)) : -1.0f;
+        const Bucket point { r.timestamp, midi, midi, midi, 1 };
+
+        if (r.timestamp < rangeStart)
+        {
+            before     = point;
+            haveBefore = true;
+            continue;
+        }
+
+        if (haveBefore)
+        {
+            out.push_back (before);
+            haveBefore = false;
+        }
+
+        out.push_back (point);
+
+        if (r.timestamp >= rangeEnd)
+            break;
+    }
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+    PitchSessionIndex.h  –  Zoomable, seekable reader for a recorded session
+
+    Reads the files PitchSessionRecorder writes, for views that span
+    anything from a few seconds to the whole session.
+
+    On open() a min/max pyramid is built into a sidecar file next to the
+    session ("<name>.pfxi", or in the temp folder if that isn't writable)
+    and reused as long as the session's point count hasn't changed:
+      • level 0 buckets cover kLevel0Secs, each level up kFanout times more
+      • per channel and level, a plain array of 8-byte buckets
+        (pitch in 1/256 semitone, 0 = nothing voiced)
+
+    Both files are memory-mapped and read in tiles of kBucketsPerTile
+    buckets, decoded into an LRU cache of at most kMaxCachedTiles, so
+    memory use doesn't depend on session length and a query never touches
+    more than a screen's worth of buckets.  Views short enough to show
+    single points read the records directly.
+
+    Message thread only (or any single thread).
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class PitchSessionIndex
+{
+public:
+    static constexpr double kLevel0Secs     = 1.0 / 32.0;   // ~5 points at 44.1 kHz / 256
+    static constexpr int    kFanout         = 4;
+    static constexpr int    kNumLevels      = 9;            // 31 ms … 34 min per bucket
+    static constexpr int    kBucketsPerTile = 256;
+    static constexpr int    kMaxCachedTiles = 512;          // ≈ 2 MB decoded
+    static constexpr int    kMaxChannels    = 16;           // higher channel tags are ignored
+
+    /** A span of one channel's points, or a single point. */
+    struct Bucket
+    {
+        double timestamp;   // start of the span (the point's own for single points)
+        float  minMidi;     // over voiced points
+        float  maxMidi;
+        float  lastMidi;    // newest voiced point; < 0 if nothing was voiced
+        int    numPoints;   // 0 = nothing recorded in the span
+    };
+
+    PitchSessionIndex() = default;
+
+    /** Maps `sessionFile` and builds its index, or reuses an up-to-date
+        one.  Returns false if the file isn't a readable session or the
+        index can't be written anywhere. */
+    bool open (const juce::File& sessionFile);
+    void close();
+
+    bool        isOpen()         const noexcept { return sessionMap != nullptr; }
+    double      getStartTime()   const noexcept { return startTime; }
+    double      getEndTime()     const noexcept { return endTime; }
+    int         getNumChannels() const noexcept { return numChannels; }
+    juce::int64 getNumPoints()   const noexcept { return numPoints; }
+
+    /** Replaces `out` with one channel's buckets overlapping
+        [rangeStart, rangeEnd), from the finest level that needs no more
+        than `maxBuckets`; single points when even level 0 would be coarser
+        than that.  Empty spans are included, so gaps stay gaps.  Returns
+        the span of each bucket in seconds, 0 for single points. */
+    double getBuckets (int channel, double rangeStart, double rangeEnd,
+                       int maxBuckets, std::vector<Bucket>& out);
+
+private:
+    struct DecodedBucket
+    {
+        float minMidi, maxMidi, lastMidi;
+        int   numPoints;
+    };
+
+    struct Tile
+    {
+        juce::uint64               key;
+        std::vector<DecodedBucket> buckets;
+    };
+
+    bool openIndex  (const juce::File& indexFile);
+    bool buildIndex (const juce::File& indexFile);
+
+    juce::int64 numBucketsAt (int level) const noexcept;
+    juce::int64 levelOffset  (int channel, int level) const noexcept;   // bytes into the index file
+
+    const Tile& getTile   (int channel, int level, juce::int64 tileIndex);
+    void        getPoints (int channel, double rangeStart, double rangeEnd, std::vector<Bucket>& out) const;
+
+    /** First record at or after `timestamp`; records are only sorted per
+        channel, so callers allow kOrderSlackSecs either side. */
+    juce::int64 lowerBoundRecord (double timestamp) const noexcept;
+
+    static constexpr juce::uint32 kIndexMagic       = 0x49584650;   // "PFXI"
+    static constexpr juce::uint32 kIndexVersion     = 1;
+    static constexpr juce::int64  kIndexHeaderBytes = 64;
+    static constexpr juce::int64  kBucketBytes      = 8;
+    static constexpr double       kOrderSlackSecs   = 1.0;
+
+    std::unique_ptr<juce::MemoryMappedFile> sessionMap, indexMap;
+    juce::int64 numPoints   { 0 };
+    juce::int64 numBuckets0 { 0 };
+    int         numChannels { 0 };
+    double      startTime   { 0.0 };
+    double      endTime     { 0.0 };
+
+    std::list<Tile>                                             tiles;        // most recently used first
+    std::unordered_map<juce::uint64, std::list<Tile>::iterator> tileLookup;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchSessionIndex)
+};
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+    PitchSessionRecorder.cpp  –  PitchSessionRecorder implementation
+  ==============================================================================
+*/
+
+#include "PitchSessionRecorder.h"
+
+PitchSessionRecorder::PitchSessionRecorder (PitchHistory& historyToFollow, PitchSubscribers& subscribersToJoin)
+    : juce::Thread ("PFix session recorder"),
+      history (historyToFollow),
+      subscribers (subscribersToJoin)
+{
+}
+
+PitchSessionRecorder::~PitchSessionRecorder()
+{
+    stopRecording();
+}
+
+// ── Start / stop (message thread) ─────────────────────────────────────────────
+
+bool PitchSessionRecorder::startRecording (const juce::File& file)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    stopRecording();
+
+    if (file.getParentDirectory().createDirectory().failed()
+        || ! file.deleteFile()
+        || file.create().failed())
+        return false;
+
+    outputFile = file;
+    pending.reset();
+    pointsWritten = 0;
+    writeFailures = 0;
+
+    if (! mapFile (kGrowBytes))
+    {
+        outputFile.deleteFile();
+        return false;
+    }
+
+    writeHeader();
+
+    recording    = true;
+    subscription = subscribers.subscribe();
+    history.addListener (this);
+    startThread (juce::Thread::Priority::low);
+    return true;
+}
+
+void PitchSessionRecorder::stopRecording()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! recording)
+        return;
+
+    history.removeListener (this);
+    subscription.reset();
+    recording = false;
+    stopThread (2000);   // run() writes whatever is still pending on the way out
+
+    mapping.reset();
+    mappedBytes = 0;
+
+    // Drop the unused tail of the last grow step.
+    juce::FileOutputStream out (outputFile);
+
+    if (out.openedOk())
+    {
+        out.setPosition (kHeaderBytes + pointsWritten.load() * kRecordBytes);
+        out.truncate();
+    }
+}
+
+void PitchSessionRecorder::pitchPointsAdded (const PitchPoint* points, int numPoints)
+{
+    if (! recording)
+        return;
+
+    pending.pushBlock (points, numPoints);
+    notify();
+}
+
+// ── Writer thread ─────────────────────────────────────────────────────────────
+
+void PitchSessionRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (kWaitMs);
+        writePending();
+    }
+
+    writePending();
+}
+
+void PitchSessionRecorder::writePending()
+{
+    const int numReady = pending.numReady();
+    if (numReady == 0)
+        return;
+
+    if (! ensureCapacity (numReady))
+    {
+        // Disk full or the file went away: count the points and keep going,
+        // in case space frees up for the next batch.
+        writeFailures += (juce::uint64) pending.popAll ([] (const PitchPoint*, int) {}, numReady);
+        return;
+    }
+
+    auto*       base    = static_cast<char*> (mapping->getData());
+    juce::int64 written = pointsWritten.load();
+
+    pending.popAll ([&] (const PitchPoint* points, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            char*              record  = base + kHeaderBytes + (written + i) * kRecordBytes;
+            const double       seconds = points[i].timestamp;
+            const float        pitchHz = points[i].pitchHz;
+            const juce::int32  channel = points[i].channel;
+
+            std::memcpy (record,      &seconds, sizeof (seconds));
+            std::memcpy (record + 8,  &pitchHz, sizeof (pitchHz));
+            std::memcpy (record + 12, &channel, sizeof (channel));
+        }
+
+        written += num;
+    }, numReady);
+
+    pointsWritten.store (written);
+    writeHeader();
+}
+
+bool PitchSessionRecorder::ensureCapacity (juce::int64 numPoints)
+{
+    const juce::int64 needed = kHeaderBytes + (pointsWritten.load() + numPoints) * kRecordBytes;
+
+    if (mapping != nullptr && needed <= mappedBytes)
+        return true;
+
+    // Grow in large steps so remapping stays rare (once every few minutes).
+    return mapFile ((needed + kGrowBytes - 1) / kGrowBytes * kGrowBytes);
+}
+
+bool PitchSessionRecorder::mapFile (juce::int64 numBytes)
+{
+    mapping.reset();   // unmap before the file changes size
+    mappedBytes = 0;
+
+    {
+        juce::FileOutputStream out (outputFile);
+
+        if (! out.openedOk())
+            return false;
+
+        if (out.getPosition() < numBytes)
+        {
+            out.setPosition (numBytes - 1);
+            out.writeByte (0);
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    mapping = std::make_unique<juce::MemoryMappedFile> (outputFile,
+                                                        juce::Range<juce::int64> (0, numBytes),
+                                                        juce::MemoryMappedFile::readWrite);
+
+    if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < numBytes)
+    {
+        mapping.reset();
+        return false;
+    }
+
+    mappedBytes = numBytes;
+    return true;
+}
+
+void PitchSessionRecorder::writeHeader()
+{
+    if (mapping == nullptr)
+        return;
+
+    auto* header = static_cast<char*> (mapping->getData());
+
+    const juce::uint32 magic      = kMagic;
+    const juce::uint32 version    = kVersion;
+    const juce::uint32 recordSize = (juce::uint32) kRecordBytes;
+    const juce::uint64 numPoints  = (juce::uint64) pointsWritten.load();
+
+    std::memcpy (header,      &magic,      sizeof (magic));
+    std::memcpy (header + 4,  &version,    sizeof (version));
+    std::memcpy (header + 8,  &recordSize, sizeof (recordSize));
+    std::memset (header + 12, 0, 4);
+    std::memcpy (header + 16, &numPoints,  sizeof (numPoints));
+    std::memset (header + 24, 0, 8);
+}
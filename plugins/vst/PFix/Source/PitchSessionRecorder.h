@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+    PitchSessionRecorder.h  –  Streams every pitch point to a session file
+
+    For whole-rehearsal logs (hours) that would never fit in PitchHistory.
+    While recording, the recorder listens to PitchHistory (which reads the
+    pitch streams) and copies each batch into its own LockFreeRing on the
+    message thread.  A background thread appends the points to a
+    memory-mapped file that grows kGrowBytes at a time, so memory use stays
+    flat and the audio thread pays nothing.
+
+    File layout (native byte order, i.e. little-endian on every target):
+      Header  (32 bytes)   magic "PFXR", version, record size, point count
+      Records (16 bytes)   double timestamp, float pitchHz, int32 channel
+
+    The point count is updated after every batch, so a crash leaves a file
+    whose header covers everything written up to that point.  On stop the
+    file is trimmed to its exact length.
+
+    A recording subscribes to the pitch streams (see PitchSubscribers), so
+    the analysis runs for it with the editor closed.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "PitchHistory.h"
+#include "../../Shared/LockFreeRing.h"
+#include <memory>
+
+class PitchSessionRecorder  : private juce::Thread,
+                              private PitchHistory::Listener
+{
+public:
+    static constexpr juce::uint32 kMagic       = 0x52584650;   // "PFXR"
+    static constexpr juce::uint32 kVersion     = 1;
+    static constexpr juce::int64  kHeaderBytes = 32;
+    static constexpr juce::int64  kRecordBytes = 16;
+    static constexpr juce::int64  kGrowBytes   = 1 << 20;   // 65 536 points ≈ 6 min of one channel
+
+    /** Both must outlive this object. */
+    PitchSessionRecorder (PitchHistory& historyToFollow, PitchSubscribers& subscribersToJoin);
+    ~PitchSessionRecorder() override;
+
+    /** Message thread.  Creates (or overwrites) the file and starts
+        appending every new point.  Returns false if the file can't be
+        created or mapped. */
+    bool startRecording (const juce::File& file);
+
+    /** Message thread.  Writes what's still queued, trims the file and
+        closes it.  Safe to call when not recording. */
+    void stopRecording();
+
+    bool        isRecording() const noexcept         { return recording; }
+    juce::File  getFile()     const                  { return outputFile; }
+    juce::int64 getNumPointsWritten() const noexcept { return pointsWritten.load(); }
+
+    /** Points the writer couldn't keep up with (ring overflow) or couldn't
+        store (disk full) since startRecording(). */
+    juce::uint64 getNumPointsLost() const noexcept
+    {
+        return pending.getStats().dropped + writeFailures.load();
+    }
+
+private:
+    // ── PitchHistory::Listener (message thread) ──────────────────────────────
+    void pitchPointsAdded (const PitchPoint* points, int numPoints) override;
+    void pitchHistoryReplaced() override {}   // a restored history isn't new data
+
+    // ── Writer thread ─────────────────────────────────────────────────────────
+    void run() override;
+    void writePending();
+
+    /** Makes sure the mapping can take `numPoints` more; false on failure. */
+    bool ensureCapacity (juce::int64 numPoints);
+    bool mapFile (juce::int64 numBytes);
+    void writeHeader();
+
+    static constexpr int kWaitMs = 50;
+
+    PitchHistory&                            history;
+    PitchSubscribers&                        subscribers;
+    PitchSubscribers::Subscription           subscription;    // while recording
+    LockFreeRing<PitchPoint, 16384>          pending;         // message thread → writer
+
+    juce::File                               outputFile;
+    std::unique_ptr<juce::MemoryMappedFile>  mapping;         // writer thread only
+    juce::int64                              mappedBytes  { 0 };
+    std::atomic<juce::int64>                 pointsWritten { 0 };
+    std::atomic<juce::uint64>                writeFailures { 0 };
+    bool                                     recording    { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchSessionRecorder)
+};
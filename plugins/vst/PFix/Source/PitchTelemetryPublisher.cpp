@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+    PitchTelemetryPublisher.cpp  –  PitchTelemetryPublisher implementation
+  ==============================================================================
+*/
+
+#include "PitchTelemetryPublisher.h"
+
+PitchTelemetryPublisher::PitchTelemetryPublisher (std::vector<PitchStream*> streamsToFollow,
+                                                  const PerfProbe& probeToPublish,
+                                                  const PitchDetectorCore::Counters& countersToPublish,
+                                                  PitchSubscribers& subscribersToJoin)
+    : probe (probeToPublish), counters (countersToPublish), subscribers (subscribersToJoin)
+{
+    for (auto* stream : streamsToFollow)
+        readers.emplace_back (*stream);
+}
+
+PitchTelemetryPublisher::~PitchTelemetryPublisher()
+{
+    stop();
+}
+
+// ── Start / stop (message thread) ─────────────────────────────────────────────
+
+bool PitchTelemetryPublisher::start()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    stop();
+
+    if (! publisher.open ("PFix"))
+        return false;
+
+    // Only what's pushed from now on: a dashboard wants the live curve
+    for (auto& reader : readers)
+        reader.skipToNewest();
+
+    formatChanged   = true;
+    ticksUntilLoads = 0;
+    publishedCounts = counters.getSnapshot();
+    subscription    = subscribers.subscribe();
+    startTimerHz (30);
+    return true;
+}
+
+void PitchTelemetryPublisher::stop()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    stopTimer();
+    publisher.close();
+    subscription.reset();
+}
+
+void PitchTelemetryPublisher::setFormat (double sampleRate, int numChannels) noexcept
+{
+    formatSampleRate .store (sampleRate);
+    formatNumChannels.store (numChannels);
+    formatChanged    .store (true);
+}
+
+// ── Publishing ───────────────────────────────────────────────────────────────
+
+void PitchTelemetryPublisher::timerCallback()
+{
+    if (formatChanged.exchange (false))
+        publisher.setInfo (formatSampleRate.load(), formatNumChannels.load(), &probe);
+
+    const auto time = SharedTelemetry::now();
+
+    for (auto& reader : readers)
+    {
+        reader.readAll ([this, time] (const PitchPoint* points, int num)
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                auto& record      = batch[(size_t) i];
+                record.time       = time;
+                record.sourceTime = points[i].timestamp;
+                record.kind       = TelemetryRecord::pitch;
+                record.channel    = points[i].channel;
+                record.values     = { points[i].pitchHz, 0.0f, 0.0f, 0.0f };
+            }
+
+            publisher.publish (batch.data(), num);
+        });
+    }
+
+    if (--ticksUntilLoads <= 0)
+    {
+        ticksUntilLoads = kLoadEveryTicks;
+        publisher.publishLoads (probe);
+        publishDetectorCounts();
+    }
+}
+
+void PitchTelemetryPublisher::publishDetectorCounts()
+{
+    // Counts over one load interval stay far inside a float's exact range
+    const auto now    = counters.getSnapshot();
+    const auto counts = now - publishedCounts;
+    publishedCounts   = now;
+
+    std::array<TelemetryRecord, 2> records;
+    const auto time = SharedTelemetry::now();
+
+    for (auto& record : records)
+    {
+        record.time = time;
+        record.kind = TelemetryRecord::detector;
+    }
+
+    records[0].channel = 0;
+    records[0].values  = { (float) counts.frames,        (float) counts.energyGated,
+                           (float) counts.unvoicedGated, (float) counts.lagsSearched };
+    records[1].channel = 1;
+    records[1].values  = { (float) counts.trackingFallbacks, (float) counts.interpolationFailures, 0.0f, 0.0f };
+
+    publisher.publish (records.data(), (int) records.size());
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+    PitchTelemetryPublisher.h  –  PFix's pitch and CPU load, for dashboards
+
+    While started, follows every pitch stream with a reader of its own and
+    copies the points, plus the PerfProbe's scope loads and what the
+    pitch detector counted (TelemetryRecord::detector), into a
+    SharedTelemetry region that external tools poll (see SharedTelemetry.h
+    for the layout and the reader).  It runs on the message thread at
+    30 Hz, beside PitchHistory rather than behind it, so the audio thread
+    pays nothing and the history doesn't either.  While started it
+    subscribes to the streams (see PitchSubscribers), so the analysis runs
+    for it with the editor closed.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include "PitchDataQueue.h"
+#include "PitchDetectorCore.h"
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/SharedTelemetry.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+class PitchTelemetryPublisher  : private juce::Timer
+{
+public:
+    /** The streams, the probe, the counters and the subscribers must
+        outlive this object. */
+    PitchTelemetryPublisher (std::vector<PitchStream*> streamsToFollow, const PerfProbe& probeToPublish,
+                             const PitchDetectorCore::Counters& countersToPublish,
+                             PitchSubscribers& subscribersToJoin);
+    ~PitchTelemetryPublisher() override;
+
+    /** Message thread.  Opens a region named "PFix" (numbered per instance)
+        and starts publishing the points from now on.  False if the region
+        can't be created. */
+    bool start();
+
+    /** Message thread.  Removes the region; safe when not started. */
+    void stop();
+
+    bool       isPublishing()  const noexcept { return publisher.isOpen(); }
+    juce::File getRegionFile() const          { return publisher.getFile(); }
+
+    /** The format the region's Info reports.  Any thread (prepareToPlay());
+        the next tick writes it. */
+    void setFormat (double sampleRate, int numChannels) noexcept;
+
+private:
+    void timerCallback() override;
+
+    /** The two TelemetryRecord::detector records, for the counts since the
+        last call. */
+    void publishDetectorCounts();
+
+    static constexpr int kLoadEveryTicks = 6;   // loads 5 times a second, which also beats the heartbeat
+
+    const PerfProbe&                                     probe;
+    const PitchDetectorCore::Counters&                   counters;
+    PitchDetectorCore::Counters::Snapshot                publishedCounts;   // as of the last detector records
+    PitchSubscribers&                                    subscribers;
+    PitchSubscribers::Subscription                       subscription;      // while started
+    std::vector<PitchStream::Reader>                     readers;
+    SharedTelemetry::Publisher                           publisher;
+    std::array<TelemetryRecord, PitchStream::kReadChunk> batch;   // one reader chunk's records
+    int                                                  ticksUntilLoads { 0 };
+
+    std::atomic<double>                                  formatSampleRate  { 0.0 };
+    std::atomic<int>                                     formatNumChannels { 0 };
+    std::atomic<bool>                                    formatChanged     { true };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchTelemetryPublisher)
+};
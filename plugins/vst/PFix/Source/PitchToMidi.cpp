@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+    PitchToMidi.cpp  –  PitchToMidi implementation
+  ==============================================================================
+*/
+
+#include "PitchToMidi.h"
+#include <cmath>
+
+void PitchToMidi::reset() noexcept
+{
+    resetPending.store (true);
+}
+
+void PitchToMidi::beginBlock (juce::MidiBuffer& midi, int sampleOffset) noexcept
+{
+    const auto wanted = requestedOutput.load (std::memory_order_relaxed);
+    const bool restart = resetPending.exchange (false) || wanted != output;
+
+    if (restart)
+    {
+        endNote (midi, sampleOffset);
+        numCandidates = 0;
+        nextCandidate = 0;
+        unvoicedHops  = 0;
+
+        if (wanted == Output::mpe)
+            announceMpeZone (midi, sampleOffset);
+    }
+
+    output = wanted;
+}
+
+void PitchToMidi::addPoint (float pitchHz, bool onset, juce::MidiBuffer& midi, int sampleOffset) noexcept
+{
+    if (output == Output::off)
+        return;
+
+    // ── Unvoiced: end the note after kReleaseHops of them ────────────────────
+    if (! (pitchHz > 0.0f))
+    {
+        numCandidates = 0;
+
+        if (++unvoicedHops >= kReleaseHops)
+            endNote (midi, sampleOffset);
+
+        return;
+    }
+
+    unvoicedHops = 0;
+    const float note = 69.0f + 12.0f * std::log2 (pitchHz / 440.0f);
+
+    if (heldNote >= 0)
+    {
+        if (output == Output::mpe)
+            sendBend (note, midi, sampleOffset);
+
+        // Only a point past the hysteresis band counts towards a new note;
+        // inside it, only a fresh attack ends this one
+        if (std::abs (note - (float) heldNote) <= 0.5f + kHysteresisSemitones)
+        {
+            numCandidates = 0;
+
+            if (onset)
+            {
+                const auto sameNote = (float) heldNote;
+                endNote (midi, sampleOffset);
+                startNote (sameNote, note, midi, sampleOffset);
+            }
+
+            return;
+        }
+    }
+
+    // ── A new note once the candidates agree ─────────────────────────────────
+    candidates[nextCandidate] = note;
+    nextCandidate = (nextCandidate + 1) % kOnsetHops;
+    numCandidates = juce::jmin (numCandidates + 1, kOnsetHops);
+
+    float onsetNote;
+
+    if (candidatesAreStable (onsetNote))
+    {
+        endNote (midi, sampleOffset);
+        startNote (onsetNote, note, midi, sampleOffset);
+        numCandidates = 0;
+    }
+}
+
+bool PitchToMidi::candidatesAreStable (float& note) const noexcept
+{
+    if (numCandidates < kOnsetHops)
+        return false;
+
+    float low = candidates[0], high = candidates[0], sum = 0.0f;
+
+    for (const float c : candidates)
+    {
+        low  = juce::jmin (low,  c);
+        high = juce::jmax (high, c);
+        sum += c;
+    }
+
+    note = sum / (float) kOnsetHops;
+    return high - low <= kStableSemitones;
+}
+
+//==============================================================================
+void PitchToMidi::startNote (float onsetNote, float currentNote, juce::MidiBuffer& midi, int sampleOffset) noexcept
+{
+    heldNote = juce::jlimit (0, 127, juce::roundToInt (onsetNote));
+
+    if (output == Output::mpe)
+    {
+        // Round-robin over the members, so a release tail on one channel
+        // isn't bent by the next note
+        heldChannel = 2 + nextMember;
+        nextMember  = (nextMember + 1) % kNumMpeMembers;
+
+        // Bent before it sounds, so the attack is already in tune
+        sendBend (currentNote, midi, sampleOffset);
+    }
+    else
+    {
+        heldChannel = 1;
+    }
+
+    midi.addEvent (juce::MidiMessage::noteOn (heldChannel, heldNote, (juce::uint8) kVelocity), sampleOffset);
+}
+
+void PitchToMidi::endNote (juce::MidiBuffer& midi, int sampleOffset) noexcept
+{
+    if (heldNote < 0)
+        return;
+
+    midi.addEvent (juce::MidiMessage::noteOff (heldChannel, heldNote), sampleOffset);
+    heldNote = -1;
+}
+
+void PitchToMidi::sendBend (float midiNote, juce::MidiBuffer& midi, int sampleOffset) const noexcept
+{
+    const float bend  = (midiNote - (float) heldNote) / (float) kMpeBendSemitones;
+    const int   value = juce::jlimit (0, 16383, 8192 + juce::roundToInt (bend * 8192.0f));
+
+    midi.addEvent (juce::MidiMessage::pitchWheel (heldChannel, value), sampleOffset);
+}
+
+void PitchToMidi::announceMpeZone (juce::MidiBuffer& midi, int sampleOffset) const noexcept
+{
+    // MPE Configuration Message (RPN 6) on the master channel: a lower zone
+    // of kNumMpeMembers; receivers then default the members' bend range to
+    // 48 semitones.  Written by hand, as juce::MPEMessages allocates.
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 101, 0), sampleOffset);
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 100, 6), sampleOffset);
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 6, kNumMpeMembers), sampleOffset);
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 101, 127), sampleOffset);
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 100, 127), sampleOffset);
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+    PitchToMidi.h  –  Notes from the pitch stream, one decision per hop
+
+    Turns the HopAnalyser's PitchPoints into MIDI notes with a detector that
+    costs a few comparisons per point and needs nothing but the pitch:
+
+      • Onset:   kOnsetHops voiced points in a row within kStableSemitones
+                 of each other start a note at the nearest semitone.
+      • Offset:  kReleaseHops unvoiced points in a row end it, so a short
+                 consonant between two sung syllables re-triggers the note.
+      • Change:  once a note is held, kOnsetHops stable points more than
+                 half a semitone plus kHysteresisSemitones away end it and
+                 start the new one at the same sample (legato).
+      • Attack:  a spectral onset (see SpectralOnsetDetector) while the
+                 pitch stays on the held note re-triggers it, for repeated
+                 notes sung without a gap.
+
+    In Output::mpe every note takes the next member channel of an MPE lower
+    zone (channels 2–16, announced on channel 1 before the first note), and
+    each voiced point also sends that channel's pitch bend, so vibrato and
+    slides come through between the semitones; the bend range is the MPE
+    default of kMpeBendSemitones.
+
+    Single-threaded: whichever thread calls beginBlock() and addPoint() owns
+    it (the audio thread), except setOutput() and reset(), see below.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+
+class PitchToMidi
+{
+public:
+    enum class Output { off, midi, mpe };
+
+    static constexpr int   kOnsetHops           = 2;
+    static constexpr int   kReleaseHops         = 2;
+    static constexpr float kStableSemitones     = 0.5f;    // widest spread of the onset points
+    static constexpr float kHysteresisSemitones = 0.3f;    // on top of the half semitone to the next note
+    static constexpr int   kVelocity            = 100;     // the pitch says nothing about level
+    static constexpr int   kMpeBendSemitones    = 48;
+    static constexpr int   kNumMpeMembers       = 15;      // the whole lower zone
+
+    /** Safe to call from any thread; takes effect at the next beginBlock(),
+        which first ends any note held in the previous output. */
+    void   setOutput (Output newOutput) noexcept { requestedOutput.store (newOutput); }
+    Output getOutput () const noexcept           { return requestedOutput.load(); }
+
+    /** Forgets the points so far; a held note is ended at the next
+        beginBlock().  Only while processing is stopped or suspended. */
+    void reset() noexcept;
+
+    /** Applies a reset or an output change, both as MIDI at sampleOffset.
+        Call once per block before its points.  Realtime-safe. */
+    void beginBlock (juce::MidiBuffer& midi, int sampleOffset = 0) noexcept;
+
+    /** One hop's pitch (0 = unvoiced) and whether the same hop's spectrum
+        shows an onset, with any MIDI they cause written at sampleOffset.
+        Realtime-safe. */
+    void addPoint (float pitchHz, bool onset, juce::MidiBuffer& midi, int sampleOffset) noexcept;
+
+    bool isNoteOn() const noexcept { return heldNote >= 0; }
+
+private:
+    void startNote (float onsetNote, float currentNote, juce::MidiBuffer& midi, int sampleOffset) noexcept;
+    void endNote (juce::MidiBuffer& midi, int sampleOffset) noexcept;
+    void sendBend (float midiNote, juce::MidiBuffer& midi, int sampleOffset) const noexcept;
+    void announceMpeZone (juce::MidiBuffer& midi, int sampleOffset) const noexcept;
+
+    /** True once the last kOnsetHops candidates agree; note is their mean. */
+    bool candidatesAreStable (float& note) const noexcept;
+
+    std::atomic<Output> requestedOutput { Output::off };
+    std::atomic<bool>   resetPending    { false };
+    Output              output          { Output::off };   // as of the last beginBlock()
+
+    float candidates[kOnsetHops] {};
+    int   numCandidates { 0 };          // saturates at kOnsetHops; oldest first overwritten
+    int   nextCandidate { 0 };
+    int   unvoicedHops  { 0 };
+
+    int heldNote    { -1 };             // MIDI note number, -1 = none
+    int heldChannel { 1 };              // 1-based
+    int nextMember  { 0 };              // MPE: index of the next member channel
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PitchToMidi)
+};
@@ -27,5 +27,8 @@ private:
     PFixAudioProcessor&   audioProcessor;
     PitchGraphComponent   pitchGraph;
 
+    // Keeps the analysis running while the editor is open
+    PitchSubscribers::Subscription pitchSubscription;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PFixAudioProcessorEditor)
 };
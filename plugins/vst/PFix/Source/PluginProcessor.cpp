@@ -1,222 +1,617 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-// Include the implementation here so it is compiled without modifying
-// the Projucer / Xcode project file.  This is the standard JUCE unity-build
-// pattern — each .cpp is compiled exactly once.
-#include "PitchDetector.cpp"
-
-//==============================================================================
-PFixAudioProcessor::PFixAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
-#endif
-{
-}
-
-PFixAudioProcessor::~PFixAudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String PFixAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool PFixAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PFixAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PFixAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double PFixAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int PFixAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int PFixAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void PFixAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String PFixAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void PFixAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void PFixAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    currentSampleRate     = sampleRate;
-    analysisBuffer.assign (kAnalysisSize, 0.0f);
-    analysisBufferFill    = 0;
-    totalSamplesProcessed = 0;
-    pitchQueue.reset();
-
-    juce::ignoreUnused (samplesPerBlock);
-}
-
-void PFixAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool PFixAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void PFixAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    juce::ignoreUnused (midiMessages);
-
-    const int numInputChannels  = getTotalNumInputChannels();
-    const int numOutputChannels = getTotalNumOutputChannels();
-    const int numSamples        = buffer.getNumSamples();
-
-    // Clear any output-only channels (prevents garbage on extra outputs)
-    for (int ch = numInputChannels; ch < numOutputChannels; ++ch)
-        buffer.clear (ch, 0, numSamples);
-
-    // Nothing to analyse without input
-    if (numInputChannels == 0)
-    {
-        totalSamplesProcessed += numSamples;
-        return;
-    }
-
-    // ── Mix down to mono and accumulate into the analysis buffer ─────────────
-    const float* chL = buffer.getReadPointer (0);
-    const float* chR = (numInputChannels > 1) ? buffer.getReadPointer (1) : nullptr;
-
-    for (int i = 0; i < numSamples; ++i)
-    {
-        const float mono = chR ? (chL[i] + chR[i]) * 0.5f : chL[i];
-        analysisBuffer[analysisBufferFill++] = mono;
-
-        if (analysisBufferFill >= kAnalysisSize)
-        {
-            // ── Run YIN on the completed analysis window ─────────────────
-            const float pitchHz =
-                pitchDetector.detectPitch (analysisBuffer.data(),
-                                           kAnalysisSize,
-                                           currentSampleRate);
-
-            // Timestamp = position of the last sample in this window
-            const double timestamp =
-                static_cast<double> (totalSamplesProcessed + i + 1)
-                / currentSampleRate;
-
-            pitchQueue.push ({ pitchHz, timestamp });
-            analysisBufferFill = 0;
-        }
-    }
-
-    totalSamplesProcessed += numSamples;
-}
-
-//==============================================================================
-bool PFixAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* PFixAudioProcessor::createEditor()
-{
-    return new PFixAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void PFixAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-}
-
-void PFixAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new PFixAudioProcessor();
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS
+
+//==============================================================================
+PFixAudioProcessor::PFixAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       ),
+       apvts (*this, nullptr, "Parameters", createParameterLayout())
+#else
+     : apvts (*this, nullptr, "Parameters", createParameterLayout())
+#endif
+{
+    // O(N log N) difference function — the direct double loop dominated our CPU
+    pitchDetector.setDifferenceEngine (PitchDetector::DifferenceEngine::fft);
+    pitchDetector.setLazyEvaluation (true);
+    detectorSettings = makeDetectorSettings (currentSampleRate);
+
+    analysisSource.setPerfProbe (&perfProbe, yinScope);
+    hopAnalyser.setSpectralFrames (&spectralFrames);
+
+    for (const auto* id : { "analysisSize", "hop", "engine", "threshold" })
+        apvts.addParameterListener (id, this);
+}
+
+PFixAudioProcessor::~PFixAudioProcessor()
+{
+    for (const auto* id : { "analysisSize", "hop", "engine", "threshold" })
+        apvts.removeParameterListener (id, this);
+
+    stopTimer();
+    cancelPendingUpdate();
+    stopAnalysis();
+}
+
+//==============================================================================
+juce::AudioProcessorValueTreeState::ParameterLayout PFixAudioProcessor::createParameterLayout()
+{
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+
+    // Auto follows the sample rate (see kMinFrequencyHz); a smaller window
+    // answers sooner but can't see the lowest notes
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "analysisSize", "Analysis Size", juce::StringArray { "Auto", "1024", "2048", "4096", "8192" }, 0));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "hop", "Hop", juce::StringArray { "64", "128", "256", "512", "1024" }, 2));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "engine", "Engine", juce::StringArray { "Direct", "FFT", "Fixed Size" }, 1));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat> (
+        "threshold", "Threshold",
+        juce::NormalisableRange<float> (0.05f, 0.5f, 0.01f), 0.15f));
+
+    // In PitchToMidi::Output's order.  Off by default: notes keep the
+    // analysis running with the editor closed (see updateIdle())
+    params.push_back (std::make_unique<juce::AudioParameterChoice> (
+        "noteOutput", "Note Output", juce::StringArray { "Off", "MIDI", "MPE" }, 0));
+
+    return { params.begin(), params.end() };
+}
+
+PitchDetector::Settings PFixAudioProcessor::makeDetectorSettings (double sampleRate) const
+{
+    auto settings = pitchDetector.getSettings();
+
+    const int sizeIndex = juce::roundToInt (apvts.getRawParameterValue ("analysisSize")->load());
+    settings.analysisSize = sizeIndex == 0 ? PitchDetector::analysisSizeFor (sampleRate, kMinFrequencyHz)
+                                           : 512 << sizeIndex;
+    settings.engine    = static_cast<PitchDetector::DifferenceEngine> (
+                             juce::roundToInt (apvts.getRawParameterValue ("engine")->load()));
+    settings.threshold = apvts.getRawParameterValue ("threshold")->load();
+    return settings;
+}
+
+void PFixAudioProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+{
+    // Any thread.  The hop is an atomic the analysers read; the rest needs
+    // a new detector, built on the message thread
+    if (parameterID == "hop")
+        hopAnalyser.setHop (64 << juce::roundToInt (newValue));
+    else
+        triggerAsyncUpdate();
+}
+
+void PFixAudioProcessor::handleAsyncUpdate()
+{
+    const auto settings = makeDetectorSettings (currentSampleRate);
+
+    if (settings.analysisSize == detectorSettings.analysisSize
+         && settings.engine == detectorSettings.engine
+         && settings.threshold == detectorSettings.threshold)
+        return;
+
+    detectorSettings = settings;
+
+    // Each analyser gets its own, the lanes included, even if one is idle:
+    // a mode change rebuilds the lanes from detectorSettings anyway
+    hopAnalyser.offerConfiguration (std::make_unique<HopAnalyser::Configuration> (settings));
+
+    for (auto& lane : channelLanes)
+        lane->analyser.offerConfiguration (std::make_unique<HopAnalyser::Configuration> (settings));
+
+    startTimer (200);
+}
+
+void PFixAudioProcessor::timerCallback()
+{
+    // An analyser that isn't running takes nothing up; prepareToPlay()
+    // frees what it holds
+    bool done = hopAnalyser.reclaimConfigurations();
+
+    for (auto& lane : channelLanes)
+        done = lane->analyser.reclaimConfigurations() && done;
+
+    if (done)
+        stopTimer();
+}
+
+//==============================================================================
+const juce::String PFixAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool PFixAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PFixAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PFixAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double PFixAudioProcessor::getTailLengthSeconds() const
+{
+    return 0.0;
+}
+
+int PFixAudioProcessor::getNumPrograms()
+{
+    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                // so this should be at least 1, even if you're not really implementing programs.
+}
+
+int PFixAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void PFixAudioProcessor::setCurrentProgram (int index)
+{
+}
+
+const juce::String PFixAudioProcessor::getProgramName (int index)
+{
+    return {};
+}
+
+void PFixAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+}
+
+//==============================================================================
+void PFixAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    stopAnalysis();
+
+    // The trace rings are allocated here, not by the first traced block
+    // (nor by a host's scan, which never plays)
+    TraceRecorder::getInstance();
+
+    currentSampleRate     = sampleRate;
+    perfProbe.prepare (sampleRate);
+    perfProbe.reset();
+    qualityGovernor.prepare (sampleRate);
+    totalSamplesProcessed = 0;
+
+    // Both out of one pre-faulted block, so the first block after a
+    // prepare doesn't page them in on the audio thread
+    const int numInputChannels = juce::jmax (1, getTotalNumInputChannels());
+    monoScratchSize   = juce::jmax (samplesPerBlock, SampleChunk::kSize);
+    numMixdownWeights = numInputChannels;
+
+    dspArena.build ([this] (DspArena& arena)
+    {
+        monoScratch    = arena.allocate<float> (static_cast<size_t> (monoScratchSize));
+        mixdownWeights = arena.allocate<float> (static_cast<size_t> (numMixdownWeights));
+    });
+
+    // Equal-weight mono sum of every input channel
+    std::fill_n (mixdownWeights, numInputChannels, 1.0f / static_cast<float> (numInputChannels));
+
+    telemetryPublisher.setFormat (sampleRate, numInputChannels);
+
+    // The parameters' detector, allocated here rather than handed over
+    detectorSettings = makeDetectorSettings (sampleRate);
+    pitchDetector.applySettings (detectorSettings);
+
+    const int windowSize = detectorSettings.analysisSize;
+    hopAnalyser.prepare (sampleRate);
+
+    // Enough frames that a block's points, at the offline hop and with a
+    // block's worth of worker lag, still find theirs (a smaller hop set
+    // later only costs the oldest points their onsets)
+    const int minHop = juce::jmax (HopAnalyser::kMinHop, hopAnalyser.getHop() / offlineHopDivisor.load());
+    spectralFrames.prepare (windowSize, 2 * juce::jmax (samplesPerBlock, SampleChunk::kSize) / minHop + 2);
+    spectrogramFeed.prepare (sampleRate, windowSize);
+    multiPitchDetector.prepare (sampleRate, windowSize);
+
+    lastBlockSize.store (samplesPerBlock);
+    restartAnalysis();
+}
+
+void PFixAudioProcessor::releaseResources()
+{
+    stopAnalysis();
+}
+
+void PFixAudioProcessor::audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup)
+{
+    analysisClient.setWorkgroup (workgroup);
+}
+
+std::vector<PitchStream*> PFixAudioProcessor::getPitchStreams() noexcept
+{
+    std::vector<PitchStream*> streams;
+
+    for (auto& stream : pitchStreams)
+        streams.push_back (&stream);
+
+    return streams;
+}
+
+void PFixAudioProcessor::setAnalysisMode (AnalysisMode newMode)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (newMode == analysisMode)
+        return;
+
+    // suspendProcessing() waits for any running processBlock to finish, so
+    // the HopAnalyser never has two owners at once.
+    suspendProcessing (true);
+    analysisMode = newMode;
+    hopAnalyser.reset();
+    restartAnalysis();
+    suspendProcessing (false);
+}
+
+void PFixAudioProcessor::setChannelMode (ChannelMode newMode)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (newMode == channelMode)
+        return;
+
+    // Same reasoning as setAnalysisMode(): the lanes are rebuilt while no
+    // processBlock can be appending to their feeds.
+    suspendProcessing (true);
+    channelMode = newMode;
+    hopAnalyser.reset();
+    restartAnalysis();
+    suspendProcessing (false);
+}
+
+void PFixAudioProcessor::restartAnalysis()
+{
+    stopAnalysis();
+    channelSources.clear();
+    channelLanes.clear();
+    sampleFeed.reset();
+    notePoints.skipToNewest();   // incl. anything lanes pushed to pitchStreams[0]
+    spectralFrames.reset();
+    onsetDetector.reset();
+    pitchToMidi.reset();      // its held note ends at the next block
+    appliedHopDivisor = 0;   // the new lanes start undivided, and unmultiplied
+    hopAnalyser.setMultiPitchDetector (channelMode == ChannelMode::polyphonic ? &multiPitchDetector : nullptr);
+    hopAnalyser.setLoopCache (channelMode == ChannelMode::mono ? &loopCache : nullptr);
+    multiPitchDetector.reset();
+
+    if (channelMode != ChannelMode::perChannel)
+    {
+        if (analysisMode == AnalysisMode::backgroundThread)
+        {
+            analysisSource.reset();
+            analysisClient.addSource (analysisSource);
+        }
+
+        return;
+    }
+
+    // ── One lane per channel, dealt round-robin over the sources ────────────
+    // No more sources than the pool has threads.  Source w is the only
+    // producer for pitchStreams[w], so every stream stays single-producer.
+    const int numChannels = juce::jlimit (1, kMaxAnalysedChannels, getTotalNumInputChannels());
+    const int numWorkers  = juce::jmin (kMaxAnalysisWorkers, numChannels, analysisClient.getNumThreads());
+    const auto settings   = detectorSettings;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto lane = std::make_unique<ChannelLane> (pitchStreams[(size_t) (ch % numWorkers)], ch);
+        lane->detector.applySettings (settings);
+        lane->analyser.followHopOf (hopAnalyser);
+        lane->analyser.prepare (currentSampleRate);
+        channelLanes.push_back (std::move (lane));
+    }
+
+    for (int w = 0; w < numWorkers; ++w)
+    {
+        auto source = std::make_unique<PitchAnalysisSource>();
+
+        for (int ch = w; ch < numChannels; ch += numWorkers)
+            source->addLane (channelLanes[(size_t) ch]->analyser, channelLanes[(size_t) ch]->feed);
+
+        source->setPerfProbe (&perfProbe, yinScope);
+        analysisClient.addSource (*source);
+        channelSources.push_back (std::move (source));
+    }
+}
+
+void PFixAudioProcessor::stopAnalysis()
+{
+    // Waits for any slice still running, so no lane is in use once it returns
+    analysisClient.removeAllSources();
+}
+
+int PFixAudioProcessor::getNoteLatencySamples() const noexcept
+{
+    int latency = hopAnalyser.getAnalysisSize() / 2
+                + (PitchToMidi::kOnsetHops - 1) * hopAnalyser.getHop();
+
+    if (analysisMode == AnalysisMode::backgroundThread)
+        latency += lastBlockSize.load (std::memory_order_relaxed)
+                 + juce::roundToInt (currentSampleRate * AnalysisWorkerPool::kPollIntervalMs / 1000.0);
+
+    return latency;
+}
+
+void PFixAudioProcessor::updateHop (int qualityLevel) noexcept
+{
+    const int divisor    = isNonRealtime() ? offlineHopDivisor.load (std::memory_order_relaxed) : 1;
+    const int multiplier = 1 << qualityLevel;
+
+    if (divisor == appliedHopDivisor && multiplier == appliedHopMultiplier)
+        return;
+
+    hopAnalyser.setHopDivisor (divisor);
+    hopAnalyser.setHopMultiplier (multiplier);
+
+    for (auto& lane : channelLanes)
+    {
+        lane->analyser.setHopDivisor (divisor);
+        lane->analyser.setHopMultiplier (multiplier);
+    }
+
+    appliedHopDivisor    = divisor;
+    appliedHopMultiplier = multiplier;
+}
+
+void PFixAudioProcessor::setNoteOutput (PitchToMidi::Output output)
+{
+    auto* parameter = apvts.getParameter ("noteOutput");
+    parameter->setValueNotifyingHost (parameter->convertTo0to1 ((float) output));
+}
+
+PitchToMidi::Output PFixAudioProcessor::getNoteOutput() const noexcept
+{
+    return static_cast<PitchToMidi::Output> (juce::roundToInt (noteOutput->load()));
+}
+
+void PFixAudioProcessor::updateIdle() noexcept
+{
+    // The audio passes through untouched, so with nobody following the
+    // points, and no notes asked for, the analysis is all waste
+    const bool notes = channelMode == ChannelMode::mono && pitchToMidi.getOutput() != PitchToMidi::Output::off;
+    const bool idle  = ! (notes || pitchSubscribers.hasSubscribers());
+
+    hopAnalyser.setIdle (idle);
+
+    for (auto& lane : channelLanes)
+        lane->analyser.setIdle (idle);
+
+    // A slice late for the notes is a note late (see getNoteLatencySamples());
+    // the display can wait, so the pool stays out of the workgroup for it
+    analysisClient.setJoinsWorkgroup (notes && analysisMode == AnalysisMode::backgroundThread);
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool PFixAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // Any channel count is analysed (mono, stereo, 5.1, mic arrays…): the
+    // mixdown weights are sized in prepareToPlay().  Audio passes through
+    // untouched, so the only requirement is a non-empty main bus.
+    if (layouts.getMainOutputChannelSet().isDisabled())
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void PFixAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    REALTIME_SAFETY_AUDIO_THREAD ("PFix processBlock");
+    TRACE_SCOPE ("PFix processBlock");
+    juce::ScopedNoDenormals noDenormals;
+
+    const int numInputChannels  = getTotalNumInputChannels();
+    const int numOutputChannels = getTotalNumOutputChannels();
+    const int numSamples        = buffer.getNumSamples();
+
+    const PerfProbe::Scope blockTimer (perfProbe, blockScope, numSamples);
+
+    // Nothing comes in on the MIDI input; what goes out is ours alone
+    midiMessages.clear();
+    pitchToMidi.setOutput (getNoteOutput());
+    pitchToMidi.beginBlock (midiMessages);
+    lastBlockSize.store (numSamples, std::memory_order_relaxed);
+
+    // Bounces get a denser pitch curve; live playing keeps the set hop,
+    // lengthened while the last blocks ran close to their deadline
+    updateHop (isNonRealtime() ? 0 : qualityGovernor.update (perfProbe, blockScope, numSamples));
+    updateIdle();
+
+    // Clear any output-only channels (prevents garbage on extra outputs)
+    for (int ch = numInputChannels; ch < numOutputChannels; ++ch)
+        buffer.clear (ch, 0, numSamples);
+
+    // Nothing to analyse without input
+    if (numInputChannels == 0)
+    {
+        pitchToMidi.addPoint (0.0f, false, midiMessages, 0);
+        totalSamplesProcessed += numSamples;
+        return;
+    }
+
+    // ── Per-channel: each input straight into its own lane's feed ───────────
+    if (channelMode == ChannelMode::perChannel)
+    {
+        const int numLanes = juce::jmin (numInputChannels, static_cast<int> (channelLanes.size()));
+
+        for (int ch = 0; ch < numLanes; ++ch)
+            channelLanes[(size_t) ch]->feed.append (buffer.getReadPointer (ch), numSamples,
+                                                    totalSamplesProcessed);
+
+        totalSamplesProcessed += numSamples;
+        return;
+    }
+
+    // ── Mix down to mono and hand it to the analyser ─────────────────────────
+    // Weighted sum of all inputs, one vector op per channel and span.  Inline,
+    // the HopAnalyser runs YIN here whenever a hop completes; in the
+    // background mode this block only copies samples into the feed.
+    const int  numMixChannels = juce::jmin (numInputChannels, numMixdownWeights);
+    const int  maxChunk       = monoScratchSize;
+    const bool background     = analysisMode == AnalysisMode::backgroundThread;
+    const auto& kernels       = VectorKernels::get();
+
+    // Where the block plays on the host's timeline while its transport
+    // runs, which lets a loop's repeats come from the loop cache
+    long long timelineSample = -1;
+
+    if (auto* playHead = getPlayHead())
+        if (const auto position = playHead->getPosition(); position.hasValue() && position->getIsPlaying())
+            if (const auto timeInSamples = position->getTimeInSamples(); timeInSamples.hasValue())
+                timelineSample = *timeInSamples;
+
+    for (int pos = 0; pos < numSamples; pos += maxChunk)
+    {
+        const int n = juce::jmin (maxChunk, numSamples - pos);
+        float* mono = monoScratch;
+
+        kernels.copyScaled (mono, buffer.getReadPointer (0, pos), mixdownWeights[0], n);
+
+        for (int ch = 1; ch < numMixChannels; ++ch)
+            kernels.multiplyAdd (mono, buffer.getReadPointer (ch, pos), mixdownWeights[ch], n);
+
+        const auto timeline = timelineSample >= 0 ? timelineSample + pos : -1;
+
+        if (background)
+        {
+            sampleFeed.append (mono, n, totalSamplesProcessed + pos, timeline);
+        }
+        else
+        {
+            const PerfProbe::Scope yinTimer (perfProbe, yinScope, n);
+            TRACE_SCOPE ("yin");
+            hopAnalyser.process (mono, n, totalSamplesProcessed + pos, timeline);
+        }
+    }
+
+    // ── Points → notes ───────────────────────────────────────────────────────
+    // Inline, this block's own points, each at the sample it was analysed
+    // at; from the worker, points of earlier blocks, all at the start.  The
+    // hop's frame shares the point's end sample.  Polyphonic points are a
+    // set per hop, with no one note to follow: only the frame goes on.
+    const bool polyphonic = channelMode == ChannelMode::polyphonic;
+
+    notePoints.readAll ([this, &midiMessages, numSamples, polyphonic] (const PitchPoint* points, int num)
+    {
+        for (int i = 0; i < num; ++i)
+        {
+            if (polyphonic && points[i].channel != 0)
+                continue;
+
+            const auto endSample = (long long) std::llround (points[i].timestamp * currentSampleRate);
+            const auto frame     = spectralFrames.findFrameEndingAt (endSample);
+
+            if (! polyphonic)
+            {
+                const bool onset  = frame >= 0 && onsetDetector.isOnset (spectralFrames, frame);
+                const auto offset = (int) juce::jlimit (0LL, (long long) numSamples - 1, endSample - totalSamplesProcessed);
+
+                pitchToMidi.addPoint (points[i].pitchHz, onset, midiMessages, offset);
+            }
+
+            if (frame >= 0)
+                spectrogramFeed.addFrame (spectralFrames, frame, points[i].timestamp);
+        }
+    });
+
+    totalSamplesProcessed += numSamples;
+}
+
+//==============================================================================
+bool PFixAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* PFixAudioProcessor::createEditor()
+{
+    return new PFixAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void PFixAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // The pitch history goes in as one compact blob (see PitchHistory), so a
+    // reopened session shows its curves without being played again.
+    juce::ValueTree state ("PFixState");
+    state.setProperty ("pitchHistory", pitchHistory.toBinary(), nullptr);
+    state.appendChild (apvts.copyState(), nullptr);
+
+    juce::MemoryOutputStream out (destData, false);
+    state.writeToStream (out);
+}
+
+void PFixAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    const auto state = juce::ValueTree::readFromData (data, static_cast<size_t> (sizeInBytes));
+
+    if (! state.hasType ("PFixState"))
+        return;
+
+    // Sessions from before the parameters keep their defaults
+    const auto parameters = state.getChildWithName (apvts.state.getType());
+
+    if (parameters.isValid())
+        apvts.replaceState (parameters.createCopy());
+
+    if (const auto* history = state.getProperty ("pitchHistory").getBinaryData())
+        pitchHistory.restoreFromBinary (history->getData(), history->getSize());
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new PFixAudioProcessor();
+}
@@ -1,77 +1,346 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PitchDetector.h"
-#include "PitchDataQueue.h"
-#include <vector>
-
-//==============================================================================
-/**
-*/
-class PFixAudioProcessor  : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    PFixAudioProcessor();
-    ~PFixAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-
-    //==============================================================================
-    /** Safe to call from any thread — returns reference to the lock-free queue
-        that the audio thread writes to and the UI thread reads from. */
-    PitchDataQueue& getPitchQueue() noexcept { return pitchQueue; }
-
-private:
-    //==============================================================================
-    // ── Pitch analysis (all accessed only on the audio thread) ───────────────
-    static constexpr int kAnalysisSize = 2048;  // ~46 ms at 44100 Hz
-
-    PitchDetector      pitchDetector  { kAnalysisSize };
-    PitchDataQueue     pitchQueue;
-    std::vector<float> analysisBuffer;           // accumulated mono samples
-    int                analysisBufferFill  { 0 };
-    double             currentSampleRate   { 44100.0 };
-    long long          totalSamplesProcessed { 0 };
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PFixAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchDetector.h"
+#include "PitchDataQueue.h"
+#include "PitchAnalyser.h"
+#include "LoopAnalysisCache.h"
+#include "SampleFeed.h"
+#include "PitchHistory.h"
+#include "PitchSessionRecorder.h"
+#include "PitchTelemetryPublisher.h"
+#include "PitchToMidi.h"
+#include "SpectrogramFeed.h"
+#include "../../Shared/DspArena.h"
+#include "../../Shared/AnalysisWorkerPool.h"
+#include "../../Shared/PerfProbe.h"
+#include "../../Shared/QualityGovernor.h"
+#include "../../Shared/RealtimeSafety.h"
+#include "../../Shared/TraceEvents.h"
+#include "../../Shared/VectorKernels.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+/**
+*/
+class PFixAudioProcessor  : public juce::AudioProcessor,
+                            private juce::AudioProcessorValueTreeState::Listener,
+                            private juce::AsyncUpdater,
+                            private juce::Timer
+{
+public:
+    //==============================================================================
+    PFixAudioProcessor();
+    ~PFixAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+    /** Hands the host's workgroup on to the analysis pool, whose threads
+        join it for this instance's slices while the notes wait on them
+        (see updateIdle()). */
+    void audioWorkgroupContextChanged (const juce::AudioWorkgroup& workgroup) override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    /** The analysis settings a host can automate:
+          "analysisSize"  Auto (the smallest reaching kMinFrequencyHz) or a
+                          fixed window, for latency against low-note accuracy
+          "hop"           samples between windows (see setAnalysisHop())
+          "engine"        the detector's DifferenceEngine
+          "threshold"     YIN's confidence threshold
+          "noteOutput"    Off, MIDI or MPE (see setNoteOutput())
+        Any of them can change while playing.  A new detector is built and
+        allocated on the message thread and taken up by whichever thread
+        runs the analysis at its next block (see
+        HopAnalyser::offerConfiguration()), so nothing allocates there and
+        the curve carries on without a restart.  The STFT frames keep the
+        size prepareToPlay() gave them: at another window size ChannelMode::
+        polyphonic falls back to YIN and no onsets or spectrogram columns
+        are made until the next prepare. */
+    juce::AudioProcessorValueTreeState apvts;
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    //==============================================================================
+    /** Safe to call from any thread — returns reference to the lock-free
+        stream that the analysis side writes to.  Any thread can follow it
+        through a PitchStream::Reader of its own, without costing the
+        producer anything. */
+    PitchStream& getPitchStream() noexcept { return pitchStreams[0]; }
+
+    /** Every stream the analysis can write to.  The mono path only uses the
+        first; in ChannelMode::perChannel each worker has its own (a stream
+        has one producer), and the points carry their channel index.  The
+        set never changes, so a consumer can hold on to the pointers. */
+    std::vector<PitchStream*> getPitchStreams() noexcept;
+
+    /** The streams' display consumer: recent points per channel, kept
+        whether or not the editor is open, and saved with the plugin state.
+        Only points made while something subscribes get here (see
+        getPitchSubscribers()).  Message thread (see PitchHistory for what
+        is safe elsewhere). */
+    PitchHistory& getPitchHistory() noexcept { return pitchHistory; }
+
+    /** Who wants the points now.  The editor holds a subscription while
+        it's open, and the recorder and the telemetry publisher while they
+        run; note output counts as one of its own.  With none, the analysis
+        goes idle: the analysers only keep their windows filled, so an
+        editor that opens later has a point within a hop.  Any thread. */
+    PitchSubscribers& getPitchSubscribers() noexcept { return pitchSubscribers; }
+
+    /** Optional whole-session log of every point to a file (message thread). */
+    PitchSessionRecorder& getSessionRecorder() noexcept { return sessionRecorder; }
+
+    /** Optional live feed of the points and CPU load to other processes,
+        through shared memory (message thread; see PitchTelemetryPublisher). */
+    PitchTelemetryPublisher& getTelemetryPublisher() noexcept { return telemetryPublisher; }
+
+    /** Samples between successive (overlapping) analysis windows, e.g. 128,
+        256 or 512.  Clamped to [HopAnalyser::kMinHop, window size].  Safe to
+        call from any thread; takes effect at the next window boundary.  The
+        hop is rescaled with the window when the sample rate changes.  The
+        "hop" parameter sets it too. */
+    void setAnalysisHop (int hopSamples) noexcept { hopAnalyser.setHop (hopSamples); }
+    int  getAnalysisHop () const noexcept         { return hopAnalyser.getHop(); }
+
+    /** While the host renders offline (isNonRealtime()) the hop is divided
+        by this, for a denser curve in bounces at no cost to live use; 1
+        keeps the live hop.  Nothing is reallocated when a render starts or
+        ends.  Safe to call from any thread; takes effect at the next block. */
+    void setOfflineHopDivisor (int divisor) noexcept { offlineHopDivisor.store (juce::jlimit (1, 16, divisor)); }
+    int  getOfflineHopDivisor () const noexcept      { return offlineHopDivisor.load(); }
+
+    /** Where YIN runs.  On the audio thread a block that completes a window
+        pays the whole detector cost; in the background the audio thread only
+        copies samples into a lock-free feed and a thread of the process-wide
+        AnalysisWorkerPool, shared with every other instance, does the
+        analysis. */
+    enum class AnalysisMode { audioThread, backgroundThread };
+
+    /** Message thread only.  Briefly suspends processing while the analysis
+        joins or leaves the pool, and restarts the pitch history. */
+    void         setAnalysisMode (AnalysisMode newMode);
+    AnalysisMode getAnalysisMode () const noexcept { return analysisMode; }
+
+    /** What gets analysed.  mono: one detector on the weighted mix of every
+        input.  perChannel: one detector per input channel (the first
+        kMaxAnalysedChannels), always on the pool whatever the AnalysisMode,
+        with the channels dealt round-robin to up to kMaxAnalysisWorkers
+        sources the pool can run at once.  The channel detectors copy the main
+        detector's settings when the mode or the sample rate changes.
+        polyphonic: the mono mix, but every pitch sounding in it (a chord, a
+        piano's two hands) from each hop's STFT frame rather than YIN, with
+        each point's channel the MultiPitchDetector slot it was tracked in,
+        and the same AnalysisMode as mono. */
+    enum class ChannelMode { mono, perChannel, polyphonic };
+
+    static constexpr int kMaxAnalysedChannels = 16;
+    static constexpr int kMaxAnalysisWorkers  = 4;
+
+    /** Message thread only; same rules as setAnalysisMode(). */
+    void        setChannelMode (ChannelMode newMode);
+    ChannelMode getChannelMode () const noexcept { return channelMode; }
+
+    /** How many pitches a hop may yield in ChannelMode::polyphonic, up to
+        MultiPitchDetector::kMaxPitches.  Safe to call from any thread. */
+    void setMaxPolyphony (int numPitches) noexcept { multiPitchDetector.setMaxPitches (numPitches); }
+    int  getMaxPolyphony () const noexcept         { return multiPitchDetector.getMaxPitches(); }
+
+    /** What processBlock() writes into its MidiBuffer: notes followed from
+        the mono analysis (see PitchToMidi), optionally as MPE with the
+        pitch as bends, or nothing.  ChannelMode::perChannel and
+        ChannelMode::polyphonic make no notes.
+        The "noteOutput" parameter, so it is automatable and saved with the
+        state; setting it is the same as the host doing so, on the message
+        thread.  Takes effect at the next block, which ends a held note
+        first. */
+    void                setNoteOutput (PitchToMidi::Output output);
+    PitchToMidi::Output getNoteOutput () const noexcept;
+
+    /** About how late a note starts after the sung onset, in samples: the
+        half window the pitch describes, the hops that confirm the onset and,
+        in the background mode, a block plus a worker's poll for the points
+        to come back.  Not reported with setLatencySamples(), since the audio
+        passes through undelayed and a live input can't be compensated; a
+        host or user lining up recorded notes can shift them back by it.
+        Safe to call from any thread. */
+    int getNoteLatencySamples() const noexcept;
+
+    /** The mono analysis' STFT, one frame per hop, for anything spectral
+        (see SpectralFrames for reading it from other threads).  Frames are
+        made in ChannelMode::mono and ChannelMode::polyphonic. */
+    const SpectralFrames& getSpectralFrames() const noexcept { return spectralFrames; }
+
+    /** Those frames as spectrogram columns for the editor, made only while
+        it has the feed enabled.  The queue has one consumer. */
+    SpectrogramFeed& getSpectrogramFeed() noexcept { return spectrogramFeed; }
+
+    /** CPU load of this instance: "block" is the whole processBlock(), "yin"
+        is the analysis, on whichever thread runs it.  Safe to read from any
+        thread. */
+    const PerfProbe& getPerfProbe() const noexcept { return perfProbe; }
+
+    /** What the mono analysis' detector counted since it was made: frames
+        gated, lags searched, tracking fallbacks and interpolation failures,
+        to see which of its options pay off on this material (diff two
+        snapshots for a rate).  Safe to read from any thread. */
+    const PitchDetectorCore::Counters& getDetectorCounters() const noexcept { return hopAnalyser.getDetectorCounters(); }
+
+    /** The mono analysis' pitches by where they fall on the host's
+        timeline, so a looped section is analysed once (see
+        LoopAnalysisCache); its lookups and hits are safe to read from any
+        thread.  Used in ChannelMode::mono while the transport runs. */
+    const LoopAnalysisCache& getLoopCache() const noexcept { return loopCache; }
+
+    /** Lengthens the hop of live blocks (×2, then ×4) while processBlock()
+        runs close to its deadline, and logs each change.  On by default;
+        bounces are never governed. */
+    QualityGovernor& getQualityGovernor() noexcept { return qualityGovernor; }
+
+private:
+    //==============================================================================
+    // ── Pitch analysis ───────────────────────────────────────────────────────
+    // The window is sized in prepareToPlay() so its lag range always reaches
+    // kMinFrequencyHz: 2048 at 44.1/48 kHz (~46 ms), 4096 at 96 kHz, ...
+    static constexpr float kMinFrequencyHz = 50.0f;
+
+    PitchDetector       pitchDetector;
+    PitchDetector::Settings detectorSettings;   // message thread: what the analysers run, or will
+    LoopAnalysisCache   loopCache;                                         // hopAnalyser's, in ChannelMode::mono
+    std::array<PitchStream, kMaxAnalysisWorkers> pitchStreams;         // [0] also serves the mono path
+    PitchSubscribers    pitchSubscribers;                                  // before every consumer that joins it
+    HopAnalyser         hopAnalyser    { pitchDetector, pitchStreams[0] }; // owned by whoever runs YIN
+    SampleFeed          sampleFeed;                                        // audio → worker
+    PitchHistory        pitchHistory   { getPitchStreams() };              // streams → message thread
+    PitchSessionRecorder sessionRecorder { pitchHistory, pitchSubscribers }; // message thread → disk
+    PitchAnalysisSource analysisSource { hopAnalyser, sampleFeed };     // in the pool in the background mode
+    MultiPitchDetector  multiPitchDetector;                                // hopAnalyser's, in ChannelMode::polyphonic
+
+    // ── Notes ────────────────────────────────────────────────────────────────
+    // processBlock() follows hopAnalyser's points, on the same stream the
+    // history reads, and hands them to pitchToMidi, each with its hop's
+    // onset, and the hop's frame (hopAnalyser fills spectralFrames from
+    // whichever thread runs it) to spectrogramFeed; in the polyphonic mode
+    // only the frames go on, once a hop (slot 0 always reports).  Lossless
+    // in practice: the audio thread catches up every block, far inside the
+    // capacity.
+    PitchStream::Reader   notePoints            { pitchStreams[0] };
+    SpectralFrames        spectralFrames;
+    SpectralOnsetDetector onsetDetector;                 // audio thread
+    SpectrogramFeed       spectrogramFeed;               // audio thread → editor
+    PitchToMidi           pitchToMidi;
+    std::atomic<float>*   noteOutput            { apvts.getRawParameterValue ("noteOutput") };   // a PitchToMidi::Output
+    std::atomic<int>    lastBlockSize         { 0 };
+
+    // ── Per-channel analysis ─────────────────────────────────────────────────
+    // Built by restartAnalysis() in ChannelMode::perChannel, empty otherwise.
+    struct ChannelLane
+    {
+        ChannelLane (PitchStream& stream, int channel) : analyser (detector, stream, channel) {}
+
+        PitchDetector detector;
+        HopAnalyser   analyser;   // follows hopAnalyser's hop
+        SampleFeed    feed;       // audio → the lane's worker
+    };
+
+    std::vector<std::unique_ptr<ChannelLane>>         channelLanes;     // index = input channel
+    std::vector<std::unique_ptr<PitchAnalysisSource>> channelSources;   // each the one producer for its stream
+
+    // After every source it runs, so they're out of the pool before they go
+    AnalysisWorkerPool::Client analysisClient { "PFix analysis" };
+
+    PerfProbe           perfProbe;
+    const int           blockScope            { perfProbe.addScope ("block") };
+    const int           yinScope              { perfProbe.addScope ("yin") };
+    QualityGovernor     qualityGovernor       { "PFix", 3 };   // level n multiplies the hop by 2^n
+
+   #if REALTIME_SAFETY_CHECKS
+    RealtimeSafety::ViolationReporter realtimeSafetyReporter;
+   #endif
+
+    PitchTelemetryPublisher telemetryPublisher { getPitchStreams(), perfProbe,     // streams → shared memory
+                                                 hopAnalyser.getDetectorCounters(), pitchSubscribers };
+
+    AnalysisMode        analysisMode          { AnalysisMode::audioThread };
+    ChannelMode         channelMode           { ChannelMode::mono };
+    DspArena            dspArena;                    // monoScratch and mixdownWeights, built in prepareToPlay
+    float*              monoScratch           { nullptr };   // audio thread: this block's mono mix
+    int                 monoScratchSize       { 0 };
+    float*              mixdownWeights        { nullptr };   // per input channel
+    int                 numMixdownWeights     { 0 };
+    double              currentSampleRate     { 44100.0 };
+    long long           totalSamplesProcessed { 0 };
+    std::atomic<int>    offlineHopDivisor     { 4 };   // 256 → 64 samples
+    int                 appliedHopDivisor     { 0 };   // audio thread; 0 = apply at the next block
+    int                 appliedHopMultiplier  { 1 };   // audio thread
+
+    /** Takes every source out of the pool, rebuilds the per-channel lanes if
+        the channel mode needs them, and adds whichever sources the modes
+        need.  Processing must be stopped or suspended.  Not realtime-safe. */
+    void restartAnalysis();
+    void stopAnalysis();
+
+    /** Gives every analyser the hop divisor for the current render mode,
+        and the multiplier for qualityLevel, if either changed.  Audio
+        thread; realtime-safe. */
+    void updateHop (int qualityLevel) noexcept;
+
+    /** Idles every analyser while nothing wants the points (no subscriber
+        and no note output), and wakes them when something does; has the
+        pool's threads join the host's workgroup while the notes come from
+        them.  Audio thread; realtime-safe. */
+    void updateIdle() noexcept;
+
+    /** The constructor's detector options with the parameters' size, engine
+        and threshold, the size for sampleRate when it's Auto. */
+    PitchDetector::Settings makeDetectorSettings (double sampleRate) const;
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+
+    /** Builds a Configuration for every analyser when the detector
+        parameters have changed. */
+    void handleAsyncUpdate() override;
+
+    /** Frees the configurations the analysers have replaced. */
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PFixAudioProcessor)
+};
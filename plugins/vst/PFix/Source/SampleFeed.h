@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+    SampleFeed.h  –  Lock-free SPSC feed of mono samples
+
+    Carries one mono signal (the mix, or a single input channel) from the
+    audio thread (producer) to a background analysis thread (consumer) in
+    fixed-size chunks.  Every chunk is stamped
+    with the absolute index of its first sample, so the consumer produces
+    sample-accurate timestamps and sees any dropped chunk as a gap, with
+    where that sample plays on the host's timeline, if it's known, and
+    with when it was sent, so a worker pool can serve the oldest first.
+
+    It is built on the shared LockFreeRing (one consumer): no locks,
+    no heap allocation after construction.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "../../Shared/LockFreeRing.h"
+#include <array>
+
+/** A run of consecutive mono samples starting at an absolute sample index. */
+struct SampleChunk
+{
+    static constexpr int kSize = 256;
+
+    long long                 firstSample    { 0 };
+    long long                 timelineSample { -1 };   // firstSample's on the host's timeline, or -1
+    int                       numSamples     { 0 };
+    juce::int64               sentTicks   { 0 };   // high-resolution ticks
+    std::array<float, kSize>  samples     {};
+};
+
+/**
+ * Audio thread:  call append() with each block's mono samples.
+ * Worker thread: call pop() until it returns false.
+ *
+ * Capacity: 512 chunks ≈ 3 s at 44.1 kHz, so the worker can be descheduled
+ * for a long time before anything is lost.
+ */
+class SampleFeed
+{
+public:
+    static constexpr int kCapacity = 512;
+
+    SampleFeed() = default;
+
+    // ── Producer (audio thread) ───────────────────────────────────────────────
+
+    /** Appends samples that start at absolute index firstSample, and at
+        timelineSample on the host's timeline (-1 if it isn't playing).
+        Chunks are sent as they fill up; a chunk that doesn't fit is dropped
+        and counted. */
+    void append (const float* mono, int num, long long firstSample, long long timelineSample = -1) noexcept
+    {
+        const bool followsOn = staging.firstSample + staging.numSamples == firstSample
+                            && (timelineSample < 0 ? staging.timelineSample < 0
+                                                   : staging.timelineSample >= 0
+                                                      && staging.timelineSample + staging.numSamples == timelineSample);
+
+        if (staging.numSamples > 0 && ! followsOn)
+            flush();   // discontinuity (e.g. transport jump): don't glue the runs together
+
+        int pos = 0;
+        while (pos < num)
+        {
+            if (staging.numSamples == 0)
+            {
+                staging.firstSample    = firstSample + pos;
+                staging.timelineSample = timelineSample >= 0 ? timelineSample + pos : -1;
+            }
+
+            const int n = juce::jmin (num - pos, SampleChunk::kSize - staging.numSamples);
+            juce::FloatVectorOperations::copy (staging.samples.data() + staging.numSamples,
+                                               mono + pos, n);
+            staging.numSamples += n;
+            pos += n;
+
+            if (staging.numSamples == SampleChunk::kSize)
+                flush();
+        }
+    }
+
+    /** Sends the partially filled staging chunk, if any. */
+    void flush() noexcept
+    {
+        if (staging.numSamples == 0)
+            return;
+
+        staging.sentTicks = juce::Time::getHighResolutionTicks();
+        ring.push (staging);   // counted in the ring's stats if dropped
+        staging.numSamples = 0;
+    }
+
+    // ── Consumer (worker thread) ──────────────────────────────────────────────
+
+    /** Dequeues the oldest chunk.  Returns false when the feed is empty. */
+    bool pop (SampleChunk& out) noexcept { return ring.pop (out); }
+
+    int getNumDroppedChunks() const noexcept { return static_cast<int> (ring.getStats().dropped); }
+
+    /** Not thread-safe: only call while neither side is running. */
+    void reset() noexcept
+    {
+        ring.reset();
+        staging.numSamples = 0;
+    }
+
+private:
+    LockFreeRing<SampleChunk, kCapacity> ring;
+    SampleChunk                          staging;   // producer-only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleFeed)
+};
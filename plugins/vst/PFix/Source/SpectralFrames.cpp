@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+    SpectralFrames.cpp  –  SpectralFrames / SpectralOnsetDetector implementation
+  ==============================================================================
+*/
+
+#include "SpectralFrames.h"
+#include <cmath>
+
+void SpectralFrames::prepare (int newFrameSize, int numFrames)
+{
+    jassert (juce::isPowerOfTwo (newFrameSize));
+
+    frameSize = newFrameSize;
+    numBins   = newFrameSize / 2 + 1;
+    numSlots  = juce::jlimit (kMinFrames, kMaxFrames, juce::nextPowerOfTwo (numFrames));
+    indexMask = numSlots - 1;
+
+    fft = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 (newFrameSize)));
+
+    // Periodic Hann, so overlapping hops sum to a constant
+    hannWindow.resize ((size_t) frameSize);
+    for (int i = 0; i < frameSize; ++i)
+        hannWindow[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) frameSize);
+
+    slots = std::make_unique<Slot[]> ((size_t) numSlots);
+
+    for (int i = 0; i < numSlots; ++i)
+    {
+        slots[(size_t) i].spectrum     .assign ((size_t) (2 * frameSize), 0.0f);
+        slots[(size_t) i].logMagnitudes.assign ((size_t) numBins, 0.0f);
+    }
+
+    reset();
+}
+
+void SpectralFrames::reset() noexcept
+{
+    for (int i = 0; i < numSlots; ++i)
+        slots[(size_t) i].sequence.store (0);
+
+    nextIndex = 0;
+    latestIndex.store (-1);
+}
+
+void SpectralFrames::addFrame (const float* window, long long endSample) noexcept
+{
+    if (numSlots == 0)
+        return;
+
+    const auto index = nextIndex++;
+    auto&      slot  = slots[(size_t) (index & indexMask)];
+
+    // Odd while writing, so a reader either sees the whole frame or knows
+    slot.sequence.store ((juce::uint64) index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    float* spectrum = slot.spectrum.data();
+    juce::FloatVectorOperations::multiply (spectrum, window, hannWindow.data(), frameSize);
+    fft->performRealOnlyForwardTransform (spectrum, true);
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const float re = spectrum[2 * k], im = spectrum[2 * k + 1];
+        slot.logMagnitudes[(size_t) k] = std::log1p (kCompression * std::sqrt (re * re + im * im)
+                                                     / (float) frameSize);
+    }
+
+    slot.endSample = endSample;
+    slot.sequence.store ((juce::uint64) index * 2 + 2, std::memory_order_release);
+    latestIndex.store (index, std::memory_order_release);
+}
+
+long long SpectralFrames::findFrameEndingAt (long long endSample) const noexcept
+{
+    const auto latest = getLatestIndex();
+
+    for (auto index = latest; index >= 0 && index > latest - numSlots; --index)
+    {
+        long long frameEnd = -1;
+
+        if (! read (index, [&frameEnd] (const Frame& frame) { frameEnd = frame.endSample; }))
+            return -1;   // the ring has moved past us
+
+        if (frameEnd <= endSample)
+            return index;
+    }
+
+    return -1;
+}
+
+//==============================================================================
+void SpectralOnsetDetector::reset() noexcept
+{
+    meanFlux       = 0.0f;
+    lastFrame      = -1;
+    lastOnsetFrame = -1;
+}
+
+bool SpectralOnsetDetector::isOnset (const SpectralFrames& frames, long long frameIndex) noexcept
+{
+    if (frameIndex <= lastFrame)
+        return false;   // already judged
+
+    float flux     = 0.0f;
+    bool  complete = false;
+
+    const bool current = frames.read (frameIndex, [&] (const SpectralFrames::Frame& now)
+    {
+        complete = frames.read (frameIndex - 1, [&] (const SpectralFrames::Frame& before)
+        {
+            for (int k = 0; k < now.numBins; ++k)
+                flux += juce::jmax (0.0f, now.logMagnitudes[k] - before.logMagnitudes[k]);
+        });
+    });
+
+    lastFrame = frameIndex;
+
+    if (! current || ! complete)
+        return false;
+
+    flux /= (float) frames.getFrameSize() / 2 + 1;
+
+    const bool onset = flux > kMinFlux && flux > kThresholdRatio * meanFlux
+                    && (lastOnsetFrame < 0 || frameIndex - lastOnsetFrame > kRefractoryHops);
+
+    meanFlux += kMeanSmoothing * (flux - meanFlux);
+
+    if (onset)
+        lastOnsetFrame = frameIndex;
+
+    return onset;
+}
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+    SpectralFrames.h  –  One STFT per analysis hop, shared by every consumer
+
+    The HopAnalyser hands each window it analyses to addFrame(), which
+    Hann-windows and transforms it once into the next slot of a
+    preallocated ring.  Anything spectral (the onset detector behind
+    PitchToMidi today; a spectrogram or polyphonic analysis later) reads
+    the slots in place, so a new feature costs its own arithmetic and not
+    another FFT.  The pitch detectors keep their own transforms: YIN's and
+    McLeod's correlations need the raw, zero-padded window, which a
+    windowed STFT can't give back.
+
+    One producer (whichever thread runs the HopAnalyser), any number of
+    readers on any threads, no locks: every slot carries a sequence number
+    that's odd while it's being written (a seqlock).  read() checks it
+    before and after the reader's callback, and returns false if the frame
+    was overwritten meanwhile, in which case whatever the callback computed
+    must be thrown away.  The ring is sized in prepare() so a reader a few
+    blocks behind still finds its frames.
+
+    SpectralOnsetDetector is the first consumer: half-wave rectified
+    spectral flux between consecutive frames, against its own running mean.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class SpectralFrames
+{
+public:
+    static constexpr int   kMinFrames   = 16;
+    static constexpr int   kMaxFrames   = 256;
+    static constexpr float kCompression = 100.0f;   // log1p (kCompression · |X|): roughly a dB scale
+
+    /** One slot, as a reader sees it inside read(). */
+    struct Frame
+    {
+        long long    endSample;       ///< Absolute index of the window's last sample + 1
+        int          numBins;         ///< frameSize / 2 + 1, DC to Nyquist
+        const float* spectrum;        ///< Interleaved re, im per bin of the Hann-windowed window
+        const float* logMagnitudes;   ///< log1p (kCompression · |X[k]|) per bin
+    };
+
+    /** Allocates numFrames slots (rounded up to a power of two, clamped to
+        [kMinFrames, kMaxFrames]) for windows of frameSize, a power of two.
+        Not realtime-safe; neither side may be running. */
+    void prepare (int frameSize, int numFrames);
+
+    /** Forgets every frame.  Neither side may be running. */
+    void reset() noexcept;
+
+    int getFrameSize() const noexcept { return frameSize; }
+    int getNumFrames() const noexcept { return numSlots; }
+
+    // ── Producer ──────────────────────────────────────────────────────────────
+
+    /** Transforms frameSize samples ending just before endSample into the
+        next slot.  Realtime-safe. */
+    void addFrame (const float* window, long long endSample) noexcept;
+
+    // ── Readers (any thread) ──────────────────────────────────────────────────
+
+    /** Index of the newest complete frame, or -1 before the first. */
+    long long getLatestIndex() const noexcept { return latestIndex.load (std::memory_order_acquire); }
+
+    /** Calls visit (const Frame&) with frame frameIndex, in place.  False
+        (and the callback's results void) if that frame isn't in the ring:
+        not written yet, already overwritten, or overwritten during visit. */
+    template <typename Visitor>
+    bool read (long long frameIndex, Visitor&& visit) const noexcept
+    {
+        if (frameIndex < 0 || numSlots == 0)
+            return false;
+
+        const auto& slot     = slots[(size_t) (frameIndex & indexMask)];
+        const auto  expected = (juce::uint64) frameIndex * 2 + 2;
+
+        if (slot.sequence.load (std::memory_order_acquire) != expected)
+            return false;
+
+        const Frame frame { slot.endSample, numBins, slot.spectrum.data(), slot.logMagnitudes.data() };
+        visit (frame);
+
+        std::atomic_thread_fence (std::memory_order_acquire);
+        return slot.sequence.load (std::memory_order_relaxed) == expected;
+    }
+
+    /** The newest frame ending at or before endSample, within the ring, or
+        -1.  A pitch point and the frame of the same hop share endSample. */
+    long long findFrameEndingAt (long long endSample) const noexcept;
+
+private:
+    struct Slot
+    {
+        std::atomic<juce::uint64> sequence { 0 };   // 2i + 1 while frame i is written, 2i + 2 once done
+        long long                 endSample { 0 };
+        std::vector<float>        spectrum;         // 2 * frameSize: the FFT's in-place buffer
+        std::vector<float>        logMagnitudes;    // numBins
+    };
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float>              hannWindow;
+    std::unique_ptr<Slot[]>         slots;                    // atomics: not in a vector
+    int                             numSlots  { 0 };
+    long long                       indexMask { 0 };
+    int                             frameSize { 0 };
+    int                             numBins   { 0 };
+    long long                       nextIndex { 0 };          // producer only
+    std::atomic<long long>          latestIndex { -1 };
+};
+
+//==============================================================================
+/**
+ * Onsets from consecutive SpectralFrames: the mean rise in log magnitude
+ * across the bins (the half-wave rectified spectral flux), flagged when it
+ * exceeds kThresholdRatio times its running mean and kMinFlux.  Catches a
+ * re-attacked note at an unchanged pitch, which the pitch alone can't.
+ *
+ * Single-threaded; call with each frame once, in order.
+ */
+class SpectralOnsetDetector
+{
+public:
+    static constexpr float kThresholdRatio = 3.0f;
+    static constexpr float kMinFlux        = 0.002f;   // per bin: ~6x a steady tone's frame-to-frame jitter
+    static constexpr float kMeanSmoothing  = 0.05f;    // per frame: a ~20-frame memory
+    static constexpr int   kRefractoryHops = 4;        // no second onset within these frames
+
+    void reset() noexcept;
+
+    /** True if frame frameIndex starts an onset.  False, without counting
+        against the running mean, when it or its predecessor is missing
+        from the ring. */
+    bool isOnset (const SpectralFrames& frames, long long frameIndex) noexcept;
+
+private:
+    float     meanFlux         { 0.0f };
+    long long lastFrame        { -1 };
+    long long lastOnsetFrame   { -1 };
+};
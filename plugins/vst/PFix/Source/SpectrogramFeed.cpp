@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+    SpectrogramFeed.cpp  –  SpectrogramFeed implementation
+  ==============================================================================
+*/
+
+#include "SpectrogramFeed.h"
+#include <cmath>
+
+SpectrogramFeed::SpectrogramFeed()
+{
+    // A display drain: a stalled editor should resume on the newest columns
+    queue.setOverflowPolicy (Queue::OverflowPolicy::overwriteOldest);
+}
+
+void SpectrogramFeed::prepare (double sampleRate, int frameSize)
+{
+    frameBins   = frameSize / 2 + 1;
+    fullScaleDb = 20.0f * std::log10 ((float) frameSize / 4.0f);   // Hann: a sine's peak is W/4
+
+    const auto binOf = [sampleRate, frameSize] (double midiNote)
+    {
+        const double hz = 440.0 * std::pow (2.0, (midiNote - 69.0) / 12.0);
+        return hz * (double) frameSize / sampleRate;
+    };
+
+    rows.resize ((size_t) kNumRows);
+
+    for (int r = 0; r < kNumRows; ++r)
+    {
+        const double note   = kLowestNote + (double) r / kRowsPerSemitone;
+        const double bottom = binOf (note);
+        const double top    = binOf (note + 1.0 / kRowsPerSemitone);
+        const int    maxBin = frameBins - 2;   // leaves a neighbour either side for the parabola
+
+        auto& row  = rows[(size_t) r];
+        row.first  = juce::jlimit (1, maxBin, (int) std::ceil  (bottom));
+        row.last   = juce::jlimit (1, maxBin, (int) std::floor (top));
+        row.offset = 0.0f;
+
+        // No bin centre inside the row: read the parabola at its middle
+        if (row.last < row.first)
+        {
+            const double centre = binOf (note + 0.5 / kRowsPerSemitone);
+            row.first  = juce::jlimit (1, maxBin, juce::roundToInt (centre));
+            row.last   = row.first;
+            row.offset = (float) juce::jlimit (-0.5, 0.5, centre - (double) row.first);
+        }
+    }
+
+    binDb.assign ((size_t) (rows.back().last + 2), 0.0f);
+
+    queue.reset();
+}
+
+void SpectrogramFeed::addFrame (const SpectralFrames& frames, long long frameIndex, double timestamp) noexcept
+{
+    if (! isEnabled() || rows.empty())
+        return;
+
+    Column column;
+    column.timestamp = timestamp;
+
+    const bool intact = frames.read (frameIndex, [this, &column] (const SpectralFrames::Frame& frame)
+    {
+        if (frame.numBins != frameBins)   // prepared for another frame size
+            return;
+
+        const float* spectrum = frame.spectrum;
+
+        for (int k = rows.front().first - 1; k < (int) binDb.size(); ++k)
+        {
+            const float power = spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+            binDb[(size_t) k] = 10.0f * std::log10 (power + 1.0e-12f) - fullScaleDb;
+        }
+
+        for (int r = 0; r < kNumRows; ++r)
+        {
+            const auto& row = rows[(size_t) r];
+            float db;
+
+            if (row.first == row.last)
+            {
+                const float below = binDb[(size_t) row.first - 1];
+                const float at    = binDb[(size_t) row.first];
+                const float above = binDb[(size_t) row.first + 1];
+                const float d     = row.offset;
+
+                db = at + 0.5f * d * (above - below) + 0.5f * d * d * (above - 2.0f * at + below);
+            }
+            else
+            {
+                db = binDb[(size_t) row.first];
+                for (int k = row.first + 1; k <= row.last; ++k)
+                    db = juce::jmax (db, binDb[(size_t) k]);
+            }
+
+            column.levels[(size_t) r] = (juce::uint8) juce::jlimit (0, 255, (int) ((db + kRangeDb) * (255.0f / kRangeDb)));
+        }
+    });
+
+    if (intact)
+        queue.push (column);
+}
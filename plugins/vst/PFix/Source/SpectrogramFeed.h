@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+    SpectrogramFeed.h  –  SpectralFrames reduced to display columns
+
+    What the editor's spectrogram shows, made on the audio thread as each
+    hop's frame is looked up for the notes: one Column per frame, one byte
+    per row, the rows a quarter semitone each from kLowestNote to
+    kHighestNote (the pitch graph's C2 – C6).  The bins behind every row
+    are worked out once in prepare(): a row narrower than a bin (all of
+    them with the usual ~21 Hz bins) reads a parabola through the levels
+    of the three bins around its middle, which near a peak puts it at the
+    partial's real frequency, not at its bin's; a wider row takes the
+    loudest of its bins.  A column costs one logarithm per bin up to C6
+    and a few multiplies per row.
+
+    Columns go out through a lock-free ring that overwrites its oldest
+    entries, so an editor that stops draining costs nothing, and none are
+    made while nobody has asked for them (setEnabled()).
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "SpectralFrames.h"
+#include "../../Shared/LockFreeRing.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+class SpectrogramFeed
+{
+public:
+    static constexpr int   kLowestNote      = 36;   // C2, the bottom of the graph
+    static constexpr int   kHighestNote     = 84;   // C6, the top
+    static constexpr int   kRowsPerSemitone = 4;
+    static constexpr int   kNumRows         = (kHighestNote - kLowestNote) * kRowsPerSemitone;
+    static constexpr float kRangeDb         = 72.0f;   // level 0 … 255 spans this much below full scale
+
+    /** One frame: levels[0] is the bottom row. */
+    struct Column
+    {
+        double                                     timestamp { 0.0 };   ///< Same timeline as the frame's PitchPoint
+        std::array<juce::uint8, (size_t) kNumRows> levels {};
+    };
+
+    using Queue = LockFreeRing<Column, 512>;   // ~3 s at the default hop
+
+    SpectrogramFeed();
+
+    /** Maps the rows onto the bins of frames of frameSize at this sample
+        rate, and empties the queue.  Not realtime-safe; neither side may be
+        running. */
+    void prepare (double sampleRate, int frameSize);
+
+    /** While false, addFrame() returns at once.  Any thread. */
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled  () const noexcept               { return enabled.load (std::memory_order_relaxed); }
+
+    /** Reduces frame frameIndex of `frames` to a Column and queues it; a
+        frame overwritten meanwhile is skipped.  Realtime-safe; the thread
+        that calls it is the queue's only producer. */
+    void addFrame (const SpectralFrames& frames, long long frameIndex, double timestamp) noexcept;
+
+    /** The consumer side (one thread, the editor's). */
+    Queue& getQueue() noexcept { return queue; }
+
+private:
+    struct RowBins
+    {
+        int   first, last;   // loudest of bins [first, last], or ...
+        float offset;        // ... when first == last, the parabola around it at first + offset
+    };
+
+    std::vector<RowBins> rows;                    // kNumRows, bottom first
+    std::vector<float>   binDb;                   // producer scratch: level per bin, up to the top row's
+    int                  frameBins   { 0 };       // the frames the rows were worked out for
+    float                fullScaleDb { 0.0f };    // a full-scale sine's peak bin
+    std::atomic<bool>    enabled     { false };
+    Queue                queue;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramFeed)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+    WindowStats.cpp  –  RunningWindowStats implementation
+  ==============================================================================
+*/
+
+#include "WindowStats.h"
+#include <cmath>
+
+void RunningWindowStats::prepare (int windowSize)
+{
+    jassert (juce::isPowerOfTwo (windowSize) && windowSize >= kPeakBlock);
+
+    size = windowSize;
+    mask = windowSize - 1;
+    blockPeaks.assign ((size_t) (windowSize / kPeakBlock), 0.0f);
+    blockDirty.assign ((size_t) (windowSize / kPeakBlock), 1);
+    invalidate();
+}
+
+void RunningWindowStats::update (const float* ring, int writePos, const float* entering, int n) noexcept
+{
+    if (! valid || n <= 0)
+        return;
+
+    jassert (writePos + n <= size);
+
+    const int half = size / 2;
+
+    // The sample before the first entering one: the newest in the ring
+    float previous = ring[(writePos - 1) & mask];
+
+    for (int j = 0; j < n; ++j)
+    {
+        const int   p       = writePos + j;
+        const float leaving = ring[p];
+        const float x       = entering[j];
+
+        // Old samples, unless this span has already overwritten them: the
+        // leaving sample's successor, and the one moving into the older half
+        const float next     = j + 1 < size ? ring[(p + 1) & mask]    : entering[j + 1 - size];
+        const float crossing = j < half     ? ring[(p + half) & mask] : entering[j - half];
+
+        stats.sum             += (double) x - (double) leaving;
+        stats.energy          += (double) x * x - (double) leaving * leaving;
+        stats.firstHalfEnergy += (double) crossing * crossing - (double) leaving * leaving;
+
+        const double slopeIn  = (double) x - (double) previous;
+        const double slopeOut = (double) next - (double) leaving;
+        stats.slopeEnergy     += slopeIn * slopeIn - slopeOut * slopeOut;
+        stats.signChanges     += (std::signbit (x)    != std::signbit (previous) ? 1 : 0)
+                               - (std::signbit (next) != std::signbit (leaving)  ? 1 : 0);
+        previous = x;
+    }
+
+    for (int b = writePos / kPeakBlock; b <= (writePos + n - 1) / kPeakBlock; ++b)
+        blockDirty[(size_t) b] = 1;
+}
+
+const WindowStats& RunningWindowStats::snapshot (const float* ring, int oldest) noexcept
+{
+    if (! valid || ++snapshotsSinceRecount >= kRefreshWindows)
+        recount (ring, oldest);
+
+    float peak = 0.0f;
+
+    for (size_t b = 0; b < blockPeaks.size(); ++b)
+    {
+        if (blockDirty[b] != 0)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax (ring + b * kPeakBlock, kPeakBlock);
+            blockPeaks[b] = juce::jmax (-range.getStart(), range.getEnd());
+            blockDirty[b] = 0;
+        }
+
+        peak = juce::jmax (peak, blockPeaks[b]);
+    }
+
+    stats.peak = peak;
+    return stats;
+}
+
+void RunningWindowStats::recount (const float* ring, int oldest) noexcept
+{
+    WindowStats fresh;
+    float previous = ring[oldest & mask];
+
+    for (int k = 0; k < size; ++k)
+    {
+        const float x = ring[(oldest + k) & mask];
+
+        fresh.sum    += x;
+        fresh.energy += (double) x * x;
+
+        if (k < size / 2)
+            fresh.firstHalfEnergy += (double) x * x;
+
+        if (k > 0)
+        {
+            const double slope = (double) x - (double) previous;
+            fresh.slopeEnergy += slope * slope;
+            fresh.signChanges += std::signbit (x) != std::signbit (previous) ? 1 : 0;
+        }
+
+        previous = x;
+    }
+
+    stats = fresh;
+    std::fill (blockDirty.begin(), blockDirty.end(), (juce::uint8) 1);
+    snapshotsSinceRecount = 0;
+    valid = true;
+}
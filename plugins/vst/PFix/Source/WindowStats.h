@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+    WindowStats.h  –  Running statistics of the analysis window
+
+    Everything the gate and the correlation engines used to re-sum over the
+    whole window every frame, kept up to date on HopAnalyser's ring as
+    samples enter and leave it instead: O(hop) per frame rather than O(W).
+
+    Each incoming sample adds its own terms and takes away those of the
+    sample it overwrites, plus the neighbour pairs at both ends (slope and
+    sign changes) and the sample that crosses into the older half (YIN's
+    e(0)).  The sums are doubles and are recounted from the ring every
+    kRefreshWindows snapshots, so rounding never builds up; the integer
+    sign-change count needs no refresh but gets one with the rest.  The
+    peak isn't a sum: the ring is split into kPeakBlock-sample blocks, and
+    a snapshot rescans only the blocks written since the last one.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+/** One window's figures, as of the last snapshot. */
+struct WindowStats
+{
+    double sum             { 0.0 };   ///< Σ x (the DC offset is sum / W)
+    double energy          { 0.0 };   ///< Σ x²
+    double firstHalfEnergy { 0.0 };   ///< Σ x² over the older half: YIN's e(0)
+    double slopeEnergy     { 0.0 };   ///< Σ (x[i] − x[i−1])² over neighbours
+    int    signChanges     { 0 };     ///< Neighbours of opposite sign (as the sign bits)
+    float  peak            { 0.0f };  ///< max |x|
+};
+
+/**
+ * Keeps a WindowStats for a power-of-two ring whose oldest sample is at its
+ * write position (HopAnalyser's), updated in O(n) for every n samples
+ * written.  Single-threaded: the ring's owner calls everything.
+ */
+class RunningWindowStats
+{
+public:
+    static constexpr int kPeakBlock      = 64;
+    static constexpr int kRefreshWindows = 64;
+
+    /** Sizes the peak blocks for a ring of windowSize (a power of two
+        >= kPeakBlock).  Not realtime-safe. */
+    void prepare (int windowSize);
+
+    /** The ring changed without update() (a reset, a refill): the next
+        snapshot recounts it, and updates until then cost nothing. */
+    void invalidate() noexcept { valid = false; }
+
+    /** Call just before `entering` overwrites ring[writePos, writePos + n),
+        a span that doesn't wrap, in an already full ring. */
+    void update (const float* ring, int writePos, const float* entering, int n) noexcept;
+
+    /** The figures of the window that starts (oldest sample) at
+        ring[oldest]. */
+    const WindowStats& snapshot (const float* ring, int oldest) noexcept;
+
+private:
+    /** Recomputes every sum from the ring. */
+    void recount (const float* ring, int oldest) noexcept;
+
+    WindowStats              stats;
+    std::vector<float>       blockPeaks;                   // max |x| per ring block
+    std::vector<juce::uint8> blockDirty;                   // written since its peak was taken
+    int                      size                  { 0 };
+    int                      mask                  { 0 };
+    int                      snapshotsSinceRecount { 0 };
+    bool                     valid                 { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RunningWindowStats)
+};
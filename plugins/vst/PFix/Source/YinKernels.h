@@ -0,0 +1,307 @@
+/*
+  ==============================================================================
+    YinKernels.h  –  Hand-vectorised inner loops for PitchDetector
+
+    Each kernel exists as a scalar reference plus SSE2, AVX2 and NEON
+    variants.  select() returns a table of function pointers for the
+    instruction set VectorKernels::detectIsa() found, with sumOfSquares
+    taken from the shared kernels; PitchDetectorCore calls it in its
+    constructor.
+
+    frameStats is the voicing gate's single pass over a window: energy,
+    first-difference energy and sign changes together, the sign changes
+    counted as the top bit of x[i] XOR x[i−1] in integer lanes.
+
+    The difference kernels compute several lags at a time: for every j the
+    sample x[j] is broadcast into all lanes and compared against the
+    contiguous run x[j+τ0 … j+τ0+L−1], so each load is unit-stride and the
+    accumulators for 4 × L consecutive lags stay in registers.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../../Shared/VectorKernels.h"
+#include <cmath>
+
+namespace YinKernels
+{
+    /** Σ x[i]² over n samples. */
+    using SumOfSquaresFn = VectorKernels::SumOfSquaresFn;
+
+    /** d[τ] = Σ_{j<halfSize} (x[j] − x[j+τ])² for τ in [tauBegin, tauEnd).
+        x must hold at least 2 · halfSize samples and tauEnd <= halfSize. */
+    using DifferenceFn   = void  (*) (const float* x, int halfSize,
+                                      int tauBegin, int tauEnd, float* d) noexcept;
+
+    /** What frameStats gathers over a window of n samples. */
+    struct FrameStats
+    {
+        float energy;        ///< Σ x[i]²,              i in [0, n)
+        float slopeEnergy;   ///< Σ (x[i] − x[i−1])²,   i in [1, n)
+        int   signChanges;   ///< neighbours of opposite sign, i in [1, n)
+    };
+
+    using FrameStatsFn   = FrameStats (*) (const float* x, int n) noexcept;
+
+    struct Table
+    {
+        SumOfSquaresFn sumOfSquares;
+        DifferenceFn   difference;
+        FrameStatsFn   frameStats;
+        const char*    name;
+    };
+
+    //==========================================================================
+    // Scalar reference implementations
+    //==========================================================================
+    using VectorKernels::sumOfSquaresScalar;
+
+    inline void differenceScalar (const float* x, int halfSize,
+                                  int tauBegin, int tauEnd, float* d) noexcept
+    {
+        for (int tau = tauBegin; tau < tauEnd; ++tau)
+        {
+            float sum = 0.0f;
+            for (int j = 0; j < halfSize; ++j)
+            {
+                const float delta = x[j] - x[j + tau];
+                sum += delta * delta;
+            }
+            d[tau] = sum;
+        }
+    }
+
+    /** Adds samples [begin, n) to stats; the vector variants finish with it. */
+    inline void accumulateFrameStats (const float* x, int begin, int n, FrameStats& stats) noexcept
+    {
+        for (int i = juce::jmax (1, begin); i < n; ++i)
+        {
+            const float delta = x[i] - x[i - 1];
+            stats.energy      += x[i] * x[i];
+            stats.slopeEnergy += delta * delta;
+            stats.signChanges += std::signbit (x[i]) != std::signbit (x[i - 1]) ? 1 : 0;   // as the sign bits
+        }
+    }
+
+    inline FrameStats frameStatsScalar (const float* x, int n) noexcept
+    {
+        FrameStats stats { n > 0 ? x[0] * x[0] : 0.0f, 0.0f, 0 };
+        accumulateFrameStats (x, 1, n, stats);
+        return stats;
+    }
+
+   #if JUCE_INTEL
+    //==========================================================================
+    // SSE2: 4 lanes × 4 accumulators = 16 lags per pass
+    //==========================================================================
+    using VectorKernels::horizontalSum;
+    using VectorKernels::sumOfSquaresSSE2;
+
+    inline void differenceSSE2 (const float* x, int halfSize,
+                                int tauBegin, int tauEnd, float* d) noexcept
+    {
+        constexpr int kLags = 16;
+        int tau0 = tauBegin;
+        for (; tau0 + kLags <= tauEnd; tau0 += kLags)
+        {
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(),
+                   acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+
+            for (int j = 0; j < halfSize; ++j)
+            {
+                const __m128 xj = _mm_set1_ps (x[j]);
+                const float* xt = x + j + tau0;
+                const __m128 d0 = _mm_sub_ps (xj, _mm_loadu_ps (xt));
+                const __m128 d1 = _mm_sub_ps (xj, _mm_loadu_ps (xt + 4));
+                const __m128 d2 = _mm_sub_ps (xj, _mm_loadu_ps (xt + 8));
+                const __m128 d3 = _mm_sub_ps (xj, _mm_loadu_ps (xt + 12));
+                acc0 = _mm_add_ps (acc0, _mm_mul_ps (d0, d0));
+                acc1 = _mm_add_ps (acc1, _mm_mul_ps (d1, d1));
+                acc2 = _mm_add_ps (acc2, _mm_mul_ps (d2, d2));
+                acc3 = _mm_add_ps (acc3, _mm_mul_ps (d3, d3));
+            }
+
+            _mm_storeu_ps (d + tau0,      acc0);
+            _mm_storeu_ps (d + tau0 + 4,  acc1);
+            _mm_storeu_ps (d + tau0 + 8,  acc2);
+            _mm_storeu_ps (d + tau0 + 12, acc3);
+        }
+        differenceScalar (x, halfSize, tau0, tauEnd, d);
+    }
+
+    inline FrameStats frameStatsSSE2 (const float* x, int n) noexcept
+    {
+        __m128  energy = _mm_setzero_ps(), slope = _mm_setzero_ps();
+        __m128i signs  = _mm_setzero_si128();
+        int i = 1;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 a     = _mm_loadu_ps (x + i);
+            const __m128 prev  = _mm_loadu_ps (x + i - 1);
+            const __m128 delta = _mm_sub_ps (a, prev);
+            energy = _mm_add_ps (energy, _mm_mul_ps (a, a));
+            slope  = _mm_add_ps (slope,  _mm_mul_ps (delta, delta));
+            signs  = _mm_add_epi32 (signs, _mm_srli_epi32 (_mm_castps_si128 (_mm_xor_ps (a, prev)), 31));
+        }
+
+        alignas (16) int counts[4];
+        _mm_store_si128 (reinterpret_cast<__m128i*> (counts), signs);
+
+        FrameStats stats { (n > 0 ? x[0] * x[0] : 0.0f) + horizontalSum (energy), horizontalSum (slope),
+                           counts[0] + counts[1] + counts[2] + counts[3] };
+        accumulateFrameStats (x, i, n, stats);
+        return stats;
+    }
+
+    //==========================================================================
+    // AVX2 + FMA: 8 lanes × 4 accumulators = 32 lags per pass
+    //==========================================================================
+    using VectorKernels::sumOfSquaresAVX2;
+
+    VECTOR_KERNELS_TARGET_AVX2 inline void differenceAVX2 (const float* x, int halfSize,
+                                                int tauBegin, int tauEnd, float* d) noexcept
+    {
+        constexpr int kLags = 32;
+        int tau0 = tauBegin;
+        for (; tau0 + kLags <= tauEnd; tau0 += kLags)
+        {
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps(),
+                   acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+            for (int j = 0; j < halfSize; ++j)
+            {
+                const __m256 xj = _mm256_set1_ps (x[j]);
+                const float* xt = x + j + tau0;
+                const __m256 d0 = _mm256_sub_ps (xj, _mm256_loadu_ps (xt));
+                const __m256 d1 = _mm256_sub_ps (xj, _mm256_loadu_ps (xt + 8));
+                const __m256 d2 = _mm256_sub_ps (xj, _mm256_loadu_ps (xt + 16));
+                const __m256 d3 = _mm256_sub_ps (xj, _mm256_loadu_ps (xt + 24));
+                acc0 = _mm256_fmadd_ps (d0, d0, acc0);
+                acc1 = _mm256_fmadd_ps (d1, d1, acc1);
+                acc2 = _mm256_fmadd_ps (d2, d2, acc2);
+                acc3 = _mm256_fmadd_ps (d3, d3, acc3);
+            }
+
+            _mm256_storeu_ps (d + tau0,      acc0);
+            _mm256_storeu_ps (d + tau0 + 8,  acc1);
+            _mm256_storeu_ps (d + tau0 + 16, acc2);
+            _mm256_storeu_ps (d + tau0 + 24, acc3);
+        }
+        differenceScalar (x, halfSize, tau0, tauEnd, d);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline FrameStats frameStatsAVX2 (const float* x, int n) noexcept
+    {
+        __m256  energy = _mm256_setzero_ps(), slope = _mm256_setzero_ps();
+        __m256i signs  = _mm256_setzero_si256();
+        int i = 1;
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m256 a     = _mm256_loadu_ps (x + i);
+            const __m256 prev  = _mm256_loadu_ps (x + i - 1);
+            const __m256 delta = _mm256_sub_ps (a, prev);
+            energy = _mm256_fmadd_ps (a, a, energy);
+            slope  = _mm256_fmadd_ps (delta, delta, slope);
+            signs  = _mm256_add_epi32 (signs, _mm256_srli_epi32 (_mm256_castps_si256 (_mm256_xor_ps (a, prev)), 31));
+        }
+
+        const __m128i counts4 = _mm_add_epi32 (_mm256_castsi256_si128 (signs), _mm256_extracti128_si256 (signs, 1));
+        alignas (16) int counts[4];
+        _mm_store_si128 (reinterpret_cast<__m128i*> (counts), counts4);
+
+        FrameStats stats { (n > 0 ? x[0] * x[0] : 0.0f)
+                             + horizontalSum (_mm_add_ps (_mm256_castps256_ps128 (energy), _mm256_extractf128_ps (energy, 1))),
+                           horizontalSum (_mm_add_ps (_mm256_castps256_ps128 (slope), _mm256_extractf128_ps (slope, 1))),
+                           counts[0] + counts[1] + counts[2] + counts[3] };
+        accumulateFrameStats (x, i, n, stats);
+        return stats;
+    }
+   #endif
+
+   #if VECTOR_KERNELS_HAVE_NEON
+    //==========================================================================
+    // NEON: 4 lanes × 4 accumulators = 16 lags per pass
+    //==========================================================================
+    using VectorKernels::horizontalSum;
+    using VectorKernels::sumOfSquaresNEON;
+
+    inline void differenceNEON (const float* x, int halfSize,
+                                int tauBegin, int tauEnd, float* d) noexcept
+    {
+        constexpr int kLags = 16;
+        int tau0 = tauBegin;
+        for (; tau0 + kLags <= tauEnd; tau0 += kLags)
+        {
+            float32x4_t acc0 = vdupq_n_f32 (0.0f), acc1 = vdupq_n_f32 (0.0f),
+                        acc2 = vdupq_n_f32 (0.0f), acc3 = vdupq_n_f32 (0.0f);
+
+            for (int j = 0; j < halfSize; ++j)
+            {
+                const float32x4_t xj = vdupq_n_f32 (x[j]);
+                const float*      xt = x + j + tau0;
+                const float32x4_t d0 = vsubq_f32 (xj, vld1q_f32 (xt));
+                const float32x4_t d1 = vsubq_f32 (xj, vld1q_f32 (xt + 4));
+                const float32x4_t d2 = vsubq_f32 (xj, vld1q_f32 (xt + 8));
+                const float32x4_t d3 = vsubq_f32 (xj, vld1q_f32 (xt + 12));
+                acc0 = vmlaq_f32 (acc0, d0, d0);
+                acc1 = vmlaq_f32 (acc1, d1, d1);
+                acc2 = vmlaq_f32 (acc2, d2, d2);
+                acc3 = vmlaq_f32 (acc3, d3, d3);
+            }
+
+            vst1q_f32 (d + tau0,      acc0);
+            vst1q_f32 (d + tau0 + 4,  acc1);
+            vst1q_f32 (d + tau0 + 8,  acc2);
+            vst1q_f32 (d + tau0 + 12, acc3);
+        }
+        differenceScalar (x, halfSize, tau0, tauEnd, d);
+    }
+
+    inline FrameStats frameStatsNEON (const float* x, int n) noexcept
+    {
+        float32x4_t energy = vdupq_n_f32 (0.0f), slope = vdupq_n_f32 (0.0f);
+        uint32x4_t  signs  = vdupq_n_u32 (0);
+        int i = 1;
+        for (; i + 4 <= n; i += 4)
+        {
+            const float32x4_t a     = vld1q_f32 (x + i);
+            const float32x4_t prev  = vld1q_f32 (x + i - 1);
+            const float32x4_t delta = vsubq_f32 (a, prev);
+            energy = vmlaq_f32 (energy, a, a);
+            slope  = vmlaq_f32 (slope, delta, delta);
+            signs  = vaddq_u32 (signs, vshrq_n_u32 (veorq_u32 (vreinterpretq_u32_f32 (a),
+                                                               vreinterpretq_u32_f32 (prev)), 31));
+        }
+
+        const uint32x2_t pairs = vadd_u32 (vget_low_u32 (signs), vget_high_u32 (signs));
+
+        FrameStats stats { (n > 0 ? x[0] * x[0] : 0.0f) + horizontalSum (energy), horizontalSum (slope),
+                           (int) vget_lane_u32 (vpadd_u32 (pairs, pairs), 0) };
+        accumulateFrameStats (x, i, n, stats);
+        return stats;
+    }
+   #endif
+
+    //==========================================================================
+    /** The variants for the instruction set VectorKernels::detectIsa()
+        found. */
+    inline Table select() noexcept
+    {
+        const auto isa  = VectorKernels::detectIsa();
+        const auto name = VectorKernels::getName (isa);
+
+        switch (isa)
+        {
+           #if JUCE_INTEL
+            case VectorKernels::Isa::avx2: return { sumOfSquaresAVX2, differenceAVX2, frameStatsAVX2, name };
+            case VectorKernels::Isa::sse2: return { sumOfSquaresSSE2, differenceSSE2, frameStatsSSE2, name };
+           #endif
+           #if VECTOR_KERNELS_HAVE_NEON
+            case VectorKernels::Isa::neon: return { sumOfSquaresNEON, differenceNEON, frameStatsNEON, name };
+           #endif
+            default:                       return { sumOfSquaresScalar, differenceScalar, frameStatsScalar, name };
+        }
+    }
+}
@@ -0,0 +1,359 @@
+/*
+  ==============================================================================
+    AnalysisWorkerPool.h  –  One process-wide set of analysis threads, shared
+                             fairly by every plugin instance
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    A thread per instance stops scaling once a session has dozens of
+    instances: forty analysis threads fighting over eight cores all lose.
+    Instead each instance owns a Client, and every Client shares one pool,
+    created with the first and stopped with the last (a
+    juce::SharedResourcePointer), of one thread per physical core less one
+    for the host's audio thread.
+
+    An instance hands the pool Sources: anything that can say when its next
+    slice of work is due and then do that slice.  Each free thread takes
+    the slice that's due first from the instance with the fewest slices
+    running, so one busy instance can't crowd out the others, and within
+    that, earliest deadline first.  A Source never runs on two threads at
+    once.
+
+    Nothing here is for the audio thread: Sources find their work by
+    polling (e.g. a lock-free feed), since waking a thread isn't
+    realtime-safe, and an idle thread polls every kPollIntervalMs.
+
+    An instance whose output waits on its slices (PFix's notes) can have
+    the threads join the host's audio workgroup while they run them, so
+    that on Apple silicon they are scheduled like the audio thread rather
+    than on the efficiency cores (see Client::setWorkgroup()).  A thread
+    is in one workgroup at a time, so it moves as it takes slices from
+    instances in different ones.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_events/juce_events.h>
+#include "TraceEvents.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+class AnalysisWorkerPool
+{
+public:
+    static constexpr int kMaxThreads     = 16;
+    static constexpr int kPollIntervalMs = 2;   // an idle thread's longest sleep
+
+    //==============================================================================
+    /** A stream of work from one instance, done a slice at a time. */
+    class Source
+    {
+    public:
+        static constexpr juce::int64 kNothingDue = std::numeric_limits<juce::int64>::max();
+
+        virtual ~Source() = default;
+
+        /** When the next slice is due, in high-resolution ticks, or
+            kNothingDue.  Called by the pool under its lock and never while
+            runSlice() is running, so it may take its next piece of work
+            from its producer here. */
+        virtual juce::int64 getDeadline() = 0;
+
+        /** Does the slice the last getDeadline() found.  On a pool thread. */
+        virtual void runSlice() = 0;
+    };
+
+    //==============================================================================
+    /** One instance's share of the pool.  Message thread. */
+    class Client
+    {
+    public:
+        /** name is a string literal, used to label the instance's work. */
+        explicit Client (const char* nameToUse) : name (nameToUse) { pool->attach (*this); }
+        ~Client()                                                 { pool->detach (*this); }
+
+        /** source must outlive its time in the pool. */
+        void addSource (Source& source) { pool->add (*this, source); }
+
+        /** Takes source out of the pool, waiting for a slice of it that's
+            running to finish. */
+        void removeSource (Source& source) { pool->remove (*this, &source); }
+        void removeAllSources()            { pool->remove (*this, nullptr); }
+
+        /** How many slices the pool can run at once, across every instance. */
+        int getNumThreads() const noexcept { return (int) pool->threads.size(); }
+
+        /** The host audio thread's workgroup, from
+            AudioProcessor::audioWorkgroupContextChanged(), or a
+            default-constructed one for none.  Any thread, including the
+            audio thread (it copies the workgroup, which may allocate, but
+            only when the host's changes). */
+        void setWorkgroup (const juce::AudioWorkgroup& newWorkgroup)
+        {
+            {
+                const juce::SpinLock::ScopedLockType sl (workgroupLock);
+                workgroup = newWorkgroup;
+            }
+
+            workgroupStamp.store (pool->makeWorkgroupStamp(), std::memory_order_release);
+        }
+
+        /** Whether the threads join that workgroup for this instance's
+            slices: only while the audio thread's output waits on them, as
+            they then count against the host's deadline.  Realtime-safe. */
+        void setJoinsWorkgroup (bool shouldJoin) noexcept
+        {
+            if (joinsWorkgroup.exchange (shouldJoin) != shouldJoin)
+                workgroupStamp.store (pool->makeWorkgroupStamp(), std::memory_order_release);
+        }
+
+    private:
+        friend class AnalysisWorkerPool;
+
+        /** The workgroup to be in for this instance's slices. */
+        juce::AudioWorkgroup getWorkgroupToJoin() const
+        {
+            if (! joinsWorkgroup.load())
+                return {};
+
+            const juce::SpinLock::ScopedLockType sl (workgroupLock);
+            return workgroup;
+        }
+
+        const char* const    name;
+        std::vector<Source*> sources;          // under the pool's lock
+        int                  numRunning = 0;   // ditto
+
+        mutable juce::SpinLock    workgroupLock;
+        juce::AudioWorkgroup      workgroup;                  // guarded by workgroupLock
+        std::atomic<bool>         joinsWorkgroup { false };
+        std::atomic<juce::uint64> workgroupStamp { 0 };       // new, pool-wide, at every change; 0 = none
+
+        juce::SharedResourcePointer<AnalysisWorkerPool> pool;
+
+        JUCE_DECLARE_NON_COPYABLE (Client)
+    };
+
+    //==============================================================================
+    /** Use a Client rather than making one of these. */
+    AnalysisWorkerPool()
+    {
+        const auto numThreads = juce::jlimit (1, kMaxThreads, juce::SystemStats::getNumPhysicalCpus() - 1);
+
+        for (int i = 0; i < numThreads; ++i)
+        {
+            threads.push_back (std::make_unique<Worker> (*this));
+            threads.back()->startThread (juce::Thread::Priority::high);
+        }
+    }
+
+    ~AnalysisWorkerPool()
+    {
+        // Ask them all first so they wind down in parallel
+        for (auto& thread : threads)
+            thread->signalThreadShouldExit();
+
+        for (auto& thread : threads)
+            thread->stopThread (1000);
+    }
+
+private:
+    struct Running
+    {
+        Source* source;
+        Client* client;
+    };
+
+    class Worker  : public juce::Thread
+    {
+    public:
+        explicit Worker (AnalysisWorkerPool& ownerToUse) : juce::Thread ("Analysis worker"), owner (ownerToUse) {}
+
+        void run() override
+        {
+            TRACE_THREAD_NAME ("Analysis worker");
+
+            // Left when this goes out of scope, on this thread as it must be
+            juce::WorkgroupToken token;
+
+            while (! threadShouldExit())
+            {
+                if (const auto running = owner.claim(); running.source != nullptr)
+                {
+                    followWorkgroup (*running.client, token);
+
+                    TRACE_SCOPE (running.client->name);
+                    running.source->runSlice();
+                    owner.finish (running);
+                }
+                else
+                {
+                    wait (kPollIntervalMs);
+                }
+            }
+        }
+
+    private:
+        /** Leaves the workgroup this thread is in and joins client's, if
+            they differ.  Checked by stamp first, since joining is a system
+            call.  A thread past the most the workgroup takes stays out. */
+        void followWorkgroup (const Client& client, juce::WorkgroupToken& token)
+        {
+            const auto stamp = client.workgroupStamp.load (std::memory_order_acquire);
+
+            if (stamp == joinedStamp)
+                return;
+
+            joinedStamp = stamp;
+            auto wanted = client.getWorkgroupToJoin();
+
+            if (wanted == joined)
+                return;
+
+            token.reset();
+            joined = std::move (wanted);
+
+            if (joined)
+                joined.join (token);
+        }
+
+        AnalysisWorkerPool& owner;
+        juce::AudioWorkgroup joined;            // this thread's
+        juce::uint64         joinedStamp = 0;   // the stamp it was chosen by
+    };
+
+    juce::uint64 makeWorkgroupStamp() noexcept { return workgroupStamps.fetch_add (1, std::memory_order_relaxed); }
+
+    void attach (Client& client)
+    {
+        const juce::ScopedLock sl (lock);
+        clients.push_back (&client);
+    }
+
+    void detach (Client& client)
+    {
+        remove (client, nullptr);
+
+        const juce::ScopedLock sl (lock);
+        clients.erase (std::find (clients.begin(), clients.end(), &client));
+    }
+
+    void add (Client& client, Source& source)
+    {
+        const juce::ScopedLock sl (lock);
+        jassert (std::find (client.sources.begin(), client.sources.end(), &source) == client.sources.end());
+        client.sources.push_back (&source);
+    }
+
+    /** Takes source (or all of client's, if nullptr) out, then waits until
+        none of them is running. */
+    void remove (Client& client, Source* source)
+    {
+        const auto matches = [&client, source] (const Running& r)
+        {
+            return r.client == &client && (source == nullptr || r.source == source);
+        };
+
+        {
+            const juce::ScopedLock sl (lock);
+            auto& sources = client.sources;
+            sources.erase (std::remove_if (sources.begin(), sources.end(),
+                                           [source] (Source* s) { return source == nullptr || s == source; }),
+                           sources.end());
+        }
+
+        for (;;)
+        {
+            {
+                const juce::ScopedLock sl (lock);
+
+                if (std::none_of (running.begin(), running.end(), matches))
+                    return;
+            }
+
+            sliceFinished.wait (kPollIntervalMs);
+        }
+    }
+
+    /** The slice due first from the instance with the fewest running,
+        marked running; an empty Running if nothing is due. */
+    Running claim()
+    {
+        const juce::ScopedLock sl (lock);
+
+        Running     best { nullptr, nullptr };
+        juce::int64 bestDeadline = Source::kNothingDue;
+        size_t      bestIndex    = 0;
+
+        // Start after the last instance served, so ties go round the instances
+        for (size_t i = 0; i < clients.size(); ++i)
+        {
+            const auto index  = (nextClient + i) % clients.size();
+            auto*      client = clients[index];
+
+            if (best.client != nullptr && client->numRunning > best.client->numRunning)
+                continue;
+
+            for (auto* source : client->sources)
+            {
+                if (isRunning (source))
+                    continue;
+
+                const auto deadline = source->getDeadline();
+
+                if (deadline == Source::kNothingDue)
+                    continue;
+
+                if (best.client == nullptr || client->numRunning < best.client->numRunning || deadline < bestDeadline)
+                {
+                    best         = { source, client };
+                    bestDeadline = deadline;
+                    bestIndex    = index;
+                }
+            }
+        }
+
+        if (best.source != nullptr)
+        {
+            ++best.client->numRunning;
+            running.push_back (best);
+            nextClient = bestIndex + 1;
+        }
+
+        return best;
+    }
+
+    void finish (const Running& slice)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            --slice.client->numRunning;
+            running.erase (std::find_if (running.begin(), running.end(),
+                                         [&slice] (const Running& r) { return r.source == slice.source; }));
+        }
+
+        sliceFinished.signal();
+    }
+
+    bool isRunning (const Source* source) const noexcept
+    {
+        return std::any_of (running.begin(), running.end(), [source] (const Running& r) { return r.source == source; });
+    }
+
+    juce::CriticalSection   lock;
+    std::vector<Client*>    clients;
+    std::vector<Running>    running;        // at most one per thread
+    size_t                  nextClient = 0;
+    juce::WaitableEvent     sliceFinished;
+
+    std::atomic<juce::uint64> workgroupStamps { 1 };
+
+    std::vector<std::unique_ptr<Worker>> threads;
+
+    JUCE_DECLARE_NON_COPYABLE (AnalysisWorkerPool)
+};
@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+    BroadcastRing.h  –  Single-producer / multi-consumer broadcast ring
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    One writer, any number of readers, and every reader sees every item:
+    reading doesn't take anything away from the others.  Each consumer
+    owns a Reader, which is nothing but its own cursor into the ring, so
+    adding a consumer costs the producer nothing; the producer writes each
+    item once and never waits for anyone, so a reader that falls more than
+    Capacity items behind has lost the oldest of them.  It finds out on
+    its next read, which counts what it missed and resyncs to the oldest
+    item still there; skipToNewest() gives up on a backlog instead.
+
+    Readers copy items out, because the producer may be overwriting a slot
+    while it's read.  Like a seqlock, the producer announces how far it is
+    about to write (claimIndex) before touching the slots and publishes
+    the items (writeIndex) after, and a reader checks the claim after
+    copying: anything the claim has lapped may be torn, and is thrown away
+    and counted as missed rather than handed on.  So that the copy is not
+    itself a data race, a slot holds its item as relaxed atomic words,
+    which cost a plain load or store each on every target we build for.
+
+    No locks and no heap allocation; T must be trivially copyable.  The
+    producer's indices sit on their own cache line, and readers only ever
+    read it, so in steady state they share it with the producer without
+    writing back.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+template <typename T, int Capacity>
+class BroadcastRing
+{
+public:
+    static_assert (Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                   "BroadcastRing capacity must be a power of two");
+    static_assert (std::is_trivially_copyable_v<T>,
+                   "BroadcastRing items are copied as raw words");
+
+    static constexpr int kCapacity  = Capacity;
+    static constexpr int kReadChunk = juce::jmin (Capacity, 256);   // Reader::readAll()'s copy buffer
+
+    BroadcastRing() = default;
+
+    // ── Producer ──────────────────────────────────────────────────────────────
+
+    void push (const T& item) noexcept
+    {
+        pushBlock (&item, 1);
+    }
+
+    /** Appends num items, overwriting the oldest; only the newest Capacity
+        of them survive if num > Capacity. */
+    void pushBlock (const T* items, int num) noexcept
+    {
+        if (num <= 0)
+            return;
+
+        size_t w = writeIndex.load (std::memory_order_relaxed);
+
+        if (num > Capacity)
+        {
+            items += num - Capacity;
+            w     += (size_t) (num - Capacity);   // as if the skipped ones were written and lapped
+            num    = Capacity;
+        }
+
+        claimIndex.store (w + (size_t) num, std::memory_order_relaxed);
+        std::atomic_thread_fence (std::memory_order_release);
+
+        const int pos = static_cast<int> (w & kMask);
+        const int n1  = juce::jmin (num, Capacity - pos);
+
+        for (int i = 0; i < n1; ++i)
+            slots[(size_t) (pos + i)].store (items[i]);
+
+        for (int i = n1; i < num; ++i)
+            slots[(size_t) (i - n1)].store (items[i]);
+
+        writeIndex.store (w + (size_t) num, std::memory_order_release);
+    }
+
+    /** Items written since the last reset().  Any thread. */
+    juce::uint64 getNumPushed() const noexcept { return (juce::uint64) writeIndex.load (std::memory_order_relaxed); }
+
+    /** Not thread-safe: only call while nothing is reading or writing.
+        Readers notice on their next read and start again from the first
+        item pushed since. */
+    void reset() noexcept
+    {
+        writeIndex.store (0);
+        claimIndex.store (0);
+        numResets.fetch_add (1);
+    }
+
+    //==============================================================================
+    /**
+     * One consumer's cursor.  Starts at the newest item (it sees what's
+     * pushed after it was made).  Everything but the constructor is for the
+     * consumer's own thread; the ring must outlive it.
+     */
+    class Reader
+    {
+    public:
+        struct Stats
+        {
+            juce::uint64 received { 0 };   ///< Items handed to the consumer
+            juce::uint64 missed   { 0 };   ///< Items lapped by the producer before they were read
+            int          maxLag   { 0 };   ///< Largest backlog a read found, Capacity = it had lapped
+        };
+
+        explicit Reader (const BroadcastRing& ringToRead) noexcept
+            : ring (&ringToRead),
+              cursor (ringToRead.writeIndex.load (std::memory_order_acquire)),
+              resetsSeen (ringToRead.numResets.load (std::memory_order_relaxed))
+        {
+        }
+
+        /** Copies out up to maxItems of the items pushed since the last
+            read, oldest first, and calls consume (const T* items, int num)
+            once per chunk of at most kReadChunk, with pointers into the
+            reader's own buffer (valid inside the callback).  Returns the
+            total consumed. */
+        template <typename Consumer>
+        int readAll (Consumer&& consume, int maxItems = Capacity)
+        {
+            int total = 0;
+
+            while (total < maxItems)
+            {
+                const int n = read (chunk.data(), juce::jmin (kReadChunk, maxItems - total));
+
+                if (n == 0)
+                    break;
+
+                consume (static_cast<const T*> (chunk.data()), n);
+                total += n;
+            }
+
+            return total;
+        }
+
+        /** Copies up to maxItems (at most Capacity) into dest, oldest first;
+            returns how many. */
+        int read (T* dest, int maxItems) noexcept
+        {
+            const size_t published = ring->writeIndex.load (std::memory_order_acquire);
+            catchUpWithReset();
+
+            size_t backlog = published - cursor;
+            stats.maxLag = juce::jmax (stats.maxLag, (int) juce::jmin (backlog, (size_t) Capacity));
+
+            if (backlog > (size_t) Capacity)
+            {
+                skip (backlog - (size_t) Capacity);
+                backlog = (size_t) Capacity;
+            }
+
+            const int n   = (int) juce::jmin (backlog, (size_t) juce::jmax (0, juce::jmin (maxItems, Capacity)));
+            const int pos = static_cast<int> (cursor & kMask);
+            const int n1  = juce::jmin (n, Capacity - pos);
+
+            for (int i = 0; i < n1; ++i)
+                dest[i] = ring->slots[(size_t) (pos + i)].load();
+
+            for (int i = n1; i < n; ++i)
+                dest[i] = ring->slots[(size_t) (i - n1)].load();
+
+            // Whatever the producer has claimed since may have overwritten
+            // the oldest of those slots while they were copied
+            std::atomic_thread_fence (std::memory_order_acquire);
+            const size_t claimed = ring->claimIndex.load (std::memory_order_relaxed);
+            const size_t oldestIntact = claimed > (size_t) Capacity ? claimed - (size_t) Capacity : 0;
+            const int    torn = oldestIntact > cursor ? (int) juce::jmin (oldestIntact - cursor, (size_t) n) : 0;
+
+            if (torn > 0)
+                std::copy (dest + torn, dest + n, dest);
+
+            skip ((size_t) torn);
+            cursor += (size_t) (n - torn);
+            stats.received += (juce::uint64) (n - torn);
+            return n - torn;
+        }
+
+        /** Items pushed that this reader hasn't read (more than Capacity
+            means it has lapped).  A snapshot: the producer may be moving. */
+        int numBehind() const noexcept
+        {
+            const size_t published = ring->writeIndex.load (std::memory_order_acquire);
+            const size_t from      = ring->numResets.load (std::memory_order_relaxed) != resetsSeen ? 0 : cursor;
+            return published > from ? (int) juce::jmin (published - from, (size_t) std::numeric_limits<int>::max()) : 0;
+        }
+
+        /** Drops the backlog: the next read starts at the next item pushed.
+            Returns how many were skipped (they count as missed). */
+        int skipToNewest() noexcept
+        {
+            const int behind = numBehind();
+            catchUpWithReset();
+            skip ((size_t) behind);
+            return behind;
+        }
+
+        const Stats& getStats() const noexcept { return stats; }
+
+    private:
+        void catchUpWithReset() noexcept
+        {
+            const auto resets = ring->numResets.load (std::memory_order_relaxed);
+
+            if (resets != resetsSeen)
+            {
+                resetsSeen = resets;
+                cursor     = 0;
+            }
+        }
+
+        void skip (size_t num) noexcept
+        {
+            cursor       += num;
+            stats.missed += (juce::uint64) num;
+        }
+
+        const BroadcastRing*               ring;
+        size_t                             cursor;
+        juce::uint32                       resetsSeen;
+        Stats                              stats;
+        std::array<T, (size_t) kReadChunk> chunk {};
+    };
+
+private:
+   #if JUCE_ARM && JUCE_MAC
+    static constexpr size_t kCacheLineSize = 128;   // Apple silicon
+   #else
+    static constexpr size_t kCacheLineSize = 64;
+   #endif
+
+    static constexpr size_t kMask = (size_t) Capacity - 1;
+
+    /** One item as relaxed atomic words: the reader may load them while the
+        producer stores, and a torn item is caught by the claim check. */
+    class Slot
+    {
+    public:
+        void store (const T& item) noexcept
+        {
+            Word bits[kNumWords] {};
+            std::memcpy (bits, &item, sizeof (T));
+
+            for (size_t i = 0; i < kNumWords; ++i)
+                words[i].store (bits[i], std::memory_order_relaxed);
+        }
+
+        T load() const noexcept
+        {
+            Word bits[kNumWords];
+
+            for (size_t i = 0; i < kNumWords; ++i)
+                bits[i] = words[i].load (std::memory_order_relaxed);
+
+            T item;
+            std::memcpy (&item, bits, sizeof (T));
+            return item;
+        }
+
+    private:
+        using Word = std::conditional_t<sizeof (T) % sizeof (juce::uint64) == 0, juce::uint64, juce::uint32>;
+        static constexpr size_t kNumWords = (sizeof (T) + sizeof (Word) - 1) / sizeof (Word);
+        static_assert (std::atomic<Word>::is_always_lock_free);
+
+        std::array<std::atomic<Word>, kNumWords> words {};
+    };
+
+    // Producer line: written only by the producer, read by every reader.
+    alignas (kCacheLineSize) std::atomic<size_t> writeIndex { 0 };   // items [0, writeIndex) are published
+    std::atomic<size_t>                          claimIndex { 0 };   // slots up to here may be mid-write
+    std::atomic<juce::uint32>                    numResets  { 0 };
+
+    alignas (kCacheLineSize) std::array<Slot, (size_t) Capacity> slots {};
+
+    JUCE_DECLARE_NON_COPYABLE (BroadcastRing)
+};
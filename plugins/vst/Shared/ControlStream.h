@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+    ControlStream.h  –  High-rate controller frames over shared memory
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Carries a controller's per-finger positions (the virtual-key hand
+    tracker's, at its camera's frame rate) straight into a plugin, with
+    no MIDI driver, no quantisation and no per-message system call.  The
+    controller creates a region under getDirectory() and is its only
+    writer; every plugin instance that wants it maps it read-only and
+    follows it with its own cursor, so one controller can play several
+    instances.
+
+    The layout is fixed and language-neutral, because the writer is
+    usually Python (src/midi/control_stream.py mirrors it).  Little-endian:
+
+      Header (64 bytes)
+         0  u32  magic "VGCS"         16  u64  frames published
+         4  u32  version (1)          24  f32  semitones per unit of x
+         8  u32  slot bytes (192)     28  u32  max fingers (10)
+        12  u32  capacity (64)        32  i64  heartbeat, ms since 1970
+      Slots (capacity × 192 bytes, frame n in slot n % capacity)
+         0  u64  sequence: 2n + 1 while frame n is written, 2n + 2 after
+         8  f64  timestamp, seconds on the writer's monotonic clock
+        16  u32  fingers used
+        24  ×10  { u8 MIDI channel (0 = no note), u8 note, u16 0,
+                   f32 x, f32 y, f32 z }
+
+    Writing frame n: store its sequence as 2n + 1, write the slot, store
+    2n + 2, then frames published = n + 1 and the heartbeat.  A reader
+    only takes a frame whose sequence reads 2n + 2 both before and after
+    copying it, so a lapped or half-written slot is skipped and counted as
+    missed.  (A writer without fences, like plain Python, can on a weakly
+    ordered CPU very occasionally leave a stale field in an accepted frame:
+    the values are positions, and the voices smooth one such frame away
+    like any other jitter.)
+
+    x is the finger's position across the controller's keyboard (0 … 1,
+    so "semitones per unit of x" is its width in keys), y its timbre
+    position (0 … 1, as it would be sent as CC74), z its press depth.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+/** One finger in a ControlFrame. */
+struct ControlFinger
+{
+    juce::uint8  channel  { 0 };   ///< MIDI channel of the note it plays, 1 … 16; 0 = none
+    juce::uint8  note     { 0 };
+    juce::uint16 reserved { 0 };
+    float        x        { 0.0f };
+    float        y        { 0.0f };
+    float        z        { 0.0f };
+};
+
+/** One camera frame's worth of fingers. */
+struct ControlFrame
+{
+    static constexpr int kMaxFingers = 10;
+
+    double                                  timestamp  { 0.0 };
+    juce::uint32                            numFingers { 0 };
+    juce::uint32                            reserved   { 0 };
+    std::array<ControlFinger, kMaxFingers>  fingers    {};
+};
+
+class ControlStream
+{
+public:
+    static constexpr juce::uint32 kMagic        = 0x53434756;   // "VGCS", little-endian
+    static constexpr juce::uint32 kVersion      = 1;
+    static constexpr int          kCapacity     = 64;           // ~1 s at 60 frames per second
+    static constexpr size_t       kHeaderBytes  = 64;
+    static constexpr size_t       kSlotBytes    = 192;
+    static constexpr juce::int64  kRegionBytes  = (juce::int64) (kHeaderBytes + kCapacity * kSlotBytes);
+
+    /** Where regions live: /dev/shm on Linux, the user's application data
+        folder elsewhere.  Not the temp folder, which on macOS is per app:
+        the controller has to find the same path (region_directory() in
+        control_stream.py). */
+    static juce::File getDirectory()
+    {
+       #if JUCE_LINUX
+        const juce::File shm ("/dev/shm");
+
+        if (shm.isDirectory())
+            return shm.getChildFile ("vst-garage-control");
+       #endif
+
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("vst-garage").getChildFile ("control");
+    }
+
+    /** The region a controller of this name writes. */
+    static juce::File getRegionFile (const juce::String& controllerName)
+    {
+        return getDirectory().getChildFile (juce::File::createLegalFileName (controllerName) + ".control");
+    }
+
+private:
+    static_assert (std::atomic<juce::uint64>::is_always_lock_free && std::atomic<juce::int64>::is_always_lock_free,
+                   "shared-memory atomics must be lock-free to work across processes");
+
+    struct Header
+    {
+        juce::uint32              magic;
+        juce::uint32              version;
+        juce::uint32              slotBytes;
+        juce::uint32              capacity;
+        std::atomic<juce::uint64> framesPublished;
+        float                     semitonesPerUnitX;
+        juce::uint32              maxFingers;
+        std::atomic<juce::int64>  heartbeatMs;
+        std::array<char, 24>      reserved;
+    };
+
+    struct Slot
+    {
+        std::atomic<juce::uint64> sequence;
+        ControlFrame              frame;
+        std::array<char, 8>       reserved;
+    };
+
+    static_assert (sizeof (ControlFinger) == 16 && sizeof (ControlFrame) == 176, "ControlFrame is part of the layout");
+    static_assert (sizeof (Header) == kHeaderBytes && sizeof (Slot) == kSlotBytes, "ControlStream layout");
+    static_assert (offsetof (Header, framesPublished) == 16 && offsetof (Header, heartbeatMs) == 32, "ControlStream layout");
+    static_assert (offsetof (Slot, frame) == 8, "ControlStream layout");
+
+    static Header& getHeader (void* base) noexcept            { return *static_cast<Header*> (base); }
+    static Slot&   getSlot   (void* base, juce::uint64 frame) noexcept
+    {
+        return reinterpret_cast<Slot*> (static_cast<char*> (base) + kHeaderBytes)[frame & (juce::uint64) (kCapacity - 1)];
+    }
+
+public:
+    //==============================================================================
+    /** Follows one controller's region, read-only.  open() and close() are
+        not realtime-safe; readNew() is (no locks, no allocation), for the
+        thread that consumes the frames. */
+    class Reader
+    {
+    public:
+        struct Stats
+        {
+            juce::uint64 received { 0 };   ///< Frames handed to the handler
+            juce::uint64 missed   { 0 };   ///< Lapped, or caught mid-write
+        };
+
+        Reader() = default;
+
+        /** Maps the region and starts after its newest frame.  False if it
+            doesn't exist or isn't a region of this version and layout. */
+        bool open (const juce::File& regionFile)
+        {
+            close();
+
+            if (regionFile.getSize() < kRegionBytes)
+                return false;
+
+            mapping = std::make_unique<juce::MemoryMappedFile> (regionFile, juce::Range<juce::int64> (0, kRegionBytes),
+                                                                juce::MemoryMappedFile::readOnly);
+
+            if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < kRegionBytes)
+            {
+                close();
+                return false;
+            }
+
+            const auto& header = getHeader (mapping->getData());
+
+            if (header.magic != kMagic || header.version != kVersion
+                 || header.slotBytes != (juce::uint32) kSlotBytes || header.capacity != (juce::uint32) kCapacity)
+            {
+                close();
+                return false;
+            }
+
+            file   = regionFile;
+            cursor = header.framesPublished.load (std::memory_order_acquire);
+            return true;
+        }
+
+        void close()
+        {
+            mapping.reset();
+            file = {};
+        }
+
+        bool       isOpen()  const noexcept { return mapping != nullptr; }
+        juce::File getFile() const          { return file; }
+
+        /** Whether the controller has written in the last staleAfterMs. */
+        bool isAlive (juce::int64 staleAfterMs = 1000) const noexcept
+        {
+            return isOpen()
+                && juce::Time::currentTimeMillis() - getHeader (mapping->getData()).heartbeatMs.load (std::memory_order_relaxed) <= staleAfterMs;
+        }
+
+        /** The controller's keyboard width in keys, for bends from x. */
+        float getSemitonesPerUnitX() const noexcept
+        {
+            return isOpen() ? getHeader (mapping->getData()).semitonesPerUnitX : 0.0f;
+        }
+
+        /** Calls handler (const ControlFrame&) for each frame published since
+            the last call, oldest first.  Returns how many. */
+        template <typename Handler>
+        int readNew (Handler&& handler) noexcept
+        {
+            if (! isOpen())
+                return 0;
+
+            auto*      base      = mapping->getData();
+            const auto published = getHeader (base).framesPublished.load (std::memory_order_acquire);
+
+            if (published < cursor)   // the controller started again
+                cursor = published;
+
+            if (published - cursor > (juce::uint64) kCapacity)
+            {
+                stats.missed += published - cursor - (juce::uint64) kCapacity;
+                cursor        = published - (juce::uint64) kCapacity;
+            }
+
+            int numRead = 0;
+
+            for (; cursor < published; ++cursor)
+            {
+                const auto& slot     = getSlot (base, cursor);
+                const auto  expected = 2 * cursor + 2;
+
+                if (slot.sequence.load (std::memory_order_acquire) != expected)
+                {
+                    ++stats.missed;
+                    continue;
+                }
+
+                std::memcpy (&frame, &slot.frame, sizeof (ControlFrame));
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (slot.sequence.load (std::memory_order_relaxed) != expected)
+                {
+                    ++stats.missed;
+                    continue;
+                }
+
+                frame.numFingers = juce::jmin (frame.numFingers, (juce::uint32) ControlFrame::kMaxFingers);
+
+                handler (static_cast<const ControlFrame&> (frame));
+                ++stats.received;
+                ++numRead;
+            }
+
+            return numRead;
+        }
+
+        const Stats& getStats() const noexcept { return stats; }
+
+    private:
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        juce::File                              file;
+        juce::uint64                            cursor { 0 };
+        ControlFrame                            frame;
+        Stats                                   stats;
+
+        JUCE_DECLARE_NON_COPYABLE (Reader)
+    };
+
+    //==============================================================================
+    /** Creates and writes a region: the reference writer, for native
+        controllers and tools (the hand tracker has its own, in Python).
+        One thread. */
+    class Writer
+    {
+    public:
+        Writer() = default;
+        ~Writer() { close(); }
+
+        bool open (const juce::String& controllerName, float semitonesPerUnitX)
+        {
+            close();
+
+            file = getRegionFile (controllerName);
+
+            if (file.getParentDirectory().createDirectory().failed())
+                return false;
+
+            {
+                juce::FileOutputStream out (file);
+
+                if (! out.openedOk() || ! out.setPosition (kRegionBytes - 1) || ! out.writeByte (0))
+                    return false;
+            }
+
+            mapping = std::make_unique<juce::MemoryMappedFile> (file, juce::Range<juce::int64> (0, kRegionBytes),
+                                                                juce::MemoryMappedFile::readWrite);
+
+            if (mapping->getData() == nullptr)
+            {
+                close();
+                return false;
+            }
+
+            auto* base = mapping->getData();
+            std::memset (base, 0, (size_t) kRegionBytes);
+
+            auto& header             = getHeader (base);
+            header.version           = kVersion;
+            header.slotBytes         = (juce::uint32) kSlotBytes;
+            header.capacity          = (juce::uint32) kCapacity;
+            header.semitonesPerUnitX = semitonesPerUnitX;
+            header.maxFingers        = (juce::uint32) ControlFrame::kMaxFingers;
+            header.heartbeatMs.store (juce::Time::currentTimeMillis());
+            std::atomic_thread_fence (std::memory_order_release);
+            header.magic             = kMagic;
+            return true;
+        }
+
+        void close()
+        {
+            if (mapping == nullptr)
+                return;
+
+            mapping.reset();
+            file.deleteFile();
+            file = {};
+        }
+
+        void publish (const ControlFrame& newFrame) noexcept
+        {
+            if (mapping == nullptr)
+                return;
+
+            auto*      base  = mapping->getData();
+            auto&      header = getHeader (base);
+            const auto n     = header.framesPublished.load (std::memory_order_relaxed);
+            auto&      slot  = getSlot (base, n);
+
+            slot.sequence.store (2 * n + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_release);
+            std::memcpy (&slot.frame, &newFrame, sizeof (ControlFrame));
+            slot.sequence.store (2 * n + 2, std::memory_order_release);
+
+            header.framesPublished.store (n + 1, std::memory_order_release);
+            header.heartbeatMs.store (juce::Time::currentTimeMillis(), std::memory_order_relaxed);
+        }
+
+    private:
+        juce::File                              file;
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+
+        JUCE_DECLARE_NON_COPYABLE (Writer)
+    };
+};
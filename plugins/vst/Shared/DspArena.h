@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+    DspArena.h  –  One pre-faulted, cache-line-aligned block for a processor's
+                   DSP buffers
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Buffers sized in prepareToPlay() used to come from wherever their owner
+    allocated them: a HeapBlock here, a vector there.  Memory the allocator
+    hands out isn't backed until it's first written, so the first block
+    after a prepare paid a page fault per fresh page on the audio thread.
+    An arena lays every buffer out in one allocation, writes all of it once
+    on the message thread, and optionally locks it into RAM:
+
+        dspArena.build ([this, blockSize] (DspArena& arena)
+        {
+            scratch = arena.allocate<float> ((size_t) blockSize);
+            for (auto* voice : voices)
+                voice->allocate (arena, blockSize);
+        });
+
+    build() runs the function twice: once to measure (every allocate()
+    returns nullptr), then again over the real block, so the function must
+    only store the pointers it's given and ask for the same sizes both
+    times.  Slices start on a 64-byte line, so neither SIMD loads nor two
+    threads' buffers straddle one.  Every slice comes back zeroed.
+
+    Rebuilding frees the previous block, so only call build() while nothing
+    is processing (prepareToPlay(), or a suspended processor).
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <type_traits>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD || JUCE_ANDROID || JUCE_IOS
+ #include <sys/mman.h>
+#endif
+
+class DspArena
+{
+public:
+    static constexpr size_t kAlignment = 64;
+
+    DspArena() = default;
+    ~DspArena() { release(); }
+
+    /** Also lock the block into RAM (mlock), so it can't be paged out
+        under memory pressure.  Best effort, and POSIX only: isLocked()
+        says whether it took.  Applies from the next build(). */
+    void setLockInMemory (bool shouldLock) noexcept { lockInMemory = shouldLock; }
+
+    /** Lays out, allocates and pre-faults the block; see the header.
+        Message thread, while nothing is processing. */
+    template <typename CarveFn>
+    void build (CarveFn&& carve)
+    {
+        release();
+
+        measuring = true;
+        used      = 0;
+        carve (*this);
+
+        capacity = used;
+        storage.calloc (capacity + kAlignment);
+        base = reinterpret_cast<char*> ((reinterpret_cast<juce::pointer_sized_uint> (storage.get()) + kAlignment - 1)
+                                        & ~(juce::pointer_sized_uint) (kAlignment - 1));
+        preFault();
+
+        if (lockInMemory && capacity > 0)
+            locked = lockPages (base, capacity);
+
+        measuring = false;
+        used      = 0;
+        carve (*this);
+
+        jassert (used == capacity);   // the second pass asked for something else
+    }
+
+    /** count Ts, zeroed, on a line of their own.  Only from build()'s
+        function; nullptr while measuring. */
+    template <typename T>
+    T* allocate (size_t count) noexcept
+    {
+        static_assert (std::is_trivially_destructible_v<T>, "the arena never runs destructors");
+        static_assert (alignof (T) <= kAlignment);
+
+        const auto offset = used;
+        used = (used + sizeof (T) * count + kAlignment - 1) & ~(kAlignment - 1);
+
+        if (measuring)
+            return nullptr;
+
+        jassert (used <= capacity);
+        return reinterpret_cast<T*> (base + offset);
+    }
+
+    /** Frees the block; every slice handed out is gone. */
+    void release() noexcept
+    {
+        if (locked)
+            unlockPages (base, capacity);
+
+        storage.free();
+        base     = nullptr;
+        capacity = 0;
+        locked   = false;
+    }
+
+    size_t getSize() const noexcept  { return capacity; }
+    bool   isLocked() const noexcept { return locked; }
+
+private:
+    /** One write per page: a large calloc() hands back untouched zero
+        pages, each faulted in on its first write.  4 KiB is the smallest
+        page anywhere; larger pages just take several writes. */
+    void preFault() noexcept
+    {
+        constexpr size_t pageSize = 4096;
+
+        for (size_t offset = 0; offset < capacity; offset += pageSize)
+            reinterpret_cast<volatile char*> (base)[offset] = 0;
+    }
+
+    static bool lockPages (void* address, size_t size) noexcept
+    {
+       #if JUCE_LINUX || JUCE_MAC || JUCE_BSD || JUCE_ANDROID || JUCE_IOS
+        return mlock (address, size) == 0;
+       #else
+        juce::ignoreUnused (address, size);
+        return false;
+       #endif
+    }
+
+    static void unlockPages (void* address, size_t size) noexcept
+    {
+       #if JUCE_LINUX || JUCE_MAC || JUCE_BSD || JUCE_ANDROID || JUCE_IOS
+        munlock (address, size);
+       #else
+        juce::ignoreUnused (address, size);
+       #endif
+    }
+
+    juce::HeapBlock<char> storage;
+    char*                 base         = nullptr;   // storage, rounded up to kAlignment
+    size_t                capacity     = 0;
+    size_t                used         = 0;
+    bool                  measuring    = false;
+    bool                  lockInMemory = false;
+    bool                  locked       = false;
+
+    JUCE_DECLARE_NON_COPYABLE (DspArena)
+};
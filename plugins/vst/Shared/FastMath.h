@@ -0,0 +1,255 @@
+/*
+  ==============================================================================
+    FastMath.h  –  Branch-free approximations of exp2, log2, sin and tanh
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    The std versions handle every input to the last bit, errno included, so
+    the compiler calls them one value at a time.  These are polynomials
+    over a range reduction built from adds, compares and bit moves, with
+    no branches and no library calls, so a loop over a block of them
+    vectorises, and one on its own is a few multiply-adds.
+
+    Each call site picks how close it needs to be:
+
+        const auto ratio = FastMath::exp2<FastMath::fine> (semitones / 12.0f);
+
+      exact    the std function, for checking a site against or going back
+      fine     close to float precision (bounds below); pitch, cutoffs
+      coarse   cheaper again, to half in tanh; meters, drawing, saturation
+
+    The worst errors over each documented domain, measured against double
+    precision by NewProjectMathBench, which fails if any is exceeded:
+
+                 domain               fine            coarse
+      exp2       [-126, 127]          2.5e-7 rel      7.6e-5 rel
+      log2       positive normals     1.5e-7 abs      5.7e-6 abs
+      sin        [-pi, pi]            2.4e-7 abs      6.8e-5 abs
+      tanh       all                  2.4e-7 abs      2.4e-2 abs
+
+    log2's bound is per unit of the result past 1: a float that large has
+    no finer steps.
+
+    Outside its domain exp2 saturates at 2^-126 and 2^127, and
+    log2 of zero, a negative or a denormal is garbage rather than -inf or
+    NaN.  sin reduces its argument in float, so beyond [-pi, pi] its error
+    grows by about |x| * 8e-8.  Coarse tanh is a clamped rational, exactly
+    +-1 from |x| = 3, and smooth everywhere, so it suits a saturator.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace FastMath
+{
+    enum Accuracy { exact, fine, coarse };
+
+    /** The documented bounds, for checking against. */
+    struct Bounds
+    {
+        static constexpr float exp2Fine   = 2.5e-7f, exp2Coarse = 7.6e-5f;   // relative
+        static constexpr float log2Fine   = 1.5e-7f, log2Coarse = 5.7e-6f;   // absolute, times max (1, |log2 x|)
+        static constexpr float sinFine    = 2.4e-7f, sinCoarse  = 6.8e-5f;   // absolute
+        static constexpr float tanhFine   = 2.4e-7f, tanhCoarse = 2.4e-2f;   // absolute
+    };
+
+    namespace detail
+    {
+        inline float         fromBits (juce::uint32 bits) noexcept { float x; std::memcpy (&x, &bits, sizeof (x)); return x; }
+        inline juce::uint32  toBits   (float x) noexcept           { juce::uint32 bits; std::memcpy (&bits, &x, sizeof (bits)); return bits; }
+
+        /** condition ? a : b as a bit mask.  GCC won't turn a float ?: (or
+            std::min) into a vector blend unless floating point can't trap,
+            which needs -fno-trapping-math, so the loop wouldn't vectorise. */
+        inline float select (bool condition, float a, float b) noexcept
+        {
+            const auto mask = 0u - (juce::uint32) condition;
+            return fromBits ((toBits (a) & mask) | (toBits (b) & ~mask));
+        }
+
+        inline float clamp (float x, float lowest, float highest) noexcept
+        {
+            return select (x < lowest, lowest, select (highest < x, highest, x));
+        }
+
+        /** Adding then subtracting 1.5 * 2^23 rounds |x| < 2^22 to the
+            nearest integer, which the sum holds in its low mantissa bits. */
+        static constexpr float kRoundingBias = 12582912.0f;
+    }
+
+    //==============================================================================
+    /** 2^x: the nearest integer straight into the exponent bits, what's
+        left through a minimax polynomial (degree 5, or 3 coarse) on
+        [-1/2, 1/2]. */
+    template <Accuracy accuracy = fine>
+    inline float exp2 (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+        {
+            return std::exp2 (x);
+        }
+        else
+        {
+            x = detail::clamp (x, -126.0f, 127.0f);
+
+            const auto biased = x + detail::kRoundingBias;
+            const auto f      = x - (biased - detail::kRoundingBias);
+            const auto scale  = detail::fromBits ((detail::toBits (biased) - 0x4b400000u + 127u) << 23);
+
+            if constexpr (accuracy == coarse)
+                return scale * (0.99992807f + f * (0.69326099f + f * (0.24261112f + f * 0.055171669f)));
+            else
+                return scale * (1.0000001f + f * (0.69314697f + f * (0.24022120f + f * (0.055507133f
+                                           + f * (0.0096755413f + f * 0.0013276472f)))));
+        }
+    }
+
+    /** e^x, through exp2(). */
+    template <Accuracy accuracy = fine>
+    inline float exp (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+            return std::exp (x);
+        else
+            return exp2<accuracy> (x * 1.4426950409f);
+    }
+
+    /** log2(x) for positive normal x: the exponent bits, plus the mantissa
+        moved into [sqrt 1/2, sqrt 2) and through the odd series of atanh in
+        s = (m - 1) / (m + 1), fitted minimax (to s^5, or s^3 coarse). */
+    template <Accuracy accuracy = fine>
+    inline float log2 (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+        {
+            return std::log2 (x);
+        }
+        else
+        {
+            const auto bits  = detail::toBits (x);
+            const auto m1    = detail::fromBits ((bits & 0x007fffffu) | 0x3f800000u);   // 1 … 2
+            const auto upper = (int) (m1 > 1.41421356f);
+            const auto e     = (float) ((int) (bits >> 23) - 127 + upper);
+            const auto m     = m1 * (1.0f - 0.5f * (float) upper);
+
+            const auto s = (m - 1.0f) / (m + 1.0f);
+            const auto u = s * s;
+
+            if constexpr (accuracy == coarse)
+                return e + s * (2.8852286f + u * 0.98353451f);
+            else
+                return e + s * (2.8853913f + u * (0.96147081f + u * 0.59897389f));
+        }
+    }
+
+    /** sin(x) in radians: x reduced to a quarter turn either side of 0 and
+        an odd minimax polynomial (to x^9, or x^5 coarse) over that. */
+    template <Accuracy accuracy = fine>
+    inline float sin (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+        {
+            return std::sin (x);
+        }
+        else
+        {
+            // Turns, to -1/2 … 1/2, then folded about ±1/4 (sin(pi - x) = sin x)
+            auto r = x * 0.15915494f;
+            r -= (r + detail::kRoundingBias) - detail::kRoundingBias;
+
+            const auto a = std::abs (r);
+            const auto q = std::copysign (detail::select (0.5f - a < a, 0.5f - a, a), r);
+            const auto u = q * q;
+
+            if constexpr (accuracy == coarse)
+                return q * (6.2812801f + u * (-41.095243f + u * 73.585515f));
+            else
+                return q * (6.2831852f + u * (-41.341655f + u * (81.601004f + u * (-76.549782f + u * 39.536706f))));
+        }
+    }
+
+    /** cos(x) in radians, as sin(x + pi/2). */
+    template <Accuracy accuracy = fine>
+    inline float cos (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+            return std::cos (x);
+        else
+            return sin<accuracy> (x + 1.5707963f);
+    }
+
+    /** tanh(x): (e^2x - 1) / (e^2x + 1) through exp2(), or coarse the
+        rational x (27 + x^2) / (27 + 9 x^2), which reaches ±1 at |x| = 3
+        with zero slope, clamped there. */
+    template <Accuracy accuracy = fine>
+    inline float tanh (float x) noexcept
+    {
+        if constexpr (accuracy == exact)
+        {
+            return std::tanh (x);
+        }
+        else if constexpr (accuracy == coarse)
+        {
+            x = detail::clamp (x, -3.0f, 3.0f);
+            const auto x2 = x * x;
+            return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+        }
+        else
+        {
+            // Past ±9 tanh rounds to ±1 in float
+            const auto e = exp2<fine> (detail::clamp (x, -9.0f, 9.0f) * 2.8853901f);
+            return (e - 1.0f) / (e + 1.0f);
+        }
+    }
+
+    //==============================================================================
+    /** Semitones to a frequency ratio, and the ratio back. */
+    template <Accuracy accuracy = fine>
+    inline float semitonesToRatio (float semitones) noexcept { return exp2<accuracy> (semitones * (1.0f / 12.0f)); }
+
+    template <Accuracy accuracy = fine>
+    inline float ratioToSemitones (float ratio) noexcept     { return 12.0f * log2<accuracy> (ratio); }
+
+    /** MIDI note (fractional) to Hz and back, A4 = 440 Hz. */
+    template <Accuracy accuracy = fine>
+    inline float midiToHz (float note) noexcept { return 440.0f * semitonesToRatio<accuracy> (note - 69.0f); }
+
+    template <Accuracy accuracy = fine>
+    inline float hzToMidi (float hz) noexcept   { return 69.0f + ratioToSemitones<accuracy> (hz * (1.0f / 440.0f)); }
+
+    //==============================================================================
+    /** The same over a block, dest[i] = f (source[i]); in place is fine.
+        Loops the compiler vectorises, where the std functions can't. */
+    template <Accuracy accuracy = fine>
+    inline void exp2 (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = exp2<accuracy> (source[i]);
+    }
+
+    template <Accuracy accuracy = fine>
+    inline void log2 (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = log2<accuracy> (source[i]);
+    }
+
+    template <Accuracy accuracy = fine>
+    inline void sin (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = sin<accuracy> (source[i]);
+    }
+
+    template <Accuracy accuracy = fine>
+    inline void tanh (float* dest, const float* source, int numValues) noexcept
+    {
+        for (int i = 0; i < numValues; ++i)
+            dest[i] = tanh<accuracy> (source[i]);
+    }
+}
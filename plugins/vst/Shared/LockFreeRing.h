@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+    LockFreeRing.h  –  Generic single-producer / single-consumer ring buffer
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Unlike juce::AbstractFifo, the producer and consumer indices live on
+    separate cache lines, and each side keeps a cached copy of the other's
+    index.  It only re-reads the shared index when the cached one says the
+    ring is full (producer) or empty (consumer), so in steady state neither
+    core touches the other's line.  Indices increase monotonically and are
+    masked with Capacity − 1, so every one of the Capacity slots is usable.
+
+    No locks and no heap allocation; T should be trivially copyable.
+
+    Health telemetry: pushed / dropped counts and the high-water mark are
+    kept by the producer with relaxed atomics and can be read from any
+    thread (getStats()).  With OverflowPolicy::overwriteOldest a full ring
+    discards its oldest item instead of the new one, so a consumer that was
+    stalled resumes on the newest data.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template <typename T, int Capacity>
+class LockFreeRing
+{
+public:
+    static_assert (Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                   "LockFreeRing capacity must be a power of two");
+
+    static constexpr int kCapacity = Capacity;
+
+    /** What push() does when the ring is full. */
+    enum class OverflowPolicy
+    {
+        dropNewest,        ///< Keep what's queued, discard the new item (default)
+        overwriteOldest    ///< Discard the oldest queued item to make room
+    };
+
+    struct Stats
+    {
+        juce::uint64 pushed        { 0 };   ///< Items offered to push() / pushBlock()
+        juce::uint64 dropped       { 0 };   ///< Items lost to overflow, under either policy
+        int          highWaterMark { 0 };   ///< Largest fill level seen since the last reset
+    };
+
+    LockFreeRing() = default;
+
+    /** Only change while neither side is running (e.g. in a constructor). */
+    void           setOverflowPolicy (OverflowPolicy p) noexcept { policy = p; }
+    OverflowPolicy getOverflowPolicy ()           const noexcept { return policy; }
+
+    // ── Producer ──────────────────────────────────────────────────────────────
+
+    /** Enqueues one item.  Returns false when it was dropped (dropNewest and
+        the ring is full); with overwriteOldest it always succeeds. */
+    bool push (const T& item) noexcept
+    {
+        return pushBlock (&item, 1) == 1;
+    }
+
+    /** Enqueues up to num items.  With dropNewest the ones that don't fit are
+        dropped; with overwriteOldest the oldest queued items make room (only
+        the newest Capacity of `items` survive if num > Capacity).  Returns
+        how many were queued. */
+    int pushBlock (const T* items, int num) noexcept
+    {
+        pushedCount.store (pushedCount.load (std::memory_order_relaxed) + (juce::uint64) num,
+                           std::memory_order_relaxed);
+
+        const size_t w = writeIndex.load (std::memory_order_relaxed);
+
+        if (w - cachedReadIndex + (size_t) num > (size_t) Capacity)
+            cachedReadIndex = readIndex.load (std::memory_order_acquire);
+
+        int free = Capacity - static_cast<int> (w - cachedReadIndex);
+
+        if (num > free && policy == OverflowPolicy::overwriteOldest)
+        {
+            if (num > Capacity)
+            {
+                addDropped (num - Capacity);
+                items += num - Capacity;
+                num    = Capacity;
+            }
+
+            free = reclaimOldest (w, num - free);
+        }
+
+        const int n   = juce::jmin (num, free);
+        const int pos = static_cast<int> (w & kMask);
+        const int n1  = juce::jmin (n, Capacity - pos);
+
+        std::copy (items,      items + n1, slots.begin() + pos);
+        std::copy (items + n1, items + n,  slots.begin());
+
+        writeIndex.store (w + (size_t) n, std::memory_order_release);
+
+        addDropped (num - n);
+        updateHighWaterMark (w + (size_t) n);
+        return n;
+    }
+
+    // ── Consumer ──────────────────────────────────────────────────────────────
+
+    /** Dequeues the oldest item.  Returns false when the ring is empty. */
+    bool pop (T& out) noexcept
+    {
+        return popAll ([&out] (const T* items, int) { out = items[0]; }, 1) == 1;
+    }
+
+    /** Drains everything currently queued without copying: calls
+        consume (const T* items, int num) once per contiguous segment (at most
+        twice), oldest first, then releases them all at once.  Returns the
+        total consumed.  The pointers are only valid inside the callback.
+
+        With overwriteOldest the producer may also advance the read index, so
+        the items are claimed (CAS) before the callback runs.  Claimed slots
+        count as free again, so if the ring was full and the producer pushes
+        while the callback is running, the oldest slots being read can be
+        overwritten in the meantime.  Fine for a display drain (microseconds
+        per call against milliseconds per point), not for lossless transfer. */
+    template <typename Consumer>
+    int popAll (Consumer&& consume, int maxItems = Capacity)
+    {
+        size_t r = readIndex.load (std::memory_order_acquire);
+        int    n;
+
+        if (policy == OverflowPolicy::overwriteOldest)
+        {
+            do
+            {
+                cachedWriteIndex = writeIndex.load (std::memory_order_acquire);
+                n = juce::jmin (maxItems, static_cast<int> (cachedWriteIndex - r));
+            }
+            while (n > 0 && ! readIndex.compare_exchange_weak (r, r + (size_t) n,
+                                                               std::memory_order_acq_rel,
+                                                               std::memory_order_acquire));
+        }
+        else
+        {
+            if (r + (size_t) maxItems > cachedWriteIndex)
+                cachedWriteIndex = writeIndex.load (std::memory_order_acquire);
+
+            n = juce::jmin (maxItems, static_cast<int> (cachedWriteIndex - r));
+        }
+
+        const int pos = static_cast<int> (r & kMask);
+        const int n1  = juce::jmin (n, Capacity - pos);
+
+        if (n1 > 0)     consume (slots.data() + pos, n1);
+        if (n - n1 > 0) consume (slots.data(), n - n1);
+
+        if (policy == OverflowPolicy::dropNewest)
+            readIndex.store (r + (size_t) n, std::memory_order_release);
+
+        return n;
+    }
+
+    // ── Either side ───────────────────────────────────────────────────────────
+
+    /** Items queued right now (a snapshot: the other side may be moving). */
+    int numReady() const noexcept
+    {
+        return static_cast<int> (writeIndex.load (std::memory_order_acquire)
+                                  - readIndex.load (std::memory_order_acquire));
+    }
+
+    /** Telemetry snapshot; safe from any thread (each field is read
+        separately, so they may be a few items apart). */
+    Stats getStats() const noexcept
+    {
+        Stats stats;
+        stats.pushed        = pushedCount   .load (std::memory_order_relaxed);
+        stats.dropped       = droppedCount  .load (std::memory_order_relaxed);
+        stats.highWaterMark = highWaterMark .load (std::memory_order_relaxed);
+        return stats;
+    }
+
+    /** Not thread-safe: only call while neither side is running. */
+    void resetStats() noexcept
+    {
+        pushedCount  .store (0);
+        droppedCount .store (0);
+        highWaterMark.store (0);
+    }
+
+    /** Not thread-safe: only call while neither side is running.  Also
+        clears the stats. */
+    void reset() noexcept
+    {
+        writeIndex.store (0);
+        readIndex .store (0);
+        cachedReadIndex  = 0;
+        cachedWriteIndex = 0;
+        resetStats();
+    }
+
+private:
+    /** overwriteOldest: advances the read index by up to `wanted` items on
+        the consumer's behalf.  Returns the free space afterwards. */
+    int reclaimOldest (size_t w, int wanted) noexcept
+    {
+        size_t r = cachedReadIndex;
+
+        for (;;)
+        {
+            const int used    = static_cast<int> (w - r);
+            const int discard = juce::jmin (wanted, used);
+
+            if (readIndex.compare_exchange_weak (r, r + (size_t) discard,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+            {
+                cachedReadIndex = r + (size_t) discard;
+                addDropped (discard);
+                return Capacity - (used - discard);
+            }
+            // r now holds the consumer's latest index: it freed some space itself.
+            wanted = juce::jmax (0, wanted - static_cast<int> (r - cachedReadIndex));
+            cachedReadIndex = r;
+        }
+    }
+
+    void addDropped (int num) noexcept
+    {
+        if (num > 0)
+            droppedCount.store (droppedCount.load (std::memory_order_relaxed) + (juce::uint64) num,
+                                std::memory_order_relaxed);
+    }
+
+    /** Only refreshes the (stale, hence pessimistic) cached read index when
+        the estimate exceeds the current mark, so it costs a shared read once
+        every few hundred pushes at most. */
+    void updateHighWaterMark (size_t newWriteIndex) noexcept
+    {
+        const int mark = highWaterMark.load (std::memory_order_relaxed);
+
+        if (static_cast<int> (newWriteIndex - cachedReadIndex) <= mark)
+            return;
+
+        cachedReadIndex = readIndex.load (std::memory_order_acquire);
+        const int fill  = static_cast<int> (newWriteIndex - cachedReadIndex);
+
+        if (fill > mark)
+            highWaterMark.store (fill, std::memory_order_relaxed);
+    }
+
+   #if JUCE_ARM && JUCE_MAC
+    static constexpr size_t kCacheLineSize = 128;   // Apple silicon
+   #else
+    static constexpr size_t kCacheLineSize = 64;
+   #endif
+
+    static constexpr size_t kMask = (size_t) Capacity - 1;
+
+    OverflowPolicy policy { OverflowPolicy::dropNewest };
+
+    // Producer line: its own index, its view of the consumer's, and the
+    // counters only it writes.
+    alignas (kCacheLineSize) std::atomic<size_t> writeIndex { 0 };
+    size_t                                       cachedReadIndex { 0 };
+    std::atomic<juce::uint64>                    pushedCount     { 0 };
+    std::atomic<juce::uint64>                    droppedCount    { 0 };
+    std::atomic<int>                             highWaterMark   { 0 };
+
+    // Consumer line.
+    alignas (kCacheLineSize) std::atomic<size_t> readIndex { 0 };
+    size_t                                       cachedWriteIndex { 0 };
+
+    alignas (kCacheLineSize) std::array<T, (size_t) Capacity> slots {};
+
+    JUCE_DECLARE_NON_COPYABLE (LockFreeRing)
+};
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+    MidiEventFifo.h  –  Wait-free MIDI hand-off to the audio thread
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Stands in for juce::MidiMessageCollector, whose CriticalSection the
+    audio thread shares with whichever thread adds messages.  At hand
+    tracking's controller rates (pitch bend and CC74 per finger per camera
+    frame) the audio thread kept waiting on a lower-priority MIDI thread.
+
+    Here the producer stamps each short message on the
+    Time::getMillisecondCounterHiRes() clock (the one juce::MidiInput
+    already uses) and pushes it into a LockFreeRing.  Once per block the
+    audio thread drains the ring and places every event at the sample it
+    fell on within the block that just elapsed, as the collector did, so
+    timing jitter stays under a block.
+
+    Single producer: give every source (a MIDI input, the on-screen
+    keyboard) its own fifo.  SysEx and other long messages are dropped.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+#include "LockFreeRing.h"
+
+class MidiEventFifo  : public juce::MidiInputCallback
+{
+public:
+    static constexpr int kCapacity = 2048;
+
+    /** One short message and when it arrived. */
+    struct Event
+    {
+        double      timeSeconds;   // Time::getMillisecondCounterHiRes() * 0.001
+        juce::uint8 data[3];
+        juce::uint8 size;
+    };
+
+    using Stats = LockFreeRing<Event, kCapacity>::Stats;
+
+    // ── Producer ──────────────────────────────────────────────────────────────
+
+    /** Queues a message stamped with its own timestamp, in seconds on the
+        high-resolution millisecond clock.  Returns false if it was dropped
+        (fifo full, or not a short message). */
+    bool push (const juce::MidiMessage& message) noexcept
+    {
+        const auto size = message.getRawDataSize();
+
+        if (size <= 0 || size > 3 || message.isSysEx())
+            return false;
+
+        Event event { message.getTimeStamp(), {}, (juce::uint8) size };
+        std::copy (message.getRawData(), message.getRawData() + size, event.data);
+        return ring.push (event);
+    }
+
+    /** As push(), stamped with the time now, for sources whose messages
+        carry no timestamp of their own. */
+    bool pushNow (juce::MidiMessage message) noexcept
+    {
+        message.setTimeStamp (juce::Time::getMillisecondCounterHiRes() * 0.001);
+        return push (message);
+    }
+
+    /** juce::MidiInput stamps its messages on the same clock. */
+    void handleIncomingMidiMessage (juce::MidiInput*, const juce::MidiMessage& message) override
+    {
+        push (message);
+    }
+
+    // ── Consumer ──────────────────────────────────────────────────────────────
+
+    /** Before the first block; drops anything queued while stopped. */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        ring.popAll ([] (const Event*, int) {});
+    }
+
+    /** Adds everything queued to `buffer`, each event at its offset in a
+        block of numSamples ending now; anything older goes at the start.
+        Audio thread, once per block. */
+    void removeNextBlockOfMessages (juce::MidiBuffer& buffer, int numSamples) noexcept
+    {
+        const auto blockStart = juce::Time::getMillisecondCounterHiRes() * 0.001 - numSamples / sampleRate;
+        const auto lastSample = juce::jmax (0, numSamples - 1);
+
+        ring.popAll ([&] (const Event* events, int num)
+        {
+            for (int i = 0; i < num; ++i)
+            {
+                const auto& event  = events[i];
+                const auto  offset = juce::jlimit (0, lastSample, (int) ((event.timeSeconds - blockStart) * sampleRate));
+
+                buffer.addEvent (event.data, event.size, offset);
+            }
+        });
+    }
+
+    /** Pushed / dropped counts and the high-water mark; any thread. */
+    Stats getStats() const noexcept { return ring.getStats(); }
+
+private:
+    LockFreeRing<Event, kCapacity> ring;
+    double                         sampleRate = 44100.0;
+};
@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+    PerfProbe.h  –  Per-instance CPU load histograms for the audio thread
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Each named scope (the whole block, "yin", "voices", "reverb", ...) records
+    how long it took and its load: that time over the real-time deadline of
+    the samples it processed.  Loads land in fixed histogram buckets, so the
+    editor can read p50 / p99 for this plugin instance rather than relying
+    on the host's single global meter.
+
+    Recording is a few relaxed fetch_adds on the scope's own cache line: no
+    locks, no allocation, nothing but the high-resolution tick counter.  Any
+    thread may record (a worker can account for analysis it does on the
+    audio thread's behalf) and any thread may read.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+class PerfProbe
+{
+public:
+    static constexpr int    kMaxScopes       = 8;
+    static constexpr int    kNumLoadBuckets  = 64;
+    static constexpr double kLoadBucketWidth = 1.0 / 32.0;   // 0 … 200 % in 3.125 % steps;
+                                                             // the last bucket also takes anything slower
+
+    /** Everything one scope has recorded since the last reset. */
+    struct Summary
+    {
+        juce::uint64 count      { 0 };     ///< Measurements recorded
+        juce::uint64 overruns   { 0 };     ///< Measurements that missed their deadline (load >= 1)
+        double       meanMicros { 0.0 };
+        double       maxMicros  { 0.0 };
+        double       meanLoad   { 0.0 };   ///< Total time / total deadline
+        double       p50Load    { 0.0 };   ///< Upper edge of the median's bucket
+        double       p99Load    { 0.0 };   ///< Upper edge of the 99th percentile's bucket
+
+        std::array<juce::uint64, kNumLoadBuckets> loadBuckets {};
+    };
+
+    PerfProbe() noexcept { prepare (44100.0); }
+
+    /** Registers a scope and returns its id.  Only before processing starts
+        (e.g. from a member initialiser); the name must outlive the probe, so
+        pass a string literal. */
+    int addScope (const char* name) noexcept
+    {
+        jassert (numScopes < kMaxScopes);
+
+        if (numScopes >= kMaxScopes)
+            return -1;
+
+        scopes[(size_t) numScopes].name = name;
+        return numScopes++;
+    }
+
+    int         getNumScopes ()            const noexcept { return numScopes; }
+    const char* getScopeName (int scopeId) const noexcept { return scopes[(size_t) scopeId].name; }
+
+    /** Sets the rate deadlines are worked out at.  Call from prepareToPlay(),
+        while nothing is recording. */
+    void prepare (double sampleRate) noexcept
+    {
+        ticksPerSample = static_cast<double> (juce::Time::getHighResolutionTicksPerSecond()) / sampleRate;
+    }
+
+    // ── Recording ─────────────────────────────────────────────────────────────
+
+    /** Records one measurement: elapsedTicks spent on numSamples samples. */
+    void record (int scopeId, juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        if (! juce::isPositiveAndBelow (scopeId, numScopes) || numSamples <= 0)
+            return;
+
+        auto&        s      = scopes[(size_t) scopeId];
+        const double load   = static_cast<double> (elapsedTicks) / (numSamples * ticksPerSample);
+        const int    bucket = juce::jlimit (0, kNumLoadBuckets - 1, static_cast<int> (load / kLoadBucketWidth));
+
+        s.loadBuckets[(size_t) bucket].fetch_add (1, std::memory_order_relaxed);
+        s.count       .fetch_add (1,                             std::memory_order_relaxed);
+        s.totalTicks  .fetch_add ((juce::uint64) elapsedTicks,   std::memory_order_relaxed);
+        s.totalSamples.fetch_add ((juce::uint64) numSamples,     std::memory_order_relaxed);
+        s.latestLoad  .store ((float) load,                      std::memory_order_relaxed);
+
+        auto previousMax = s.maxTicks.load (std::memory_order_relaxed);
+        while (elapsedTicks > previousMax
+               && ! s.maxTicks.compare_exchange_weak (previousMax, elapsedTicks, std::memory_order_relaxed))
+        {}
+    }
+
+    /** Measures from construction to destruction:
+        const PerfProbe::Scope timer (probe, yinScope, numSamples); */
+    class Scope
+    {
+    public:
+        Scope (PerfProbe& probeToUse, int scopeIdToUse, int numSamplesToCover) noexcept
+            : probe (probeToUse), scopeId (scopeIdToUse), numSamples (numSamplesToCover),
+              startTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~Scope() noexcept
+        {
+            probe.record (scopeId, juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+        }
+
+    private:
+        PerfProbe&        probe;
+        const int         scopeId;
+        const int         numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+    // ── Reading ───────────────────────────────────────────────────────────────
+
+    /** Snapshot of one scope; safe from any thread.  The fields are read one
+        by one, so a measurement recorded meanwhile may be half-counted. */
+    Summary getSummary (int scopeId) const noexcept
+    {
+        Summary summary;
+
+        if (! juce::isPositiveAndBelow (scopeId, numScopes))
+            return summary;
+
+        const auto& s = scopes[(size_t) scopeId];
+
+        for (int b = 0; b < kNumLoadBuckets; ++b)
+        {
+            summary.loadBuckets[(size_t) b] = s.loadBuckets[(size_t) b].load (std::memory_order_relaxed);
+            summary.count += summary.loadBuckets[(size_t) b];
+
+            if (b * kLoadBucketWidth >= 1.0)
+                summary.overruns += summary.loadBuckets[(size_t) b];
+        }
+
+        if (summary.count == 0)
+            return summary;
+
+        const double ticksPerMicro = static_cast<double> (juce::Time::getHighResolutionTicksPerSecond()) / 1.0e6;
+        const auto   totalTicks    = static_cast<double> (s.totalTicks  .load (std::memory_order_relaxed));
+        const auto   totalSamples  = static_cast<double> (s.totalSamples.load (std::memory_order_relaxed));
+        const auto   numRecorded   = static_cast<double> (s.count       .load (std::memory_order_relaxed));
+
+        summary.meanMicros = numRecorded > 0.0 ? totalTicks / numRecorded / ticksPerMicro : 0.0;
+        summary.maxMicros  = static_cast<double> (s.maxTicks.load (std::memory_order_relaxed)) / ticksPerMicro;
+        summary.meanLoad   = totalSamples > 0.0 ? totalTicks / (totalSamples * ticksPerSample) : 0.0;
+        summary.p50Load    = percentileLoad (summary, 0.50);
+        summary.p99Load    = percentileLoad (summary, 0.99);
+        return summary;
+    }
+
+    /** The load of the scope's last measurement, 0 before the first; safe
+        from any thread.  What a QualityGovernor follows. */
+    float getLatestLoad (int scopeId) const noexcept
+    {
+        return juce::isPositiveAndBelow (scopeId, numScopes)
+                 ? scopes[(size_t) scopeId].latestLoad.load (std::memory_order_relaxed)
+                 : 0.0f;
+    }
+
+    /** Clears every scope's histogram (the scopes stay registered).  Safe
+        from any thread, with the same half-counting caveat as getSummary(). */
+    void reset() noexcept
+    {
+        for (auto& s : scopes)
+        {
+            for (auto& bucket : s.loadBuckets)
+                bucket.store (0, std::memory_order_relaxed);
+
+            s.count       .store (0, std::memory_order_relaxed);
+            s.totalTicks  .store (0, std::memory_order_relaxed);
+            s.totalSamples.store (0, std::memory_order_relaxed);
+            s.maxTicks    .store (0, std::memory_order_relaxed);
+            s.latestLoad  .store (0.0f, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static double percentileLoad (const Summary& summary, double fraction) noexcept
+    {
+        const auto   target     = static_cast<juce::uint64> (std::ceil (fraction * static_cast<double> (summary.count)));
+        juce::uint64 cumulative = 0;
+
+        for (int b = 0; b < kNumLoadBuckets; ++b)
+        {
+            cumulative += summary.loadBuckets[(size_t) b];
+
+            if (cumulative >= target)
+                return (b + 1) * kLoadBucketWidth;
+        }
+
+        return kNumLoadBuckets * kLoadBucketWidth;
+    }
+
+   #if JUCE_ARM && JUCE_MAC
+    static constexpr size_t kCacheLineSize = 128;   // Apple silicon
+   #else
+    static constexpr size_t kCacheLineSize = 64;
+   #endif
+
+    // One cache line (or a few) per scope, so a worker recording "yin" never
+    // contends with the audio thread recording the block.
+    struct alignas (kCacheLineSize) ScopeData
+    {
+        const char*                                           name         { nullptr };
+        std::atomic<juce::uint64>                             count        { 0 };
+        std::atomic<juce::uint64>                             totalTicks   { 0 };
+        std::atomic<juce::uint64>                             totalSamples { 0 };
+        std::atomic<juce::int64>                              maxTicks     { 0 };
+        std::atomic<float>                                    latestLoad   { 0.0f };
+        std::array<std::atomic<juce::uint64>, kNumLoadBuckets> loadBuckets  {};
+    };
+
+    std::array<ScopeData, kMaxScopes> scopes;
+    int                               numScopes      { 0 };
+    double                            ticksPerSample { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE (PerfProbe)
+};
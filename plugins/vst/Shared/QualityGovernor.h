@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+    QualityGovernor.h  –  Latency-budget-aware quality levels for one instance
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Each plugin maps a level onto its own cost knobs: level 0 is the quality
+    it was set to, and every level above it is cheaper (PFix a longer hop,
+    NewProject the FDN reverb and then fewer voices, AutoTunes fewer
+    detections).  At the start of every live block the audio thread calls
+    update() with the instance's PerfProbe, whose "block" scope holds the
+    load of the block before: its time over the buffer's deadline.
+
+    Hysteresis keeps it from hunting.  The load is one-pole smoothed; above
+    stepDownLoad, or on any block that missed its deadline, it sheds a level
+    and then holds for holdSeconds so the cheaper level's load can show.  A
+    level only comes back after recoverySeconds spent below stepUpLoad.  An
+    overloaded session so settles every instance on its own rather than
+    being hand-tuned one by one.
+
+    update() is a few float operations and never blocks.  Every change it
+    makes is pushed onto a LockFreeRing, and written to juce::Logger from
+    the message thread, tagged with the instance's name.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include "LockFreeRing.h"
+#include "PerfProbe.h"
+#include <atomic>
+
+class QualityGovernor  : private juce::Timer
+{
+public:
+    struct Settings
+    {
+        float  stepDownLoad    = 0.75f;   // smoothed load above which a level is shed
+        float  stepUpLoad      = 0.5f;    // and below which one is given back
+        float  smoothing       = 0.2f;    // per block
+        double holdSeconds     = 0.25;    // after a step down, before the next
+        double recoverySeconds = 2.0;     // under stepUpLoad before a step up
+    };
+
+    /** One level change, as logged. */
+    struct Change
+    {
+        int   fromLevel = 0, toLevel = 0;
+        float load      = 0.0f;   // smoothed, when it was made
+    };
+
+    static constexpr int kLogIntervalMs = 500;
+
+    /** name tags the log lines; pass a string literal.  numLevels counts
+        level 0, so 1 never governs anything.  Message thread. */
+    QualityGovernor (const char* instanceName, int numLevelsToUse, Settings settingsToUse = {})
+        : name (instanceName), numLevels (juce::jmax (1, numLevelsToUse)), settings (settingsToUse)
+    {
+        startTimer (kLogIntervalMs);
+    }
+
+    ~QualityGovernor() override { stopTimer(); }
+
+    /** Back to level 0, with the hold and recovery worked out for
+        sampleRate.  Call from prepareToPlay(), while nothing is processing. */
+    void prepare (double sampleRate) noexcept
+    {
+        holdSamples     = (juce::int64) (settings.holdSeconds     * sampleRate);
+        recoverySamples = (juce::int64) (settings.recoverySeconds * sampleRate);
+        smoothedLoad    = 0.0f;
+        holdRemaining   = 0;
+        samplesUnderLow = 0;
+        level.store (0);
+    }
+
+    /** Disabled, update() returns level 0.  Any thread. */
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled); }
+    bool isEnabled() const noexcept                 { return enabled.load(); }
+
+    int getNumLevels() const noexcept { return numLevels; }
+
+    /** The level the last update() chose.  Any thread. */
+    int getLevel() const noexcept { return level.load (std::memory_order_relaxed); }
+
+    /** Audio thread, at the start of a live block of numSamples: follows
+        the last measurement of probe's scopeId and returns the level this
+        block should render at. */
+    int update (const PerfProbe& probe, int scopeId, int numSamples) noexcept
+    {
+        auto current = level.load (std::memory_order_relaxed);
+
+        if (! enabled.load (std::memory_order_relaxed))
+        {
+            smoothedLoad    = 0.0f;
+            samplesUnderLow = 0;
+            return changeLevel (current, 0);
+        }
+
+        const auto load = probe.getLatestLoad (scopeId);
+        smoothedLoad += settings.smoothing * (load - smoothedLoad);
+        holdRemaining = juce::jmax ((juce::int64) 0, holdRemaining - numSamples);
+
+        if ((smoothedLoad > settings.stepDownLoad || load >= 1.0f) && holdRemaining == 0)
+        {
+            samplesUnderLow = 0;
+
+            if (current + 1 < numLevels)
+            {
+                holdRemaining = holdSamples;
+                current = changeLevel (current, current + 1);
+            }
+        }
+        else if (smoothedLoad < settings.stepUpLoad)
+        {
+            if ((samplesUnderLow += numSamples) >= recoverySamples && current > 0)
+            {
+                samplesUnderLow = 0;
+                current = changeLevel (current, current - 1);
+            }
+        }
+        else
+        {
+            samplesUnderLow = 0;
+        }
+
+        return current;
+    }
+
+    /** Changes made so far (some may still be waiting to be logged).  Any
+        thread. */
+    juce::uint64 getNumChanges() const noexcept { return changes.getStats().pushed; }
+
+private:
+    int changeLevel (int from, int to) noexcept
+    {
+        if (from != to)
+        {
+            level.store (to, std::memory_order_relaxed);
+            changes.push ({ from, to, smoothedLoad });
+        }
+
+        return to;
+    }
+
+    void timerCallback() override
+    {
+        Change change;
+
+        while (changes.pop (change))
+            juce::Logger::writeToLog (juce::String (name) + ": quality level " + juce::String (change.fromLevel)
+                                      + " -> " + juce::String (change.toLevel) + " at "
+                                      + juce::String (juce::roundToInt (change.load * 100.0f)) + "% load");
+    }
+
+    const char* const  name;
+    const int          numLevels;
+    const Settings     settings;
+    std::atomic<bool>  enabled { true };
+    std::atomic<int>   level   { 0 };
+
+    // Audio thread
+    float       smoothedLoad    = 0.0f;
+    juce::int64 holdSamples     = 0, recoverySamples = 0;
+    juce::int64 holdRemaining   = 0;   // samples before the next step down
+    juce::int64 samplesUnderLow = 0;
+
+    LockFreeRing<Change, 64> changes;   // audio thread → timerCallback()
+
+    JUCE_DECLARE_NON_COPYABLE (QualityGovernor)
+};
@@ -0,0 +1,358 @@
+/*
+  ==============================================================================
+    RealtimeSafety.h  –  Debug-build detector for allocations and blocking
+                         locks on the audio thread
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Every processBlock() marks itself with REALTIME_SAFETY_AUDIO_THREAD
+    ("name"), as does anything else that runs against the audio deadline
+    (NewProject's render workers).  While a thread is inside such a scope:
+
+      • operator new / delete report an allocation or deallocation.  Each
+        binary replaces them once, with REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS
+        in its PluginProcessor.cpp.  Plain malloc() from C code, or from
+        JUCE's HeapBlock, isn't seen: a plugin module can't interpose the C
+        allocator portably.
+
+      • A lock declared as RealtimeSafety::Checked<juce::CriticalSection>
+        (or any JUCE-style lock type) reports every blocking enter().
+        tryEnter() never blocks, so it's allowed.  Locks inside JUCE, such
+        as juce::Synthesiser's, can't be wrapped and aren't seen.
+
+    A violation goes to a process-wide ViolationLog with the thread's scope
+    name and its stack (return addresses only; symbolised later), claimed
+    with one fetch_add, so reporting neither allocates nor locks.  A
+    ViolationReporter writes new ones to juce::Logger from the message
+    thread.  Code that allocates on purpose, e.g. a one-off rebuild, can
+    say so with RealtimeSafety::ScopedAllowance.
+
+    Off unless REALTIME_SAFETY_CHECKS is set, which it is in debug builds:
+    release builds get plain locks and empty macros.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_events/juce_events.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef REALTIME_SAFETY_CHECKS
+ #ifdef JUCE_DEBUG
+  #define REALTIME_SAFETY_CHECKS 1
+ #else
+  #define REALTIME_SAFETY_CHECKS 0
+ #endif
+#endif
+
+#if REALTIME_SAFETY_CHECKS && (JUCE_LINUX || JUCE_MAC || JUCE_BSD)
+ #include <execinfo.h>
+ #define REALTIME_SAFETY_BACKTRACE 1
+#else
+ #define REALTIME_SAFETY_BACKTRACE 0   // violations are logged without a stack
+#endif
+
+namespace RealtimeSafety
+{
+
+#if REALTIME_SAFETY_CHECKS
+
+enum class Violation : juce::uint8 { allocation, deallocation, blockingLock };
+
+inline const char* getDescription (Violation kind) noexcept
+{
+    switch (kind)
+    {
+        case Violation::allocation:   return "allocation";
+        case Violation::deallocation: return "deallocation";
+        case Violation::blockingLock: return "blocking lock";
+    }
+
+    return "";
+}
+
+//==============================================================================
+/** The calling thread's marks.  thread_local, so checking one costs a TLS
+    read and nothing is shared. */
+struct ThreadState
+{
+    int         depth     = 0;         // nested audio-thread scopes
+    int         allowed   = 0;         // nested ScopedAllowances
+    bool        reporting = false;     // guards against a report reporting itself
+    const char* scope     = nullptr;   // the outermost scope's name
+};
+
+inline ThreadState& getThreadState() noexcept
+{
+    static thread_local ThreadState state;
+    return state;
+}
+
+//==============================================================================
+/** Every violation in the process, the first kCapacity of them kept.  Any
+    thread may add (wait-free: one fetch_add claims a slot); any thread may
+    read the slots that have been published. */
+class ViolationLog
+{
+public:
+    static constexpr int kCapacity  = 256;
+    static constexpr int kMaxFrames = 24;
+
+    struct Record
+    {
+        Violation                     kind      = Violation::allocation;
+        const char*                   scope     = nullptr;
+        juce::Thread::ThreadID        threadId  = nullptr;
+        int                           numFrames = 0;
+        std::array<void*, kMaxFrames> frames {};
+    };
+
+    static ViolationLog& getInstance()
+    {
+        static ViolationLog log;
+        return log;
+    }
+
+    void add (Violation kind, const char* scope) noexcept
+    {
+        const auto index = next.fetch_add (1, std::memory_order_relaxed);
+
+        if (index >= (juce::uint32) kCapacity)
+            return;   // still counted by getNumViolations()
+
+        auto& slot = slots[(size_t) index];
+        slot.record.kind     = kind;
+        slot.record.scope    = scope;
+        slot.record.threadId = juce::Thread::getCurrentThreadId();
+       #if REALTIME_SAFETY_BACKTRACE
+        slot.record.numFrames = backtrace (slot.record.frames.data(), kMaxFrames);
+       #endif
+        slot.published.store (true, std::memory_order_release);
+    }
+
+    /** Every violation so far, including any past kCapacity. */
+    int getNumViolations() const noexcept { return (int) next.load (std::memory_order_relaxed); }
+
+    /** False until slot index has been published (or if it never will be). */
+    bool getRecord (int index, Record& out) const noexcept
+    {
+        if (! juce::isPositiveAndBelow (index, kCapacity)
+            || ! slots[(size_t) index].published.load (std::memory_order_acquire))
+            return false;
+
+        out = slots[(size_t) index].record;
+        return true;
+    }
+
+    /** The record as a log entry, its stack symbolised.  Allocates; not
+        on the audio thread. */
+    static juce::String describe (const Record& record)
+    {
+        juce::String text;
+        text << "Realtime safety: " << getDescription (record.kind) << " in " << record.scope
+             << " (thread " << juce::String::toHexString ((juce::pointer_sized_int) record.threadId) << ")";
+
+       #if REALTIME_SAFETY_BACKTRACE
+        if (auto* symbols = backtrace_symbols (record.frames.data(), record.numFrames))
+        {
+            for (int i = 0; i < record.numFrames; ++i)
+                text << juce::newLine << "    " << symbols[i];
+
+            std::free (symbols);
+        }
+       #endif
+
+        return text;
+    }
+
+private:
+    ViolationLog()
+    {
+       #if REALTIME_SAFETY_BACKTRACE
+        // The first backtrace() may load the unwinder, which allocates:
+        // get that over with before any audio thread needs one
+        std::array<void*, 1> frame;
+        backtrace (frame.data(), 1);
+       #endif
+    }
+
+    struct Slot
+    {
+        Record            record;
+        std::atomic<bool> published { false };
+    };
+
+    std::atomic<juce::uint32>            next { 0 };
+    std::array<Slot, (size_t) kCapacity> slots;
+
+    JUCE_DECLARE_NON_COPYABLE (ViolationLog)
+};
+
+/** Reports kind if the calling thread is inside an audio-thread scope and
+    not allowed it. */
+inline void check (Violation kind) noexcept
+{
+    auto& state = getThreadState();
+
+    if (state.depth == 0 || state.allowed > 0 || state.reporting)
+        return;
+
+    state.reporting = true;
+    ViolationLog::getInstance().add (kind, state.scope);
+    state.reporting = false;
+}
+
+//==============================================================================
+/** Marks the calling thread as on the audio deadline until destruction.
+    Use REALTIME_SAFETY_AUDIO_THREAD, which compiles away in release. */
+class ScopedAudioThread
+{
+public:
+    explicit ScopedAudioThread (const char* scopeName) noexcept
+    {
+        auto& state = getThreadState();
+
+        if (state.depth++ == 0)
+            state.scope = scopeName;
+    }
+
+    ~ScopedAudioThread() noexcept { --getThreadState().depth; }
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedAudioThread)
+};
+
+/** Allows what would be a violation, for code that allocates or locks on
+    the audio thread on purpose. */
+class ScopedAllowance
+{
+public:
+    ScopedAllowance() noexcept  { ++getThreadState().allowed; }
+    ~ScopedAllowance() noexcept { --getThreadState().allowed; }
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedAllowance)
+};
+
+//==============================================================================
+/** LockType, reporting every blocking enter() made in an audio-thread
+    scope.  Take it with its own ScopedLockType: juce::ScopedLock would
+    call the unchecked enter(). */
+template <typename LockType>
+class Checked  : public LockType
+{
+public:
+    using LockType::LockType;
+
+    void enter() const noexcept
+    {
+        check (Violation::blockingLock);
+        LockType::enter();
+    }
+
+    using ScopedLockType    = juce::GenericScopedLock<Checked>;
+    using ScopedUnlockType  = juce::GenericScopedUnlock<Checked>;
+    using ScopedTryLockType = juce::GenericScopedTryLock<Checked>;
+};
+
+//==============================================================================
+/** Writes every violation, whichever instance's, to juce::Logger once,
+    from the message thread.  Each plugin instance owns one; the first to
+    claim a record logs it. */
+class ViolationReporter  : private juce::Timer
+{
+public:
+    static constexpr int kIntervalMs = 1000;
+
+    ViolationReporter()
+    {
+        ViolationLog::getInstance();   // built here rather than by the first violation
+        startTimer (kIntervalMs);
+    }
+
+    ~ViolationReporter() override { stopTimer(); }
+
+private:
+    void timerCallback() override
+    {
+        auto& log = ViolationLog::getInstance();
+        ViolationLog::Record record;
+
+        // A record claimed but not published yet waits for the next tick
+        for (auto index = getNextToReport().load(); log.getRecord (index, record); index = getNextToReport().load())
+            if (getNextToReport().compare_exchange_strong (index, index + 1))
+                juce::Logger::writeToLog (ViolationLog::describe (record));
+
+        if (const auto lost = log.getNumViolations() - ViolationLog::kCapacity; lost > reportedLost)
+        {
+            juce::Logger::writeToLog ("Realtime safety: " + juce::String (lost) + " more violations not kept");
+            reportedLost = lost;
+        }
+    }
+
+    static std::atomic<int>& getNextToReport() noexcept
+    {
+        static std::atomic<int> nextToReport { 0 };
+        return nextToReport;
+    }
+
+    int reportedLost = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (ViolationReporter)
+};
+
+#else
+
+template <typename LockType>
+using Checked = LockType;
+
+class ScopedAllowance
+{
+public:
+    ScopedAllowance() noexcept {}
+};
+
+#endif
+
+} // namespace RealtimeSafety
+
+//==============================================================================
+#if REALTIME_SAFETY_CHECKS
+
+ #define REALTIME_SAFETY_AUDIO_THREAD(scopeName) \
+    const RealtimeSafety::ScopedAudioThread JUCE_JOIN_MACRO (realtimeSafetyScope_, __LINE__) (scopeName)
+
+ /** Replaces the global operator new and delete for the whole binary; use
+     it exactly once, at namespace scope in a .cpp file. */
+ #define REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS \
+    void* operator new (std::size_t size) \
+    { \
+        RealtimeSafety::check (RealtimeSafety::Violation::allocation); \
+        if (auto* p = std::malloc (size == 0 ? 1 : size)) return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[] (std::size_t size) { return operator new (size); } \
+    void* operator new (std::size_t size, const std::nothrow_t&) noexcept \
+    { \
+        RealtimeSafety::check (RealtimeSafety::Violation::allocation); \
+        return std::malloc (size == 0 ? 1 : size); \
+    } \
+    void* operator new[] (std::size_t size, const std::nothrow_t& tag) noexcept { return operator new (size, tag); } \
+    void operator delete (void* p) noexcept \
+    { \
+        if (p != nullptr) RealtimeSafety::check (RealtimeSafety::Violation::deallocation); \
+        std::free (p); \
+    } \
+    void operator delete[] (void* p) noexcept                               { operator delete (p); } \
+    void operator delete   (void* p, std::size_t) noexcept                  { operator delete (p); } \
+    void operator delete[] (void* p, std::size_t) noexcept                  { operator delete (p); } \
+    void operator delete   (void* p, const std::nothrow_t&) noexcept        { operator delete (p); } \
+    void operator delete[] (void* p, const std::nothrow_t&) noexcept        { operator delete (p); }
+
+#else
+
+ #define REALTIME_SAFETY_AUDIO_THREAD(scopeName)
+ #define REALTIME_SAFETY_DEFINE_ALLOCATION_HOOKS
+
+#endif
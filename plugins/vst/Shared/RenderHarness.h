@@ -0,0 +1,661 @@
+/*
+  ==============================================================================
+    RenderHarness.h  –  Deterministic headless renders checked against golden
+                        output and timing baselines
+
+    Shared by every plugin in this repo (include it by relative path).  Each
+    plugin's Bench/RenderCheck.cpp builds one console tool around it, with
+    the plugin's AudioProcessor compiled in exactly as in the plugin:
+
+        int main (int argc, char* argv[])
+        {
+            return RenderHarness::run (argc, argv, "PFix", []
+            {
+                return std::make_unique<PFixAudioProcessor>();
+            });
+        }
+
+    No host: the tool calls prepareToPlay() / processBlock() itself, feeding
+    every fixture through every block pattern, and either records what
+    comes out (--record) or compares it with what was recorded:
+
+      • audio against a 32-bit float golden WAV, within --tolerance dB of
+        full scale, and MIDI out event for event (PFix's notes);
+      • the same render twice (--runs), which must match bit for bit;
+      • per-block time, as ns per sample frame (mean and p99), against a
+        stored baseline, within --timing-tolerance.  Baselines belong to
+        the machine they were recorded on: record them once per machine
+        with --record-timing, and pass --timing=warn where runs are noisy.
+
+    A plugin with two engines for the same sound passes a second factory,
+    for the other one: each fixture and block pattern is rendered with it
+    as well, and must match the first's render within --engine-tolerance
+    dB of full scale, so neither engine drifts from the other unnoticed.
+
+    Fixtures are WAV files, each with an optional MIDI file of the same
+    name, or a lone MIDI file for an instrument.  Without --fixtures the
+    tool generates its own: a vibrato sweep with a chord progression over
+    it, the same on every machine.
+
+    Block patterns: a fixed size, "odd" (1, 7, 31, 127, 509, … cycling),
+    or "variable" (sizes drawn from a fixed seed, 1 … --max-block).  Every
+    size stays within the --max-block the processor was prepared with, as a
+    host promises; the odd and variable ones are what catches state that
+    assumed full blocks (DSPVoice's tempBlock, per-block smoothing).
+
+    Usage:
+      <Plugin>RenderCheck  [--fixtures=dir]  [--golden=dir]
+                           [--blocks=64,512,odd,variable]  [--max-block=1024]
+                           [--rate=48000]  [--live]  [--runs=2]
+                           [--tolerance=-90]  [--timing=fail | warn | off]
+                           [--timing-tolerance=0.15]  [--engine-tolerance=-60]
+                           [--record | --record-timing]  [--out=report.json]
+
+    Renders are offline (setNonRealtime (true)) unless --live, so every
+    plugin takes its deterministic path; the factory is expected to turn
+    off anything that adapts to timing, such as a QualityGovernor.  Exits
+    with 1 if any check fails, so the tool can gate a performance change
+    on not having changed the sound.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_events/juce_events.h>
+#include "RealtimeSafety.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace RenderHarness
+{
+
+//==============================================================================
+/** One input: audio (possibly no channels, for an instrument), MIDI, or both. */
+struct Fixture
+{
+    juce::String             name;
+    juce::AudioBuffer<float> audio;
+    juce::MidiBuffer         midi;           // sample positions
+    int                      numSamples = 0;
+};
+
+/** The block sizes one render is cut into. */
+class BlockPattern
+{
+public:
+    /** "odd", "variable" or a size; false if it's none of those or the
+        size is outside 1 … maxBlock. */
+    bool parse (const juce::String& text, int maxBlockToUse)
+    {
+        name     = text;
+        maxBlock = maxBlockToUse;
+
+        if (text == "odd")      { kind = Kind::odd;      return true; }
+        if (text == "variable") { kind = Kind::variable; return true; }
+
+        kind  = Kind::fixed;
+        fixed = text.getIntValue();
+        return text.containsOnly ("0123456789") && juce::isPositiveAndNotGreaterThan (fixed, maxBlock);
+    }
+
+    /** Back to the first block, so every render is cut identically. */
+    void restart() noexcept
+    {
+        index = 0;
+        seed  = 0x5eed;
+    }
+
+    int next() noexcept
+    {
+        static constexpr int oddSizes[] { 1, 7, 31, 127, 509, 3, 257, 61, 1021, 13 };
+
+        switch (kind)
+        {
+            case Kind::odd:
+                while (oddSizes[(size_t) index % std::size (oddSizes)] > maxBlock)
+                    ++index;   // 1 always fits
+
+                return oddSizes[(size_t) index++ % std::size (oddSizes)];
+
+            case Kind::variable:
+                // A fixed LCG rather than juce::Random, whose sequence is
+                // free to change between JUCE versions
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                return 1 + (int) ((seed >> 33) % (juce::uint64) maxBlock);
+
+            case Kind::fixed:
+                break;
+        }
+
+        return fixed;
+    }
+
+    const juce::String& getName() const noexcept { return name; }
+
+private:
+    enum class Kind { fixed, odd, variable };
+
+    juce::String name;
+    Kind         kind     = Kind::fixed;
+    int          fixed    = 0;
+    int          maxBlock = 0;
+    int          index    = 0;
+    juce::uint64 seed     = 0x5eed;
+};
+
+/** What one render produced. */
+struct Render
+{
+    juce::AudioBuffer<float> audio;
+    juce::MidiBuffer         midi;
+    std::vector<double>      blockNsPerSample;
+    double                   meanNsPerSample = 0.0;
+    double                   p99NsPerSample  = 0.0;
+};
+
+using ProcessorFactory = std::function<std::unique_ptr<juce::AudioProcessor>()>;
+
+//==============================================================================
+namespace detail
+{
+    inline juce::StringArray splitList (const juce::String& text)
+    {
+        juce::StringArray items;
+        items.addTokens (text, ",", "\"");
+        items.trim();
+        items.removeEmptyStrings();
+        return items;
+    }
+
+    inline juce::String optionOr (const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        const auto value = args.getValueForOption (option);
+        return value.isNotEmpty() ? value : fallback;
+    }
+
+    inline int fail (const juce::String& message)
+    {
+        std::cerr << "RenderCheck: " << message << std::endl;
+        return 1;
+    }
+
+    // ── Fixtures ─────────────────────────────────────────────────────────────
+    inline bool readMidi (const juce::File& file, double sampleRate, juce::MidiBuffer& midi)
+    {
+        juce::FileInputStream stream (file);
+        juce::MidiFile        midiFile;
+
+        if (! stream.openedOk() || ! midiFile.readFrom (stream))
+            return false;
+
+        midiFile.convertTimestampTicksToSeconds();
+
+        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+            for (const auto* event : *midiFile.getTrack (t))
+                if (! event->message.isMetaEvent())
+                    midi.addEvent (event->message, juce::roundToInt (event->message.getTimeStamp() * sampleRate));
+
+        return true;
+    }
+
+    /** *.wav, each with an optional *.mid beside it, and lone *.mid files,
+        which play for their length plus two seconds of tail.  WAVs are
+        used at their own length and must be at sampleRate. */
+    inline juce::String loadFixtures (const juce::File& directory, double sampleRate, std::vector<Fixture>& fixtures)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        auto files = directory.findChildFiles (juce::File::findFiles, false, "*.wav;*.mid");
+        files.sort();
+
+        for (const auto& file : files)
+        {
+            const auto isWav   = file.hasFileExtension ("wav");
+            const auto wavFile = file.withFileExtension ("wav");
+
+            if (! isWav && wavFile.existsAsFile())
+                continue;   // read with its WAV
+
+            Fixture fixture;
+            fixture.name = file.getFileNameWithoutExtension();
+
+            if (isWav)
+            {
+                std::unique_ptr<juce::AudioFormatReader> reader (formats.createReaderFor (file));
+
+                if (reader == nullptr)
+                    return "can't read " + file.getFullPathName();
+
+                if (! juce::approximatelyEqual (reader->sampleRate, sampleRate))
+                    return file.getFileName() + " is at " + juce::String (reader->sampleRate) + " Hz, not " + juce::String (sampleRate);
+
+                fixture.numSamples = (int) reader->lengthInSamples;
+                fixture.audio.setSize ((int) reader->numChannels, fixture.numSamples);
+                reader->read (&fixture.audio, 0, fixture.numSamples, 0, true, true);
+            }
+
+            if (const auto midiFile = file.withFileExtension ("mid"); midiFile.existsAsFile())
+            {
+                if (! readMidi (midiFile, sampleRate, fixture.midi))
+                    return "can't read " + midiFile.getFullPathName();
+
+                if (! isWav)
+                    fixture.numSamples = fixture.midi.getLastEventTime() + (int) (2.0 * sampleRate);
+            }
+
+            fixtures.push_back (std::move (fixture));
+        }
+
+        return fixtures.empty() ? "no .wav or .mid fixtures in " + directory.getFullPathName() : juce::String();
+    }
+
+    /** Eight seconds of a stereo sine gliding 110 → 440 Hz with 5 Hz
+        vibrato, a held note and a silence, under four two-second chords:
+        pitch to track for the effects, notes for the instrument. */
+    inline Fixture generateFixture (double sampleRate)
+    {
+        Fixture fixture;
+        fixture.name       = "generated";
+        fixture.numSamples = (int) (8.0 * sampleRate);
+        fixture.audio.setSize (2, fixture.numSamples);
+
+        double phase = 0.0;
+
+        for (int i = 0; i < fixture.numSamples; ++i)
+        {
+            const auto t      = (double) i / sampleRate;
+            const auto glide  = 110.0 * std::pow (2.0, juce::jmin (t, 4.0) / 2.0);
+            const auto hz     = glide * (1.0 + 0.01 * std::sin (juce::MathConstants<double>::twoPi * 5.0 * t));
+            const auto level  = t < 7.0 ? 0.5 : 0.0;
+
+            phase += juce::MathConstants<double>::twoPi * hz / sampleRate;
+            const auto sample = (float) (level * std::sin (phase));
+
+            fixture.audio.setSample (0, i, sample);
+            fixture.audio.setSample (1, i, 0.8f * sample);
+        }
+
+        static constexpr int chords[4][3] { { 48, 52, 55 }, { 53, 57, 60 }, { 55, 59, 62 }, { 48, 55, 64 } };
+
+        for (int c = 0; c < 4; ++c)
+        {
+            const auto on  = (int) (2.0 * c * sampleRate);
+            const auto off = on + (int) (1.5 * sampleRate);
+
+            for (const auto note : chords[c])
+            {
+                fixture.midi.addEvent (juce::MidiMessage::noteOn  (1, note, 0.8f), on);
+                fixture.midi.addEvent (juce::MidiMessage::noteOff (1, note),       off);
+            }
+
+            fixture.midi.addEvent (juce::MidiMessage::pitchWheel (1, 8192 + 1024 * (c % 2)), on + (int) (0.5 * sampleRate));
+        }
+
+        return fixture;
+    }
+
+    // ── Rendering ────────────────────────────────────────────────────────────
+    inline Render render (juce::AudioProcessor& processor, const Fixture& fixture, BlockPattern& pattern,
+                          double sampleRate, int maxBlock, bool live)
+    {
+        const auto numIns    = processor.getTotalNumInputChannels();
+        const auto numOuts   = processor.getTotalNumOutputChannels();
+        const auto numFrames = fixture.numSamples;
+
+        processor.setNonRealtime (! live);
+        processor.setPlayConfigDetails (numIns, numOuts, sampleRate, maxBlock);
+        processor.prepareToPlay (sampleRate, maxBlock);
+
+        Render result;
+        result.audio.setSize (numOuts, numFrames);
+        result.audio.clear();
+
+        juce::AudioBuffer<float> block (juce::jmax (numIns, numOuts, 1), maxBlock);
+        juce::MidiBuffer         midi;
+        double                   totalSeconds = 0.0;
+
+        pattern.restart();
+
+        for (int pos = 0; pos < numFrames;)
+        {
+            const auto numSamples = juce::jmin (pattern.next(), numFrames - pos);
+
+            block.setSize (block.getNumChannels(), numSamples, false, false, true);
+            block.clear();
+
+            for (int ch = 0; ch < numIns && fixture.audio.getNumChannels() > 0; ++ch)
+                block.copyFrom (ch, 0, fixture.audio, ch % fixture.audio.getNumChannels(), pos, numSamples);
+
+            midi.clear();
+            midi.addEvents (fixture.midi, pos, numSamples, -pos);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock (block, midi);
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+            result.blockNsPerSample.push_back (seconds * 1.0e9 / numSamples);
+            totalSeconds += seconds;
+
+            for (int ch = 0; ch < numOuts; ++ch)
+                result.audio.copyFrom (ch, pos, block, ch, 0, numSamples);
+
+            result.midi.addEvents (midi, 0, numSamples, pos);
+            pos += numSamples;
+        }
+
+        processor.releaseResources();
+
+        auto sorted = result.blockNsPerSample;
+        std::sort (sorted.begin(), sorted.end());
+
+        result.meanNsPerSample = numFrames > 0 ? totalSeconds * 1.0e9 / numFrames : 0.0;
+        result.p99NsPerSample  = sorted.empty() ? 0.0
+                               : sorted[(size_t) juce::jmin ((int) sorted.size() - 1, (int) std::ceil (0.99 * (double) sorted.size()) - 1)];
+        return result;
+    }
+
+    // ── Golden files ─────────────────────────────────────────────────────────
+    inline bool writeWav (const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream (file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate,
+                                                                              (unsigned int) audio.getNumChannels(),
+                                                                              32, {}, 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();   // the writer owns it now
+        return writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    inline bool readWav (const juce::File& file, juce::AudioBuffer<float>& audio)
+    {
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor (file.createInputStream().release(), true));
+
+        if (reader == nullptr)
+            return false;
+
+        audio.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);
+        return reader->read (&audio, 0, audio.getNumSamples(), 0, true, true);
+    }
+
+    /** MIDI in sample-position ticks, so nothing is lost to tempo maths. */
+    inline bool writeMidi (const juce::File& file, const juce::MidiBuffer& midi)
+    {
+        juce::MidiMessageSequence track;
+
+        for (const auto metadata : midi)
+            track.addEvent (metadata.getMessage(), metadata.samplePosition);
+
+        juce::MidiFile midiFile;
+        midiFile.setTicksPerQuarterNote (960);
+        midiFile.addTrack (track);
+
+        file.deleteFile();
+        juce::FileOutputStream stream (file);
+        return stream.openedOk() && midiFile.writeTo (stream);
+    }
+
+    inline bool readMidiTicks (const juce::File& file, juce::MidiBuffer& midi)
+    {
+        juce::FileInputStream stream (file);
+        juce::MidiFile        midiFile;
+
+        if (! stream.openedOk() || ! midiFile.readFrom (stream) || midiFile.getNumTracks() == 0)
+            return false;
+
+        for (const auto* event : *midiFile.getTrack (0))
+            if (! event->message.isMetaEvent())
+                midi.addEvent (event->message, (int) event->message.getTimeStamp());
+
+        return true;
+    }
+
+    /** Largest difference, in dB of full scale; -inf if identical, +inf if
+        the shapes differ. */
+    inline double maxDifferenceDb (const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return std::numeric_limits<double>::infinity();
+
+        float largest = 0.0f;
+
+        for (int ch = 0; ch < a.getNumChannels(); ++ch)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                largest = juce::jmax (largest, std::abs (a.getSample (ch, i) - b.getSample (ch, i)));
+
+        return largest > 0.0f ? 20.0 * std::log10 ((double) largest) : -std::numeric_limits<double>::infinity();
+    }
+
+    /** Events that differ in bytes or sample position, counting any
+        missing on either side. */
+    inline int midiMismatches (const juce::MidiBuffer& a, const juce::MidiBuffer& b)
+    {
+        auto ia = a.begin(), ib = b.begin();
+        int mismatches = 0;
+
+        for (; ia != a.end() && ib != b.end(); ++ia, ++ib)
+        {
+            const auto ma = *ia, mb = *ib;
+
+            if (ma.samplePosition != mb.samplePosition || ma.numBytes != mb.numBytes
+                || std::memcmp (ma.data, mb.data, (size_t) ma.numBytes) != 0)
+                ++mismatches;
+        }
+
+        return mismatches + std::abs (a.getNumEvents() - b.getNumEvents());
+    }
+
+    inline bool identical (const Render& a, const Render& b)
+    {
+        const auto differenceDb = maxDifferenceDb (a.audio, b.audio);
+        return std::isinf (differenceDb) && differenceDb < 0.0 && midiMismatches (a.midi, b.midi) == 0;
+    }
+}
+
+//==============================================================================
+/** The whole tool: parses argv, renders, checks or records, prints the
+    JSON report, and returns the exit code.  createOtherEngine, if given,
+    builds the processor whose renders must match createProcessor's (see
+    above); the golden files are createProcessor's. */
+inline int run (int argc, char* argv[], const juce::String& pluginName, const ProcessorFactory& createProcessor,
+                const ProcessorFactory& createOtherEngine = {})
+{
+    using namespace detail;
+
+    const juce::ArgumentList args (argc, argv);
+
+    // Parameter trees and async updates expect a message manager
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const auto cwd          = juce::File::getCurrentWorkingDirectory();
+    const auto goldenDir    = cwd.getChildFile (optionOr (args, "--golden", "RenderGolden/" + pluginName));
+    const auto blockNames   = splitList (optionOr (args, "--blocks", "64,512,odd,variable"));
+    const auto maxBlock     = optionOr (args, "--max-block", "1024").getIntValue();
+    const auto sampleRate   = optionOr (args, "--rate",      "48000").getDoubleValue();
+    const auto numRuns      = juce::jmax (1, optionOr (args, "--runs", "2").getIntValue());
+    const auto toleranceDb  = optionOr (args, "--tolerance", "-90").getDoubleValue();
+    const auto timingMode   = optionOr (args, "--timing", "fail");
+    const auto timingSlack  = optionOr (args, "--timing-tolerance", "0.15").getDoubleValue();
+    const auto engineSlack  = optionOr (args, "--engine-tolerance", "-60").getDoubleValue();
+    const bool live         = args.containsOption ("--live");
+    const bool record       = args.containsOption ("--record");
+    const bool recordTiming = record || args.containsOption ("--record-timing");
+
+    if (maxBlock < 1 || sampleRate <= 0.0)
+        return fail ("--max-block and --rate must be positive");
+
+    if (timingMode != "fail" && timingMode != "warn" && timingMode != "off")
+        return fail ("--timing is fail, warn or off");
+
+    std::vector<BlockPattern> patterns (blockNames.size());
+
+    for (int i = 0; i < blockNames.size(); ++i)
+        if (! patterns[(size_t) i].parse (blockNames[i], maxBlock))
+            return fail ("unknown block pattern '" + blockNames[i] + "' (a size up to --max-block, odd or variable)");
+
+    std::vector<Fixture> fixtures;
+
+    if (const auto fixtureDir = args.getValueForOption ("--fixtures"); fixtureDir.isNotEmpty())
+    {
+        if (const auto error = loadFixtures (cwd.getChildFile (fixtureDir), sampleRate, fixtures); error.isNotEmpty())
+            return fail (error);
+    }
+    else
+    {
+        fixtures.push_back (generateFixture (sampleRate));
+    }
+
+    if ((record || recordTiming) && ! goldenDir.createDirectory())
+        return fail ("can't create " + goldenDir.getFullPathName());
+
+    juce::Array<juce::var> results;
+    int failures = 0;
+
+    for (const auto& fixture : fixtures)
+    for (auto& pattern : patterns)
+    {
+        const auto stem = fixture.name + "." + pattern.getName();
+
+        // Fresh processor per render, so nothing carries over between them;
+        // the fastest run's timing, the least disturbed by the machine
+        std::vector<Render> renders;
+
+        for (int r = 0; r < numRuns; ++r)
+        {
+            const auto processor = createProcessor();
+            renders.push_back (render (*processor, fixture, pattern, sampleRate, maxBlock, live));
+        }
+
+        const auto& first   = renders.front();
+        const auto  fastest = std::min_element (renders.begin(), renders.end(), [] (const Render& a, const Render& b)
+                                                { return a.meanNsPerSample < b.meanNsPerSample; });
+
+        bool deterministic = true;
+
+        for (size_t r = 1; r < renders.size(); ++r)
+            deterministic = deterministic && identical (first, renders[r]);
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty ("fixture",         fixture.name);
+        result->setProperty ("blocks",          pattern.getName());
+        result->setProperty ("deterministic",   deterministic);
+        result->setProperty ("meanNsPerSample", fastest->meanNsPerSample);
+        result->setProperty ("p99NsPerSample",  fastest->p99NsPerSample);
+
+        bool passed = deterministic;
+
+        if (createOtherEngine != nullptr)
+        {
+            const auto processor  = createOtherEngine();
+            const auto other      = render (*processor, fixture, pattern, sampleRate, maxBlock, live);
+            const auto engineDb   = maxDifferenceDb (first.audio, other.audio);
+            const auto engineMidi = midiMismatches (first.midi, other.midi);
+
+            result->setProperty ("engineDifferenceDb",   std::isfinite (engineDb) ? juce::var (engineDb) : juce::var());
+            result->setProperty ("engineMidiMismatches", engineMidi);
+            passed = passed && engineDb <= engineSlack && engineMidi == 0;
+        }
+
+        const auto goldenWav    = goldenDir.getChildFile (stem + ".wav");
+        const auto goldenMidi   = goldenDir.getChildFile (stem + ".mid");
+        const auto baselineFile = goldenDir.getChildFile (stem + ".timing.json");
+
+        if (record)
+        {
+            if (! writeWav (goldenWav, first.audio, sampleRate) || ! writeMidi (goldenMidi, first.midi))
+                return fail ("can't write " + goldenWav.getFullPathName());
+
+            result->setProperty ("recorded", true);
+        }
+        else
+        {
+            juce::AudioBuffer<float> goldenAudio;
+            juce::MidiBuffer         goldenEvents;
+
+            if (! readWav (goldenWav, goldenAudio) || ! readMidiTicks (goldenMidi, goldenEvents))
+                return fail ("no golden render " + goldenWav.getFullPathName() + " (record one with --record)");
+
+            const auto differenceDb = maxDifferenceDb (first.audio, goldenAudio);
+            const auto mismatches   = midiMismatches (first.midi, goldenEvents);
+
+            // JSON has no infinities: an identical render reports null
+            result->setProperty ("maxDifferenceDb", std::isfinite (differenceDb) ? juce::var (differenceDb) : juce::var());
+            result->setProperty ("midiMismatches",  mismatches);
+            passed = passed && differenceDb <= toleranceDb && mismatches == 0;
+        }
+
+        if (recordTiming)
+        {
+            auto* baseline = new juce::DynamicObject();
+            baseline->setProperty ("meanNsPerSample", fastest->meanNsPerSample);
+            baseline->setProperty ("p99NsPerSample",  fastest->p99NsPerSample);
+
+            if (! baselineFile.replaceWithText (juce::JSON::toString (juce::var (baseline))))
+                return fail ("can't write " + baselineFile.getFullPathName());
+        }
+        else if (timingMode != "off")
+        {
+            const auto baseline = juce::JSON::parse (baselineFile);
+
+            if (! baseline.isObject())
+                return fail ("no timing baseline " + baselineFile.getFullPathName() + " (record one with --record-timing)");
+
+            const auto baselineMean = (double) baseline.getProperty ("meanNsPerSample", 0.0);
+            const auto baselineP99  = (double) baseline.getProperty ("p99NsPerSample",  0.0);
+            const bool slower = fastest->meanNsPerSample > baselineMean * (1.0 + timingSlack)
+                             || fastest->p99NsPerSample  > baselineP99  * (1.0 + timingSlack);
+
+            result->setProperty ("baselineMeanNsPerSample", baselineMean);
+            result->setProperty ("baselineP99NsPerSample",  baselineP99);
+            result->setProperty ("timingRegression",        slower);
+            passed = passed && ! (slower && timingMode == "fail");
+        }
+
+        result->setProperty ("passed", passed);
+        results.add (juce::var (result));
+        failures += passed ? 0 : 1;
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("tool",       pluginName + "RenderCheck");
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("maxBlock",   maxBlock);
+    root->setProperty ("live",       live);
+    root->setProperty ("results",    results);
+    root->setProperty ("failures",   failures);
+
+   #if REALTIME_SAFETY_CHECKS
+    const auto violations = RealtimeSafety::ViolationLog::getInstance().getNumViolations();
+    root->setProperty ("realtimeSafetyViolations", violations);
+    failures += violations;
+   #endif
+
+    const auto json = juce::JSON::toString (juce::var (root));
+    const auto out  = args.getValueForOption ("--out");
+
+    if (out.isEmpty())
+        std::cout << json << std::endl;
+    else if (! cwd.getChildFile (out).replaceWithText (json))
+        return fail ("can't write " + out);
+
+    return failures > 0 ? 1 : 0;
+}
+
+} // namespace RenderHarness
@@ -0,0 +1,413 @@
+/*
+  ==============================================================================
+    SharedTelemetry.h  –  Live telemetry in shared memory, for other processes
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    A Publisher maps a small named region (a file under getDirectory():
+    /dev/shm on Linux, the temp folder elsewhere, so it stays in the page
+    cache) and writes fixed-size TelemetryRecords into a BroadcastRing
+    after a small header.  Any number of external processes (dashboards, logging
+    tools) open the same file with a Reader and poll it: they only ever
+    read the mapping, so the plugin never knows they are there and pays
+    nothing for them, and a reader that falls behind counts what it missed
+    and resyncs, as inside the plugin.
+
+    Region layout (native byte order; sizes are checked on open):
+      Header   (kRingOffset bytes)  magic "VGTM", version, sizes, a
+                                    seqlock-protected Info (source name,
+                                    sample rate, PerfProbe scope names) and
+                                    a heartbeat
+      Ring     BroadcastRing<TelemetryRecord, kCapacity>
+
+    The magic is written last, so a reader never sees a half-built region.
+    The file is deleted on close(); one left by a crashed host stops its
+    heartbeat, which is how readers tell (isAlive()).
+
+    The Publisher is for one thread (plugins drive theirs from a message
+    thread timer, never the audio thread); each Reader for its own thread.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "BroadcastRing.h"
+#include "PerfProbe.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+/** One published measurement. */
+struct TelemetryRecord
+{
+    enum Kind : juce::uint32
+    {
+        pitch    = 1,   ///< channel = input channel; values[0] = Hz (0 = unvoiced)
+        load     = 2,   ///< channel = PerfProbe scope (Info::scopeNames); mean, p50, p99 load, overruns
+        voices   = 3,   ///< active voices, voice cap, one voice's load, reverb load (loads in % of real time)
+        detector = 4    ///< pitch detector counts since the last; channel 0: frames, energy-gated,
+                        ///< unvoiced-gated, lags searched; channel 1: tracking fallbacks, interpolation failures
+    };
+
+    double               time       { 0.0 };   ///< SharedTelemetry::now() when published
+    double               sourceTime { 0.0 };   ///< On the plugin's own timeline (a pitch point's timestamp), else 0
+    juce::uint32         kind       { 0 };
+    juce::int32          channel    { 0 };
+    std::array<float, 4> values     {};
+};
+
+class SharedTelemetry
+{
+public:
+    static constexpr juce::uint32 kMagic        = 0x4d544756;   // "VGTM", little-endian
+    static constexpr juce::uint32 kVersion      = 1;
+    static constexpr int          kCapacity     = 8192;         // ~3 s of 16 channels' pitch at 256-sample hops
+    static constexpr int          kNameBytes    = 32;
+    static constexpr int          kMaxScopes    = PerfProbe::kMaxScopes;
+    static constexpr size_t       kRingOffset   = 1024;
+
+    using Ring = BroadcastRing<TelemetryRecord, kCapacity>;
+
+    /** What a region's records are about; rewritten rarely (format changes). */
+    struct Info
+    {
+        char                                         source[kNameBytes] {};   ///< e.g. "PFix", null-terminated
+        double                                       sampleRate  { 0.0 };
+        juce::int32                                  numChannels { 0 };
+        juce::int32                                  numScopes   { 0 };
+        std::array<char[kNameBytes], kMaxScopes>     scopeNames  {};          ///< TelemetryRecord::load's channels
+    };
+
+    /** Where regions live; Reader::findRegions() lists it. */
+    static juce::File getDirectory()
+    {
+       #if JUCE_LINUX
+        const juce::File shm ("/dev/shm");
+
+        if (shm.isDirectory())
+            return shm.getChildFile ("vst-garage-telemetry");
+       #endif
+
+        return juce::File::getSpecialLocation (juce::File::tempDirectory).getChildFile ("vst-garage-telemetry");
+    }
+
+    /** The records' clock: seconds on the high-resolution millisecond
+        counter, which every process on the machine shares. */
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+private:
+    static_assert (std::atomic<juce::uint32>::is_always_lock_free && std::atomic<juce::int64>::is_always_lock_free
+                     && std::atomic<size_t>::is_always_lock_free,
+                   "shared-memory atomics must be lock-free to work across processes");
+    static_assert (sizeof (TelemetryRecord) == 40, "TelemetryRecord is part of the region's layout");
+
+    struct Header
+    {
+        std::atomic<juce::uint32> magic        { 0 };   // stored last (release) once the rest is valid
+        juce::uint32              version      { kVersion };
+        juce::uint32              headerBytes  { (juce::uint32) kRingOffset };
+        juce::uint32              recordBytes  { (juce::uint32) sizeof (TelemetryRecord) };
+        juce::uint32              capacity     { (juce::uint32) kCapacity };
+        juce::uint32              ringBytes    { (juce::uint32) sizeof (Ring) };
+        std::atomic<juce::uint32> infoSequence { 0 };   // odd while info is being rewritten
+        juce::uint32              reserved     { 0 };
+        Info                      info;
+        std::atomic<juce::int64>  heartbeatMs  { 0 };   // Time::currentTimeMillis() of the last publish, 0 once closed
+    };
+
+    static_assert (sizeof (Header) <= kRingOffset && kRingOffset % alignof (Ring) == 0, "region layout");
+
+    static constexpr juce::int64 kRegionBytes = (juce::int64) (kRingOffset + sizeof (Ring));
+
+    static Header* getHeader (void* base) noexcept { return static_cast<Header*> (base); }
+    static Ring*   getRing   (void* base) noexcept { return reinterpret_cast<Ring*> (static_cast<char*> (base) + kRingOffset); }
+
+    static void copyName (char (&dest)[kNameBytes], const char* name) noexcept
+    {
+        std::memset (dest, 0, sizeof (dest));
+
+        if (name != nullptr)
+            std::strncpy (dest, name, sizeof (dest) - 1);
+    }
+
+public:
+    //==============================================================================
+    /** Writes one region.  Not realtime-safe to open or close; publishing is
+        lock-free and doesn't allocate. */
+    class Publisher
+    {
+    public:
+        Publisher() = default;
+        ~Publisher() { close(); }
+
+        /** Creates a region named after sourceName (numbered if another
+            instance already has one) and starts its heartbeat.  Returns false
+            if it can't be created or mapped. */
+        bool open (const juce::String& sourceName)
+        {
+            close();
+
+            const auto directory = getDirectory();
+
+            if (directory.createDirectory().failed())
+                return false;
+
+            file = directory.getNonexistentChildFile (juce::File::createLegalFileName (sourceName), ".telemetry", false);
+
+            {
+                juce::FileOutputStream out (file);
+
+                if (! out.openedOk() || ! out.setPosition (kRegionBytes - 1) || ! out.writeByte (0))
+                    return failToOpen();
+
+                out.flush();
+
+                if (out.getStatus().failed())
+                    return failToOpen();
+            }
+
+            mapping = std::make_unique<juce::MemoryMappedFile> (file, juce::Range<juce::int64> (0, kRegionBytes),
+                                                                juce::MemoryMappedFile::readWrite);
+
+            if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < kRegionBytes)
+                return failToOpen();
+
+            // Constructing the ring also touches every page, so publishing never faults
+            auto* base = mapping->getData();
+            header     = new (base) Header();
+            ring       = new (getRing (base)) Ring();
+
+            copyName (header->info.source, sourceName.toRawUTF8());
+            header->heartbeatMs.store (juce::Time::currentTimeMillis(), std::memory_order_relaxed);
+            header->magic.store (kMagic, std::memory_order_release);
+            return true;
+        }
+
+        /** Stops the heartbeat and removes the region (readers that have it
+            mapped keep what they have, and see isAlive() go false). */
+        void close()
+        {
+            if (mapping == nullptr)
+                return;
+
+            if (header != nullptr)
+            {
+                header->heartbeatMs.store (0, std::memory_order_release);
+                header->magic.store (0, std::memory_order_release);
+            }
+
+            header = nullptr;
+            ring   = nullptr;
+            mapping.reset();
+            file.deleteFile();
+            file = {};
+        }
+
+        bool       isOpen()  const noexcept { return header != nullptr; }
+        juce::File getFile() const          { return file; }
+
+        /** Rewrites the region's Info, e.g. after prepareToPlay().  The scope
+            names are the probe's, so load records can be labelled. */
+        void setInfo (double sampleRate, int numChannels, const PerfProbe* probe) noexcept
+        {
+            if (header == nullptr)
+                return;
+
+            const auto sequence = header->infoSequence.load (std::memory_order_relaxed);
+            header->infoSequence.store (sequence + 1, std::memory_order_relaxed);   // odd: rewriting
+            std::atomic_thread_fence (std::memory_order_release);
+
+            auto& info       = header->info;
+            info.sampleRate  = sampleRate;
+            info.numChannels = numChannels;
+            info.numScopes   = probe != nullptr ? probe->getNumScopes() : 0;
+
+            for (int s = 0; s < kMaxScopes; ++s)
+                copyName (info.scopeNames[(size_t) s], s < info.numScopes ? probe->getScopeName (s) : nullptr);
+
+            header->infoSequence.store (sequence + 2, std::memory_order_release);
+        }
+
+        void publish (const TelemetryRecord& record) noexcept
+        {
+            publish (&record, 1);
+        }
+
+        /** Appends records and beats the heartbeat.  A no-op while closed. */
+        void publish (const TelemetryRecord* records, int numRecords) noexcept
+        {
+            if (ring == nullptr)
+                return;
+
+            ring->pushBlock (records, numRecords);
+            header->heartbeatMs.store (juce::Time::currentTimeMillis(), std::memory_order_relaxed);
+        }
+
+        /** One TelemetryRecord::load per scope: its mean, p50 and p99 load
+            and its overruns, all since the probe was last reset. */
+        void publishLoads (const PerfProbe& probe) noexcept
+        {
+            std::array<TelemetryRecord, kMaxScopes> records;
+            const auto time      = now();
+            const int  numScopes = juce::jmin (probe.getNumScopes(), kMaxScopes);
+
+            for (int s = 0; s < numScopes; ++s)
+            {
+                const auto summary = probe.getSummary (s);
+                auto&      record  = records[(size_t) s];
+
+                record.time    = time;
+                record.kind    = TelemetryRecord::load;
+                record.channel = s;
+                record.values  = { (float) summary.meanLoad, (float) summary.p50Load,
+                                   (float) summary.p99Load,  (float) summary.overruns };
+            }
+
+            publish (records.data(), numScopes);
+        }
+
+    private:
+        bool failToOpen()
+        {
+            mapping.reset();
+            file.deleteFile();
+            file = {};
+            return false;
+        }
+
+        juce::File                              file;
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        Header*                                 header { nullptr };
+        Ring*                                   ring   { nullptr };
+
+        JUCE_DECLARE_NON_COPYABLE (Publisher)
+    };
+
+    //==============================================================================
+    /** Follows one region, read-only: the small reader library for tools
+        outside the plugin.  A typical poll loop:
+
+            SharedTelemetry::Reader reader;
+
+            for (auto& f : SharedTelemetry::Reader::findRegions())
+                if (reader.open (f) && reader.isAlive()) break;
+
+            reader.readAll ([] (const TelemetryRecord* records, int num) { ... });
+    */
+    class Reader
+    {
+    public:
+        Reader() = default;
+
+        /** Every region in getDirectory(), newest first; some may be stale. */
+        static juce::Array<juce::File> findRegions()
+        {
+            auto files = getDirectory().findChildFiles (juce::File::findFiles, false, "*.telemetry");
+
+            std::sort (files.begin(), files.end(), [] (const juce::File& a, const juce::File& b)
+            {
+                return a.getLastModificationTime() > b.getLastModificationTime();
+            });
+
+            return files;
+        }
+
+        /** Maps the region and starts at its newest record.  False if it
+            isn't a complete region of this version and layout. */
+        bool open (const juce::File& regionFile)
+        {
+            close();
+
+            mapping = std::make_unique<juce::MemoryMappedFile> (regionFile, juce::Range<juce::int64> (0, kRegionBytes),
+                                                                juce::MemoryMappedFile::readOnly);
+
+            if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < kRegionBytes)
+            {
+                close();
+                return false;
+            }
+
+            auto* candidate = getHeader (mapping->getData());
+
+            if (candidate->magic.load (std::memory_order_acquire) != kMagic
+                 || candidate->version     != kVersion
+                 || candidate->headerBytes != (juce::uint32) kRingOffset
+                 || candidate->recordBytes != (juce::uint32) sizeof (TelemetryRecord)
+                 || candidate->capacity    != (juce::uint32) kCapacity
+                 || candidate->ringBytes   != (juce::uint32) sizeof (Ring))
+            {
+                close();
+                return false;
+            }
+
+            header = candidate;
+            cursor = std::make_unique<Ring::Reader> (*getRing (mapping->getData()));
+            return true;
+        }
+
+        void close()
+        {
+            cursor.reset();
+            header = nullptr;
+            mapping.reset();
+        }
+
+        bool isOpen() const noexcept { return header != nullptr; }
+
+        /** Whether the publisher has written in the last staleAfterMs (the
+            plugins publish several times a second, even when idle). */
+        bool isAlive (juce::int64 staleAfterMs = 2000) const noexcept
+        {
+            if (header == nullptr)
+                return false;
+
+            const auto beat = header->heartbeatMs.load (std::memory_order_acquire);
+            return beat != 0 && juce::Time::currentTimeMillis() - beat <= staleAfterMs;
+        }
+
+        /** A consistent copy of the region's Info; false if closed, or if the
+            publisher kept rewriting it (try again). */
+        bool readInfo (Info& info) const noexcept
+        {
+            for (int attempt = 0; header != nullptr && attempt < 8; ++attempt)
+            {
+                const auto before = header->infoSequence.load (std::memory_order_acquire);
+
+                if ((before & 1) != 0)
+                    continue;
+
+                std::memcpy (&info, &header->info, sizeof (Info));
+                std::atomic_thread_fence (std::memory_order_acquire);
+
+                if (header->infoSequence.load (std::memory_order_relaxed) == before)
+                    return true;
+            }
+
+            return false;
+        }
+
+        /** Hands over the records published since the last read, in chunks
+            (see BroadcastRing::Reader::readAll).  0 while closed. */
+        template <typename Consumer>
+        int readAll (Consumer&& consume, int maxRecords = kCapacity)
+        {
+            return cursor != nullptr ? cursor->readAll (std::forward<Consumer> (consume), maxRecords) : 0;
+        }
+
+        int numBehind()    const noexcept { return cursor != nullptr ? cursor->numBehind() : 0; }
+        int skipToNewest()       noexcept { return cursor != nullptr ? cursor->skipToNewest() : 0; }
+
+        /** Received / missed counts since open(). */
+        Ring::Reader::Stats getStats() const noexcept { return cursor != nullptr ? cursor->getStats() : Ring::Reader::Stats(); }
+
+    private:
+        std::unique_ptr<juce::MemoryMappedFile> mapping;
+        const Header*                           header { nullptr };
+        std::unique_ptr<Ring::Reader>           cursor;
+
+        JUCE_DECLARE_NON_COPYABLE (Reader)
+    };
+};
@@ -0,0 +1,303 @@
+/*
+  ==============================================================================
+    TraceEvents.h  –  Wait-free per-thread trace rings, exported as Chrome
+                      trace JSON
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    Where PerfProbe says how long a scope takes, a trace says when: what
+    the audio thread, the analysis workers, the ARA renderer and the UI
+    were each doing at the same moment.  Mark code with
+
+        TRACE_SCOPE ("yin");                    // begin here, end at the brace
+        TRACE_COUNTER ("voices", numVoices);
+        TRACE_INSTANT ("prefetch miss");
+
+    and TraceRecorder::getInstance().start() … stopAndWrite (file) captures
+    a trace that chrome://tracing and ui.perfetto.dev both open.  Names
+    must be string literals: only the pointer is recorded.
+
+    Each thread writes to its own LockFreeRing, claimed from a fixed pool
+    the first time it records, so recording is a tick read and an SPSC
+    push: no locks, no allocation, wait-free.  While nothing is capturing,
+    each macro is one relaxed load and a branch, cheap enough to leave in
+    release builds (define TRACE_EVENTS_COMPILED=0 to remove them
+    entirely).  A background thread drains the rings while capturing, so
+    they only have to hold its polling interval's worth of events.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "LockFreeRing.h"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifndef TRACE_EVENTS_COMPILED
+ #define TRACE_EVENTS_COMPILED 1
+#endif
+
+class TraceRecorder
+{
+public:
+    static constexpr int kMaxThreads      = 32;     // past this, threads go untraced
+    static constexpr int kEventsPerThread = 4096;   // ~40 ms of a busy thread between drains
+    static constexpr int kDrainIntervalMs = 5;
+
+    enum class Phase : juce::uint8 { begin, end, counter, instant };
+
+    struct Event
+    {
+        juce::int64  ticks = 0;
+        const char*  name  = nullptr;
+        float        value = 0.0f;   // counters only
+        Phase        phase = Phase::instant;
+    };
+
+    static TraceRecorder& getInstance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    ~TraceRecorder() { flusher.stopThread (1000); }
+
+    // ── Recording (any thread) ────────────────────────────────────────────────
+
+    bool isCapturing() const noexcept { return capturing.load (std::memory_order_relaxed); }
+
+    void record (Phase phase, const char* name, float value = 0.0f) noexcept
+    {
+        if (! isCapturing())
+            return;
+
+        if (auto* buffer = getThreadBuffer())
+            buffer->ring.push ({ juce::Time::getHighResolutionTicks(), name, value, phase });
+    }
+
+    /** Names the calling thread's row in the trace; a string literal.
+        Threads that never call this are named by their thread id. */
+    void setThreadName (const char* name) noexcept
+    {
+        if (auto* buffer = getThreadBuffer())
+            buffer->name.store (name);
+    }
+
+    // ── Capturing (message thread, or any one other thread) ──────────────────
+
+    /** Drops anything captured before and starts recording. */
+    void start()
+    {
+        stop();
+        captured.clear();
+        droppedAtStart = 0;
+        droppedAtStart = getNumDropped();
+        startTicks     = juce::Time::getHighResolutionTicks();
+        capturing.store (true);
+        flusher.startThread();
+    }
+
+    /** Stops recording and collects what's left in the rings. */
+    void stop()
+    {
+        capturing.store (false);
+        flusher.stopThread (1000);
+        drain();
+    }
+
+    /** stop(), then writes everything captured as Chrome trace JSON.
+        Returns false if the file couldn't be written. */
+    bool stopAndWrite (const juce::File& file)
+    {
+        stop();
+        return file.replaceWithText (toChromeTraceJson());
+    }
+
+    /** Events lost to a full ring since the last start(). */
+    juce::uint64 getNumDropped() const noexcept
+    {
+        juce::uint64 dropped = 0;
+
+        for (int i = 0; i < juce::jmin (numThreads.load(), kMaxThreads); ++i)
+            dropped += buffers[(size_t) i]->ring.getStats().dropped;
+
+        return dropped - droppedAtStart;
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        LockFreeRing<Event, kEventsPerThread> ring;
+        std::atomic<const char*>              name     { nullptr };
+        juce::Thread::ThreadID                threadId { nullptr };
+    };
+
+    struct CapturedEvent
+    {
+        Event event;
+        int   thread;
+    };
+
+    TraceRecorder()
+    {
+        // The whole pool up front, so no thread allocates its ring
+        for (auto& buffer : buffers)
+            buffer = std::make_unique<ThreadBuffer>();
+    }
+
+    /** The calling thread's ring, claimed on first use; nullptr once the
+        pool is used up. */
+    ThreadBuffer* getThreadBuffer() noexcept
+    {
+        static thread_local ThreadBuffer* buffer = nullptr;
+        static thread_local bool          claimed = false;
+
+        if (! claimed)
+        {
+            claimed = true;
+            const auto index = numThreads.fetch_add (1);
+
+            if (index < kMaxThreads)
+            {
+                buffer = buffers[(size_t) index].get();
+                buffer->threadId = juce::Thread::getCurrentThreadId();
+            }
+        }
+
+        return buffer;
+    }
+
+    /** Moves every ring's events into captured.  The flusher, or whoever
+        stopped it. */
+    void drain()
+    {
+        for (int i = 0; i < juce::jmin (numThreads.load(), kMaxThreads); ++i)
+            buffers[(size_t) i]->ring.popAll ([this, i] (const Event* events, int num)
+            {
+                for (int e = 0; e < num; ++e)
+                    captured.push_back ({ events[e], i });
+            });
+    }
+
+    juce::String toChromeTraceJson() const
+    {
+        const auto microsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+        juce::Array<juce::var> events;
+
+        for (int i = 0; i < juce::jmin (numThreads.load(), kMaxThreads); ++i)
+        {
+            const auto* name = buffers[(size_t) i]->name.load();
+            auto* args = new juce::DynamicObject();
+            args->setProperty ("name", name != nullptr ? juce::String (name)
+                                                       : "thread " + juce::String::toHexString ((juce::pointer_sized_int) buffers[(size_t) i]->threadId));
+
+            auto* metadata = new juce::DynamicObject();
+            metadata->setProperty ("name", "thread_name");
+            metadata->setProperty ("ph", "M");
+            metadata->setProperty ("pid", 1);
+            metadata->setProperty ("tid", i);
+            metadata->setProperty ("args", juce::var (args));
+            events.add (juce::var (metadata));
+        }
+
+        for (const auto& [event, thread] : captured)
+        {
+            static constexpr const char* phases[] { "B", "E", "C", "i" };
+
+            auto* object = new juce::DynamicObject();
+            object->setProperty ("name", juce::String (event.name));
+            object->setProperty ("ph",   phases[(int) event.phase]);
+            object->setProperty ("ts",   (double) (event.ticks - startTicks) * microsPerTick);
+            object->setProperty ("pid",  1);
+            object->setProperty ("tid",  thread);
+
+            if (event.phase == Phase::counter)
+            {
+                auto* args = new juce::DynamicObject();
+                args->setProperty ("value", event.value);
+                object->setProperty ("args", juce::var (args));
+            }
+            else if (event.phase == Phase::instant)
+            {
+                object->setProperty ("s", "t");   // a tick on its thread's row
+            }
+
+            events.add (juce::var (object));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("traceEvents", events);
+        root->setProperty ("displayTimeUnit", "ms");
+        return juce::JSON::toString (juce::var (root), true);
+    }
+
+    class Flusher  : public juce::Thread
+    {
+    public:
+        explicit Flusher (TraceRecorder& ownerToUse) : juce::Thread ("Trace flusher"), owner (ownerToUse) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                owner.drain();
+                wait (kDrainIntervalMs);
+            }
+        }
+
+    private:
+        TraceRecorder& owner;
+    };
+
+    std::array<std::unique_ptr<ThreadBuffer>, kMaxThreads> buffers;
+    std::atomic<int>                                       numThreads { 0 };
+    std::atomic<bool>                                      capturing  { false };
+
+    // Capturing side
+    Flusher                    flusher { *this };
+    std::vector<CapturedEvent> captured;
+    juce::int64                startTicks     = 0;
+    juce::uint64               droppedAtStart = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (TraceRecorder)
+};
+
+/** Records a begin event now and the matching end when it goes out of
+    scope; use TRACE_SCOPE. */
+class TraceScope
+{
+public:
+    explicit TraceScope (const char* nameToUse) noexcept
+        : name (nameToUse), recorded (TraceRecorder::getInstance().isCapturing())
+    {
+        if (recorded)
+            TraceRecorder::getInstance().record (TraceRecorder::Phase::begin, name);
+    }
+
+    ~TraceScope() noexcept
+    {
+        if (recorded)
+            TraceRecorder::getInstance().record (TraceRecorder::Phase::end, name);
+    }
+
+private:
+    const char* const name;
+    const bool        recorded;   // so a capture starting mid-scope doesn't get a lone end
+
+    JUCE_DECLARE_NON_COPYABLE (TraceScope)
+};
+
+#if TRACE_EVENTS_COMPILED
+ #define TRACE_SCOPE(name)          const TraceScope JUCE_JOIN_MACRO (traceScope_, __LINE__) (name)
+ #define TRACE_COUNTER(name, value) TraceRecorder::getInstance().record (TraceRecorder::Phase::counter, name, (float) (value))
+ #define TRACE_INSTANT(name)        TraceRecorder::getInstance().record (TraceRecorder::Phase::instant, name)
+ #define TRACE_THREAD_NAME(name)    TraceRecorder::getInstance().setThreadName (name)
+#else
+ #define TRACE_SCOPE(name)
+ #define TRACE_COUNTER(name, value)
+ #define TRACE_INSTANT(name)
+ #define TRACE_THREAD_NAME(name)
+#endif
@@ -0,0 +1,386 @@
+/*
+  ==============================================================================
+    VectorKernels.h  –  Block kernels with runtime instruction-set dispatch
+
+    Shared by every plugin in this repo (include it by relative path).
+
+    juce::FloatVectorOperations is fixed at compile time to the baseline
+    the binary targets (SSE2 on x64), so a plugin built for every machine
+    never uses AVX2 where it has it.  Here each kernel exists as a scalar
+    reference plus SSE2, AVX2 and NEON variants, and get() inspects the CPU
+    once (juce::SystemStats, on first use) and returns a table of function
+    pointers to the widest set it supports:
+
+        const auto& kernels = VectorKernels::get();   // keep the reference
+        kernels.multiplyAdd (mix, voice, gain, numSamples);
+
+    A kernel that only one plugin needs (YIN's difference function) keeps
+    its own table beside its code, but picks its variant with
+    detectIsa() too, so no plugin checks the CPU itself.  reference() is
+    the scalar table, for checking a variant against.
+
+    AVX-512 isn't dispatched: at audio block sizes the wider registers
+    barely fill before the tail, and on several CPUs using them lowers the
+    clock for every thread on the core.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#elif JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define VECTOR_KERNELS_HAVE_NEON 1
+#endif
+
+#ifndef VECTOR_KERNELS_HAVE_NEON
+ #define VECTOR_KERNELS_HAVE_NEON 0
+#endif
+
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define VECTOR_KERNELS_TARGET_AVX2 __attribute__ ((target ("avx2,fma")))
+#else
+ #define VECTOR_KERNELS_TARGET_AVX2
+#endif
+
+namespace VectorKernels
+{
+    enum class Isa { scalar, sse2, avx2, neon };
+
+    /** The widest instruction set this CPU has that the kernels use;
+        worked out on the first call. */
+    inline Isa detectIsa() noexcept
+    {
+        static const Isa isa = []
+        {
+           #if JUCE_INTEL
+            if (juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3())
+                return Isa::avx2;
+
+            return juce::SystemStats::hasSSE2() ? Isa::sse2 : Isa::scalar;
+           #elif VECTOR_KERNELS_HAVE_NEON
+            return Isa::neon;
+           #else
+            return Isa::scalar;
+           #endif
+        }();
+
+        return isa;
+    }
+
+    inline const char* getName (Isa isa) noexcept
+    {
+        switch (isa)
+        {
+            case Isa::scalar: return "scalar";
+            case Isa::sse2:   return "SSE2";
+            case Isa::avx2:   return "AVX2";
+            case Isa::neon:   return "NEON";
+        }
+
+        return "";
+    }
+
+    /** dest[i] *= src[i]: an envelope or window over a block. */
+    using MultiplyFn     = void  (*) (float* dest, const float* src, int n) noexcept;
+
+    /** dest[i] *= gain. */
+    using ScaleFn        = void  (*) (float* dest, float gain, int n) noexcept;
+
+    /** dest[i] += src[i]. */
+    using AddFn          = void  (*) (float* dest, const float* src, int n) noexcept;
+
+    /** dest[i] = src[i] · gain: the first channel of a mixdown. */
+    using CopyScaledFn   = void  (*) (float* dest, const float* src, float gain, int n) noexcept;
+
+    /** dest[i] += src[i] · gain: the rest of a mixdown, or a voice into
+        the mix. */
+    using MultiplyAddFn  = void  (*) (float* dest, const float* src, float gain, int n) noexcept;
+
+    /** Σ x[i]². */
+    using SumOfSquaresFn = float (*) (const float* x, int n) noexcept;
+
+    struct Table
+    {
+        MultiplyFn     multiply;
+        ScaleFn        scale;
+        AddFn          add;
+        CopyScaledFn   copyScaled;
+        MultiplyAddFn  multiplyAdd;
+        SumOfSquaresFn sumOfSquares;
+        Isa            isa;
+    };
+
+    //==========================================================================
+    // Scalar reference implementations
+    //==========================================================================
+    inline void multiplyScalar (float* dest, const float* src, int n) noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            dest[i] *= src[i];
+    }
+
+    inline void scaleScalar (float* dest, float gain, int n) noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            dest[i] *= gain;
+    }
+
+    inline void addScalar (float* dest, const float* src, int n) noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            dest[i] += src[i];
+    }
+
+    inline void copyScaledScalar (float* dest, const float* src, float gain, int n) noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            dest[i] = src[i] * gain;
+    }
+
+    inline void multiplyAddScalar (float* dest, const float* src, float gain, int n) noexcept
+    {
+        for (int i = 0; i < n; ++i)
+            dest[i] += src[i] * gain;
+    }
+
+    inline float sumOfSquaresScalar (const float* x, int n) noexcept
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i)
+            sum += x[i] * x[i];
+        return sum;
+    }
+
+   #if JUCE_INTEL
+    //==========================================================================
+    // SSE2: 4 lanes
+    //==========================================================================
+    inline float horizontalSum (__m128 v) noexcept
+    {
+        const __m128 hi = _mm_movehl_ps (v, v);
+        const __m128 s  = _mm_add_ps (v, hi);
+        return _mm_cvtss_f32 (_mm_add_ss (s, _mm_shuffle_ps (s, s, 1)));
+    }
+
+    inline void multiplySSE2 (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_loadu_ps (dest + i), _mm_loadu_ps (src + i)));
+        multiplyScalar (dest + i, src + i, n - i);
+    }
+
+    inline void scaleSSE2 (float* dest, float gain, int n) noexcept
+    {
+        const __m128 g = _mm_set1_ps (gain);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_loadu_ps (dest + i), g));
+        scaleScalar (dest + i, gain, n - i);
+    }
+
+    inline void addSSE2 (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps (dest + i, _mm_add_ps (_mm_loadu_ps (dest + i), _mm_loadu_ps (src + i)));
+        addScalar (dest + i, src + i, n - i);
+    }
+
+    inline void copyScaledSSE2 (float* dest, const float* src, float gain, int n) noexcept
+    {
+        const __m128 g = _mm_set1_ps (gain);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps (dest + i, _mm_mul_ps (_mm_loadu_ps (src + i), g));
+        copyScaledScalar (dest + i, src + i, gain, n - i);
+    }
+
+    inline void multiplyAddSSE2 (float* dest, const float* src, float gain, int n) noexcept
+    {
+        const __m128 g = _mm_set1_ps (gain);
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps (dest + i, _mm_add_ps (_mm_loadu_ps (dest + i), _mm_mul_ps (_mm_loadu_ps (src + i), g)));
+        multiplyAddScalar (dest + i, src + i, gain, n - i);
+    }
+
+    inline float sumOfSquaresSSE2 (const float* x, int n) noexcept
+    {
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m128 a = _mm_loadu_ps (x + i);
+            const __m128 b = _mm_loadu_ps (x + i + 4);
+            acc0 = _mm_add_ps (acc0, _mm_mul_ps (a, a));
+            acc1 = _mm_add_ps (acc1, _mm_mul_ps (b, b));
+        }
+        return horizontalSum (_mm_add_ps (acc0, acc1)) + sumOfSquaresScalar (x + i, n - i);
+    }
+
+    //==========================================================================
+    // AVX2 + FMA: 8 lanes
+    //==========================================================================
+    VECTOR_KERNELS_TARGET_AVX2 inline void multiplyAVX2 (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_mul_ps (_mm256_loadu_ps (dest + i), _mm256_loadu_ps (src + i)));
+        multiplyScalar (dest + i, src + i, n - i);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline void scaleAVX2 (float* dest, float gain, int n) noexcept
+    {
+        const __m256 g = _mm256_set1_ps (gain);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_mul_ps (_mm256_loadu_ps (dest + i), g));
+        scaleScalar (dest + i, gain, n - i);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline void addAVX2 (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_add_ps (_mm256_loadu_ps (dest + i), _mm256_loadu_ps (src + i)));
+        addScalar (dest + i, src + i, n - i);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline void copyScaledAVX2 (float* dest, const float* src, float gain, int n) noexcept
+    {
+        const __m256 g = _mm256_set1_ps (gain);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_mul_ps (_mm256_loadu_ps (src + i), g));
+        copyScaledScalar (dest + i, src + i, gain, n - i);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline void multiplyAddAVX2 (float* dest, const float* src, float gain, int n) noexcept
+    {
+        const __m256 g = _mm256_set1_ps (gain);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps (dest + i, _mm256_fmadd_ps (_mm256_loadu_ps (src + i), g, _mm256_loadu_ps (dest + i)));
+        multiplyAddScalar (dest + i, src + i, gain, n - i);
+    }
+
+    VECTOR_KERNELS_TARGET_AVX2 inline float sumOfSquaresAVX2 (const float* x, int n) noexcept
+    {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        int i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            const __m256 a = _mm256_loadu_ps (x + i);
+            const __m256 b = _mm256_loadu_ps (x + i + 8);
+            acc0 = _mm256_fmadd_ps (a, a, acc0);
+            acc1 = _mm256_fmadd_ps (b, b, acc1);
+        }
+        const __m256 acc = _mm256_add_ps (acc0, acc1);
+        return horizontalSum (_mm_add_ps (_mm256_castps256_ps128 (acc), _mm256_extractf128_ps (acc, 1)))
+             + sumOfSquaresScalar (x + i, n - i);
+    }
+   #endif
+
+   #if VECTOR_KERNELS_HAVE_NEON
+    //==========================================================================
+    // NEON: 4 lanes
+    //==========================================================================
+    inline float horizontalSum (float32x4_t v) noexcept
+    {
+        const float32x2_t s = vadd_f32 (vget_low_f32 (v), vget_high_f32 (v));
+        return vget_lane_f32 (vpadd_f32 (s, s), 0);
+    }
+
+    inline void multiplyNEON (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32 (dest + i, vmulq_f32 (vld1q_f32 (dest + i), vld1q_f32 (src + i)));
+        multiplyScalar (dest + i, src + i, n - i);
+    }
+
+    inline void scaleNEON (float* dest, float gain, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32 (dest + i, vmulq_n_f32 (vld1q_f32 (dest + i), gain));
+        scaleScalar (dest + i, gain, n - i);
+    }
+
+    inline void addNEON (float* dest, const float* src, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32 (dest + i, vaddq_f32 (vld1q_f32 (dest + i), vld1q_f32 (src + i)));
+        addScalar (dest + i, src + i, n - i);
+    }
+
+    inline void copyScaledNEON (float* dest, const float* src, float gain, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32 (dest + i, vmulq_n_f32 (vld1q_f32 (src + i), gain));
+        copyScaledScalar (dest + i, src + i, gain, n - i);
+    }
+
+    inline void multiplyAddNEON (float* dest, const float* src, float gain, int n) noexcept
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32 (dest + i, vmlaq_n_f32 (vld1q_f32 (dest + i), vld1q_f32 (src + i), gain));
+        multiplyAddScalar (dest + i, src + i, gain, n - i);
+    }
+
+    inline float sumOfSquaresNEON (const float* x, int n) noexcept
+    {
+        float32x4_t acc0 = vdupq_n_f32 (0.0f), acc1 = vdupq_n_f32 (0.0f);
+        int i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            const float32x4_t a = vld1q_f32 (x + i);
+            const float32x4_t b = vld1q_f32 (x + i + 4);
+            acc0 = vmlaq_f32 (acc0, a, a);
+            acc1 = vmlaq_f32 (acc1, b, b);
+        }
+        return horizontalSum (vaddq_f32 (acc0, acc1)) + sumOfSquaresScalar (x + i, n - i);
+    }
+   #endif
+
+    //==========================================================================
+    /** The scalar kernels, for checking the others against. */
+    inline const Table& reference() noexcept
+    {
+        static const Table table { multiplyScalar, scaleScalar, addScalar, copyScaledScalar,
+                                   multiplyAddScalar, sumOfSquaresScalar, Isa::scalar };
+        return table;
+    }
+
+    /** The kernels for detectIsa(), chosen on the first call; any thread. */
+    inline const Table& get() noexcept
+    {
+        static const Table table = []
+        {
+            switch (detectIsa())
+            {
+               #if JUCE_INTEL
+                case Isa::avx2: return Table { multiplyAVX2, scaleAVX2, addAVX2, copyScaledAVX2,
+                                               multiplyAddAVX2, sumOfSquaresAVX2, Isa::avx2 };
+                case Isa::sse2: return Table { multiplySSE2, scaleSSE2, addSSE2, copyScaledSSE2,
+                                               multiplyAddSSE2, sumOfSquaresSSE2, Isa::sse2 };
+               #endif
+               #if VECTOR_KERNELS_HAVE_NEON
+                case Isa::neon: return Table { multiplyNEON, scaleNEON, addNEON, copyScaledNEON,
+                                               multiplyAddNEON, sumOfSquaresNEON, Isa::neon };
+               #endif
+                default:        return reference();
+            }
+        }();
+
+        return table;
+    }
+}